@@ -364,7 +364,7 @@ int LOGKSI_SignatureVerify_calendarBased(ERR_TRCKR *err, KSI_Signature *sig, KSI
 }
 
 int LOGKSI_SignatureVerify_keyBased(ERR_TRCKR *err, KSI_Signature *sig, KSI_CTX *ctx, KSI_DataHash *hsh, KSI_uint64_t rootLevel,
-									 KSI_PolicyVerificationResult **result){
+									 KSI_PublicationsFile* pubFile, KSI_PolicyVerificationResult **result){
 	int res;
 
 	if (err == NULL || sig == NULL || ctx == NULL || result == NULL) {
@@ -372,14 +372,14 @@ int LOGKSI_SignatureVerify_keyBased(ERR_TRCKR *err, KSI_Signature *sig, KSI_CTX
 		return res;
 	}
 
-	res = verify_signature(sig, ctx, hsh, rootLevel, 0, NULL, NULL, KSI_VERIFICATION_POLICY_KEY_BASED, result);
+	res = verify_signature(sig, ctx, hsh, rootLevel, 0, pubFile, NULL, KSI_VERIFICATION_POLICY_KEY_BASED, result);
 	if (res != KSI_OK) LOGKSI_KSI_ERRTrace_save(ctx);
 
 	return res;
 }
 
 int LOGKSI_SignatureVerify_publicationsFileBased(ERR_TRCKR *err, KSI_Signature *sig, KSI_CTX *ctx, KSI_DataHash *hsh, KSI_uint64_t rootLevel,
-												  int extperm,
+												  KSI_PublicationsFile* pubFile, int extperm,
 												  KSI_PolicyVerificationResult **result){
 	int res;
 
@@ -388,7 +388,7 @@ int LOGKSI_SignatureVerify_publicationsFileBased(ERR_TRCKR *err, KSI_Signature *
 		return res;
 	}
 
-	res = verify_signature(sig, ctx, hsh, rootLevel, extperm, NULL, NULL, KSI_VERIFICATION_POLICY_PUBLICATIONS_FILE_BASED, result);
+	res = verify_signature(sig, ctx, hsh, rootLevel, extperm, pubFile, NULL, KSI_VERIFICATION_POLICY_PUBLICATIONS_FILE_BASED, result);
 	if (res != KSI_OK) LOGKSI_KSI_ERRTrace_save(ctx);
 
 	return res;
@@ -66,7 +66,7 @@ char* CONF_generate_param_set_desc(char *description, const char *flags, char *b
 	}
 
 	if (is_P) {
-		count += KSI_snprintf(buf + count, buf_len - count, "{P}{cnstr}{V}{W}{publications-file-no-verify}");
+		count += KSI_snprintf(buf + count, buf_len - count, "{P}{cnstr}{V}{W}{publications-file-no-verify}{pubfile-cache}{pubfile-cache-ttl}");
 	}
 
 	if (is_X || is_S) {
@@ -142,11 +142,19 @@ int CONF_initialize_set_functions(PARAM_SET *conf, const char *flags) {
 		res = PARAM_SET_addControl(conf, "{cnstr}", isFormatOk_constraint, NULL, convertRepair_constraint, NULL);
 		if (res != PST_OK) goto cleanup;
 
+		res = PARAM_SET_addControl(conf, "{pubfile-cache}", isFormatOk_path, NULL, convertRepair_path, NULL);
+		if (res != PST_OK) goto cleanup;
+
+		res = PARAM_SET_addControl(conf, "{pubfile-cache-ttl}", isFormatOk_int, isContentOk_uint_not_zero, NULL, extract_uint);
+		if (res != PST_OK) goto cleanup;
+
 		PARAM_SET_setHelpText(conf, "P", "<URL>", "Publications file URL (or file with URI scheme 'file://').");
 		PARAM_SET_setHelpText(conf, "cnstr", "<oid=value>", "OID of the PKI certificate field (e.g. e-mail address) and the expected value to qualify the certificate for verification of publications file PKI signature. At least one constraint must be defined.");
 		PARAM_SET_setHelpText(conf, "V", "<file>", "Certificate file in PEM format for publications file verification. All values from lower priority source are ignored.");
 		PARAM_SET_setHelpText(conf, "W", "<dir>", "Specify an OpenSSL-style trust store directory for publications file verification.");
 		PARAM_SET_setHelpText(conf, "publications-file-no-verify", NULL, "A flag to force the tool to trust the publications file without verifying it. The flag can only be defined on command-line to avoid the usage of insecure configuration files. It must be noted that the option is insecure and may only be used for testing.");
+		PARAM_SET_setHelpText(conf, "pubfile-cache", "<file>", "Keep the publications file and the result of its verification in the given cache file. The cached publications file is used without downloading and verifying it again, until it is older than '--pubfile-cache-ttl' or any of the options '-P', '--cnstr', '-V' and '-W' is changed. The cache file is replaced atomically under a lock ('<file>.lock'), so it can be shared by several processes.");
+		PARAM_SET_setHelpText(conf, "pubfile-cache-ttl", "<sec>", "The time in seconds the publications file in the cache file given with '--pubfile-cache' is used, before it is downloaded again. Default value is 3600.");
 	}
 
 	if (is_S) {
@@ -211,3 +211,41 @@ int ERR_TRCKR_getErrCount(ERR_TRCKR *err) {
 	if (err == NULL) return 0;
 	else return err->count;
 }
+
+int ERR_TRCKR_writeToFile(ERR_TRCKR *err, FILE *out) {
+	if (err == NULL || out == NULL) return -1;
+	if (fwrite(err, sizeof(ERR_TRCKR), 1, out) != 1) return -1;
+	return 0;
+}
+
+int ERR_TRCKR_addFromFile(ERR_TRCKR *err, FILE *in) {
+	ERR_TRCKR *tmp = NULL;
+	unsigned i;
+	int res = -1;
+
+	if (err == NULL || in == NULL) return -1;
+
+	tmp = (ERR_TRCKR*)malloc(sizeof(ERR_TRCKR));
+	if (tmp == NULL) goto cleanup;
+
+	if (fread(tmp, sizeof(ERR_TRCKR), 1, in) != 1) goto cleanup;
+	if (tmp->count > MAX_ERROR_COUNT || tmp->additionalInfo_len >= MAX_ADDITIONAL_INFO_LEN || tmp->warnings_len >= MAX_ADDITIONAL_INFO_LEN) goto cleanup;
+
+	for (i = 0; i < tmp->count; i++) {
+		tmp->err[i].message[MAX_MESSAGE_LEN - 1] = 0;
+		tmp->err[i].fileName[MAX_FILE_NAME_LEN - 1] = 0;
+		ERR_TRCKR_add(err, tmp->err[i].code, tmp->err[i].fileName, tmp->err[i].line, "%s", tmp->err[i].message);
+	}
+
+	tmp->additionalInfo[tmp->additionalInfo_len] = 0;
+	tmp->warnings[tmp->warnings_len] = 0;
+	if (tmp->additionalInfo_len > 0) ERR_TRCKR_addAdditionalInfo(err, "%s", tmp->additionalInfo);
+	if (tmp->warnings_len > 0) ERR_TRCKR_addWarning(err, "%s", tmp->warnings);
+
+	res = 0;
+
+cleanup:
+
+	free(tmp);
+	return res;
+}
@@ -46,6 +46,18 @@ void ERR_TRCKR_printWarnings(ERR_TRCKR *err);
 void ERR_TRCKR_print(ERR_TRCKR *err, int extended);
 int ERR_TRCKR_getErrCount(ERR_TRCKR *err);
 
+/**
+ * Writes the errors, warnings and additional info to the file, so that they can be added
+ * to the error tracker of another process with #ERR_TRCKR_addFromFile. Returns 0 on success.
+ */
+int ERR_TRCKR_writeToFile(ERR_TRCKR *err, FILE *out);
+
+/**
+ * Reads the errors, warnings and additional info written by #ERR_TRCKR_writeToFile and
+ * adds them to the error tracker. Returns 0 on success.
+ */
+int ERR_TRCKR_addFromFile(ERR_TRCKR *err, FILE *in);
+
 #define ERR_TRCKR_ADD(err, code, msg, ...) ERR_TRCKR_add(err, code, __FILE__, __LINE__, msg, ##__VA_ARGS__)
 
 #ifdef	__cplusplus
@@ -37,6 +37,7 @@ static int logksi_ErrToExitcode(int error_code) {
 		case KT_VERIFICATION_NA:
 		case KT_INDEX_OVF:
 		case KT_TREE_LEVEL_OVF:
+		case KT_TIMEOUT:
 		case KT_UNKNOWN_ERROR:
 		case KT_SIGNING_FAILURE:
 		case KT_USER_INPUT_FAILURE:
@@ -163,6 +164,8 @@ static const char* logksiErrToString(int error_code) {
 			return "Tree too large.";
 		case KT_UNEXPECTED_EOF:
 			return "Unexpected end of file.";
+		case KT_TIMEOUT:
+			return "Timeout.";
 		case KT_UNKNOWN_ERROR:
 			return "Unknown error.";
 		default:
@@ -74,6 +74,7 @@ enum Logksi_errors {
 	KT_INTEGRATION_PURPOSELY_STOPPED,
 	KT_TREE_LEVEL_OVF,
 	KT_UNEXPECTED_EOF,
+	KT_TIMEOUT,
 	KT_UNKNOWN_ERROR,
 };
 int LOGKSI_errToExitCode(int error);
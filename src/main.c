@@ -30,6 +30,7 @@
 #include "logksi_err.h"
 #include "printer.h"
 #include "conf_file.h"
+#include "tool_box/job_socket.h"
 
 
 #ifdef HAVE_CONFIG_H
@@ -44,7 +45,9 @@ typedef enum {
        TASK_ID_INTEGRATE = 3,
        TASK_ID_EXTRACT = 4,
        TASK_ID_CONF = 5,
-       TASK_ID_CREATE = 6
+       TASK_ID_CREATE = 6,
+       TASK_ID_INDEX = 7,
+       TASK_ID_DAEMON = 8
 } TASK_ID;
 
 const char *TOOL_getVersion(void) {
@@ -145,6 +148,15 @@ static void print_general_help(PARAM_SET *set, const char *KSI_CONF){
 
 static int logksi_compo_get(TASK_SET *tasks, PARAM_SET **set, TOOL_COMPONENT_LIST **compo);
 
+/**
+ * Only the tasks that do not need a terminal of their own can be run by logksi daemon.
+ */
+static int is_daemon_job(int id, const char *daemonSocket) {
+	if (daemonSocket == NULL || daemonSocket[0] == '\0') return 0;
+
+	return id == TASK_ID_SIGN || id == TASK_ID_VERIFY || id == TASK_ID_EXTEND || id == TASK_ID_EXTRACT;
+}
+
 int main(int argc, char** argv, char **envp) {
 	int res;
 	PARAM_SET *set_task_name = NULL;
@@ -154,6 +166,7 @@ int main(int argc, char** argv, char **envp) {
 	TASK_SET *tasks = NULL;
 	TASK *task = NULL;
 	int retval = EXIT_SUCCESS;
+	const char *daemonSocket = getenv(JOB_SOCKET_ENV_NAME);
 	char buf[0xffff];
 
 	/**
@@ -269,6 +282,21 @@ int main(int argc, char** argv, char **envp) {
 		print_enable(PRINT_DEBUG);
 	}
 
+	/**
+	 * If logksi daemon is available, pass the job to the daemon, so that it is
+	 * run in already initialized process.
+	 */
+	if (is_daemon_job(TASK_getID(task), daemonSocket)) {
+		res = JOB_SOCKET_runJob(daemonSocket, argc - 1, argv + 1, envp, &retval);
+		if (res != KT_OK) {
+			print_errors("Error: Unable to run the job in logksi daemon listening on '%s'.\n", daemonSocket);
+			goto cleanup;
+		}
+
+		res = KT_OK;
+		goto cleanup;
+	}
+
 	/**
 	 * Run component by its ID.
 	 */
@@ -300,7 +328,7 @@ static int logksi_compo_get(TASK_SET *tasks, PARAM_SET **set, TOOL_COMPONENT_LIS
 	/**
 	 * Create parameter list that contains all known tasks.
 	 */
-	res = PARAM_SET_new("{sign}{extend}{verify}{integrate}{extract}{create}{conf}", &tmp_set);
+	res = PARAM_SET_new("{sign}{extend}{verify}{integrate}{extract}{create}{index}{daemon}{conf}", &tmp_set);
 	if (res != PST_OK) goto cleanup;
 
 	res = TOOL_COMPONENT_LIST_new(32, &tmp_compo);
@@ -315,6 +343,8 @@ static int logksi_compo_get(TASK_SET *tasks, PARAM_SET **set, TOOL_COMPONENT_LIS
 	TASK_SET_add(tasks, TASK_ID_INTEGRATE, "Integrate", "integrate", NULL, NULL, NULL);
 	TASK_SET_add(tasks, TASK_ID_EXTRACT, "Extract", "extract", NULL, NULL, NULL);
 	TASK_SET_add(tasks, TASK_ID_CREATE, "Create", "create", NULL, NULL, NULL);
+	TASK_SET_add(tasks, TASK_ID_INDEX, "Index", "index", NULL, NULL, NULL);
+	TASK_SET_add(tasks, TASK_ID_DAEMON, "Daemon", "daemon", NULL, NULL, NULL);
 	TASK_SET_add(tasks, TASK_ID_CONF, "conf", "conf", NULL, NULL, NULL);
 
 	/**
@@ -326,6 +356,8 @@ static int logksi_compo_get(TASK_SET *tasks, PARAM_SET **set, TOOL_COMPONENT_LIS
 	TOOL_COMPONENT_LIST_add(tmp_compo, "integrate", integrate_run, integrate_help_toString, integrate_get_desc, TASK_ID_INTEGRATE);
 	TOOL_COMPONENT_LIST_add(tmp_compo, "extract", extract_run, extract_help_toString, extract_get_desc, TASK_ID_EXTRACT);
 	TOOL_COMPONENT_LIST_add(tmp_compo, "create", create_run, create_help_toString, create_get_desc, TASK_ID_CREATE);
+	TOOL_COMPONENT_LIST_add(tmp_compo, "index", index_run, index_help_toString, index_get_desc, TASK_ID_INDEX);
+	TOOL_COMPONENT_LIST_add(tmp_compo, "daemon", daemon_run, daemon_help_toString, daemon_get_desc, TASK_ID_DAEMON);
 	TOOL_COMPONENT_LIST_add(tmp_compo, "conf", conf_run, conf_help_toString, conf_get_desc, TASK_ID_CONF);
 
 	*set = tmp_set;
@@ -17,6 +17,15 @@
  * reserves and retains all trademark rights.
  */
 
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+/* Needed for the declaration of copy_file_range. */
+#if defined(HAVE_COPY_FILE_RANGE) && !defined(_GNU_SOURCE)
+#  define _GNU_SOURCE
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -32,6 +41,13 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <sys/mman.h>
+
+/* Size of the buffer that collects small writes. */
+#define SMART_FILE_WRITE_BUFFER_SIZE 0x40000
+
+/* Size of the buffer used by #SMART_FILE_copyRange when the data can not be copied by the kernel. */
+#define SMART_FILE_COPY_BUFFER_SIZE 0x10000
 
 struct SMART_FILE_st {
 	char fname[1024];	/* Original file name. */
@@ -42,15 +58,24 @@ struct SMART_FILE_st {
 
 	void *file;
 
+	/* Small writes to a regular file or to a stream are collected into the write buffer (see smart_file_write_buffered). */
+	unsigned char *wbuf;
+	size_t wbuf_len;
+	int isWriteBuffered;
+
 	int (*file_open)(const char *fname, const char *mode, char* fname_out_buf, size_t fname_out_buf_len, void **file);
 	int (*file_reposition)(void *file, size_t offset);
 	int (*file_get_current_position)(void *file, size_t *pos);
 	int (*file_truncate)(void *file, size_t pos);
+	int (*file_flush)(void *file);
+	int (*file_sync)(void *file);
+	int (*file_get_fd)(void *file);
 	int (*file_write)(void *file, const unsigned char *raw, size_t raw_len, size_t *count);
 	int (*file_read)(void *file, unsigned char *raw, size_t raw_len, size_t *count);
 	int (*file_read_line)(void *file, char *raw, size_t raw_len, size_t *row_pointer, size_t *count, size_t *raw_count);
 	int (*file_read_line_every)(void *file, char *raw, size_t raw_len, size_t *row_pointer, size_t *count, size_t *raw_count);
 	int (*file_gets)(void *file, char *raw, size_t raw_len, int *eof);
+	int (*file_read_line_span)(void *file, const char **line, size_t *line_len, size_t *raw_count);
 	int (*file_set_lock)(void *file, int lockType);
 	int (*file_get_stream)(const char *mode, void **stream, int *is_close_mandatory);
 	void (*file_close)(void *file);
@@ -80,8 +105,41 @@ static int smart_file_get_error(void);
 static char* get_pure_mode(const char *mode, char *buf, size_t buf_len);
 static int smart_file_get_current_position(void *file, size_t *pos);
 static int smart_file_truncate(void *file, size_t pos);
+static int smart_file_flush(void *file);
+static int smart_file_sync(void *file);
+static int smart_file_get_fd(void *file);
 static int smart_file_set_lock(void *file, int lockType);
 
+static int smart_file_mem_open(const char *fname, const char *mode, char* fname_out_buf, size_t fname_out_buf_len, void **file);
+static void smart_file_mem_close(void *file);
+static int smart_file_mem_reposition(void *file, size_t offset);
+static int smart_file_mem_get_current_position(void *file, size_t *pos);
+static int smart_file_mem_truncate(void *file, size_t pos);
+static int smart_file_mem_flush(void *file);
+static int smart_file_mem_sync(void *file);
+static int smart_file_mem_get_fd(void *file);
+static int smart_file_mem_write(void *file, const unsigned char *raw, size_t raw_len, size_t *count);
+static int smart_file_mem_read(void *file, unsigned char *raw, size_t raw_len, size_t *count);
+static int smart_file_mem_read_line(void *file, char *buf, size_t len, size_t *row_pointer, size_t *count, size_t *raw_count);
+static int smart_file_mem_gets(void *file, char *raw, size_t raw_len, int *eof);
+static int smart_file_mem_set_lock(void *file, int lockType);
+
+static int smart_file_map_open(const char *fname, const char *mode, char* fname_out_buf, size_t fname_out_buf_len, void **file);
+static void smart_file_map_close(void *file);
+static int smart_file_map_reposition(void *file, size_t offset);
+static int smart_file_map_get_current_position(void *file, size_t *pos);
+static int smart_file_map_truncate(void *file, size_t pos);
+static int smart_file_map_flush(void *file);
+static int smart_file_map_sync(void *file);
+static int smart_file_map_get_fd(void *file);
+static int smart_file_map_write(void *file, const unsigned char *raw, size_t raw_len, size_t *count);
+static int smart_file_map_read(void *file, unsigned char *raw, size_t raw_len, size_t *count);
+static int smart_file_map_read_line(void *file, char *buf, size_t len, size_t *row_pointer, size_t *count, size_t *raw_count);
+static int smart_file_map_read_line_every(void *file, char *buf, size_t len, size_t *row_pointer, size_t *count, size_t *raw_count);
+static int smart_file_map_read_line_span(void *file, const char **line, size_t *line_len, size_t *raw_count);
+static int smart_file_map_gets(void *file, char *raw, size_t raw_len, int *eof);
+static int smart_file_map_set_lock(void *file, int lockType);
+
 static int is_access(const char *path, int mode) {
 	int res;
 	if (path == NULL) return 0;
@@ -104,11 +162,15 @@ static int smart_file_init(SMART_FILE *file) {
 	file->file_read_line = smart_file_read_line;
 	file->file_read_line_every = smart_file_read_line_every;
 	file->file_gets = smart_file_gets;
+	file->file_read_line_span = NULL;
 	file->file_write = smart_file_write;
 	file->file_get_stream = smart_file_get_stream;
 	file->file_reposition = smart_file_reposition;
 	file->file_get_current_position = smart_file_get_current_position;
 	file->file_truncate = smart_file_truncate;
+	file->file_flush = smart_file_flush;
+	file->file_sync = smart_file_sync;
+	file->file_get_fd = smart_file_get_fd;
 	file->file_set_lock = smart_file_set_lock;
 
 	res = SMART_FILE_OK;
@@ -118,6 +180,72 @@ cleanup:
 	return res;
 }
 
+static int smart_file_init_mem(SMART_FILE *file) {
+	int res;
+
+	if (file == NULL) {
+		res = SMART_FILE_INVALID_ARG;
+		goto cleanup;
+	}
+
+	file->file = NULL;
+	file->file_open = smart_file_mem_open;
+	file->file_close = smart_file_mem_close;
+	file->file_read = smart_file_mem_read;
+	file->file_read_line = smart_file_mem_read_line;
+	file->file_read_line_every = smart_file_mem_read_line;
+	file->file_gets = smart_file_mem_gets;
+	file->file_read_line_span = NULL;
+	file->file_write = smart_file_mem_write;
+	file->file_get_stream = NULL;
+	file->file_reposition = smart_file_mem_reposition;
+	file->file_get_current_position = smart_file_mem_get_current_position;
+	file->file_truncate = smart_file_mem_truncate;
+	file->file_flush = smart_file_mem_flush;
+	file->file_sync = smart_file_mem_sync;
+	file->file_get_fd = smart_file_mem_get_fd;
+	file->file_set_lock = smart_file_mem_set_lock;
+
+	res = SMART_FILE_OK;
+
+cleanup:
+
+	return res;
+}
+
+static int smart_file_init_map(SMART_FILE *file) {
+	int res;
+
+	if (file == NULL) {
+		res = SMART_FILE_INVALID_ARG;
+		goto cleanup;
+	}
+
+	file->file = NULL;
+	file->file_open = smart_file_map_open;
+	file->file_close = smart_file_map_close;
+	file->file_read = smart_file_map_read;
+	file->file_read_line = smart_file_map_read_line;
+	file->file_read_line_every = smart_file_map_read_line_every;
+	file->file_gets = smart_file_map_gets;
+	file->file_read_line_span = smart_file_map_read_line_span;
+	file->file_write = smart_file_map_write;
+	file->file_get_stream = NULL;
+	file->file_reposition = smart_file_map_reposition;
+	file->file_get_current_position = smart_file_map_get_current_position;
+	file->file_truncate = smart_file_map_truncate;
+	file->file_flush = smart_file_map_flush;
+	file->file_sync = smart_file_map_sync;
+	file->file_get_fd = smart_file_map_get_fd;
+	file->file_set_lock = smart_file_map_set_lock;
+
+	res = SMART_FILE_OK;
+
+cleanup:
+
+	return res;
+}
+
 static int smart_file_redirect_to_stream(void *from, void *to) {
 	int res;
 	unsigned char buf[0xffff];
@@ -305,6 +433,30 @@ cleanup:
 	return res;
 }
 
+static int smart_file_flush(void *file) {
+	FILE *fp = file;
+
+	if (file == NULL) return SMART_FILE_INVALID_ARG;
+	if (fflush(fp) != 0) return SMART_FILE_UNABLE_TO_WRITE;
+
+	return SMART_FILE_OK;
+}
+
+static int smart_file_sync(void *file) {
+	FILE *fp = file;
+
+	if (file == NULL) return SMART_FILE_INVALID_ARG;
+	if (fflush(fp) != 0) return SMART_FILE_UNABLE_TO_WRITE;
+	if (fsync(fileno(fp)) != 0) return SMART_FILE_UNABLE_TO_WRITE;
+
+	return SMART_FILE_OK;
+}
+
+static int smart_file_get_fd(void *file) {
+	if (file == NULL) return -1;
+	return fileno((FILE*)file);
+}
+
 static int smart_file_set_lock(void *file, int lockType) {
 	int res;
 	FILE *fp = file;
@@ -537,36 +689,606 @@ cleanup:
 	return res;
 }
 
-static int smart_file_get_error(void) {
-	int error_code = 0;
-	int smart_file_error_code = 0;
+static int smart_file_get_error(void) {
+	int error_code = 0;
+	int smart_file_error_code = 0;
+
+
+	error_code = errno;
+
+	switch(error_code) {
+		case 0:
+			smart_file_error_code =  SMART_FILE_OK;
+		break;
+
+		case ENOENT:
+			smart_file_error_code =  SMART_FILE_DOES_NOT_EXIST;
+		break;
+
+		case EACCES:
+			smart_file_error_code =  SMART_FILE_ACCESS_DENIED;
+		break;
+
+		case EINVAL:
+			smart_file_error_code =  SMART_FILE_INVALID_PATH;
+		break;
+
+		default:
+			smart_file_error_code = SMART_FILE_UNKNOWN_ERROR;
+		break;
+	}
+
+	return smart_file_error_code;
+}
+
+/**
+ * In-memory file (mode M). Data is kept in a growing buffer and it never touches
+ * the file system. It is meant to be used as a spool where some data must be
+ * collected before it is written into the final output file.
+ */
+typedef struct SMART_FILE_MEM_st {
+	unsigned char *buf;
+	size_t buf_size;
+	size_t data_len;
+	size_t position;
+} SMART_FILE_MEM;
+
+#define SMART_FILE_MEM_INITIAL_SIZE 0x4000
+
+static int smart_file_mem_open(const char *fname, const char *mode, char* fname_out_buf, size_t fname_out_buf_len, void **file) {
+	int res;
+	SMART_FILE_MEM *tmp = NULL;
+
+	if (mode == NULL || file == NULL) {
+		res = SMART_FILE_INVALID_ARG;
+		goto cleanup;
+	}
+
+	if (fname_out_buf != NULL) {
+		fname_out_buf[0] = '\0';
+	}
+
+	tmp = (SMART_FILE_MEM*)malloc(sizeof(SMART_FILE_MEM));
+	if (tmp == NULL) {
+		res = SMART_FILE_OUT_OF_MEM;
+		goto cleanup;
+	}
+
+	tmp->buf = NULL;
+	tmp->buf_size = 0;
+	tmp->data_len = 0;
+	tmp->position = 0;
+
+	*file = (void*)tmp;
+	tmp = NULL;
+	res = SMART_FILE_OK;
+
+cleanup:
+
+	smart_file_mem_close(tmp);
+
+	return res;
+}
+
+static void smart_file_mem_close(void *file) {
+	SMART_FILE_MEM *tmp = file;
+	if (file == NULL) return;
+	free(tmp->buf);
+	free(tmp);
+}
+
+static int smart_file_mem_reposition(void *file, size_t offset) {
+	SMART_FILE_MEM *mem = file;
+
+	if (file == NULL) return SMART_FILE_INVALID_ARG;
+	if (offset > mem->data_len) return SMART_FILE_UNABLE_TO_REPOSITION;
+
+	mem->position = offset;
+
+	return SMART_FILE_OK;
+}
+
+static int smart_file_mem_get_current_position(void *file, size_t *pos) {
+	SMART_FILE_MEM *mem = file;
+
+	if (file == NULL || pos == NULL) return SMART_FILE_INVALID_ARG;
+
+	*pos = mem->position;
+
+	return SMART_FILE_OK;
+}
+
+static int smart_file_mem_truncate(void *file, size_t pos) {
+	SMART_FILE_MEM *mem = file;
+
+	if (file == NULL) return SMART_FILE_INVALID_ARG;
+	if (pos > mem->data_len) return SMART_FILE_UNABLE_TO_TRUNCATE;
+
+	mem->data_len = pos;
+	mem->position = pos;
+
+	return SMART_FILE_OK;
+}
+
+static int smart_file_mem_write(void *file, const unsigned char *raw, size_t raw_len, size_t *count) {
+	int res;
+	SMART_FILE_MEM *mem = file;
+
+	if (file == NULL || raw == NULL || raw_len == 0) {
+		res = SMART_FILE_INVALID_ARG;
+		goto cleanup;
+	}
+
+	/* Grow the buffer by doubling its size. */
+	if (mem->position + raw_len > mem->buf_size) {
+		unsigned char *tmp = NULL;
+		size_t new_size = mem->buf_size == 0 ? SMART_FILE_MEM_INITIAL_SIZE : mem->buf_size;
+
+		while (new_size < mem->position + raw_len) new_size *= 2;
+
+		tmp = (unsigned char*)realloc(mem->buf, new_size);
+		if (tmp == NULL) {
+			res = SMART_FILE_OUT_OF_MEM;
+			goto cleanup;
+		}
+
+		mem->buf = tmp;
+		mem->buf_size = new_size;
+	}
+
+	memcpy(mem->buf + mem->position, raw, raw_len);
+	mem->position += raw_len;
+	if (mem->position > mem->data_len) mem->data_len = mem->position;
+
+	if (count != NULL) {
+		*count = raw_len;
+	}
+
+	res = SMART_FILE_OK;
+
+cleanup:
+
+	return res;
+}
+
+static int smart_file_mem_read(void *file, unsigned char *raw, size_t raw_len, size_t *count) {
+	SMART_FILE_MEM *mem = file;
+	size_t read_count = 0;
+
+	if (file == NULL || raw == NULL || raw_len == 0) return SMART_FILE_INVALID_ARG;
+
+	read_count = mem->data_len - mem->position;
+	if (read_count > raw_len) read_count = raw_len;
+
+	if (read_count > 0) {
+		memcpy(raw, mem->buf + mem->position, read_count);
+		mem->position += read_count;
+	}
+
+	if (count != NULL) {
+		*count = read_count;
+	}
+
+	return SMART_FILE_OK;
+}
+
+static int smart_file_mem_read_line(void *file, char *buf, size_t len, size_t *row_pointer, size_t *count, size_t *raw_count) {
+	return SMART_FILE_INVALID_MODE;
+}
+
+static int smart_file_mem_gets(void *file, char *raw, size_t raw_len, int *eof) {
+	return SMART_FILE_INVALID_MODE;
+}
+
+static int smart_file_mem_flush(void *file) {
+	return SMART_FILE_OK;
+}
+
+static int smart_file_mem_sync(void *file) {
+	return SMART_FILE_OK;
+}
+
+static int smart_file_mem_get_fd(void *file) {
+	return -1;
+}
+
+static int smart_file_mem_set_lock(void *file, int lockType) {
+	return SMART_FILE_OK;
+}
+
+/**
+ * Memory mapped file (mode m). A regular file is mapped into memory as a whole
+ * and lines are found with memchr instead of reading the file char by char. The
+ * lines can be accessed without copying (see #SMART_FILE_readLineSpan). Reading
+ * a page of the mapping that has been cut off by truncating the file raises
+ * SIGBUS, thus only files that are not truncated while read can be mapped.
+ */
+typedef struct SMART_FILE_MAP_REGION_st {
+	const char *data;
+	size_t size;
+} SMART_FILE_MAP_REGION;
+
+typedef struct SMART_FILE_MAP_st {
+	int fd;
+	const char *data;
+	size_t size;
+	size_t position;
+
+	/**
+	 * Mappings replaced when the file has grown. Lines returned without copying may
+	 * still be in use (e.g. hashed by other threads), thus the mappings are kept
+	 * until the file is closed.
+	 */
+	SMART_FILE_MAP_REGION *retired;
+	size_t retired_count;
+
+	/* Positions of the next line-end characters (size if not found, size + 1 if unknown). */
+	size_t next_lf;
+	size_t next_cr;
+	size_t next_nul;
+} SMART_FILE_MAP;
+
+static void smart_file_map_invalidate(SMART_FILE_MAP *map) {
+	map->next_lf = map->size + 1;
+	map->next_cr = map->size + 1;
+	map->next_nul = map->size + 1;
+}
+
+/**
+ * Called when the end of the mapping is reached. If the file has grown after it
+ * was mapped, it is mapped again with the new size, so that appended data is not
+ * ignored. The previous mapping is not unmapped before the file is closed. File
+ * that has been truncated is not mapped again.
+ */
+static int smart_file_map_update(SMART_FILE_MAP *map) {
+	struct stat status;
+	void *data = NULL;
+
+	if (fstat(map->fd, &status) != 0) return SMART_FILE_UNABLE_TO_GET_STATUS;
+	if (status.st_size <= 0 || (size_t)status.st_size <= map->size) return SMART_FILE_OK;
+
+	if (map->data != NULL) {
+		SMART_FILE_MAP_REGION *retired = NULL;
+
+		retired = (SMART_FILE_MAP_REGION*)realloc(map->retired, (map->retired_count + 1) * sizeof(SMART_FILE_MAP_REGION));
+		if (retired == NULL) return SMART_FILE_OUT_OF_MEM;
+		map->retired = retired;
+	}
+
+	data = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, map->fd, 0);
+	if (data == MAP_FAILED) return SMART_FILE_UNABLE_TO_READ;
+
+	madvise(data, (size_t)status.st_size, MADV_SEQUENTIAL);
+	if (map->data != NULL) {
+		map->retired[map->retired_count].data = map->data;
+		map->retired[map->retired_count].size = map->size;
+		map->retired_count++;
+	}
+	map->data = data;
+	map->size = (size_t)status.st_size;
+	smart_file_map_invalidate(map);
+
+	return SMART_FILE_OK;
+}
+
+static int smart_file_map_open(const char *fname, const char *mode, char* fname_out_buf, size_t fname_out_buf_len, void **file) {
+	int res;
+	SMART_FILE_MAP *tmp = NULL;
+	struct stat status;
+	void *data = NULL;
+
+	if (fname == NULL || mode == NULL || file == NULL) {
+		res = SMART_FILE_INVALID_ARG;
+		goto cleanup;
+	}
+
+	if (fname_out_buf != NULL) {
+		fname_out_buf[0] = '\0';
+	}
+
+	tmp = (SMART_FILE_MAP*)malloc(sizeof(SMART_FILE_MAP));
+	if (tmp == NULL) {
+		res = SMART_FILE_OUT_OF_MEM;
+		goto cleanup;
+	}
+
+	tmp->data = NULL;
+	tmp->size = 0;
+	tmp->position = 0;
+	tmp->retired = NULL;
+	tmp->retired_count = 0;
+
+	tmp->fd = open(fname, O_RDONLY);
+	if (tmp->fd == -1) {
+		res = smart_file_get_error();
+		res = (res == SMART_FILE_UNKNOWN_ERROR) ? SMART_FILE_UNABLE_TO_OPEN : res;
+		goto cleanup;
+	}
+
+	if (fstat(tmp->fd, &status) != 0) {
+		res = SMART_FILE_UNABLE_TO_GET_STATUS;
+		goto cleanup;
+	}
+
+	/* Empty file can not be mapped. */
+	if (status.st_size > 0) {
+		data = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, tmp->fd, 0);
+		if (data == MAP_FAILED) {
+			res = SMART_FILE_UNABLE_TO_OPEN;
+			goto cleanup;
+		}
+
+		madvise(data, (size_t)status.st_size, MADV_SEQUENTIAL);
+		tmp->data = data;
+		tmp->size = (size_t)status.st_size;
+	}
+
+	smart_file_map_invalidate(tmp);
+
+	*file = (void*)tmp;
+	tmp = NULL;
+	res = SMART_FILE_OK;
+
+cleanup:
+
+	smart_file_map_close(tmp);
+
+	return res;
+}
+
+static void smart_file_map_close(void *file) {
+	SMART_FILE_MAP *tmp = file;
+	size_t i;
+	if (file == NULL) return;
+	for (i = 0; i < tmp->retired_count; i++) munmap((void*)tmp->retired[i].data, tmp->retired[i].size);
+	free(tmp->retired);
+	if (tmp->data != NULL) munmap((void*)tmp->data, tmp->size);
+	if (tmp->fd != -1) close(tmp->fd);
+	free(tmp);
+}
+
+static int smart_file_map_reposition(void *file, size_t offset) {
+	SMART_FILE_MAP *map = file;
+
+	if (file == NULL) return SMART_FILE_INVALID_ARG;
+	if (offset > map->size) return SMART_FILE_UNABLE_TO_REPOSITION;
+
+	map->position = offset;
+	smart_file_map_invalidate(map);
+
+	return SMART_FILE_OK;
+}
+
+static int smart_file_map_get_current_position(void *file, size_t *pos) {
+	SMART_FILE_MAP *map = file;
+
+	if (file == NULL || pos == NULL) return SMART_FILE_INVALID_ARG;
+
+	*pos = map->position;
+
+	return SMART_FILE_OK;
+}
+
+static int smart_file_map_truncate(void *file, size_t pos) {
+	return SMART_FILE_INVALID_MODE;
+}
+
+static int smart_file_map_flush(void *file) {
+	return SMART_FILE_OK;
+}
+
+static int smart_file_map_sync(void *file) {
+	return SMART_FILE_OK;
+}
+
+static int smart_file_map_get_fd(void *file) {
+	if (file == NULL) return -1;
+	return ((SMART_FILE_MAP*)file)->fd;
+}
+
+static int smart_file_map_write(void *file, const unsigned char *raw, size_t raw_len, size_t *count) {
+	return SMART_FILE_INVALID_MODE;
+}
+
+static int smart_file_map_read(void *file, unsigned char *raw, size_t raw_len, size_t *count) {
+	SMART_FILE_MAP *map = file;
+	size_t read_count = 0;
+
+	if (file == NULL || raw == NULL || raw_len == 0) return SMART_FILE_INVALID_ARG;
+
+	if (map->position == map->size) {
+		int res = smart_file_map_update(map);
+		if (res != SMART_FILE_OK) return res;
+	}
+
+	read_count = map->size - map->position;
+	if (read_count > raw_len) read_count = raw_len;
+
+	if (read_count > 0) {
+		memcpy(raw, map->data + map->position, read_count);
+		map->position += read_count;
+	}
+
+	if (count != NULL) {
+		*count = read_count;
+	}
+
+	return SMART_FILE_OK;
+}
+
+/* Returns the position of the next character c, that is searched only when the previous result is behind. */
+static size_t smart_file_map_find(SMART_FILE_MAP *map, size_t *next, int c) {
+	if (*next < map->position || *next > map->size) {
+		const char *found = memchr(map->data + map->position, c, map->size - map->position);
+		*next = (found == NULL) ? map->size : (size_t)(found - map->data);
+	}
+
+	return *next;
+}
+
+/**
+ * Finds the next line with the same rules as smart_file_read_line_common. Line
+ * ends with LF, CR or CR LF. Character 0x00 ends the line and is dropped. When
+ * the line is longer than max_len, max_len characters are returned together with
+ * SMART_FILE_NO_EOL and the rest of the line is returned by the next call.
+ */
+static int smart_file_map_next_line(SMART_FILE_MAP *map, size_t max_len, const char **line, size_t *line_len, size_t *raw_count, size_t *line_count) {
+	size_t end = 0;
+	size_t len = 0;
+	char c = '\0';
+
+	if (map->position == map->size) {
+		int res = smart_file_map_update(map);
+		if (res != SMART_FILE_OK) return res;
+	}
+
+	end = map->size;
+	if (map->position < map->size) {
+		end = smart_file_map_find(map, &map->next_lf, '\n');
+		if (smart_file_map_find(map, &map->next_cr, '\r') < end) end = map->next_cr;
+		if (smart_file_map_find(map, &map->next_nul, '\0') < end) end = map->next_nul;
+	}
+
+	len = end - map->position;
+	if (end < map->size) c = map->data[end];
+
+	*line = (map->data == NULL) ? "" : map->data + map->position;
+
+	if (len > max_len || (len == max_len && end < map->size && c != '\0')) {
+		*line_len = max_len;
+		*raw_count = max_len;
+		*line_count = 0;
+		map->position += max_len;
+		return SMART_FILE_NO_EOL;
+	}
+
+	*line_len = len;
+	*raw_count = len;
+	*line_count = 0;
+
+	if (end == map->size) {
+		*line_count = 1;
+		map->position = end;
+	} else if (c == '\0') {
+		map->position = end + 1;
+	} else {
+		*raw_count = len + 1;
+		*line_count = 1;
+		map->position = end + 1;
+
+		if (c == '\r' && map->position < map->size && map->data[map->position] == '\n') {
+			map->position++;
+		}
+	}
+
+	return SMART_FILE_OK;
+}
+
+static int smart_file_map_read_line_common(void *file, char *buf, size_t len, size_t *row_pointer, size_t *count, size_t *raw_count_out, int skipEmpty) {
+	int res = SMART_FILE_UNKNOWN_ERROR;
+	SMART_FILE_MAP *map = file;
+	const char *line = NULL;
+	size_t line_len = 0;
+	size_t raw_count = 0;
+	size_t line_count = 0;
+	size_t empty_raw_count = 0;
+	size_t empty_line_count = 0;
+
+	if (file == NULL || buf == NULL || len == 0 || count == NULL) {
+		res = SMART_FILE_INVALID_ARG;
+		goto cleanup;
+	}
+	buf[0] = '\0';
+
+	do {
+		res = smart_file_map_next_line(map, len - 1, &line, &line_len, &raw_count, &line_count);
+		if (res != SMART_FILE_OK && res != SMART_FILE_NO_EOL) goto cleanup;
+
+		/* Empty lines are skipped only when terminated with a newline. */
+		if (!skipEmpty || line_len > 0 || raw_count == 0) break;
+
+		empty_raw_count += raw_count;
+		empty_line_count += line_count;
+	} while (1);
+
+	if (line_len > 0) memcpy(buf, line, line_len);
+	buf[line_len] = '\0';
+
+	*count = line_len;
+	*raw_count_out = raw_count + empty_raw_count;
+
+	if (res == SMART_FILE_OK && row_pointer != NULL) {
+		*row_pointer += line_count + empty_line_count;
+	}
+
+cleanup:
+
+	return res;
+}
+
+static int smart_file_map_read_line(void *file, char *buf, size_t len, size_t *row_pointer, size_t *count, size_t *raw_count) {
+	return smart_file_map_read_line_common(file, buf, len, row_pointer, count, raw_count, 1);
+}
+
+static int smart_file_map_read_line_every(void *file, char *buf, size_t len, size_t *row_pointer, size_t *count, size_t *raw_count) {
+	return smart_file_map_read_line_common(file, buf, len, row_pointer, count, raw_count, 0);
+}
+
+static int smart_file_map_read_line_span(void *file, const char **line, size_t *line_len, size_t *raw_count) {
+	size_t line_count = 0;
+
+	if (file == NULL || line == NULL || line_len == NULL || raw_count == NULL) return SMART_FILE_INVALID_ARG;
+
+	return smart_file_map_next_line(file, (size_t)-1, line, line_len, raw_count, &line_count);
+}
+
+static int smart_file_map_gets(void *file, char *raw, size_t raw_len, int *eof) {
+	SMART_FILE_MAP *map = file;
+	const char *lf = NULL;
+	size_t len = 0;
+
+	if (file == NULL || raw == NULL || raw_len == 0 || eof == NULL) return SMART_FILE_INVALID_ARG;
+
+	*eof = 0;
+
+	if (map->position == map->size) {
+		int res = smart_file_map_update(map);
+		if (res != SMART_FILE_OK) return res;
+	}
+
+	if (map->position == map->size) {
+		*eof = 1;
+		return SMART_FILE_OK;
+	}
+
+	/* Same as fgets, newline is kept. */
+	len = map->size - map->position;
+	if (len > raw_len - 1) len = raw_len - 1;
 
+	lf = memchr(map->data + map->position, '\n', len);
+	if (lf != NULL) len = (size_t)(lf - (map->data + map->position)) + 1;
 
-	error_code = errno;
+	memcpy(raw, map->data + map->position, len);
+	raw[len] = '\0';
+	map->position += len;
 
-	switch(error_code) {
-		case 0:
-			smart_file_error_code =  SMART_FILE_OK;
-		break;
+	return SMART_FILE_OK;
+}
 
-		case ENOENT:
-			smart_file_error_code =  SMART_FILE_DOES_NOT_EXIST;
-		break;
+static int smart_file_map_set_lock(void *file, int lockType) {
+	SMART_FILE_MAP *map = file;
+	struct flock lock;
 
-		case EACCES:
-			smart_file_error_code =  SMART_FILE_ACCESS_DENIED;
-		break;
+	if (file == NULL) return SMART_FILE_INVALID_ARG;
 
-		case EINVAL:
-			smart_file_error_code =  SMART_FILE_INVALID_PATH;
-		break;
+	lock.l_type = (lockType == SMART_FILE_READ_LOCK) ? F_RDLCK : F_WRLCK;
+	lock.l_whence = SEEK_SET;
+	lock.l_start = 0;
+	lock.l_len = 0;
 
-		default:
-			smart_file_error_code = SMART_FILE_UNKNOWN_ERROR;
-		break;
-	}
+	if (fcntl(map->fd, F_SETLK, &lock) != 0) return SMART_FILE_UNABLE_TO_LOCK;
 
-	return smart_file_error_code;
+	return SMART_FILE_OK;
 }
 
 static int file_get_type(const char *path, int *type) {
@@ -689,6 +1411,53 @@ static char* get_pure_mode(const char *mode, char *buf, size_t buf_len) {
 	return buf;
 }
 
+/**
+ * Writes the content of the write buffer to the file. Must be called before any other
+ * operation than a write, so that the file never sees the data out of order.
+ */
+static int smart_file_write_buffer_flush(SMART_FILE *file) {
+	int res;
+	size_t c = 0;
+
+	if (file->wbuf_len == 0) return SMART_FILE_OK;
+
+	res = file->file_write(file->file, file->wbuf, file->wbuf_len, &c);
+	if (res != SMART_FILE_OK) return res;
+	if (c != file->wbuf_len) return SMART_FILE_UNABLE_TO_WRITE;
+
+	file->wbuf_len = 0;
+
+	return SMART_FILE_OK;
+}
+
+/**
+ * Copies the data into the write buffer, that is written to the file when full. Data
+ * that does not fit into the empty buffer is written directly.
+ */
+static int smart_file_write_buffered(SMART_FILE *file, const unsigned char *raw, size_t raw_len, size_t *count) {
+	int res;
+
+	if (file->wbuf == NULL) {
+		file->wbuf = (unsigned char*)malloc(SMART_FILE_WRITE_BUFFER_SIZE);
+		if (file->wbuf == NULL) return SMART_FILE_OUT_OF_MEM;
+	}
+
+	if (file->wbuf_len + raw_len > SMART_FILE_WRITE_BUFFER_SIZE) {
+		res = smart_file_write_buffer_flush(file);
+		if (res != SMART_FILE_OK) return res;
+	}
+
+	if (raw_len >= SMART_FILE_WRITE_BUFFER_SIZE) {
+		return file->file_write(file->file, raw, raw_len, count);
+	}
+
+	memcpy(file->wbuf + file->wbuf_len, raw, raw_len);
+	file->wbuf_len += raw_len;
+	*count = raw_len;
+
+	return SMART_FILE_OK;
+}
+
 int SMART_FILE_open(const char *fname, const char *mode, SMART_FILE **file) {
 	int res;
 	SMART_FILE *tmp = NULL;
@@ -706,6 +1475,9 @@ int SMART_FILE_open(const char *fname, const char *mode, SMART_FILE **file) {
 	int is_B;
 	int is_T;
 	int is_X;
+	int is_M;
+	int is_m;
+	int type = SMART_FILE_TYPE_UNKNOWN;
 
 
 	if (fname == NULL || mode == NULL || file == NULL) {
@@ -722,6 +1494,8 @@ int SMART_FILE_open(const char *fname, const char *mode, SMART_FILE **file) {
 	is_B = strchr(mode, 'B') == NULL ? 0 : 1;
 	is_T = strchr(mode, 'T') == NULL ? 0 : 1;
 	is_X = strchr(mode, 'X') == NULL ? 0 : 1;
+	is_M = strchr(mode, 'M') == NULL ? 0 : 1;
+	is_m = strchr(mode, 'm') == NULL ? 0 : 1;
 
 
 	/* Reject bad combinations. */
@@ -731,6 +1505,8 @@ int SMART_FILE_open(const char *fname, const char *mode, SMART_FILE **file) {
 		|| (!is_w && is_T && isStream) /* Read mode stream with output temporary file buffer. */
 		|| (!is_w && (is_B || is_T || is_i || is_f)) /* Read mode with backups and temporary files is not logical. */
 		|| (!is_w && is_e) /* Read mode from stderr does not work. */
+		|| (is_M && (!is_w || isStream || is_B || is_T || is_i || is_f)) /* Memory file is not related to any file on the disk. */
+		|| (is_m && (is_w || is_M)) /* Memory mapping is only used for reading. */
 		) {
 		res = SMART_FILE_INVALID_MODE;
 		goto cleanup;
@@ -739,7 +1515,7 @@ int SMART_FILE_open(const char *fname, const char *mode, SMART_FILE **file) {
 	/**
 	 * Some special flags that should be checked before going ahead.
 	 */
-	if (!isStream) {
+	if (!isStream && !is_M) {
 		/* If file already exists try to resolve the case.
 		   By default file is overwritten! */
 		if (is_w && SMART_FILE_doFileExist(fname)) {
@@ -794,6 +1570,9 @@ int SMART_FILE_open(const char *fname, const char *mode, SMART_FILE **file) {
 	tmp->isStream = isStream;
 	tmp->isTmpStreamBuffer = isStream && is_T;
 	tmp->consistent_position = 0;
+	tmp->wbuf = NULL;
+	tmp->wbuf_len = 0;
+	tmp->isWriteBuffered = 0;
 
 	/* Make a copy from the file names. */
 	KSI_strncpy(tmp->fname, pFname, sizeof(tmp->fname));
@@ -803,7 +1582,15 @@ int SMART_FILE_open(const char *fname, const char *mode, SMART_FILE **file) {
 	/**
 	 * Initialize implementations.
 	 */
-	res = smart_file_init(tmp);
+	if (is_M) {
+		res = smart_file_init_mem(tmp);
+	} else if (is_m && !isStream && file_get_type(fname, &type) == SMART_FILE_OK && type == SMART_FILE_TYPE_REGULAR) {
+		/* Pipes and other special files are read with stdio. */
+		res = smart_file_init_map(tmp);
+	} else {
+		res = smart_file_init(tmp);
+		tmp->isWriteBuffered = is_w;
+	}
 	if (res != SMART_FILE_OK) goto cleanup;
 
 	/* If there is a need to create a backup IMMEDIATELY (no tmp file is used) do it NOW! */
@@ -870,9 +1657,16 @@ int SMART_FILE_close(SMART_FILE *file) {
 	void *stream = NULL;
 	int is_stream_close_mandatory = 0;
 	int need_to_close_the_file = 0;
+	int write_error = SMART_FILE_OK;
 
 
 	if (file != NULL) {
+		/* Data that can not be written makes the file inconsistent. */
+		if (file->isOpen && file->file != NULL) {
+			write_error = smart_file_write_buffer_flush(file);
+			if (write_error != SMART_FILE_OK) file->isConsistent = 0;
+		}
+
 		is_B = strchr(file->mode, 'B') == NULL ? 0 : 1;
 		is_T = strchr(file->mode, 'T') == NULL ? 0 : 1;
 		is_X = strchr(file->mode, 'X') == NULL ? 0 : 1;
@@ -926,14 +1720,9 @@ int SMART_FILE_close(SMART_FILE *file) {
 					res = SMART_FILE_rename(file->fname, file->bak_fname);
 					if (res != SMART_FILE_OK) goto cleanup;
 					file->isBackupCreated = 1;
-				/* Make temporary file persistent, remove existing file. */
-				} else if (!is_B) {
-					if (SMART_FILE_doFileExist(file->fname)) {
-						res = SMART_FILE_remove(file->fname);
-						if (res != SMART_FILE_OK) goto cleanup;
-					}
 				}
 
+				/* Make temporary file persistent. Existing file is replaced atomically by rename. */
 				res = SMART_FILE_rename(file->tmp_fname, file->fname);
 				if (res != SMART_FILE_OK) goto cleanup;
 			}
@@ -957,10 +1746,11 @@ int SMART_FILE_close(SMART_FILE *file) {
 		}
 	}
 
-	res = SMART_FILE_OK;
+	res = write_error;
 
 cleanup:
 	if (need_to_close_the_file) file->file_close(file->file);
+	if (file != NULL) free(file->wbuf);
 	if (file != NULL) free(file);
 
 	if (is_stream_close_mandatory && stream != NULL && file != NULL && file->file_close != NULL) {
@@ -977,6 +1767,11 @@ int SMART_FILE_markConsistent(SMART_FILE *file) {
 
 	if (file == NULL) return SMART_FILE_INVALID_ARG;
 	if (!file->isOpen) return SMART_FILE_NOT_OPEND;
+
+	/* Consistent state of the file is a flush point of the write buffer. */
+	res = smart_file_write_buffer_flush(file);
+	if (res != SMART_FILE_OK) return res;
+
 	file->isConsistent = 1;
 
 	is_X = strchr(file->mode, 'X') == NULL ? 0 : 1;
@@ -1008,7 +1803,11 @@ int SMART_FILE_write(SMART_FILE *file, const unsigned char *raw, size_t raw_len,
 	}
 
 	if (file->file != NULL && file->isOpen) {
-		res = file->file_write(file->file, raw, raw_len, &c);
+		if (file->isWriteBuffered) {
+			res = smart_file_write_buffered(file, raw, raw_len, &c);
+		} else {
+			res = file->file_write(file->file, raw, raw_len, &c);
+		}
 		if (res != SMART_FILE_OK) goto cleanup;
 	} else {
 		return SMART_FILE_NOT_OPEND;
@@ -1030,6 +1829,137 @@ cleanup:
 	return res;
 }
 
+int SMART_FILE_writev(SMART_FILE *file, const SMART_FILE_IOVEC *iov, size_t iov_count, size_t *count) {
+	int res;
+	size_t i;
+	size_t c = 0;
+	size_t total = 0;
+
+	if (file == NULL || (iov == NULL && iov_count > 0)) {
+		res = SMART_FILE_INVALID_ARG;
+		goto cleanup;
+	}
+
+	if (file->file == NULL || !file->isOpen) return SMART_FILE_NOT_OPEND;
+
+	for (i = 0; i < iov_count; i++) {
+		if (iov[i].raw_len == 0) continue;
+
+		res = SMART_FILE_write(file, iov[i].raw, iov[i].raw_len, &c);
+		total += c;
+		if (res != SMART_FILE_OK) goto cleanup;
+	}
+
+	res = SMART_FILE_OK;
+
+cleanup:
+
+	if (count != NULL) {
+		*count = total;
+	}
+
+	return res;
+}
+
+/**
+ * Copies the data by reading it into a buffer and writing it to the output file.
+ */
+static int smart_file_copy_range_by_read(SMART_FILE *in, size_t offset, size_t len, SMART_FILE *out, size_t *count) {
+	int res;
+	unsigned char buf[SMART_FILE_COPY_BUFFER_SIZE];
+	size_t total = 0;
+
+	res = SMART_FILE_setPosition(in, offset);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	while (total < len) {
+		size_t c = 0;
+		size_t chunk = (len - total < sizeof(buf)) ? len - total : sizeof(buf);
+
+		res = SMART_FILE_read(in, buf, chunk, &c);
+		if (res != SMART_FILE_OK) goto cleanup;
+
+		if (c == 0) {
+			res = SMART_FILE_UNABLE_TO_READ;
+			goto cleanup;
+		}
+
+		res = SMART_FILE_write(out, buf, c, NULL);
+		if (res != SMART_FILE_OK) goto cleanup;
+
+		total += c;
+	}
+
+	res = SMART_FILE_OK;
+
+cleanup:
+
+	*count += total;
+
+	return res;
+}
+
+int SMART_FILE_copyRange(SMART_FILE *in, size_t offset, size_t len, SMART_FILE *out, size_t *count) {
+	int res;
+	size_t total = 0;
+
+	if (in == NULL || out == NULL) {
+		res = SMART_FILE_INVALID_ARG;
+		goto cleanup;
+	}
+
+	if (in->file == NULL || !in->isOpen || out->file == NULL || !out->isOpen) return SMART_FILE_NOT_OPEND;
+
+#ifdef HAVE_COPY_FILE_RANGE
+	if (len > 0 && in->file_get_fd(in->file) != -1 && out->file_get_fd(out->file) != -1) {
+		size_t outPos = 0;
+		loff_t off_in = (loff_t)offset;
+		loff_t off_out = 0;
+
+		/* Everything written so far must reach the file before the kernel writes after it. */
+		res = SMART_FILE_flush(out);
+		if (res != SMART_FILE_OK) goto cleanup;
+
+		res = SMART_FILE_getPosition(out, &outPos);
+		if (res != SMART_FILE_OK) goto cleanup;
+
+		/* Data is copied (or shared, if supported by the file system) without passing it through
+		 * the user space. If the files do not support it (e.g. a pipe or different file systems
+		 * with older kernels), the rest of the data is copied by reading it. */
+		off_out = (loff_t)outPos;
+		while (total < len) {
+			ssize_t c = copy_file_range(in->file_get_fd(in->file), &off_in, out->file_get_fd(out->file), &off_out, len - total, 0);
+			if (c <= 0) break;
+			total += (size_t)c;
+		}
+
+		/* Offsets of the file descriptors are not changed, the stream is moved after the copied data. */
+		if (total > 0) {
+			res = out->file_reposition(out->file, outPos + total);
+			if (res != SMART_FILE_OK) goto cleanup;
+		}
+	}
+#endif
+
+	if (total < len) {
+		res = smart_file_copy_range_by_read(in, offset + total, len - total, out, &total);
+		if (res != SMART_FILE_OK) goto cleanup;
+	} else {
+		res = SMART_FILE_setPosition(in, offset + len);
+		if (res != SMART_FILE_OK) goto cleanup;
+	}
+
+	res = SMART_FILE_OK;
+
+cleanup:
+
+	if (count != NULL) {
+		*count = total;
+	}
+
+	return res;
+}
+
 int SMART_FILE_read(SMART_FILE *file, unsigned char *raw, size_t raw_len, size_t *count) {
 	int res;
 	size_t c = 0;
@@ -1040,6 +1970,9 @@ int SMART_FILE_read(SMART_FILE *file, unsigned char *raw, size_t raw_len, size_t
 	}
 
 	if (file->file != NULL && file->isOpen) {
+		res = smart_file_write_buffer_flush(file);
+		if (res != SMART_FILE_OK) goto cleanup;
+
 		res = file->file_read(file->file, raw, raw_len, &c);
 		if (res != SMART_FILE_OK) goto cleanup;
 	} else {
@@ -1074,6 +2007,9 @@ static int smart_file_read_line_skip_empty_or_not(SMART_FILE *file, char *raw, s
 	}
 
 	if (file->file != NULL && file->isOpen) {
+		res = smart_file_write_buffer_flush(file);
+		if (res != SMART_FILE_OK) goto cleanup;
+
 		if (skipEmpty) {
 			res = file->file_read_line(file->file, raw, raw_len, row_pointer, &c, &raw_count);
 		} else {
@@ -1107,10 +2043,63 @@ int SMART_FILE_readLineSkipEmpty(SMART_FILE *file, char *raw, size_t raw_len, si
 	return smart_file_read_line_skip_empty_or_not(file, raw, raw_len, row_pointer, count, 1);
 }
 
+int SMART_FILE_readLineSpan(SMART_FILE *file, const char **line, size_t *line_len) {
+	int res;
+	size_t raw_count = 0;
+
+	if (file == NULL || line == NULL || line_len == NULL) {
+		res = SMART_FILE_INVALID_ARG;
+		goto cleanup;
+	}
+
+	if (file->file != NULL && file->isOpen) {
+		if (file->file_read_line_span == NULL) return SMART_FILE_INVALID_MODE;
+
+		res = file->file_read_line_span(file->file, line, line_len, &raw_count);
+		if (res != SMART_FILE_OK) goto cleanup;
+	} else {
+		return SMART_FILE_NOT_OPEND;
+	}
+
+	/**
+	 * EOF is detected as Read finished without an error and read count is zero.
+	 */
+	if (raw_count == 0) {
+		file->isEOF = 1;
+	}
+
+	res = SMART_FILE_OK;
+
+cleanup:
+
+	return res;
+}
+
 int SMART_FILE_readLine(SMART_FILE *file, char *raw, size_t raw_len, size_t *count) {
 	return smart_file_read_line_skip_empty_or_not(file, raw, raw_len, NULL, count, 0);
 }
 
+int SMART_FILE_findLineEnd(const unsigned char *buf, size_t len, size_t *end) {
+	size_t i;
+
+	if (buf == NULL || end == NULL) return 0;
+
+	/* Same rules as smart_file_read_line_common and smart_file_map_next_line. */
+	for (i = 0; i < len; i++) {
+		unsigned char c = buf[i];
+
+		if (c == '\n' || c == '\0') {
+			*end = i + 1;
+			return 1;
+		} else if (c == '\r') {
+			*end = (i + 1 < len && buf[i + 1] == '\n') ? i + 2 : i + 1;
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
 int SMART_FILE_gets(SMART_FILE *file, char *raw, size_t raw_len, size_t *count) {
 	int res;
 	int isEof = 0;
@@ -1121,6 +2110,9 @@ int SMART_FILE_gets(SMART_FILE *file, char *raw, size_t raw_len, size_t *count)
 	}
 
 	if (file->file != NULL && file->isOpen) {
+		res = smart_file_write_buffer_flush(file);
+		if (res != SMART_FILE_OK) goto cleanup;
+
 		res = file->file_gets(file->file, raw, raw_len, &isEof);
 		if (res != SMART_FILE_OK) goto cleanup;
 
@@ -1171,8 +2163,106 @@ int SMART_FILE_rewind(SMART_FILE *file) {
 	}
 
 	if (file->file != NULL && file->isOpen) {
+		res = smart_file_write_buffer_flush(file);
+		if (res != SMART_FILE_OK) goto cleanup;
+
 		res = file->file_reposition(file->file, 0);
 		if (res != SMART_FILE_OK) goto cleanup;
+		file->isEOF = 0;
+	} else {
+		return SMART_FILE_NOT_OPEND;
+	}
+
+	res = SMART_FILE_OK;
+
+cleanup:
+
+	return res;
+}
+
+int SMART_FILE_flush(SMART_FILE *file) {
+	int res;
+
+	if (file == NULL) return SMART_FILE_INVALID_ARG;
+	if (file->file == NULL || !file->isOpen) return SMART_FILE_NOT_OPEND;
+
+	res = smart_file_write_buffer_flush(file);
+	if (res != SMART_FILE_OK) return res;
+
+	return file->file_flush(file->file);
+}
+
+int SMART_FILE_sync(SMART_FILE *file) {
+	int res;
+
+	if (file == NULL) return SMART_FILE_INVALID_ARG;
+	if (file->file == NULL || !file->isOpen) return SMART_FILE_NOT_OPEND;
+
+	res = smart_file_write_buffer_flush(file);
+	if (res != SMART_FILE_OK) return res;
+
+	return file->file_sync(file->file);
+}
+
+int SMART_FILE_truncate(SMART_FILE *file, size_t pos) {
+	int res;
+
+	if (file == NULL) return SMART_FILE_INVALID_ARG;
+	if (file->file == NULL || !file->isOpen) return SMART_FILE_NOT_OPEND;
+	if (file->isStream) return SMART_FILE_INVALID_MODE;
+
+	res = smart_file_write_buffer_flush(file);
+	if (res != SMART_FILE_OK) return res;
+
+	res = file->file_truncate(file->file, pos);
+	if (res != SMART_FILE_OK) return res;
+	file->isEOF = 0;
+
+	return SMART_FILE_OK;
+}
+
+int SMART_FILE_getPosition(SMART_FILE *file, size_t *pos) {
+	int res;
+	size_t tmp = 0;
+
+	if (file == NULL || pos == NULL) {
+		res = SMART_FILE_INVALID_ARG;
+		goto cleanup;
+	}
+
+	if (file->file != NULL && file->isOpen) {
+		res = file->file_get_current_position(file->file, &tmp);
+		if (res != SMART_FILE_OK) goto cleanup;
+
+		/* Buffered data is not written yet, but it is part of the file. */
+		tmp += file->wbuf_len;
+	} else {
+		return SMART_FILE_NOT_OPEND;
+	}
+
+	*pos = tmp;
+	res = SMART_FILE_OK;
+
+cleanup:
+
+	return res;
+}
+
+int SMART_FILE_setPosition(SMART_FILE *file, size_t pos) {
+	int res;
+
+	if (file == NULL) {
+		res = SMART_FILE_INVALID_ARG;
+		goto cleanup;
+	}
+
+	if (file->file != NULL && file->isOpen) {
+		res = smart_file_write_buffer_flush(file);
+		if (res != SMART_FILE_OK) goto cleanup;
+
+		res = file->file_reposition(file->file, pos);
+		if (res != SMART_FILE_OK) goto cleanup;
+		file->isEOF = 0;
 	} else {
 		return SMART_FILE_NOT_OPEND;
 	}
@@ -62,6 +62,12 @@ extern "C" {
 
 typedef struct SMART_FILE_st SMART_FILE;
 
+/* A piece of data written with #SMART_FILE_writev. */
+typedef struct SMART_FILE_IOVEC_st {
+	const unsigned char *raw;
+	size_t raw_len;
+} SMART_FILE_IOVEC;
+
 /**
  * Smart file object that is used to open, read and write files and streams. If user
  * wants to read from stdin or write to stdout, file name '-' must be used with mode
@@ -93,6 +99,11 @@ typedef struct SMART_FILE_st SMART_FILE;
  * and there is corrupted or not complete data at the end of the file, closing file
  * will drop the data.
  *
+ * Data written into a file opened with w (except wM) is collected into a write buffer
+ * and written to the file when the buffer is full, when the file is marked consistent
+ * (#SMART_FILE_markConsistent), flushed, read, repositioned, truncated or closed. This
+ * turns many small writes (e.g. TLVs of hash values) into a few large writes.
+ *
  * Success is marked with function #SMART_FILE_markConsistent. If it is not called
  * before #SMART_FILE_close, original file is restored from backup, temporary files
  * are discarded, stream buffered with temporary file is "flushed". With X this
@@ -121,6 +132,15 @@ typedef struct SMART_FILE_st SMART_FILE;
  *     - Possibility to clear not consistent end of the file. Can be combined
  *       with modes where output is directly written to a file (yes it works with
  *       wsT combination). Suggest to use with T.
+ * wM  - Keep the content in memory (file name is ignored). Content can be read
+ *       back after #SMART_FILE_rewind. It can not be combined with other modes.
+ * rm  - Map a regular file into memory for reading. Lines are found with memchr
+ *       and can be accessed without copying (see #SMART_FILE_readLineSpan). For
+ *       streams and files that are not regular files (e.g. pipes) it has no effect.
+ *       File is mapped again if it has grown when its end is reached and the
+ *       previous mapping is kept until the file is closed. Truncating the file
+ *       while it is read raises SIGBUS, thus it must not be used for files that
+ *       are written by others (e.g. the input log file of create).
  * \param fname file name to be used.
  * \param mode	file open mode.
  * \param file	smart file return pointer.
@@ -130,6 +150,32 @@ int SMART_FILE_open(const char *fname, const char *mode, SMART_FILE **file);
 
 int SMART_FILE_close(SMART_FILE *file);
 int SMART_FILE_write(SMART_FILE *file, const unsigned char *raw, size_t raw_len, size_t *count);
+
+/**
+ * Writes multiple pieces of data in the given order, as they were written with a
+ * single #SMART_FILE_write. Pieces are gathered into the write buffer.
+ * \param file			SMART_FILE object.
+ * \param iov			Array of pieces of data.
+ * \param iov_count		Count of pieces in \c iov.
+ * \param count			Output parameter for the count of bytes written. Can be NULL.
+ * \return SMART_FILE_OK if successful, error code otherwise.
+ */
+int SMART_FILE_writev(SMART_FILE *file, const SMART_FILE_IOVEC *iov, size_t iov_count, size_t *count);
+
+/**
+ * Copies \c len bytes starting from \c offset of the input file to the current position
+ * of the output file. When possible, the data is copied by the kernel (see copy_file_range)
+ * and shared between the files by the file systems that support it. Otherwise the data is
+ * read and written. The position of the input file is moved after the copied data.
+ * \param in			SMART_FILE object to copy from. Must not be a stream.
+ * \param offset		Position of the data in the input file.
+ * \param len			Count of bytes to copy.
+ * \param out			SMART_FILE object to copy to.
+ * \param count			Output parameter for the count of bytes copied. Can be NULL.
+ * \return SMART_FILE_OK if successful, SMART_FILE_UNABLE_TO_READ if the input file ends
+ * before \c len bytes, error code otherwise.
+ */
+int SMART_FILE_copyRange(SMART_FILE *in, size_t offset, size_t len, SMART_FILE *out, size_t *count);
 int SMART_FILE_read(SMART_FILE *file, unsigned char *raw, size_t raw_len, size_t *count);
 
 /**
@@ -160,9 +206,82 @@ int SMART_FILE_readLineSkipEmpty(SMART_FILE *file, char *raw, size_t raw_len, si
  * SMART_FILE_NO_EOL is returned.
  */
 int SMART_FILE_readLine(SMART_FILE *file, char *raw, size_t raw_len, size_t *count);
+
+/**
+ * Same as #SMART_FILE_readLine, but the line is not copied. The returned pointer
+ * points directly into the memory mapped file and is not terminated with 0.
+ * Only supported by memory mapped files (see mode m of #SMART_FILE_open).
+ * \param file			SMART_FILE object.
+ * \param line			Output parameter for the pointer to the line.
+ * \param line_len		Output parameter for the length of the line, without the newline character.
+ * \return SMART_FILE_OK if successful, SMART_FILE_INVALID_MODE if the file is not
+ * memory mapped, error code otherwise. The pointer is valid until the file is closed,
+ * also after the file is mapped again as it has grown.
+ */
+int SMART_FILE_readLineSpan(SMART_FILE *file, const char **line, size_t *line_len);
+
+/**
+ * Finds the end of the first line in the buffer with the same rules as #SMART_FILE_readLine,
+ * so that the lines can be counted without reading them one by one. Line ends with LF, CR,
+ * CR LF or with character 0x00.
+ * \param buf			Buffer.
+ * \param len			Size of the buffer.
+ * \param end			Output parameter for the position after the end of the line.
+ * \return 1 if the end of the line is found, 0 otherwise. If the line ends with CR that
+ * is the last character in the buffer, the LF that may follow it is not in the buffer and
+ * must be checked by the caller.
+ */
+int SMART_FILE_findLineEnd(const unsigned char *buf, size_t len, size_t *end);
 int SMART_FILE_gets(SMART_FILE *file, char *raw, size_t raw_len, size_t *count);
 int SMART_FILE_rewind(SMART_FILE *file);
 int SMART_FILE_lock(SMART_FILE *file, int lock);
+
+/**
+ * Returns the current read or write position of the file. For memory mapped files
+ * it is the offset of the next byte to be read.
+ * \param file			SMART_FILE object.
+ * \param pos			Output parameter for the position.
+ * \return SMART_FILE_OK if successful, SMART_FILE_UNABLE_TO_GET_POSITION if the
+ * position can not be determined (e.g. stdin is a pipe), error code otherwise.
+ */
+int SMART_FILE_getPosition(SMART_FILE *file, size_t *pos);
+
+/**
+ * Moves the read or write position of the file to \c pos bytes from the beginning
+ * of the file and clears the end of file indicator.
+ * \param file			SMART_FILE object.
+ * \param pos			New position.
+ * \return SMART_FILE_OK if successful, error code otherwise. Fails if the file is
+ * a stream (e.g. stdin).
+ */
+int SMART_FILE_setPosition(SMART_FILE *file, size_t pos);
+
+/**
+ * Writes the data buffered by the file object to the file. Memory files and memory
+ * mapped files are not buffered.
+ * \param file			SMART_FILE object.
+ * \return SMART_FILE_OK if successful, error code otherwise.
+ */
+int SMART_FILE_flush(SMART_FILE *file);
+
+/**
+ * Same as #SMART_FILE_flush, but the data is also written from the system cache to
+ * the storage device (see fsync).
+ * \param file			SMART_FILE object.
+ * \return SMART_FILE_OK if successful, error code otherwise.
+ */
+int SMART_FILE_sync(SMART_FILE *file);
+
+/**
+ * Cuts the file to the size of \c pos bytes and moves the position to the end of
+ * the file.
+ * \param file			SMART_FILE object.
+ * \param pos			New size of the file.
+ * \return SMART_FILE_OK if successful, SMART_FILE_INVALID_MODE if the file is a
+ * stream or memory mapped, error code otherwise.
+ */
+int SMART_FILE_truncate(SMART_FILE *file, size_t pos);
+
 int SMART_FILE_markConsistent(SMART_FILE *file);
 int SMART_FILE_markInconsistent(SMART_FILE *file);
 
@@ -161,6 +161,45 @@ int LOGKSI_FTLV_smartFileRead(SMART_FILE *sf, unsigned char *buf, size_t len, si
 	return readData(sf, buf, len, consumed, t, (reader_t) SMART_FILE_read);
 }
 
+int LOGKSI_FTLV_smartFileReadHeader(SMART_FILE *sf, size_t *consumed, struct fast_tlv_s *t) {
+	int res;
+	unsigned char hdr[4];
+	size_t count = 0;
+
+	if (sf == NULL || consumed == NULL || t == NULL) return KT_INVALID_ARGUMENT;
+
+	*consumed = 0;
+
+	res = SMART_FILE_read(sf, hdr, 2, &count);
+	if (res != SMART_FILE_OK) return res;
+
+	*consumed = count;
+	if (count < 2) return KT_INVALID_INPUT_FORMAT;
+
+	t->off = 0;
+	t->is_nc = (hdr[0] & 0x40) ? 1 : 0;
+	t->is_fwd = (hdr[0] & 0x20) ? 1 : 0;
+
+	/* TLV16 has 13 bit tag and 16 bit length, TLV8 has 5 bit tag and 8 bit length. */
+	if (hdr[0] & 0x80) {
+		res = SMART_FILE_read(sf, hdr + 2, 2, &count);
+		if (res != SMART_FILE_OK) return res;
+
+		*consumed += count;
+		if (count < 2) return KT_INVALID_INPUT_FORMAT;
+
+		t->tag = ((hdr[0] & 0x1f) << 8) | hdr[1];
+		t->hdr_len = 4;
+		t->dat_len = ((size_t)hdr[2] << 8) | hdr[3];
+	} else {
+		t->tag = hdr[0] & 0x1f;
+		t->hdr_len = 2;
+		t->dat_len = hdr[1];
+	}
+
+	return KT_OK;
+}
+
 int tlv_element_get_uint(KSI_TlvElement *tlv, KSI_CTX *ksi, unsigned tag, size_t *out) {
 	int res;
 	KSI_TlvElement *el = NULL;
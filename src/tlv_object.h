@@ -32,6 +32,8 @@ extern "C" {
 #include "smart_file.h"
 #include "tool_box/extract_info.h"
 
+#define META_DATA_BLOCK_CLOSE_REASON "com.guardtime.blockCloseReason"
+
 typedef struct MetaDataRecord_st MetaDataRecord;
 
 int tlv_element_get_uint(KSI_TlvElement *tlv, KSI_CTX *ksi, unsigned tag, size_t *out);
@@ -50,6 +52,17 @@ int tlv_element_write_signature_block(KSI_CTX *ksi, uint64_t recCount, KSI_Signa
 int tlv_element_parse_and_check_sub_elements(ERR_TRCKR *err, KSI_CTX *ksi, unsigned char *dat, size_t dat_len, size_t hdr_len, KSI_TlvElement **out);
 int LOGKSI_FTLV_smartFileRead(SMART_FILE *sf, unsigned char *buf, size_t len, size_t *consumed, struct fast_tlv_s *t);
 
+/**
+ * Reads only the header of the next TLV, the value is not read. Can be used to skip
+ * the TLVs that are not needed (see #SMART_FILE_setPosition).
+ * \param sf			SMART_FILE object.
+ * \param consumed		Output parameter for the count of bytes read.
+ * \param t				Output parameter for the tag, header length and value length.
+ * \return KT_OK if successful, KT_INVALID_INPUT_FORMAT if the header is incomplete
+ * (\c consumed is 0 at the end of the file), error code otherwise.
+ */
+int LOGKSI_FTLV_smartFileReadHeader(SMART_FILE *sf, size_t *consumed, struct fast_tlv_s *t);
+
 int MetaDataRecord_new(KSI_CTX *ksi, uint64_t recIndex, const char *key, const char *value, MetaDataRecord **obj);
 void MetaDataRecord_free(MetaDataRecord *obj);
 int MetaDataRecord_serialize(KSI_CTX *ksi, MetaDataRecord *rec, unsigned char **raw, size_t *raw_len);
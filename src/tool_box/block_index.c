@@ -0,0 +1,443 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "logksi_err.h"
+#include "block_index.h"
+
+/**
+ * Index file layout (all integers are 64-bit big-endian):
+ *   magic "LOGIDX11" | size of the log signature file | size, device, inode and modification
+ *   time of the log file | count of entries | entries
+ * where every entry is:
+ *   block no | sig offset | log offset | first line | last line | record count | signing time | is signed
+ */
+#define BLOCK_INDEX_MAGIC "LOGIDX11"
+#define BLOCK_INDEX_MAGIC_SIZE 8
+#define BLOCK_INDEX_HEADER_SIZE (BLOCK_INDEX_MAGIC_SIZE + 6 * 8)
+#define BLOCK_INDEX_ENTRY_SIZE (8 * 8)
+
+/* Identity of the log file the log file offsets are found for. */
+typedef struct BLOCK_INDEX_LOG_ID_st {
+	uint64_t size;
+	uint64_t device;
+	uint64_t inode;
+	uint64_t mtime;
+} BLOCK_INDEX_LOG_ID;
+
+struct BLOCK_INDEX_st {
+	BLOCK_INDEX_ENTRY *entries;
+	size_t capacity;
+	size_t count;
+	BLOCK_INDEX_LOG_ID log;
+};
+
+static void block_index_put_uint64(unsigned char *buf, uint64_t val) {
+	int i;
+
+	for (i = 7; i >= 0; i--) {
+		buf[i] = (unsigned char)(val & 0xff);
+		val >>= 8;
+	}
+}
+
+static uint64_t block_index_get_uint64(const unsigned char *buf) {
+	uint64_t val = 0;
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		val = (val << 8) | buf[i];
+	}
+
+	return val;
+}
+
+static void block_index_entry_serialize(const BLOCK_INDEX_ENTRY *entry, unsigned char *buf) {
+	block_index_put_uint64(buf + 0 * 8, entry->blockNo);
+	block_index_put_uint64(buf + 1 * 8, entry->sigOffset);
+	block_index_put_uint64(buf + 2 * 8, entry->logOffset);
+	block_index_put_uint64(buf + 3 * 8, entry->firstLine);
+	block_index_put_uint64(buf + 4 * 8, entry->lastLine);
+	block_index_put_uint64(buf + 5 * 8, entry->recordCount);
+	block_index_put_uint64(buf + 6 * 8, entry->sigTime);
+	block_index_put_uint64(buf + 7 * 8, entry->isSigned ? 1 : 0);
+}
+
+static void block_index_entry_parse(const unsigned char *buf, BLOCK_INDEX_ENTRY *entry) {
+	entry->blockNo = block_index_get_uint64(buf + 0 * 8);
+	entry->sigOffset = block_index_get_uint64(buf + 1 * 8);
+	entry->logOffset = block_index_get_uint64(buf + 2 * 8);
+	entry->firstLine = block_index_get_uint64(buf + 3 * 8);
+	entry->lastLine = block_index_get_uint64(buf + 4 * 8);
+	entry->recordCount = block_index_get_uint64(buf + 5 * 8);
+	entry->sigTime = block_index_get_uint64(buf + 6 * 8);
+	entry->isSigned = block_index_get_uint64(buf + 7 * 8) ? 1 : 0;
+}
+
+static int block_index_get_log_id(const char *fname, BLOCK_INDEX_LOG_ID *id) {
+	struct stat st;
+
+	if (stat(fname, &st) != 0) return KT_IO_ERROR;
+
+	id->size = (uint64_t)st.st_size;
+	id->device = (uint64_t)st.st_dev;
+	id->inode = (uint64_t)st.st_ino;
+	id->mtime = (uint64_t)st.st_mtime;
+
+	return KT_OK;
+}
+
+static int block_index_read_all(SMART_FILE *in, unsigned char *buf, size_t len) {
+	int res;
+	size_t count = 0;
+
+	res = SMART_FILE_read(in, buf, len, &count);
+	if (res != SMART_FILE_OK) return res;
+
+	return (count == len) ? KT_OK : KT_INVALID_INPUT_FORMAT;
+}
+
+/* Sets the log file offset of the blocks that start with the given line. */
+static void block_index_set_line_offset(BLOCK_INDEX *index, size_t *next, uint64_t lineNo, uint64_t lineStart) {
+	while (*next < index->count && index->entries[*next].firstLine <= lineNo) {
+		if (index->entries[*next].firstLine == lineNo) index->entries[*next].logOffset = lineStart;
+		(*next)++;
+	}
+}
+
+int BLOCK_INDEX_new(BLOCK_INDEX **index) {
+	BLOCK_INDEX *tmp = NULL;
+
+	if (index == NULL) return KT_INVALID_ARGUMENT;
+
+	tmp = (BLOCK_INDEX*)malloc(sizeof(BLOCK_INDEX));
+	if (tmp == NULL) return KT_OUT_OF_MEMORY;
+
+	tmp->entries = NULL;
+	tmp->capacity = 0;
+	tmp->count = 0;
+	memset(&tmp->log, 0, sizeof(tmp->log));
+
+	*index = tmp;
+
+	return KT_OK;
+}
+
+void BLOCK_INDEX_free(BLOCK_INDEX *index) {
+	if (index == NULL) return;
+
+	free(index->entries);
+	free(index);
+}
+
+int BLOCK_INDEX_add(BLOCK_INDEX *index, const BLOCK_INDEX_ENTRY *entry) {
+	if (index == NULL || entry == NULL) return KT_INVALID_ARGUMENT;
+	if (entry->blockNo != index->count + 1) return KT_INVALID_ARGUMENT;
+
+	if (index->count == index->capacity) {
+		size_t capacity = (index->capacity == 0) ? 64 : index->capacity * 2;
+		BLOCK_INDEX_ENTRY *entries = NULL;
+
+		entries = (BLOCK_INDEX_ENTRY*)realloc(index->entries, capacity * sizeof(BLOCK_INDEX_ENTRY));
+		if (entries == NULL) return KT_OUT_OF_MEMORY;
+
+		index->entries = entries;
+		index->capacity = capacity;
+	}
+
+	index->entries[index->count] = *entry;
+	index->count++;
+
+	return KT_OK;
+}
+
+const BLOCK_INDEX_ENTRY *BLOCK_INDEX_get(BLOCK_INDEX *index, size_t i) {
+	if (index == NULL || i >= index->count) return NULL;
+	return &index->entries[i];
+}
+
+size_t BLOCK_INDEX_getCount(BLOCK_INDEX *index) {
+	return (index == NULL) ? 0 : index->count;
+}
+
+int BLOCK_INDEX_findByLine(BLOCK_INDEX *index, uint64_t lineNo, size_t *i) {
+	size_t first = 0;
+	size_t last = 0;
+
+	if (index == NULL || i == NULL) return KT_INVALID_ARGUMENT;
+
+	/* Find the first block whose last line is not before the line. */
+	last = index->count;
+	while (first < last) {
+		size_t mid = first + (last - first) / 2;
+
+		if (index->entries[mid].lastLine < lineNo) {
+			first = mid + 1;
+		} else {
+			last = mid;
+		}
+	}
+
+	/* Blocks without lines (lastLine < firstLine) are skipped. */
+	while (first < index->count && index->entries[first].lastLine < index->entries[first].firstLine) first++;
+
+	if (first >= index->count || index->entries[first].firstLine > lineNo) return KT_INDEX_OVF;
+
+	*i = first;
+
+	return KT_OK;
+}
+
+void BLOCK_INDEX_inheritLogOffsets(BLOCK_INDEX *index, BLOCK_INDEX *old) {
+	size_t i;
+
+	if (index == NULL || old == NULL) return;
+
+	/* Offsets are valid only for the log file they are found for. */
+	index->log = old->log;
+
+	for (i = 0; i < index->count && i < old->count; i++) {
+		BLOCK_INDEX_ENTRY *entry = &index->entries[i];
+		const BLOCK_INDEX_ENTRY *oldEntry = &old->entries[i];
+
+		if (entry->logOffset == BLOCK_INDEX_UNKNOWN_OFFSET &&
+			entry->blockNo == oldEntry->blockNo &&
+			entry->firstLine == oldEntry->firstLine &&
+			entry->lastLine == oldEntry->lastLine) {
+			entry->logOffset = oldEntry->logOffset;
+		}
+	}
+}
+
+int BLOCK_INDEX_setLogFile(BLOCK_INDEX *index, const char *logFname) {
+	if (index == NULL || logFname == NULL) return KT_INVALID_ARGUMENT;
+	return block_index_get_log_id(logFname, &index->log);
+}
+
+int BLOCK_INDEX_setLogOffsets(BLOCK_INDEX *index, SMART_FILE *log, const char *logFname) {
+	int res = KT_UNKNOWN_ERROR;
+	unsigned char buf[0x10000];
+	uint64_t lineNo = 1;
+	uint64_t position = 0;
+	size_t next = 0;
+	size_t count = 0;
+	int isCrPending = 0;
+
+	if (index == NULL || log == NULL || logFname == NULL) return KT_INVALID_ARGUMENT;
+
+	res = BLOCK_INDEX_setLogFile(index, logFname);
+	if (res != KT_OK) return res;
+
+	block_index_set_line_offset(index, &next, lineNo, 0);
+
+	while (next < index->count) {
+		size_t i = 0;
+		size_t end = 0;
+
+		res = SMART_FILE_read(log, buf, sizeof(buf), &count);
+		if (res != SMART_FILE_OK) return res;
+
+		/* Line ended with CR in the previous read, LF of the CR LF may follow. */
+		if (isCrPending) {
+			if (count > 0 && buf[0] == '\n') i = 1;
+			lineNo++;
+			block_index_set_line_offset(index, &next, lineNo, position + i);
+			isCrPending = 0;
+		}
+
+		if (count == 0) break;
+
+		/* Lines end with the same characters as for the log reader (see SMART_FILE_readLine). */
+		while (i < count && SMART_FILE_findLineEnd(buf + i, count - i, &end)) {
+			if (i + end == count && buf[count - 1] == '\r') {
+				isCrPending = 1;
+				break;
+			}
+
+			i += end;
+			lineNo++;
+			block_index_set_line_offset(index, &next, lineNo, position + i);
+		}
+
+		position += count;
+	}
+
+	/* Blocks without lines at the end of the log file (e.g. closed with a meta-record only). */
+	while (next < index->count && index->entries[next].lastLine < index->entries[next].firstLine) {
+		index->entries[next].logOffset = position;
+		next++;
+	}
+
+	return (next < index->count) ? KT_UNEXPECTED_EOF : KT_OK;
+}
+
+int BLOCK_INDEX_write(BLOCK_INDEX *index, const char *fname, uint64_t sigSize) {
+	int res = KT_UNKNOWN_ERROR;
+	SMART_FILE *out = NULL;
+	unsigned char header[BLOCK_INDEX_HEADER_SIZE];
+	unsigned char *buf = NULL;
+	SMART_FILE_IOVEC iov[2];
+	size_t i;
+
+	if (index == NULL || fname == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	buf = (unsigned char*)malloc(index->count * BLOCK_INDEX_ENTRY_SIZE + 1);
+	if (buf == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	memcpy(header, BLOCK_INDEX_MAGIC, BLOCK_INDEX_MAGIC_SIZE);
+	block_index_put_uint64(header + BLOCK_INDEX_MAGIC_SIZE, sigSize);
+	block_index_put_uint64(header + BLOCK_INDEX_MAGIC_SIZE + 1 * 8, index->log.size);
+	block_index_put_uint64(header + BLOCK_INDEX_MAGIC_SIZE + 2 * 8, index->log.device);
+	block_index_put_uint64(header + BLOCK_INDEX_MAGIC_SIZE + 3 * 8, index->log.inode);
+	block_index_put_uint64(header + BLOCK_INDEX_MAGIC_SIZE + 4 * 8, index->log.mtime);
+	block_index_put_uint64(header + BLOCK_INDEX_MAGIC_SIZE + 5 * 8, index->count);
+
+	for (i = 0; i < index->count; i++) {
+		block_index_entry_serialize(&index->entries[i], buf + i * BLOCK_INDEX_ENTRY_SIZE);
+	}
+
+	res = SMART_FILE_open(fname, "wbT", &out);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	iov[0].raw = header;
+	iov[0].raw_len = sizeof(header);
+	iov[1].raw = buf;
+	iov[1].raw_len = index->count * BLOCK_INDEX_ENTRY_SIZE;
+
+	res = SMART_FILE_writev(out, iov, 2, NULL);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	res = SMART_FILE_markConsistent(out);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	res = SMART_FILE_close(out);
+	out = NULL;
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	res = KT_OK;
+
+cleanup:
+
+	SMART_FILE_close(out);
+	free(buf);
+
+	return res;
+}
+
+int BLOCK_INDEX_read(const char *fname, const char *sigFname, const char *logFname, BLOCK_INDEX **index) {
+	int res = KT_UNKNOWN_ERROR;
+	SMART_FILE *in = NULL;
+	BLOCK_INDEX *tmp = NULL;
+	unsigned char header[BLOCK_INDEX_HEADER_SIZE];
+	unsigned char buf[BLOCK_INDEX_ENTRY_SIZE];
+	uint64_t sigSize = 0;
+	uint64_t count = 0;
+	uint64_t i;
+	struct stat st;
+	BLOCK_INDEX_LOG_ID logId;
+	int isLogChanged = 0;
+
+	if (fname == NULL || sigFname == NULL || index == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	if (stat(sigFname, &st) != 0) {
+		res = KT_IO_ERROR;
+		goto cleanup;
+	}
+
+	res = SMART_FILE_open(fname, "rb", &in);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	res = block_index_read_all(in, header, sizeof(header));
+	if (res != KT_OK) goto cleanup;
+
+	if (memcmp(header, BLOCK_INDEX_MAGIC, BLOCK_INDEX_MAGIC_SIZE) != 0) {
+		res = KT_INVALID_INPUT_FORMAT;
+		goto cleanup;
+	}
+
+	sigSize = block_index_get_uint64(header + BLOCK_INDEX_MAGIC_SIZE);
+	logId.size = block_index_get_uint64(header + BLOCK_INDEX_MAGIC_SIZE + 1 * 8);
+	logId.device = block_index_get_uint64(header + BLOCK_INDEX_MAGIC_SIZE + 2 * 8);
+	logId.inode = block_index_get_uint64(header + BLOCK_INDEX_MAGIC_SIZE + 3 * 8);
+	logId.mtime = block_index_get_uint64(header + BLOCK_INDEX_MAGIC_SIZE + 4 * 8);
+	count = block_index_get_uint64(header + BLOCK_INDEX_MAGIC_SIZE + 5 * 8);
+
+	/* Log signature file is changed after the index file was written. */
+	if (sigSize != (uint64_t)st.st_size) {
+		res = KT_INVALID_INPUT_FORMAT;
+		goto cleanup;
+	}
+
+	/* Log file is rewritten, rotated or appended after the offsets were found. */
+	if (logFname != NULL) {
+		BLOCK_INDEX_LOG_ID current;
+
+		isLogChanged = block_index_get_log_id(logFname, &current) != KT_OK ||
+			current.size != logId.size || current.device != logId.device ||
+			current.inode != logId.inode || current.mtime != logId.mtime;
+	}
+
+	res = BLOCK_INDEX_new(&tmp);
+	if (res != KT_OK) goto cleanup;
+
+	tmp->log = logId;
+
+	for (i = 0; i < count; i++) {
+		BLOCK_INDEX_ENTRY entry;
+
+		res = block_index_read_all(in, buf, sizeof(buf));
+		if (res != KT_OK) goto cleanup;
+
+		block_index_entry_parse(buf, &entry);
+		if (isLogChanged) entry.logOffset = BLOCK_INDEX_UNKNOWN_OFFSET;
+
+		if (entry.sigOffset >= sigSize) {
+			res = KT_INVALID_INPUT_FORMAT;
+			goto cleanup;
+		}
+
+		res = BLOCK_INDEX_add(tmp, &entry);
+		if (res != KT_OK) {
+			res = KT_INVALID_INPUT_FORMAT;
+			goto cleanup;
+		}
+	}
+
+	*index = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	SMART_FILE_close(in);
+	BLOCK_INDEX_free(tmp);
+
+	return res;
+}
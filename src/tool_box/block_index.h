@@ -0,0 +1,145 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+#ifndef BLOCK_INDEX_H
+#define	BLOCK_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "smart_file.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/* File extension of the index file that is added to the log signature file name. */
+#define BLOCK_INDEX_FILE_EXTENSION ".idx"
+
+/* Offset value of an entry that is not known. */
+#define BLOCK_INDEX_UNKNOWN_OFFSET UINT64_MAX
+
+typedef struct BLOCK_INDEX_st BLOCK_INDEX;
+
+typedef struct BLOCK_INDEX_ENTRY_st {
+	uint64_t blockNo;				/* Number of the block, starting from 1. */
+	uint64_t sigOffset;				/* Offset of the block header in the log signature file. */
+	uint64_t logOffset;				/* Offset of the first line of the block in the log file or BLOCK_INDEX_UNKNOWN_OFFSET. */
+	uint64_t firstLine;				/* Number of the first line in the block. */
+	uint64_t lastLine;				/* Number of the last line in the block. If the block has no lines, it is firstLine - 1. */
+	uint64_t recordCount;			/* Count of records in the block, meta-records included. */
+	uint64_t sigTime;				/* Signing time of the block or 0 if not known. */
+	int isSigned;					/* Set if the block has a signature, cleared if the block is not signed. */
+} BLOCK_INDEX_ENTRY;
+
+/**
+ * Creates an empty index that maps blocks of a log signature file to the positions
+ * in the log signature file and in the log file. The index is kept in a sidecar file
+ * (see #BLOCK_INDEX_write) so that a block can be found without reading the log
+ * signature file and the log file from the beginning.
+ * \param index			Output parameter for the index.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int BLOCK_INDEX_new(BLOCK_INDEX **index);
+void BLOCK_INDEX_free(BLOCK_INDEX *index);
+
+/**
+ * Appends the entry to the end of the index. Blocks must be added in the order
+ * they appear in the log signature file.
+ * \return KT_OK if successful, KT_INVALID_ARGUMENT if the block number does not follow
+ * the last block, error code otherwise.
+ */
+int BLOCK_INDEX_add(BLOCK_INDEX *index, const BLOCK_INDEX_ENTRY *entry);
+
+/**
+ * Returns the entry with index \c i (block number \c i + 1) or \c NULL if out of range.
+ */
+const BLOCK_INDEX_ENTRY *BLOCK_INDEX_get(BLOCK_INDEX *index, size_t i);
+size_t BLOCK_INDEX_getCount(BLOCK_INDEX *index);
+
+/**
+ * Finds the block that contains the given line.
+ * \param index			Index object.
+ * \param lineNo		Line number, starting from 1.
+ * \param i				Output parameter for the index of the entry.
+ * \return KT_OK if successful, KT_INDEX_OVF if none of the blocks contain the line,
+ * error code otherwise.
+ */
+int BLOCK_INDEX_findByLine(BLOCK_INDEX *index, uint64_t lineNo, size_t *i);
+
+/**
+ * Copies the log file offsets that are not known from \c old. An offset is copied only
+ * if the block in \c old has the same number and covers the same lines. The identity
+ * of the log file is copied together with the offsets. It is used when the log
+ * signature file is rewritten without reading the log file.
+ */
+void BLOCK_INDEX_inheritLogOffsets(BLOCK_INDEX *index, BLOCK_INDEX *old);
+
+/**
+ * Keeps the size, device, inode and modification time of the log file the log file
+ * offsets of the index belong to, so that the offsets are not used after the log
+ * file is changed (see #BLOCK_INDEX_read).
+ * \param index			Index object.
+ * \param logFname		Name of the log file.
+ * \return KT_OK if successful, KT_IO_ERROR if the file can not be accessed, error code otherwise.
+ */
+int BLOCK_INDEX_setLogFile(BLOCK_INDEX *index, const char *logFname);
+
+/**
+ * Finds the log file offsets of all blocks by counting the lines of the log file. Lines
+ * end with the same characters as for the log reader (see #SMART_FILE_findLineEnd).
+ * The file is read from the current position that must be the beginning of the file.
+ * The log file is kept in the index (see #BLOCK_INDEX_setLogFile).
+ * \param index			Index object.
+ * \param log			Log file.
+ * \param logFname		Name of the log file.
+ * \return KT_OK if successful, KT_UNEXPECTED_EOF if the log file has less lines than
+ * the index, error code otherwise.
+ */
+int BLOCK_INDEX_setLogOffsets(BLOCK_INDEX *index, SMART_FILE *log, const char *logFname);
+
+/**
+ * Writes the index file. The file is written to a temporary file first and renamed
+ * when complete.
+ * \param index			Index object.
+ * \param fname			Name of the index file.
+ * \param sigSize		Size of the log signature file the index belongs to.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int BLOCK_INDEX_write(BLOCK_INDEX *index, const char *fname, uint64_t sigSize);
+
+/**
+ * Reads the index file. As the log signature file can be changed without updating
+ * the index, the size of the log signature file is compared with the size stored
+ * in the index file. If the log file is changed (its size, device, inode or
+ * modification time differs from the one stored), the log file offsets are left
+ * unknown and must be found again (see #BLOCK_INDEX_setLogOffsets).
+ * \param fname			Name of the index file.
+ * \param sigFname		Name of the log signature file the index belongs to.
+ * \param logFname		Name of the log file or \c NULL if the log file offsets are not used.
+ * \param index			Output parameter for the index.
+ * \return KT_OK if successful, KT_INVALID_INPUT_FORMAT if the index file is corrupted
+ * or does not match the log signature file, error code otherwise.
+ */
+int BLOCK_INDEX_read(const char *fname, const char *sigFname, const char *logFname, BLOCK_INDEX **index);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* BLOCK_INDEX_H */
@@ -48,20 +48,24 @@ int check_log_line_embedded_time(PARAM_SET* set, MULTI_PRINTER *mp, ERR_TRCKR *e
 
 	if (logksi->taskId == TASK_VERIFY && PARAM_SET_isSetByName(set, "time-form")) {
 		char *format = NULL;
+		const char *logLine = NULL;
 		struct tm tmp_time;
 		time_t t = 0;
 
 		res = PARAM_SET_getStr(set, "time-form", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, &format);
 		ERR_CATCH_MSG(err, res, "Error: Unable to get time format string.");
 
-		ret = strptime(logksi->logLine, format, &tmp_time);
+		res = LOGKSI_getLine(logksi, &logLine);
+		ERR_CATCH_MSG(err, res, "Error: Unable to get log line.");
+
+		ret = strptime(logLine, format, &tmp_time);
 		if (ret == NULL) {
 			res = KT_INVALID_INPUT_FORMAT;
-			print_debug_mp(mp, MP_ID_BLOCK_ERRORS, DEBUG_EQUAL | DEBUG_LEVEL_3, "Block no. %3zu: Error: Unable to extract timestamp (%s) from log line %zu: %.*s.\n", logksi->blockNo, format, LOGKSI_getNofLines(logksi), (strlen(logksi->logLine) - 1), logksi->logLine);
+			print_debug_mp(mp, MP_ID_BLOCK_ERRORS, DEBUG_EQUAL | DEBUG_LEVEL_3, "Block no. %3zu: Error: Unable to extract timestamp (%s) from log line %zu: %.*s.\n", logksi->blockNo, format, LOGKSI_getNofLines(logksi), (strlen(logLine) - 1), logLine);
 			print_debug_mp(mp, MP_ID_BLOCK_ERRORS, DEBUG_SMALLER | DEBUG_LEVEL_3, "\n x Error: Unable to extract time stamp from log line %zu in block %zu:\n"
 																						  "   + Log line:    '%.*s'\n"
 																						  "   + Time format: '%s'\n"
-																						  ,  LOGKSI_getNofLines(logksi), logksi->blockNo, (strlen(logksi->logLine) - 1), logksi->logLine, format);
+																						  ,  LOGKSI_getNofLines(logksi), logksi->blockNo, (strlen(logLine) - 1), logLine, format);
 
 			ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to extract time stamp from the logline no. %zu.", logksi->blockNo, LOGKSI_getNofLines(logksi))
 		}
@@ -142,6 +146,49 @@ cleanup:
 	return res;
 }
 
+int get_log_line_time(PARAM_SET *set, const char *logLine, uint64_t *time) {
+	int res = KT_UNKNOWN_ERROR;
+	char *format = NULL;
+	struct tm tmp_time;
+	time_t t = 0;
+
+	if (set == NULL || logLine == NULL || time == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	res = PARAM_SET_getStr(set, "time-form", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, &format);
+	if (res != PST_OK) goto cleanup;
+
+	memset(&tmp_time, 0, sizeof(tmp_time));
+	if (strptime(logLine, format, &tmp_time) == NULL) {
+		res = KT_INVALID_INPUT_FORMAT;
+		goto cleanup;
+	}
+
+	if (PARAM_SET_isSetByName(set, "time-base")) {
+		int timeBase = 0;
+
+		res = PARAM_SET_getObj(set, "time-base", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, (void**)&timeBase);
+		if (res != PST_OK) goto cleanup;
+
+		tmp_time.tm_year = timeBase - 1900;
+	}
+
+	t = KSI_CalendarTimeToUnixTime(&tmp_time);
+	if (t == (time_t)-1) {
+		res = KT_INVALID_INPUT_FORMAT;
+		goto cleanup;
+	}
+
+	*time = (uint64_t)t;
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
+
 int check_log_record_embedded_time_against_ksi_signature_time(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, LOGKSI *logksi) {
 	int res = KT_UNKNOWN_ERROR;
 	int checkLogRecordTime = 0;
@@ -624,6 +671,57 @@ cleanup:
   return res;
 }
 
+/**
+ * Checks the highest record time of the blocks before the block logksi->blockNo (file.recTimeMax)
+ * against the lowest record time of the blocks from logksi->blockNo to lastBlockNo (block.recTimeMin),
+ * when the blocks are verified in ranges (see verify --jobs). This is the order of log lines
+ * checked by #check_log_line_embedded_time between the ranges.
+ */
+int check_record_time_check_between_blocks(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, LOGKSI *logksi, size_t lastBlockNo) {
+	int res = KT_UNKNOWN_ERROR;
+
+	if (set == NULL || mp == NULL || err == NULL || logksi == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	if (logksi->file.recTimeMax != 0 && logksi->block.recTimeMin != 0 && PARAM_SET_isSetByName(set, "time-diff")) {
+		int time_diff = 0;
+
+		if (PARAM_SET_isSetByName(set, "time-disordered")) {
+			res = PARAM_SET_getObj(set, "time-disordered", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, (void**)&time_diff);
+			ERR_CATCH_MSG(err, res, "Error: Unable to extract time base as integer.");
+		}
+
+		if (logksi->file.recTimeMax > logksi->block.recTimeMin + time_diff) {
+			char str_last_time[1024] = "<null>";
+			char str_current_time[1024] = "<null>";
+
+			res = KT_VERIFICATION_FAILURE;
+			LOGKSI_setErrorLevel(logksi, LOGKSI_VER_RES_FAIL);
+			print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_1, res);
+			LOGKSI_uint64_toDateString(logksi->file.recTimeMax, str_last_time, sizeof(str_last_time));
+			LOGKSI_uint64_toDateString(logksi->block.recTimeMin, str_current_time, sizeof(str_current_time));
+			logksi->file.nofTotalFailedBlocks++;
+
+			print_debug_mp(mp, MP_ID_BLOCK_ERRORS, DEBUG_EQUAL | DEBUG_LEVEL_3, "Block no. %3zu: Error: Most recent log line (%s) from previous blocks is more recent than least recent log line (%s) from blocks %zu - %zu.\n", logksi->blockNo, str_last_time, str_current_time, logksi->blockNo, lastBlockNo);
+
+			print_debug_mp(mp, MP_ID_BLOCK_ERRORS, DEBUG_SMALLER | DEBUG_LEVEL_3, "\n x Error: Most recent log line from previous blocks is more recent than least recent log line from blocks %zu - %zu:\n"
+																			  "   + Time for most recent log line:  %s\n"
+																			  "   + Time for least recent log line: %s\n"
+																			  , logksi->blockNo, lastBlockNo, str_last_time, str_current_time);
+			logksi->quietError = res;
+			ERR_TRCKR_ADD(err, res, "Error: Most recent log line before block %zu is more recent than least recent log line from blocks %zu - %zu!", logksi->blockNo, logksi->blockNo, lastBlockNo);
+			goto cleanup;
+		}
+	}
+
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
 
 
 
@@ -721,9 +819,14 @@ int logksi_datahash_compare(ERR_TRCKR *err, MULTI_PRINTER *mp, LOGKSI* logksi, i
 		minSize = strlen(helpRight) > minSize ? strlen(helpRight) : minSize;
 
 		if (isLogline) {
+			const char *logLine = NULL;
+
+			/* Log line may not be copied yet (see LOGKSI_getLine). */
+			if (LOGKSI_getLine(logksi, &logLine) != KT_OK) logLine = "\n";
+
 			print_debug_mp(mp, MP_ID_BLOCK_ERRORS, DEBUG_SMALLER | DEBUG_LEVEL_3, "\n x Error: Failed to verify logline no. %zu:\n"
 																				  "   + Logline:\n"
-																				  "     '%.*s'\n", LOGKSI_getNofLines(logksi), (strlen(logksi->logLine) - 1), logksi->logLine);
+																				  "     '%.*s'\n", LOGKSI_getNofLines(logksi), (strlen(logLine) - 1), logLine);
 			if (differentHashAlg) print_debug_mp(mp, MP_ID_BLOCK_ERRORS, DEBUG_SMALLER | DEBUG_LEVEL_3, "   + Hash algorithms differ!\n");
 			print_debug_mp(mp, MP_ID_BLOCK_ERRORS, DEBUG_SMALLER | DEBUG_LEVEL_3, "   + %s\n"
 																				  "     %s\n", helpLeft, LOGKSI_DataHash_toString(left, buf, sizeof(buf)));
@@ -731,7 +834,7 @@ int logksi_datahash_compare(ERR_TRCKR *err, MULTI_PRINTER *mp, LOGKSI* logksi, i
 																				  "     %s\n", helpRight, LOGKSI_DataHash_toString(right, buf, sizeof(buf)));
 
 
-			print_debug_mp(mp, MP_ID_BLOCK_ERRORS, DEBUG_EQUAL | DEBUG_LEVEL_3, "Block no. %3zu: Error: failed to verify logline no. %zu: %s", logksi->blockNo, LOGKSI_getNofLines(logksi), logksi->logLine);
+			print_debug_mp(mp, MP_ID_BLOCK_ERRORS, DEBUG_EQUAL | DEBUG_LEVEL_3, "Block no. %3zu: Error: failed to verify logline no. %zu: %s", logksi->blockNo, LOGKSI_getNofLines(logksi), logLine);
 		} else {
 			print_debug_mp(mp, MP_ID_BLOCK_ERRORS, DEBUG_SMALLER | DEBUG_LEVEL_3, "\n x Error: %s:\n", failureReason);
 			if (differentHashAlg) print_debug_mp(mp, MP_ID_BLOCK_ERRORS, DEBUG_SMALLER | DEBUG_LEVEL_3, "   + Hash algorithms differ!\n");
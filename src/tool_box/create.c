@@ -23,6 +23,11 @@
 #include <string.h>
 #include <time.h>
 #include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/wait.h>
 #include <ksi/ksi.h>
 #include <ksi/compatibility.h>
 #include "param_set/param_set.h"
@@ -45,20 +50,25 @@
 #include "rsyslog.h"
 #include "logksi.h"
 #include "io_files.h"
+#include "log_follow.h"
 
 static int generate_tasks_set(PARAM_SET *set, TASK_SET *task_set);
 static int set_defaults(PARAM_SET *set);
 static int check_pipe_errors(PARAM_SET *set, ERR_TRCKR *err);
 static int generate_filenames(PARAM_SET *set, ERR_TRCKR *err, IO_FILES *files);
 static int open_state(PARAM_SET *set, ERR_TRCKR *err, KSI_CTX *ksi, STATE_FILE **state);
-static int open_input_and_output_files(PARAM_SET *set, ERR_TRCKR *err, IO_FILES *files);
+static int open_follow(PARAM_SET *set, ERR_TRCKR *err, STATE_FILE *state, LOG_FOLLOW **follow);
+static int open_input_and_output_files(PARAM_SET *set, ERR_TRCKR *err, STATE_FILE *state, IO_FILES *files);
 static int rename_temporary_and_backup_files(ERR_TRCKR *err, IO_FILES *files);
 static void close_input_and_output_files(ERR_TRCKR *err, int res, IO_FILES *files);
 static int getLogFiles(PARAM_SET *set, ERR_TRCKR *err, int i, IO_FILES *files);
 static int check_io_naming_and_type_errors(PARAM_SET *set, ERR_TRCKR *err);
 static int check_if_output_files_will_not_be_overwritten_if_restricted(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err);
+static int move_rotated_log_signature(ERR_TRCKR *err, char *sig_dir, char *user_out_sig, const char *inLog, const char *outSig, const STATE_FILE_FOLLOW *pos);
+static void stop_following(int sig);
+static int create_log_files_in_parallel(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_CTX *ksi, SMART_FILE *ksi_log, STATE_FILE *state, int nofFiles, unsigned nofJobs, IO_FILES *files);
 
-#define PARAMS "{log-file-list}{log-file-list-delimiter}{sig-dir}{logfile}{input}{multiple_logs}{o}{input-hash}{output-hash}{force-overwrite}{blk-size}{keep-record-hashes}{seed}{seed-len}{keep-tree-hashes}{d}{log}{conf}{h|help}{log-from-stdin}{dump-conf}{state}{state-file-name}"
+#define PARAMS "{log-file-list}{log-file-list-delimiter}{sig-dir}{logfile}{input}{multiple_logs}{o}{input-hash}{output-hash}{force-overwrite}{blk-size}{blk-time}{keep-record-hashes}{seed}{seed-len}{keep-tree-hashes}{d}{log}{conf}{h|help}{log-from-stdin}{dump-conf}{state}{state-file-name}{state-fsync}{max-pending}{batch-size}{threads}{jobs}{write-index}{follow}"
 
 int create_run(int argc, char** argv, char **envp) {
 	int res;
@@ -75,7 +85,10 @@ int create_run(int argc, char** argv, char **envp) {
 	IO_FILES_init(&files);
 	LOGKSI logksi;
 	STATE_FILE *state = NULL;
+	LOG_FOLLOW *follow = NULL;
 	size_t i = 0;
+	unsigned nofJobs = 1;
+	int nofFiles = 0;
 	/**
 	 * Extract command line parameters.
 	 */
@@ -125,13 +138,37 @@ int create_run(int argc, char** argv, char **envp) {
 		if (PARAM_SET_isSetByName(set, "dump-conf")) goto cleanup;
 	}
 
-	res = check_if_output_files_will_not_be_overwritten_if_restricted(set, mp, err);
-	if (res != KT_OK) goto cleanup;
-
 	res = open_state(set, err, ksi, &state);
 	if (res != KT_OK) goto cleanup;
 
-	do {
+	if (PARAM_SET_isSetByName(set, "follow")) {
+		res = open_follow(set, err, state, &follow);
+		if (res != KT_OK) goto cleanup;
+
+		/* Following is ended gracefully, so that the last block is closed and signed. */
+		signal(SIGINT, stop_following);
+		signal(SIGTERM, stop_following);
+	}
+
+	/* When signing of a followed log file is continued, the log signature file is appended. */
+	if (STATE_FILE_getFollow(state) == NULL) {
+		res = check_if_output_files_will_not_be_overwritten_if_restricted(set, mp, err);
+		if (res != KT_OK) goto cleanup;
+	}
+
+	if (PARAM_SET_isSetByName(set, "jobs")) {
+		res = PARAM_SET_getObj(set, "jobs", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, (void*)&nofJobs);
+		ERR_CATCH_MSG(err, res, "Error: Unable to get the count of jobs.");
+
+		res = PARAM_SET_getValueCount(set, "input", NULL, PST_PRIORITY_NONE, &nofFiles);
+		ERR_CATCH_MSG(err, res, "Error: Unable to get the count of log files.");
+	}
+
+	/* Log files are created one after another, if there is nothing to do in parallel. */
+	if (nofJobs > 1 && nofFiles > 1) {
+		res = create_log_files_in_parallel(set, mp, err, ksi, logfile, state, nofFiles, nofJobs, &files);
+		if (res != KT_OK) goto cleanup;
+	} else do {
 		int isSigStream = 0;
 		int isLogStream = 0;
 
@@ -145,7 +182,7 @@ int create_run(int argc, char** argv, char **envp) {
 		res = generate_filenames(set, err, &files);
 		if (res != KT_OK) goto cleanup;
 
-		res = open_input_and_output_files(set, err, &files);
+		res = open_input_and_output_files(set, err, state, &files);
 		if (res != KT_OK) goto cleanup;
 
 		isSigStream = SMART_FILE_isStream(files.files.outSig);
@@ -161,10 +198,14 @@ int create_run(int argc, char** argv, char **envp) {
 			isSigStream ? "" : "'");
 
 		print_progressDesc(mp, MP_ID_BLOCK, 0, DEBUG_EQUAL | DEBUG_LEVEL_1, "Creating... ");
-		res = logsignature_create(set, mp, err, ksi, &logksi, &files, STATE_FILE_hashAlgo(state), state);
+		res = logsignature_create(set, mp, err, ksi, &logksi, &files, STATE_FILE_hashAlgo(state), state, follow, NULL);
 		print_progressResult(mp, MP_ID_BLOCK, DEBUG_EQUAL | DEBUG_LEVEL_1, res);
 		if (res != KT_OK) goto cleanup;
 
+		if (LOG_FOLLOW_isRotated(follow)) {
+			print_debug_mp(mp, MP_ID_BLOCK, DEBUG_LEVEL_1, "Log file '%s' was rotated, following ended.\n", files.internal.inLog);
+		}
+
 		MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
 		if (MULTI_PRINTER_hasDataByID(mp, MP_ID_LOGFILE_WARNINGS)) {
 			print_debug("\n");
@@ -227,6 +268,7 @@ cleanup:
 	PARAM_SET_free(set);
 	ERR_TRCKR_free(err);
 	STATE_FILE_close(state);
+	LOG_FOLLOW_free(follow);
 	KSI_CTX_free(ksi);
 
 	return LOGKSI_errToExitCode(res);
@@ -259,17 +301,25 @@ char *create_help_toString(char*buf, size_t len) {
 	PARAM_SET_setHelpText(set, "log-file-list", "<file>", "Same as -- but log file list is read from a file or from stdin (use '-' as file name to read log file list from stdin). This option can be useful when the list of log files is too long to represent it on the command line. By default file names are separated by whitespace characters (including new line). Empty lines are ignored. Quote (') and double quote (\") can be used to include strings containing delimiters or delimiters can be escaped with backslash (\\\\). To change the delimiter see --log-file-list-delimiter. It can not be combined with other log file inputs and log file output -o.");
 	PARAM_SET_setHelpText(set, "log-file-list-delimiter", "<str>", "To change how the file names are separated from each other in log file list (see --log-file-list) specify the delimiter. There are two magical strings 'new-line', where each line contains one log file name, and 'space' (default), where whitespace characters separates log file names. Otherwise the user can specify a single character from {:;,|}.");
 	PARAM_SET_setHelpText(set, "log-from-stdin", NULL, "Read log file from stdin (same as input log file is omitted). This option can not be used together with file inputs (<logfile>, -- and --log-file-list). If output file name is not specified, log signature is stored as stdin.logsig.");
+	PARAM_SET_setHelpText(set, "follow", NULL, "Keep reading the log file when its end is reached and sign the log lines as they are written (like 'tail -F'). Every block is signed when it is full (see --blk-size and --max-lvl) or too old (see --blk-time) and is written into the log signature file immediately. Following is ended and the last block is closed as at the end of the file when the log file is rotated (the file name refers to another file or the file is truncated) or when SIGINT or SIGTERM is received. With --state or --state-file-name the position of signing is kept in the state file after every block and a restarted 'logksi create --follow' continues after the last signed block, appending the log signature file. If the log file was rotated, the restarted 'logksi create --follow' renames the log signature file after the rotated log file, found from the same directory (e.g. 'log.1.logsig'), and signs the new log file from the beginning. If the rotated log file is not found (e.g. it is compressed or the log file was truncated) or -o is used, the log signature file must be moved aside manually. Only a single log file can be followed and it can not be combined with --max-pending, --batch-size, --threads, --jobs and --write-index.");
 	PARAM_SET_setHelpText(set, "seed", "<file>", "Specify random seed for masking. Random seed is a file containing enough bytes to provide a sequence of bytes, in the size of the output of hash algorithm used to build Merkle tree, for every block (see -H). Use '-' as file name to read the random from stdin. If not specified '/dev/urandom' is used as default (only if such file exists).");
 	PARAM_SET_setHelpText(set, "seed-len", "<int>", "Size of the random seed. If not set size of the seed is the size of the output of hash algorithm used to build Merkle tree (see -H).");
 	PARAM_SET_setHelpText(set, "blk-size", "<int>", "The maximum size of the block (how many log records are aggregated into single Merkle tree).");
+	PARAM_SET_setHelpText(set, "blk-time", "<int>", "The maximum time in seconds a block is kept open, counted from its first log record. When the time is reached, the block is closed with a meta-record (com.guardtime.blockCloseReason) and signed even if it is not full. The time is checked while waiting for the next log line, so it can only be used with --follow. Can be combined with --blk-size and --max-lvl.");
+	PARAM_SET_setHelpText(set, "max-pending", "<int>", "The maximum count of block signing requests that can be sent to the aggregator without waiting for the responses. Blocks are kept in memory until they are signed and are written into the log signature file in the original order. Default value is 1 (every block is signed before the next block is built).");
+	PARAM_SET_setHelpText(set, "batch-size", "<int>", "The maximum count of blocks whose root hashes are aggregated locally into a single signing request. The signature of every block is created from the signature of the local aggregation root. Can be combined with '--max-pending'. Default value is 1 (every block is signed with a separate request).");
+	PARAM_SET_setHelpText(set, "threads", "<int>", "The count of threads used to calculate the hashes of log lines. Log lines are read ahead and hashed in parallel, the log signature file is identical to the one created with a single thread. Default value is 1.");
+	PARAM_SET_setHelpText(set, "jobs", "<int>", "The maximum count of log files that are processed at once, when multiple log files are signed (see -- and --log-file-list). Every log file is processed in a separate process: its log lines are read ahead and hashed while the previous log file is still processed and the Merkle trees are built as soon as the last leaf of the previous log file is known. Signing of the blocks overlaps with processing of the next log files, thus combine it with --max-pending to sign the blocks of a log file without waiting. A log signature file is kept only if all the previous log signature files are created. The log signature files are identical to the ones created one after another. Default value is 1.");
+	PARAM_SET_setHelpText(set, "write-index", NULL, "Write a block index file next to the log signature file as '<out.logsig>.idx'. The index contains the positions of the blocks in the log signature file and in the log file and makes it possible to access a block without reading the files from the beginning. The index is always updated if it already exists. See 'logksi index' to create the index for an existing log signature file.");
 	PARAM_SET_setHelpText(set, "keep-record-hashes", NULL, "Include record hashes (hash value directly calculated from log line without any masking) into log signature file. Log signature without record hashes can still be verified but the diagnostics in case of failure is more difficult.");
 	PARAM_SET_setHelpText(set, "keep-tree-hashes", NULL, "Include intermediate Merkle tree (every tree node) hash values into log signature file. Log signature without tree hashes can still be verified but the diagnostics in case of failure is more difficult.");
 	PARAM_SET_setHelpText(set, "input-hash", "<hash>", "Specify hash imprint for inter-linking (the last leaf from the previous log signature). Hash can be specified on command line or from a file containing its string representation. Hash format: <alg>:<hash in hex>. Use '-' as file name to read the imprint from stdin. Call logksi -h to get the list of supported hash algorithms. See --output-hash to see how to extract the hash imprint from the previous log file. When used together with -- or --log-file-list, only the first block uses the value as input hash.");
 	PARAM_SET_setHelpText(set, "output-hash", "<file>", "Output the last leaf from the log signature into file. Use '-' as file name to redirect hash imprint to stdout. See --input-hash to use the output hash as input hash to next log signature. When used together with -- or --log-file-list, only the output hash of the last block is returned. Will always overwrite existing file.");
-	PARAM_SET_setHelpText(set, "state", NULL, "Creates a binary state file that keeps aggregation hash algorithm and last leaf from the Merkle tree being built. State file helps to continue signing the logs and keeps cryptographic linking between different calls to logksi. Functionality is similar to using --input-hash and --output-hash but it requires less scripting and also configures aggregation hash algorithm. It must be noted that state file requires more frequent disk access as every log line will update the state!\n\n"
+	PARAM_SET_setHelpText(set, "state", NULL, "Creates a binary state file that keeps aggregation hash algorithm and last leaf from the Merkle tree being built. State file helps to continue signing the logs and keeps cryptographic linking between different calls to logksi. Functionality is similar to using --input-hash and --output-hash but it requires less scripting and also configures aggregation hash algorithm. The state is kept in memory while the log files are signed and the state file is written only once at the end (with --follow after every signed block). The state file is replaced atomically, so it is never left partially written.\n\n"
 		"The state file name is generated by appending '.state' extension to the log files name. If --sig-dir is specified state file is stored there. In case of multiple input log files state file name must be specified explicitly (see --state-file-name). On success state file is always overwritten. In case of failure old state file is preserved.\n\n"
 		"If state file does not exist it is created and initialized (with --input-hash or zero hash). If state file already exists it is loaded and input hash and aggregation hash algorithm is used to initialize log signing process. Using option -H will override aggregation hash algorithm. With existing state file --input-hash can not be used.");
 	PARAM_SET_setHelpText(set, "state-file-name", "<file>", "Same as --state but state file is always stored at given location no matter what the log files name is, making it suitable for signing multiple log files in sequence (in one or multiple calls to logksi).");
+	PARAM_SET_setHelpText(set, "state-fsync", NULL, "Flush the state file to the storage device (fsync) every time it is written, so that the state survives a system crash or power failure. With --follow the log signature file is also flushed before the state file is updated.");
 	PARAM_SET_setHelpText(set, "sig-dir", "<dir>", "Specify the directory to store the log signatures into. Using this option signature file names are generated by appending '.logsig' extension to the log file; This option can not work with -o. If used together with implicit state file name (--state) state file is stored next to the signature.");
 	PARAM_SET_setHelpText(set, "o", "<out.logsig>", "Specify the name of the created log signature file; recommended file extension is '.logsig'. If not specified, the log signature file is saved as '<logfile>.logsig' in the same folder where the <logfile> is located. An attempt to overwrite an existing log signature file will result in an error (see --force-overwrite). Use '-' as file name to redirect the output as a binary stream to stdout. This option can only be used when a single log file is used as input (exept with --log-file-list).");
 	PARAM_SET_setHelpText(set, "force-overwrite", NULL, "Force overwriting of existing log signature file.");
@@ -288,7 +338,7 @@ char *create_help_toString(char*buf, size_t len) {
 		"logksi create -S URL [--aggr-user user --aggr-key key] --dump-conf\\>1\n\\>8"
 		"\\>\n\n\n");
 
-	ret = PARAM_SET_helpToString(set, "input,multiple_logs,log-file-list,log-file-list-delimiter,log-from-stdin,seed,seed-len,max-lvl,blk-size,keep-record-hashes,keep-tree-hashes,input-hash,output-hash,state,state-file-name,H,sig-dir,o,force-overwrite,S,aggr-user,aggr-key,aggr-hmac-alg,d,dump-conf,conf,apply-remote-conf,log", 1, 13, 80, buf + count, len - count);
+	ret = PARAM_SET_helpToString(set, "input,multiple_logs,log-file-list,log-file-list-delimiter,log-from-stdin,follow,seed,seed-len,max-lvl,blk-size,blk-time,max-pending,batch-size,threads,jobs,write-index,keep-record-hashes,keep-tree-hashes,input-hash,output-hash,state,state-file-name,state-fsync,H,sig-dir,o,force-overwrite,S,aggr-user,aggr-key,aggr-hmac-alg,d,dump-conf,conf,apply-remote-conf,log", 1, 13, 80, buf + count, len - count);
 
 cleanup:
 	if (res != PST_OK || ret == NULL) {
@@ -322,15 +372,15 @@ static int generate_tasks_set(PARAM_SET *set, TASK_SET *task_set) {
 
 	res |= PARAM_SET_addControl(set, "{conf}", isFormatOk_inputFile, isContentOk_inputFileRestrictPipe, convertRepair_path, NULL);
 	res |= PARAM_SET_addControl(set, "{o}{log}{output-hash}{state-file-name}", isFormatOk_path, NULL, convertRepair_path, NULL);
-	res |= PARAM_SET_addControl(set, "{d}{keep-record-hashes}{keep-tree-hashes}{log-from-stdin}{force-overwrite}{dump-conf}{state}", isFormatOk_flag, NULL, NULL, NULL);
+	res |= PARAM_SET_addControl(set, "{d}{keep-record-hashes}{keep-tree-hashes}{log-from-stdin}{force-overwrite}{dump-conf}{state}{state-fsync}{write-index}{follow}", isFormatOk_flag, NULL, NULL, NULL);
 	res |= PARAM_SET_addControl(set, "{logfile}{multiple_logs}", isFormatOk_inputFile, isContentOk_inputFileNoDir, convertRepair_path, NULL);
 	res |= PARAM_SET_addControl(set, "{sig-dir}", isFormatOk_inputFile, isContentOk_dir, convertRepair_path, NULL);
 	res |= PARAM_SET_addControl(set, "{input-hash}", isFormatOk_inputHash, isContentOk_inputHash, convertRepair_path, extract_inputHashFromImprintOrImprintInFile);
 	res |= PARAM_SET_addControl(set, "{seed}{log-file-list}", isFormatOk_inputFile, isContentOk_inputFileWithPipe, convertRepair_path, NULL);
-	res |= PARAM_SET_addControl(set, "{seed-len}{blk-size}", isFormatOk_int, isContentOk_uint_not_zero, NULL, extract_uint);
+	res |= PARAM_SET_addControl(set, "{seed-len}{blk-size}{blk-time}{max-pending}{batch-size}{threads}{jobs}", isFormatOk_int, isContentOk_uint_not_zero, NULL, extract_uint);
 	res |= PARAM_SET_addControl(set, "{log-file-list-delimiter}", isFormatOk_fileNameDelimiter, NULL, NULL, NULL);
 
-	res |= PARAM_SET_setParseOptions(set, "seed-len,blk-size,max-lvl,log-file-list-delimiter",
+	res |= PARAM_SET_setParseOptions(set, "seed-len,blk-size,blk-time,max-lvl,max-pending,batch-size,threads,jobs,log-file-list-delimiter",
 		PST_PRSCMD_HAS_VALUE | PST_PRSCMD_BREAK_WITH_EXISTING_PARAMETER_MATCH);
 
 	res |= PARAM_SET_setParseOptions(set, "seed", PST_PRSCMD_HAS_VALUE);
@@ -348,7 +398,7 @@ static int generate_tasks_set(PARAM_SET *set, TASK_SET *task_set) {
 		PST_PRSCMD_CLOSE_PARSING | PST_PRSCMD_COLLECT_WHEN_PARSING_IS_CLOSED
 		);
 	res |= PARAM_SET_setParseOptions(set, "d,h", PST_PRSCMD_HAS_NO_VALUE | PST_PRSCMD_NO_TYPOS);
-	res |= PARAM_SET_setParseOptions(set, "log-from-stdin,keep-record-hashes,keep-tree-hashes,force-overwrite,dump-conf,state", PST_PRSCMD_HAS_NO_VALUE);
+	res |= PARAM_SET_setParseOptions(set, "log-from-stdin,keep-record-hashes,keep-tree-hashes,force-overwrite,dump-conf,state,state-fsync,write-index,follow", PST_PRSCMD_HAS_NO_VALUE);
 
 	res |= TASK_SET_add(task_set,
 	/* ID:           */ task_id++,
@@ -584,6 +634,9 @@ static int open_state(PARAM_SET *set, ERR_TRCKR *err, KSI_CTX *ksi, STATE_FILE *
 	res = STATE_FILE_open(0, stateFileName, ksi, &tmp);
 	ERR_CATCH_MSG(err, res, "Error: Unable to open state file '%s'!", stateFileName);
 
+	res = STATE_FILE_setSync(tmp, PARAM_SET_isSetByName(set, "state-fsync"));
+	ERR_CATCH_MSG(err, res, "Error: Unable to configure state file '%s'!", stateFileName);
+
 	/* If there is explicitly specified aggregation hash algorithm override
 	   even the value read from state file. Note that original input hash is
 	   not affected in any way. */
@@ -610,6 +663,12 @@ static int open_state(PARAM_SET *set, ERR_TRCKR *err, KSI_CTX *ksi, STATE_FILE *
 		ERR_CATCH_MSG(err, res, "Error: Unable to update state file '%s'!", stateFileName);
 	}
 
+	/* Position of signing a followed log file is not valid after the log files are signed in another way. */
+	if (!PARAM_SET_isSetByName(set, "follow") && STATE_FILE_getFollow(tmp) != NULL) {
+		res = STATE_FILE_setFollow(tmp, NULL);
+		ERR_CATCH_MSG(err, res, "Error: Unable to update state file '%s'!", stateFileName);
+	}
+
 	*state = tmp;
 	tmp = NULL;
 	res = KT_OK;
@@ -623,6 +682,185 @@ cleanup:
 	return res;
 }
 
+static int open_follow(PARAM_SET *set, ERR_TRCKR *err, STATE_FILE *state, LOG_FOLLOW **follow) {
+	int res = KT_UNKNOWN_ERROR;
+	LOG_FOLLOW *tmp = NULL;
+	const STATE_FILE_FOLLOW *pos = NULL;
+	char *sig_dir = NULL;
+	char *user_out_sig = NULL;
+	char *inLog = NULL;
+	char *outSig = NULL;
+	uint64_t device = 0;
+	uint64_t inode = 0;
+	uint64_t logSize = 0;
+	uint64_t sigSize = 0;
+
+	if (set == NULL || err == NULL || state == NULL || follow == NULL) return KT_INVALID_ARGUMENT;
+
+	res = PARAM_SET_getStr(set, "input", NULL, PST_PRIORITY_NONE, 0, &inLog);
+	if (res != KT_OK) goto cleanup;
+	res = PARAM_SET_getStr(set, "sig-dir", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, &sig_dir);
+	if (res != KT_OK && res != PST_PARAMETER_EMPTY) goto cleanup;
+	res = PARAM_SET_getStr(set, "o", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, &user_out_sig);
+	if (res != KT_OK && res != PST_PARAMETER_EMPTY) goto cleanup;
+
+	res = LOG_FOLLOW_new(inLog, &tmp);
+	ERR_CATCH_MSG(err, res, "Error: Unable to follow log file '%s'.", inLog);
+
+	/**
+	 * If the log file is rotated or truncated since the last run, it is signed from the
+	 * beginning. The finished log signature file of the rotated log file is moved aside
+	 * first, so that it is not overwritten.
+	 */
+	pos = STATE_FILE_getFollow(state);
+	if (pos != NULL) {
+		res = LOG_FOLLOW_getFileId(inLog, &device, &inode, &logSize);
+		ERR_CATCH_MSG(err, res, "Error: Unable to follow log file '%s'.", inLog);
+
+		res = get_output_signature_name(sig_dir, user_out_sig, inLog, err, &outSig);
+		if (res != KT_OK) goto cleanup;
+
+		if (pos->logDevice != LOG_FOLLOW_getDevice(tmp) || pos->logInode != LOG_FOLLOW_getInode(tmp) || pos->logOffset > logSize) {
+			if (SMART_FILE_doFileExist(outSig)) {
+				res = move_rotated_log_signature(err, sig_dir, user_out_sig, inLog, outSig, pos);
+				if (res != KT_OK) goto cleanup;
+			}
+
+			res = STATE_FILE_setFollow(state, NULL);
+			ERR_CATCH_MSG(err, res, "Error: Unable to update state file.");
+		} else {
+			if (LOG_FOLLOW_getFileId(outSig, &device, &inode, &sigSize) != KT_OK || sigSize < pos->sigSize) {
+				res = KT_IO_ERROR;
+				ERR_CATCH_MSG(err, res, "Error: Unable to continue signing log file '%s' as log signature file '%s' is missing or shorter than recorded in the state file.", inLog, outSig);
+			}
+		}
+	}
+
+	*follow = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	LOG_FOLLOW_free(tmp);
+	KSI_free(outSig);
+
+	return res;
+}
+
+/**
+ * Searches the directory of the log file for the file with the given device and inode
+ * numbers, that is the log file renamed by log rotation (e.g. 'log.1').
+ */
+static int find_rotated_log_file(const char *inLog, uint64_t device, uint64_t inode, char **rotated) {
+	int res = KT_UNKNOWN_ERROR;
+	DIR *dir = NULL;
+	struct dirent *entry = NULL;
+	const char *slash = NULL;
+	size_t dir_len = 0;
+	char dir_name[2048];
+	char path[2048];
+	uint64_t entryDevice = 0;
+	uint64_t entryInode = 0;
+	char *tmp = NULL;
+
+	if (inLog == NULL || rotated == NULL) return KT_INVALID_ARGUMENT;
+
+	slash = strrchr(inLog, '/');
+	dir_len = (slash == NULL) ? 0 : (size_t)(slash - inLog) + 1;
+	if (dir_len >= sizeof(dir_name)) return KT_INVALID_ARGUMENT;
+
+	if (dir_len == 0) {
+		KSI_strncpy(dir_name, ".", sizeof(dir_name));
+	} else {
+		memcpy(dir_name, inLog, dir_len);
+		dir_name[dir_len] = '\0';
+	}
+
+	dir = opendir(dir_name);
+	if (dir == NULL) {
+		res = KT_IO_ERROR;
+		goto cleanup;
+	}
+
+	while ((entry = readdir(dir)) != NULL) {
+		if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+
+		KSI_snprintf(path, sizeof(path), "%.*s%s", (int)dir_len, inLog, entry->d_name);
+		if (LOG_FOLLOW_getFileId(path, &entryDevice, &entryInode, NULL) != KT_OK) continue;
+
+		if (entryDevice == device && entryInode == inode) {
+			tmp = (char*)malloc(strlen(path) + 1);
+			if (tmp == NULL) {
+				res = KT_OUT_OF_MEMORY;
+				goto cleanup;
+			}
+			strcpy(tmp, path);
+			break;
+		}
+	}
+
+	*rotated = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	if (dir != NULL) closedir(dir);
+	free(tmp);
+
+	return res;
+}
+
+/**
+ * Renames the log signature file of a log file that was rotated after the signing of
+ * it ended, so that it belongs to the rotated log file (e.g. 'log.1.logsig'). If the
+ * rotated log file can not be found in the same directory (e.g. it is compressed or the
+ * log file was truncated in place) or the log signature file is given with -o, the log
+ * signature file must be moved aside manually.
+ */
+static int move_rotated_log_signature(ERR_TRCKR *err, char *sig_dir, char *user_out_sig, const char *inLog, const char *outSig, const STATE_FILE_FOLLOW *pos) {
+	int res = KT_UNKNOWN_ERROR;
+	char *rotatedLog = NULL;
+	char *rotatedSig = NULL;
+
+	if (err == NULL || inLog == NULL || outSig == NULL || pos == NULL) return KT_INVALID_ARGUMENT;
+
+	if (user_out_sig == NULL) {
+		res = find_rotated_log_file(inLog, pos->logDevice, pos->logInode, &rotatedLog);
+		ERR_CATCH_MSG(err, res, "Error: Unable to search for the rotated log file of '%s'.", inLog);
+	}
+
+	if (rotatedLog == NULL) {
+		res = KT_IO_ERROR;
+		ERR_CATCH_MSG(err, res, "Error: Log file '%s' was rotated, but the rotated log file is not found. Move the log signature file '%s' of the rotated log file aside to continue.", inLog, outSig);
+	}
+
+	res = get_output_signature_name(sig_dir, NULL, rotatedLog, err, &rotatedSig);
+	if (res != KT_OK) goto cleanup;
+
+	if (SMART_FILE_doFileExist(rotatedSig)) {
+		res = KT_IO_ERROR;
+		ERR_CATCH_MSG(err, res, "Error: Log file '%s' was rotated, but the log signature file '%s' of the rotated log file already exists. Move the log signature file '%s' aside to continue.", inLog, rotatedSig, outSig);
+	}
+
+	res = SMART_FILE_rename(outSig, rotatedSig);
+	ERR_CATCH_MSG(err, res, "Error: Unable to rename log signature file '%s' to '%s'.", outSig, rotatedSig);
+
+	res = KT_OK;
+
+cleanup:
+
+	free(rotatedLog);
+	KSI_free(rotatedSig);
+
+	return res;
+}
+
+static void stop_following(int sig) {
+	LOG_FOLLOW_stop();
+}
+
 static int generate_filenames(PARAM_SET *set, ERR_TRCKR *err, IO_FILES *files) {
 	int res = KT_UNKNOWN_ERROR;
 	IO_FILES tmp;
@@ -680,9 +918,10 @@ cleanup:
 	return res;
 }
 
-static int open_input_and_output_files(PARAM_SET *set, ERR_TRCKR *err, IO_FILES *files) {
+static int open_input_and_output_files(PARAM_SET *set, ERR_TRCKR *err, STATE_FILE *state, IO_FILES *files) {
 	int res;
 	IO_FILES tmp;
+	int isFollow = 0;
 
 	memset(&tmp.files, 0, sizeof(tmp.files));
 
@@ -696,6 +935,9 @@ static int open_input_and_output_files(PARAM_SET *set, ERR_TRCKR *err, IO_FILES
 		ERR_CATCH_MSG(err, res, "Unable to open input random file '%s'.", files->internal.inRandom)
 	}
 
+	isFollow = PARAM_SET_isSetByName(set, "follow");
+
+	/* Log file may be written or truncated while it is signed, thus it is not memory mapped. */
 	if (files->internal.inLog) {
 		res = SMART_FILE_open(files->internal.inLog, files->user.bStdinLog ? "rbs" : "rb", &tmp.files.inLog);
 		ERR_CATCH_MSG(err, res, "Unable to open input log file '%s'.", files->internal.inLog)
@@ -704,8 +946,17 @@ static int open_input_and_output_files(PARAM_SET *set, ERR_TRCKR *err, IO_FILES
 		ERR_CATCH_MSG(err, res, "Unable to open input log stream.")
 	}
 
-	res = SMART_FILE_open(files->internal.outSig, "wbTs", &tmp.files.outSig);
-	ERR_CATCH_MSG(err, res, "Error: Could not create temporary output log signature file.");
+	/* Blocks of a followed log file are written directly into the log signature file, so that they are available immediately. */
+	if (isFollow && STATE_FILE_getFollow(state) != NULL) {
+		res = SMART_FILE_open(files->internal.outSig, "r+b", &tmp.files.outSig);
+		ERR_CATCH_MSG(err, res, "Error: Could not open output log signature file %s.", files->internal.outSig);
+	} else if (isFollow) {
+		res = SMART_FILE_open(files->internal.outSig, "wb", &tmp.files.outSig);
+		ERR_CATCH_MSG(err, res, "Error: Could not create output log signature file %s.", files->internal.outSig);
+	} else {
+		res = SMART_FILE_open(files->internal.outSig, "wbTs", &tmp.files.outSig);
+		ERR_CATCH_MSG(err, res, "Error: Could not create temporary output log signature file.");
+	}
 
 	files->files = tmp.files;
 	memset(&tmp.files, 0, sizeof(tmp.files));
@@ -812,9 +1063,392 @@ static int check_io_naming_and_type_errors(PARAM_SET *set, ERR_TRCKR *err) {
 		if (res != KT_OK) goto cleanup;
 	}
 
+	/* Log files created in parallel can not share the random stream. */
+	if (PARAM_SET_isSetByName(set, "jobs")) {
+		char *seed = NULL;
+
+		if (PARAM_SET_getStr(set, "seed", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, &seed) == PST_OK && strcmp(seed, "-") == 0) {
+			ERR_TRCKR_ADD(err, res = KT_INVALID_CMD_PARAM, "Error: It is not possible to read random seed from stdin with --jobs!");
+			goto cleanup;
+		}
+	}
+
+	/* Without --follow the time limit could only be checked when the next log line is read. */
+	if (PARAM_SET_isSetByName(set, "blk-time") && !PARAM_SET_isSetByName(set, "follow")) {
+		ERR_TRCKR_ADD(err, res = KT_INVALID_CMD_PARAM, "Error: It is not possible to use --blk-time without --follow!");
+		goto cleanup;
+	}
+
+	if (PARAM_SET_isSetByName(set, "follow")) {
+		char *outSig = NULL;
+
+		if (in_count_all != 1 || isLogFileList || isLogFromStdin) {
+			ERR_TRCKR_ADD(err, res = KT_INVALID_CMD_PARAM, "Error: Only a single log file (<logfile>) can be followed with --follow!");
+			goto cleanup;
+		}
+
+		if (PARAM_SET_isOneOfSetByName(set, "max-pending,batch-size,threads,jobs,write-index")) {
+			ERR_TRCKR_ADD(err, res = KT_INVALID_CMD_PARAM, "Error: It is not possible to use --follow together with --max-pending, --batch-size, --threads, --jobs and --write-index!");
+			goto cleanup;
+		}
+
+		if (isExplicitOutput && PARAM_SET_getStr(set, "o", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, &outSig) == PST_OK && strcmp(outSig, "-") == 0) {
+			ERR_TRCKR_ADD(err, res = KT_INVALID_CMD_PARAM, "Error: Log signature of a followed log file can not be written to stdout!");
+			goto cleanup;
+		}
+	}
+
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
+
+/**
+ * Log file processed in a child process (see #create_log_files_in_parallel). Output of the
+ * child is kept in temporary files until all the previous log files are finished.
+ */
+typedef struct CREATE_JOB_st {
+	pid_t pid;
+	FILE *out;			/* Standard output of the child. */
+	FILE *errOut;		/* Standard error of the child. */
+	FILE *result;		/* Result of the child (CREATE_JOB_RESULT) followed by the errors. */
+} CREATE_JOB;
+
+typedef struct CREATE_JOB_RESULT_st {
+	int res;
+	unsigned char lastLeaf[KSI_MAX_IMPRINT_LEN];
+	size_t lastLeaf_len;
+	char logFile[4096];
+	char sigFile[4096];
+} CREATE_JOB_RESULT;
+
+static void create_job_close(CREATE_JOB *job) {
+	if (job == NULL) return;
+
+	/* Child is not killed, as it removes its temporary files itself when the previous job has failed. */
+	if (job->pid > 0) waitpid(job->pid, NULL, 0);
+
+	if (job->out != NULL) fclose(job->out);
+	if (job->errOut != NULL) fclose(job->errOut);
+	if (job->result != NULL) fclose(job->result);
+
+	job->pid = -1;
+	job->out = NULL;
+	job->errOut = NULL;
+	job->result = NULL;
+}
+
+/* A single byte is written into the link after the last leaf, when the log signature file is kept. */
+static int create_job_signal_done(int fd) {
+	char done = 1;
+	ssize_t ret;
+
+	do {
+		ret = write(fd, &done, 1);
+	} while (ret < 0 && errno == EINTR);
+
+	return (ret == 1) ? KT_OK : KT_IO_ERROR;
+}
+
+static int create_job_wait_previous(int fd) {
+	char done = 0;
+	ssize_t ret;
+
+	do {
+		ret = read(fd, &done, 1);
+	} while (ret < 0 && errno == EINTR);
+
+	return (ret == 1 && done == 1) ? KT_OK : KT_UNEXPECTED_EOF;
+}
+
+/**
+ * Creates the log signature file in the child process. The input hash is taken from the
+ * previous job and the last leaf is passed to the next job through the link (see
+ * #logsignature_create). The first job takes the input hash from the state.
+ */
+static int create_job_run(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_CTX *ksi, STATE_FILE *state, int i, LOGSIG_LINK *sigLink, CREATE_JOB *job) {
+	int res = KT_UNKNOWN_ERROR;
+	int isCreated = 0;
+	IO_FILES files;
+	LOGKSI logksi;
+	CREATE_JOB_RESULT result;
+	const unsigned char *imprint = NULL;
+	size_t imprint_len = 0;
+
+	IO_FILES_init(&files);
+	LOGKSI_initialize(&logksi);
+	memset(&result, 0, sizeof(result));
+
+	/* Errors are passed to the parent, that has its own errors already. */
+	ERR_TRCKR_reset(err);
+
+	/* If the next job is gone, writing into the link fails instead of killing the job. */
+	signal(SIGPIPE, SIG_IGN);
+
+	if (dup2(fileno(job->out), STDOUT_FILENO) < 0 || dup2(fileno(job->errOut), STDERR_FILENO) < 0) {
+		res = KT_IO_ERROR;
+		ERR_TRCKR_ADD(err, res, "Error: Unable to redirect the output of log file no. %i.", i + 1);
+		goto cleanup;
+	}
+
+	res = getLogFiles(set, err, i, &files);
+	ERR_CATCH_MSG(err, res, "Error: Unable to get file names for log and log signature file.");
+
+	res = generate_filenames(set, err, &files);
+	if (res != KT_OK) goto cleanup;
+
+	res = open_input_and_output_files(set, err, state, &files);
+	if (res != KT_OK) goto cleanup;
+
+	print_debug_mp(mp, MP_ID_BLOCK, DEBUG_LEVEL_1, "%sLog file           '%s'.\n", (i == 0 ? "" : "\n"), files.internal.inLog);
+	print_debug_mp(mp, MP_ID_BLOCK, DEBUG_LEVEL_1, "Log signature file '%s'.\n\n", files.internal.outSig);
+
+	print_progressDesc(mp, MP_ID_BLOCK, 0, DEBUG_EQUAL | DEBUG_LEVEL_1, "Creating... ");
+	res = logsignature_create(set, mp, err, ksi, &logksi, &files, STATE_FILE_hashAlgo(state), state, NULL, sigLink);
+	print_progressResult(mp, MP_ID_BLOCK, DEBUG_EQUAL | DEBUG_LEVEL_1, res);
+	if (res != KT_OK) goto cleanup;
+	isCreated = 1;
+
+	/* Log signature file is linked to the previous one, that must be kept as well. */
+	if (sigLink->in >= 0) {
+		res = create_job_wait_previous(sigLink->in);
+		ERR_CATCH_MSG(err, res, "Error: Log signature file %s is not kept as the previous log signature file was not created.", files.internal.outSig);
+	}
+
+	res = KSI_DataHash_getImprint(STATE_FILE_lastLeaf(state), &imprint, &imprint_len);
+	ERR_CATCH_MSG(err, res, "Error: Unable to get the imprint of the last leaf.");
+
+	memcpy(result.lastLeaf, imprint, imprint_len);
+	result.lastLeaf_len = imprint_len;
+
+	IO_FILES_StorePreviousFileNames(&files);
+	PST_strncpy(result.logFile, files.previousLogFile, sizeof(result.logFile));
+	PST_strncpy(result.sigFile, files.previousSigFileOut, sizeof(result.sigFile));
+
+	/* Temporary log signature file replaces the output file. */
+	close_input_and_output_files(err, KT_OK, &files);
+
+	res = create_job_signal_done(sigLink->out);
+	ERR_CATCH_MSG(err, res, "Error: Unable to pass the result to the next log signature file.");
+
+	res = KT_OK;
+
+cleanup:
+
+	if (isCreated && res != KT_OK && files.files.outSig != NULL) {
+		SMART_FILE_markInconsistent(files.files.outSig);
+	}
+
+	MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
+	if (MULTI_PRINTER_hasDataByID(mp, MP_ID_LOGFILE_WARNINGS)) {
+		print_debug("\n");
+		MULTI_PRINTER_printByID(mp, MP_ID_LOGFILE_WARNINGS);
+	}
+
+	LOGKSI_KSI_ERRTrace_save(ksi);
+	if (res != KT_OK) LOGKSI_KSI_ERRTrace_LOG(ksi);
+
+	close_input_and_output_files(err, res, &files);
+
+	result.res = res;
+	if (fwrite(&result, sizeof(result), 1, job->result) != 1 || ERR_TRCKR_writeToFile(err, job->result) != 0 || fflush(job->result) != 0) {
+		res = KT_IO_ERROR;
+	}
+
+	fflush(stdout);
+	fflush(stderr);
+
+	return res;
+}
+
+/**
+ * Starts the job in a child process. The read end of the link from the previous job is
+ * given to the child and is replaced with the read end of the link to the next job.
+ */
+static int create_job_start(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_CTX *ksi, SMART_FILE *ksi_log, STATE_FILE *state, int i, int *nextLink, CREATE_JOB *job) {
+	int res = KT_UNKNOWN_ERROR;
+	int fd[2] = {-1, -1};
+	int exitCode;
+
+	job->out = tmpfile();
+	job->errOut = tmpfile();
+	job->result = tmpfile();
+	if (job->out == NULL || job->errOut == NULL || job->result == NULL) {
+		res = KT_IO_ERROR;
+		ERR_CATCH_MSG(err, res, "Error: Unable to create temporary files for log file no. %i.", i + 1);
+	}
+
+	if (pipe(fd) != 0) {
+		res = KT_IO_ERROR;
+		ERR_CATCH_MSG(err, res, "Error: Unable to link log file no. %i with the next log file: %s.", i + 1, strerror(errno));
+	}
+
+	/* Buffered output must not be inherited by the child, as it would be written twice. */
+	fflush(stdout);
+	fflush(stderr);
+	if (ksi_log != NULL) SMART_FILE_flush(ksi_log);
+
+	job->pid = fork();
+	if (job->pid < 0) {
+		res = KT_UNKNOWN_ERROR;
+		ERR_CATCH_MSG(err, res, "Error: Unable to start the creation of log file no. %i: %s.", i + 1, strerror(errno));
+	} else if (job->pid == 0) {
+		LOGSIG_LINK jobLink;
+
+		close(fd[0]);
+		jobLink.in = *nextLink;
+		jobLink.out = fd[1];
+
+		exitCode = LOGKSI_errToExitCode(create_job_run(set, mp, err, ksi, state, i, &jobLink, job));
+
+		/* Objects inherited from the parent are not freed by _exit, but the log file is closed. */
+		SMART_FILE_close(ksi_log);
+		fflush(stdout);
+		fflush(stderr);
+		_exit(exitCode);
+	}
+
+	if (*nextLink >= 0) close(*nextLink);
+	*nextLink = fd[0];
+	fd[0] = -1;
+
+	res = KT_OK;
+
+cleanup:
+
+	if (fd[0] >= 0) close(fd[0]);
+	if (fd[1] >= 0) close(fd[1]);
+
+	return res;
+}
+
+static int copy_job_output(FILE *in, FILE *out) {
+	char buf[4096];
+	size_t count;
+
+	rewind(in);
+	while ((count = fread(buf, 1, sizeof(buf), in)) > 0) {
+		if (fwrite(buf, 1, count, out) != count) return KT_IO_ERROR;
+	}
+
+	return ferror(in) ? KT_IO_ERROR : KT_OK;
+}
+
+/**
+ * Waits for the child, prints its output and reads its result. Errors of the child are added
+ * to the error tracker.
+ */
+static int create_job_finish(ERR_TRCKR *err, int i, CREATE_JOB *job, CREATE_JOB_RESULT *result) {
+	int res = KT_UNKNOWN_ERROR;
+
+	if (waitpid(job->pid, NULL, 0) < 0) {
+		res = KT_UNKNOWN_ERROR;
+		ERR_CATCH_MSG(err, res, "Error: Unable to wait for the creation of log file no. %i: %s.", i + 1, strerror(errno));
+	}
+	job->pid = -1;
+
+	res = copy_job_output(job->out, stdout);
+	if (res == KT_OK) res = copy_job_output(job->errOut, stderr);
+	ERR_CATCH_MSG(err, res, "Error: Unable to print the output of the creation of log file no. %i.", i + 1);
+
+	rewind(job->result);
+	if (fread(result, sizeof(CREATE_JOB_RESULT), 1, job->result) != 1 || ERR_TRCKR_addFromFile(err, job->result) != 0) {
+		res = KT_UNKNOWN_ERROR;
+		ERR_CATCH_MSG(err, res, "Error: Creation of log file no. %i was terminated unexpectedly.", i + 1);
+	}
+
+	res = KT_OK;
+
+cleanup:
+
+	create_job_close(job);
+
+	return res;
+}
+
+/**
+ * Creates log signature files of multiple log files in child processes, up to nofJobs at
+ * once. Every job passes the last leaf to the next job as soon as its last block is closed,
+ * so that the Merkle trees are built one after another, while the log lines of the next log
+ * files are read ahead and hashed and the blocks of the previous log files are signed. The
+ * output of the children is printed in the order of the log files and nothing is kept after
+ * the first failure, as it is without the jobs. The state is updated with the last leaf of
+ * the last log file and the names of the last log and log signature file are returned.
+ */
+static int create_log_files_in_parallel(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_CTX *ksi, SMART_FILE *ksi_log, STATE_FILE *state, int nofFiles, unsigned nofJobs, IO_FILES *files) {
+	int res = KT_UNKNOWN_ERROR;
+	CREATE_JOB *jobs = NULL;
+	CREATE_JOB_RESULT *result = NULL;
+	KSI_DataHash *lastLeaf = NULL;
+	int nextLink = -1;
+	int started = 0;
+	int i;
+	unsigned j;
+
+	if (set == NULL || mp == NULL || err == NULL || ksi == NULL || state == NULL || nofJobs == 0 || files == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	jobs = (CREATE_JOB*)malloc(nofJobs * sizeof(CREATE_JOB));
+	result = (CREATE_JOB_RESULT*)malloc(sizeof(CREATE_JOB_RESULT));
+	if (jobs == NULL || result == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	for (j = 0; j < nofJobs; j++) {
+		jobs[j].pid = -1;
+		jobs[j].out = NULL;
+		jobs[j].errOut = NULL;
+		jobs[j].result = NULL;
+	}
+
+	/* Output collected so far is printed before it is copied into the children. */
+	MULTI_PRINTER_print(mp);
+
+	for (i = 0; i < nofFiles; i++) {
+		/* Keep the next nofJobs log files processed, including the one that is waited for. */
+		while (started < nofFiles && started < i + (int)nofJobs) {
+			res = create_job_start(set, mp, err, ksi, ksi_log, state, started, &nextLink, &jobs[started % nofJobs]);
+			if (res != KT_OK) goto cleanup;
+			started++;
+		}
+
+		res = create_job_finish(err, i, &jobs[i % nofJobs], result);
+		if (res != KT_OK) goto cleanup;
+
+		res = result->res;
+		if (res != KT_OK) goto cleanup;
+
+		KSI_DataHash_free(lastLeaf);
+		lastLeaf = NULL;
+		res = KSI_DataHash_fromImprint(ksi, result->lastLeaf, result->lastLeaf_len, &lastLeaf);
+		ERR_CATCH_MSG(err, res, "Error: Unable to create hash from the last leaf of the log signature.");
+
+		PST_strncpy(files->previousLogFile, result->logFile, sizeof(files->previousLogFile));
+		PST_strncpy(files->previousSigFileOut, result->sigFile, sizeof(files->previousSigFileOut));
+	}
+
+	res = STATE_FILE_update(state, lastLeaf);
+	ERR_CATCH_MSG(err, res, "Error: Unable to update state file.");
+
 	res = KT_OK;
 
 cleanup:
 
+	/* Jobs still running find out that the link is broken and do not keep their log signature files. */
+	if (nextLink >= 0) close(nextLink);
+
+	if (jobs != NULL) {
+		for (j = 0; j < nofJobs; j++) create_job_close(&jobs[j]);
+	}
+
+	KSI_DataHash_free(lastLeaf);
+	free(result);
+	free(jobs);
+
 	return res;
 }
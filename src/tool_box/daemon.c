@@ -0,0 +1,532 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <ksi/ksi.h>
+#include <ksi/compatibility.h>
+#include <param_set/param_set.h>
+#include <param_set/task_def.h>
+#include <param_set/parameter.h>
+#include <param_set/strn.h>
+#include "tool_box/ksi_init.h"
+#include "tool_box/param_control.h"
+#include "tool_box/task_initializer.h"
+#include "tool_box/default_tasks.h"
+#include "tool_box.h"
+#include "smart_file.h"
+#include "err_trckr.h"
+#include "api_wrapper.h"
+#include "printer.h"
+#include "debug_print.h"
+#include "conf_file.h"
+#include "tool.h"
+#include "pubfile_cache.h"
+#include "job_socket.h"
+
+typedef struct DAEMON_TASK_st {
+	const char *name;
+	int (*run)(int argc, char **argv, char **envp);
+} DAEMON_TASK;
+
+/* Tasks that can be run by the daemon. */
+static const DAEMON_TASK daemon_tasks[] = {
+	{"sign", sign_run},
+	{"verify", verify_run},
+	{"extend", extend_run},
+	{"extract", extract_run},
+	{NULL, NULL}
+};
+
+/* Count of worker processes by default. */
+#define DAEMON_DEFAULT_WORKERS 4
+
+/* Time to wait for a new job, before the stop request and the workers are checked again. */
+#define DAEMON_POLL_INTERVAL_MS 200
+
+static int generate_tasks_set(PARAM_SET *set, TASK_SET *task_set);
+static int check_pipe_errors(PARAM_SET *set, ERR_TRCKR *err);
+static int warm_publications_file(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_CTX *ksi);
+static pid_t start_worker(int listenFd, SMART_FILE *ksi_log);
+static void run_worker(int listenFd);
+static int run_job(int conn, const int *stdFds);
+static void stop_daemon(int sig);
+
+static volatile sig_atomic_t daemon_stop_requested = 0;
+
+#define PARAMS "{socket}{workers}{d}{log}{conf}{h|help}"
+
+int daemon_run(int argc, char **argv, char **envp) {
+	int res;
+	char buf[2048];
+	PARAM_SET *set = NULL;
+	TASK_SET *task_set = NULL;
+	TASK *task = NULL;
+	KSI_CTX *ksi = NULL;
+	ERR_TRCKR *err = NULL;
+	SMART_FILE *logfile = NULL;
+	int d = 0;
+	MULTI_PRINTER *mp = NULL;
+	char *socketPath = NULL;
+	unsigned int workers = DAEMON_DEFAULT_WORKERS;
+	unsigned int ttl = PUBFILE_CACHE_DEFAULT_TTL;
+	unsigned int active = 0;
+	unsigned int i = 0;
+	pid_t *pids = NULL;
+	int listenFd = -1;
+	int isPubFileWarm = 0;
+	time_t lastWarm = 0;
+
+	/**
+	 * Extract command line parameters and also add configuration specific parameters.
+	 */
+	res = PARAM_SET_new(
+			CONF_generate_param_set_desc(PARAMS, "SXP", buf, sizeof(buf)),
+			&set);
+	if (res != KT_OK) goto cleanup;
+
+	res = TASK_SET_new(&task_set);
+	if (res != PST_OK) goto cleanup;
+
+	res = generate_tasks_set(set, task_set);
+	if (res != PST_OK) goto cleanup;
+
+	res = TASK_INITIALIZER_getServiceInfo(set, argc, argv, envp);
+	if (res != PST_OK) goto cleanup;
+
+	res = TASK_INITIALIZER_check_analyze_report(set, task_set, 0.2, 0.1, &task);
+	if (res != KT_OK) goto cleanup;
+
+	res = TASK_INITIALIZER_getPrinter(set, &mp);
+	ERR_CATCH_MSG(err, res, "Error: Unable to create Multi printer!");
+
+	/* Library and service configuration is initialized once and inherited by all the jobs. */
+	res = TOOL_init_ksi(set, &ksi, &err, &logfile);
+	if (res != KT_OK) goto cleanup;
+
+	d = PARAM_SET_isSetByName(set, "d");
+
+	res = check_pipe_errors(set, err);
+	if (res != KT_OK) goto cleanup;
+
+	res = PARAM_SET_getStr(set, "socket", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, &socketPath);
+	ERR_CATCH_MSG(err, res, "Error: Unable to get socket name.");
+
+	if (PARAM_SET_isSetByName(set, "workers")) {
+		res = PARAM_SET_getObj(set, "workers", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, (void*)&workers);
+		ERR_CATCH_MSG(err, res, "Error: Unable to get the count of workers.");
+	}
+
+	if (PARAM_SET_isSetByName(set, "pubfile-cache-ttl")) {
+		res = PARAM_SET_getObj(set, "pubfile-cache-ttl", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, (void*)&ttl);
+		ERR_CATCH_MSG(err, res, "Error: Unable to get publications file cache time-to-live.");
+	}
+
+	/* Publications file cache is kept fresh and verified, so that the jobs do not have to download and verify the file. */
+	isPubFileWarm = PARAM_SET_isSetByName(set, "pubfile-cache,P");
+	if (isPubFileWarm) {
+		res = warm_publications_file(set, mp, err, ksi);
+		if (res != KT_OK) goto cleanup;
+		lastWarm = time(NULL);
+	}
+
+	res = JOB_SOCKET_listen(socketPath, &listenFd);
+	if (res == KT_IO_ERROR) ERR_TRCKR_addAdditionalInfo(err, "  * Suggestion:  Make sure that no other logksi daemon is using the socket.\n");
+	ERR_CATCH_MSG(err, res, "Error: Unable to listen on socket '%s'.", socketPath);
+
+	signal(SIGINT, stop_daemon);
+	signal(SIGTERM, stop_daemon);
+	signal(SIGPIPE, SIG_IGN);
+
+	pids = (pid_t*)calloc(workers, sizeof(pid_t));
+	if (pids == NULL) {
+		ERR_TRCKR_ADD(err, res = KT_OUT_OF_MEMORY, NULL);
+		goto cleanup;
+	}
+
+	print_debug("Listening for jobs on '%s' with %u worker(s).\n", socketPath, workers);
+
+	/**
+	 * Workers are forked once and every worker serves one job at a time, as long as the
+	 * daemon is running. A worker that has ended (e.g. a job has crashed it) is replaced.
+	 */
+	while (!daemon_stop_requested) {
+		struct timespec interval = {0, DAEMON_POLL_INTERVAL_MS * 1000000L};
+		pid_t pid = 0;
+
+		while ((pid = waitpid(-1, NULL, WNOHANG)) > 0) {
+			for (i = 0; i < workers; i++) {
+				if (pids[i] == pid) {
+					pids[i] = 0;
+					active--;
+					print_debug("Worker %u (pid %d) ended.\n", i + 1, (int)pid);
+				}
+			}
+		}
+
+		for (i = 0; i < workers && !daemon_stop_requested; i++) {
+			if (pids[i] != 0) continue;
+
+			pids[i] = start_worker(listenFd, logfile);
+			if (pids[i] < 0) {
+				pids[i] = 0;
+				print_errors("Error: Unable to start worker process: %s\n", strerror(errno));
+			} else {
+				active++;
+				print_debug("Worker %u (pid %d) started.\n", i + 1, (int)pids[i]);
+			}
+		}
+
+		/* Failure to refresh the cache is not fatal, the jobs download the publications file themselves. */
+		if (isPubFileWarm && time(NULL) - lastWarm >= (time_t)(ttl / 2)) {
+			lastWarm = time(NULL);
+			if (warm_publications_file(set, mp, err, ksi) != KT_OK) {
+				ERR_TRCKR_print(err, d);
+				ERR_TRCKR_reset(err);
+			}
+		}
+
+		nanosleep(&interval, NULL);
+	}
+
+	print_debug("Stopping, waiting for %u worker(s) to finish their jobs.\n", active);
+	for (i = 0; i < workers; i++) {
+		if (pids[i] > 0) kill(pids[i], SIGTERM);
+	}
+	while (active > 0 && waitpid(-1, NULL, 0) > 0) active--;
+
+	res = KT_OK;
+
+cleanup:
+
+	if (listenFd >= 0) {
+		close(listenFd);
+		unlink(socketPath);
+	}
+
+	MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
+	LOGKSI_KSI_ERRTrace_save(ksi);
+
+	if (res != KT_OK) {
+		if (ERR_TRCKR_getErrCount(err) == 0) {ERR_TRCKR_ADD(err, res, NULL);}
+		LOGKSI_KSI_ERRTrace_LOG(ksi);
+
+		print_errors("\n");
+		ERR_TRCKR_print(err, d);
+	}
+
+	free(pids);
+	SMART_FILE_close(logfile);
+	PARAM_SET_free(set);
+	TASK_SET_free(task_set);
+	ERR_TRCKR_free(err);
+	KSI_CTX_free(ksi);
+	MULTI_PRINTER_free(mp);
+
+	return LOGKSI_errToExitCode(res);
+}
+
+char *daemon_help_toString(char *buf, size_t len) {
+	int res;
+	char *ret = NULL;
+	PARAM_SET *set;
+	size_t count = 0;
+	char tmp[1024];
+
+	if (buf == NULL || len == 0) return NULL;
+
+
+	/* Create set with documented parameters. */
+	res = PARAM_SET_new(CONF_generate_param_set_desc(PARAMS, "SXP", tmp, sizeof(tmp)), &set);
+	if (res != PST_OK) goto cleanup;
+
+	res = CONF_initialize_set_functions(set, "SXP");
+	if (res != PST_OK) goto cleanup;
+
+	PARAM_SET_setHelpText(set, "socket", "<file>", "Path of the UNIX domain socket where the jobs are accepted. A socket left behind by a daemon that is not running is replaced. To pass the jobs of 'logksi sign', 'verify', 'extend' and 'extract' to the daemon, set the environment variable " JOB_SOCKET_ENV_NAME " to the same path. The standard streams, the working directory and the environment of the client are used by the job and the exit code of the job is returned by the client. The socket is accessible only by the owner and only the jobs of the user running the daemon are accepted.");
+	PARAM_SET_setHelpText(set, "workers", "<int>", "The count of worker processes, that is the maximum count of jobs that are run concurrently. Workers are forked when the daemon is started and every worker runs one job at a time until the daemon is stopped. Default value is 4.");
+	PARAM_SET_setHelpText(set, "d", NULL, "Print information about the jobs and errors to stderr.");
+	PARAM_SET_setHelpText(set, "conf", NULL, "Read configuration options from the given file. Configuration options given explicitly on command line will override the ones in the configuration file.");
+	PARAM_SET_setHelpText(set, "log", NULL, "Write libksi log to the given file. Use '-' as file name to redirect the log to stdout.");
+
+
+	/* Format synopsis and parameters. */
+	count += PST_snhiprintf(buf + count, len - count, 80, 0, 0, NULL, ' ', "Usage:\\>1\n\\>8"
+	"logksi daemon --socket <file> [--workers <int>] [-P <URL> --pubfile-cache <file>] [more_options]"
+	"\\>\n\n\n");
+
+	ret = PARAM_SET_helpToString(set, "socket,workers,P,cnstr,V,pubfile-cache,pubfile-cache-ttl,d,conf,log", 1, 13, 80, buf + count, len - count);
+
+cleanup:
+	if (res != PST_OK || ret == NULL) {
+		PST_snprintf(buf + count, len - count, "\nError: There were failures while generating help by PARAM_SET.\n");
+	}
+	PARAM_SET_free(set);
+	return buf;
+}
+
+const char *daemon_get_desc(void) {
+	return "Runs the jobs of other logksi commands received over a UNIX domain socket.";
+}
+
+static int generate_tasks_set(PARAM_SET *set, TASK_SET *task_set) {
+	int res;
+
+	if (set == NULL || task_set == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	/**
+	 * Configure parameter set, control, repair and object extractor function.
+	 */
+	res = CONF_initialize_set_functions(set, "SXP");
+	if (res != KT_OK) goto cleanup;
+
+	PARAM_SET_addControl(set, "{conf}", isFormatOk_inputFile, isContentOk_inputFileRestrictPipe, convertRepair_path, NULL);
+	PARAM_SET_addControl(set, "{log}{socket}", isFormatOk_path, NULL, convertRepair_path, NULL);
+	PARAM_SET_addControl(set, "{d}", isFormatOk_flag, NULL, NULL, NULL);
+	PARAM_SET_addControl(set, "{workers}", isFormatOk_int, isContentOk_uint_not_zero, NULL, extract_uint);
+
+	PARAM_SET_setParseOptions(set, "d,h", PST_PRSCMD_HAS_NO_VALUE | PST_PRSCMD_NO_TYPOS);
+	PARAM_SET_setParseOptions(set, "socket,workers", PST_PRSCMD_HAS_VALUE | PST_PRSCMD_BREAK_WITH_EXISTING_PARAMETER_MATCH);
+
+
+	/*						ID		DESC							MAN			ATL		FORBIDDEN	IGN	*/
+	TASK_SET_add(task_set,	0,		"Run logksi daemon.",			"socket",	NULL,	NULL,		NULL);
+
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
+
+static int check_pipe_errors(PARAM_SET *set, ERR_TRCKR *err) {
+	int res;
+
+	res = get_pipe_out_error(set, err, NULL, "log", NULL);
+	if (res != KT_OK) goto cleanup;
+
+cleanup:
+	return res;
+}
+
+static int warm_publications_file(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_CTX *ksi) {
+	int res = KT_UNKNOWN_ERROR;
+	int d = PARAM_SET_isSetByName(set, "d");
+	KSI_PublicationsFile *pubFile = NULL;
+	int isPubFileVerified = 0;
+
+	/* Publications file kept by KSI context is dropped, otherwise it is written to the cache again. */
+	res = KSI_CTX_setPublicationsFile(ksi, NULL);
+	ERR_CATCH_MSG(err, res, "Error: Unable to reset publications file.");
+
+	print_progressDesc(mp, MP_ID_BLOCK, d, DEBUG_LEVEL_1, "%s", getPublicationsFileRetrieveDescriptionString(set));
+	res = TOOL_receivePublicationsFile(set, err, ksi, &pubFile, &isPubFileVerified);
+	ERR_CATCH_MSG(err, res, "Error: Unable to receive publications file.");
+	print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_1, res);
+
+	if (!PARAM_SET_isSetByName(set, "publications-file-no-verify")) {
+		print_progressDesc(mp, MP_ID_BLOCK, d, DEBUG_LEVEL_1, "Verifying publications file... ");
+		if (!isPubFileVerified) res = TOOL_verifyPublicationsFile(set, err, ksi, pubFile);
+		ERR_CATCH_MSG(err, res, "Error: Unable to verify publications file.");
+		print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_1, res);
+	}
+
+	res = KT_OK;
+
+cleanup:
+
+	print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_1, res);
+	MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
+	KSI_PublicationsFile_free(pubFile);
+
+	return res;
+}
+
+/**
+ * Debug output of the job is enabled the same way as in main.
+ */
+static int is_debug_requested(int argc, char **argv) {
+	int res;
+	PARAM_SET *set = NULL;
+	int d = 0;
+
+	res = PARAM_SET_new("{h|help}{version}{d}{time-diff}{block-time-diff}", &set);
+	if (res != PST_OK) goto cleanup;
+
+	res = PARAM_SET_setParseOptions(set, "time-diff,block-time-diff", PST_PRSCMD_HAS_VALUE | PST_PRSCMD_NO_TYPOS);
+	if (res != PST_OK) goto cleanup;
+
+	PARAM_SET_parseCMD(set, argc, argv, NULL, 0);
+	d = PARAM_SET_isSetByName(set, "d");
+
+cleanup:
+
+	PARAM_SET_free(set);
+
+	return d;
+}
+
+/**
+ * Forks a worker process. The worker inherits the KSI context of the daemon and keeps
+ * it for its whole life, so that libksi and its network and crypto providers are
+ * initialized only once per worker and not for every job.
+ */
+static pid_t start_worker(int listenFd, SMART_FILE *ksi_log) {
+	pid_t pid = 0;
+
+	fflush(stdout);
+	fflush(stderr);
+	if (ksi_log != NULL) SMART_FILE_flush(ksi_log);
+
+	pid = fork();
+	if (pid == 0) {
+		run_worker(listenFd);
+		fflush(stdout);
+		fflush(stderr);
+		_exit(EXIT_SUCCESS);
+	}
+
+	return pid;
+}
+
+/**
+ * Accepts the jobs one at a time until the daemon is stopped. Only the jobs of the user
+ * running the daemon are accepted. The job in progress is finished before the worker ends.
+ */
+static void run_worker(int listenFd) {
+	int stdFds[JOB_SOCKET_FD_COUNT];
+	int i;
+
+	/* Standard streams of the daemon are restored after every job. */
+	for (i = 0; i < JOB_SOCKET_FD_COUNT; i++) {
+		stdFds[i] = dup(i);
+	}
+
+	while (!daemon_stop_requested) {
+		struct pollfd pfd;
+		int conn = -1;
+		uid_t uid = 0;
+
+		pfd.fd = listenFd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+
+		if (poll(&pfd, 1, DAEMON_POLL_INTERVAL_MS) <= 0) continue;
+
+		/* Other workers may have taken the connection. */
+		conn = accept(listenFd, NULL, NULL);
+		if (conn < 0) continue;
+
+		if (JOB_SOCKET_getPeerUid(conn, &uid) != KT_OK || uid != getuid()) {
+			print_errors("Error: Job of user %ld rejected, only the jobs of user %ld are accepted.\n", (long)uid, (long)getuid());
+			close(conn);
+			continue;
+		}
+
+		run_job(conn, stdFds);
+	}
+
+	for (i = 0; i < JOB_SOCKET_FD_COUNT; i++) {
+		if (stdFds[i] >= 0) close(stdFds[i]);
+	}
+}
+
+static int run_job(int conn, const int *stdFds) {
+	int res;
+	JOB_REQUEST *req = NULL;
+	const DAEMON_TASK *task = NULL;
+	int exitCode = EXIT_FAILURE;
+	int isRedirected = 0;
+	int isDebug = print_enabled(PRINT_DEBUG);
+	int i;
+
+	res = JOB_SOCKET_receiveRequest(conn, &req);
+	if (res != KT_OK) goto cleanup;
+
+	/* Output of the job is written directly to the standard streams of the client. */
+	isRedirected = 1;
+	for (i = 0; i < JOB_SOCKET_FD_COUNT; i++) {
+		if (req->fds[i] < 0 || dup2(req->fds[i], i) < 0) {
+			res = KT_IO_ERROR;
+			goto cleanup;
+		}
+	}
+
+	for (i = 0; daemon_tasks[i].name != NULL; i++) {
+		if (strcmp(daemon_tasks[i].name, req->argv[0]) == 0) {
+			task = &daemon_tasks[i];
+			break;
+		}
+	}
+
+	if (task == NULL) {
+		print_errors("Error: Task '%s' can not be run by logksi daemon.\n", req->argv[0]);
+		exitCode = EXIT_INVALID_CL_PARAMETERS;
+	} else if (chdir(req->cwd) != 0) {
+		print_errors("Error: Unable to change working directory to '%s'.\n", req->cwd);
+		exitCode = EXIT_IO_ERROR;
+	} else {
+		print_disable(PRINT_DEBUG);
+		if (is_debug_requested(req->argc, req->argv)) print_enable(PRINT_DEBUG);
+
+		/* Job is configured by the environment of the client (e.g. KSI_CONF). */
+		exitCode = task->run(req->argc, req->argv, req->envp);
+	}
+
+	res = KT_OK;
+
+cleanup:
+
+	/* Worker must not keep the streams of the client open after the job. */
+	fflush(stdout);
+	fflush(stderr);
+	if (isRedirected) {
+		for (i = 0; i < JOB_SOCKET_FD_COUNT; i++) {
+			if (stdFds[i] >= 0) dup2(stdFds[i], i);
+		}
+	}
+	if (isDebug) print_enable(PRINT_DEBUG);
+	else print_disable(PRINT_DEBUG);
+
+	JOB_REQUEST_free(req);
+	req = NULL;
+
+	if (res == KT_OK) res = JOB_SOCKET_sendResponse(conn, exitCode);
+
+	close(conn);
+
+	return (res == KT_OK) ? exitCode : LOGKSI_errToExitCode(res);
+}
+
+static void stop_daemon(int sig) {
+	(void)sig;
+	daemon_stop_requested = 1;
+}
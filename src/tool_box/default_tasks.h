@@ -48,6 +48,14 @@ int create_run(int argc, char** argv, char **envp);
 char *create_help_toString(char*buf, size_t len);
 const char *create_get_desc(void);
 
+int index_run(int argc, char** argv, char **envp);
+char *index_help_toString(char*buf, size_t len);
+const char *index_get_desc(void);
+
+int daemon_run(int argc, char** argv, char **envp);
+char *daemon_help_toString(char*buf, size_t len);
+const char *daemon_get_desc(void);
+
 int conf_run(int argc, char** argv, char **envp);
 char *conf_help_toString(char *buf, size_t len);
 const char *conf_get_desc(void);
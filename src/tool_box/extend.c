@@ -22,6 +22,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
+#include <time.h>
 #include <ksi/ksi.h>
 #include <ksi/compatibility.h>
 #include <ksi/policy.h>
@@ -44,10 +45,15 @@
 #include "rsyslog.h"
 #include <inttypes.h>
 #include "io_files.h"
+#include "extend_cache.h"
+#include "extend_queue.h"
+#include "tlv_object.h"
 
 static int extend_to_nearest_publication(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *logksi, IO_FILES *files, KSI_Signature *sig, KSI_PublicationsFile *pubFile, KSI_VerificationContext *context, KSI_Signature **ext);
 static int extend_to_specified_time(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *logksi, IO_FILES *files, KSI_Signature *sig, KSI_PublicationsFile *pubFile, KSI_VerificationContext *context, KSI_Signature **ext);
 static int extend_to_specified_publication(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *logksi, IO_FILES *files, KSI_Signature *sig, KSI_PublicationsFile *pubFile, KSI_VerificationContext *context, KSI_Signature **ext);
+static int extend_signature_using_cache(ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *logksi, KSI_Signature *sig, const KSI_PublicationRecord *pubRec, KSI_Integer *pubTime, KSI_VerificationContext *context, KSI_Signature **ext);
+static int prefetch_calendar_hash_chains(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_CTX *ksi, KSI_PublicationsFile *pubFile, const char *fname, EXTEND_CACHE *cache, size_t maxPending);
 static int generate_tasks_set(PARAM_SET *set, TASK_SET *task_set);
 static int check_pipe_errors(PARAM_SET *set, ERR_TRCKR *err);
 static int check_io_naming_and_type_errors(PARAM_SET *set, ERR_TRCKR *err);
@@ -56,7 +62,7 @@ static int open_input_and_output_files(PARAM_SET *set, ERR_TRCKR *err, IO_FILES
 static int rename_temporary_and_backup_files(ERR_TRCKR *err, IO_FILES *files);
 static void close_input_and_output_files(ERR_TRCKR *err, int res, IO_FILES *files);
 
-#define PARAMS "{input}{o}{sig-from-stdin}{enable-rfc3161-conversion}{d}{x}{T}{pub-str}{conf}{log}{h|help}{hex-to-str}"
+#define PARAMS "{input}{o}{sig-from-stdin}{enable-rfc3161-conversion}{d}{x}{T}{pub-str}{conf}{log}{h|help}{hex-to-str}{write-index}{skip-tree-check}{ext-cache}{max-pending}"
 
 enum {
 	EXT_TO_EAV_PUBLICATION_FROM_FILE = 0x00,
@@ -80,7 +86,11 @@ int extend_run(int argc, char** argv, char **envp) {
 	IO_FILES files;
 	EXTENDING_FUNCTION extend_signature = NULL;
 	KSI_PublicationsFile *pubFile = NULL;
+	int isPubFileVerified = 0;
 	MULTI_PRINTER *mp = NULL;
+	EXTEND_CACHE *cache = NULL;
+	char *cacheDir = NULL;
+	unsigned int maxPending = 1;
 
 	IO_FILES_init(&files);
 
@@ -124,13 +134,13 @@ int extend_run(int argc, char** argv, char **envp) {
 		case EXT_TO_SPEC_PUBLICATION_FROM_FILE:
 		case EXT_TO_SPEC_PUBLICATION_FROM_STDIN:
 				print_progressDesc(mp, MP_ID_BLOCK, d, DEBUG_LEVEL_1, "%s", getPublicationsFileRetrieveDescriptionString(set));
-				res = LOGKSI_receivePublicationsFile(err, ksi, &pubFile);
+				res = TOOL_receivePublicationsFile(set, err, ksi, &pubFile, &isPubFileVerified);
 				ERR_CATCH_MSG(err, res, "Error: Unable to receive publications file.");
 				print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_1, res);
 
 				if (!PARAM_SET_isSetByName(set, "publications-file-no-verify")) {
 					print_progressDesc(mp, MP_ID_BLOCK, d, DEBUG_LEVEL_1, "Verifying publications file... ");
-					res = LOGKSI_verifyPublicationsFile(err, ksi, pubFile);
+					if (!isPubFileVerified) res = TOOL_verifyPublicationsFile(set, err, ksi, pubFile);
 					ERR_CATCH_MSG(err, res, "Error: Unable to verify publications file.");
 					print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_1, res);
 				}
@@ -159,17 +169,47 @@ int extend_run(int argc, char** argv, char **envp) {
 		break;
 	}
 
+	if (PARAM_SET_isSetByName(set, "ext-cache")) {
+		res = PARAM_SET_getStr(set, "ext-cache", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, &cacheDir);
+		ERR_CATCH_MSG(err, res, "Error: Unable to get extender cache directory.");
+
+		res = EXTEND_CACHE_new(cacheDir, &cache);
+		ERR_CATCH_MSG(err, res, "Error: Unable to open extender cache directory %s.", cacheDir);
+	}
+
 	res = generate_filenames(set, err, &files);
 	if (res != KT_OK) goto cleanup;
 
 	res = open_input_and_output_files(set, err, &files);
 	if (res != KT_OK) goto cleanup;
 
+	if (PARAM_SET_isSetByName(set, "max-pending")) {
+		res = PARAM_SET_getObj(set, "max-pending", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, (void*)&maxPending);
+		ERR_CATCH_MSG(err, res, "Error: Unable to get the maximum count of pending extending requests.");
+	}
+
+	/* Responses of the concurrent requests are handed over to the extending pass via the cache. */
+	if (maxPending > 1 && files.internal.inSig != NULL) {
+		if (cache == NULL) {
+			res = EXTEND_CACHE_new(NULL, &cache);
+			ERR_CATCH_MSG(err, res, "Error: Unable to create extender cache.");
+		}
+
+		print_progressDesc(mp, MP_ID_BLOCK, 0, DEBUG_EQUAL | DEBUG_LEVEL_1, "Prefetching calendar hash chains... ");
+		res = prefetch_calendar_hash_chains(set, mp, err, ksi, pubFile, files.internal.inSig, cache, (size_t)maxPending);
+		print_progressResult(mp, MP_ID_BLOCK, DEBUG_EQUAL | DEBUG_LEVEL_1, res);
+		if (res != KT_OK) goto cleanup;
+	}
+
 	print_progressDesc(mp, MP_ID_BLOCK, 0, DEBUG_EQUAL | DEBUG_LEVEL_1, "Extending... ");
-	res = logsignature_extend(set, mp, err, ksi, pubFile, extend_signature, &files);
+	res = logsignature_extend(set, mp, err, ksi, pubFile, extend_signature, &files, cache);
 	print_progressResult(mp, MP_ID_BLOCK, DEBUG_EQUAL | DEBUG_LEVEL_1, res);
 	if (res != KT_OK) goto cleanup;
 
+	if (cache != NULL) {
+		print_debug_mp(mp, MP_ID_BLOCK, DEBUG_LEVEL_2, "Extender cache: %zu KSI signature(s) extended with cached calendar hash chains.\n", EXTEND_CACHE_getHits(cache));
+	}
+
 	res = rename_temporary_and_backup_files(err, &files);
 	if (res != KT_OK) goto cleanup;
 
@@ -198,6 +238,7 @@ cleanup:
 	TASK_SET_free(task_set);
 	ERR_TRCKR_free(err);
 	KSI_PublicationsFile_free(pubFile);
+	EXTEND_CACHE_free(cache);
 	KSI_CTX_free(ksi);
 	MULTI_PRINTER_free(mp);
 
@@ -228,6 +269,10 @@ char *extend_help_toString(char*buf, size_t len) {
 	PARAM_SET_setHelpText(set, "o", "<out.logsig>", "Name of the extended output log signature file. An existing log signature file is always overwritten. If not specified, the log signature is saved to '<logfile>.logsig' while a backup of '<logfile>.logsig' is saved in '<logfile>.logsig.bak'. Use '-' to redirect the extended log signature binary stream to stdout. If input is read from stdin and output is not specified, stdout is used for output.");
 	PARAM_SET_setHelpText(set, "pub-str", "<str>", "Publication record as publication string to extend the signature to.");
 	PARAM_SET_setHelpText(set, "enable-rfc3161-conversion", NULL, "Enable conversion, extending and replacing of RFC3161 timestamps with KSI signatures. Note: this flag is not required if a different output log signature file name is specified with '-o' to avoid overwriting of the original log signature file.");
+	PARAM_SET_setHelpText(set, "skip-tree-check", NULL, "Extend the KSI signatures without rebuilding the Merkle trees of the blocks. Only the block signatures are parsed, all the other data is copied to the output log signature file as it is. The KSI signatures are not checked against the record hashes, use 'logksi verify' for that.");
+	PARAM_SET_setHelpText(set, "ext-cache", "<dir>", "Keep the calendar hash chains received from the extender in the given directory. A calendar hash chain depends only on the aggregation time of the KSI signature and on the publication time, so it is reused for all the KSI signatures of the same aggregation round, in the same and in later runs. The cached chains are verified together with the KSI signature. The directory is created if it does not exist and can be shared by several processes.");
+	PARAM_SET_setHelpText(set, "max-pending", "<int>", "The maximum count of extending requests that can be sent to the extender without waiting for the responses. The log signature file is scanned before extending and one request is sent for every different aggregation time of the KSI signatures. The responses are kept in memory (and in the directory given with '--ext-cache') and used when the blocks are extended in the original order. Default value is 1 (every KSI signature is extended before the next one is read).");
+	PARAM_SET_setHelpText(set, "write-index", NULL, "Write a block index file next to the output log signature file as '<out.logsig>.idx'. The index contains the positions of the blocks in the log signature file and makes it possible to access a block without reading the file from the beginning. The index is always updated if it already exists. See 'logksi index' to create the index for an existing log signature file.");
 	PARAM_SET_setHelpText(set, "d", NULL, "Print detailed information about processes and errors to stderr. To make output more verbose use -dd or -ddd.");
 	PARAM_SET_setHelpText(set, "conf", NULL, "Read configuration options from the given file. Configuration options given explicitly on command line will override the ones in the configuration file.");
 	PARAM_SET_setHelpText(set, "log", NULL, "Write libksi log to the given file. Use '-' as file name to redirect the log to stdout.");
@@ -242,7 +287,7 @@ char *extend_help_toString(char*buf, size_t len) {
 	"logksi extend --sig-from-stdin [-o <out.logsig>] [more_options]"
 	"\\>\n\n\n");
 
-	ret = PARAM_SET_helpToString(set, "input,sig-from-stdin,o,X,ext-user,ext-key,ext-hmac-alg,P,cnstr,pub-str,V,enable-rfc3161-conversion,d,conf,log", 1, 13, 80, buf + count, len - count);
+	ret = PARAM_SET_helpToString(set, "input,sig-from-stdin,o,X,ext-user,ext-key,ext-hmac-alg,P,cnstr,pub-str,V,pubfile-cache,pubfile-cache-ttl,enable-rfc3161-conversion,skip-tree-check,ext-cache,max-pending,write-index,d,conf,log", 1, 13, 80, buf + count, len - count);
 
 cleanup:
 	if (res != PST_OK || ret == NULL) {
@@ -294,7 +339,7 @@ static int extend_to_nearest_publication(PARAM_SET *set, MULTI_PRINTER *mp, ERR_
 	}
 
 
-	res = LOGKSI_Signature_extend(err, sig, ksi, pubRec, context, &tmp);
+	res = extend_signature_using_cache(err, ksi, logksi, sig, pubRec, NULL, context, &tmp);
 	ERR_CATCH_MSG(err, res, "Error: Unable to extend signature.");
 	print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_1, res);
 
@@ -345,7 +390,7 @@ static int extend_to_specified_time(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR
 		logksi->blockNo,
 		KSI_Integer_toDateString(pubTime, buf, sizeof(buf)),
 		(unsigned long long)KSI_Integer_getUInt64(pubTime));
-	res = LOGKSI_Signature_extendTo(err, sig, ksi, pubTime, context, &tmp);
+	res = extend_signature_using_cache(err, ksi, logksi, sig, NULL, pubTime, context, &tmp);
 	ERR_CATCH_MSG(err, res, "Error: Unable to extend signature.");
 	print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_1, res);
 
@@ -397,7 +442,7 @@ static int extend_to_specified_publication(PARAM_SET *set, MULTI_PRINTER *mp, ER
 
 	print_progressDesc(mp, MP_ID_BLOCK, 1, DEBUG_LEVEL_3, "Block no. %3zu: extending KSI signature to the specified publication: %s (%llu)... ", logksi->blockNo, KSI_Integer_toDateString(pubTime, buf, sizeof(buf)), (unsigned long long)KSI_Integer_getUInt64(pubTime));
 	print_progressDesc(mp, MP_ID_BLOCK, 1, DEBUG_EQUAL | DEBUG_LEVEL_2, "Extending Block no. %3zu to the specified publication... ", logksi->blockNo);
-	res = LOGKSI_Signature_extend(err, sig, ksi, pub_rec, context, &tmp);
+	res = extend_signature_using_cache(err, ksi, logksi, sig, pub_rec, NULL, context, &tmp);
 	ERR_CATCH_MSG(err, res, "Error: Unable to extend signature.");
 	print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_1, res);
 
@@ -413,6 +458,561 @@ cleanup:
 	return res;
 }
 
+/**
+ * Extracts the calendar hash chain of the extended KSI signature. The chain is stored
+ * as the only element of a KSI signature TLV. The publication record is not cached, as
+ * it must always be taken from a trusted source (see #extend_cache_data_to_signature).
+ */
+static int extend_cache_data_from_signature(KSI_Signature *ext, unsigned char *buf, size_t buf_len, size_t *len) {
+	int res;
+	unsigned char *raw = NULL;
+	size_t raw_len = 0;
+	KSI_TlvElement *tlvExt = NULL;
+	KSI_TlvElement *tlvData = NULL;
+	size_t i;
+
+	res = KSI_Signature_serialize(ext, &raw, &raw_len);
+	if (res != KSI_OK) goto cleanup;
+
+	res = KSI_TlvElement_parse(raw, raw_len, &tlvExt);
+	if (res != KSI_OK) goto cleanup;
+
+	res = KSI_TlvElement_new(&tlvData);
+	if (res != KSI_OK) goto cleanup;
+	tlvData->ftlv.tag = 0x800;
+
+	for (i = 0; i < KSI_TlvElementList_length(tlvExt->subList); i++) {
+		KSI_TlvElement *tmpTlv = NULL;
+
+		res = KSI_TlvElementList_elementAt(tlvExt->subList, i, &tmpTlv);
+		if (res != KSI_OK) goto cleanup;
+
+		if (tmpTlv != NULL && tmpTlv->ftlv.tag == 0x802) {
+			res = KSI_TlvElement_appendElement(tlvData, tmpTlv);
+			if (res != KSI_OK) goto cleanup;
+		}
+	}
+
+	res = KSI_TlvElement_serialize(tlvData, buf, buf_len, len, 0);
+	if (res != KSI_OK) goto cleanup;
+
+	res = KT_OK;
+
+cleanup:
+
+	KSI_free(raw);
+	KSI_TlvElement_free(tlvExt);
+	KSI_TlvElement_free(tlvData);
+
+	return res;
+}
+
+/**
+ * Checks that the calendar hash chain of the extended KSI signature ends with the published
+ * hash and at the publication time of the trusted publication record.
+ */
+static int extend_check_publication(KSI_Signature *ext, const KSI_PublicationRecord *pubRec) {
+	int res;
+	KSI_CalendarHashChain *chain = NULL;
+	KSI_DataHash *root = NULL;
+	KSI_Integer *chainTime = NULL;
+	KSI_PublicationData *pubData = NULL;
+	KSI_DataHash *pubHash = NULL;
+	KSI_Integer *pubTime = NULL;
+
+	if (ext == NULL || pubRec == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	res = KSI_Signature_getCalendarHashChain(ext, &chain);
+	if (res != KSI_OK) goto cleanup;
+
+	res = KSI_PublicationRecord_getPublishedData(pubRec, &pubData);
+	if (res != KSI_OK) goto cleanup;
+
+	if (chain == NULL || pubData == NULL) {
+		res = KT_VERIFICATION_FAILURE;
+		goto cleanup;
+	}
+
+	res = KSI_CalendarHashChain_aggregate(chain, &root);
+	if (res != KSI_OK) goto cleanup;
+
+	res = KSI_CalendarHashChain_getPublicationTime(chain, &chainTime);
+	if (res != KSI_OK) goto cleanup;
+
+	res = KSI_PublicationData_getImprint(pubData, &pubHash);
+	if (res != KSI_OK) goto cleanup;
+
+	res = KSI_PublicationData_getTime(pubData, &pubTime);
+	if (res != KSI_OK) goto cleanup;
+
+	if (!KSI_DataHash_equals(root, pubHash) || !KSI_Integer_equals(chainTime, pubTime)) {
+		res = KT_VERIFICATION_FAILURE;
+		goto cleanup;
+	}
+
+	res = KT_OK;
+
+cleanup:
+
+	KSI_DataHash_free(root);
+
+	return res;
+}
+
+/**
+ * Replaces the calendar hash chain and the calendar authentication record of the KSI
+ * signature with the cached calendar hash chain (see #extend_cache_data_from_signature)
+ * and drops the publication record. The result is verified with the internal verification
+ * policy, so a cached calendar hash chain that does not match the aggregation hash chains
+ * is not used. If \c pubRec is set, the output of the calendar hash chain must match its
+ * published hash and a copy of \c pubRec is attached to the result.
+ */
+static int extend_cache_data_to_signature(KSI_CTX *ksi, KSI_Signature *sig, const KSI_PublicationRecord *pubRec, const unsigned char *data, size_t data_len, KSI_VerificationContext *context, KSI_Signature **ext) {
+	int res;
+	unsigned char *raw = NULL;
+	size_t raw_len = 0;
+	unsigned char buf[SOF_FTLV_BUFFER];
+	size_t buf_len = 0;
+	KSI_TlvElement *tlvSig = NULL;
+	KSI_TlvElement *tlvData = NULL;
+	KSI_TlvElement *tlvExt = NULL;
+	KSI_Signature *tmp = NULL;
+	KSI_PublicationRecord *tmpRec = NULL;
+	int isDataAdded = 0;
+	size_t i;
+
+	res = KSI_Signature_serialize(sig, &raw, &raw_len);
+	if (res != KSI_OK) goto cleanup;
+
+	res = KSI_TlvElement_parse(raw, raw_len, &tlvSig);
+	if (res != KSI_OK) goto cleanup;
+
+	res = KSI_TlvElement_parse((unsigned char*)data, data_len, &tlvData);
+	if (res != KSI_OK) goto cleanup;
+
+	res = KSI_TlvElement_new(&tlvExt);
+	if (res != KSI_OK) goto cleanup;
+	tlvExt->ftlv.tag = 0x800;
+
+	/* Cached elements take the place of the calendar hash chain to keep the order of the elements. */
+	for (i = 0; i < KSI_TlvElementList_length(tlvSig->subList); i++) {
+		KSI_TlvElement *tmpTlv = NULL;
+		size_t j;
+
+		res = KSI_TlvElementList_elementAt(tlvSig->subList, i, &tmpTlv);
+		if (res != KSI_OK) goto cleanup;
+		if (tmpTlv == NULL) continue;
+
+		if (tmpTlv->ftlv.tag == 0x802 || tmpTlv->ftlv.tag == 0x806) {
+			for (j = 0; !isDataAdded && j < KSI_TlvElementList_length(tlvData->subList); j++) {
+				KSI_TlvElement *dataTlv = NULL;
+
+				res = KSI_TlvElementList_elementAt(tlvData->subList, j, &dataTlv);
+				if (res != KSI_OK) goto cleanup;
+				if (dataTlv == NULL || dataTlv->ftlv.tag != 0x802) continue;
+
+				res = KSI_TlvElement_appendElement(tlvExt, dataTlv);
+				if (res != KSI_OK) goto cleanup;
+			}
+			isDataAdded = 1;
+		}
+
+		if (tmpTlv->ftlv.tag != 0x802 && tmpTlv->ftlv.tag != 0x803 && tmpTlv->ftlv.tag != 0x805) {
+			res = KSI_TlvElement_appendElement(tlvExt, tmpTlv);
+			if (res != KSI_OK) goto cleanup;
+		}
+	}
+
+	for (i = 0; !isDataAdded && i < KSI_TlvElementList_length(tlvData->subList); i++) {
+		KSI_TlvElement *dataTlv = NULL;
+
+		res = KSI_TlvElementList_elementAt(tlvData->subList, i, &dataTlv);
+		if (res != KSI_OK) goto cleanup;
+		if (dataTlv == NULL || dataTlv->ftlv.tag != 0x802) continue;
+
+		res = KSI_TlvElement_appendElement(tlvExt, dataTlv);
+		if (res != KSI_OK) goto cleanup;
+	}
+
+	res = KSI_TlvElement_serialize(tlvExt, buf, sizeof(buf), &buf_len, 0);
+	if (res != KSI_OK) goto cleanup;
+
+	res = KSI_Signature_parseWithPolicy(ksi, buf, buf_len, KSI_VERIFICATION_POLICY_INTERNAL, context, &tmp);
+	if (res != KSI_OK) goto cleanup;
+
+	if (pubRec != NULL) {
+		res = extend_check_publication(tmp, pubRec);
+		if (res != KT_OK) goto cleanup;
+
+		res = KSI_PublicationRecord_clone(pubRec, &tmpRec);
+		if (res != KSI_OK) goto cleanup;
+
+		res = KSI_Signature_replacePublicationRecord(tmp, tmpRec);
+		if (res != KSI_OK) goto cleanup;
+		tmpRec = NULL;
+	}
+
+	*ext = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	KSI_Signature_free(tmp);
+	KSI_PublicationRecord_free(tmpRec);
+	KSI_free(raw);
+	KSI_TlvElement_free(tlvSig);
+	KSI_TlvElement_free(tlvData);
+	KSI_TlvElement_free(tlvExt);
+
+	return res;
+}
+
+/**
+ * Extends the KSI signature to the publication record (\c pubRec) or to the publication time
+ * (\c pubTime) if \c pubRec is not set. If the extender cache is used, the calendar hash chain
+ * is taken from the cache if possible and the chains received from the extender are added
+ * to the cache.
+ */
+static int extend_signature_using_cache(ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *logksi, KSI_Signature *sig, const KSI_PublicationRecord *pubRec, KSI_Integer *pubTime, KSI_VerificationContext *context, KSI_Signature **ext) {
+	int res;
+	EXTEND_CACHE *cache = NULL;
+	KSI_Signature *tmp = NULL;
+	KSI_Integer *sigTime = NULL;
+	KSI_PublicationData *pubData = NULL;
+	const unsigned char *data = NULL;
+	size_t data_len = 0;
+	unsigned char buf[SOF_FTLV_BUFFER];
+	size_t buf_len = 0;
+	uint64_t aggrTime = 0;
+	uint64_t toTime = 0;
+	time_t extTime = 0;
+
+	if (err == NULL || ksi == NULL || logksi == NULL || sig == NULL || (pubRec == NULL && pubTime == NULL) || ext == NULL) {
+		ERR_TRCKR_ADD(err, res = KT_INVALID_ARGUMENT, NULL);
+		goto cleanup;
+	}
+
+	cache = logksi->task.extend.cache;
+
+	if (cache == NULL) {
+		if (pubRec != NULL) {
+			res = LOGKSI_Signature_extend(err, sig, ksi, pubRec, context, &tmp);
+		} else {
+			res = LOGKSI_Signature_extendTo(err, sig, ksi, pubTime, context, &tmp);
+		}
+		if (res != KT_OK) goto cleanup;
+	} else {
+		if (pubRec != NULL) {
+			res = KSI_PublicationRecord_getPublishedData(pubRec, &pubData);
+			ERR_CATCH_MSG(err, res, "Error: Unable to get publication data.");
+
+			res = KSI_PublicationData_getTime(pubData, &pubTime);
+			ERR_CATCH_MSG(err, res, "Error: Unable to get publication time.");
+		}
+
+		res = KSI_Signature_getSigningTime(sig, &sigTime);
+		ERR_CATCH_MSG(err, res, "Error: Unable to get signing time.");
+
+		aggrTime = KSI_Integer_getUInt64(sigTime);
+		toTime = KSI_Integer_getUInt64(pubTime);
+
+		res = EXTEND_CACHE_get(cache, aggrTime, toTime, &data, &data_len);
+		if (res != KT_OK && res != KT_INDEX_OVF) {
+			ERR_TRCKR_ADD(err, res, "Error: Unable to get calendar hash chain from extender cache.");
+			goto cleanup;
+		}
+
+		/* A cached chain that does not fit is removed and requested from the extender again. */
+		if (res == KT_OK) {
+			res = extend_cache_data_to_signature(ksi, sig, pubRec, data, data_len, context, &tmp);
+			if (res == KT_OK) {
+				res = KSI_Signature_getPublicationInfo(tmp, NULL, NULL, &extTime, NULL, NULL);
+				if (res == KT_OK && (uint64_t)extTime != toTime) res = KT_INVALID_INPUT_FORMAT;
+			}
+
+			if (res != KT_OK) {
+				KSI_Signature_free(tmp);
+				tmp = NULL;
+				EXTEND_CACHE_remove(cache, aggrTime, toTime);
+			}
+		}
+
+		if (tmp == NULL) {
+			if (pubRec != NULL) {
+				res = LOGKSI_Signature_extend(err, sig, ksi, pubRec, context, &tmp);
+			} else {
+				res = LOGKSI_Signature_extendTo(err, sig, ksi, pubTime, context, &tmp);
+			}
+			if (res != KT_OK) goto cleanup;
+
+			if (pubRec != NULL) {
+				res = extend_check_publication(tmp, pubRec);
+				ERR_CATCH_MSG(err, res, "Error: Calendar hash chain of the extended KSI signature does not match the publication.");
+			}
+
+			res = extend_cache_data_from_signature(tmp, buf, sizeof(buf), &buf_len);
+			ERR_CATCH_MSG(err, res, "Error: Unable to get calendar hash chain from extended KSI signature.");
+
+			res = EXTEND_CACHE_add(cache, aggrTime, toTime, buf, buf_len);
+			ERR_CATCH_MSG(err, res, "Error: Unable to store calendar hash chain in extender cache.");
+		}
+	}
+
+	*ext = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	KSI_Signature_free(tmp);
+
+	return res;
+}
+
+typedef struct EXTEND_PREFETCH_KEY_st {
+	uint64_t aggrTime;
+	uint64_t pubTime;
+} EXTEND_PREFETCH_KEY;
+
+/**
+ * Takes the next response from the queue and stores the calendar hash chain in the cache.
+ * The extended KSI signature is verified with the internal verification policy first, so
+ * that a calendar hash chain that does not fit the signature is not cached. Failed requests
+ * are only counted, as the KSI signatures are extended again when the blocks are processed
+ * and the errors are reported there.
+ */
+static int prefetch_store_response(ERR_TRCKR *err, KSI_CTX *ksi, EXTEND_QUEUE *queue, EXTEND_CACHE *cache, size_t *nofFailed) {
+	int res;
+	void *ctx = NULL;
+	EXTEND_PREFETCH_KEY *key = NULL;
+	KSI_Signature *ext = NULL;
+	KSI_PolicyVerificationResult *verRes = NULL;
+	int error = KT_OK;
+	unsigned char buf[SOF_FTLV_BUFFER];
+	size_t buf_len = 0;
+
+	res = EXTEND_QUEUE_getNext(queue, 1, &ctx, &ext, &error);
+	if (res != KT_OK) goto cleanup;
+
+	key = (EXTEND_PREFETCH_KEY*)ctx;
+	if (key == NULL) {
+		res = KT_OK;
+		goto cleanup;
+	}
+
+	if (ext == NULL || error != KT_OK
+			|| LOGKSI_SignatureVerify_internally(err, ext, ksi, NULL, 0, &verRes) != KT_OK
+			|| extend_cache_data_from_signature(ext, buf, sizeof(buf), &buf_len) != KT_OK) {
+		(*nofFailed)++;
+	} else {
+		res = EXTEND_CACHE_add(cache, key->aggrTime, key->pubTime, buf, buf_len);
+		if (res != KT_OK) goto cleanup;
+	}
+
+	res = KT_OK;
+
+cleanup:
+
+	free(key);
+	KSI_PolicyVerificationResult_free(verRes);
+	KSI_Signature_free(ext);
+
+	return res;
+}
+
+/**
+ * Sends an extending request for the KSI signature of the block signature TLV, unless the
+ * calendar hash chain is already cached or requested for the previous block. Block
+ * signatures without a KSI signature and the ones that can not be parsed are skipped.
+ */
+static int prefetch_block_signature(ERR_TRCKR *err, KSI_CTX *ksi, KSI_PublicationsFile *pubFile, unsigned char *raw, size_t raw_len, KSI_PublicationRecord *pubRec, KSI_Integer *pubTime, EXTEND_QUEUE *queue, EXTEND_CACHE *cache, EXTEND_PREFETCH_KEY *last, size_t *nofRequests, size_t *nofFailed) {
+	int res;
+	KSI_TlvElement *tlv = NULL;
+	KSI_TlvElement *tlvSig = NULL;
+	KSI_Signature *sig = NULL;
+	KSI_Integer *sigTime = NULL;
+	KSI_PublicationRecord *nearestRec = NULL;
+	KSI_PublicationData *pubData = NULL;
+	EXTEND_PREFETCH_KEY *key = NULL;
+	uint64_t aggrTime = 0;
+	uint64_t toTime = 0;
+
+	res = KSI_TlvElement_parse(raw, raw_len, &tlv);
+	if (res != KSI_OK || KSI_TlvElement_getElement(tlv, 0x905, &tlvSig) != KSI_OK || tlvSig == NULL) {
+		res = KT_OK;
+		goto cleanup;
+	}
+
+	res = KSI_Signature_parseWithPolicy(ksi, tlvSig->ptr + tlvSig->ftlv.hdr_len, tlvSig->ftlv.dat_len, KSI_VERIFICATION_POLICY_EMPTY, NULL, &sig);
+	if (res != KSI_OK || KSI_Signature_getSigningTime(sig, &sigTime) != KSI_OK || sigTime == NULL) {
+		res = KT_OK;
+		goto cleanup;
+	}
+
+	aggrTime = KSI_Integer_getUInt64(sigTime);
+
+	if (pubTime == NULL && pubRec == NULL) {
+		res = KSI_PublicationsFile_getNearestPublication(pubFile, sigTime, &nearestRec);
+		if (res != KSI_OK || nearestRec == NULL) {
+			res = KT_OK;
+			goto cleanup;
+		}
+		pubRec = nearestRec;
+	}
+
+	if (pubRec != NULL) {
+		res = KSI_PublicationRecord_getPublishedData(pubRec, &pubData);
+		if (res != KSI_OK) goto cleanup;
+
+		res = KSI_PublicationData_getTime(pubData, &pubTime);
+		if (res != KSI_OK) goto cleanup;
+	}
+
+	toTime = KSI_Integer_getUInt64(pubTime);
+
+	if ((last->aggrTime == aggrTime && last->pubTime == toTime) || EXTEND_CACHE_has(cache, aggrTime, toTime)) {
+		res = KT_OK;
+		goto cleanup;
+	}
+
+	while (EXTEND_QUEUE_isFull(queue)) {
+		res = prefetch_store_response(err, ksi, queue, cache, nofFailed);
+		if (res != KT_OK) goto cleanup;
+	}
+
+	key = (EXTEND_PREFETCH_KEY*)malloc(sizeof(EXTEND_PREFETCH_KEY));
+	if (key == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	key->aggrTime = aggrTime;
+	key->pubTime = toTime;
+
+	res = EXTEND_QUEUE_add(queue, sig, pubRec, toTime, key, free);
+	if (res != KT_OK) goto cleanup;
+	key = NULL;
+
+	last->aggrTime = aggrTime;
+	last->pubTime = toTime;
+	(*nofRequests)++;
+	res = KT_OK;
+
+cleanup:
+
+	free(key);
+	KSI_PublicationRecord_free(nearestRec);
+	KSI_Signature_free(sig);
+	KSI_TlvElement_free(tlvSig);
+	KSI_TlvElement_free(tlv);
+
+	return res;
+}
+
+/**
+ * Scans the log signature file and sends extending requests for all the KSI signatures
+ * concurrently, at most \c maxPending at once. The calendar hash chains received are
+ * stored in the cache, where they are taken from when the blocks are extended.
+ */
+static int prefetch_calendar_hash_chains(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_CTX *ksi, KSI_PublicationsFile *pubFile, const char *fname, EXTEND_CACHE *cache, size_t maxPending) {
+	int res;
+	SMART_FILE *in = NULL;
+	EXTEND_QUEUE *queue = NULL;
+	LOGSIG_VERSION version = UNKN_VER;
+	unsigned char ftlv_raw[SOF_FTLV_BUFFER];
+	size_t ftlv_len = 0;
+	KSI_FTLV ftlv;
+	size_t hdr_len = 0;
+	size_t pos = 0;
+	KSI_Integer *pubTime = NULL;
+	KSI_PublicationRecord *pubRec = NULL;
+	EXTEND_PREFETCH_KEY last = {0, 0};
+	size_t nofRequests = 0;
+	size_t nofFailed = 0;
+	char *pubs_str = NULL;
+	COMPOSITE extra;
+
+	if (set == NULL || err == NULL || ksi == NULL || fname == NULL || cache == NULL || maxPending == 0) {
+		ERR_TRCKR_ADD(err, res = KT_INVALID_ARGUMENT, NULL);
+		goto cleanup;
+	}
+
+	res = SMART_FILE_open(fname, "rb", &in);
+	ERR_CATCH_MSG(err, res, "Error: Could not open input signature file '%s'.", fname);
+
+	/* Excerpt files and legacy log signature files are extended one signature at a time. */
+	version = LOGSIG_VERSION_getFileVer(in);
+	if (version != LOGSIG11 && version != LOGSIG12) {
+		res = KT_OK;
+		goto cleanup;
+	}
+
+	if (PARAM_SET_isSetByName(set, "T")) {
+		extra.ctx = ksi;
+		extra.err = err;
+
+		res = PARAM_SET_getObjExtended(set, "T", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, &extra, (void**)&pubTime);
+		ERR_CATCH_MSG(err, res, "Error: Unable to extract the time value to extend to.");
+	} else if (PARAM_SET_isSetByName(set, "pub-str")) {
+		res = PARAM_SET_getStr(set, "pub-str", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, &pubs_str);
+		ERR_CATCH_MSG(err, res, "Error: Unable get publication string.");
+
+		/* Missing publication record is reported when the first block is extended. */
+		res = KSI_PublicationsFile_getPublicationDataByPublicationString(pubFile, pubs_str, &pubRec);
+		if (res != KSI_OK || pubRec == NULL) {
+			res = KT_OK;
+			goto cleanup;
+		}
+	}
+
+	res = TOOL_newExtendQueue(set, err, ksi, maxPending, &queue);
+	if (res != KT_OK) goto cleanup;
+
+	while (1) {
+		res = SMART_FILE_getPosition(in, &pos);
+		ERR_CATCH_MSG(err, res, "Error: Could not get the position of input log signature file.");
+
+		res = LOGKSI_FTLV_smartFileReadHeader(in, &hdr_len, &ftlv);
+		if (res == KT_INVALID_INPUT_FORMAT && hdr_len == 0) break;
+		ERR_CATCH_MSG(err, res, "Error: Incomplete data found in log signature file.");
+
+		if (ftlv.tag == 0x904) {
+			res = SMART_FILE_setPosition(in, pos);
+			ERR_CATCH_MSG(err, res, "Error: Unable to read block signature.");
+
+			res = LOGKSI_FTLV_smartFileRead(in, ftlv_raw, SOF_FTLV_BUFFER, &ftlv_len, &ftlv);
+			ERR_CATCH_MSG(err, res, "Error: Unable to read block signature.");
+
+			res = prefetch_block_signature(err, ksi, pubFile, ftlv_raw, ftlv_len, pubRec, pubTime, queue, cache, &last, &nofRequests, &nofFailed);
+			ERR_CATCH_MSG(err, res, "Error: Unable to send extending request.");
+		} else {
+			res = SMART_FILE_setPosition(in, pos + ftlv.hdr_len + ftlv.dat_len);
+			ERR_CATCH_MSG(err, res, "Error: Unable to skip data in log signature file.");
+		}
+	}
+
+	while (EXTEND_QUEUE_getCount(queue) > 0) {
+		res = prefetch_store_response(err, ksi, queue, cache, &nofFailed);
+		ERR_CATCH_MSG(err, res, "Error: Unable to receive extending response.");
+	}
+
+	print_debug_mp(mp, MP_ID_BLOCK, DEBUG_LEVEL_2, "Prefetch: %zu extending request(s) sent, %zu failed.\n", nofRequests, nofFailed);
+
+	res = KT_OK;
+
+cleanup:
+
+	EXTEND_QUEUE_free(queue);
+	SMART_FILE_close(in);
+	KSI_Integer_free(pubTime);
+
+	return res;
+}
+
 static int generate_tasks_set(PARAM_SET *set, TASK_SET *task_set) {
 	int res;
 
@@ -431,15 +1031,17 @@ static int generate_tasks_set(PARAM_SET *set, TASK_SET *task_set) {
 	 * Configure parameter set, control, repair and object extractor function.
 	 */
 	PARAM_SET_addControl(set, "{conf}", isFormatOk_inputFile, isContentOk_inputFileRestrictPipe, convertRepair_path, NULL);
-	PARAM_SET_addControl(set, "{log}{o}", isFormatOk_path, NULL, convertRepair_path, NULL);
+	PARAM_SET_addControl(set, "{log}{o}{ext-cache}", isFormatOk_path, NULL, convertRepair_path, NULL);
 	PARAM_SET_addControl(set, "{input}", isFormatOk_inputFile, isContentOk_inputFileWithPipe, convertRepair_path, NULL);
 	PARAM_SET_addControl(set, "{T}", isFormatOk_utcTime, isContentOk_utcTime, NULL, extract_utcTime);
-	PARAM_SET_addControl(set, "{sig-from-stdin}{enable-rfc3161-conversion}{d}{hex-to-str}", isFormatOk_flag, NULL, NULL, NULL);
+	PARAM_SET_addControl(set, "{sig-from-stdin}{enable-rfc3161-conversion}{d}{hex-to-str}{write-index}{skip-tree-check}", isFormatOk_flag, NULL, NULL, NULL);
 	PARAM_SET_addControl(set, "{pub-str}", isFormatOk_pubString, NULL, NULL, extract_pubString);
+	PARAM_SET_addControl(set, "{max-pending}", isFormatOk_int, isContentOk_uint_not_zero, NULL, extract_uint);
 
 	PARAM_SET_setParseOptions(set, "input", PST_PRSCMD_COLLECT_LOOSE_VALUES | PST_PRSCMD_HAS_NO_FLAG | PST_PRSCMD_NO_TYPOS);
 	PARAM_SET_setParseOptions(set, "d,h", PST_PRSCMD_HAS_NO_VALUE | PST_PRSCMD_NO_TYPOS);
-	PARAM_SET_setParseOptions(set, "sig-from-stdin,enable-rfc3161-conversion,hex-to-str", PST_PRSCMD_HAS_NO_VALUE);
+	PARAM_SET_setParseOptions(set, "sig-from-stdin,enable-rfc3161-conversion,hex-to-str,write-index,skip-tree-check", PST_PRSCMD_HAS_NO_VALUE);
+	PARAM_SET_setParseOptions(set, "max-pending", PST_PRSCMD_HAS_VALUE | PST_PRSCMD_BREAK_WITH_EXISTING_PARAMETER_MATCH);
 
 	/**
 	 * Define possible tasks.
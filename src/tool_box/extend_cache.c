@@ -0,0 +1,392 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "logksi_err.h"
+#include "smart_file.h"
+#include "extend_cache.h"
+
+/**
+ * Cache file layout (all integers are 64-bit big-endian):
+ *   magic "LOGECH10" | aggregation time | publication time | size of the data | data
+ * The file name is '<aggregation time>-<publication time>' in the cache directory.
+ */
+#define EXTEND_CACHE_MAGIC "LOGECH10"
+#define EXTEND_CACHE_MAGIC_SIZE 8
+#define EXTEND_CACHE_HEADER_SIZE (EXTEND_CACHE_MAGIC_SIZE + 3 * 8)
+#define EXTEND_CACHE_MAX_DATA_SIZE (0xffff + 4)
+#define EXTEND_CACHE_BUCKET_COUNT 0x400
+
+typedef struct EXTEND_CACHE_ENTRY_st EXTEND_CACHE_ENTRY;
+
+struct EXTEND_CACHE_ENTRY_st {
+	uint64_t aggrTime;
+	uint64_t pubTime;
+	unsigned char *data;
+	size_t data_len;
+	EXTEND_CACHE_ENTRY *next;
+};
+
+struct EXTEND_CACHE_st {
+	char *dir;
+	EXTEND_CACHE_ENTRY *buckets[EXTEND_CACHE_BUCKET_COUNT];
+	size_t hits;
+};
+
+static void extend_cache_put_uint64(unsigned char *buf, uint64_t val) {
+	int i;
+
+	for (i = 7; i >= 0; i--) {
+		buf[i] = (unsigned char)(val & 0xff);
+		val >>= 8;
+	}
+}
+
+static uint64_t extend_cache_get_uint64(const unsigned char *buf) {
+	uint64_t val = 0;
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		val = (val << 8) | buf[i];
+	}
+
+	return val;
+}
+
+static size_t extend_cache_bucket(uint64_t aggrTime, uint64_t pubTime) {
+	return (size_t)((aggrTime * 31 + pubTime) % EXTEND_CACHE_BUCKET_COUNT);
+}
+
+static EXTEND_CACHE_ENTRY **extend_cache_find(EXTEND_CACHE *cache, uint64_t aggrTime, uint64_t pubTime) {
+	EXTEND_CACHE_ENTRY **entry = &cache->buckets[extend_cache_bucket(aggrTime, pubTime)];
+
+	while (*entry != NULL && ((*entry)->aggrTime != aggrTime || (*entry)->pubTime != pubTime)) {
+		entry = &(*entry)->next;
+	}
+
+	return entry;
+}
+
+static int extend_cache_file_name(EXTEND_CACHE *cache, uint64_t aggrTime, uint64_t pubTime, char *buf, size_t buf_len) {
+	int count = 0;
+
+	count = snprintf(buf, buf_len, "%s/%llu-%llu", cache->dir, (unsigned long long)aggrTime, (unsigned long long)pubTime);
+	if (count < 0 || (size_t)count >= buf_len) return KT_INDEX_OVF;
+
+	return KT_OK;
+}
+
+static int extend_cache_read_all(SMART_FILE *in, unsigned char *buf, size_t len) {
+	int res;
+	size_t count = 0;
+
+	res = SMART_FILE_read(in, buf, len, &count);
+	if (res != SMART_FILE_OK) return res;
+
+	return (count == len) ? KT_OK : KT_INVALID_INPUT_FORMAT;
+}
+
+static int extend_cache_read_file(const char *fname, uint64_t aggrTime, uint64_t pubTime, unsigned char **data, size_t *data_len) {
+	int res = KT_UNKNOWN_ERROR;
+	SMART_FILE *in = NULL;
+	unsigned char buf[EXTEND_CACHE_HEADER_SIZE];
+	unsigned char *tmp = NULL;
+	uint64_t len = 0;
+
+	res = SMART_FILE_open(fname, "rb", &in);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	res = extend_cache_read_all(in, buf, sizeof(buf));
+	if (res != KT_OK) goto cleanup;
+
+	len = extend_cache_get_uint64(buf + EXTEND_CACHE_MAGIC_SIZE + 16);
+
+	if (memcmp(buf, EXTEND_CACHE_MAGIC, EXTEND_CACHE_MAGIC_SIZE) != 0
+			|| extend_cache_get_uint64(buf + EXTEND_CACHE_MAGIC_SIZE) != aggrTime
+			|| extend_cache_get_uint64(buf + EXTEND_CACHE_MAGIC_SIZE + 8) != pubTime
+			|| len == 0 || len > EXTEND_CACHE_MAX_DATA_SIZE) {
+		res = KT_INVALID_INPUT_FORMAT;
+		goto cleanup;
+	}
+
+	tmp = (unsigned char*)malloc((size_t)len);
+	if (tmp == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	res = extend_cache_read_all(in, tmp, (size_t)len);
+	if (res != KT_OK) goto cleanup;
+
+	*data = tmp;
+	*data_len = (size_t)len;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	SMART_FILE_close(in);
+	free(tmp);
+
+	return res;
+}
+
+static int extend_cache_write_file(const char *fname, uint64_t aggrTime, uint64_t pubTime, const unsigned char *data, size_t data_len) {
+	int res = KT_UNKNOWN_ERROR;
+	SMART_FILE *out = NULL;
+	unsigned char buf[EXTEND_CACHE_HEADER_SIZE];
+	SMART_FILE_IOVEC iov[2];
+
+	memcpy(buf, EXTEND_CACHE_MAGIC, EXTEND_CACHE_MAGIC_SIZE);
+	extend_cache_put_uint64(buf + EXTEND_CACHE_MAGIC_SIZE, aggrTime);
+	extend_cache_put_uint64(buf + EXTEND_CACHE_MAGIC_SIZE + 8, pubTime);
+	extend_cache_put_uint64(buf + EXTEND_CACHE_MAGIC_SIZE + 16, data_len);
+
+	iov[0].raw = buf;
+	iov[0].raw_len = sizeof(buf);
+	iov[1].raw = data;
+	iov[1].raw_len = data_len;
+
+	res = SMART_FILE_open(fname, "wbT", &out);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	res = SMART_FILE_writev(out, iov, 2, NULL);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	res = SMART_FILE_markConsistent(out);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	res = SMART_FILE_close(out);
+	out = NULL;
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	res = KT_OK;
+
+cleanup:
+
+	SMART_FILE_close(out);
+
+	return res;
+}
+
+static int extend_cache_insert(EXTEND_CACHE *cache, uint64_t aggrTime, uint64_t pubTime, unsigned char *data, size_t data_len) {
+	EXTEND_CACHE_ENTRY **entry = NULL;
+	EXTEND_CACHE_ENTRY *tmp = NULL;
+
+	entry = extend_cache_find(cache, aggrTime, pubTime);
+
+	if (*entry != NULL) {
+		free((*entry)->data);
+		(*entry)->data = data;
+		(*entry)->data_len = data_len;
+		return KT_OK;
+	}
+
+	tmp = (EXTEND_CACHE_ENTRY*)malloc(sizeof(EXTEND_CACHE_ENTRY));
+	if (tmp == NULL) return KT_OUT_OF_MEMORY;
+
+	tmp->aggrTime = aggrTime;
+	tmp->pubTime = pubTime;
+	tmp->data = data;
+	tmp->data_len = data_len;
+	tmp->next = NULL;
+	*entry = tmp;
+
+	return KT_OK;
+}
+
+int EXTEND_CACHE_new(const char *dir, EXTEND_CACHE **cache) {
+	int res = KT_UNKNOWN_ERROR;
+	EXTEND_CACHE *tmp = NULL;
+	size_t i;
+
+	if (cache == NULL) return KT_INVALID_ARGUMENT;
+
+	tmp = (EXTEND_CACHE*)malloc(sizeof(EXTEND_CACHE));
+	if (tmp == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	tmp->dir = NULL;
+	tmp->hits = 0;
+	for (i = 0; i < EXTEND_CACHE_BUCKET_COUNT; i++) tmp->buckets[i] = NULL;
+
+	if (dir != NULL) {
+		tmp->dir = (char*)malloc(strlen(dir) + 1);
+		if (tmp->dir == NULL) {
+			res = KT_OUT_OF_MEMORY;
+			goto cleanup;
+		}
+		strcpy(tmp->dir, dir);
+
+		if (mkdir(dir, 0700) != 0 && errno != EEXIST) {
+			res = KT_IO_ERROR;
+			goto cleanup;
+		}
+	}
+
+	*cache = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	EXTEND_CACHE_free(tmp);
+
+	return res;
+}
+
+void EXTEND_CACHE_free(EXTEND_CACHE *cache) {
+	size_t i;
+
+	if (cache == NULL) return;
+
+	for (i = 0; i < EXTEND_CACHE_BUCKET_COUNT; i++) {
+		EXTEND_CACHE_ENTRY *entry = cache->buckets[i];
+
+		while (entry != NULL) {
+			EXTEND_CACHE_ENTRY *next = entry->next;
+			free(entry->data);
+			free(entry);
+			entry = next;
+		}
+	}
+
+	free(cache->dir);
+	free(cache);
+}
+
+int EXTEND_CACHE_get(EXTEND_CACHE *cache, uint64_t aggrTime, uint64_t pubTime, const unsigned char **data, size_t *data_len) {
+	int res = KT_UNKNOWN_ERROR;
+	EXTEND_CACHE_ENTRY **entry = NULL;
+	unsigned char *tmp = NULL;
+	size_t tmp_len = 0;
+	char fname[0x1000];
+
+	if (cache == NULL || data == NULL || data_len == NULL) return KT_INVALID_ARGUMENT;
+
+	entry = extend_cache_find(cache, aggrTime, pubTime);
+
+	if (*entry == NULL) {
+		if (cache->dir == NULL) return KT_INDEX_OVF;
+
+		res = extend_cache_file_name(cache, aggrTime, pubTime, fname, sizeof(fname));
+		if (res != KT_OK) return res;
+
+		if (!SMART_FILE_doFileExist(fname)) return KT_INDEX_OVF;
+
+		/* Entries that can not be read are fetched again and overwritten. */
+		res = extend_cache_read_file(fname, aggrTime, pubTime, &tmp, &tmp_len);
+		if (res == KT_OUT_OF_MEMORY) return res;
+		if (res != KT_OK) return KT_INDEX_OVF;
+
+		res = extend_cache_insert(cache, aggrTime, pubTime, tmp, tmp_len);
+		if (res != KT_OK) {
+			free(tmp);
+			return res;
+		}
+
+		entry = extend_cache_find(cache, aggrTime, pubTime);
+	}
+
+	cache->hits++;
+	*data = (*entry)->data;
+	*data_len = (*entry)->data_len;
+
+	return KT_OK;
+}
+
+int EXTEND_CACHE_has(EXTEND_CACHE *cache, uint64_t aggrTime, uint64_t pubTime) {
+	char fname[0x1000];
+
+	if (cache == NULL) return 0;
+	if (*extend_cache_find(cache, aggrTime, pubTime) != NULL) return 1;
+	if (cache->dir == NULL) return 0;
+	if (extend_cache_file_name(cache, aggrTime, pubTime, fname, sizeof(fname)) != KT_OK) return 0;
+
+	return SMART_FILE_doFileExist(fname);
+}
+
+int EXTEND_CACHE_add(EXTEND_CACHE *cache, uint64_t aggrTime, uint64_t pubTime, const unsigned char *data, size_t data_len) {
+	int res = KT_UNKNOWN_ERROR;
+	unsigned char *tmp = NULL;
+	char fname[0x1000];
+
+	if (cache == NULL || data == NULL || data_len == 0 || data_len > EXTEND_CACHE_MAX_DATA_SIZE) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	if (cache->dir != NULL) {
+		res = extend_cache_file_name(cache, aggrTime, pubTime, fname, sizeof(fname));
+		if (res != KT_OK) goto cleanup;
+
+		res = extend_cache_write_file(fname, aggrTime, pubTime, data, data_len);
+		if (res != KT_OK) goto cleanup;
+	}
+
+	tmp = (unsigned char*)malloc(data_len);
+	if (tmp == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+	memcpy(tmp, data, data_len);
+
+	res = extend_cache_insert(cache, aggrTime, pubTime, tmp, data_len);
+	if (res != KT_OK) goto cleanup;
+
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	free(tmp);
+
+	return res;
+}
+
+void EXTEND_CACHE_remove(EXTEND_CACHE *cache, uint64_t aggrTime, uint64_t pubTime) {
+	EXTEND_CACHE_ENTRY **entry = NULL;
+	char fname[0x1000];
+
+	if (cache == NULL) return;
+
+	entry = extend_cache_find(cache, aggrTime, pubTime);
+
+	if (*entry != NULL) {
+		EXTEND_CACHE_ENTRY *tmp = *entry;
+		*entry = tmp->next;
+		free(tmp->data);
+		free(tmp);
+	}
+
+	if (cache->dir != NULL && extend_cache_file_name(cache, aggrTime, pubTime, fname, sizeof(fname)) == KT_OK) {
+		SMART_FILE_remove(fname);
+	}
+}
+
+size_t EXTEND_CACHE_getHits(EXTEND_CACHE *cache) {
+	return (cache == NULL) ? 0 : cache->hits;
+}
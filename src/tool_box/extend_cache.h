@@ -0,0 +1,92 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+#ifndef EXTEND_CACHE_H
+#define	EXTEND_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+typedef struct EXTEND_CACHE_st EXTEND_CACHE;
+
+/**
+ * Creates a cache for the responses of the extender. A calendar hash chain depends
+ * only on the aggregation time of the signature and on the publication time it is
+ * extended to, so the same chain can be used for all the signatures created in the same
+ * aggregation round. The entries are kept in memory and, if \c dir is set, in the given
+ * directory (one file per entry), so that they can be used in later runs.
+ * \param dir			Name of the cache directory or \c NULL to keep the entries only in memory. The directory is created with access for the owner only if it does not exist.
+ * \param cache			Output parameter for the cache.
+ * \return KT_OK if successful, KT_IO_ERROR if the directory can not be created, error code otherwise.
+ */
+int EXTEND_CACHE_new(const char *dir, EXTEND_CACHE **cache);
+void EXTEND_CACHE_free(EXTEND_CACHE *cache);
+
+/**
+ * Returns the cached data of the given aggregation and publication time. If the entry
+ * is not in memory, it is read from the cache directory.
+ * \param cache			Cache object.
+ * \param aggrTime		Aggregation time of the signature.
+ * \param pubTime		Publication time the signature is extended to.
+ * \param data			Output parameter for the data. Belongs to the cache.
+ * \param data_len		Output parameter for the size of the data.
+ * \return KT_OK if successful, KT_INDEX_OVF if there is no such entry, error code otherwise.
+ * A corrupted cache file is handled as a missing entry.
+ */
+int EXTEND_CACHE_get(EXTEND_CACHE *cache, uint64_t aggrTime, uint64_t pubTime, const unsigned char **data, size_t *data_len);
+
+/**
+ * Returns non-zero value, if there is an entry for the given aggregation and publication
+ * time in memory or in the cache directory. The entry is not read.
+ */
+int EXTEND_CACHE_has(EXTEND_CACHE *cache, uint64_t aggrTime, uint64_t pubTime);
+
+/**
+ * Adds an entry to the cache. An existing entry with the same key is replaced. The cache
+ * file is written to a temporary file first and renamed when complete, so that processes
+ * sharing the cache directory never see a partial entry.
+ * \param cache			Cache object.
+ * \param aggrTime		Aggregation time of the signature.
+ * \param pubTime		Publication time the signature is extended to.
+ * \param data			Data to be cached.
+ * \param data_len		Size of the data.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int EXTEND_CACHE_add(EXTEND_CACHE *cache, uint64_t aggrTime, uint64_t pubTime, const unsigned char *data, size_t data_len);
+
+/**
+ * Removes an entry from the cache and from the cache directory. It is used when the
+ * cached data turns out to be invalid.
+ */
+void EXTEND_CACHE_remove(EXTEND_CACHE *cache, uint64_t aggrTime, uint64_t pubTime);
+
+/**
+ * Returns the count of lookups that were answered from the cache.
+ */
+size_t EXTEND_CACHE_getHits(EXTEND_CACHE *cache);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* EXTEND_CACHE_H */
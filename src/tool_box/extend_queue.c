@@ -0,0 +1,489 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ksi/ksi.h>
+#include <ksi/net.h>
+#include "logksi_err.h"
+#include "extend_queue.h"
+
+/* Time to sleep between polls of the asynchronous service, when waiting for a response. */
+#define EXTEND_QUEUE_POLL_INTERVAL_NS 1000000
+
+typedef struct EXTEND_QUEUE_ITEM_st {
+	size_t id;			/* Request id, that is unique within the queue. */
+	KSI_Signature *sig;
+	KSI_PublicationRecord *pubRec;
+	KSI_uint64_t pubTime;
+	void *ctx;
+	void (*ctx_free)(void*);
+	KSI_Signature *ext;
+	int error;
+	int isSent;
+	int isDone;
+} EXTEND_QUEUE_ITEM;
+
+struct EXTEND_QUEUE_st {
+	KSI_CTX *ksi;
+	KSI_AsyncService *service;
+	EXTEND_QUEUE_ITEM *items;
+	size_t capacity;
+	size_t first;
+	size_t count;
+	size_t nextId;
+};
+
+static void extend_queue_item_clean(EXTEND_QUEUE_ITEM *item) {
+	if (item == NULL) return;
+
+	KSI_Signature_free(item->sig);
+	KSI_PublicationRecord_free(item->pubRec);
+	KSI_Signature_free(item->ext);
+	if (item->ctx_free != NULL) item->ctx_free(item->ctx);
+	memset(item, 0, sizeof(EXTEND_QUEUE_ITEM));
+}
+
+static EXTEND_QUEUE_ITEM* extend_queue_get_item(EXTEND_QUEUE *queue, size_t i) {
+	return &queue->items[(queue->first + i) % queue->capacity];
+}
+
+/* Returns the item of the request with the given id or NULL if the item is already taken from the queue. */
+static EXTEND_QUEUE_ITEM* extend_queue_find_item(EXTEND_QUEUE *queue, size_t id) {
+	size_t i;
+
+	for (i = 0; i < queue->count; i++) {
+		EXTEND_QUEUE_ITEM *item = extend_queue_get_item(queue, i);
+		if (item->id == id) return item;
+	}
+
+	return NULL;
+}
+
+static void extend_queue_mark_failed(EXTEND_QUEUE *queue, int error) {
+	size_t i;
+
+	for (i = 0; i < queue->count; i++) {
+		EXTEND_QUEUE_ITEM *item = extend_queue_get_item(queue, i);
+
+		if (!item->isDone) {
+			item->isDone = 1;
+			item->error = error;
+		}
+	}
+}
+
+/* Returns KSI_ASYNC_REQUEST_CACHE_FULL if the request must be sent later. */
+static int extend_queue_send_item(EXTEND_QUEUE *queue, EXTEND_QUEUE_ITEM *item) {
+	int res = KT_UNKNOWN_ERROR;
+	KSI_ExtendReq *req = NULL;
+	KSI_AsyncHandle *handle = NULL;
+	KSI_Integer *sigTime = NULL;
+	KSI_Integer *aggrTime = NULL;
+	KSI_Integer *pubTime = NULL;
+	size_t *id = NULL;
+
+	res = KSI_Signature_getSigningTime(item->sig, &sigTime);
+	if (res != KSI_OK) goto cleanup;
+
+	res = KSI_ExtendReq_new(queue->ksi, &req);
+	if (res != KSI_OK) goto cleanup;
+
+	res = KSI_Integer_new(queue->ksi, KSI_Integer_getUInt64(sigTime), &aggrTime);
+	if (res != KSI_OK) goto cleanup;
+
+	res = KSI_ExtendReq_setAggregationTime(req, aggrTime);
+	if (res != KSI_OK) goto cleanup;
+	aggrTime = NULL;
+
+	res = KSI_Integer_new(queue->ksi, item->pubTime, &pubTime);
+	if (res != KSI_OK) goto cleanup;
+
+	res = KSI_ExtendReq_setPublicationTime(req, pubTime);
+	if (res != KSI_OK) goto cleanup;
+	pubTime = NULL;
+
+	res = KSI_AsyncExtendHandle_new(queue->ksi, req, &handle);
+	if (res != KSI_OK) goto cleanup;
+	req = NULL;
+
+	/* Request is identified by its id, as the item is reused for the next requests. */
+	id = (size_t*)malloc(sizeof(size_t));
+	if (id == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	*id = item->id;
+
+	res = KSI_AsyncHandle_setRequestCtx(handle, (void*)id, free);
+	if (res != KSI_OK) goto cleanup;
+	id = NULL;
+
+	res = KSI_AsyncService_addRequest(queue->service, handle);
+	if (res != KSI_OK) goto cleanup;
+	handle = NULL;
+
+	item->isSent = 1;
+	res = KT_OK;
+
+cleanup:
+
+	free(id);
+	KSI_Integer_free(aggrTime);
+	KSI_Integer_free(pubTime);
+	KSI_ExtendReq_free(req);
+	KSI_AsyncHandle_free(handle);
+
+	return res;
+}
+
+/**
+ * Creates the extended signature by replacing the calendar hash chain of the original
+ * signature with the received one and attaching the publication record.
+ */
+static int extend_queue_build_signature(EXTEND_QUEUE_ITEM *item, KSI_AsyncHandle *handle, KSI_Signature **ext) {
+	int res = KT_UNKNOWN_ERROR;
+	KSI_ExtendResp *resp = NULL;
+	KSI_CalendarHashChain *chain = NULL;
+	KSI_PublicationRecord *pubRec = NULL;
+	KSI_Signature *tmp = NULL;
+
+	res = KSI_AsyncHandle_getExtendResp(handle, &resp);
+	if (res != KSI_OK) goto cleanup;
+
+	res = KSI_ExtendResp_getCalendarHashChain(resp, &chain);
+	if (res != KSI_OK) goto cleanup;
+
+	if (chain == NULL) {
+		res = KSI_INVALID_FORMAT;
+		goto cleanup;
+	}
+
+	res = KSI_Signature_clone(item->sig, &tmp);
+	if (res != KSI_OK) goto cleanup;
+
+	res = KSI_Signature_replaceCalendarChain(tmp, KSI_CalendarHashChain_ref(chain));
+	if (res != KSI_OK) goto cleanup;
+
+	if (item->pubRec != NULL) {
+		res = KSI_PublicationRecord_clone(item->pubRec, &pubRec);
+		if (res != KSI_OK) goto cleanup;
+
+		res = KSI_Signature_replacePublicationRecord(tmp, pubRec);
+		if (res != KSI_OK) goto cleanup;
+		pubRec = NULL;
+	}
+
+	*ext = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	KSI_PublicationRecord_free(pubRec);
+	KSI_Signature_free(tmp);
+
+	return res;
+}
+
+static int extend_queue_handle_response(EXTEND_QUEUE *queue, KSI_AsyncHandle *handle) {
+	int res = KT_UNKNOWN_ERROR;
+	int state = 0;
+	const size_t *id = NULL;
+	EXTEND_QUEUE_ITEM *item = NULL;
+
+	res = KSI_AsyncHandle_getState(handle, &state);
+	if (res != KSI_OK) goto cleanup;
+
+	/* Skip responses that do not belong to any request (e.g. pushed configuration). */
+	if (state != KSI_ASYNC_STATE_RESPONSE_RECEIVED && state != KSI_ASYNC_STATE_ERROR) {
+		res = KT_OK;
+		goto cleanup;
+	}
+
+	res = KSI_AsyncHandle_getRequestCtx(handle, (const void**)&id);
+	if (res != KSI_OK) goto cleanup;
+
+	if (id == NULL) {
+		res = KT_UNKNOWN_ERROR;
+		goto cleanup;
+	}
+
+	/* Request may already be marked as failed and even taken from the queue. */
+	item = extend_queue_find_item(queue, *id);
+	if (item == NULL || item->isDone) {
+		res = KT_OK;
+		goto cleanup;
+	}
+
+	if (state == KSI_ASYNC_STATE_RESPONSE_RECEIVED) {
+		item->error = extend_queue_build_signature(item, handle, &item->ext);
+	} else {
+		res = KSI_AsyncHandle_getError(handle, &item->error);
+		if (res != KSI_OK) goto cleanup;
+		if (item->error == KSI_OK) item->error = KSI_SERVICE_UNKNOWN_ERROR;
+	}
+
+	item->isDone = 1;
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
+
+static int extend_queue_run(EXTEND_QUEUE *queue) {
+	int res = KT_UNKNOWN_ERROR;
+	KSI_AsyncHandle *handle = NULL;
+	size_t waiting = 0;
+	size_t i;
+
+	/* Send all requests that were not accepted by the service earlier. */
+	for (i = 0; i < queue->count; i++) {
+		EXTEND_QUEUE_ITEM *item = extend_queue_get_item(queue, i);
+
+		if (item->isSent || item->isDone) continue;
+
+		res = extend_queue_send_item(queue, item);
+		if (res == KSI_ASYNC_REQUEST_CACHE_FULL) break;
+		else if (res != KT_OK) {
+			item->isDone = 1;
+			item->error = res;
+		}
+	}
+
+	do {
+		res = KSI_AsyncService_run(queue->service, &handle, &waiting);
+		if (res != KSI_OK) {
+			/* Service is not usable anymore. Let the caller handle the failed requests. */
+			extend_queue_mark_failed(queue, res);
+			res = KT_OK;
+			goto cleanup;
+		}
+
+		if (handle == NULL) break;
+
+		res = extend_queue_handle_response(queue, handle);
+		if (res != KT_OK) goto cleanup;
+
+		KSI_AsyncHandle_free(handle);
+		handle = NULL;
+	} while (1);
+
+	res = KT_OK;
+
+cleanup:
+
+	KSI_AsyncHandle_free(handle);
+
+	return res;
+}
+
+int EXTEND_QUEUE_new(KSI_CTX *ksi, const char *url, const char *user, const char *key, KSI_HashAlgorithm hmacAlg, size_t maxPending, EXTEND_QUEUE **queue) {
+	int res = KT_UNKNOWN_ERROR;
+	EXTEND_QUEUE *tmp = NULL;
+
+	if (ksi == NULL || url == NULL || maxPending == 0 || queue == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	tmp = (EXTEND_QUEUE*)malloc(sizeof(EXTEND_QUEUE));
+	if (tmp == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	tmp->ksi = ksi;
+	tmp->service = NULL;
+	tmp->items = NULL;
+	tmp->capacity = maxPending;
+	tmp->first = 0;
+	tmp->count = 0;
+	tmp->nextId = 1;
+
+	tmp->items = (EXTEND_QUEUE_ITEM*)calloc(maxPending, sizeof(EXTEND_QUEUE_ITEM));
+	if (tmp->items == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	res = KSI_ExtendingAsyncService_new(ksi, &tmp->service);
+	if (res != KSI_OK) goto cleanup;
+
+	res = KSI_AsyncService_setEndpoint(tmp->service, url, user, key);
+	if (res != KSI_OK) goto cleanup;
+
+	if (KSI_isHashAlgorithmSupported(hmacAlg)) {
+		res = KSI_AsyncService_setOption(tmp->service, KSI_ASYNC_OPT_HMAC_ALGORITHM, (void*)hmacAlg);
+		if (res != KSI_OK) goto cleanup;
+	}
+
+	res = KSI_AsyncService_setOption(tmp->service, KSI_ASYNC_OPT_REQUEST_CACHE_SIZE, (void*)maxPending);
+	if (res != KSI_OK) goto cleanup;
+
+	res = KSI_AsyncService_setOption(tmp->service, KSI_ASYNC_OPT_MAX_REQUEST_COUNT, (void*)maxPending);
+	if (res != KSI_OK) goto cleanup;
+
+	*queue = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	EXTEND_QUEUE_free(tmp);
+
+	return res;
+}
+
+void EXTEND_QUEUE_free(EXTEND_QUEUE *queue) {
+	size_t i;
+
+	if (queue == NULL) return;
+
+	KSI_AsyncService_free(queue->service);
+
+	if (queue->items != NULL) {
+		for (i = 0; i < queue->capacity; i++) {
+			extend_queue_item_clean(&queue->items[i]);
+		}
+	}
+
+	free(queue->items);
+	free(queue);
+}
+
+int EXTEND_QUEUE_add(EXTEND_QUEUE *queue, KSI_Signature *sig, KSI_PublicationRecord *pubRec, KSI_uint64_t pubTime, void *ctx, void (*ctx_free)(void*)) {
+	int res = KT_UNKNOWN_ERROR;
+	EXTEND_QUEUE_ITEM *item = NULL;
+	KSI_Signature *tmpSig = NULL;
+	KSI_PublicationRecord *tmpRec = NULL;
+
+	if (queue == NULL || sig == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	if (EXTEND_QUEUE_isFull(queue)) {
+		res = KT_INDEX_OVF;
+		goto cleanup;
+	}
+
+	res = KSI_Signature_clone(sig, &tmpSig);
+	if (res != KSI_OK) goto cleanup;
+
+	if (pubRec != NULL) {
+		res = KSI_PublicationRecord_clone(pubRec, &tmpRec);
+		if (res != KSI_OK) goto cleanup;
+	}
+
+	item = extend_queue_get_item(queue, queue->count);
+	item->id = queue->nextId++;
+	item->sig = tmpSig;
+	item->pubRec = tmpRec;
+	item->pubTime = pubTime;
+	item->ctx = ctx;
+	item->ctx_free = ctx_free;
+	item->ext = NULL;
+	item->error = KT_OK;
+	item->isSent = 0;
+	item->isDone = 0;
+	queue->count++;
+	tmpSig = NULL;
+	tmpRec = NULL;
+
+	/* Send the request immediately and process any responses already received. As
+	 * the item is already owned by the queue, failures are reported per request. */
+	res = extend_queue_run(queue);
+	if (res != KT_OK) extend_queue_mark_failed(queue, res);
+
+	res = KT_OK;
+
+cleanup:
+
+	KSI_Signature_free(tmpSig);
+	KSI_PublicationRecord_free(tmpRec);
+
+	return res;
+}
+
+int EXTEND_QUEUE_getNext(EXTEND_QUEUE *queue, int wait, void **ctx, KSI_Signature **ext, int *error) {
+	int res = KT_UNKNOWN_ERROR;
+	EXTEND_QUEUE_ITEM *item = NULL;
+
+	if (queue == NULL || ctx == NULL || ext == NULL || error == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	*ctx = NULL;
+	*ext = NULL;
+	*error = KT_OK;
+
+	if (queue->count == 0) {
+		res = KT_OK;
+		goto cleanup;
+	}
+
+	item = extend_queue_get_item(queue, 0);
+
+	do {
+		res = extend_queue_run(queue);
+		if (res != KT_OK) goto cleanup;
+
+		if (!item->isDone && wait) {
+			struct timespec interval = {0, EXTEND_QUEUE_POLL_INTERVAL_NS};
+			nanosleep(&interval, NULL);
+		}
+	} while (!item->isDone && wait);
+
+	if (!item->isDone) {
+		res = KT_OK;
+		goto cleanup;
+	}
+
+	*ctx = item->ctx;
+	*ext = item->ext;
+	*error = item->error;
+
+	/* Ownership of the user context and signature is passed to the caller. */
+	item->ctx = NULL;
+	item->ctx_free = NULL;
+	item->ext = NULL;
+	extend_queue_item_clean(item);
+
+	queue->first = (queue->first + 1) % queue->capacity;
+	queue->count--;
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
+
+int EXTEND_QUEUE_isFull(EXTEND_QUEUE *queue) {
+	if (queue == NULL) return 0;
+	return queue->count >= queue->capacity;
+}
+
+size_t EXTEND_QUEUE_getCount(EXTEND_QUEUE *queue) {
+	if (queue == NULL) return 0;
+	return queue->count;
+}
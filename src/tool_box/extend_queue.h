@@ -0,0 +1,84 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+#ifndef EXTEND_QUEUE_H
+#define	EXTEND_QUEUE_H
+
+#include <stddef.h>
+#include <ksi/ksi.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+typedef struct EXTEND_QUEUE_st EXTEND_QUEUE;
+
+/**
+ * Creates a queue of non-blocking extending requests on top of libksi asynchronous
+ * extending service. Requests are sent to the extender as soon as they are added
+ * and responses are returned in the same order as the requests were added.
+ * \param ksi			KSI context.
+ * \param url			Extender URL.
+ * \param user			Extender user.
+ * \param key			Extender key.
+ * \param hmacAlg		HMAC algorithm of the requests. If not supported (e.g. KSI_HASHALG_INVALID_VALUE), the default is used.
+ * \param maxPending	Maximum count of requests that can be in the queue at once.
+ * \param queue			Output parameter for the queue.
+ * \return KT_OK if successful, error code otherwise.
+ * \see #TOOL_newExtendQueue to configure the queue from the command line and the configuration file.
+ */
+int EXTEND_QUEUE_new(KSI_CTX *ksi, const char *url, const char *user, const char *key, KSI_HashAlgorithm hmacAlg, size_t maxPending, EXTEND_QUEUE **queue);
+void EXTEND_QUEUE_free(EXTEND_QUEUE *queue);
+
+/**
+ * Adds a new extending request to the end of the queue. When the queue is full
+ * (see #EXTEND_QUEUE_isFull) the request is rejected and at least one response must
+ * be taken from the queue with #EXTEND_QUEUE_getNext.
+ * \param queue			Queue object.
+ * \param sig			KSI signature to be extended. A copy is kept in the queue.
+ * \param pubRec		Publication record to extend to. Can be \c NULL. If set, a copy is attached to the extended signature.
+ * \param pubTime		Publication time to extend to.
+ * \param ctx			User context returned together with the response. Can be \c NULL.
+ * \param ctx_free		Function to free \c ctx if the queue is freed before the response is taken. Can be \c NULL.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int EXTEND_QUEUE_add(EXTEND_QUEUE *queue, KSI_Signature *sig, KSI_PublicationRecord *pubRec, KSI_uint64_t pubTime, void *ctx, void (*ctx_free)(void*));
+
+/**
+ * Takes the response of the oldest request from the queue. If \c wait is set the
+ * function blocks until the response is received, otherwise \c ctx is set to \c NULL
+ * if the oldest request is not answered yet.
+ * \param queue			Queue object.
+ * \param wait			Block until the response of the oldest request is available.
+ * \param ctx			Output parameter for the user context given to #EXTEND_QUEUE_add.
+ * \param ext			Output parameter for the extended KSI signature. Is \c NULL when request failed. The signature is not verified.
+ * \param error			Output parameter for the error code of the failed request. Is KT_OK on success.
+ * \return KT_OK if successful, error code otherwise. Note that failure of a single request
+ * is reported via \c error and does not make the function fail.
+ */
+int EXTEND_QUEUE_getNext(EXTEND_QUEUE *queue, int wait, void **ctx, KSI_Signature **ext, int *error);
+
+int EXTEND_QUEUE_isFull(EXTEND_QUEUE *queue);
+size_t EXTEND_QUEUE_getCount(EXTEND_QUEUE *queue);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* EXTEND_QUEUE_H */
@@ -463,7 +463,7 @@ static int open_log_and_signature_files(PARAM_SET *set, ERR_TRCKR *err, IO_FILES
 		res = SMART_FILE_open("-", "rbs", &tmp.files.inLog);
 		ERR_CATCH_MSG(err, res, "Error: Could not open input log stream.");
 	} else {
-		res = SMART_FILE_open(files->internal.inLog, "rb", &tmp.files.inLog);
+		res = SMART_FILE_open(files->internal.inLog, "rbm", &tmp.files.inLog);
 		ERR_CATCH_MSG(err, res, "Error: Could not open input log file '%s'.", files->internal.inLog);
 	}
 
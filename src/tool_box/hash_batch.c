@@ -0,0 +1,699 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <ksi/ksi.h>
+#include "logksi_err.h"
+#include "hash_batch.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#	include <cpuid.h>
+#	include <immintrin.h>
+#	define HASH_BATCH_X86
+#endif
+
+#define SHA256_BLOCK_SIZE 64
+#define SHA256_DIGEST_SIZE 32
+
+/* Maximum count of messages hashed in parallel by a multi-buffer kernel. */
+#define SHA256_MAX_LANES 16
+
+typedef struct SHA256_KERNEL_st {
+	const char *name;
+
+	/* Count of messages hashed in parallel, 1 for a single buffer kernel. */
+	size_t lanes;
+
+	/* Single buffer kernel, compresses consecutive blocks of a single message. */
+	void (*compress)(uint32_t *state, const unsigned char *blocks, size_t nofBlocks);
+
+	/* Multi-buffer kernel, compresses one block of every lane. Block words are already in host byte order. */
+	void (*compressLanes)(uint32_t state[8][SHA256_MAX_LANES], uint32_t w[16][SHA256_MAX_LANES]);
+} SHA256_KERNEL;
+
+struct HASH_BATCH_st {
+	KSI_CTX *ksi;
+	int isOwnCtx;
+	const SHA256_KERNEL *single;
+	const SHA256_KERNEL *lanes;
+	char kernelName[32];
+	KSI_DataHasher *hasher;
+	KSI_HashAlgorithm algo;
+	unsigned char *digests;
+	size_t digests_capacity;
+};
+
+static const uint32_t sha256_k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const uint32_t sha256_h0[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+static uint32_t sha256_load_be32(const unsigned char *p) {
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static void sha256_store_be32(unsigned char *p, uint32_t v) {
+	p[0] = (unsigned char)(v >> 24);
+	p[1] = (unsigned char)(v >> 16);
+	p[2] = (unsigned char)(v >> 8);
+	p[3] = (unsigned char)v;
+}
+
+/* Count of blocks of the padded message (0x80, zeros and 64-bit length in bits). */
+static size_t sha256_nof_blocks(size_t len) {
+	return (len + 8) / SHA256_BLOCK_SIZE + 1;
+}
+
+/* Returns the block with index i of the padded message. Tail blocks are built into the pad buffer. */
+static const unsigned char *sha256_get_block(const unsigned char *data, size_t len, size_t i, unsigned char *pad) {
+	size_t offset = i * SHA256_BLOCK_SIZE;
+	uint64_t bits = (uint64_t)len * 8;
+	int j;
+
+	if (offset + SHA256_BLOCK_SIZE <= len) return data + offset;
+
+	memset(pad, 0, SHA256_BLOCK_SIZE);
+	if (offset < len) memcpy(pad, data + offset, len - offset);
+	if (offset <= len) pad[len - offset] = 0x80;
+
+	if (i + 1 == sha256_nof_blocks(len)) {
+		for (j = 0; j < 8; j++) pad[SHA256_BLOCK_SIZE - 1 - j] = (unsigned char)(bits >> (8 * j));
+	}
+
+	return pad;
+}
+
+#define SHA256_ROR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void sha256_generic_compress(uint32_t *state, const unsigned char *blocks, size_t nofBlocks) {
+	uint32_t w[64];
+	uint32_t a, b, c, d, e, f, g, h;
+	size_t t;
+
+	while (nofBlocks-- > 0) {
+		for (t = 0; t < 16; t++) w[t] = sha256_load_be32(blocks + 4 * t);
+
+		for (t = 16; t < 64; t++) {
+			uint32_t s0 = SHA256_ROR(w[t - 15], 7) ^ SHA256_ROR(w[t - 15], 18) ^ (w[t - 15] >> 3);
+			uint32_t s1 = SHA256_ROR(w[t - 2], 17) ^ SHA256_ROR(w[t - 2], 19) ^ (w[t - 2] >> 10);
+			w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+		}
+
+		a = state[0];
+		b = state[1];
+		c = state[2];
+		d = state[3];
+		e = state[4];
+		f = state[5];
+		g = state[6];
+		h = state[7];
+
+		for (t = 0; t < 64; t++) {
+			uint32_t t1 = h + (SHA256_ROR(e, 6) ^ SHA256_ROR(e, 11) ^ SHA256_ROR(e, 25)) + ((e & f) ^ (~e & g)) + sha256_k[t] + w[t];
+			uint32_t t2 = (SHA256_ROR(a, 2) ^ SHA256_ROR(a, 13) ^ SHA256_ROR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+
+			h = g;
+			g = f;
+			f = e;
+			e = d + t1;
+			d = c;
+			c = b;
+			b = a;
+			a = t1 + t2;
+		}
+
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+		state[4] += e;
+		state[5] += f;
+		state[6] += g;
+		state[7] += h;
+		blocks += SHA256_BLOCK_SIZE;
+	}
+}
+
+/* Portable kernel is used only for single digests, batches fall back to libksi instead (unless forced, see HASH_BATCH_setKernel). */
+static const SHA256_KERNEL sha256_kernel_generic = {"generic", 1, sha256_generic_compress, NULL};
+
+#ifdef HASH_BATCH_X86
+
+#define SHA256_TARGET_SHANI __attribute__((target("sha,sse4.1")))
+#define SHA256_TARGET_AVX2 __attribute__((target("avx2")))
+#define SHA256_TARGET_AVX512 __attribute__((target("avx512f")))
+
+SHA256_TARGET_SHANI
+static void sha256_shani_compress(uint32_t *state, const unsigned char *blocks, size_t nofBlocks) {
+	const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+	__m128i state0, state1, abef, cdgh, msg, tmp;
+	__m128i w[16];
+	size_t i;
+
+	/* Rounds instruction expects the state as ABEF and CDGH. */
+	tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[0]), 0xB1);
+	state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[4]), 0x1B);
+	state0 = _mm_alignr_epi8(tmp, state1, 8);
+	state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+	while (nofBlocks-- > 0) {
+		abef = state0;
+		cdgh = state1;
+
+		for (i = 0; i < 4; i++) {
+			w[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(blocks + 16 * i)), mask);
+		}
+
+		for (i = 4; i < 16; i++) {
+			tmp = _mm_sha256msg1_epu32(w[i - 4], w[i - 3]);
+			tmp = _mm_add_epi32(tmp, _mm_alignr_epi8(w[i - 1], w[i - 2], 4));
+			w[i] = _mm_sha256msg2_epu32(tmp, w[i - 1]);
+		}
+
+		for (i = 0; i < 16; i++) {
+			msg = _mm_add_epi32(w[i], _mm_loadu_si128((const __m128i*)&sha256_k[4 * i]));
+			state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+			msg = _mm_shuffle_epi32(msg, 0x0E);
+			state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+		}
+
+		state0 = _mm_add_epi32(state0, abef);
+		state1 = _mm_add_epi32(state1, cdgh);
+		blocks += SHA256_BLOCK_SIZE;
+	}
+
+	tmp = _mm_shuffle_epi32(state0, 0x1B);
+	state1 = _mm_shuffle_epi32(state1, 0xB1);
+	state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+	state1 = _mm_alignr_epi8(state1, tmp, 8);
+
+	_mm_storeu_si128((__m128i*)&state[0], state0);
+	_mm_storeu_si128((__m128i*)&state[4], state1);
+}
+
+#define SHA256_AVX2_ROR(x, n) _mm256_or_si256(_mm256_srli_epi32((x), (n)), _mm256_slli_epi32((x), 32 - (n)))
+#define SHA256_AVX2_XOR3(x, y, z) _mm256_xor_si256(_mm256_xor_si256((x), (y)), (z))
+
+SHA256_TARGET_AVX2
+static void sha256_avx2_compress_lanes(uint32_t state[8][SHA256_MAX_LANES], uint32_t w[16][SHA256_MAX_LANES]) {
+	__m256i a, b, c, d, e, f, g, h;
+	__m256i W[16];
+	size_t t;
+
+	a = _mm256_loadu_si256((const __m256i*)state[0]);
+	b = _mm256_loadu_si256((const __m256i*)state[1]);
+	c = _mm256_loadu_si256((const __m256i*)state[2]);
+	d = _mm256_loadu_si256((const __m256i*)state[3]);
+	e = _mm256_loadu_si256((const __m256i*)state[4]);
+	f = _mm256_loadu_si256((const __m256i*)state[5]);
+	g = _mm256_loadu_si256((const __m256i*)state[6]);
+	h = _mm256_loadu_si256((const __m256i*)state[7]);
+
+	for (t = 0; t < 16; t++) W[t] = _mm256_loadu_si256((const __m256i*)w[t]);
+
+	for (t = 0; t < 64; t++) {
+		__m256i t1, t2;
+
+		if (t >= 16) {
+			__m256i w2 = W[(t - 2) & 15];
+			__m256i w15 = W[(t - 15) & 15];
+			__m256i s0 = SHA256_AVX2_XOR3(SHA256_AVX2_ROR(w15, 7), SHA256_AVX2_ROR(w15, 18), _mm256_srli_epi32(w15, 3));
+			__m256i s1 = SHA256_AVX2_XOR3(SHA256_AVX2_ROR(w2, 17), SHA256_AVX2_ROR(w2, 19), _mm256_srli_epi32(w2, 10));
+
+			W[t & 15] = _mm256_add_epi32(_mm256_add_epi32(W[t & 15], s0), _mm256_add_epi32(W[(t - 7) & 15], s1));
+		}
+
+		t1 = _mm256_add_epi32(h, SHA256_AVX2_XOR3(SHA256_AVX2_ROR(e, 6), SHA256_AVX2_ROR(e, 11), SHA256_AVX2_ROR(e, 25)));
+		t1 = _mm256_add_epi32(t1, _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g)));
+		t1 = _mm256_add_epi32(t1, _mm256_add_epi32(_mm256_set1_epi32((int)sha256_k[t]), W[t & 15]));
+		t2 = SHA256_AVX2_XOR3(SHA256_AVX2_ROR(a, 2), SHA256_AVX2_ROR(a, 13), SHA256_AVX2_ROR(a, 22));
+		t2 = _mm256_add_epi32(t2, _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b))));
+
+		h = g;
+		g = f;
+		f = e;
+		e = _mm256_add_epi32(d, t1);
+		d = c;
+		c = b;
+		b = a;
+		a = _mm256_add_epi32(t1, t2);
+	}
+
+	_mm256_storeu_si256((__m256i*)state[0], _mm256_add_epi32(a, _mm256_loadu_si256((const __m256i*)state[0])));
+	_mm256_storeu_si256((__m256i*)state[1], _mm256_add_epi32(b, _mm256_loadu_si256((const __m256i*)state[1])));
+	_mm256_storeu_si256((__m256i*)state[2], _mm256_add_epi32(c, _mm256_loadu_si256((const __m256i*)state[2])));
+	_mm256_storeu_si256((__m256i*)state[3], _mm256_add_epi32(d, _mm256_loadu_si256((const __m256i*)state[3])));
+	_mm256_storeu_si256((__m256i*)state[4], _mm256_add_epi32(e, _mm256_loadu_si256((const __m256i*)state[4])));
+	_mm256_storeu_si256((__m256i*)state[5], _mm256_add_epi32(f, _mm256_loadu_si256((const __m256i*)state[5])));
+	_mm256_storeu_si256((__m256i*)state[6], _mm256_add_epi32(g, _mm256_loadu_si256((const __m256i*)state[6])));
+	_mm256_storeu_si256((__m256i*)state[7], _mm256_add_epi32(h, _mm256_loadu_si256((const __m256i*)state[7])));
+}
+
+#define SHA256_AVX512_XOR3(x, y, z) _mm512_ternarylogic_epi32((x), (y), (z), 0x96)
+
+SHA256_TARGET_AVX512
+static void sha256_avx512_compress_lanes(uint32_t state[8][SHA256_MAX_LANES], uint32_t w[16][SHA256_MAX_LANES]) {
+	__m512i a, b, c, d, e, f, g, h;
+	__m512i W[16];
+	size_t t;
+
+	a = _mm512_loadu_si512(state[0]);
+	b = _mm512_loadu_si512(state[1]);
+	c = _mm512_loadu_si512(state[2]);
+	d = _mm512_loadu_si512(state[3]);
+	e = _mm512_loadu_si512(state[4]);
+	f = _mm512_loadu_si512(state[5]);
+	g = _mm512_loadu_si512(state[6]);
+	h = _mm512_loadu_si512(state[7]);
+
+	for (t = 0; t < 16; t++) W[t] = _mm512_loadu_si512(w[t]);
+
+	for (t = 0; t < 64; t++) {
+		__m512i t1, t2;
+
+		if (t >= 16) {
+			__m512i w2 = W[(t - 2) & 15];
+			__m512i w15 = W[(t - 15) & 15];
+			__m512i s0 = SHA256_AVX512_XOR3(_mm512_ror_epi32(w15, 7), _mm512_ror_epi32(w15, 18), _mm512_srli_epi32(w15, 3));
+			__m512i s1 = SHA256_AVX512_XOR3(_mm512_ror_epi32(w2, 17), _mm512_ror_epi32(w2, 19), _mm512_srli_epi32(w2, 10));
+
+			W[t & 15] = _mm512_add_epi32(_mm512_add_epi32(W[t & 15], s0), _mm512_add_epi32(W[(t - 7) & 15], s1));
+		}
+
+		/* Ternary logic 0xCA is (e ? f : g) and 0xE8 is majority of a, b and c. */
+		t1 = _mm512_add_epi32(h, SHA256_AVX512_XOR3(_mm512_ror_epi32(e, 6), _mm512_ror_epi32(e, 11), _mm512_ror_epi32(e, 25)));
+		t1 = _mm512_add_epi32(t1, _mm512_ternarylogic_epi32(e, f, g, 0xCA));
+		t1 = _mm512_add_epi32(t1, _mm512_add_epi32(_mm512_set1_epi32((int)sha256_k[t]), W[t & 15]));
+		t2 = SHA256_AVX512_XOR3(_mm512_ror_epi32(a, 2), _mm512_ror_epi32(a, 13), _mm512_ror_epi32(a, 22));
+		t2 = _mm512_add_epi32(t2, _mm512_ternarylogic_epi32(a, b, c, 0xE8));
+
+		h = g;
+		g = f;
+		f = e;
+		e = _mm512_add_epi32(d, t1);
+		d = c;
+		c = b;
+		b = a;
+		a = _mm512_add_epi32(t1, t2);
+	}
+
+	_mm512_storeu_si512(state[0], _mm512_add_epi32(a, _mm512_loadu_si512(state[0])));
+	_mm512_storeu_si512(state[1], _mm512_add_epi32(b, _mm512_loadu_si512(state[1])));
+	_mm512_storeu_si512(state[2], _mm512_add_epi32(c, _mm512_loadu_si512(state[2])));
+	_mm512_storeu_si512(state[3], _mm512_add_epi32(d, _mm512_loadu_si512(state[3])));
+	_mm512_storeu_si512(state[4], _mm512_add_epi32(e, _mm512_loadu_si512(state[4])));
+	_mm512_storeu_si512(state[5], _mm512_add_epi32(f, _mm512_loadu_si512(state[5])));
+	_mm512_storeu_si512(state[6], _mm512_add_epi32(g, _mm512_loadu_si512(state[6])));
+	_mm512_storeu_si512(state[7], _mm512_add_epi32(h, _mm512_loadu_si512(state[7])));
+}
+
+static const SHA256_KERNEL sha256_kernel_shani = {"sha-ni", 1, sha256_shani_compress, NULL};
+static const SHA256_KERNEL sha256_kernel_avx512 = {"avx512", 16, NULL, sha256_avx512_compress_lanes};
+static const SHA256_KERNEL sha256_kernel_avx2 = {"avx2", 8, NULL, sha256_avx2_compress_lanes};
+
+#endif
+
+/* Maximum count of kernels that can be supported by the CPU. */
+#define SHA256_MAX_KERNELS 4
+
+/* Finds the kernels supported by the CPU, in the order of preference. The generic kernel is always the last one. */
+static size_t sha256_find_kernels(const SHA256_KERNEL **kernels) {
+	size_t count = 0;
+
+#ifdef HASH_BATCH_X86
+	unsigned int eax = 0;
+	unsigned int ebx = 0;
+	unsigned int ecx = 0;
+	unsigned int edx = 0;
+	unsigned int xcr0 = 0;
+	int hasSse41 = 0;
+
+	if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+		hasSse41 = (ecx >> 19) & 1;
+
+		/* AVX registers can be used only if the OS saves them (see XGETBV). */
+		if ((ecx >> 27) & 1) {
+			unsigned int xcr0_high = 0;
+			__asm__ __volatile__("xgetbv" : "=a"(xcr0), "=d"(xcr0_high) : "c"(0));
+		}
+
+		if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+			if (((ebx >> 29) & 1) && hasSse41) kernels[count++] = &sha256_kernel_shani;
+			if (((ebx >> 16) & 1) && (xcr0 & 0xE6) == 0xE6) kernels[count++] = &sha256_kernel_avx512;
+			if (((ebx >> 5) & 1) && (xcr0 & 0x06) == 0x06) kernels[count++] = &sha256_kernel_avx2;
+		}
+	}
+#endif
+
+	kernels[count++] = &sha256_kernel_generic;
+
+	return count;
+}
+
+static pthread_once_t sha256_kernels_once = PTHREAD_ONCE_INIT;
+static const SHA256_KERNEL *sha256_kernels[SHA256_MAX_KERNELS];
+static size_t sha256_kernels_count = 0;
+static const SHA256_KERNEL *sha256_single = NULL;
+static const SHA256_KERNEL *sha256_lanes = NULL;
+
+static void sha256_init_kernels(void) {
+	size_t i;
+
+	sha256_kernels_count = sha256_find_kernels(sha256_kernels);
+
+	/* The generic kernel is not selected for batches, libksi is used instead. */
+	for (i = 0; i < sha256_kernels_count; i++) {
+		const SHA256_KERNEL *kernel = sha256_kernels[i];
+
+		if (kernel->lanes > 1) {
+			if (sha256_lanes == NULL) sha256_lanes = kernel;
+		} else if (kernel != &sha256_kernel_generic) {
+			if (sha256_single == NULL) sha256_single = kernel;
+		}
+	}
+}
+
+static void hash_batch_set_kernels(HASH_BATCH *batch, const SHA256_KERNEL *single, const SHA256_KERNEL *lanes) {
+	batch->single = single;
+	batch->lanes = lanes;
+
+	if (single != NULL && lanes != NULL) {
+		KSI_snprintf(batch->kernelName, sizeof(batch->kernelName), "%s+%s", lanes->name, single->name);
+	} else if (single != NULL || lanes != NULL) {
+		KSI_snprintf(batch->kernelName, sizeof(batch->kernelName), "%s", (single != NULL) ? single->name : lanes->name);
+	} else {
+		KSI_snprintf(batch->kernelName, sizeof(batch->kernelName), "libksi");
+	}
+}
+
+static void sha256_digest_single(const SHA256_KERNEL *kernel, const unsigned char *data, size_t len, unsigned char *digest) {
+	uint32_t state[8];
+	unsigned char pad[SHA256_BLOCK_SIZE];
+	size_t nofBlocks = sha256_nof_blocks(len);
+	size_t i;
+
+	memcpy(state, sha256_h0, sizeof(state));
+
+	/* Full blocks are hashed directly from the data, only the tail is copied. */
+	if (len >= SHA256_BLOCK_SIZE) kernel->compress(state, data, len / SHA256_BLOCK_SIZE);
+
+	for (i = len / SHA256_BLOCK_SIZE; i < nofBlocks; i++) {
+		kernel->compress(state, sha256_get_block(data, len, i, pad), 1);
+	}
+
+	for (i = 0; i < 8; i++) sha256_store_be32(digest + 4 * i, state[i]);
+}
+
+/* Every lane hashes its own message. When a message is finished, the lane continues with the next one. */
+static void sha256_digest_lanes(const SHA256_KERNEL *kernel, const unsigned char * const *data, const size_t *data_len, size_t count, unsigned char *digests) {
+	uint32_t state[8][SHA256_MAX_LANES];
+	uint32_t w[16][SHA256_MAX_LANES];
+	unsigned char pad[SHA256_MAX_LANES][SHA256_BLOCK_SIZE];
+	size_t msg[SHA256_MAX_LANES];
+	size_t block[SHA256_MAX_LANES];
+	int isActive[SHA256_MAX_LANES];
+	size_t nofActive = 0;
+	size_t next = 0;
+	size_t lane;
+	size_t i;
+
+	memset(w, 0, sizeof(w));
+
+	for (lane = 0; lane < kernel->lanes; lane++) {
+		isActive[lane] = 0;
+		if (next >= count) continue;
+
+		msg[lane] = next++;
+		block[lane] = 0;
+		for (i = 0; i < 8; i++) state[i][lane] = sha256_h0[i];
+		isActive[lane] = 1;
+		nofActive++;
+	}
+
+	while (nofActive > 0) {
+		for (lane = 0; lane < kernel->lanes; lane++) {
+			const unsigned char *p = NULL;
+
+			if (!isActive[lane]) continue;
+
+			p = sha256_get_block(data[msg[lane]], data_len[msg[lane]], block[lane], pad[lane]);
+			for (i = 0; i < 16; i++) w[i][lane] = sha256_load_be32(p + 4 * i);
+		}
+
+		/* Idle lanes are hashed too, but their state is never used. */
+		kernel->compressLanes(state, w);
+
+		for (lane = 0; lane < kernel->lanes; lane++) {
+			if (!isActive[lane]) continue;
+
+			block[lane]++;
+			if (block[lane] < sha256_nof_blocks(data_len[msg[lane]])) continue;
+
+			for (i = 0; i < 8; i++) sha256_store_be32(digests + msg[lane] * SHA256_DIGEST_SIZE + 4 * i, state[i][lane]);
+
+			isActive[lane] = 0;
+			nofActive--;
+
+			if (next < count) {
+				msg[lane] = next++;
+				block[lane] = 0;
+				for (i = 0; i < 8; i++) state[i][lane] = sha256_h0[i];
+				isActive[lane] = 1;
+				nofActive++;
+			}
+		}
+	}
+}
+
+static int hash_batch_calculate_sha256(HASH_BATCH *batch, const SHA256_KERNEL *kernel, const unsigned char * const *data, const size_t *data_len, size_t count, KSI_DataHash **hashes) {
+	int res = KT_UNKNOWN_ERROR;
+	size_t i;
+
+	if (count * SHA256_DIGEST_SIZE > batch->digests_capacity) {
+		unsigned char *tmp = (unsigned char*)realloc(batch->digests, count * SHA256_DIGEST_SIZE);
+		if (tmp == NULL) {
+			res = KT_OUT_OF_MEMORY;
+			goto cleanup;
+		}
+
+		batch->digests = tmp;
+		batch->digests_capacity = count * SHA256_DIGEST_SIZE;
+	}
+
+	if (kernel->lanes > 1) {
+		sha256_digest_lanes(kernel, data, data_len, count, batch->digests);
+	} else {
+		for (i = 0; i < count; i++) {
+			sha256_digest_single(kernel, data[i], data_len[i], batch->digests + i * SHA256_DIGEST_SIZE);
+		}
+	}
+
+	for (i = 0; i < count; i++) {
+		res = KSI_DataHash_fromDigest(batch->ksi, KSI_HASHALG_SHA2_256, batch->digests + i * SHA256_DIGEST_SIZE, SHA256_DIGEST_SIZE, &hashes[i]);
+		if (res != KSI_OK) goto cleanup;
+	}
+
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
+
+static int hash_batch_calculate_libksi(HASH_BATCH *batch, KSI_HashAlgorithm algo, const unsigned char * const *data, const size_t *data_len, size_t count, KSI_DataHash **hashes) {
+	int res = KT_UNKNOWN_ERROR;
+	size_t i;
+
+	if (batch->hasher == NULL || batch->algo != algo) {
+		KSI_DataHasher_free(batch->hasher);
+		batch->hasher = NULL;
+
+		res = KSI_DataHasher_open(batch->ksi, algo, &batch->hasher);
+		if (res != KSI_OK) goto cleanup;
+
+		batch->algo = algo;
+	}
+
+	for (i = 0; i < count; i++) {
+		res = KSI_DataHasher_reset(batch->hasher);
+		if (res != KSI_OK) goto cleanup;
+
+		res = KSI_DataHasher_add(batch->hasher, data[i], data_len[i]);
+		if (res != KSI_OK) goto cleanup;
+
+		res = KSI_DataHasher_close(batch->hasher, &hashes[i]);
+		if (res != KSI_OK) goto cleanup;
+	}
+
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
+
+int HASH_BATCH_new(KSI_CTX *ksi, HASH_BATCH **batch) {
+	int res = KT_UNKNOWN_ERROR;
+	HASH_BATCH *tmp = NULL;
+
+	if (batch == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	tmp = (HASH_BATCH*)malloc(sizeof(HASH_BATCH));
+	if (tmp == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	tmp->ksi = ksi;
+	tmp->isOwnCtx = 0;
+	pthread_once(&sha256_kernels_once, sha256_init_kernels);
+	hash_batch_set_kernels(tmp, sha256_single, sha256_lanes);
+	tmp->hasher = NULL;
+	tmp->algo = KSI_HASHALG_INVALID_VALUE;
+	tmp->digests = NULL;
+	tmp->digests_capacity = 0;
+
+	if (tmp->ksi == NULL) {
+		res = KSI_CTX_new(&tmp->ksi);
+		if (res != KSI_OK) goto cleanup;
+
+		tmp->isOwnCtx = 1;
+	}
+
+	*batch = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	HASH_BATCH_free(tmp);
+
+	return res;
+}
+
+void HASH_BATCH_free(HASH_BATCH *batch) {
+	if (batch == NULL) return;
+
+	KSI_DataHasher_free(batch->hasher);
+	if (batch->isOwnCtx) KSI_CTX_free(batch->ksi);
+	free(batch->digests);
+	free(batch);
+}
+
+int HASH_BATCH_calculate(HASH_BATCH *batch, KSI_HashAlgorithm algo, const unsigned char * const *data, const size_t *data_len, size_t count, KSI_DataHash **hashes) {
+	int res = KT_UNKNOWN_ERROR;
+	const SHA256_KERNEL *kernel = NULL;
+	size_t i;
+
+	if (batch == NULL || (count > 0 && (data == NULL || data_len == NULL || hashes == NULL))) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	for (i = 0; i < count; i++) {
+		if (data[i] == NULL && data_len[i] > 0) {
+			res = KT_INVALID_ARGUMENT;
+			goto cleanup;
+		}
+
+		hashes[i] = NULL;
+	}
+
+	/* Multi-buffer kernel pays off only if at least half of the lanes are used. */
+	if (algo == KSI_HASHALG_SHA2_256) {
+		if (batch->lanes != NULL && count >= batch->lanes->lanes / 2) kernel = batch->lanes;
+		else kernel = batch->single;
+	}
+
+	if (kernel != NULL) {
+		res = hash_batch_calculate_sha256(batch, kernel, data, data_len, count, hashes);
+	} else {
+		res = hash_batch_calculate_libksi(batch, algo, data, data_len, count, hashes);
+	}
+	if (res != KT_OK) goto cleanup;
+
+	res = KT_OK;
+
+cleanup:
+
+	if (res != KT_OK && res != KT_INVALID_ARGUMENT) {
+		for (i = 0; i < count; i++) {
+			KSI_DataHash_free(hashes[i]);
+			hashes[i] = NULL;
+		}
+	}
+
+	return res;
+}
+
+int HASH_BATCH_sha256(const unsigned char *data, size_t data_len, unsigned char *digest) {
+	if ((data == NULL && data_len > 0) || digest == NULL) return KT_INVALID_ARGUMENT;
+
+	pthread_once(&sha256_kernels_once, sha256_init_kernels);
+	sha256_digest_single((sha256_single != NULL) ? sha256_single : &sha256_kernel_generic, data, data_len, digest);
+
+	return KT_OK;
+}
+
+const char *HASH_BATCH_getKernelName(HASH_BATCH *batch) {
+	if (batch == NULL) return "libksi";
+	return batch->kernelName;
+}
+
+int HASH_BATCH_setKernel(HASH_BATCH *batch, const char *name) {
+	size_t i;
+
+	if (batch == NULL || name == NULL) return KT_INVALID_ARGUMENT;
+
+	if (strcmp(name, "libksi") == 0) {
+		hash_batch_set_kernels(batch, NULL, NULL);
+		return KT_OK;
+	}
+
+	pthread_once(&sha256_kernels_once, sha256_init_kernels);
+
+	for (i = 0; i < sha256_kernels_count; i++) {
+		const SHA256_KERNEL *kernel = sha256_kernels[i];
+
+		if (strcmp(name, kernel->name) != 0) continue;
+
+		if (kernel->lanes > 1) hash_batch_set_kernels(batch, NULL, kernel);
+		else hash_batch_set_kernels(batch, kernel, NULL);
+
+		return KT_OK;
+	}
+
+	return KT_INVALID_ARGUMENT;
+}
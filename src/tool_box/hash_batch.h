@@ -0,0 +1,90 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+#ifndef HASH_BATCH_H
+#define	HASH_BATCH_H
+
+#include <stddef.h>
+#include <ksi/ksi.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+typedef struct HASH_BATCH_st HASH_BATCH;
+
+/**
+ * Creates a hasher that calculates hashes of many independent messages at once.
+ * SHA-256 is calculated with the fastest kernel supported by the CPU (SHA
+ * extensions, AVX-512 or AVX2 multi-buffer), other algorithms and CPUs without
+ * these extensions are hashed one by one with the libksi hasher. The object
+ * must not be shared between threads.
+ * \param ksi			KSI context. If \c NULL, an own context is created.
+ * \param batch			Output parameter for the hasher.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int HASH_BATCH_new(KSI_CTX *ksi, HASH_BATCH **batch);
+void HASH_BATCH_free(HASH_BATCH *batch);
+
+/**
+ * Calculates the hashes of \c count messages.
+ * \param batch			Hasher object.
+ * \param algo			Hash algorithm.
+ * \param data			Array of \c count pointers to the messages.
+ * \param data_len		Array of \c count message lengths.
+ * \param count			Count of messages.
+ * \param hashes		Array of \c count output parameters for the hashes. If
+ * 						the function fails, all hashes are freed and set to \c NULL.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int HASH_BATCH_calculate(HASH_BATCH *batch, KSI_HashAlgorithm algo, const unsigned char * const *data, const size_t *data_len, size_t count, KSI_DataHash **hashes);
+
+/**
+ * Calculates the SHA-256 digest of a single message without allocating memory.
+ * The SHA extensions are used if available, a portable implementation otherwise.
+ * The function is thread safe.
+ * \param data			Message.
+ * \param data_len		Length of the message.
+ * \param digest		Output buffer of 32 bytes for the digest.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int HASH_BATCH_sha256(const unsigned char *data, size_t data_len, unsigned char *digest);
+
+/**
+ * Returns the name of the SHA-256 kernel selected for the CPU, e.g. "avx2".
+ * If no kernel is supported, "libksi" is returned.
+ */
+const char *HASH_BATCH_getKernelName(HASH_BATCH *batch);
+
+/**
+ * Forces the hasher to use a single SHA-256 kernel, e.g. to test every kernel
+ * supported by the CPU. Batches too small for a multi-buffer kernel (less than
+ * half of the lanes used) are hashed with libksi.
+ * \param batch			Hasher object.
+ * \param name			Kernel name: "generic", "sha-ni", "avx2", "avx512" or "libksi".
+ * \return KT_OK if successful, KT_INVALID_ARGUMENT if the kernel is unknown or
+ * not supported by the CPU.
+ */
+int HASH_BATCH_setKernel(HASH_BATCH *batch, const char *name);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* HASH_BATCH_H */
@@ -0,0 +1,405 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <ksi/ksi.h>
+#include "logksi_err.h"
+#include "hash_batch.h"
+#include "hash_pool.h"
+
+/* Count of items a worker takes from a job at once. */
+#define HASH_POOL_CHUNK_SIZE 64
+
+typedef struct HASH_POOL_WORKER_st {
+	HASH_POOL *pool;
+	pthread_t thread;
+	int isStarted;
+	HASH_BATCH *hasher;
+} HASH_POOL_WORKER;
+
+struct HASH_JOB_st {
+	KSI_HashAlgorithm algo;
+	unsigned char *data;
+	size_t data_len;
+	size_t data_capacity;
+	size_t *offset;
+	size_t *len;
+	const unsigned char **ref;	/* Data that is not copied into the job, NULL for copied items. */
+	KSI_DataHash **hashes;
+	size_t capacity;
+	size_t count;
+
+	/* Following fields are protected by the pool mutex. */
+	size_t taken;
+	size_t done;
+	int error;
+	int isSubmitted;			/* Job that is not submitted is not waited for. */
+	HASH_JOB *next;
+};
+
+struct HASH_POOL_st {
+	pthread_mutex_t mutex;
+	pthread_cond_t workAvailable;
+	pthread_cond_t workDone;
+	HASH_JOB *first;
+	HASH_JOB *last;
+	int stop;
+	HASH_POOL_WORKER *workers;
+	size_t nofWorkers;
+};
+
+static int hash_pool_worker_hash(HASH_POOL_WORKER *worker, HASH_JOB *job, size_t from, size_t to) {
+	const unsigned char *data[HASH_POOL_CHUNK_SIZE];
+	size_t i;
+
+	for (i = from; i < to; i++) {
+		data[i - from] = (job->ref[i] != NULL) ? job->ref[i] : job->data + job->offset[i];
+	}
+
+	/* Whole chunk is hashed at once, so that SHA-256 can be calculated with multi-buffer kernel. */
+	return HASH_BATCH_calculate(worker->hasher, job->algo, data, job->len + from, to - from, job->hashes + from);
+}
+
+static void *hash_pool_worker_run(void *arg) {
+	HASH_POOL_WORKER *worker = arg;
+	HASH_POOL *pool = worker->pool;
+
+	while (1) {
+		HASH_JOB *job = NULL;
+		size_t from = 0;
+		size_t to = 0;
+		int res;
+
+		pthread_mutex_lock(&pool->mutex);
+
+		while (!pool->stop && pool->first == NULL) {
+			pthread_cond_wait(&pool->workAvailable, &pool->mutex);
+		}
+
+		if (pool->stop) {
+			pthread_mutex_unlock(&pool->mutex);
+			break;
+		}
+
+		job = pool->first;
+		from = job->taken;
+		to = (job->count - from > HASH_POOL_CHUNK_SIZE) ? from + HASH_POOL_CHUNK_SIZE : job->count;
+		job->taken = to;
+
+		/* All items of the job are taken, remove it from the list. */
+		if (job->taken == job->count) {
+			pool->first = job->next;
+			if (pool->first == NULL) pool->last = NULL;
+			job->next = NULL;
+		}
+
+		pthread_mutex_unlock(&pool->mutex);
+
+		res = hash_pool_worker_hash(worker, job, from, to);
+
+		pthread_mutex_lock(&pool->mutex);
+
+		if (res != KT_OK && job->error == KT_OK) job->error = res;
+		job->done += to - from;
+		if (job->done == job->count) pthread_cond_broadcast(&pool->workDone);
+
+		pthread_mutex_unlock(&pool->mutex);
+	}
+
+	return NULL;
+}
+
+int HASH_POOL_new(size_t nofThreads, HASH_POOL **pool) {
+	int res = KT_UNKNOWN_ERROR;
+	HASH_POOL *tmp = NULL;
+	size_t i;
+
+	if (nofThreads == 0 || pool == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	tmp = (HASH_POOL*)malloc(sizeof(HASH_POOL));
+	if (tmp == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	pthread_mutex_init(&tmp->mutex, NULL);
+	pthread_cond_init(&tmp->workAvailable, NULL);
+	pthread_cond_init(&tmp->workDone, NULL);
+	tmp->first = NULL;
+	tmp->last = NULL;
+	tmp->stop = 0;
+	tmp->nofWorkers = nofThreads;
+
+	tmp->workers = (HASH_POOL_WORKER*)calloc(nofThreads, sizeof(HASH_POOL_WORKER));
+	if (tmp->workers == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	for (i = 0; i < nofThreads; i++) {
+		tmp->workers[i].pool = tmp;
+		tmp->workers[i].hasher = NULL;
+
+		/* Every worker has its own KSI context, as it is not thread safe. */
+		res = HASH_BATCH_new(NULL, &tmp->workers[i].hasher);
+		if (res != KT_OK) goto cleanup;
+
+		if (pthread_create(&tmp->workers[i].thread, NULL, hash_pool_worker_run, &tmp->workers[i]) != 0) {
+			res = KT_UNKNOWN_ERROR;
+			goto cleanup;
+		}
+
+		tmp->workers[i].isStarted = 1;
+	}
+
+	*pool = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	HASH_POOL_free(tmp);
+
+	return res;
+}
+
+void HASH_POOL_free(HASH_POOL *pool) {
+	size_t i;
+
+	if (pool == NULL) return;
+
+	if (pool->workers != NULL) {
+		pthread_mutex_lock(&pool->mutex);
+		pool->stop = 1;
+		pthread_cond_broadcast(&pool->workAvailable);
+		pthread_mutex_unlock(&pool->mutex);
+
+		for (i = 0; i < pool->nofWorkers; i++) {
+			if (pool->workers[i].isStarted) pthread_join(pool->workers[i].thread, NULL);
+			HASH_BATCH_free(pool->workers[i].hasher);
+		}
+	}
+
+	pthread_cond_destroy(&pool->workDone);
+	pthread_cond_destroy(&pool->workAvailable);
+	pthread_mutex_destroy(&pool->mutex);
+	free(pool->workers);
+	free(pool);
+}
+
+int HASH_POOL_submit(HASH_POOL *pool, HASH_JOB *job) {
+	if (pool == NULL || job == NULL) return KT_INVALID_ARGUMENT;
+
+	pthread_mutex_lock(&pool->mutex);
+
+	job->taken = 0;
+	job->done = 0;
+	job->error = KT_OK;
+	job->isSubmitted = 1;
+	job->next = NULL;
+
+	/* Empty job is finished immediately. */
+	if (job->count > 0) {
+		if (pool->last != NULL) pool->last->next = job;
+		else pool->first = job;
+		pool->last = job;
+
+		pthread_cond_broadcast(&pool->workAvailable);
+	}
+
+	pthread_mutex_unlock(&pool->mutex);
+
+	return KT_OK;
+}
+
+int HASH_POOL_wait(HASH_POOL *pool, HASH_JOB *job) {
+	int res;
+
+	if (pool == NULL || job == NULL) return KT_INVALID_ARGUMENT;
+
+	pthread_mutex_lock(&pool->mutex);
+
+	while (job->isSubmitted && job->done < job->count) {
+		pthread_cond_wait(&pool->workDone, &pool->mutex);
+	}
+
+	res = job->error;
+
+	pthread_mutex_unlock(&pool->mutex);
+
+	return res;
+}
+
+int HASH_JOB_new(KSI_HashAlgorithm algo, size_t maxCount, HASH_JOB **job) {
+	int res = KT_UNKNOWN_ERROR;
+	HASH_JOB *tmp = NULL;
+
+	if (maxCount == 0 || job == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	tmp = (HASH_JOB*)malloc(sizeof(HASH_JOB));
+	if (tmp == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	tmp->algo = algo;
+	tmp->data = NULL;
+	tmp->data_len = 0;
+	tmp->data_capacity = 0;
+	tmp->capacity = maxCount;
+	tmp->count = 0;
+	tmp->taken = 0;
+	tmp->done = 0;
+	tmp->error = KT_OK;
+	tmp->isSubmitted = 0;
+	tmp->next = NULL;
+
+	tmp->offset = (size_t*)malloc(maxCount * sizeof(size_t));
+	tmp->len = (size_t*)malloc(maxCount * sizeof(size_t));
+	tmp->ref = (const unsigned char**)calloc(maxCount, sizeof(const unsigned char*));
+	tmp->hashes = (KSI_DataHash**)calloc(maxCount, sizeof(KSI_DataHash*));
+	if (tmp->offset == NULL || tmp->len == NULL || tmp->ref == NULL || tmp->hashes == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	*job = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	HASH_JOB_free(tmp);
+
+	return res;
+}
+
+void HASH_JOB_free(HASH_JOB *job) {
+	if (job == NULL) return;
+
+	if (job->hashes != NULL) HASH_JOB_reset(job);
+
+	free(job->data);
+	free(job->offset);
+	free(job->len);
+	free((void*)job->ref);
+	free(job->hashes);
+	free(job);
+}
+
+int HASH_JOB_add(HASH_JOB *job, const unsigned char *data, size_t data_len) {
+	if (job == NULL || (data == NULL && data_len > 0)) return KT_INVALID_ARGUMENT;
+	if (HASH_JOB_isFull(job)) return KT_INDEX_OVF;
+
+	if (job->data_len + data_len > job->data_capacity) {
+		unsigned char *tmp = NULL;
+		size_t newCapacity = job->data_capacity == 0 ? 0x10000 : job->data_capacity;
+
+		while (newCapacity < job->data_len + data_len) newCapacity *= 2;
+
+		tmp = (unsigned char*)realloc(job->data, newCapacity);
+		if (tmp == NULL) return KT_OUT_OF_MEMORY;
+
+		job->data = tmp;
+		job->data_capacity = newCapacity;
+	}
+
+	if (data_len > 0) memcpy(job->data + job->data_len, data, data_len);
+	job->offset[job->count] = job->data_len;
+	job->len[job->count] = data_len;
+	job->ref[job->count] = NULL;
+	job->data_len += data_len;
+	job->count++;
+
+	return KT_OK;
+}
+
+int HASH_JOB_addRef(HASH_JOB *job, const unsigned char *data, size_t data_len) {
+	if (job == NULL || (data == NULL && data_len > 0)) return KT_INVALID_ARGUMENT;
+	if (HASH_JOB_isFull(job)) return KT_INDEX_OVF;
+
+	/* Empty item still needs a valid pointer to be distinguished from a copied item. */
+	job->offset[job->count] = 0;
+	job->len[job->count] = data_len;
+	job->ref[job->count] = (data != NULL) ? data : (const unsigned char*)"";
+	job->count++;
+
+	return KT_OK;
+}
+
+int HASH_JOB_getData(HASH_JOB *job, size_t i, const unsigned char **data, size_t *data_len) {
+	if (job == NULL || i >= job->count || data == NULL || data_len == NULL) return KT_INVALID_ARGUMENT;
+
+	*data = (job->ref[i] != NULL) ? job->ref[i] : job->data + job->offset[i];
+	*data_len = job->len[i];
+
+	return KT_OK;
+}
+
+int HASH_JOB_getHash(HASH_JOB *job, size_t i, KSI_DataHash **hash) {
+	if (job == NULL || i >= job->count || hash == NULL || job->hashes[i] == NULL) return KT_INVALID_ARGUMENT;
+
+	*hash = KSI_DataHash_ref(job->hashes[i]);
+
+	return KT_OK;
+}
+
+void HASH_JOB_reset(HASH_JOB *job) {
+	size_t i;
+
+	if (job == NULL) return;
+
+	for (i = 0; i < job->count; i++) {
+		KSI_DataHash_free(job->hashes[i]);
+		job->hashes[i] = NULL;
+	}
+
+	job->count = 0;
+	job->data_len = 0;
+	job->isSubmitted = 0;
+}
+
+int HASH_JOB_setAlgorithm(HASH_JOB *job, KSI_HashAlgorithm algo) {
+	if (job == NULL || job->count > 0) return KT_INVALID_ARGUMENT;
+	job->algo = algo;
+	return KT_OK;
+}
+
+KSI_HashAlgorithm HASH_JOB_getAlgorithm(HASH_JOB *job) {
+	if (job == NULL) return KSI_HASHALG_INVALID_VALUE;
+	return job->algo;
+}
+
+int HASH_JOB_isFull(HASH_JOB *job) {
+	if (job == NULL) return 0;
+	return job->count >= job->capacity;
+}
+
+size_t HASH_JOB_getCount(HASH_JOB *job) {
+	if (job == NULL) return 0;
+	return job->count;
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+#ifndef HASH_POOL_H
+#define	HASH_POOL_H
+
+#include <stddef.h>
+#include <ksi/ksi.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+typedef struct HASH_POOL_st HASH_POOL;
+typedef struct HASH_JOB_st HASH_JOB;
+
+/**
+ * Creates a pool of worker threads that calculate hashes of the data items in
+ * submitted jobs. Items of a single job are shared between all workers.
+ * \param nofThreads	Count of worker threads.
+ * \param pool			Output parameter for the pool.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int HASH_POOL_new(size_t nofThreads, HASH_POOL **pool);
+
+/**
+ * Stops the worker threads and frees the pool. All submitted jobs must be finished
+ * (see #HASH_POOL_wait) before the pool is freed.
+ */
+void HASH_POOL_free(HASH_POOL *pool);
+
+/**
+ * Submits the job to the pool. The function does not block. The job must not be
+ * modified until #HASH_POOL_wait has returned.
+ * \param pool			Pool object.
+ * \param job			Job to be processed.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int HASH_POOL_submit(HASH_POOL *pool, HASH_JOB *job);
+
+/**
+ * Blocks until all items in the job are hashed. Returns immediately if the job has
+ * not been submitted since it was created or reset (see #HASH_JOB_reset).
+ * \param pool			Pool object.
+ * \param job			Job submitted with #HASH_POOL_submit.
+ * \return KT_OK if all hashes are calculated, error code of the first failure otherwise.
+ */
+int HASH_POOL_wait(HASH_POOL *pool, HASH_JOB *job);
+
+/**
+ * Creates a job of data items to be hashed.
+ * \param algo			Hash algorithm.
+ * \param maxCount		Maximum count of items in the job.
+ * \param job			Output parameter for the job.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int HASH_JOB_new(KSI_HashAlgorithm algo, size_t maxCount, HASH_JOB **job);
+void HASH_JOB_free(HASH_JOB *job);
+
+/**
+ * Copies the data to the end of the job.
+ * \return KT_OK if successful, KT_INDEX_OVF if the job is full, error code otherwise.
+ */
+int HASH_JOB_add(HASH_JOB *job, const unsigned char *data, size_t data_len);
+
+/**
+ * Same as #HASH_JOB_add, but the data is not copied. The data must stay valid
+ * until the job is reset or freed.
+ */
+int HASH_JOB_addRef(HASH_JOB *job, const unsigned char *data, size_t data_len);
+
+/**
+ * Returns a pointer to the data of the item with index \c i. The data is valid
+ * until the job is reset or freed.
+ */
+int HASH_JOB_getData(HASH_JOB *job, size_t i, const unsigned char **data, size_t *data_len);
+
+/**
+ * Returns a reference to the hash of the item with index \c i. Must be called
+ * after #HASH_POOL_wait has returned successfully.
+ */
+int HASH_JOB_getHash(HASH_JOB *job, size_t i, KSI_DataHash **hash);
+
+/**
+ * Removes all items and hashes from the job. The job is not submitted any more.
+ */
+void HASH_JOB_reset(HASH_JOB *job);
+
+/**
+ * Changes the hash algorithm of the job. Only an empty job can be changed.
+ */
+int HASH_JOB_setAlgorithm(HASH_JOB *job, KSI_HashAlgorithm algo);
+KSI_HashAlgorithm HASH_JOB_getAlgorithm(HASH_JOB *job);
+
+int HASH_JOB_isFull(HASH_JOB *job);
+size_t HASH_JOB_getCount(HASH_JOB *job);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* HASH_POOL_H */
@@ -0,0 +1,344 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ksi/ksi.h>
+#include <ksi/compatibility.h>
+#include <ksi/policy.h>
+#include <param_set/param_set.h>
+#include <param_set/task_def.h>
+#include <param_set/parameter.h>
+#include <param_set/strn.h>
+#include "tool_box/ksi_init.h"
+#include "tool_box/param_control.h"
+#include "tool_box/task_initializer.h"
+#include "smart_file.h"
+#include "err_trckr.h"
+#include "api_wrapper.h"
+#include "printer.h"
+#include "debug_print.h"
+#include "obj_printer.h"
+#include "conf_file.h"
+#include "tool.h"
+#include "rsyslog.h"
+#include "io_files.h"
+#include "block_index.h"
+
+static int generate_tasks_set(PARAM_SET *set, TASK_SET *task_set);
+static int check_pipe_errors(PARAM_SET *set, ERR_TRCKR *err);
+
+static int generate_filenames(PARAM_SET *set, ERR_TRCKR *err, IO_FILES *files);
+static int open_log_and_signature_files(PARAM_SET *set, ERR_TRCKR *err, IO_FILES *files);
+static void close_log_and_signature_files(ERR_TRCKR *err, int res, IO_FILES *files);
+
+#define PARAMS "{input}{o}{d}{log}{h|help}{hex-to-str}"
+
+int index_run(int argc, char **argv, char **envp) {
+	int res;
+	char buf[2048];
+	PARAM_SET *set = NULL;
+	TASK_SET *task_set = NULL;
+	TASK *task = NULL;
+	KSI_CTX *ksi = NULL;
+	ERR_TRCKR *err = NULL;
+	SMART_FILE *logfile = NULL;
+	int d = 0;
+	IO_FILES files;
+	MULTI_PRINTER *mp = NULL;
+	BLOCK_INDEX *index = NULL;
+	size_t sigSize = 0;
+
+	IO_FILES_init(&files);
+
+	/**
+	 * Extract command line parameters and also add configuration specific parameters.
+	 */
+	res = PARAM_SET_new(
+			CONF_generate_param_set_desc(PARAMS, "", buf, sizeof(buf)),
+			&set);
+	if (res != KT_OK) goto cleanup;
+
+	res = TASK_SET_new(&task_set);
+	if (res != PST_OK) goto cleanup;
+
+	res = generate_tasks_set(set, task_set);
+	if (res != PST_OK) goto cleanup;
+
+	res = TASK_INITIALIZER_getServiceInfo(set, argc, argv, envp);
+	if (res != PST_OK) goto cleanup;
+
+	res = TASK_INITIALIZER_check_analyze_report(set, task_set, 0.2, 0.1, &task);
+	if (res != KT_OK) goto cleanup;
+
+	res = TASK_INITIALIZER_getPrinter(set, &mp);
+	ERR_CATCH_MSG(err, res, "Error: Unable to create Multi printer!");
+
+	res = TOOL_init_ksi(set, &ksi, &err, &logfile);
+	if (res != KT_OK) goto cleanup;
+
+	d = PARAM_SET_isSetByName(set, "d");
+
+	res = check_pipe_errors(set, err);
+	if (res != KT_OK) goto cleanup;
+
+	res = generate_filenames(set, err, &files);
+	if (res != KT_OK) goto cleanup;
+
+	res = open_log_and_signature_files(set, err, &files);
+	if (res != KT_OK) goto cleanup;
+
+	res = logsignature_index(set, mp, err, ksi, &files, &index);
+	if (res != KT_OK) goto cleanup;
+
+	/* The whole log signature file is read, thus the position is the size of the file. */
+	res = SMART_FILE_getPosition(files.files.inSig, &sigSize);
+	ERR_CATCH_MSG(err, res, "Error: Could not get the size of log signature file %s.", files.internal.inSig);
+
+	print_progressDesc(mp, MP_ID_BLOCK, 0, DEBUG_EQUAL | DEBUG_LEVEL_1, "Writing block index... ");
+	res = BLOCK_INDEX_write(index, files.internal.outSig, sigSize);
+	print_progressResult(mp, MP_ID_BLOCK, DEBUG_EQUAL | DEBUG_LEVEL_1, res);
+	ERR_CATCH_MSG(err, res, "Error: Could not write block index file %s.", files.internal.outSig);
+
+	print_debug_mp(mp, MP_ID_BLOCK, DEBUG_EQUAL | DEBUG_LEVEL_1, "Block index of %zu blocks saved to '%s'\n", BLOCK_INDEX_getCount(index), files.internal.outSig);
+
+cleanup:
+
+	close_log_and_signature_files(err, res, &files);
+
+	MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
+	LOGKSI_KSI_ERRTrace_save(ksi);
+
+	if (res != KT_OK) {
+		if (ERR_TRCKR_getErrCount(err) == 0) {ERR_TRCKR_ADD(err, res, NULL);}
+		LOGKSI_KSI_ERRTrace_LOG(ksi);
+
+		print_errors("\n");
+		ERR_TRCKR_print(err, d);
+	}
+
+	SMART_FILE_close(logfile);
+	BLOCK_INDEX_free(index);
+	PARAM_SET_free(set);
+	TASK_SET_free(task_set);
+	ERR_TRCKR_free(err);
+	KSI_CTX_free(ksi);
+	MULTI_PRINTER_free(mp);
+
+	return LOGKSI_errToExitCode(res);
+}
+
+char *index_help_toString(char *buf, size_t len) {
+	int res;
+	char *ret = NULL;
+	PARAM_SET *set;
+	size_t count = 0;
+	char tmp[1024];
+
+	if (buf == NULL || len == 0) return NULL;
+
+
+	/* Create set with documented parameters. */
+	res = PARAM_SET_new(CONF_generate_param_set_desc(PARAMS "{logsig}", "", tmp, sizeof(tmp)), &set);
+	if (res != PST_OK) goto cleanup;
+
+	res = CONF_initialize_set_functions(set, "");
+	if (res != PST_OK) goto cleanup;
+
+	/* Temporary name change for formatting help text. */
+	PARAM_SET_setPrintName(set, "input", "<logfile>", NULL);
+	PARAM_SET_setHelpText(set, "input", NULL, "Log file that is signed with the log signature file. It is used to find the positions of the blocks in the log file.");
+
+	/* Note that logsig is not a real parameter, but a dummy parameter to be used to format help! */
+	PARAM_SET_setPrintName(set, "logsig", "<logfile.logsig>", NULL);
+	PARAM_SET_setHelpText(set, "logsig", NULL, "Log signature file to be indexed. If omitted, the log signature file name is derived by adding either '.logsig' or '.gtsig' to '<logfile>'. It is expected to be found in the same folder as the '<logfile>'.");
+
+	PARAM_SET_setHelpText(set, "o", "<out.idx>", "Name of the block index file. If not specified, the block index file is saved as '<logfile.logsig>.idx' that is also updated by 'logksi create', 'sign', 'extend' and 'integrate' if it exists. An existing block index file is overwritten.");
+	PARAM_SET_setHelpText(set, "d", NULL, "Print detailed information about processes and errors to stderr. To make output more verbose use -dd or -ddd.");
+	PARAM_SET_setHelpText(set, "log", "<file>", "Write libksi log to the given file. Use '-' as file name to redirect the log to stdout.");
+
+
+	/* Format synopsis and parameters. */
+	count += PST_snhiprintf(buf + count, len - count, 80, 0, 0, NULL, ' ', "Usage:\\>1\n\\>8"
+	"logksi index <logfile> [<logfile.logsig>] [-o <out.idx>] [more_options]"
+	"\\>\n\n\n");
+
+	ret = PARAM_SET_helpToString(set, "input,logsig,o,d,log", 1, 13, 80, buf + count, len - count);
+
+cleanup:
+	if (res != PST_OK || ret == NULL) {
+		PST_snprintf(buf + count, len - count, "\nError: There were failures while generating help by PARAM_SET.\n");
+	}
+	PARAM_SET_free(set);
+	return buf;
+}
+
+const char *index_get_desc(void) {
+	return "Creates a block index for random access to the log signature file.";
+}
+
+static int generate_tasks_set(PARAM_SET *set, TASK_SET *task_set) {
+	int res;
+
+	if (set == NULL || task_set == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	/**
+	 * Configure parameter set, control, repair and object extractor function.
+	 */
+	PARAM_SET_addControl(set, "{log}{o}", isFormatOk_path, NULL, convertRepair_path, NULL);
+	PARAM_SET_addControl(set, "{input}", isFormatOk_inputFile, isContentOk_inputFileRestrictPipe, convertRepair_path, NULL);
+	PARAM_SET_addControl(set, "{d}{hex-to-str}", isFormatOk_flag, NULL, NULL, NULL);
+
+	PARAM_SET_setParseOptions(set, "input", PST_PRSCMD_COLLECT_LOOSE_VALUES | PST_PRSCMD_HAS_NO_FLAG | PST_PRSCMD_NO_TYPOS);
+	PARAM_SET_setParseOptions(set, "d,h", PST_PRSCMD_HAS_NO_VALUE | PST_PRSCMD_NO_TYPOS);
+	PARAM_SET_setParseOptions(set, "hex-to-str", PST_PRSCMD_HAS_NO_VALUE);
+
+
+	/*						ID		DESC							MAN			ATL		FORBIDDEN	IGN	*/
+	TASK_SET_add(task_set,	0,		"Create block index.",			"input",	NULL,	NULL,		NULL);
+
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
+
+static int check_pipe_errors(PARAM_SET *set, ERR_TRCKR *err) {
+	int res;
+
+	res = get_pipe_out_error(set, err, NULL, "log", NULL);
+	if (res != KT_OK) goto cleanup;
+
+cleanup:
+	return res;
+}
+
+static int generate_filenames(PARAM_SET *set, ERR_TRCKR *err, IO_FILES *files) {
+	int res;
+	IO_FILES tmp;
+	char *legacy_name = NULL;
+	char *outIndex = NULL;
+	int count = 0;
+
+	memset(&tmp.internal, 0, sizeof(tmp.internal));
+
+	if (err == NULL || files == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	res = PARAM_SET_getValueCount(set, "input", NULL, PST_PRIORITY_NONE, &count);
+	if (res != KT_OK) goto cleanup;
+
+	res = PARAM_SET_getStr(set, "input", NULL, PST_PRIORITY_NONE, 0, &files->user.inLog);
+	if (res != KT_OK) goto cleanup;
+
+	if (count > 1) {
+		res = PARAM_SET_getStr(set, "input", NULL, PST_PRIORITY_NONE, 1, &files->user.inSig);
+		if (res != KT_OK) goto cleanup;
+	}
+
+	res = PARAM_SET_getStr(set, "o", NULL, PST_PRIORITY_NONE, 0, &outIndex);
+	if (res != KT_OK && res != PST_PARAMETER_EMPTY) goto cleanup;
+
+	res = duplicate_name(files->user.inLog, &tmp.internal.inLog);
+	ERR_CATCH_MSG(err, res, "Error: Could not duplicate input log file name.");
+
+	if (files->user.inSig) {
+		res = duplicate_name(files->user.inSig, &tmp.internal.inSig);
+		ERR_CATCH_MSG(err, res, "Error: Could not duplicate input log signature file name.");
+	} else {
+		/* If input log signature file name is not specified, it is generated from the input log file name. */
+		res = concat_names(files->user.inLog, ".logsig", &tmp.internal.inSig);
+		ERR_CATCH_MSG(err, res, "Error: Could not generate input log signature file name.");
+		if (!SMART_FILE_doFileExist(tmp.internal.inSig)) {
+			res = concat_names(files->user.inLog, ".gtsig", &legacy_name);
+			ERR_CATCH_MSG(err, res, "Error: Could not generate input log signature file name.");
+			if (SMART_FILE_doFileExist(legacy_name)) {
+				KSI_free(tmp.internal.inSig);
+				tmp.internal.inSig = legacy_name;
+				legacy_name = NULL;
+			}
+		}
+	}
+
+	/* Block index file name is kept as output log signature file name. */
+	if (outIndex && strcmp(outIndex, "-") == 0) {
+		res = KT_INVALID_CMD_PARAM;
+		ERR_CATCH_MSG(err, res, "Error: Block index can not be redirected to stdout.");
+	} else if (outIndex) {
+		res = duplicate_name(outIndex, &tmp.internal.outSig);
+		ERR_CATCH_MSG(err, res, "Error: Could not duplicate block index file name.");
+	} else {
+		res = concat_names(tmp.internal.inSig, BLOCK_INDEX_FILE_EXTENSION, &tmp.internal.outSig);
+		ERR_CATCH_MSG(err, res, "Error: Could not generate block index file name.");
+	}
+
+	files->internal = tmp.internal;
+	memset(&tmp.internal, 0, sizeof(tmp.internal));
+	res = KT_OK;
+
+cleanup:
+
+	KSI_free(legacy_name);
+	logksi_internal_filenames_free(&tmp.internal);
+
+	return res;
+}
+
+static int open_log_and_signature_files(PARAM_SET *set, ERR_TRCKR *err, IO_FILES *files) {
+	int res = KT_IO_ERROR;
+	IO_FILES tmp;
+
+	memset(&tmp.files, 0, sizeof(tmp.files));
+
+	if (set == NULL || err == NULL || files == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	res = SMART_FILE_open(files->internal.inLog, "rbm", &tmp.files.inLog);
+	ERR_CATCH_MSG(err, res, "Error: Could not open input log file '%s'.", files->internal.inLog);
+
+	res = SMART_FILE_open(files->internal.inSig, "rb", &tmp.files.inSig);
+	ERR_CATCH_MSG(err, res, "Error: Could not open input sig file '%s'.", files->internal.inSig);
+
+	files->files = tmp.files;
+	memset(&tmp.files, 0, sizeof(tmp.files));
+
+	res = KT_OK;
+
+cleanup:
+
+	logksi_files_close(&tmp.files);
+	return res;
+}
+
+static void close_log_and_signature_files(ERR_TRCKR *err, int res, IO_FILES *files) {
+	if (files) {
+		logksi_files_close(&files->files);
+		logksi_internal_filenames_free(&files->internal);
+	}
+}
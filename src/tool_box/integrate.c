@@ -50,7 +50,7 @@ static int rename_temporary_and_backup_files(PARAM_SET *set, ERR_TRCKR *err, IO_
 static void close_input_and_output_files(ERR_TRCKR *err, int res, IO_FILES *files);
 static int check_pipe_errors(PARAM_SET *set, ERR_TRCKR *err);
 
-#define PARAMS "{input}{o}{out-log}{insert-missing-hashes}{force-overwrite}{use-computed-hash-on-fail}{use-stored-hash-on-fail}{recover}{d}{log}{h|help}{hex-to-str}"
+#define PARAMS "{input}{o}{out-log}{insert-missing-hashes}{force-overwrite}{use-computed-hash-on-fail}{use-stored-hash-on-fail}{recover}{d}{log}{h|help}{hex-to-str}{write-index}"
 
 int integrate_run(int argc, char **argv, char **envp) {
 	int res;
@@ -186,6 +186,7 @@ char *integrate_help_toString(char *buf, size_t len) {
 	PARAM_SET_setHelpText(set, "out-log", "<out.logsig>", "Specify the name of recovered log file (only valid with --recover). If not specified, the log signature file is saved as <logfile>.recovered in the same folder where the <logfile> is located. An attempt to overwrite an existing log file will result in an error. Use '-' as file name to redirect the output as a binary stream to stdout result in an error. Use '-' to redirect the integrated log signature binary stream to stdout.");
 	PARAM_SET_setHelpText(set, "recover", NULL, "Tries to recover as many blocks as possible from corrupted log and log signature temporary files. For example if block no. 6 is corrupted it is possible to recover log records and log signatures until the end of the block no. 5. By default output file names are derived from the log file name: <logfile>.recovered and <logfile>.recovered.logsig for log and log signature file accordingly. If the files already exist, error is returned (see --force-overwrite).");
 	PARAM_SET_setHelpText(set, "force-overwrite", NULL, "Force overwriting of existing log signature file.");
+	PARAM_SET_setHelpText(set, "write-index", NULL, "Write a block index file next to the output log signature file as '<out.logsig>.idx'. The index contains the positions of the blocks in the log signature file and makes it possible to access a block without reading the file from the beginning. The index is always updated if it already exists. See 'logksi index' to create the index for an existing log signature file.");
 	PARAM_SET_setHelpText(set, "d", NULL, "Print detailed information about processes and errors to stderr. To make output more verbose use -dd or -ddd.");
 	PARAM_SET_setHelpText(set, "log", "<file>", "Write libksi log to the given file. Use '-' as file name to redirect the log to stdout.");
 
@@ -197,7 +198,7 @@ char *integrate_help_toString(char *buf, size_t len) {
 	"[--out-log <out.recovered.logsig>]"
 	"\\>\n\n\n");
 
-	ret = PARAM_SET_helpToString(set, "input,o,out-log,recover,force-overwrite,d,log", 1, 13, 80, buf + count, len - count);
+	ret = PARAM_SET_helpToString(set, "input,o,out-log,recover,force-overwrite,write-index,d,log", 1, 13, 80, buf + count, len - count);
 
 cleanup:
 	if (res != PST_OK || ret == NULL) {
@@ -225,11 +226,11 @@ static int generate_tasks_set(PARAM_SET *set, TASK_SET *task_set) {
 	 */
 	PARAM_SET_addControl(set, "{input}", isFormatOk_inputFile, NULL, convertRepair_path, NULL);
 	PARAM_SET_addControl(set, "{log}{o}{out-log}", isFormatOk_path, NULL, convertRepair_path, NULL);
-	PARAM_SET_addControl(set, "{insert-missing-hashes}{force-overwrite}{use-computed-hash-on-fail}{use-stored-hash-on-fail}{d}{recover}{hex-to-str}", isFormatOk_flag, NULL, NULL, NULL);
+	PARAM_SET_addControl(set, "{insert-missing-hashes}{force-overwrite}{use-computed-hash-on-fail}{use-stored-hash-on-fail}{d}{recover}{hex-to-str}{write-index}", isFormatOk_flag, NULL, NULL, NULL);
 
 	PARAM_SET_setParseOptions(set, "input", PST_PRSCMD_COLLECT_LOOSE_VALUES | PST_PRSCMD_HAS_NO_FLAG | PST_PRSCMD_NO_TYPOS);
 
-	PARAM_SET_setParseOptions(set, "insert-missing-hashes,force-overwrite,use-computed-hash-on-fail,use-stored-hash-on-fail,recover,hex-to-str", PST_PRSCMD_HAS_NO_VALUE);
+	PARAM_SET_setParseOptions(set, "insert-missing-hashes,force-overwrite,use-computed-hash-on-fail,use-stored-hash-on-fail,recover,hex-to-str,write-index", PST_PRSCMD_HAS_NO_VALUE);
 	PARAM_SET_setParseOptions(set, "d,h", PST_PRSCMD_HAS_NO_VALUE | PST_PRSCMD_NO_TYPOS);
 
 	/**
@@ -185,6 +185,7 @@ void IO_FILES_init(IO_FILES *files) {
 		files->previousLogFile[0] = '\0';
 		files->previousSigFileIn[0] = '\0';
 		files->previousSigFileOut[0] = '\0';
+		files->previousSigTime = 0;
 	}
 }
 
@@ -21,6 +21,7 @@
 #define	IO_FILES_H
 
 #include <stddef.h>
+#include <stdint.h>
 #include <ksi/hash.h>
 #include "smart_file.h"
 #include "err_trckr.h"
@@ -80,6 +81,9 @@ typedef struct {
 	char previousLogFile[4096];
 	char previousSigFileIn[4096];
 	char previousSigFileOut[4096];
+
+	/* Signing time of the last block of the previous log signature file. */
+	uint64_t previousSigTime;
 } IO_FILES;
 
 
@@ -0,0 +1,520 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+/* Needed for the declaration of struct ucred (SO_PEERCRED). */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#  define _GNU_SOURCE
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "logksi_err.h"
+#include "job_socket.h"
+
+#define JOB_SOCKET_REQUEST_MAGIC "LOGDJQ11"
+#define JOB_SOCKET_RESPONSE_MAGIC "LOGDJR10"
+#define JOB_SOCKET_MAGIC_SIZE 8
+#define JOB_SOCKET_REQUEST_HEADER_SIZE (JOB_SOCKET_MAGIC_SIZE + 3 * 8)
+#define JOB_SOCKET_RESPONSE_SIZE (JOB_SOCKET_MAGIC_SIZE + 8)
+#define JOB_SOCKET_MAX_ARGC 0x1000
+#define JOB_SOCKET_MAX_ENVC 0x1000
+#define JOB_SOCKET_MAX_STRING_SIZE 0x10000
+
+static void job_socket_put_uint64(unsigned char *buf, uint64_t val) {
+	int i;
+
+	for (i = 7; i >= 0; i--) {
+		buf[i] = (unsigned char)(val & 0xff);
+		val >>= 8;
+	}
+}
+
+static uint64_t job_socket_get_uint64(const unsigned char *buf) {
+	uint64_t val = 0;
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		val = (val << 8) | buf[i];
+	}
+
+	return val;
+}
+
+static int job_socket_send_all(int fd, const void *buf, size_t len) {
+	const unsigned char *p = buf;
+
+	while (len > 0) {
+		ssize_t count = send(fd, p, len, MSG_NOSIGNAL);
+
+		if (count < 0 && errno == EINTR) continue;
+		if (count <= 0) return KT_IO_ERROR;
+
+		p += count;
+		len -= (size_t)count;
+	}
+
+	return KT_OK;
+}
+
+static int job_socket_recv_all(int fd, void *buf, size_t len) {
+	unsigned char *p = buf;
+
+	while (len > 0) {
+		ssize_t count = recv(fd, p, len, 0);
+
+		if (count < 0 && errno == EINTR) continue;
+		if (count < 0) return KT_IO_ERROR;
+		if (count == 0) return KT_INVALID_INPUT_FORMAT;
+
+		p += count;
+		len -= (size_t)count;
+	}
+
+	return KT_OK;
+}
+
+static int job_socket_send_string(int fd, const char *str) {
+	int res;
+	unsigned char len_buf[8];
+	size_t len = strlen(str);
+
+	job_socket_put_uint64(len_buf, len);
+
+	res = job_socket_send_all(fd, len_buf, sizeof(len_buf));
+	if (res != KT_OK) return res;
+
+	return job_socket_send_all(fd, str, len);
+}
+
+static int job_socket_recv_string(int fd, char **str) {
+	int res;
+	unsigned char len_buf[8];
+	uint64_t len = 0;
+	char *tmp = NULL;
+
+	res = job_socket_recv_all(fd, len_buf, sizeof(len_buf));
+	if (res != KT_OK) return res;
+
+	len = job_socket_get_uint64(len_buf);
+	if (len > JOB_SOCKET_MAX_STRING_SIZE) return KT_INVALID_INPUT_FORMAT;
+
+	tmp = (char*)malloc((size_t)len + 1);
+	if (tmp == NULL) return KT_OUT_OF_MEMORY;
+
+	res = job_socket_recv_all(fd, tmp, (size_t)len);
+	if (res != KT_OK) {
+		free(tmp);
+		return res;
+	}
+
+	tmp[len] = '\0';
+	*str = tmp;
+
+	return KT_OK;
+}
+
+static int job_socket_address(const char *path, struct sockaddr_un *addr) {
+	if (strlen(path) >= sizeof(addr->sun_path)) return KT_INVALID_ARGUMENT;
+
+	memset(addr, 0, sizeof(struct sockaddr_un));
+	addr->sun_family = AF_UNIX;
+	strcpy(addr->sun_path, path);
+
+	return KT_OK;
+}
+
+int JOB_SOCKET_listen(const char *path, int *fd) {
+	int res = KT_UNKNOWN_ERROR;
+	struct sockaddr_un addr;
+	int tmp = -1;
+	mode_t mask = 0;
+	int bound = 0;
+
+	if (path == NULL || fd == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	res = job_socket_address(path, &addr);
+	if (res != KT_OK) goto cleanup;
+
+	/* If nobody is listening, the socket file is left behind by a daemon that is not running. */
+	if (JOB_SOCKET_connect(path, &tmp) == KT_OK) {
+		res = KT_IO_ERROR;
+		goto cleanup;
+	}
+
+	if (unlink(path) != 0 && errno != ENOENT) {
+		res = KT_IO_ERROR;
+		goto cleanup;
+	}
+
+	tmp = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (tmp < 0) {
+		res = KT_IO_ERROR;
+		goto cleanup;
+	}
+
+	/* Socket is created accessible only by the owner, as the jobs are run with the rights of the daemon. */
+	mask = umask(S_IXUSR | S_IRWXG | S_IRWXO);
+	bound = bind(tmp, (struct sockaddr*)&addr, sizeof(addr)) == 0;
+	umask(mask);
+
+	if (!bound || chmod(path, S_IRUSR | S_IWUSR) != 0 || listen(tmp, SOMAXCONN) != 0) {
+		res = KT_IO_ERROR;
+		goto cleanup;
+	}
+
+	*fd = tmp;
+	tmp = -1;
+	res = KT_OK;
+
+cleanup:
+
+	if (tmp >= 0) close(tmp);
+
+	return res;
+}
+
+int JOB_SOCKET_connect(const char *path, int *fd) {
+	int res = KT_UNKNOWN_ERROR;
+	struct sockaddr_un addr;
+	int tmp = -1;
+
+	if (path == NULL || fd == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	res = job_socket_address(path, &addr);
+	if (res != KT_OK) goto cleanup;
+
+	tmp = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (tmp < 0) {
+		res = KT_IO_ERROR;
+		goto cleanup;
+	}
+
+	if (connect(tmp, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+		res = KT_IO_ERROR;
+		goto cleanup;
+	}
+
+	*fd = tmp;
+	tmp = -1;
+	res = KT_OK;
+
+cleanup:
+
+	if (tmp >= 0) close(tmp);
+
+	return res;
+}
+
+int JOB_SOCKET_getPeerUid(int fd, uid_t *uid) {
+#ifdef SO_PEERCRED
+	struct ucred cred;
+	socklen_t len = sizeof(cred);
+
+	if (fd < 0 || uid == NULL) return KT_INVALID_ARGUMENT;
+	if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0 || len != sizeof(cred)) return KT_IO_ERROR;
+
+	*uid = cred.uid;
+#else
+	gid_t gid;
+
+	if (fd < 0 || uid == NULL) return KT_INVALID_ARGUMENT;
+	if (getpeereid(fd, uid, &gid) != 0) return KT_IO_ERROR;
+#endif
+
+	return KT_OK;
+}
+
+int JOB_SOCKET_sendRequest(int fd, int argc, char **argv, char **envp, const char *cwd) {
+	int res = KT_UNKNOWN_ERROR;
+	unsigned char buf[JOB_SOCKET_REQUEST_HEADER_SIZE];
+	int fds[JOB_SOCKET_FD_COUNT] = {STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO};
+	char control[CMSG_SPACE(sizeof(fds))];
+	struct msghdr msg;
+	struct iovec iov;
+	struct cmsghdr *cmsg = NULL;
+	ssize_t count = 0;
+	int envc = 0;
+	int i;
+
+	if (fd < 0 || argc <= 0 || argc > JOB_SOCKET_MAX_ARGC || argv == NULL || cwd == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	while (envp != NULL && envp[envc] != NULL) envc++;
+	if (envc > JOB_SOCKET_MAX_ENVC) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	memcpy(buf, JOB_SOCKET_REQUEST_MAGIC, JOB_SOCKET_MAGIC_SIZE);
+	job_socket_put_uint64(buf + JOB_SOCKET_MAGIC_SIZE, (uint64_t)argc);
+	job_socket_put_uint64(buf + JOB_SOCKET_MAGIC_SIZE + 8, (uint64_t)envc);
+	job_socket_put_uint64(buf + JOB_SOCKET_MAGIC_SIZE + 16, strlen(cwd));
+
+	/* Standard streams are passed together with the header. */
+	memset(&msg, 0, sizeof(msg));
+	memset(control, 0, sizeof(control));
+	iov.iov_base = buf;
+	iov.iov_len = sizeof(buf);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+	memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+	do {
+		count = sendmsg(fd, &msg, MSG_NOSIGNAL);
+	} while (count < 0 && errno == EINTR);
+
+	if (count <= 0) {
+		res = KT_IO_ERROR;
+		goto cleanup;
+	}
+
+	res = job_socket_send_all(fd, buf + count, sizeof(buf) - (size_t)count);
+	if (res != KT_OK) goto cleanup;
+
+	res = job_socket_send_all(fd, cwd, strlen(cwd));
+	if (res != KT_OK) goto cleanup;
+
+	for (i = 0; i < argc; i++) {
+		res = job_socket_send_string(fd, argv[i]);
+		if (res != KT_OK) goto cleanup;
+	}
+
+	for (i = 0; i < envc; i++) {
+		res = job_socket_send_string(fd, envp[i]);
+		if (res != KT_OK) goto cleanup;
+	}
+
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
+
+int JOB_SOCKET_receiveRequest(int fd, JOB_REQUEST **req) {
+	int res = KT_UNKNOWN_ERROR;
+	JOB_REQUEST *tmp = NULL;
+	unsigned char buf[JOB_SOCKET_REQUEST_HEADER_SIZE];
+	char control[CMSG_SPACE(JOB_SOCKET_FD_COUNT * sizeof(int))];
+	struct msghdr msg;
+	struct iovec iov;
+	struct cmsghdr *cmsg = NULL;
+	ssize_t count = 0;
+	uint64_t argc = 0;
+	uint64_t envc = 0;
+	uint64_t cwd_len = 0;
+	int i;
+
+	if (fd < 0 || req == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	tmp = (JOB_REQUEST*)malloc(sizeof(JOB_REQUEST));
+	if (tmp == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	tmp->argc = 0;
+	tmp->argv = NULL;
+	tmp->envc = 0;
+	tmp->envp = NULL;
+	tmp->cwd = NULL;
+	for (i = 0; i < JOB_SOCKET_FD_COUNT; i++) tmp->fds[i] = -1;
+
+	memset(&msg, 0, sizeof(msg));
+	iov.iov_base = buf;
+	iov.iov_len = sizeof(buf);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+
+	do {
+		count = recvmsg(fd, &msg, 0);
+	} while (count < 0 && errno == EINTR);
+
+	if (count <= 0) {
+		res = (count == 0) ? KT_INVALID_INPUT_FORMAT : KT_IO_ERROR;
+		goto cleanup;
+	}
+
+	for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+		if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS && cmsg->cmsg_len == CMSG_LEN(sizeof(tmp->fds))) {
+			memcpy(tmp->fds, CMSG_DATA(cmsg), sizeof(tmp->fds));
+		}
+	}
+
+	res = job_socket_recv_all(fd, buf + count, sizeof(buf) - (size_t)count);
+	if (res != KT_OK) goto cleanup;
+
+	if (memcmp(buf, JOB_SOCKET_REQUEST_MAGIC, JOB_SOCKET_MAGIC_SIZE) != 0 || (msg.msg_flags & MSG_CTRUNC)) {
+		res = KT_INVALID_INPUT_FORMAT;
+		goto cleanup;
+	}
+
+	argc = job_socket_get_uint64(buf + JOB_SOCKET_MAGIC_SIZE);
+	envc = job_socket_get_uint64(buf + JOB_SOCKET_MAGIC_SIZE + 8);
+	cwd_len = job_socket_get_uint64(buf + JOB_SOCKET_MAGIC_SIZE + 16);
+	if (argc == 0 || argc > JOB_SOCKET_MAX_ARGC || envc > JOB_SOCKET_MAX_ENVC || cwd_len > JOB_SOCKET_MAX_STRING_SIZE) {
+		res = KT_INVALID_INPUT_FORMAT;
+		goto cleanup;
+	}
+
+	tmp->cwd = (char*)malloc((size_t)cwd_len + 1);
+	tmp->argv = (char**)calloc((size_t)argc + 1, sizeof(char*));
+	tmp->envp = (char**)calloc((size_t)envc + 1, sizeof(char*));
+	if (tmp->cwd == NULL || tmp->argv == NULL || tmp->envp == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	res = job_socket_recv_all(fd, tmp->cwd, (size_t)cwd_len);
+	if (res != KT_OK) goto cleanup;
+	tmp->cwd[cwd_len] = '\0';
+
+	for (i = 0; i < (int)argc; i++) {
+		res = job_socket_recv_string(fd, &tmp->argv[i]);
+		if (res != KT_OK) goto cleanup;
+		tmp->argc++;
+	}
+
+	for (i = 0; i < (int)envc; i++) {
+		res = job_socket_recv_string(fd, &tmp->envp[i]);
+		if (res != KT_OK) goto cleanup;
+		tmp->envc++;
+	}
+
+	*req = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	JOB_REQUEST_free(tmp);
+
+	return res;
+}
+
+void JOB_REQUEST_free(JOB_REQUEST *req) {
+	int i;
+
+	if (req == NULL) return;
+
+	for (i = 0; i < req->argc; i++) {
+		free(req->argv[i]);
+	}
+
+	for (i = 0; i < req->envc; i++) {
+		free(req->envp[i]);
+	}
+
+	for (i = 0; i < JOB_SOCKET_FD_COUNT; i++) {
+		if (req->fds[i] >= 0) close(req->fds[i]);
+	}
+
+	free(req->argv);
+	free(req->envp);
+	free(req->cwd);
+	free(req);
+}
+
+int JOB_SOCKET_sendResponse(int fd, int exitCode) {
+	unsigned char buf[JOB_SOCKET_RESPONSE_SIZE];
+
+	if (fd < 0) return KT_INVALID_ARGUMENT;
+
+	memcpy(buf, JOB_SOCKET_RESPONSE_MAGIC, JOB_SOCKET_MAGIC_SIZE);
+	job_socket_put_uint64(buf + JOB_SOCKET_MAGIC_SIZE, (uint64_t)(unsigned int)exitCode);
+
+	return job_socket_send_all(fd, buf, sizeof(buf));
+}
+
+int JOB_SOCKET_receiveResponse(int fd, int *exitCode) {
+	int res;
+	unsigned char buf[JOB_SOCKET_RESPONSE_SIZE];
+
+	if (fd < 0 || exitCode == NULL) return KT_INVALID_ARGUMENT;
+
+	res = job_socket_recv_all(fd, buf, sizeof(buf));
+	if (res != KT_OK) return res;
+
+	if (memcmp(buf, JOB_SOCKET_RESPONSE_MAGIC, JOB_SOCKET_MAGIC_SIZE) != 0) return KT_INVALID_INPUT_FORMAT;
+
+	*exitCode = (int)(unsigned int)job_socket_get_uint64(buf + JOB_SOCKET_MAGIC_SIZE);
+
+	return KT_OK;
+}
+
+int JOB_SOCKET_runJob(const char *path, int argc, char **argv, char **envp, int *exitCode) {
+	int res = KT_UNKNOWN_ERROR;
+	int fd = -1;
+	char cwd[PATH_MAX];
+
+	if (path == NULL || argv == NULL || exitCode == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	if (getcwd(cwd, sizeof(cwd)) == NULL) {
+		res = KT_IO_ERROR;
+		goto cleanup;
+	}
+
+	res = JOB_SOCKET_connect(path, &fd);
+	if (res != KT_OK) goto cleanup;
+
+	res = JOB_SOCKET_sendRequest(fd, argc, argv, envp, cwd);
+	if (res != KT_OK) goto cleanup;
+
+	res = JOB_SOCKET_receiveResponse(fd, exitCode);
+	if (res != KT_OK) goto cleanup;
+
+	res = KT_OK;
+
+cleanup:
+
+	if (fd >= 0) close(fd);
+
+	return res;
+}
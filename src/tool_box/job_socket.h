@@ -0,0 +1,125 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+#ifndef JOB_SOCKET_H
+#define	JOB_SOCKET_H
+
+#include <sys/types.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/* Name of the environment variable that makes logksi pass the jobs to logksi daemon. */
+#define JOB_SOCKET_ENV_NAME "LOGKSI_DAEMON_SOCKET"
+
+/* Count of the file descriptors (stdin, stdout and stderr) passed with the request. */
+#define JOB_SOCKET_FD_COUNT 3
+
+typedef struct JOB_REQUEST_st {
+	int argc;								/* Count of the command-line arguments. */
+	char **argv;							/* Command-line arguments, starting with the name of the task (e.g. verify). */
+	char **envp;							/* Environment of the client, terminated with NULL. */
+	int envc;								/* Count of the environment variables. */
+	char *cwd;								/* Working directory of the client. */
+	int fds[JOB_SOCKET_FD_COUNT];			/* Standard streams of the client or -1 if not received. */
+} JOB_REQUEST;
+
+/**
+ * Creates a UNIX domain socket that accepts the jobs of logksi daemon. A file left
+ * behind by a daemon that is not running is removed. The socket is accessible only
+ * by the owner (mode 0600).
+ * \param path			Path of the socket.
+ * \param fd			Output parameter for the listening socket.
+ * \return KT_OK if successful, KT_IO_ERROR if the socket is in use by another daemon or
+ * can not be created, error code otherwise.
+ */
+int JOB_SOCKET_listen(const char *path, int *fd);
+
+/**
+ * Connects to logksi daemon.
+ * \param path			Path of the socket.
+ * \param fd			Output parameter for the connected socket.
+ * \return KT_OK if successful, KT_IO_ERROR if there is no daemon listening, error code otherwise.
+ */
+int JOB_SOCKET_connect(const char *path, int *fd);
+
+/**
+ * Returns the user id of the process at the other end of the connected socket.
+ * \param fd			Connected socket.
+ * \param uid			Output parameter for the user id.
+ * \return KT_OK if successful, KT_IO_ERROR if the user id can not be determined.
+ */
+int JOB_SOCKET_getPeerUid(int fd, uid_t *uid);
+
+/**
+ * Sends the job to the daemon. The standard streams of the calling process are passed
+ * to the daemon, so that the output of the job is written directly to them.
+ * Request layout (all integers are 64-bit big-endian):
+ *   magic "LOGDJQ11" | count of arguments | count of environment variables | size of cwd | cwd | arguments | environment
+ * where every argument and environment variable is:
+ *   size of the string | string
+ * \param fd			Connected socket.
+ * \param argc			Count of the arguments.
+ * \param argv			Arguments, starting with the name of the task.
+ * \param envp			Environment of the job, terminated with NULL. Can be NULL.
+ * \param cwd			Working directory of the job.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int JOB_SOCKET_sendRequest(int fd, int argc, char **argv, char **envp, const char *cwd);
+
+/**
+ * Receives the job sent with #JOB_SOCKET_sendRequest.
+ * \param fd			Connected socket.
+ * \param req			Output parameter for the request.
+ * \return KT_OK if successful, KT_INVALID_INPUT_FORMAT if the request is corrupted,
+ * error code otherwise.
+ */
+int JOB_SOCKET_receiveRequest(int fd, JOB_REQUEST **req);
+
+/**
+ * Frees the request and closes the file descriptors received with it.
+ */
+void JOB_REQUEST_free(JOB_REQUEST *req);
+
+/**
+ * Sends the exit code of the job to the client.
+ * Response layout: magic "LOGDJR10" | exit code
+ */
+int JOB_SOCKET_sendResponse(int fd, int exitCode);
+int JOB_SOCKET_receiveResponse(int fd, int *exitCode);
+
+/**
+ * Runs the job in logksi daemon and waits until it is finished. It is the client
+ * side of the daemon: connects, sends the request with the current working directory
+ * and environment and receives the exit code.
+ * \param path			Path of the socket.
+ * \param argc			Count of the arguments.
+ * \param argv			Arguments, starting with the name of the task.
+ * \param envp			Environment of the job (e.g. KSI_CONF), terminated with NULL. Can be NULL.
+ * \param exitCode		Output parameter for the exit code of the job.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int JOB_SOCKET_runJob(const char *path, int argc, char **argv, char **envp, int *exitCode);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* JOB_SOCKET_H */
@@ -28,6 +28,7 @@
 #include "logksi_err.h"
 #include "printer.h"
 #include "api_wrapper.h"
+#include "tool_box/pubfile_cache.h"
 #include <limits.h>
 #include <sys/time.h>
 
@@ -354,9 +355,10 @@ static int tool_init_ksi_publications_file(KSI_CTX *ksi, ERR_TRCKR *err, PARAM_S
 	/**
 	 * If there is a direct need to not verify publications file do the publications
 	 * file request manually so KSI API do not verify the file extracted by the API
-	 * user.
+	 * user. With a publications file cache the file is received by the task (see
+	 * TOOL_receivePublicationsFile).
 	 */
-	if (PARAM_SET_isSetByName(set, "publications-file-no-verify")) {
+	if (PARAM_SET_isSetByName(set, "publications-file-no-verify") && !PARAM_SET_isSetByName(set, "pubfile-cache")) {
 		KSI_receivePublicationsFile(ksi, &tmp);
 	}
 
@@ -494,3 +496,286 @@ cleanup:
 
 	return res;
 }
+
+int TOOL_newSignQueue(PARAM_SET *set, ERR_TRCKR *err, KSI_CTX *ksi, size_t maxPending, SIGN_QUEUE **queue) {
+	int res;
+	char *aggr_url = NULL;
+	char *aggr_user = NULL;
+	char *aggr_pass = NULL;
+	KSI_HashAlgorithm aggr_alg = KSI_HASHALG_INVALID_VALUE;
+
+	if (set == NULL || err == NULL || ksi == NULL || queue == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	PARAM_SET_getStr(set, "S", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, &aggr_url);
+	PARAM_SET_getStr(set, "aggr-user", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, &aggr_user);
+	PARAM_SET_getStr(set, "aggr-key", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, &aggr_pass);
+
+	res = PARAM_SET_getObjExtended(set, "aggr-hmac-alg", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, NULL, (void**)&aggr_alg);
+	if (res != PST_OK && res != PST_PARAMETER_EMPTY && res != PST_PARAMETER_NOT_FOUND) {
+		ERR_TRCKR_ADD(err, res, "Error: Unable to get aggregator HMAC algorithm.");
+		goto cleanup;
+	}
+
+	res = KT_OK;
+	if (aggr_url == NULL) ERR_TRCKR_ADD(err, res = KT_INVALID_CMD_PARAM, "Error: Aggregator URL (null) not set!");
+	if (aggr_user == NULL) ERR_TRCKR_ADD(err, res = KT_INVALID_CMD_PARAM, "Error: Aggregator user (null) not set!");
+	if (aggr_pass == NULL) ERR_TRCKR_ADD(err, res = KT_INVALID_CMD_PARAM, "Error: Aggregator key (null) not set!");
+	if (res != KT_OK) goto cleanup;
+
+	res = SIGN_QUEUE_new(ksi, aggr_url, aggr_user, aggr_pass, aggr_alg, maxPending, queue);
+	ERR_CATCH_MSG(err, res, "Error: Unable to create signing queue.");
+
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
+
+int TOOL_newExtendQueue(PARAM_SET *set, ERR_TRCKR *err, KSI_CTX *ksi, size_t maxPending, EXTEND_QUEUE **queue) {
+	int res;
+	char *ext_url = NULL;
+	char *ext_user = NULL;
+	char *ext_pass = NULL;
+	KSI_HashAlgorithm ext_alg = KSI_HASHALG_INVALID_VALUE;
+
+	if (set == NULL || err == NULL || ksi == NULL || queue == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	PARAM_SET_getStr(set, "X", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, &ext_url);
+	PARAM_SET_getStr(set, "ext-user", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, &ext_user);
+	PARAM_SET_getStr(set, "ext-key", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, &ext_pass);
+
+	res = PARAM_SET_getObjExtended(set, "ext-hmac-alg", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, NULL, (void**)&ext_alg);
+	if (res != PST_OK && res != PST_PARAMETER_EMPTY && res != PST_PARAMETER_NOT_FOUND) {
+		ERR_TRCKR_ADD(err, res, "Error: Unable to get extender HMAC algorithm.");
+		goto cleanup;
+	}
+
+	res = KT_OK;
+	if (ext_url == NULL) ERR_TRCKR_ADD(err, res = KT_INVALID_CMD_PARAM, "Error: Extender URL (null) not set!");
+	if (ext_user == NULL) ERR_TRCKR_ADD(err, res = KT_INVALID_CMD_PARAM, "Error: Extender user (null) not set!");
+	if (ext_pass == NULL) ERR_TRCKR_ADD(err, res = KT_INVALID_CMD_PARAM, "Error: Extender key (null) not set!");
+	if (res != KT_OK) goto cleanup;
+
+	res = EXTEND_QUEUE_new(ksi, ext_url, ext_user, ext_pass, ext_alg, maxPending, queue);
+	ERR_CATCH_MSG(err, res, "Error: Unable to create extending request queue.");
+
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
+
+static int tool_publications_file_trust_digest(PARAM_SET *set, ERR_TRCKR *err, KSI_CTX *ksi, unsigned char *trust) {
+	int res = KT_UNKNOWN_ERROR;
+	const char *values[] = {"P", "cnstr", "V", "W", NULL};
+	KSI_DataHasher *hsr = NULL;
+	KSI_DataHash *hash = NULL;
+	KSI_HashAlgorithm algo = KSI_HASHALG_INVALID_VALUE;
+	const unsigned char *digest = NULL;
+	size_t digest_len = 0;
+	size_t i;
+	int j;
+
+	res = KSI_DataHasher_open(ksi, KSI_HASHALG_SHA2_256, &hsr);
+	ERR_CATCH_MSG(err, res, "Error: Could not open SHA-256 hasher.");
+
+	for (i = 0; values[i] != NULL; i++) {
+		char *value = NULL;
+
+		for (j = 0; PARAM_SET_getStr(set, values[i], NULL, PST_PRIORITY_HIGHEST, j, &value) == PST_OK; j++) {
+			res = KSI_DataHasher_add(hsr, values[i], strlen(values[i]));
+			if (res != KSI_OK) goto cleanup;
+
+			res = KSI_DataHasher_add(hsr, "=", 1);
+			if (res != KSI_OK) goto cleanup;
+
+			if (value != NULL) {
+				res = KSI_DataHasher_add(hsr, value, strlen(value));
+				if (res != KSI_OK) goto cleanup;
+			}
+
+			res = KSI_DataHasher_add(hsr, ";", 1);
+			if (res != KSI_OK) goto cleanup;
+		}
+	}
+
+	res = KSI_DataHasher_close(hsr, &hash);
+	ERR_CATCH_MSG(err, res, "Error: Unable to compute the digest of publications file trust settings.");
+
+	res = KSI_DataHash_extract(hash, &algo, &digest, &digest_len);
+	ERR_CATCH_MSG(err, res, "Error: Unable to compute the digest of publications file trust settings.");
+
+	if (digest_len != PUBFILE_CACHE_DIGEST_SIZE) {
+		res = KT_UNKNOWN_ERROR;
+		goto cleanup;
+	}
+
+	memcpy(trust, digest, PUBFILE_CACHE_DIGEST_SIZE);
+	res = KT_OK;
+
+cleanup:
+
+	KSI_DataHasher_free(hsr);
+	KSI_DataHash_free(hash);
+
+	return res;
+}
+
+static int tool_publications_file_from_cache(ERR_TRCKR *err, KSI_CTX *ksi, PUBFILE_CACHE *cache, KSI_PublicationsFile **pubFile) {
+	int res = KT_UNKNOWN_ERROR;
+	KSI_PublicationsFile *tmp = NULL;
+	const unsigned char *raw = NULL;
+	size_t raw_len = 0;
+
+	raw = PUBFILE_CACHE_getData(cache, &raw_len);
+
+	res = KSI_PublicationsFile_parse(ksi, raw, raw_len, &tmp);
+	ERR_CATCH_MSG(err, res, "Error: Unable to parse cached publications file.");
+
+	/* Publications file kept by KSI context is not downloaded again. */
+	res = KSI_CTX_setPublicationsFile(ksi, tmp);
+	ERR_CATCH_MSG(err, res, "Error: Unable to set publications file.");
+	tmp = NULL;
+
+	res = LOGKSI_receivePublicationsFile(err, ksi, pubFile);
+	if (res != KT_OK) goto cleanup;
+
+	res = KT_OK;
+
+cleanup:
+
+	KSI_PublicationsFile_free(tmp);
+
+	return res;
+}
+
+int TOOL_receivePublicationsFile(PARAM_SET *set, ERR_TRCKR *err, KSI_CTX *ksi, KSI_PublicationsFile **pubFile, int *isVerified) {
+	int res = KT_UNKNOWN_ERROR;
+	KSI_PublicationsFile *tmp = NULL;
+	PUBFILE_CACHE *cache = NULL;
+	SMART_FILE *lock = NULL;
+	char *fname = NULL;
+	unsigned int ttl = PUBFILE_CACHE_DEFAULT_TTL;
+	unsigned char trust[PUBFILE_CACHE_DIGEST_SIZE];
+	char *raw = NULL;
+	size_t raw_len = 0;
+	int verified = 0;
+
+	if (set == NULL || err == NULL || ksi == NULL || pubFile == NULL) {
+		ERR_TRCKR_ADD(err, res = KT_INVALID_ARGUMENT, NULL);
+		goto cleanup;
+	}
+
+	if (!PARAM_SET_isSetByName(set, "pubfile-cache")) {
+		res = LOGKSI_receivePublicationsFile(err, ksi, &tmp);
+		if (res != KT_OK) goto cleanup;
+	} else {
+		res = PARAM_SET_getStr(set, "pubfile-cache", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, &fname);
+		ERR_CATCH_MSG(err, res, "Error: Unable to get publications file cache name.");
+
+		if (PARAM_SET_isSetByName(set, "pubfile-cache-ttl")) {
+			res = PARAM_SET_getObj(set, "pubfile-cache-ttl", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, (void*)&ttl);
+			ERR_CATCH_MSG(err, res, "Error: Unable to get publications file cache time-to-live.");
+		}
+
+		res = tool_publications_file_trust_digest(set, err, ksi, trust);
+		if (res != KT_OK) goto cleanup;
+
+		/* Cache file is replaced atomically and can be read without the lock. Missing or corrupted file is just replaced. */
+		if (PUBFILE_CACHE_read(fname, &cache) != KT_OK || !PUBFILE_CACHE_isFresh(cache, trust, ttl)) {
+			PUBFILE_CACHE_free(cache);
+			cache = NULL;
+
+			res = PUBFILE_CACHE_lock(fname, &lock);
+			ERR_CATCH_MSG(err, res, "Error: Unable to lock publications file cache %s.", fname);
+
+			/* Cache file may have been updated by another process while waiting for the lock. */
+			if (PUBFILE_CACHE_read(fname, &cache) != KT_OK || !PUBFILE_CACHE_isFresh(cache, trust, ttl)) {
+				PUBFILE_CACHE_free(cache);
+				cache = NULL;
+
+				res = LOGKSI_receivePublicationsFile(err, ksi, &tmp);
+				if (res != KT_OK) goto cleanup;
+
+				res = KSI_PublicationsFile_serialize(ksi, tmp, &raw, &raw_len);
+				ERR_CATCH_MSG(err, res, "Error: Unable to serialize publications file.");
+
+				res = PUBFILE_CACHE_new(trust, (unsigned char*)raw, raw_len, 0, &cache);
+				ERR_CATCH_MSG(err, res, "Error: Unable to create publications file cache entry.");
+
+				res = PUBFILE_CACHE_write(cache, fname);
+				ERR_CATCH_MSG(err, res, "Error: Unable to write publications file cache %s.", fname);
+			}
+		}
+
+		if (tmp == NULL) {
+			res = tool_publications_file_from_cache(err, ksi, cache, &tmp);
+			if (res != KT_OK) goto cleanup;
+
+			verified = PUBFILE_CACHE_isVerified(cache);
+		}
+	}
+
+	*pubFile = tmp;
+	tmp = NULL;
+	if (isVerified != NULL) *isVerified = verified;
+	res = KT_OK;
+
+cleanup:
+
+	SMART_FILE_close(lock);
+	PUBFILE_CACHE_free(cache);
+	KSI_PublicationsFile_free(tmp);
+	KSI_free(raw);
+
+	return res;
+}
+
+int TOOL_verifyPublicationsFile(PARAM_SET *set, ERR_TRCKR *err, KSI_CTX *ksi, KSI_PublicationsFile *pubFile) {
+	int res = KT_UNKNOWN_ERROR;
+	PUBFILE_CACHE *cache = NULL;
+	SMART_FILE *lock = NULL;
+	char *fname = NULL;
+	unsigned char trust[PUBFILE_CACHE_DIGEST_SIZE];
+	char *raw = NULL;
+	size_t raw_len = 0;
+
+	if (set == NULL || err == NULL || ksi == NULL || pubFile == NULL) {
+		ERR_TRCKR_ADD(err, res = KT_INVALID_ARGUMENT, NULL);
+		goto cleanup;
+	}
+
+	res = LOGKSI_verifyPublicationsFile(err, ksi, pubFile);
+	if (res != KT_OK) goto cleanup;
+
+	/* Verification result is stored only if the cache still holds the same file. Failure to update the cache is not an error. */
+	if (PARAM_SET_isSetByName(set, "pubfile-cache")
+			&& PARAM_SET_getStr(set, "pubfile-cache", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, &fname) == PST_OK
+			&& tool_publications_file_trust_digest(set, err, ksi, trust) == KT_OK
+			&& KSI_PublicationsFile_serialize(ksi, pubFile, &raw, &raw_len) == KSI_OK
+			&& PUBFILE_CACHE_lock(fname, &lock) == KT_OK
+			&& PUBFILE_CACHE_read(fname, &cache) == KT_OK
+			&& PUBFILE_CACHE_isSame(cache, trust, (unsigned char*)raw, raw_len)
+			&& !PUBFILE_CACHE_isVerified(cache)) {
+		PUBFILE_CACHE_setVerified(cache);
+		PUBFILE_CACHE_write(cache, fname);
+	}
+
+	res = KT_OK;
+
+cleanup:
+
+	SMART_FILE_close(lock);
+	PUBFILE_CACHE_free(cache);
+	KSI_free(raw);
+
+	return res;
+}
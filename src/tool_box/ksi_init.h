@@ -30,6 +30,8 @@ extern "C" {
 #include "logksi_err.h"	
 #include "smart_file.h"
 #include "err_trckr.h"
+#include "sign_queue.h"
+#include "extend_queue.h"
 
 /**
  * This function takes PARAM_SET as input and configures KSI_CTX and ERR_TRCKR.
@@ -44,7 +46,67 @@ extern "C" {
  * \return KT_OK if successful, error code otherwise.
  */
 int TOOL_init_ksi(PARAM_SET *set, KSI_CTX **ksi, ERR_TRCKR **error, SMART_FILE **ksi_log);
-	
+
+/**
+ * Creates a queue of non-blocking signing requests (see #SIGN_QUEUE_new). The aggregator
+ * endpoint and its HMAC algorithm are taken from the same parameters as by #TOOL_init_ksi
+ * (\c S, \c aggr-user, \c aggr-key and \c aggr-hmac-alg), including the values from the
+ * configuration file.
+ *
+ * \param set			PARAM_SET given.
+ * \param err			Error tracker.
+ * \param ksi			KSI context.
+ * \param maxPending	Maximum count of requests that can be in the queue at once.
+ * \param queue			Output parameter for the queue.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int TOOL_newSignQueue(PARAM_SET *set, ERR_TRCKR *err, KSI_CTX *ksi, size_t maxPending, SIGN_QUEUE **queue);
+
+/**
+ * Creates a queue of non-blocking extending requests (see #EXTEND_QUEUE_new). The extender
+ * endpoint and its HMAC algorithm are taken from the same parameters as by #TOOL_init_ksi
+ * (\c X, \c ext-user, \c ext-key and \c ext-hmac-alg), including the values from the
+ * configuration file.
+ *
+ * \param set			PARAM_SET given.
+ * \param err			Error tracker.
+ * \param ksi			KSI context.
+ * \param maxPending	Maximum count of requests that can be in the queue at once.
+ * \param queue			Output parameter for the queue.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int TOOL_newExtendQueue(PARAM_SET *set, ERR_TRCKR *err, KSI_CTX *ksi, size_t maxPending, EXTEND_QUEUE **queue);
+
+/**
+ * Receives the publications file. If \c pubfile-cache is set, the publications file
+ * is taken from the cache file, when it is not older than \c pubfile-cache-ttl seconds
+ * and was received with the same trust settings (\c P, \c cnstr, \c V and \c W).
+ * Otherwise the publications file is downloaded and the cache file is replaced. The
+ * cache file is updated under a lock, so it can be shared by concurrent processes.
+ *
+ * \param set		PARAM_SET given.
+ * \param err		Error tracker.
+ * \param ksi		KSI context.
+ * \param pubFile	Output parameter for the publications file.
+ * \param isVerified	Output parameter that is set if the publications file was taken
+ *					from the cache and is already verified. Can be NULL.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int TOOL_receivePublicationsFile(PARAM_SET *set, ERR_TRCKR *err, KSI_CTX *ksi, KSI_PublicationsFile **pubFile, int *isVerified);
+
+/**
+ * Verifies the publications file. If \c pubfile-cache is set and the cache file holds
+ * the same publications file, the result is stored in the cache file, so the
+ * publications file is not verified again until it is downloaded again.
+ *
+ * \param set		PARAM_SET given.
+ * \param err		Error tracker.
+ * \param ksi		KSI context.
+ * \param pubFile	Publications file.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int TOOL_verifyPublicationsFile(PARAM_SET *set, ERR_TRCKR *err, KSI_CTX *ksi, KSI_PublicationsFile *pubFile);
+
 #ifdef	__cplusplus
 }
 #endif
@@ -0,0 +1,241 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "logksi_err.h"
+#include "smart_file.h"
+#include "log_follow.h"
+
+/* Time to sleep between polls of the log file, when there are no new lines. */
+#define LOG_FOLLOW_POLL_INTERVAL_NS 200000000
+
+/* Size of the chunk that is read when looking for the end of the next line. */
+#define LOG_FOLLOW_SCAN_BUFFER_SIZE 0x1000
+
+struct LOG_FOLLOW_st {
+	char *fname;
+	uint64_t device;
+	uint64_t inode;
+	size_t end;			/* Position after the end of the last line found. */
+	size_t scanned;		/* Position up to which the file is searched for the ends of lines. */
+	int isRotated;
+};
+
+static volatile sig_atomic_t log_follow_stop_requested = 0;
+
+/**
+ * Searches the log file for the end of the next line that is not before \c pos. Lines
+ * end with the same characters as for the log reader (see SMART_FILE_readLine). The
+ * file is read until a chunk contains the end of a line or the end of the file is
+ * reached. As LF may be written after CR later, CR at the end of the file ends the line
+ * only if \c isFinal is set. The position of the file is restored.
+ */
+static int log_follow_find_line_end(LOG_FOLLOW *follow, SMART_FILE *log, size_t pos, int isFinal) {
+	int res = KT_UNKNOWN_ERROR;
+	unsigned char buf[LOG_FOLLOW_SCAN_BUFFER_SIZE];
+	size_t from = 0;
+	size_t count = 0;
+	size_t i = 0;
+	size_t end = 0;
+	int isCrPending = 0;
+
+	from = (pos > follow->scanned) ? pos : follow->scanned;
+
+	res = SMART_FILE_setPosition(log, from);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	do {
+		res = SMART_FILE_read(log, buf, sizeof(buf), &count);
+		if (res != SMART_FILE_OK) goto cleanup;
+
+		i = 0;
+
+		/* Line ended with CR in the previous chunk, LF of the CR LF may follow. */
+		if (isCrPending && count > 0) {
+			if (buf[0] == '\n') i = 1;
+			follow->end = from + i;
+			isCrPending = 0;
+		}
+
+		while (i < count && SMART_FILE_findLineEnd(buf + i, count - i, &end)) {
+			if (i + end == count && buf[count - 1] == '\r') {
+				isCrPending = 1;
+				break;
+			}
+
+			i += end;
+			follow->end = from + i;
+		}
+
+		from += count;
+	} while (count == sizeof(buf) && follow->end <= pos);
+
+	/* CR at the end of the file ends the line only when following is ended, otherwise it is searched again. */
+	if (isCrPending && isFinal) {
+		follow->end = from;
+		isCrPending = 0;
+	}
+
+	follow->scanned = isCrPending ? from - 1 : from;
+
+	res = SMART_FILE_setPosition(log, pos);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
+
+int LOG_FOLLOW_new(const char *fname, LOG_FOLLOW **follow) {
+	int res = KT_UNKNOWN_ERROR;
+	LOG_FOLLOW *tmp = NULL;
+
+	if (fname == NULL || follow == NULL) return KT_INVALID_ARGUMENT;
+
+	tmp = (LOG_FOLLOW*)malloc(sizeof(LOG_FOLLOW));
+	if (tmp == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	tmp->fname = NULL;
+	tmp->device = 0;
+	tmp->inode = 0;
+	tmp->end = 0;
+	tmp->scanned = 0;
+	tmp->isRotated = 0;
+
+	tmp->fname = (char*)malloc(strlen(fname) + 1);
+	if (tmp->fname == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+	strcpy(tmp->fname, fname);
+
+	res = LOG_FOLLOW_getFileId(fname, &tmp->device, &tmp->inode, NULL);
+	if (res != KT_OK) goto cleanup;
+
+	*follow = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	LOG_FOLLOW_free(tmp);
+
+	return res;
+}
+
+void LOG_FOLLOW_free(LOG_FOLLOW *follow) {
+	if (follow == NULL) return;
+	free(follow->fname);
+	free(follow);
+}
+
+int LOG_FOLLOW_waitForLine(LOG_FOLLOW *follow, SMART_FILE *log, time_t deadline) {
+	int res = KT_UNKNOWN_ERROR;
+	size_t pos = 0;
+	int isLastCheck = 0;
+
+	if (follow == NULL || log == NULL) return KT_INVALID_ARGUMENT;
+
+	/* Stop request is handled before the available lines, otherwise a busy log is followed forever. */
+	if (log_follow_stop_requested) {
+		res = KT_UNEXPECTED_EOF;
+		goto cleanup;
+	}
+
+	res = SMART_FILE_getPosition(log, &pos);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	while (pos >= follow->end) {
+		uint64_t device = 0;
+		uint64_t inode = 0;
+		uint64_t size = 0;
+
+		res = log_follow_find_line_end(follow, log, pos, isLastCheck || log_follow_stop_requested);
+		if (res != KT_OK) goto cleanup;
+
+		if (pos < follow->end) break;
+
+		if (isLastCheck || log_follow_stop_requested) {
+			res = KT_UNEXPECTED_EOF;
+			goto cleanup;
+		}
+
+		/* File name is taken by another file or the file is truncated. Lines written before the rotation are read with an extra check. */
+		if (LOG_FOLLOW_getFileId(follow->fname, &device, &inode, &size) != KT_OK
+				|| device != follow->device || inode != follow->inode || size < pos) {
+			follow->isRotated = 1;
+			isLastCheck = 1;
+		} else if (deadline != 0 && time(NULL) >= deadline) {
+			res = KT_TIMEOUT;
+			goto cleanup;
+		} else {
+			struct timespec interval = {0, LOG_FOLLOW_POLL_INTERVAL_NS};
+			nanosleep(&interval, NULL);
+		}
+	}
+
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
+
+int LOG_FOLLOW_isRotated(LOG_FOLLOW *follow) {
+	if (follow == NULL) return 0;
+	return follow->isRotated;
+}
+
+uint64_t LOG_FOLLOW_getDevice(LOG_FOLLOW *follow) {
+	if (follow == NULL) return 0;
+	return follow->device;
+}
+
+uint64_t LOG_FOLLOW_getInode(LOG_FOLLOW *follow) {
+	if (follow == NULL) return 0;
+	return follow->inode;
+}
+
+void LOG_FOLLOW_stop(void) {
+	log_follow_stop_requested = 1;
+}
+
+int LOG_FOLLOW_getFileId(const char *fname, uint64_t *device, uint64_t *inode, uint64_t *size) {
+	struct stat st;
+
+	if (fname == NULL || device == NULL || inode == NULL) return KT_INVALID_ARGUMENT;
+
+	if (stat(fname, &st) != 0) return KT_IO_ERROR;
+
+	*device = (uint64_t)st.st_dev;
+	*inode = (uint64_t)st.st_ino;
+	if (size != NULL) *size = (uint64_t)st.st_size;
+
+	return KT_OK;
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+#ifndef LOG_FOLLOW_H
+#define	LOG_FOLLOW_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include "smart_file.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+typedef struct LOG_FOLLOW_st LOG_FOLLOW;
+
+/**
+ * Creates an object that follows a log file that is still being written. The file
+ * is identified by its device and inode numbers, so that the rotation of the file
+ * can be detected (see #LOG_FOLLOW_waitForLine).
+ * \param fname			Name of the log file.
+ * \param follow		Output parameter for the follow object.
+ * \return KT_OK if successful, KT_IO_ERROR if the file does not exist, error code otherwise.
+ */
+int LOG_FOLLOW_new(const char *fname, LOG_FOLLOW **follow);
+void LOG_FOLLOW_free(LOG_FOLLOW *follow);
+
+/**
+ * Waits until there is a complete line (terminated with LF, CR or CR LF as for
+ * #SMART_FILE_readLine) at the current position of the log file. Line that ends with
+ * CR at the end of the file is complete when the next character is written or when
+ * following is ended. The file is polled for new data. Following is
+ * ended when the file name is taken by another file, the file is truncated or when
+ * #LOG_FOLLOW_stop is called. The lines written before the file was rotated are
+ * still returned.
+ * \param follow		Follow object.
+ * \param log			Log file opened without memory mapping.
+ * \param deadline		Time when waiting is given up or 0 to wait without a time limit.
+ * \return KT_OK if a line can be read, KT_UNEXPECTED_EOF if following is ended, KT_TIMEOUT
+ * if there is no line at \c deadline, error code otherwise. The position of the log file
+ * is not changed.
+ */
+int LOG_FOLLOW_waitForLine(LOG_FOLLOW *follow, SMART_FILE *log, time_t deadline);
+
+/**
+ * Returns non-zero value, if following was ended as the log file was rotated.
+ */
+int LOG_FOLLOW_isRotated(LOG_FOLLOW *follow);
+
+uint64_t LOG_FOLLOW_getDevice(LOG_FOLLOW *follow);
+uint64_t LOG_FOLLOW_getInode(LOG_FOLLOW *follow);
+
+/**
+ * Requests all followers to end following. Can be called from a signal handler.
+ */
+void LOG_FOLLOW_stop(void);
+
+/**
+ * Returns the device and inode numbers and the size of the file.
+ * \param fname			Name of the file.
+ * \param device		Output parameter for the device number.
+ * \param inode			Output parameter for the inode number.
+ * \param size			Output parameter for the size of the file. Can be NULL.
+ * \return KT_OK if successful, KT_IO_ERROR if the file can not be accessed, error code otherwise.
+ */
+int LOG_FOLLOW_getFileId(const char *fname, uint64_t *device, uint64_t *inode, uint64_t *size);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* LOG_FOLLOW_H */
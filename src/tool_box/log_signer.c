@@ -0,0 +1,598 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ksi/ksi.h>
+#include "logksi_err.h"
+#include "smart_file.h"
+#include "tlv_object.h"
+#include "merkle_tree.h"
+#include "sign_queue.h"
+#include "logsig_version.h"
+#include "logksi.h"
+#include "log_signer.h"
+
+/* A block that is closed and waits for its signature from the signing queue. */
+typedef struct LOG_SIGNER_BLOCK_st {
+	size_t blockNo;
+	size_t recordCount;
+	SMART_FILE *body;
+} LOG_SIGNER_BLOCK;
+
+struct LOG_SIGNER_st {
+	KSI_CTX *ksi;
+	KSI_HashAlgorithm algo;
+	size_t seedLen;
+	char *randomSource;
+	SMART_FILE *random;
+	SIGN_QUEUE *queue;
+	MERKLE_TREE *tree;
+
+	/* Input hash of the next block, that is the last leaf of the previous block. */
+	KSI_DataHash *inputHash;
+
+	/* Content of the current block or NULL if there is no block open. */
+	SMART_FILE *body;
+	size_t blockNo;
+	size_t recordCount;
+
+	size_t maxRecords;
+	unsigned int maxSeconds;
+	time_t blockDeadline;
+
+	void *sinkCtx;
+	LOG_SIGNER_SINK sink;
+	int isMagicWritten;
+	int isClosed;
+
+	/* Signer can not be used after the chain of blocks is broken. */
+	int error;
+};
+
+static void log_signer_block_free(void *obj) {
+	LOG_SIGNER_BLOCK *block = obj;
+
+	if (block == NULL) return;
+
+	SMART_FILE_close(block->body);
+	free(block);
+}
+
+static int log_signer_hash(LOG_SIGNER *signer, const unsigned char *data, size_t data_len, KSI_DataHash **hash) {
+	int res = KT_UNKNOWN_ERROR;
+	KSI_DataHasher *hsr = NULL;
+
+	res = MERKLE_TREE_getHasher(signer->tree, &hsr);
+	if (res != KT_OK) return res;
+
+	res = KSI_DataHasher_reset(hsr);
+	if (res != KSI_OK) return res;
+
+	res = KSI_DataHasher_add(hsr, data, data_len);
+	if (res != KSI_OK) return res;
+
+	return KSI_DataHasher_close(hsr, hash);
+}
+
+static int log_signer_read_seed(LOG_SIGNER *signer, KSI_OctetString **seed) {
+	int res = KT_UNKNOWN_ERROR;
+	unsigned char buf[KSI_MAX_IMPRINT_LEN];
+	size_t count = 0;
+
+	if (signer->random == NULL) {
+		res = SMART_FILE_open(signer->randomSource != NULL ? signer->randomSource : LOG_SIGNER_DEFAULT_RANDOM, "rb", &signer->random);
+		if (res != SMART_FILE_OK) return res;
+	}
+
+	res = SMART_FILE_read(signer->random, buf, signer->seedLen, &count);
+	if (res != SMART_FILE_OK) return res;
+	if (count != signer->seedLen) return KT_IO_ERROR;
+
+	return KSI_OctetString_new(signer->ksi, buf, count, seed);
+}
+
+static int log_signer_open_block(LOG_SIGNER *signer) {
+	int res = KT_UNKNOWN_ERROR;
+	KSI_OctetString *seed = NULL;
+	SMART_FILE *body = NULL;
+
+	res = log_signer_read_seed(signer, &seed);
+	if (res != KT_OK) goto cleanup;
+
+	res = MERKLE_TREE_reset(signer->tree, signer->algo, KSI_DataHash_ref(signer->inputHash), KSI_OctetString_ref(seed));
+	if (res != KT_OK) goto cleanup;
+
+	res = SMART_FILE_open("<block>", "wM", &body);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	res = tlv_element_write_header(signer->ksi, signer->algo, seed, signer->inputHash, body);
+	if (res != KT_OK) goto cleanup;
+
+	signer->body = body;
+	signer->blockNo++;
+	signer->recordCount = 0;
+	signer->blockDeadline = 0;
+	body = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	KSI_OctetString_free(seed);
+	SMART_FILE_close(body);
+
+	return res;
+}
+
+static int log_signer_add_metadata(LOG_SIGNER *signer, const char *value) {
+	int res = KT_UNKNOWN_ERROR;
+	MetaDataRecord *metaData = NULL;
+	KSI_DataHash *hash = NULL;
+	unsigned char *buf = NULL;
+	size_t buf_len = 0;
+
+	res = MetaDataRecord_new(signer->ksi, signer->recordCount, META_DATA_BLOCK_CLOSE_REASON, value, &metaData);
+	if (res != KT_OK) goto cleanup;
+
+	res = MetaDataRecord_serialize(signer->ksi, metaData, &buf, &buf_len);
+	if (res != KSI_OK) goto cleanup;
+
+	res = log_signer_hash(signer, buf, buf_len, &hash);
+	if (res != KSI_OK) goto cleanup;
+
+	res = SMART_FILE_write(signer->body, buf, buf_len, NULL);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	res = MERKLE_TREE_addRecordHash(signer->tree, 1, hash);
+	if (res != KT_OK) goto cleanup;
+
+	signer->recordCount++;
+	res = KT_OK;
+
+cleanup:
+
+	MetaDataRecord_free(metaData);
+	KSI_DataHash_free(hash);
+	free(buf);
+
+	return res;
+}
+
+/* Appends the signature to the block and passes the whole block to the sink. */
+static int log_signer_write_block(LOG_SIGNER *signer, LOG_SIGNER_BLOCK *block, KSI_Signature *sig) {
+	int res = KT_UNKNOWN_ERROR;
+	unsigned char *buf = NULL;
+	size_t buf_len = 0;
+	size_t count = 0;
+
+	res = tlv_element_write_signature_block(signer->ksi, block->recordCount, sig, block->body);
+	if (res != KT_OK) goto cleanup;
+
+	res = SMART_FILE_getPosition(block->body, &buf_len);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	res = SMART_FILE_rewind(block->body);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	buf = (unsigned char*)malloc(buf_len);
+	if (buf == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	res = SMART_FILE_read(block->body, buf, buf_len, &count);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	if (count != buf_len) {
+		res = KT_IO_ERROR;
+		goto cleanup;
+	}
+
+	if (!signer->isMagicWritten) {
+		res = signer->sink(signer->sinkCtx, 0, 0, (const unsigned char*)LOGSIG_VERSION_toString(LOGSIG12), MAGIC_SIZE);
+		if (res != KT_OK) goto cleanup;
+		signer->isMagicWritten = 1;
+	}
+
+	res = signer->sink(signer->sinkCtx, block->blockNo, block->recordCount, buf, buf_len);
+	if (res != KT_OK) goto cleanup;
+
+	res = KT_OK;
+
+cleanup:
+
+	free(buf);
+
+	return res;
+}
+
+/**
+ * Takes the oldest block from the signing queue and passes it to the sink. If \c wait
+ * is not set and the oldest block is not signed yet, \c written is 0.
+ */
+static int log_signer_write_next(LOG_SIGNER *signer, int wait, int *written) {
+	int res = KT_UNKNOWN_ERROR;
+	LOG_SIGNER_BLOCK *block = NULL;
+	KSI_Signature *sig = NULL;
+	int error = KT_OK;
+
+	*written = 0;
+
+	res = SIGN_QUEUE_getNext(signer->queue, wait, (void**)&block, &sig, &error);
+	if (res != KT_OK) goto cleanup;
+	if (block == NULL) goto cleanup;
+
+	if (sig == NULL) {
+		res = (error != KT_OK) ? error : KT_SIGNING_FAILURE;
+		goto cleanup;
+	}
+
+	res = log_signer_write_block(signer, block, sig);
+	if (res != KT_OK) goto cleanup;
+
+	*written = 1;
+	res = KT_OK;
+
+cleanup:
+
+	log_signer_block_free(block);
+	KSI_Signature_free(sig);
+
+	return res;
+}
+
+static int log_signer_write_signed(LOG_SIGNER *signer, int wait) {
+	int res = KT_OK;
+	int written = 0;
+
+	if (wait) {
+		while (res == KT_OK && SIGN_QUEUE_getCount(signer->queue) > 0) {
+			res = log_signer_write_next(signer, 1, &written);
+		}
+	} else {
+		do {
+			res = log_signer_write_next(signer, 0, &written);
+		} while (res == KT_OK && written);
+	}
+
+	return res;
+}
+
+/**
+ * Closes the current block and adds its root hash to the signing queue. If \c reason
+ * is not NULL, it is recorded with a meta-record. If the queue is full, the oldest block
+ * is waited for.
+ */
+static int log_signer_close_block(LOG_SIGNER *signer, const char *reason) {
+	int res = KT_UNKNOWN_ERROR;
+	LOG_SIGNER_BLOCK *block = NULL;
+	KSI_DataHash *root = NULL;
+	KSI_DataHash *lastLeaf = NULL;
+	int written = 0;
+
+	if (reason != NULL) {
+		res = log_signer_add_metadata(signer, reason);
+		if (res != KT_OK) goto cleanup;
+	}
+
+	res = MERKLE_TREE_calculateRootHash(signer->tree, &root);
+	if (res != KT_OK) goto cleanup;
+
+	res = MERKLE_TREE_getPrevLeaf(signer->tree, &lastLeaf);
+	if (res != KT_OK) goto cleanup;
+
+	if (SIGN_QUEUE_isFull(signer->queue)) {
+		res = log_signer_write_next(signer, 1, &written);
+		if (res != KT_OK) goto cleanup;
+	}
+
+	block = (LOG_SIGNER_BLOCK*)malloc(sizeof(LOG_SIGNER_BLOCK));
+	if (block == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	block->blockNo = signer->blockNo;
+	block->recordCount = signer->recordCount;
+	block->body = signer->body;
+	signer->body = NULL;
+
+	res = SIGN_QUEUE_add(signer->queue, root, LOGKSI_calculateAggregationLevel(LOGSIG12, block->recordCount), block, log_signer_block_free);
+	if (res != KT_OK) goto cleanup;
+	block = NULL;
+
+	KSI_DataHash_free(signer->inputHash);
+	signer->inputHash = lastLeaf;
+	lastLeaf = NULL;
+	signer->recordCount = 0;
+	signer->blockDeadline = 0;
+
+	res = KT_OK;
+
+cleanup:
+
+	log_signer_block_free(block);
+	KSI_DataHash_free(root);
+	KSI_DataHash_free(lastLeaf);
+
+	return res;
+}
+
+static int log_signer_check_state(LOG_SIGNER *signer) {
+	if (signer == NULL) return KT_INVALID_ARGUMENT;
+	if (signer->error != KT_OK) return signer->error;
+	if (signer->isClosed || signer->sink == NULL) return KT_INVALID_ARGUMENT;
+	return KT_OK;
+}
+
+static int log_signer_is_started(LOG_SIGNER *signer) {
+	return signer->blockNo > 0;
+}
+
+int LOG_SIGNER_new(KSI_CTX *ksi, const char *url, const char *user, const char *key, KSI_HashAlgorithm algo, size_t maxPending, LOG_SIGNER **signer) {
+	int res = KT_UNKNOWN_ERROR;
+	LOG_SIGNER *tmp = NULL;
+
+	if (ksi == NULL || url == NULL || maxPending == 0 || signer == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	tmp = (LOG_SIGNER*)malloc(sizeof(LOG_SIGNER));
+	if (tmp == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	tmp->ksi = ksi;
+	tmp->algo = algo;
+	tmp->seedLen = KSI_getHashLength(algo);
+	tmp->randomSource = NULL;
+	tmp->random = NULL;
+	tmp->queue = NULL;
+	tmp->tree = NULL;
+	tmp->inputHash = NULL;
+	tmp->body = NULL;
+	tmp->blockNo = 0;
+	tmp->recordCount = 0;
+	tmp->maxRecords = 0;
+	tmp->maxSeconds = 0;
+	tmp->blockDeadline = 0;
+	tmp->sinkCtx = NULL;
+	tmp->sink = NULL;
+	tmp->isMagicWritten = 0;
+	tmp->isClosed = 0;
+	tmp->error = KT_OK;
+
+	if (tmp->seedLen == 0 || tmp->seedLen > KSI_MAX_IMPRINT_LEN) {
+		res = KT_UNKNOWN_HASH_ALG;
+		goto cleanup;
+	}
+
+	res = KSI_DataHash_createZero(ksi, algo, &tmp->inputHash);
+	if (res != KSI_OK) goto cleanup;
+
+	res = MERKLE_TREE_new(ksi, &tmp->tree);
+	if (res != KT_OK) goto cleanup;
+
+	res = SIGN_QUEUE_new(ksi, url, user, key, KSI_HASHALG_INVALID_VALUE, maxPending, &tmp->queue);
+	if (res != KT_OK) goto cleanup;
+
+	*signer = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	LOG_SIGNER_free(tmp);
+
+	return res;
+}
+
+void LOG_SIGNER_free(LOG_SIGNER *signer) {
+	if (signer == NULL) return;
+
+	SIGN_QUEUE_free(signer->queue);
+	MERKLE_TREE_free(signer->tree);
+	KSI_DataHash_free(signer->inputHash);
+	SMART_FILE_close(signer->body);
+	SMART_FILE_close(signer->random);
+	free(signer->randomSource);
+	free(signer);
+}
+
+int LOG_SIGNER_setSink(LOG_SIGNER *signer, void *ctx, LOG_SIGNER_SINK sink) {
+	if (signer == NULL || sink == NULL || log_signer_is_started(signer)) return KT_INVALID_ARGUMENT;
+
+	signer->sinkCtx = ctx;
+	signer->sink = sink;
+
+	return KT_OK;
+}
+
+int LOG_SIGNER_setBlockLimits(LOG_SIGNER *signer, size_t maxRecords, unsigned int maxSeconds) {
+	if (signer == NULL) return KT_INVALID_ARGUMENT;
+
+	signer->maxRecords = maxRecords;
+	signer->maxSeconds = maxSeconds;
+
+	return KT_OK;
+}
+
+int LOG_SIGNER_setInputHash(LOG_SIGNER *signer, KSI_DataHash *hash) {
+	KSI_HashAlgorithm algo = KSI_HASHALG_INVALID_VALUE;
+
+	if (signer == NULL || hash == NULL || log_signer_is_started(signer)) return KT_INVALID_ARGUMENT;
+
+	/* Input hash is the last leaf of a tree, thus it must be of the same algorithm. */
+	if (KSI_DataHash_getHashAlg(hash, &algo) != KSI_OK || algo != signer->algo) return KT_INVALID_ARGUMENT;
+
+	KSI_DataHash_free(signer->inputHash);
+	signer->inputHash = KSI_DataHash_ref(hash);
+
+	return KT_OK;
+}
+
+int LOG_SIGNER_setRandomSource(LOG_SIGNER *signer, const char *fname) {
+	char *tmp = NULL;
+
+	if (signer == NULL || fname == NULL || log_signer_is_started(signer)) return KT_INVALID_ARGUMENT;
+
+	tmp = (char*)malloc(strlen(fname) + 1);
+	if (tmp == NULL) return KT_OUT_OF_MEMORY;
+	strcpy(tmp, fname);
+
+	free(signer->randomSource);
+	signer->randomSource = tmp;
+	SMART_FILE_close(signer->random);
+	signer->random = NULL;
+
+	return KT_OK;
+}
+
+int LOG_SIGNER_addRecord(LOG_SIGNER *signer, const unsigned char *record, size_t record_len) {
+	int res = KT_UNKNOWN_ERROR;
+	KSI_DataHash *hash = NULL;
+
+	res = log_signer_check_state(signer);
+	if (res != KT_OK) return res;
+
+	if (record == NULL && record_len > 0) return KT_INVALID_ARGUMENT;
+
+	/* A record must not be added to a block whose time limit has already passed. */
+	if (signer->body != NULL && signer->blockDeadline > 0 && time(NULL) >= signer->blockDeadline) {
+		res = log_signer_close_block(signer, "Block closed due to time limit.");
+		if (res != KT_OK) goto cleanup;
+	}
+
+	if (signer->body == NULL) {
+		res = log_signer_open_block(signer);
+		if (res != KT_OK) goto cleanup;
+	}
+
+	/* Newline character is not used in hash calculation, as in logksi create. */
+	res = log_signer_hash(signer, record != NULL ? record : (const unsigned char*)"", record_len, &hash);
+	if (res != KSI_OK) goto cleanup;
+
+	res = MERKLE_TREE_addRecordHash(signer->tree, 0, hash);
+	if (res != KT_OK) goto cleanup;
+
+	signer->recordCount++;
+
+	if (signer->maxSeconds > 0 && signer->recordCount == 1) {
+		signer->blockDeadline = time(NULL) + signer->maxSeconds;
+	}
+
+	if (signer->maxRecords > 0 && signer->recordCount >= signer->maxRecords) {
+		res = log_signer_close_block(signer, NULL);
+		if (res != KT_OK) goto cleanup;
+	}
+
+	res = LOG_SIGNER_poll(signer, 0);
+	if (res != KT_OK) goto cleanup;
+
+	res = KT_OK;
+
+cleanup:
+
+	if (res != KT_OK && signer->error == KT_OK) signer->error = res;
+	KSI_DataHash_free(hash);
+
+	return res;
+}
+
+int LOG_SIGNER_closeBlock(LOG_SIGNER *signer) {
+	int res = KT_UNKNOWN_ERROR;
+
+	res = log_signer_check_state(signer);
+	if (res != KT_OK) return res;
+
+	if (signer->body == NULL || signer->recordCount == 0) return KT_OK;
+
+	/* The reason of closing a block that is not full is recorded with a meta-record. */
+	res = log_signer_close_block(signer, "Block closed on request.");
+	if (res != KT_OK) signer->error = res;
+
+	return res;
+}
+
+int LOG_SIGNER_poll(LOG_SIGNER *signer, int wait) {
+	int res = KT_UNKNOWN_ERROR;
+
+	if (signer == NULL) return KT_INVALID_ARGUMENT;
+	if (signer->error != KT_OK) return signer->error;
+
+	if (signer->body != NULL && signer->blockDeadline > 0 && time(NULL) >= signer->blockDeadline) {
+		res = log_signer_close_block(signer, "Block closed due to time limit.");
+		if (res != KT_OK) goto cleanup;
+	}
+
+	res = log_signer_write_signed(signer, wait);
+	if (res != KT_OK) goto cleanup;
+
+	res = KT_OK;
+
+cleanup:
+
+	if (res != KT_OK) signer->error = res;
+
+	return res;
+}
+
+int LOG_SIGNER_close(LOG_SIGNER *signer) {
+	int res = KT_UNKNOWN_ERROR;
+
+	res = log_signer_check_state(signer);
+	if (res != KT_OK) return res;
+
+	/* As with logksi create, the last block exists even if there are no records. */
+	if (signer->body == NULL) {
+		res = log_signer_open_block(signer);
+		if (res != KT_OK) goto cleanup;
+	}
+
+	res = log_signer_close_block(signer, "Block closed due to file closure.");
+	if (res != KT_OK) goto cleanup;
+
+	res = log_signer_write_signed(signer, 1);
+	if (res != KT_OK) goto cleanup;
+
+	signer->isClosed = 1;
+	res = KT_OK;
+
+cleanup:
+
+	if (res != KT_OK) signer->error = res;
+
+	return res;
+}
+
+int LOG_SIGNER_getLastLeaf(LOG_SIGNER *signer, KSI_DataHash **hash) {
+	if (signer == NULL || hash == NULL) return KT_INVALID_ARGUMENT;
+
+	*hash = KSI_DataHash_ref(signer->inputHash);
+
+	return KT_OK;
+}
+
+size_t LOG_SIGNER_getPendingCount(LOG_SIGNER *signer) {
+	if (signer == NULL) return 0;
+	return SIGN_QUEUE_getCount(signer->queue);
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+#ifndef LOG_SIGNER_H
+#define	LOG_SIGNER_H
+
+#include <stddef.h>
+#include <ksi/ksi.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/**
+ * Log signer is the in-process counterpart of \c logksi \c create. Log records are
+ * pushed from memory buffers, blocks are built and signed asynchronously and the
+ * resulting log signature file is passed to the sink, block by block. The output is
+ * the same as the log signature file created by \c logksi \c create, so it can be
+ * verified, extended and extracted with logksi.
+ *
+ * All functions return KT_OK if successful, error code otherwise (see logksi_err.h).
+ * The functions must not be called concurrently for the same signer.
+ */
+typedef struct LOG_SIGNER_st LOG_SIGNER;
+
+/* Source of the random seeds for masking, if not set with #LOG_SIGNER_setRandomSource. */
+#define LOG_SIGNER_DEFAULT_RANDOM "/dev/urandom"
+
+/**
+ * Sink of the log signature file. It is called with the magic of the log signature
+ * file (\c blockNo is 0) before the first block and then with every signed block in
+ * order. The data is only valid during the call.
+ * \param ctx			User context given to #LOG_SIGNER_setSink.
+ * \param blockNo		Number of the block (starting from 1) or 0 for the magic.
+ * \param recordCount	Count of records in the block, including meta-records.
+ * \param data			Serialized block (block header, meta-records and block signature).
+ * \param data_len		Size of the data.
+ * \return KT_OK if successful. Any other value stops the signer and is returned to the caller.
+ */
+typedef int (*LOG_SIGNER_SINK)(void *ctx, size_t blockNo, size_t recordCount, const unsigned char *data, size_t data_len);
+
+/**
+ * Creates a new log signer.
+ * \param ksi			KSI context.
+ * \param url			Aggregator URL.
+ * \param user			Aggregator user.
+ * \param key			Aggregator key.
+ * \param algo			Hash algorithm used to hash the records and to build Merkle trees.
+ * \param maxPending	Maximum count of blocks that can wait for the signature at once.
+ * \param signer		Output parameter for the signer.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int LOG_SIGNER_new(KSI_CTX *ksi, const char *url, const char *user, const char *key, KSI_HashAlgorithm algo, size_t maxPending, LOG_SIGNER **signer);
+
+/**
+ * Frees the signer. Blocks that are not signed yet are discarded, call #LOG_SIGNER_close
+ * first to get all the blocks signed.
+ */
+void LOG_SIGNER_free(LOG_SIGNER *signer);
+
+/**
+ * Sets the sink of the log signature file. Must be set before the first record is added.
+ */
+int LOG_SIGNER_setSink(LOG_SIGNER *signer, void *ctx, LOG_SIGNER_SINK sink);
+
+/**
+ * Sets the limits of a block. A block is closed when it has \c maxRecords records or
+ * \c maxSeconds have passed since its first record. The time limit is checked before a
+ * record is added, so that the record goes to the next block, and by #LOG_SIGNER_poll. 0 disables the limit. By default only an
+ * explicit call of #LOG_SIGNER_closeBlock closes a block.
+ */
+int LOG_SIGNER_setBlockLimits(LOG_SIGNER *signer, size_t maxRecords, unsigned int maxSeconds);
+
+/**
+ * Sets the input hash of the first block, e.g. the last leaf of the previous log
+ * signature file (see #LOG_SIGNER_getLastLeaf). Zero hash is used by default. Must be
+ * set before the first record is added. Reference is taken.
+ */
+int LOG_SIGNER_setInputHash(LOG_SIGNER *signer, KSI_DataHash *hash);
+
+/**
+ * Sets the file to read the random seeds from (see #LOG_SIGNER_DEFAULT_RANDOM). Must be
+ * set before the first record is added.
+ */
+int LOG_SIGNER_setRandomSource(LOG_SIGNER *signer, const char *fname);
+
+/**
+ * Adds a log record. Newline character at the end of the record must not be included.
+ * Blocks that are already signed are passed to the sink, but the function does not
+ * wait for any signature unless \c maxPending blocks are waiting for the signature.
+ */
+int LOG_SIGNER_addRecord(LOG_SIGNER *signer, const unsigned char *record, size_t record_len);
+
+/**
+ * Closes the current block and sends its root hash to be signed. Does nothing if
+ * there are no records in the current block.
+ */
+int LOG_SIGNER_closeBlock(LOG_SIGNER *signer);
+
+/**
+ * Closes the current block if its time limit has passed and passes the signed blocks
+ * to the sink. If \c wait is set, the function blocks until all closed blocks are signed.
+ */
+int LOG_SIGNER_poll(LOG_SIGNER *signer, int wait);
+
+/**
+ * Closes the last block (with a meta-record, as \c logksi \c create does at the end
+ * of a log file) and waits until all the blocks are signed and passed to the sink.
+ * Records can not be added afterwards.
+ */
+int LOG_SIGNER_close(LOG_SIGNER *signer);
+
+/**
+ * Returns the last leaf of the last closed block, that is the input hash of the next
+ * block. It can be used to link the next log signature file with this one.
+ * The returned value must be freed by the user.
+ */
+int LOG_SIGNER_getLastLeaf(LOG_SIGNER *signer, KSI_DataHash **hash);
+
+size_t LOG_SIGNER_getPendingCount(LOG_SIGNER *signer);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* LOG_SIGNER_H */
@@ -22,6 +22,8 @@
 #include "logksi_err.h"
 #include "logksi.h"
 #include "logksi_impl.h"
+#include "logline_pipeline.h"
+#include "block_index.h"
 
 static void extract_task_free_and_clear_internals(EXTRACT_TASK *obj);
 static void sign_task_free_and_clear_internals(SIGN_TASK *obj);
@@ -65,6 +67,10 @@ void LOGKSI_initialize(LOGKSI *obj) {
 	obj->logLine = NULL;
 	obj->logLine_capacity = 0;
 	obj->logLine_len = 0;
+	obj->logLineSpan = NULL;
+	obj->logLineSpan_len = 0;
+	obj->logLinePipeline = NULL;
+	obj->index = NULL;
 
 	obj->logksiVerRes = LOGKSI_VER_RES_INVALID;
 
@@ -105,14 +111,15 @@ static int logksi_get_line_buffer(LOGKSI *logksi, int incr, char **buf, size_t *
 	return KT_OK;
 }
 
-int LOGKSI_readLine(LOGKSI *logksi, SMART_FILE *file) {
+static int logksi_read_line_copy(LOGKSI *logksi, SMART_FILE *file) {
 	int res = KT_UNKNOWN_ERROR;
 	int i = 0;
 	char *buf = NULL;
 	size_t buf_cap;
 	size_t read_count = 0;
 
-	if (logksi == NULL || file == NULL) return KT_INVALID_ARGUMENT;
+	logksi->logLineSpan = NULL;
+	logksi->logLineSpan_len = 0;
 
 	do {
 		size_t c = 0;
@@ -134,11 +141,109 @@ int LOGKSI_readLine(LOGKSI *logksi, SMART_FILE *file) {
 	return KT_OK;
 }
 
+int LOGKSI_readLineSpan(LOGKSI *logksi, SMART_FILE *file, const char **line, size_t *line_len) {
+	int res = KT_UNKNOWN_ERROR;
+
+	if (logksi == NULL || file == NULL || line == NULL || line_len == NULL) return KT_INVALID_ARGUMENT;
+
+	/* Memory mapped file returns the whole line without copying. */
+	res = SMART_FILE_readLineSpan(file, line, line_len);
+	if (res == SMART_FILE_OK) {
+		/* Same limit as for the lines that are copied (see logksi_get_line_buffer). */
+		if (*line_len + 2 > LINE_BUFFER_LIMIT) return KT_INDEX_OVF;
+
+		logksi->logLineSpan = *line;
+		logksi->logLineSpan_len = *line_len;
+		return KT_OK;
+	} else if (res != SMART_FILE_INVALID_MODE) {
+		return res;
+	}
+
+	res = logksi_read_line_copy(logksi, file);
+	if (res != KT_OK) return res;
+
+	*line = logksi->logLine;
+	*line_len = logksi->logLine_len - 1;
+
+	return KT_OK;
+}
+
+int LOGKSI_readLine(LOGKSI *logksi, SMART_FILE *file) {
+	int res = KT_UNKNOWN_ERROR;
+	const char *line = NULL;
+	size_t line_len = 0;
+
+	if (logksi == NULL || file == NULL) return KT_INVALID_ARGUMENT;
+
+	res = LOGKSI_readLineSpan(logksi, file, &line, &line_len);
+	if (res != KT_OK) return res;
+
+	/* Line is already in logLine, if the file is not memory mapped. */
+	if (line == logksi->logLine) return KT_OK;
+
+	return LOGKSI_setLine(logksi, line, line_len);
+}
+
+int LOGKSI_setLine(LOGKSI *logksi, const char *line, size_t line_len) {
+	int res = KT_UNKNOWN_ERROR;
+	int i = 0;
+	char *buf = NULL;
+	size_t buf_cap = 0;
+
+	if (logksi == NULL || (line == NULL && line_len > 0)) return KT_INVALID_ARGUMENT;
+
+	logksi->logLineSpan = NULL;
+	logksi->logLineSpan_len = 0;
+
+	do {
+		res = logksi_get_line_buffer(logksi, i > 0, &buf, &buf_cap);
+		if (res != KT_OK) return res;
+		i++;
+	} while (buf_cap < line_len + 2);
+
+	if (line_len > 0) memcpy(buf, line, line_len);
+	buf[line_len] = '\n';
+	buf[line_len + 1] = '\0';
+	logksi->logLine_len = line_len + 1;
+
+	return KT_OK;
+}
+
+void LOGKSI_setLineSpan(LOGKSI *logksi, const char *line, size_t line_len) {
+	if (logksi == NULL) return;
+
+	logksi->logLineSpan = (line == NULL) ? "" : line;
+	logksi->logLineSpan_len = (line == NULL) ? 0 : line_len;
+}
+
+int LOGKSI_getLine(LOGKSI *logksi, const char **line) {
+	int res = KT_UNKNOWN_ERROR;
+
+	if (logksi == NULL || line == NULL) return KT_INVALID_ARGUMENT;
+
+	if (logksi->logLineSpan != NULL) {
+		res = LOGKSI_setLine(logksi, logksi->logLineSpan, logksi->logLineSpan_len);
+		if (res != KT_OK) return res;
+	}
+
+	/* Nothing is read yet. */
+	if (logksi->logLine == NULL) {
+		res = LOGKSI_setLine(logksi, NULL, 0);
+		if (res != KT_OK) return res;
+	}
+
+	*line = logksi->logLine;
+
+	return KT_OK;
+}
+
 void LOGKSI_freeAndClearInternals(LOGKSI *logksi) {
 	if (logksi == NULL) return;
 
 	MERKLE_TREE_free(logksi->tree);
 	if (logksi->logLine) free(logksi->logLine);
+	LOGLINE_PIPELINE_free(logksi->logLinePipeline);
+	BLOCK_INDEX_free(logksi->index);
 
 	extract_task_free_and_clear_internals(&logksi->task.extract);
 	sign_task_free_and_clear_internals(&logksi->task.sign);
@@ -175,34 +280,40 @@ int LOGKSI_initNextBlock(LOGKSI *logksi) {
 	return KT_OK;
 }
 
-int LOGKSI_get_aggregation_level(LOGKSI *logksi) {
+int LOGKSI_calculateAggregationLevel(LOGSIG_VERSION version, size_t recordCount) {
 	int level = 0;
-	if (logksi != NULL) {
-		if (logksi->file.version == LOGSIG11) {
-			/* To be backward compatible with a bug in LOGSIG11 implementation of rsyslog-ksi,
-			 * we must sign tree hashes with level 0 regardless of the tree height. */
-			level = 0;
-		} else if (logksi->block.recordCount){
-			/* LOGSIG12 implementation:
-			 * Calculate the aggregation level from the number of records in the block (tree).
-			 * Level is log2 dependent on the number of records,
-			 * and is the same for all perfect and smaller trees.
-			 * E.g. level = 4 for 5.. 8 records
-			 *      level = 5 for 9..16 records etc.
-			 * Level for the single node tree that uses blinding masks is 1. */
-			level = 1;
-			size_t c = logksi->block.recordCount - 1;
-			while (c) {
-				level++;
-				c = c / 2;
-			}
+
+	if (version == LOGSIG11) {
+		/* To be backward compatible with a bug in LOGSIG11 implementation of rsyslog-ksi,
+		 * we must sign tree hashes with level 0 regardless of the tree height. */
+		level = 0;
+	} else if (recordCount) {
+		/* LOGSIG12 implementation:
+		 * Calculate the aggregation level from the number of records in the block (tree).
+		 * Level is log2 dependent on the number of records,
+		 * and is the same for all perfect and smaller trees.
+		 * E.g. level = 4 for 5.. 8 records
+		 *      level = 5 for 9..16 records etc.
+		 * Level for the single node tree that uses blinding masks is 1. */
+		size_t c = recordCount - 1;
+
+		level = 1;
+		while (c) {
+			level++;
+			c = c / 2;
 		}
-		/* If there are no records in the block, the aggregation level is 0,
-		 * as if we are signing a record hash directly. */
 	}
+	/* If there are no records in the block, the aggregation level is 0,
+	 * as if we are signing a record hash directly. */
+
 	return level;
 }
 
+int LOGKSI_get_aggregation_level(LOGKSI *logksi) {
+	if (logksi == NULL) return 0;
+	return LOGKSI_calculateAggregationLevel(logksi->file.version, logksi->block.recordCount);
+}
+
 int LOGKSI_hasWarnings(LOGKSI *logksi) {
 	if (logksi) {
 		if (logksi->task.integrate.warningSignatures || logksi->file.warningTreeHashes || logksi->file.warningLegacy) {
@@ -254,11 +365,108 @@ int LOGKSI_getErrorLevel(LOGKSI *logksi) {
 	return logksi->logksiVerRes;
 }
 
+int LOGKSI_setBlockSigOffset(LOGKSI *logksi, SMART_FILE *sig, size_t len) {
+	size_t pos = 0;
+
+	if (logksi == NULL || sig == NULL) return KT_INVALID_ARGUMENT;
+	if (logksi->index == NULL) return KT_OK;
+
+	/* Position is not available for pipes. */
+	if (SMART_FILE_getPosition(sig, &pos) != SMART_FILE_OK || pos < len) {
+		logksi->block.sigOffset = BLOCK_INDEX_UNKNOWN_OFFSET;
+	} else {
+		logksi->block.sigOffset = pos - len;
+	}
+
+	return KT_OK;
+}
+
+int LOGKSI_setBlockLogOffset(LOGKSI *logksi, SMART_FILE *log) {
+	size_t pos = 0;
+
+	if (logksi == NULL || log == NULL) return KT_INVALID_ARGUMENT;
+	if (logksi->index == NULL) return KT_OK;
+
+	/* If lines are read ahead, the position of the file is not the position of the next line. */
+	if (LOGLINE_PIPELINE_hasMoreData(logksi->logLinePipeline) || SMART_FILE_getPosition(log, &pos) != SMART_FILE_OK) {
+		logksi->block.logOffset = BLOCK_INDEX_UNKNOWN_OFFSET;
+	} else {
+		logksi->block.logOffset = pos;
+	}
+
+	return KT_OK;
+}
+
+int LOGKSI_addBlockToIndex(LOGKSI *logksi) {
+	BLOCK_INDEX_ENTRY entry;
+	size_t nofLines = 0;
+
+	if (logksi == NULL) return KT_INVALID_ARGUMENT;
+	if (logksi->index == NULL) return KT_OK;
+
+	if (logksi->block.recordCount > logksi->block.nofMetaRecords) {
+		nofLines = logksi->block.recordCount - logksi->block.nofMetaRecords;
+	}
+
+	entry.blockNo = logksi->blockNo;
+	entry.sigOffset = logksi->block.sigOffset;
+	entry.logOffset = logksi->block.logOffset;
+	entry.firstLine = logksi->block.firstLineNo;
+	entry.lastLine = logksi->block.firstLineNo + nofLines - 1;
+	entry.recordCount = logksi->block.recordCount;
+	entry.sigTime = logksi->block.sigTime_1;
+	entry.isSigned = !logksi->block.curBlockNotSigned && logksi->block.sigTime_1 > 0;
+
+	return BLOCK_INDEX_add(logksi->index, &entry);
+}
+
+int LOGKSI_skipToBlock(LOGKSI *logksi, struct BLOCK_INDEX_st *index, size_t i) {
+	const BLOCK_INDEX_ENTRY *entry = NULL;
+	size_t count = 0;
+	size_t j;
+
+	if (logksi == NULL || index == NULL) return KT_INVALID_ARGUMENT;
+
+	count = BLOCK_INDEX_getCount(index);
+	if (i > count || i < logksi->blockNo) return KT_INVALID_ARGUMENT;
+
+	/* Meta-records of the skipped blocks are counted as if the blocks were processed. */
+	for (j = logksi->blockNo; j < i; j++) {
+		entry = BLOCK_INDEX_get(index, j);
+		logksi->file.nofTotalMetarecords += entry->recordCount - (entry->lastLine + 1 - entry->firstLine);
+	}
+
+	/* Signing time of the previous block is needed to check the signing times of consecutive blocks. */
+	if (i > logksi->blockNo && i > 0 && BLOCK_INDEX_get(index, i - 1)->sigTime > 0) {
+		logksi->sigTime_0 = BLOCK_INDEX_get(index, i - 1)->sigTime;
+	}
+
+	/* If no block is processed yet, processing starts from the block i. */
+	if (logksi->blockNo < logksi->file.firstBlockNo) logksi->file.firstBlockNo = i + 1;
+
+	logksi->blockNo = i;
+	logksi->sigNo = i;
+
+	if (i < count) {
+		logksi->file.nofTotalRecordHashes = BLOCK_INDEX_get(index, i)->firstLine - 1;
+	} else if (count > 0) {
+		logksi->file.nofTotalRecordHashes = BLOCK_INDEX_get(index, count - 1)->lastLine;
+	}
+
+	logksi_reset_block_info(logksi);
+
+	/* Output hash of the skipped block is not known and can not be compared with the input hash of the next block. */
+	MERKLE_TREE_clean(logksi->tree);
+
+	return KT_OK;
+}
+
 static void extract_task_initialize(EXTRACT_TASK *obj) {
 	if (obj == NULL) return;
 	obj->info = NULL;
 	obj->metaRecord = NULL;
 	obj->metaRecord_len = 0;
+	obj->index = NULL;
 	return;
 }
 
@@ -270,6 +478,8 @@ static void sign_task_initialize(SIGN_TASK *obj) {
 	obj->noSigCreated = 0;
 	obj->noSigNo = 0;
 	obj->outSigModified = 0;
+	obj->preSigned = NULL;
+	obj->preSigned_count = 0;
 	return;
 }
 
@@ -279,12 +489,16 @@ static void verify_task_initialize(VERIFY_TASK *obj) {
 	obj->lastBlockWasSkipped = 0;
 	obj->client_id_match = NULL;
 	obj->client_id_last[0] = '\0';
+	obj->index = NULL;
+	obj->firstBlock = 0;
+	obj->lastBlock = 0;
 	return;
 }
 
 static void extend_task_initialize(EXTEND_TASK *obj) {
 	if (obj == NULL) return;
 	obj->extendedToTime = 0;
+	obj->cache = NULL;
 	return;
 }
 
@@ -304,9 +518,13 @@ static void file_info_initialize(FILE_INFO *obj) {
 	obj->nofTotalRecordHashes = 0;
 	obj->recTimeMax = 0;
 	obj->recTimeMin = 0;
+	obj->recTimeFirst = 0;
+	obj->sigTimeFirst = 0;
+	obj->firstBlockNo = 1;
 	obj->version = UNKN_VER;
 	obj->warningLegacy = 0;
 	obj->warningTreeHashes = 0;
+	obj->isPartial = 0;
 	return;
 }
 
@@ -329,6 +547,8 @@ static void block_info_initialize(BLOCK_INFO *obj) {
 	obj->recTimeMin = 0;
 	obj->recordCount = 0;
 	obj->sigTime_1 = 0;
+	obj->sigOffset = BLOCK_INDEX_UNKNOWN_OFFSET;
+	obj->logOffset = BLOCK_INDEX_UNKNOWN_OFFSET;
 	obj->signatureTLVReached = 0;
 
 	obj->hashAlgo = KSI_HASHALG_INVALID_VALUE;
@@ -346,12 +566,21 @@ static void extract_task_free_and_clear_internals(EXTRACT_TASK *obj) {
 	if (obj == NULL) return;
 	if (obj->metaRecord) free(obj->metaRecord);
 	EXTRACT_INFO_free(obj->info);
+	BLOCK_INDEX_free(obj->index);
 	extract_task_initialize(obj);
 	return;
 }
 
 static void sign_task_free_and_clear_internals(SIGN_TASK *obj) {
+	size_t i;
+
 	if (obj == NULL) return;
+
+	for (i = 0; i < obj->preSigned_count; i++) {
+		KSI_Signature_free(obj->preSigned[i]);
+	}
+	free(obj->preSigned);
+
 	sign_task_initialize(obj);
 	return;
 }
@@ -434,13 +663,131 @@ static void logksi_reset_block_info(LOGKSI *logksi) {
 	extend_task_reset_block_info(&logksi->task.extend);
 }
 
+/* Size of the position of signing a followed log file in the state file (KSISTAT11). */
+#define STATE_FILE_FOLLOW_SIZE (6 * 8)
+
+/* Maximum size of the state file magic (e.g. KSISTAT10). */
+#define STATE_FILE_MAGIC_MAX_SIZE 16
+
+/* Maximum size of the state file: magic, algorithm, digest length, digest and the position of signing. */
+#define STATE_FILE_MAX_SIZE (STATE_FILE_MAGIC_MAX_SIZE + 2 + 0xff + STATE_FILE_FOLLOW_SIZE)
+
+/**
+ * The state is kept in memory and is written into the temporary state file only when
+ * it is committed or approved, with a single write. The temporary file replaces the
+ * state file by rename, so the state file is never seen partially written.
+ */
 struct STATE_FILE_st {
 	LOGSIG_VERSION ver;
 	SMART_FILE *state_file;
+	char *fname;
+	size_t size;
 	KSI_DataHash *hash;
 	KSI_HashAlgorithm aggrAlgo;
+	STATE_FILE_FOLLOW follow;
+	int isSync;
 };
 
+static void state_file_put_uint64(unsigned char *buf, uint64_t val) {
+	int i;
+
+	for (i = 7; i >= 0; i--) {
+		buf[i] = (unsigned char)(val & 0xff);
+		val >>= 8;
+	}
+}
+
+static uint64_t state_file_get_uint64(const unsigned char *buf) {
+	uint64_t val = 0;
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		val = (val << 8) | buf[i];
+	}
+
+	return val;
+}
+
+static void state_file_follow_serialize(const STATE_FILE_FOLLOW *follow, unsigned char *buf) {
+	state_file_put_uint64(buf, follow->logDevice);
+	state_file_put_uint64(buf + 8, follow->logInode);
+	state_file_put_uint64(buf + 16, follow->logOffset);
+	state_file_put_uint64(buf + 24, follow->lineNo);
+	state_file_put_uint64(buf + 32, follow->blockNo);
+	state_file_put_uint64(buf + 40, follow->sigSize);
+}
+
+static void state_file_follow_parse(const unsigned char *buf, STATE_FILE_FOLLOW *follow) {
+	follow->logDevice = state_file_get_uint64(buf);
+	follow->logInode = state_file_get_uint64(buf + 8);
+	follow->logOffset = state_file_get_uint64(buf + 16);
+	follow->lineNo = state_file_get_uint64(buf + 24);
+	follow->blockNo = state_file_get_uint64(buf + 32);
+	follow->sigSize = state_file_get_uint64(buf + 40);
+}
+
+static int state_file_write(STATE_FILE *state) {
+	int res = KT_UNKNOWN_ERROR;
+	const char *magic = NULL;
+	size_t magic_len = 0;
+	KSI_HashAlgorithm algo = 0;
+	const unsigned char *digest = NULL;
+	size_t digest_len = 0;
+	unsigned char buf[STATE_FILE_MAX_SIZE];
+	size_t size = 0;
+
+	if (state->state_file == NULL || state->hash == NULL) return KT_OK;
+
+	magic = LOGSIG_VERSION_toString(state->ver);
+	if (magic == NULL || (magic_len = strlen(magic)) > STATE_FILE_MAGIC_MAX_SIZE) {
+		res = KT_UNKNOWN_ERROR;
+		goto cleanup;
+	}
+
+	res = KSI_DataHash_extract(state->hash, &algo, &digest, &digest_len);
+	if (res != KT_OK) goto cleanup;
+
+	if (digest_len > 0xff) {
+		res = KT_UNKNOWN_ERROR;
+		goto cleanup;
+	}
+
+	memcpy(buf, magic, magic_len);
+	size = magic_len;
+	buf[size++] = algo;
+	buf[size++] = digest_len;
+	memcpy(buf + size, digest, digest_len);
+	size += digest_len;
+
+	if (state->ver == KSISTAT11) {
+		state_file_follow_serialize(&state->follow, buf + size);
+		size += STATE_FILE_FOLLOW_SIZE;
+	}
+
+	res = SMART_FILE_rewind(state->state_file);
+	if (res != KT_OK) goto cleanup;
+	res = SMART_FILE_write(state->state_file, buf, size, NULL);
+	if (res != KT_OK) goto cleanup;
+
+	/* Remove the end of the previous state, if it was longer. */
+	if (size < state->size) {
+		res = SMART_FILE_truncate(state->state_file, size);
+		if (res != KT_OK) goto cleanup;
+	}
+	state->size = size;
+
+	if (state->isSync) {
+		res = SMART_FILE_sync(state->state_file);
+		if (res != KT_OK) goto cleanup;
+	}
+
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
+
 int STATE_FILE_open(int readOnly, const char *fname, KSI_CTX *ksi, STATE_FILE **state) {
 	int res = KT_OK;
 	SMART_FILE *tmp_in_out_file = NULL;
@@ -451,12 +798,15 @@ int STATE_FILE_open(int readOnly, const char *fname, KSI_CTX *ksi, STATE_FILE **
 	uint8_t digest_len = 0;
 	KSI_HashAlgorithm aggrAlgo = KSI_HASHALG_INVALID_VALUE;
 	size_t read_count = 0;
-
+	STATE_FILE_FOLLOW follow;
 
 	if (state == NULL) return KT_INVALID_ARGUMENT;
 
+	memset(&follow, 0, sizeof(follow));
+
 	if (SMART_FILE_doFileExist(fname)) {
 		unsigned char digest[256];
+		unsigned char follow_raw[STATE_FILE_FOLLOW_SIZE];
 		unsigned char dummy;
 
 		res = SMART_FILE_open(fname, "rb", &tmp_in_out_file);
@@ -465,6 +815,7 @@ int STATE_FILE_open(int readOnly, const char *fname, KSI_CTX *ksi, STATE_FILE **
 		ver = LOGSIG_VERSION_getFileVer(tmp_in_out_file);
 		switch(ver) {
 			case KSISTAT10:
+			case KSISTAT11:
 				res = SMART_FILE_read(tmp_in_out_file, (unsigned char*)&algo, 1, &read_count);
 				if (res != SMART_FILE_OK) goto cleanup;
 
@@ -509,6 +860,19 @@ int STATE_FILE_open(int readOnly, const char *fname, KSI_CTX *ksi, STATE_FILE **
 					goto cleanup;
 				}
 
+				/* Version 1.1 keeps the position of signing a followed log file. */
+				if (ver == KSISTAT11) {
+					res = SMART_FILE_read(tmp_in_out_file, follow_raw, sizeof(follow_raw), &read_count);
+					if (res != SMART_FILE_OK) goto cleanup;
+
+					if (read_count != sizeof(follow_raw)) {
+						res = KT_UNEXPECTED_EOF;
+						goto cleanup;
+					}
+
+					state_file_follow_parse(follow_raw, &follow);
+				}
+
 				res = SMART_FILE_read(tmp_in_out_file, &dummy, 1, &read_count);
 				if (res != SMART_FILE_OK) goto cleanup;
 
@@ -548,10 +912,25 @@ int STATE_FILE_open(int readOnly, const char *fname, KSI_CTX *ksi, STATE_FILE **
 		goto cleanup;
 	}
 
+	tmp->state_file = NULL;
+	tmp->hash = NULL;
+	tmp->fname = NULL;
+	if (fname != NULL) {
+		tmp->fname = malloc(strlen(fname) + 1);
+		if (tmp->fname == NULL) {
+			res = KT_OUT_OF_MEMORY;
+			goto cleanup;
+		}
+		strcpy(tmp->fname, fname);
+	}
+
 	tmp->ver = ver;
 	tmp->state_file = tmp_in_out_file;
+	tmp->size = 0;
 	tmp->hash = tmp_hash;
 	tmp->aggrAlgo = aggrAlgo;
+	tmp->follow = follow;
+	tmp->isSync = 0;
 	tmp_in_out_file = NULL;
 	tmp_hash = NULL;
 	*state = tmp;
@@ -563,7 +942,7 @@ cleanup:
 
 	SMART_FILE_close(tmp_in_out_file);
 	KSI_DataHash_free(tmp_hash);
-	free(tmp);
+	STATE_FILE_close(tmp);
 
 	return res;
 }
@@ -580,40 +959,6 @@ int STATE_FILE_update(STATE_FILE *state, KSI_DataHash *hash) {
 		if (res != KSI_OK) goto cleanup;
 	}
 
-	if (state->state_file != NULL) {
-		const char *magic = NULL;
-		KSI_HashAlgorithm algo = 0;
-		const unsigned char *digest = NULL;
-		size_t digest_len = 0;
-		uint8_t algo_and_len[2];
-
-		magic = LOGSIG_VERSION_toString(state->ver);
-		if (magic == NULL) {
-			res = KT_UNKNOWN_ERROR;
-			goto cleanup;
-		}
-
-		res = KSI_DataHash_extract(hash, &algo, &digest, &digest_len);
-		if (res != KT_OK) goto cleanup;
-
-		if (digest_len > 0xff) {
-			res = KT_UNKNOWN_ERROR;
-			goto cleanup;
-		}
-
-		algo_and_len[0] = algo;
-		algo_and_len[1] = digest_len;
-
-		res = SMART_FILE_rewind(state->state_file);
-		if (res != KT_OK) goto cleanup;
-		res = SMART_FILE_write(state->state_file, (const unsigned char*)magic, strlen(magic), NULL);
-		if (res != KT_OK) goto cleanup;
-		res = SMART_FILE_write(state->state_file, algo_and_len, 2, NULL);
-		if (res != KT_OK) goto cleanup;
-		res = SMART_FILE_write(state->state_file, digest, digest_len, NULL);
-		if (res != KT_OK) goto cleanup;
-	}
-
 	res = KT_OK;
 
 cleanup:
@@ -626,6 +971,7 @@ void STATE_FILE_close(STATE_FILE *state) {
 	if (state == NULL) return;
 	SMART_FILE_close(state->state_file);
 	KSI_DataHash_free(state->hash);
+	free(state->fname);
 	free(state);
 	return;
 }
@@ -647,6 +993,71 @@ int STATE_FILE_setHashAlgo(STATE_FILE *state, KSI_HashAlgorithm algo) {
 }
 
 int STATE_FILE_approve(STATE_FILE *state) {
+	int res = KT_UNKNOWN_ERROR;
+
 	if (state == NULL) return KT_INVALID_ARGUMENT;
-	return 	(state->state_file  == NULL) ? KT_OK : SMART_FILE_markConsistent(state->state_file);
-}
\ No newline at end of file
+	if (state->state_file == NULL) return KT_OK;
+
+	res = state_file_write(state);
+	if (res != KT_OK) return res;
+
+	return SMART_FILE_markConsistent(state->state_file);
+}
+
+int STATE_FILE_setSync(STATE_FILE *state, int isSync) {
+	if (state == NULL) return KT_INVALID_ARGUMENT;
+	state->isSync = isSync;
+	return KT_OK;
+}
+
+int STATE_FILE_isSync(STATE_FILE *state) {
+	if (state == NULL) return 0;
+	return state->isSync;
+}
+
+int STATE_FILE_setFollow(STATE_FILE *state, const STATE_FILE_FOLLOW *follow) {
+	if (state == NULL) return KT_INVALID_ARGUMENT;
+
+	if (follow != NULL) {
+		state->follow = *follow;
+		state->ver = KSISTAT11;
+	} else {
+		memset(&state->follow, 0, sizeof(state->follow));
+		state->ver = KSISTAT10;
+	}
+
+	return KT_OK;
+}
+
+const STATE_FILE_FOLLOW* STATE_FILE_getFollow(STATE_FILE *state) {
+	if (state == NULL || state->ver != KSISTAT11) return NULL;
+	return &state->follow;
+}
+
+int STATE_FILE_commit(STATE_FILE *state) {
+	int res = KT_UNKNOWN_ERROR;
+
+	if (state == NULL) return KT_INVALID_ARGUMENT;
+	if (state->state_file == NULL) return KT_OK;
+
+	res = state_file_write(state);
+	if (res != KT_OK) goto cleanup;
+
+	res = SMART_FILE_markConsistent(state->state_file);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	/* Temporary file replaces the state file on closing. */
+	res = SMART_FILE_close(state->state_file);
+	state->state_file = NULL;
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	res = SMART_FILE_open(state->fname, "wbT", &state->state_file);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	state->size = 0;
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
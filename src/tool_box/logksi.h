@@ -53,18 +53,107 @@ enum LOGSIG_VER_enum {
 };
 
 typedef struct STATE_FILE_st STATE_FILE;
+
+/* Position of signing a log file that is followed (see create --follow). */
+typedef struct STATE_FILE_FOLLOW_st {
+	uint64_t logDevice;		/* Device number of the log file. */
+	uint64_t logInode;		/* Inode number of the log file. */
+	uint64_t logOffset;		/* Offset of the first log line that is not signed. */
+	uint64_t lineNo;		/* Count of log lines signed. */
+	uint64_t blockNo;		/* Count of blocks in the log signature file. */
+	uint64_t sigSize;		/* Size of the log signature file. */
+} STATE_FILE_FOLLOW;
+
 int STATE_FILE_open(int readOnly, const char *fname, KSI_CTX *ksi, STATE_FILE **state);
+
+/**
+ * Sets the last leaf. The state is kept in memory and is written into the state file
+ * by #STATE_FILE_commit and #STATE_FILE_approve only.
+ * \param state		State file object.
+ * \param hash		The last leaf of the Merkle tree.
+ * \return KT_OK if successful, error code otherwise.
+ */
 int STATE_FILE_update(STATE_FILE *state, KSI_DataHash *hash);
 void STATE_FILE_close(STATE_FILE *state);
 KSI_DataHash* STATE_FILE_lastLeaf(STATE_FILE *state);
 int STATE_FILE_setHashAlgo(STATE_FILE *state, KSI_HashAlgorithm algo);
+
+/**
+ * Writes the state into the temporary state file and marks it consistent, so that
+ * the state file is replaced when it is closed.
+ * \param state		State file object.
+ * \return KT_OK if successful, error code otherwise.
+ */
 int STATE_FILE_approve(STATE_FILE *state);
 KSI_HashAlgorithm STATE_FILE_hashAlgo(STATE_FILE *state);
 
+/**
+ * Enables or disables flushing the state file to the storage device (fsync) every
+ * time it is written. By default it is disabled.
+ * \param state		State file object.
+ * \param isSync		Non-zero value to enable fsync.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int STATE_FILE_setSync(STATE_FILE *state, int isSync);
+int STATE_FILE_isSync(STATE_FILE *state);
+
+/**
+ * Sets or clears (\c follow is NULL) the position of signing a followed log file.
+ * The position is kept in the state file together with the last leaf.
+ * \param state		State file object.
+ * \param follow		Position of signing or NULL.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int STATE_FILE_setFollow(STATE_FILE *state, const STATE_FILE_FOLLOW *follow);
+
+/**
+ * Returns the position of signing a followed log file or NULL if it is not set.
+ */
+const STATE_FILE_FOLLOW* STATE_FILE_getFollow(STATE_FILE *state);
+
+/**
+ * Writes the current state and replaces the state file, like it is done on closing an
+ * approved state file (see #STATE_FILE_approve), and keeps the state file open for
+ * further updates. It is used to keep the state durable while signing has not ended.
+ * \param state		State file object.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int STATE_FILE_commit(STATE_FILE *state);
+
 void LOGKSI_initialize(LOGKSI *block);
 int LOGKSI_readLine(LOGKSI *logksi, SMART_FILE *file);
+int LOGKSI_setLine(LOGKSI *logksi, const char *line, size_t line_len);
+
+/**
+ * Reads the next line like #LOGKSI_readLine. If the file is memory mapped, the line
+ * is not copied into \c logLine and \c line points directly into the file. In that
+ * case the line is copied only if it is requested with #LOGKSI_getLine.
+ * \param logksi		LOGKSI object.
+ * \param file			Input file.
+ * \param line			Output parameter for the line (not terminated with newline nor 0).
+ * \param line_len		Output parameter for the length of the line.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int LOGKSI_readLineSpan(LOGKSI *logksi, SMART_FILE *file, const char **line, size_t *line_len);
+
+/**
+ * Sets the current line without copying it. The line must stay valid until the
+ * next line is read or set.
+ */
+void LOGKSI_setLineSpan(LOGKSI *logksi, const char *line, size_t line_len);
+
+/**
+ * Returns the current line terminated with newline and 0. If the line is not
+ * copied yet (see #LOGKSI_readLineSpan and #LOGKSI_setLineSpan), it is copied now.
+ */
+int LOGKSI_getLine(LOGKSI *logksi, const char **line);
 void LOGKSI_freeAndClearInternals(LOGKSI *logksi);
 int LOGKSI_initNextBlock(LOGKSI *logksi);
+/**
+ * Calculates the aggregation level of the root hash of a block with \c recordCount
+ * records (including meta-records) in a log signature file of the given version.
+ */
+int LOGKSI_calculateAggregationLevel(LOGSIG_VERSION version, size_t recordCount);
 int LOGKSI_get_aggregation_level(LOGKSI *logksi);
 int LOGKSI_hasWarnings(LOGKSI *logksi);
 int LOGKSI_getMaxFinalHashes(LOGKSI *logksi);
@@ -73,6 +162,33 @@ size_t LOGKSI_getNofLines(LOGKSI *logksi);
 int LOGKSI_setErrorLevel(LOGKSI *logksi, int lvl);
 int LOGKSI_getErrorLevel(LOGKSI *logksi);
 
+/**
+ * Stores the offset of the current block header in the log signature file, that is
+ * the current position of \c sig minus \c len. The offset is stored only if the block
+ * index is maintained (see #LOGKSI_addBlockToIndex).
+ */
+int LOGKSI_setBlockSigOffset(LOGKSI *logksi, SMART_FILE *sig, size_t len);
+
+/**
+ * Stores the current position of \c log as the offset of the first line of the current
+ * block. The offset is stored only if the block index is maintained.
+ */
+int LOGKSI_setBlockLogOffset(LOGKSI *logksi, SMART_FILE *log);
+
+/**
+ * Adds the current block to the block index. Does nothing if the block index is not set.
+ */
+int LOGKSI_addBlockToIndex(LOGKSI *logksi);
+
+/**
+ * Moves the state to the beginning of the block with index \c i (block number \c i + 1),
+ * as if all the blocks before it were processed. Record and meta-record counts of the
+ * skipped blocks are taken from the block index. If \c i is the count of blocks, the
+ * state is moved to the end of the log signature file. Blocks can only be skipped
+ * forward.
+ */
+int LOGKSI_skipToBlock(LOGKSI *logksi, struct BLOCK_INDEX_st *index, size_t i);
+
 #ifdef	__cplusplus
 }
 #endif
@@ -52,6 +52,8 @@ typedef struct SIGN_TASK_st {
 	size_t noSigCreated;			/* Count of signatures created for unsigned blocks. */
 	char curBlockJustReSigned;
 	char outSigModified;			/* Indicates that output signature file is actually modified. */
+	KSI_Signature **preSigned;		/* Signatures created in advance for unsigned blocks (see --max-requests). Index is noSigNo - 1. Failed requests are NULL. */
+	size_t preSigned_count;
 } SIGN_TASK;
 
 typedef struct INTEGRATE_TASK_st {
@@ -64,10 +66,12 @@ typedef struct EXTRACT_TASK_st {
 	EXTRACT_INFO *info;
 	unsigned char *metaRecord;
 	size_t metaRecord_len;
+	struct BLOCK_INDEX_st *index;	/* If set, only the blocks that contain extract positions are processed (see block_index.h). */
 } EXTRACT_TASK;
 
 typedef struct EXTEND_TASK_st {
 	uint64_t extendedToTime;
+	struct EXTEND_CACHE_st *cache;	/* If set, calendar hash chains are reused from the cache (see extend_cache.h). */
 } EXTEND_TASK;
 
 typedef struct VERIFY_TASK_st {
@@ -75,6 +79,9 @@ typedef struct VERIFY_TASK_st {
 	REGEXP *client_id_match;		/* A regular expression value to be matched with KSI signatures. */
 	char lastBlockWasSkipped;		/* If block is skipped (--continue-on-failure) due to verification failure, this is set. It is cleared in process_ksi_signature or process_block_signature. */
 	char errSignTime;				/* Signing time check failed. */
+	struct BLOCK_INDEX_st *index;	/* If set, only the blocks firstBlock to lastBlock of the index are verified (see verify --jobs). Not owned. */
+	size_t firstBlock;				/* Index of the first verified block in index. */
+	size_t lastBlock;				/* Index of the last verified block in index. */
 } VERIFY_TASK;
 
 typedef struct TASK_SPECIFIC_st {
@@ -93,8 +100,12 @@ typedef struct FILE_INFO_st {
 	size_t nofTotaHashFails;		/* Overall count of hahs failures inside log signature. */
 	uint64_t recTimeMin;			/* The lowest record time value in the log file, extracted from the log line. */
 	uint64_t recTimeMax;			/* The highest record time value in the log file, extracted from the log line. */
+	uint64_t recTimeFirst;			/* The lowest record time value in the first block. */
+	uint64_t sigTimeFirst;			/* Signing time of the first block. */
+	size_t firstBlockNo;			/* Number of the first block that is processed (see LOGKSI_skipToBlock). */
 	char warningLegacy;
 	char warningTreeHashes;
+	char isPartial;					/* Set if some of the blocks are skipped with the block index (see LOGKSI_skipToBlock). */
 } FILE_INFO;
 
 typedef struct BLOCK_INF_st {
@@ -107,6 +118,8 @@ typedef struct BLOCK_INF_st {
 	uint64_t recTimeMin;			/* The lowest record time value in the block, extracted from the log line. */
 	uint64_t recTimeMax;			/* The highest record time value in the block, extracted from the log line. */
 	uint64_t sigTime_1;
+	uint64_t sigOffset;				/* Offset of the block header in the (output) log signature file (see block_index.h). */
+	uint64_t logOffset;				/* Offset of the first line of the block in the log file (see block_index.h). */
 	KSI_HashAlgorithm hashAlgo;		/* Hash algorithm used for aggregation. */
 	KSI_DataHash *inputHash;		/* Just a reference for the input hash of a block. */
 	KSI_DataHash *rootHash;			/* Root hash value extracted from KSI signature / unsigned block marker. */
@@ -141,6 +154,10 @@ typedef struct {
 	char *logLine;
 	size_t logLine_capacity;
 	size_t logLine_len;
+	const char *logLineSpan;		/* Current line that is not yet copied into logLine (see LOGKSI_getLine). */
+	size_t logLineSpan_len;
+	struct LOGLINE_PIPELINE_st *logLinePipeline;	/* If set, log lines are read ahead and hashed in parallel (see logline_pipeline.h). */
+	struct BLOCK_INDEX_st *index;	/* If set, every finalized block is added to the index (see block_index.h). */
 
 	char isContinuedOnFail;			/* Option --continue-on-failure is set. */
 	int quietError;					/* In case of failure and --continue-on-fail, this option will keep the error code and block is not skipped. */
@@ -0,0 +1,318 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+#include <stdlib.h>
+#include <ksi/ksi.h>
+#include "logksi_err.h"
+#include "hash_pool.h"
+#include "logline_pipeline.h"
+
+/* Count of log lines read ahead and hashed at once by every worker thread. */
+#define LOGLINE_PIPELINE_LINES_PER_THREAD 256
+
+struct LOGLINE_PIPELINE_st {
+	HASH_POOL *pool;
+	HASH_JOB **jobs;		/* Ring of jobs that are filled in order. */
+	size_t nofJobs;
+	size_t current;			/* Job whose lines are being consumed. */
+	size_t pos;				/* Index of the next line in the current job. */
+	size_t nofLines;		/* Count of lines per job. */
+	size_t *lineEnds;		/* Position in the log file after every line read ahead, nofLines per job. */
+	size_t position;		/* Position in the log file after the last consumed line. */
+	KSI_HashAlgorithm algo;	/* Algorithm used for the lines read ahead. */
+	KSI_DataHasher *hasher;	/* Used when the algorithm is changed. */
+	int isStarted;
+	int isWaited;			/* The first job is waited for. */
+	int isEof;
+	int hasTrailingData;	/* Last line without newline, that is not a log record. */
+	int readError;			/* Returned when all the lines read before the error are consumed. */
+};
+
+int LOGLINE_PIPELINE_new(size_t nofThreads, size_t nofJobs, LOGLINE_PIPELINE **pipeline) {
+	int res = KT_UNKNOWN_ERROR;
+	LOGLINE_PIPELINE *tmp = NULL;
+	size_t i;
+
+	if (nofThreads == 0 || nofJobs < 2 || pipeline == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	tmp = (LOGLINE_PIPELINE*)malloc(sizeof(LOGLINE_PIPELINE));
+	if (tmp == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	tmp->pool = NULL;
+	tmp->jobs = NULL;
+	tmp->nofJobs = 0;
+	tmp->current = 0;
+	tmp->pos = 0;
+	tmp->nofLines = nofThreads * LOGLINE_PIPELINE_LINES_PER_THREAD;
+	tmp->lineEnds = NULL;
+	tmp->position = 0;
+	tmp->algo = KSI_HASHALG_INVALID_VALUE;
+	tmp->hasher = NULL;
+	tmp->isStarted = 0;
+	tmp->isWaited = 0;
+	tmp->isEof = 0;
+	tmp->hasTrailingData = 0;
+	tmp->readError = KT_OK;
+
+	tmp->jobs = (HASH_JOB**)calloc(nofJobs, sizeof(HASH_JOB*));
+	tmp->lineEnds = (size_t*)malloc(nofJobs * tmp->nofLines * sizeof(size_t));
+	if (tmp->jobs == NULL || tmp->lineEnds == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+	tmp->nofJobs = nofJobs;
+
+	res = HASH_POOL_new(nofThreads, &tmp->pool);
+	if (res != KT_OK) goto cleanup;
+
+	for (i = 0; i < nofJobs; i++) {
+		res = HASH_JOB_new(KSI_HASHALG_INVALID_VALUE, tmp->nofLines, &tmp->jobs[i]);
+		if (res != KT_OK) goto cleanup;
+	}
+
+	*pipeline = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	LOGLINE_PIPELINE_free(tmp);
+
+	return res;
+}
+
+void LOGLINE_PIPELINE_free(LOGLINE_PIPELINE *pipeline) {
+	size_t i;
+
+	if (pipeline == NULL) return;
+
+	/* Jobs may still be processed by the workers. */
+	for (i = 0; i < pipeline->nofJobs; i++) {
+		if (pipeline->pool != NULL && pipeline->jobs[i] != NULL) HASH_POOL_wait(pipeline->pool, pipeline->jobs[i]);
+	}
+
+	HASH_POOL_free(pipeline->pool);
+	for (i = 0; i < pipeline->nofJobs; i++) {
+		HASH_JOB_free(pipeline->jobs[i]);
+	}
+	free(pipeline->jobs);
+	free(pipeline->lineEnds);
+	KSI_DataHasher_free(pipeline->hasher);
+	free(pipeline);
+}
+
+/* Reads log lines into the job i (see LOGKSI_readLineSpan) and submits it to the pool. */
+static int logline_pipeline_fill(LOGLINE_PIPELINE *pipeline, LOGKSI *logksi, SMART_FILE *in, size_t i) {
+	int res = KT_UNKNOWN_ERROR;
+	HASH_JOB *job = pipeline->jobs[i];
+	size_t *lineEnds = pipeline->lineEnds + i * pipeline->nofLines;
+
+	HASH_JOB_reset(job);
+
+	res = HASH_JOB_setAlgorithm(job, pipeline->algo);
+	if (res != KT_OK) return res;
+
+	while (!pipeline->isEof && pipeline->readError == KT_OK && !HASH_JOB_isFull(job)) {
+		const char *line = NULL;
+		size_t line_len = 0;
+
+		res = LOGKSI_readLineSpan(logksi, in, &line, &line_len);
+		if (res != SMART_FILE_OK) {
+			pipeline->readError = res;
+			break;
+		}
+
+		if (SMART_FILE_isEof(in)) {
+			pipeline->isEof = 1;
+			if (line_len > 0) pipeline->hasTrailingData = 1;
+			break;
+		}
+
+		/* Line in logLine buffer is overwritten by the next read, memory mapped line is not. */
+		if (line == logksi->logLine) {
+			res = HASH_JOB_add(job, (const unsigned char*)line, line_len);
+		} else {
+			res = HASH_JOB_addRef(job, (const unsigned char*)line, line_len);
+		}
+		if (res != KT_OK) {
+			/* Job is left empty, as the lines added so far are not hashed. */
+			HASH_JOB_reset(job);
+			return res;
+		}
+
+		res = SMART_FILE_getPosition(in, &lineEnds[HASH_JOB_getCount(job) - 1]);
+		if (res != SMART_FILE_OK) {
+			HASH_JOB_reset(job);
+			return res;
+		}
+	}
+
+	return HASH_POOL_submit(pipeline->pool, job);
+}
+
+static int logline_pipeline_calculate_hash(LOGLINE_PIPELINE *pipeline, KSI_HashAlgorithm algo, const unsigned char *data, size_t data_len, KSI_DataHash **hash) {
+	int res = KT_UNKNOWN_ERROR;
+
+	if (pipeline->hasher == NULL) {
+		res = KSI_DataHasher_open(NULL, algo, &pipeline->hasher);
+		if (res != KSI_OK) return res;
+	}
+
+	res = KSI_DataHasher_reset(pipeline->hasher);
+	if (res != KSI_OK) return res;
+
+	res = KSI_DataHasher_add(pipeline->hasher, data, data_len);
+	if (res != KSI_OK) return res;
+
+	return KSI_DataHasher_close(pipeline->hasher, hash);
+}
+
+int LOGLINE_PIPELINE_start(LOGLINE_PIPELINE *pipeline, LOGKSI *logksi, SMART_FILE *in, KSI_HashAlgorithm algo) {
+	int res = KT_UNKNOWN_ERROR;
+	size_t i;
+
+	if (pipeline == NULL || logksi == NULL || in == NULL) return KT_INVALID_ARGUMENT;
+	if (pipeline->isStarted) return KT_OK;
+
+	pipeline->algo = algo;
+
+	res = SMART_FILE_getPosition(in, &pipeline->position);
+	if (res != SMART_FILE_OK) return res;
+
+	for (i = 0; i < pipeline->nofJobs; i++) {
+		res = logline_pipeline_fill(pipeline, logksi, in, i);
+		if (res != KT_OK) return res;
+	}
+
+	pipeline->isStarted = 1;
+
+	return KT_OK;
+}
+
+int LOGLINE_PIPELINE_nextLine(LOGLINE_PIPELINE *pipeline, LOGKSI *logksi, SMART_FILE *in, KSI_HashAlgorithm algo, KSI_DataHash **hash) {
+	int res = KT_UNKNOWN_ERROR;
+	HASH_JOB *job = NULL;
+	const unsigned char *data = NULL;
+	size_t data_len = 0;
+	KSI_DataHash *tmp = NULL;
+
+	if (pipeline == NULL || logksi == NULL || in == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	if (!pipeline->isStarted) {
+		res = LOGLINE_PIPELINE_start(pipeline, logksi, in, algo);
+		if (res != KT_OK) goto cleanup;
+	}
+
+	if (!pipeline->isWaited) {
+		res = HASH_POOL_wait(pipeline->pool, pipeline->jobs[pipeline->current]);
+		if (res != KT_OK) goto cleanup;
+
+		pipeline->isWaited = 1;
+	}
+
+	while (pipeline->pos == HASH_JOB_getCount(pipeline->jobs[pipeline->current])) {
+		HASH_JOB *consumed = pipeline->jobs[pipeline->current];
+
+		if (HASH_JOB_getCount(consumed) == 0) {
+			/* Lines read ahead are not valid any more. */
+			LOGKSI_setLineSpan(logksi, "", 0);
+			res = (pipeline->readError != KT_OK) ? pipeline->readError : KT_UNEXPECTED_EOF;
+			goto cleanup;
+		}
+
+		/* Read ahead into the consumed job and continue with the next one. */
+		res = logline_pipeline_fill(pipeline, logksi, in, pipeline->current);
+		if (res != KT_OK) goto cleanup;
+
+		pipeline->current = (pipeline->current + 1) % pipeline->nofJobs;
+		pipeline->pos = 0;
+
+		res = HASH_POOL_wait(pipeline->pool, pipeline->jobs[pipeline->current]);
+		if (res != KT_OK) goto cleanup;
+	}
+
+	job = pipeline->jobs[pipeline->current];
+
+	res = HASH_JOB_getData(job, pipeline->pos, &data, &data_len);
+	if (res != KT_OK) goto cleanup;
+
+	if (hash != NULL) {
+		if (HASH_JOB_getAlgorithm(job) == algo) {
+			res = HASH_JOB_getHash(job, pipeline->pos, &tmp);
+			if (res != KT_OK) goto cleanup;
+		} else {
+			/* Lines read ahead from now on are hashed with the new algorithm. */
+			if (pipeline->algo != algo) {
+				KSI_DataHasher_free(pipeline->hasher);
+				pipeline->hasher = NULL;
+				pipeline->algo = algo;
+			}
+
+			res = logline_pipeline_calculate_hash(pipeline, algo, data, data_len, &tmp);
+			if (res != KSI_OK) goto cleanup;
+		}
+	}
+
+	/* Line is valid until the job is filled again, that is not before the next call. */
+	LOGKSI_setLineSpan(logksi, (const char*)data, data_len);
+	pipeline->position = pipeline->lineEnds[pipeline->current * pipeline->nofLines + pipeline->pos];
+	pipeline->pos++;
+
+	if (hash != NULL) {
+		*hash = tmp;
+		tmp = NULL;
+	}
+
+	res = KT_OK;
+
+cleanup:
+
+	KSI_DataHash_free(tmp);
+
+	return res;
+}
+
+int LOGLINE_PIPELINE_hasMoreData(LOGLINE_PIPELINE *pipeline) {
+	if (pipeline == NULL || !pipeline->isStarted) return 0;
+
+	if (pipeline->pos < HASH_JOB_getCount(pipeline->jobs[pipeline->current])) return 1;
+	if (HASH_JOB_getCount(pipeline->jobs[(pipeline->current + 1) % pipeline->nofJobs]) > 0) return 1;
+
+	return pipeline->hasTrailingData;
+}
+
+int LOGLINE_PIPELINE_getPosition(LOGLINE_PIPELINE *pipeline, SMART_FILE *in, size_t *pos) {
+	if (pipeline == NULL || in == NULL || pos == NULL) return KT_INVALID_ARGUMENT;
+
+	/* Nothing is read ahead yet. */
+	if (!pipeline->isStarted) return SMART_FILE_getPosition(in, pos);
+
+	*pos = pipeline->position;
+
+	return KT_OK;
+}
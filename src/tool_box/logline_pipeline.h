@@ -0,0 +1,102 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+#ifndef LOGLINE_PIPELINE_H
+#define	LOGLINE_PIPELINE_H
+
+#include <stddef.h>
+#include <ksi/ksi.h>
+#include "smart_file.h"
+#include "logksi.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+typedef struct LOGLINE_PIPELINE_st LOGLINE_PIPELINE;
+
+/**
+ * Creates a pipeline that reads log lines ahead and calculates their hashes on a
+ * pool of worker threads. Lines are read into a ring of jobs: while the hashes of
+ * one job are consumed, the other jobs are being hashed. Lines and hashes are
+ * returned in the same order as they appear in the log file.
+ * \param nofThreads	Count of worker threads.
+ * \param nofJobs		Count of jobs read ahead, at least 2. Every job holds up to 256
+ *						lines per worker thread.
+ * \param pipeline		Output parameter for the pipeline.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int LOGLINE_PIPELINE_new(size_t nofThreads, size_t nofJobs, LOGLINE_PIPELINE **pipeline);
+
+/**
+ * Waits until the workers are done with the jobs and frees the pipeline.
+ */
+void LOGLINE_PIPELINE_free(LOGLINE_PIPELINE *pipeline);
+
+/**
+ * Fills all the jobs and submits them to the workers without waiting for the hashes,
+ * so that the log lines are hashed while the caller is busy with something else.
+ * It is called by the first #LOGLINE_PIPELINE_nextLine, if not called before.
+ * \param pipeline		Pipeline object.
+ * \param logksi		LOGKSI object used to read the lines.
+ * \param in			Log file.
+ * \param algo			Hash algorithm.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int LOGLINE_PIPELINE_start(LOGLINE_PIPELINE *pipeline, LOGKSI *logksi, SMART_FILE *in, KSI_HashAlgorithm algo);
+
+/**
+ * Moves to the next log line and sets it as the current line of \c logksi without
+ * copying (see #LOGKSI_getLine). The hash of the line is calculated without the trailing
+ * newline character. If the line was read ahead with another hash algorithm, the
+ * hash is calculated in the calling thread and next lines are read ahead with
+ * the new algorithm.
+ * \param pipeline		Pipeline object.
+ * \param logksi		LOGKSI object used to read the lines and to store the current line.
+ * \param in			Log file.
+ * \param algo			Hash algorithm.
+ * \param hash			Output parameter for the hash of the line. Can be \c NULL to skip the line.
+ * \return KT_OK if successful, KT_UNEXPECTED_EOF if there are no more lines, error code otherwise.
+ */
+int LOGLINE_PIPELINE_nextLine(LOGLINE_PIPELINE *pipeline, LOGKSI *logksi, SMART_FILE *in, KSI_HashAlgorithm algo, KSI_DataHash **hash);
+
+/**
+ * Checks if the pipeline holds data that is read from the log file but not yet
+ * consumed with #LOGLINE_PIPELINE_nextLine. If the function returns 0, the rest
+ * of the data (if any) is still in the log file.
+ */
+int LOGLINE_PIPELINE_hasMoreData(LOGLINE_PIPELINE *pipeline);
+
+/**
+ * Returns the position in the log file after the last line consumed with
+ * #LOGLINE_PIPELINE_nextLine, that is where the next line starts, even if the
+ * lines are read ahead. If no lines are read yet, the position of the log file
+ * is returned.
+ * \param pipeline		Pipeline object.
+ * \param in			Log file.
+ * \param pos			Output parameter for the position.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int LOGLINE_PIPELINE_getPosition(LOGLINE_PIPELINE *pipeline, SMART_FILE *in, size_t *pos);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* LOGLINE_PIPELINE_H */
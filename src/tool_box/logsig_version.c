@@ -37,7 +37,8 @@ struct magic_reference_st magic_reference[NOF_VERS] = {
 	_LGVR(RECSIG12),
 	_LGVR(LOG12BLK),
 	_LGVR(LOG12SIG),
-	_LGVR(KSISTAT10)
+	_LGVR(KSISTAT10),
+	_LGVR(KSISTAT11)
 };
 #undef _LGVR
 
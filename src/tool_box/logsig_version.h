@@ -38,6 +38,7 @@ typedef enum {
 	LOG12BLK = 4,
 	LOG12SIG = 5,
 	KSISTAT10 = 6,
+	KSISTAT11 = 7,
 	NOF_VERS,
 	UNKN_VER = 0xff
 } LOGSIG_VERSION;
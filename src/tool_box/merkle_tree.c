@@ -23,22 +23,35 @@
 #include "merkle_tree.h"
 #include "logksi_err.h"
 #include "extract_info.h"
+#include "hash_batch.h"
 #include "logksi_impl.h"
 
+/* Maximum size of hashed data that is handled without the libksi hasher (two imprints and a level byte or imprint and random seed). */
+#define MERKLE_TREE_DATA_SIZE 256
+
+/**
+ * Hash value that is stored inline in the tree. Imprint consists of the hash
+ * algorithm id and the digest. KSI_DataHash objects are only created for the
+ * values returned by the API and passed to the callbacks.
+ */
+typedef struct MERKLE_TREE_HASH_st {
+	size_t len;									/* Length of the imprint, 0 if not set. */
+	unsigned char imprint[KSI_MAX_IMPRINT_LEN];
+} MERKLE_TREE_HASH;
 
 struct MERKLE_TREE_st {
+	KSI_CTX *ksi;
 	KSI_OctetString *randomSeed;
-	KSI_DataHash *prevLeaf;
-	KSI_DataHash *prevMask;
-	KSI_DataHash *merkleTree[MAX_TREE_HEIGHT];
-	KSI_DataHash *notVerified[MAX_TREE_HEIGHT];
+	MERKLE_TREE_HASH prevLeaf;
+	MERKLE_TREE_HASH prevMask;
+	MERKLE_TREE_HASH merkleTree[MAX_TREE_HEIGHT];
+	MERKLE_TREE_HASH notVerified[MAX_TREE_HEIGHT];
 	unsigned char treeHeight;
 	unsigned char balanced;
 	KSI_DataHasher *hasher;
 	KSI_HashAlgorithm hasher_algo;
 
 	int isClosing;
-
 	/**
 	 * Abstract functionality for extracting hash chains from the tree while the tree
 	 * is being built. This object is feed to abstract functions newRecordChain and
@@ -76,13 +89,201 @@ struct MERKLE_TREE_st {
 	int (*extractRecordChain)(MERKLE_TREE *tree, void *ctx, unsigned char lvl, KSI_DataHash *hash);
 };
 
+static void merkle_tree_hash_clear(MERKLE_TREE_HASH *hash) {
+	hash->len = 0;
+}
+
+static int merkle_tree_hash_isSet(const MERKLE_TREE_HASH *hash) {
+	return hash->len > 0;
+}
+
+/* Copies the imprint of the hash into the tree. */
+static int merkle_tree_hash_fromDataHash(MERKLE_TREE_HASH *hash, const KSI_DataHash *dataHash) {
+	int res = KT_UNKNOWN_ERROR;
+	const unsigned char *imprint = NULL;
+	size_t imprint_len = 0;
+
+	res = KSI_DataHash_getImprint(dataHash, &imprint, &imprint_len);
+	if (res != KSI_OK) return res;
+
+	if (imprint_len == 0 || imprint_len > KSI_MAX_IMPRINT_LEN) return KT_INVALID_INPUT_FORMAT;
+
+	memcpy(hash->imprint, imprint, imprint_len);
+	hash->len = imprint_len;
+
+	return KT_OK;
+}
+
+/* Creates a new KSI_DataHash object at the API boundary. Not set hash value is returned as NULL. */
+static int merkle_tree_hash_toDataHash(MERKLE_TREE *tree, const MERKLE_TREE_HASH *hash, KSI_DataHash **dataHash) {
+	if (!merkle_tree_hash_isSet(hash)) {
+		*dataHash = NULL;
+		return KT_OK;
+	}
+
+	return KSI_DataHash_fromImprint(tree->ksi, hash->imprint, hash->len, dataHash);
+}
+
+/* Hashes the concatenation of data a, b and c with the hash algorithm of the tree. */
+static int merkle_tree_hash_data(MERKLE_TREE *tree,
+								 const unsigned char *a, size_t a_len,
+								 const unsigned char *b, size_t b_len,
+								 const unsigned char *c, size_t c_len,
+								 MERKLE_TREE_HASH *out) {
+	int res = KT_UNKNOWN_ERROR;
+	KSI_DataHash *tmp = NULL;
+
+	if (tree->hasher == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	/* SHA-256 is calculated without allocating memory, other algorithms with libksi. */
+	if (tree->hasher_algo == KSI_HASHALG_SHA2_256 && a_len + b_len + c_len <= MERKLE_TREE_DATA_SIZE) {
+		unsigned char buf[MERKLE_TREE_DATA_SIZE];
+
+		if (a_len > 0) memcpy(buf, a, a_len);
+		if (b_len > 0) memcpy(buf + a_len, b, b_len);
+		if (c_len > 0) memcpy(buf + a_len + b_len, c, c_len);
+
+		res = HASH_BATCH_sha256(buf, a_len + b_len + c_len, out->imprint + 1);
+		if (res != KT_OK) goto cleanup;
+
+		out->imprint[0] = KSI_HASHALG_SHA2_256;
+		out->len = 1 + 32;
+	} else {
+		res = KSI_DataHasher_reset(tree->hasher);
+		if (res != KSI_OK) goto cleanup;
+		res = KSI_DataHasher_add(tree->hasher, a, a_len);
+		if (res != KSI_OK) goto cleanup;
+		res = KSI_DataHasher_add(tree->hasher, b, b_len);
+		if (res != KSI_OK) goto cleanup;
+		if (c_len > 0) {
+			res = KSI_DataHasher_add(tree->hasher, c, c_len);
+			if (res != KSI_OK) goto cleanup;
+		}
+		res = KSI_DataHasher_close(tree->hasher, &tmp);
+		if (res != KSI_OK) goto cleanup;
+
+		res = merkle_tree_hash_fromDataHash(out, tmp);
+		if (res != KT_OK) goto cleanup;
+	}
+
+	res = KT_OK;
+
+cleanup:
+
+	KSI_DataHash_free(tmp);
+	return res;
+}
+
+static int merkle_tree_calculate_tree_hash(MERKLE_TREE *tree, const MERKLE_TREE_HASH *left, const MERKLE_TREE_HASH *right, unsigned char level, MERKLE_TREE_HASH *node) {
+	if (!merkle_tree_hash_isSet(left) || !merkle_tree_hash_isSet(right)) return KT_INVALID_ARGUMENT;
+	if (level > MAX_TREE_HEIGHT) return KT_TREE_LEVEL_OVF;
+
+	return merkle_tree_hash_data(tree, left->imprint, left->len, right->imprint, right->len, &level, 1, node);
+}
+
+static int merkle_tree_calculate_leaf_hash(MERKLE_TREE *tree, const MERKLE_TREE_HASH *recordHash, int isMetaRecordHash, MERKLE_TREE_HASH *leafHash) {
+	int res = KT_UNKNOWN_ERROR;
+	const unsigned char *seed = NULL;
+	size_t seed_len = 0;
+	MERKLE_TREE_HASH mask;
+
+	if (!merkle_tree_hash_isSet(&tree->prevLeaf) || tree->randomSeed == NULL) return KT_INVALID_ARGUMENT;
+
+	res = KSI_OctetString_extract(tree->randomSeed, &seed, &seed_len);
+	if (res != KSI_OK) return res;
+
+	res = merkle_tree_hash_data(tree, tree->prevLeaf.imprint, tree->prevLeaf.len, seed, seed_len, NULL, 0, &mask);
+	if (res != KT_OK) return res;
+
+	tree->prevMask = mask;
+
+	return isMetaRecordHash ?
+		merkle_tree_calculate_tree_hash(tree, recordHash, &mask, 1, leafHash) :
+		merkle_tree_calculate_tree_hash(tree, &mask, recordHash, 1, leafHash);
+}
+
+/* Calls newTreeNode and extractRecordChain callbacks that need the hash as KSI_DataHash object. */
+static int merkle_tree_call_node_callbacks(MERKLE_TREE *tree, int callNewTreeNode, unsigned char treeNodeLevel, const MERKLE_TREE_HASH *treeNode,
+										   int callExtract, unsigned char extractLevel, const MERKLE_TREE_HASH *extractNode) {
+	int res = KT_UNKNOWN_ERROR;
+	KSI_DataHash *tmp = NULL;
+
+	if (callNewTreeNode && tree->newTreeNode != NULL) {
+		res = merkle_tree_hash_toDataHash(tree, treeNode, &tmp);
+		if (res != KT_OK) goto cleanup;
+
+		res = tree->newTreeNode(tree, tree->ctx, treeNodeLevel, tmp);
+		if (res != KT_OK) goto cleanup;
+
+		KSI_DataHash_free(tmp);
+		tmp = NULL;
+	}
+
+	if (callExtract && tree->extractRecordChain != NULL) {
+		res = merkle_tree_hash_toDataHash(tree, extractNode, &tmp);
+		if (res != KT_OK) goto cleanup;
+
+		res = tree->extractRecordChain(tree, tree->ctx, extractLevel, tmp);
+		if (res != KT_OK) goto cleanup;
+	}
+
+	res = KT_OK;
+
+cleanup:
+
+	KSI_DataHash_free(tmp);
+	return res;
+}
+
+static int merkle_tree_add_leaf_hash(MERKLE_TREE *tree, const MERKLE_TREE_HASH *hash) {
+	int res;
+	unsigned char i = 0;
+	MERKLE_TREE_HASH right = *hash;
+	MERKLE_TREE_HASH tmp;
+
+	tree->balanced = 0;
+
+	while (i < MAX_TREE_HEIGHT && merkle_tree_hash_isSet(&tree->merkleTree[i])) {
+		res = merkle_tree_calculate_tree_hash(tree, &tree->merkleTree[i], &right, i + 2, &tmp);
+		if (res != KT_OK) return res;
+
+		res = merkle_tree_call_node_callbacks(tree, 1, i, &right, 1, i, &right);
+		if (res != KT_OK) return res;
+
+		tree->notVerified[i] = right;
+
+		right = tmp;
+		merkle_tree_hash_clear(&tree->merkleTree[i]);
+		i++;
+	}
+
+	if (i >= MAX_TREE_HEIGHT) return KT_TREE_LEVEL_OVF;
+
+	res = merkle_tree_call_node_callbacks(tree, 1, i == 0 ? 0 : i + 2, &right, 0, 0, NULL);
+	if (res != KT_OK) return res;
+
+	tree->merkleTree[i] = right;
+	tree->notVerified[i] = right;
+
+	if (i == tree->treeHeight) {
+		tree->treeHeight++;
+		tree->balanced = 1;
+	}
+
+	tree->prevLeaf = *hash;
 
-int MERKLE_TREE_new(MERKLE_TREE **tree) {
+	return KT_OK;
+}
+
+int MERKLE_TREE_new(KSI_CTX *ksi, MERKLE_TREE **tree) {
 	int i = 0;
 	MERKLE_TREE *tmp = NULL;
 	int res = KT_UNKNOWN_ERROR;
 
-	if (tree == NULL) {
+	if (ksi == NULL || tree == NULL) {
 		res = KT_INVALID_ARGUMENT;
 		goto cleanup;
 	}
@@ -93,6 +294,7 @@ int MERKLE_TREE_new(MERKLE_TREE **tree) {
 		goto cleanup;
 	}
 
+	tmp->ksi = ksi;
 	tmp->balanced = 0;
 	tmp->treeHeight = 0;
 	tmp->isClosing = 0;
@@ -103,14 +305,13 @@ int MERKLE_TREE_new(MERKLE_TREE **tree) {
 	tmp->extractRecordChain = NULL;
 	tmp->newRecordChain = NULL;
 	tmp->newTreeNode = NULL;
-	tmp->prevLeaf = NULL;
-	tmp->prevMask = NULL;
 	tmp->randomSeed = NULL;
-
+	merkle_tree_hash_clear(&tmp->prevLeaf);
+	merkle_tree_hash_clear(&tmp->prevMask);
 
 	for (i = 0; i < MAX_TREE_HEIGHT; i++) {
-		tmp->notVerified[i] = NULL;
-		tmp->merkleTree[i] = NULL;
+		merkle_tree_hash_clear(&tmp->notVerified[i]);
+		merkle_tree_hash_clear(&tmp->merkleTree[i]);
 	}
 
 	*tree = tmp;
@@ -152,20 +353,9 @@ int MERKLE_TREE_setCallbacks(MERKLE_TREE *tree,
 }
 
 void MERKLE_TREE_free(MERKLE_TREE *tree) {
-	int i = 0;
-
 	if (tree == NULL) return;
 
 	KSI_OctetString_free(tree->randomSeed);
-	KSI_DataHash_free(tree->prevLeaf);
-	KSI_DataHash_free(tree->prevMask);
-
-	while (i < tree->treeHeight) {
-		KSI_DataHash_free(tree->merkleTree[i]);
-		KSI_DataHash_free(tree->notVerified[i]);
-		i++;
-	}
-
 	KSI_DataHasher_free(tree->hasher);
 
 	free(tree);
@@ -175,19 +365,14 @@ void MERKLE_TREE_clean(MERKLE_TREE *tree) {
 	int i = 0;
 
 	if (tree == NULL) return;
-	KSI_DataHash_free(tree->prevMask);
-	KSI_DataHash_free(tree->prevLeaf);
 	KSI_OctetString_free(tree->randomSeed);
-	tree->prevMask = NULL;
-	tree->prevLeaf = NULL;
 	tree->randomSeed = NULL;
+	merkle_tree_hash_clear(&tree->prevMask);
+	merkle_tree_hash_clear(&tree->prevLeaf);
 
-	while (i < tree->treeHeight) {
-		KSI_DataHash_free(tree->merkleTree[i]);
-		KSI_DataHash_free(tree->notVerified[i]);
-		tree->merkleTree[i] = NULL;
-		tree->notVerified[i] = NULL;
-		i++;
+	for (i = 0; i < MAX_TREE_HEIGHT; i++) {
+		merkle_tree_hash_clear(&tree->merkleTree[i]);
+		merkle_tree_hash_clear(&tree->notVerified[i]);
 	}
 
 	KSI_DataHasher_reset(tree->hasher);
@@ -207,9 +392,15 @@ int MERKLE_TREE_reset(MERKLE_TREE *tree, KSI_HashAlgorithm algo, KSI_DataHash *p
 	}
 
 	MERKLE_TREE_clean(tree);
-	tree->prevLeaf = prevLeaf;
 	tree->randomSeed = randomSeed;
 
+	/* Ownership of the previous leaf is taken, but only its imprint is kept. */
+	if (prevLeaf != NULL) {
+		res = merkle_tree_hash_fromDataHash(&tree->prevLeaf, prevLeaf);
+		KSI_DataHash_free(prevLeaf);
+		if (res != KT_OK) goto cleanup;
+	}
+
 	if (tree->hasher == NULL || tree->hasher_algo != algo) {
 		if (tree->hasher != NULL) {
 			KSI_DataHasher_free(tree->hasher);
@@ -232,54 +423,48 @@ cleanup:
 int MERKLE_TREE_mergeLowestSubTrees(MERKLE_TREE *tree, KSI_DataHash **hash) {
 	int res;
 	unsigned char i = 0;
-	KSI_DataHash *root = NULL;
-	KSI_DataHash *tmp = NULL;
+	MERKLE_TREE_HASH root;
+	MERKLE_TREE_HASH tmp;
 
 	if (tree == NULL || hash == NULL) {
 		res = KT_INVALID_ARGUMENT;
 		goto cleanup;
 	}
 
+	merkle_tree_hash_clear(&root);
+
 	while (i < tree->treeHeight) {
-		if (tree->merkleTree[i]) {
-			if (root == NULL) {
+		if (merkle_tree_hash_isSet(&tree->merkleTree[i])) {
+			if (!merkle_tree_hash_isSet(&root)) {
 				/* Initialize root hash only if there is at least one more hash afterwards. */
 				if (i < tree->treeHeight - 1) {
 					root = tree->merkleTree[i];
-					tree->merkleTree[i] = NULL;
+					merkle_tree_hash_clear(&tree->merkleTree[i]);
 				}
 			} else {
-				res = MERKLE_TREE_calculateTreeHash(tree, tree->merkleTree[i], root, i + 2, &tmp);
+				res = merkle_tree_calculate_tree_hash(tree, &tree->merkleTree[i], &root, i + 2, &tmp);
 				if (res != KT_OK) goto cleanup;
 
-				KSI_DataHash_free(root);
 				root = tmp;
-
-				KSI_DataHash_free(tree->merkleTree[i]);
-				tree->merkleTree[i] = KSI_DataHash_ref(root);
+				tree->merkleTree[i] = root;
 				break;
 			}
 		}
 		i++;
 	}
 
-	*hash = KSI_DataHash_ref(root);
-	tmp = NULL;
-
-	res = KT_OK;
+	res = merkle_tree_hash_toDataHash(tree, &root, hash);
 
 cleanup:
 
-	KSI_DataHash_free(root);
-	KSI_DataHash_free(tmp);
 	return res;
 }
 
 int MERKLE_TREE_calculateRootHash(MERKLE_TREE *tree, KSI_DataHash **hash) {
 	int res;
 	unsigned char i = 0;
-	KSI_DataHash *root = NULL;
-	KSI_DataHash *tmp = NULL;
+	MERKLE_TREE_HASH root;
+	MERKLE_TREE_HASH tmp;
 
 	if (tree == NULL || hash == NULL) {
 		res = KT_INVALID_ARGUMENT;
@@ -287,199 +472,120 @@ int MERKLE_TREE_calculateRootHash(MERKLE_TREE *tree, KSI_DataHash **hash) {
 	}
 
 	tree->isClosing = 1;
+	merkle_tree_hash_clear(&root);
 
 	if (tree->balanced) {
-		root = KSI_DataHash_ref(tree->merkleTree[tree->treeHeight - 1]);
+		root = tree->merkleTree[tree->treeHeight - 1];
 	} else {
 		while (i < tree->treeHeight) {
-			if (root == NULL) {
-				root = KSI_DataHash_ref(tree->merkleTree[i]);
+			if (!merkle_tree_hash_isSet(&root)) {
+				root = tree->merkleTree[i];
 				i++;
 				continue;
 			}
-			if (tree->merkleTree[i]) {
-				res = MERKLE_TREE_calculateTreeHash(tree, tree->merkleTree[i], root, i + 2, &tmp);
+			if (merkle_tree_hash_isSet(&tree->merkleTree[i])) {
+				res = merkle_tree_calculate_tree_hash(tree, &tree->merkleTree[i], &root, i + 2, &tmp);
 				if (res != KT_OK) goto cleanup;
 
-				if (tree->newTreeNode != NULL) {
-					res = tree->newTreeNode(tree, tree->ctx, i, tmp);
-					if (res != KT_OK) goto cleanup;
-				}
-
-				if (tree->extractRecordChain != NULL) {
-					res = tree->extractRecordChain(tree, tree->ctx, i, root);
-					if (res != KT_OK) goto cleanup;
-				}
+				res = merkle_tree_call_node_callbacks(tree, 1, i, &tmp, 1, i, &root);
+				if (res != KT_OK) goto cleanup;
 
-				KSI_DataHash_free(root);
 				root = tmp;
 			}
 			i++;
 		}
 	}
 
-
-	*hash = KSI_DataHash_ref(root);
-	tmp = NULL;
-	res = KT_OK;
+	res = merkle_tree_hash_toDataHash(tree, &root, hash);
 
 cleanup:
 
-	KSI_DataHash_free(root);
-	KSI_DataHash_free(tmp);
 	return res;
 }
 
 int MERKLE_TREE_calculateTreeHash(MERKLE_TREE *tree, KSI_DataHash *leftHash, KSI_DataHash *rightHash, unsigned char level, KSI_DataHash **nodeHash) {
 	int res;
-	KSI_DataHash *tmp = NULL;
+	MERKLE_TREE_HASH left;
+	MERKLE_TREE_HASH right;
+	MERKLE_TREE_HASH node;
 
 	if (tree == NULL || leftHash == NULL || rightHash == NULL || nodeHash == NULL) {
 		res = KT_INVALID_ARGUMENT;
 		goto cleanup;
 	}
 
-	if (level > MAX_TREE_HEIGHT) {
-		res = KT_TREE_LEVEL_OVF;
-		goto cleanup;
-	}
+	res = merkle_tree_hash_fromDataHash(&left, leftHash);
+	if (res != KT_OK) goto cleanup;
+
+	res = merkle_tree_hash_fromDataHash(&right, rightHash);
+	if (res != KT_OK) goto cleanup;
 
-	res = KSI_DataHasher_reset(tree->hasher);
-	if (res != KSI_OK) goto cleanup;
-	res = KSI_DataHasher_addImprint(tree->hasher, leftHash);
-	if (res != KSI_OK) goto cleanup;
-	res = KSI_DataHasher_addImprint(tree->hasher, rightHash);
-	if (res != KSI_OK) goto cleanup;
-	res = KSI_DataHasher_add(tree->hasher, &level, 1);
-	if (res != KSI_OK) goto cleanup;
-	res = KSI_DataHasher_close(tree->hasher, &tmp);
-	if (res != KSI_OK) goto cleanup;
+	res = merkle_tree_calculate_tree_hash(tree, &left, &right, level, &node);
+	if (res != KT_OK) goto cleanup;
 
-	*nodeHash = tmp;
-	tmp = NULL;
-	res = KT_OK;
+	res = merkle_tree_hash_toDataHash(tree, &node, nodeHash);
 
 cleanup:
 
-	KSI_DataHash_free(tmp);
 	return res;
 }
 
  int MERKLE_TREE_addLeafHash(MERKLE_TREE *tree, KSI_DataHash *hash, int isMetaRecordHash) {
 	int res;
-	unsigned char i = 0;
-	KSI_DataHash *right = NULL;
-	KSI_DataHash *tmp = NULL;
+	MERKLE_TREE_HASH leaf;
 
 	if (tree == NULL || hash == NULL) {
 		res = KT_INVALID_ARGUMENT;
 		goto cleanup;
 	}
 
-	right = KSI_DataHash_ref(hash);
-
-	tree->balanced = 0;
-
-	while (tree->merkleTree[i] != NULL) {
-		res = MERKLE_TREE_calculateTreeHash(tree, tree->merkleTree[i], right, i + 2, &tmp);
-		if (res != KT_OK) goto cleanup;
-
-		if (tree->newTreeNode != NULL) {
-			res = tree->newTreeNode(tree, tree->ctx, i, right);
-			if (res != KT_OK) goto cleanup;
-		}
-
-		if (tree->extractRecordChain != NULL) {
-			res = tree->extractRecordChain(tree, tree->ctx, i, right);
-			if (res != KT_OK) goto cleanup;
-		}
-
-		res = MERKLE_TREE_insertUnverified(tree, i, right);
-		if (res != KT_OK) goto cleanup;
-
-		KSI_DataHash_free(right);
-		right = tmp;
-		tmp = NULL;
-		KSI_DataHash_free(tree->merkleTree[i]);
-		tree->merkleTree[i] = NULL;
-		i++;
-	}
-
-	if (tree->newTreeNode != NULL) {
-		res = tree->newTreeNode(tree, tree->ctx, i == 0 ? 0 : i + 2, right);
-		if (res != KT_OK) goto cleanup;
-	}
-
-	tree->merkleTree[i] = right;
-
-	res = MERKLE_TREE_insertUnverified(tree, i, right);
+	res = merkle_tree_hash_fromDataHash(&leaf, hash);
 	if (res != KT_OK) goto cleanup;
 
-	if (i == tree->treeHeight) {
-		tree->treeHeight++;
-		tree->balanced = 1;
-	}
-
-	KSI_DataHash_free(tree->prevLeaf);
-	tree->prevLeaf = KSI_DataHash_ref(hash);
-	right = NULL;
-	res = KT_OK;
+	res = merkle_tree_add_leaf_hash(tree, &leaf);
 
 cleanup:
 
-	KSI_DataHash_free(right);
-	KSI_DataHash_free(tmp);
 	return res;
 }
 
 int MERKLE_TREE_calculateLeafHash(MERKLE_TREE *tree, KSI_DataHash *recordHash, int isMetaRecordHash, KSI_DataHash **leafHash) {
 	int res;
-	KSI_DataHash *mask = NULL;
-	KSI_DataHash *tmp = NULL;
+	MERKLE_TREE_HASH record;
+	MERKLE_TREE_HASH leaf;
 
 	if (tree == NULL || recordHash == NULL || leafHash == NULL) {
 		res = KT_INVALID_ARGUMENT;
 		goto cleanup;
 	}
 
-	res = KSI_DataHasher_reset(tree->hasher);
-	if (res != KSI_OK) goto cleanup;
-	res = KSI_DataHasher_addImprint(tree->hasher, tree->prevLeaf);
-	if (res != KSI_OK) goto cleanup;
-	res = KSI_DataHasher_addOctetString(tree->hasher, tree->randomSeed);
-	if (res != KSI_OK) goto cleanup;
-	res = KSI_DataHasher_close(tree->hasher, &mask);
-	if (res != KSI_OK) goto cleanup;
-
-	KSI_DataHash_free(tree->prevMask);
-	tree->prevMask = KSI_DataHash_ref(mask);
+	res = merkle_tree_hash_fromDataHash(&record, recordHash);
+	if (res != KT_OK) goto cleanup;
 
-	res = isMetaRecordHash ?
-		MERKLE_TREE_calculateTreeHash(tree, recordHash, mask, 1, &tmp) :
-		MERKLE_TREE_calculateTreeHash(tree, mask, recordHash, 1, &tmp);
+	res = merkle_tree_calculate_leaf_hash(tree, &record, isMetaRecordHash, &leaf);
 	if (res != KT_OK) goto cleanup;
 
-	*leafHash = tmp;
-	tmp = NULL;
-	res = KT_OK;
+	res = merkle_tree_hash_toDataHash(tree, &leaf, leafHash);
 
 cleanup:
 
-	KSI_DataHash_free(mask);
-	KSI_DataHash_free(tmp);
 	return res;
 }
 
 int MERKLE_TREE_addRecordHash(MERKLE_TREE *tree, int isMetaRecordHash, KSI_DataHash *hash) {
 	int res;
-	KSI_DataHash *lastHash = NULL;
+	MERKLE_TREE_HASH record;
+	MERKLE_TREE_HASH leaf;
 
 	if (tree == NULL || hash == NULL) {
 		res = KT_INVALID_ARGUMENT;
 		goto cleanup;
 	}
 
-	res = MERKLE_TREE_calculateLeafHash(tree, hash, isMetaRecordHash, &lastHash);
+	res = merkle_tree_hash_fromDataHash(&record, hash);
+	if (res != KT_OK) goto cleanup;
+
+	res = merkle_tree_calculate_leaf_hash(tree, &record, isMetaRecordHash, &leaf);
 	if (res != KT_OK) goto cleanup;
 
 
@@ -488,12 +594,11 @@ int MERKLE_TREE_addRecordHash(MERKLE_TREE *tree, int isMetaRecordHash, KSI_DataH
 		if (res != KT_OK) goto cleanup;
 	}
 
-	res = MERKLE_TREE_addLeafHash(tree, lastHash, isMetaRecordHash);
+	res = merkle_tree_add_leaf_hash(tree, &leaf);
 	if (res != KT_OK) goto cleanup;
 
 cleanup:
 
-	KSI_DataHash_free(lastHash);
 	return res;
 }
 
@@ -504,21 +609,18 @@ unsigned char MERKLE_TREE_getHeight(MERKLE_TREE *tree) {
 
 int MERKLE_TREE_getSubTreeRoot(MERKLE_TREE *tree, unsigned char level, KSI_DataHash **hsh) {
 	if (tree == NULL || hsh == NULL) return KT_INVALID_ARGUMENT;
-	if (level > MAX_TREE_HEIGHT) return KT_TREE_LEVEL_OVF;
-	*hsh = KSI_DataHash_ref(tree->merkleTree[level]);
-	return KT_OK;
+	if (level >= MAX_TREE_HEIGHT) return KT_TREE_LEVEL_OVF;
+	return merkle_tree_hash_toDataHash(tree, &tree->merkleTree[level], hsh);
 }
 
 int MERKLE_TREE_getPrevLeaf(MERKLE_TREE *tree, KSI_DataHash **hsh) {
 	if (tree == NULL || hsh == NULL) return KT_INVALID_ARGUMENT;
-	*hsh = KSI_DataHash_ref(tree->prevLeaf);
-	return KT_OK;
+	return merkle_tree_hash_toDataHash(tree, &tree->prevLeaf, hsh);
 }
 
 int MERKLE_TREE_getPrevMask(MERKLE_TREE *tree, KSI_DataHash **hsh) {
 	if (tree == NULL || hsh == NULL) return KT_INVALID_ARGUMENT;
-	*hsh = KSI_DataHash_ref(tree->prevMask);
-	return KT_OK;
+	return merkle_tree_hash_toDataHash(tree, &tree->prevMask, hsh);
 }
 
 int MERKLE_TREE_getHasher(MERKLE_TREE *tree, KSI_DataHasher **hsr) {
@@ -527,6 +629,12 @@ int MERKLE_TREE_getHasher(MERKLE_TREE *tree, KSI_DataHasher **hsr) {
 	return KT_OK;
 }
 
+int MERKLE_TREE_getHashAlgo(MERKLE_TREE *tree, KSI_HashAlgorithm *algo) {
+	if (tree == NULL || algo == NULL) return KT_INVALID_ARGUMENT;
+	*algo = tree->hasher_algo;
+	return KT_OK;
+}
+
 int MERKLE_TREE_isClosing(MERKLE_TREE *tree) {
 	if (tree == NULL) return 0;
 	return tree->isClosing;
@@ -544,7 +652,7 @@ size_t MERKLE_TREE_nofUnverifiedHashes(MERKLE_TREE *tree) {
 	if (tree == NULL) return 0;
 
 	for (i = 0; i < MERKLE_TREE_getHeight(tree); i++) {
-		if (tree->notVerified[i]) {
+		if (merkle_tree_hash_isSet(&tree->notVerified[i])) {
 			count++;
 		}
 	}
@@ -554,7 +662,6 @@ size_t MERKLE_TREE_nofUnverifiedHashes(MERKLE_TREE *tree) {
 
 int MERKLE_TREE_setFinalHashesForVerification(MERKLE_TREE *tree) {
 	int res = KT_UNKNOWN_ERROR;
-	KSI_DataHash *tmp = NULL;
 	size_t i;
 
 	if (tree == NULL) {
@@ -563,18 +670,13 @@ int MERKLE_TREE_setFinalHashesForVerification(MERKLE_TREE *tree) {
 	}
 
 	for (i = 0; i < MERKLE_TREE_getHeight(tree); i++) {
-
-		res = MERKLE_TREE_getSubTreeRoot(tree, i, &tmp);
-		if (res != KT_OK) goto cleanup;
-
 		/* Sanity check for unexpected case. */
-		if (tree->notVerified[i] != NULL) {
+		if (merkle_tree_hash_isSet(&tree->notVerified[i])) {
 			res = KT_UNKNOWN_ERROR;
 			goto cleanup;
 		}
 
-		tree->notVerified[i] = tmp;
-		tmp = NULL;
+		tree->notVerified[i] = tree->merkleTree[i];
 	}
 
 
@@ -582,14 +684,12 @@ int MERKLE_TREE_setFinalHashesForVerification(MERKLE_TREE *tree) {
 
 cleanup:
 
-	KSI_DataHash_free(tmp);
-
 	return res;
 }
 
 int MERKLE_TREE_popUnverifed(MERKLE_TREE *tree, unsigned char *pos, KSI_DataHash **hsh) {
 	int res = KT_UNKNOWN_ERROR;
-	unsigned char i = 0;;
+	unsigned char i = 0;
 
 	if (tree == NULL  || hsh == NULL) {
 		res = KT_INVALID_ARGUMENT;
@@ -598,16 +698,23 @@ int MERKLE_TREE_popUnverifed(MERKLE_TREE *tree, unsigned char *pos, KSI_DataHash
 
 	/* Find the corresponding tree hash from the merkle tree. */
 	for (i = 0; i < MERKLE_TREE_getHeight(tree); i++) {
-		if (tree->notVerified[i] != NULL) break;
+		if (merkle_tree_hash_isSet(&tree->notVerified[i])) break;
 	}
 
 	if (pos != NULL) {
 		*pos = i;
 	}
 
-	/* Reassign the ownership. */
-	*hsh = tree->notVerified[i];
-	tree->notVerified[i] = NULL;
+	if (i >= MAX_TREE_HEIGHT) {
+		*hsh = NULL;
+		res = KT_OK;
+		goto cleanup;
+	}
+
+	res = merkle_tree_hash_toDataHash(tree, &tree->notVerified[i], hsh);
+	if (res != KT_OK) goto cleanup;
+
+	merkle_tree_hash_clear(&tree->notVerified[i]);
 
 	res = KT_OK;
 
@@ -620,13 +727,13 @@ cleanup:
 int MERKLE_TREE_insertUnverified(MERKLE_TREE *tree, unsigned char pos, KSI_DataHash *hsh) {
 	int res = KT_UNKNOWN_ERROR;
 
-	if (tree == NULL || pos > MAX_TREE_HEIGHT || hsh == NULL) {
+	if (tree == NULL || pos >= MAX_TREE_HEIGHT || hsh == NULL) {
 		res = KT_INVALID_ARGUMENT;
 		goto cleanup;
 	}
 
-	KSI_DataHash_free(tree->notVerified[pos]);
-	tree->notVerified[pos] = KSI_DataHash_ref(hsh);
+	res = merkle_tree_hash_fromDataHash(&tree->notVerified[pos], hsh);
+	if (res != KT_OK) goto cleanup;
 
 	res = KT_OK;
 
@@ -642,4 +749,4 @@ size_t MERKLE_TREE_calcMaxTreeHashes(size_t nof_records) {
 		nof_records = nof_records / 2;
 	}
 	return max;
-}
\ No newline at end of file
+}
@@ -30,7 +30,15 @@ extern "C" {
 
 typedef struct MERKLE_TREE_st MERKLE_TREE;
 
-int MERKLE_TREE_new(MERKLE_TREE **tree);
+/**
+ * Creates a new Merkle tree. Hash values are kept inside the tree as imprints,
+ * KSI_DataHash objects are only created for values returned by the functions
+ * and passed to the callbacks (see #MERKLE_TREE_setCallbacks).
+ * \param ksi		KSI context used to create the returned hash objects.
+ * \param tree		Output parameter for the tree.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int MERKLE_TREE_new(KSI_CTX *ksi, MERKLE_TREE **tree);
 void MERKLE_TREE_free(MERKLE_TREE *tree);
 void MERKLE_TREE_clean(MERKLE_TREE *tree);
 int MERKLE_TREE_reset(MERKLE_TREE *tree, KSI_HashAlgorithm algo, KSI_DataHash *prevLeaf, KSI_OctetString *randomSeed);
@@ -54,6 +62,7 @@ int MERKLE_TREE_getSubTreeRoot(MERKLE_TREE *tree, unsigned char level, KSI_DataH
 int MERKLE_TREE_getPrevLeaf(MERKLE_TREE *tree, KSI_DataHash **hsh);
 int MERKLE_TREE_getPrevMask(MERKLE_TREE *tree, KSI_DataHash **hsh);
 int MERKLE_TREE_getHasher(MERKLE_TREE *tree, KSI_DataHasher **hsr);
+int MERKLE_TREE_getHashAlgo(MERKLE_TREE *tree, KSI_HashAlgorithm *algo);
 int MERKLE_TREE_isClosing(MERKLE_TREE *tree);
 unsigned char MERKLE_TREE_getHeight(MERKLE_TREE *tree);
 int MERKLE_TREE_isBalenced(MERKLE_TREE *tree);
@@ -23,6 +23,8 @@
 #include <ctype.h>
 #include <limits.h>
 #include <string.h>
+#include <errno.h>
+#include <stdint.h>
 #include <ksi/ksi.h>
 #include <ksi/compatibility.h>
 #include "tool_box.h"
@@ -242,6 +244,130 @@ int isFormatOk_recordExtract(const char *rec) {
 	return FORMAT_OK;
 }
 
+int isFormatOk_lineRange(const char *range) {
+	unsigned long long from = 0;
+	unsigned long long to = 0;
+	char *pEnd = NULL;
+	size_t i = 0;
+
+
+	if (range == NULL) return FORMAT_NULLPTR;
+	if (strlen(range) == 0) return FORMAT_NOCONTENT;
+
+	while(range[i]) {
+		if (isspace(range[i])) return FORMAT_RECORD_WHITESPACE;
+		if (!isdigit(range[i]) && range[i] != '-') return FORMAT_INVALID_LINE_RANGE;
+		i++;
+	}
+
+	if (!isdigit(range[0])) return FORMAT_INVALID_LINE_RANGE;
+
+	errno = 0;
+	from = strtoull(range, &pEnd, 10);
+	if (errno == ERANGE) return FORMAT_TOO_LARGE_VALUE;
+	if (from == 0) return FORMAT_INVALID_LINE_RANGE;
+	if (*pEnd == '\0') return FORMAT_OK;
+
+	/* Range without the last line continues to the end of the log file. */
+	if (*pEnd != '-') return FORMAT_INVALID_LINE_RANGE;
+	pEnd++;
+	if (*pEnd == '\0') return FORMAT_OK;
+	if (!isdigit(*pEnd)) return FORMAT_INVALID_LINE_RANGE;
+
+	errno = 0;
+	to = strtoull(pEnd, &pEnd, 10);
+	if (errno == ERANGE) return FORMAT_TOO_LARGE_VALUE;
+	if (*pEnd != '\0') return FORMAT_INVALID_LINE_RANGE;
+	if (to < from) return FORMAT_INVALID_LINE_RANGE;
+
+	return FORMAT_OK;
+}
+
+int extract_lineRange(void **extra, const char* str, void** obj) {
+	UINT64_RANGE *pObj = (UINT64_RANGE*)obj;
+	char *pEnd = NULL;
+
+	VARIABLE_IS_NOT_USED(extra);
+	if (str == NULL || obj == NULL) return PST_INVALID_ARGUMENT;
+
+	pObj->from = strtoull(str, &pEnd, 10);
+	pObj->to = pObj->from;
+
+	if (*pEnd == '-') {
+		pEnd++;
+		pObj->to = (*pEnd == '\0') ? UINT64_MAX : strtoull(pEnd, NULL, 10);
+	}
+
+	return PST_OK;
+}
+
+static int time_range_get_value(const char *str, size_t len, uint64_t *value, int *isSet) {
+	int res;
+	char buf[1024];
+	struct tm time_st;
+	time_t t = 0;
+
+	if (len >= sizeof(buf)) return FORMAT_INVALID_UTC;
+
+	*isSet = (len > 0);
+	if (len == 0) return FORMAT_OK;
+
+	memcpy(buf, str, len);
+	buf[len] = '\0';
+
+	if (isInteger(buf)) {
+		errno = 0;
+		*value = strtoull(buf, NULL, 10);
+		if (errno == ERANGE) return FORMAT_TOO_LARGE_VALUE;
+		return FORMAT_OK;
+	}
+
+	res = string_to_tm(buf, &time_st);
+	if (res != FORMAT_OK) return res;
+	if (convert_UTC_to_UNIX2(buf, &t) != KT_OK) return FORMAT_INVALID_UTC_OUT_OF_RANGE;
+	*value = (uint64_t)t;
+
+	return FORMAT_OK;
+}
+
+static int time_range_parse(const char *range, UINT64_RANGE *obj) {
+	int res;
+	const char *comma = NULL;
+	int isFromSet = 0;
+	int isToSet = 0;
+
+	if (range == NULL) return FORMAT_NULLPTR;
+	if (strlen(range) == 0) return FORMAT_NOCONTENT;
+
+	comma = strchr(range, ',');
+	if (comma == NULL || strchr(comma + 1, ',') != NULL) return FORMAT_INVALID_UTC_RANGE;
+
+	obj->from = 0;
+	obj->to = UINT64_MAX;
+
+	res = time_range_get_value(range, comma - range, &obj->from, &isFromSet);
+	if (res != FORMAT_OK) return res;
+
+	res = time_range_get_value(comma + 1, strlen(comma + 1), &obj->to, &isToSet);
+	if (res != FORMAT_OK) return res;
+
+	if (!isFromSet && !isToSet) return FORMAT_INVALID_UTC_RANGE;
+	if (obj->to < obj->from) return FORMAT_INVALID_UTC_RANGE;
+
+	return FORMAT_OK;
+}
+
+int isFormatOk_timeRange(const char *range) {
+	UINT64_RANGE tmp;
+	return time_range_parse(range, &tmp);
+}
+
+int extract_timeRange(void **extra, const char* str, void** obj) {
+	VARIABLE_IS_NOT_USED(extra);
+	if (str == NULL || obj == NULL) return PST_INVALID_ARGUMENT;
+	return time_range_parse(str, (UINT64_RANGE*)obj) == FORMAT_OK ? PST_OK : PST_INVALID_FORMAT;
+}
+
 int isInteger(const char *str) {
 	int i = 0;
 	int C;
@@ -1432,6 +1558,8 @@ const char *getParameterErrorString(int res) {
 		case FORMAT_INVALID_RECORD: return "Positions must be represented by positive decimal integers, using a list of comma-separated ranges";
 		case FORMAT_INVALID_DELIMITER: return "Invalid delimiter. Only 'new-line', 'space' or one of ':;,|' is supported";
 		case FORMAT_RECORD_DESC_ORDER: return "List of positions must be given in strictly ascending order";
+		case FORMAT_INVALID_LINE_RANGE: return "Line range must be <from>-<to>, <from>- or <line>, using positive decimal integers in ascending order";
+		case FORMAT_INVALID_UTC_RANGE: return "Time range must be <from>,<to>, where one of the times can be omitted and <from> is not after <to>";
 		default: return "Unknown error";
 	}
 }
@@ -20,6 +20,7 @@
 #ifndef PARAM_CONTROL_H
 #define	PARAM_CONTROL_H
 
+#include <stdint.h>
 #include "err_trckr.h"
 #include "param_set/param_set.h"
 
@@ -102,6 +103,8 @@ enum formatStatus_enum{
 	FORMAT_INVALID_RECORD,
 	FORMAT_RECORD_DESC_ORDER,
 	FORMAT_INVALID_DELIMITER,
+	FORMAT_INVALID_LINE_RANGE,
+	FORMAT_INVALID_UTC_RANGE,
 	FORMAT_UNKNOWN_ERROR
 };
 
@@ -175,6 +178,16 @@ int isFormatOk_fileNameDelimiter(const char *delimiter);
 
 int isFormatOk_recordExtract(const char *rec);
 
+typedef struct UINT64_RANGE_st {
+	uint64_t from;
+	uint64_t to;
+} UINT64_RANGE;
+
+int isFormatOk_lineRange(const char *range);
+int extract_lineRange(void **extra, const char* str, void** obj);
+int isFormatOk_timeRange(const char *range);
+int extract_timeRange(void **extra, const char* str, void** obj);
+
 int convertRepair_constraint(const char* arg, char* buf, unsigned len);
 
 int get_pipe_out_error(PARAM_SET *set, ERR_TRCKR *err, const char *check_all_files, const char *out_file_names, const char *print_out_names);
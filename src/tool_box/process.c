@@ -42,6 +42,7 @@
 #include <ksi/tlv_element.h>
 #include "tlv_object.h"
 #include "logsig_version.h"
+#include "logline_pipeline.h"
 #include <gtrfc3161/tsconvert.h>
 
 //static int is_block_signature_expected(ERR_TRCKR *err, LOGKSI *logksi);
@@ -705,6 +706,121 @@ int process_log_signature_with_block_signature(PARAM_SET *set, MULTI_PRINTER *mp
 	return process_log_signature_general_components_(set, mp, err, ksi, pubFile, 1, logksi, files, processors);
 }
 
+int process_block_signature_without_tree(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, LOGKSI *logksi, IO_FILES *files, KSI_CTX *ksi, SIGNATURE_PROCESSORS *processors, KSI_PublicationsFile *pubFile) {
+	int res;
+	KSI_Signature *sig = NULL;
+	KSI_VerificationContext context;
+	KSI_TlvElement *tlv = NULL;
+	KSI_TlvElement *tlvSig = NULL;
+	KSI_TlvElement *tlvUnsig = NULL;
+	KSI_TlvElement *tlvRfc3161 = NULL;
+	KSI_Integer *t1 = NULL;
+	char sigTimeStr[256] = "<null>";
+
+	KSI_VerificationContext_init(&context, ksi);
+
+	if (set == NULL || err == NULL || ksi == NULL || processors == NULL || processors->extend_signature == NULL || files == NULL || logksi == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	logksi->sigNo++;
+	if (logksi->sigNo > logksi->blockNo) {
+		res = KT_INVALID_INPUT_FORMAT;
+		ERR_CATCH_MSG(err, res, "Error: Block no. %zu: block signature data without preceding block header found.", logksi->sigNo);
+	}
+
+	logksi->block.signatureTLVReached = 1;
+
+	print_progressDesc(mp, MP_ID_BLOCK, 0, DEBUG_LEVEL_3, "Block no. %3zu: processing block signature data... ", logksi->blockNo);
+
+	res = tlv_element_parse_and_check_sub_elements(err, ksi, logksi->ftlv_raw, logksi->ftlv_len, logksi->ftlv.hdr_len, &tlv);
+	ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to parse block signature as TLV element.", logksi->blockNo);
+
+	res = tlv_element_get_uint(tlv, ksi, 0x01, &logksi->block.recordCount);
+	ERR_CATCH_MSG(err, res, "Error: Block no. %zu: missing record count in block signature.", logksi->blockNo);
+
+	if (logksi->block.recordCount < logksi->block.nofMetaRecords) {
+		res = KT_INVALID_INPUT_FORMAT;
+		ERR_CATCH_MSG(err, res, "Error: Block no. %zu: record count %zu is smaller than the count of meta-records %zu.", logksi->blockNo, logksi->block.recordCount, logksi->block.nofMetaRecords);
+	}
+
+	/* Record hashes are not read, they are counted as if all of them were present. */
+	logksi->block.nofRecordHashes = logksi->block.recordCount;
+	logksi->file.nofTotalRecordHashes += logksi->block.nofRecordHashes;
+
+	res = KSI_TlvElement_getElement(tlv, 0x906, &tlvRfc3161);
+	ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to extract RFC3161 element in block signature.", logksi->blockNo);
+
+	if (tlvRfc3161 != NULL) {
+		/* Convert the RFC3161 timestamp into KSI signature and replace it in the TLV. */
+		res = convert_signature(ksi, tlvRfc3161->ptr + tlvRfc3161->ftlv.hdr_len, tlvRfc3161->ftlv.dat_len, &sig);
+		ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to convert RFC3161 element in block signature.", logksi->blockNo);
+
+		res = KSI_TlvElement_removeElement(tlv, 0x906, NULL);
+		ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to remove RFC3161 timestamp from block signature.", logksi->blockNo);
+		res = tlv_element_set_signature(tlv, ksi, 0x905, sig);
+		ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to insert KSI signature in block signature.", logksi->blockNo);
+		KSI_Signature_free(sig);
+		sig = NULL;
+
+		logksi->file.warningLegacy = 1;
+	}
+
+	res = KSI_TlvElement_getElement(tlv, 0x905, &tlvSig);
+	ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to extract KSI signature element in block signature.", logksi->blockNo);
+
+	res = KSI_TlvElement_getElement(tlv, 0x02, &tlvUnsig);
+	ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to extract unsigned block marker.", logksi->blockNo);
+
+	if (tlvUnsig != NULL) {
+		res = KT_VERIFICATION_NA;
+		logksi->block.curBlockNotSigned = 1;
+		ERR_TRCKR_addAdditionalInfo(err, "  * Suggestion: Use logksi sign to sign unsigned blocks.\n");
+		ERR_CATCH_MSG(err, res, "Error: Block no. %zu is unsigned and missing KSI signature in block signature.", logksi->blockNo);
+	} else if (tlvSig == NULL) {
+		res = KT_INVALID_INPUT_FORMAT;
+		ERR_CATCH_MSG(err, res, "Error: Block no. %zu: missing KSI signature (and unsigned block marker) in block signature.", logksi->blockNo);
+	}
+
+	print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_3, res);
+
+	/* As the Merkle tree is not rebuilt, the document hash is not set and only the
+	 * internal consistency of the KSI signature is verified before extending. */
+	context.docAggrLevel = LOGKSI_get_aggregation_level(logksi);
+
+	res = LOGKSI_Signature_parseWithPolicy(err, ksi, tlvSig->ptr + tlvSig->ftlv.hdr_len, tlvSig->ftlv.dat_len, KSI_VERIFICATION_POLICY_INTERNAL, &context, &sig);
+	ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to parse KSI signature.", logksi->blockNo);
+
+	res = extend_and_store(sig, &context, tlv, set, mp, err, ksi, pubFile, processors, logksi, files);
+	ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to extend.", logksi->blockNo);
+
+	res = KSI_Signature_getSigningTime(sig, &t1);
+	ERR_CATCH_MSG(err, res, NULL);
+
+	logksi->block.sigTime_1 = KSI_Integer_getUInt64(t1);
+
+	print_debug_mp(mp, MP_ID_BLOCK, DEBUG_LEVEL_3, "Block no. %3zu: signing time: (%llu) %s\n", logksi->blockNo, logksi->block.sigTime_1, LOGKSI_signature_sigTimeToString(sig, sigTimeStr, sizeof(sigTimeStr)));
+
+	res = check_log_signature_client_id(set, mp, err, logksi, sig);
+	if (res != KT_OK) goto cleanup;
+
+	res = KT_OK;
+
+cleanup:
+
+	print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_3, res);
+
+	KSI_Signature_free(sig);
+	KSI_VerificationContext_clean(&context);
+	KSI_TlvElement_free(tlvSig);
+	KSI_TlvElement_free(tlvUnsig);
+	KSI_TlvElement_free(tlvRfc3161);
+	KSI_TlvElement_free(tlv);
+
+	return res;
+}
+
 void print_block_duration_summary(MULTI_PRINTER *mp, int indent, LOGKSI *logksi) {
 	char strT1[256];
 
@@ -767,6 +883,11 @@ int finalize_block(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, LOGKSI *lo
 	if ((logksi->file.recTimeMin == 0 || logksi->file.recTimeMin > logksi->block.recTimeMin) && logksi->block.recTimeMin > 0) logksi->file.recTimeMin = logksi->block.recTimeMin;
 	if (logksi->file.recTimeMax == 0 || logksi->file.recTimeMax < logksi->block.recTimeMax) logksi->file.recTimeMax = logksi->block.recTimeMax;
 
+	if (logksi->blockNo == logksi->file.firstBlockNo) {
+		logksi->file.recTimeFirst = logksi->block.recTimeMin;
+		logksi->file.sigTimeFirst = logksi->block.sigTime_1;
+	}
+
 	res = check_block_signing_time_check(set, mp, err, logksi, files);
 	if (res != KT_OK) goto cleanup;
 
@@ -833,6 +954,11 @@ int finalize_block(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, LOGKSI *lo
 		}
 	}
 
+	if (logksi->blockNo > 0 && logksi->file.version != RECSIG11 && logksi->file.version != RECSIG12) {
+		res = LOGKSI_addBlockToIndex(logksi);
+		ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to add block to the block index.", logksi->blockNo);
+	}
+
 	/* Print Output hash of previous block. */
 	if (prevLeaf != NULL && ((logksi->taskId == TASK_VERIFY && logksi->block.signatureTLVReached) || logksi->taskId == TASK_CREATE)) {
 		char buf[256];
@@ -890,10 +1016,14 @@ int finalize_log_signature(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, LO
 
 	print_progressDesc(mp, MP_ID_BLOCK, 0, DEBUG_LEVEL_3, "Finalizing log signature... ");
 
-	/* Log file must not contain more records than log signature file. */
-	if (files->files.inLog) {
+	/* Log file must not contain more records than log signature file. When only some
+	 * of the blocks are processed, the end of log file is not reached. */
+	if (files->files.inLog && !logksi->file.isPartial) {
 		size_t count = 0;
-		SMART_FILE_read(files->files.inLog, buf, 1, &count);
+
+		/* Lines read ahead by the pipeline are not in the log file any more. */
+		if (LOGLINE_PIPELINE_hasMoreData(logksi->logLinePipeline)) count = 1;
+		else SMART_FILE_read(files->files.inLog, buf, 1, &count);
 		if (count > 0) {
 			res = KT_VERIFICATION_FAILURE;
 			ERR_CATCH_MSG(err, res, "Error: Block no. %zu: end of log file contains unexpected records.", logksi->blockNo);
@@ -1073,8 +1203,14 @@ static int process_block_header(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *er
 		res = SMART_FILE_markConsistent(files->files.outSig);
 		ERR_CATCH_MSG(err, res, "Error: Block no. %zu: Unable to mark output log signature file consistent.", logksi->blockNo);
 
+		res = LOGKSI_setBlockSigOffset(logksi, files->files.outSig, 0);
+		if (res != KT_OK) goto cleanup;
+
 		res = SMART_FILE_write(files->files.outSig, logksi->ftlv_raw, logksi->ftlv_len, NULL);
 		ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to copy block header.", logksi->blockNo);
+	} else if (files->files.inSig) {
+		res = LOGKSI_setBlockSigOffset(logksi, files->files.inSig, logksi->ftlv_len);
+		if (res != KT_OK) goto cleanup;
 	}
 
 	res = MERKLE_TREE_reset(logksi->tree, algo,
@@ -2101,8 +2237,20 @@ int logksi_logline_calculate_hash_and_store(LOGKSI *logksi, IO_FILES *files, KSI
 	res = MERKLE_TREE_getHasher(logksi->tree, &pHasher);
 	if (res != KSI_OK) goto cleanup;
 
-	if (files->files.inLog) {
-		res = LOGKSI_readLine(logksi, files->files.inLog);
+	if (files->files.inLog && logksi->logLinePipeline != NULL) {
+		KSI_HashAlgorithm algo = KSI_HASHALG_INVALID_VALUE;
+
+		res = MERKLE_TREE_getHashAlgo(logksi->tree, &algo);
+		if (res != KT_OK) goto cleanup;
+
+		res = LOGLINE_PIPELINE_nextLine(logksi->logLinePipeline, logksi, files->files.inLog, algo, &tmp);
+		if (res != KT_OK) goto cleanup;
+	} else if (files->files.inLog) {
+		const char *line = NULL;
+		size_t line_len = 0;
+
+		/* Line is hashed directly from the memory mapped file, if possible. */
+		res = LOGKSI_readLineSpan(logksi, files->files.inLog, &line, &line_len);
 		if (res != SMART_FILE_OK) goto cleanup;
 
 		if (SMART_FILE_isEof(files->files.inLog)) {
@@ -2112,8 +2260,8 @@ int logksi_logline_calculate_hash_and_store(LOGKSI *logksi, IO_FILES *files, KSI
 
 		res = KSI_DataHasher_reset(pHasher);
 		if (res != KSI_OK) goto cleanup;
-		/* Last character (newline) is not used in hash calculation. */
-		res = KSI_DataHasher_add(pHasher, logksi->logLine, logksi->logLine_len - 1);
+		/* Newline character is not used in hash calculation. */
+		res = KSI_DataHasher_add(pHasher, line, line_len);
 		if (res != KSI_OK) goto cleanup;
 		res = KSI_DataHasher_close(pHasher, &tmp);
 		if (res != KSI_OK) goto cleanup;
@@ -53,6 +53,14 @@ int process_ksi_signature(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, LOG
 int process_log_signature(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, LOGKSI *logksi, IO_FILES *files, KSI_CTX *ksi);
 int process_log_signature_with_block_signature(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, LOGKSI *logksi, IO_FILES *files, KSI_CTX *ksi, SIGNATURE_PROCESSORS *processors, KSI_PublicationsFile *pubFile);
 
+/**
+ * Extends the KSI signature in the block signature TLV (logksi->ftlv_raw) without
+ * rebuilding the Merkle tree of the block. The KSI signature is not checked against
+ * the root hash of the tree, only its internal consistency is verified. Block header
+ * and meta-records must be counted by the caller.
+ */
+int process_block_signature_without_tree(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, LOGKSI *logksi, IO_FILES *files, KSI_CTX *ksi, SIGNATURE_PROCESSORS *processors, KSI_PublicationsFile *pubFile);
+
 int logksi_logline_calculate_hash_and_store(LOGKSI *logksi, IO_FILES *files, KSI_DataHash **hash);
 int finalize_block(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, LOGKSI *logksi, IO_FILES *files, KSI_CTX *ksi);
 int finalize_log_signature(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, LOGKSI *logksi, IO_FILES *files, KSI_CTX *ksi, KSI_DataHash *inputHash);
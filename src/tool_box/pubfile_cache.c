@@ -0,0 +1,320 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "logksi_err.h"
+#include "smart_file.h"
+#include "pubfile_cache.h"
+
+/**
+ * Cache file layout (all integers are 64-bit big-endian):
+ *   magic "LOGPFC10" | creation time | verified | trust digest | size of the publications file | publications file
+ */
+#define PUBFILE_CACHE_MAGIC "LOGPFC10"
+#define PUBFILE_CACHE_MAGIC_SIZE 8
+#define PUBFILE_CACHE_HEADER_SIZE (PUBFILE_CACHE_MAGIC_SIZE + 3 * 8 + PUBFILE_CACHE_DIGEST_SIZE)
+#define PUBFILE_CACHE_MAX_DATA_SIZE 0x1000000
+
+/* Time to sleep between the attempts to take the lock and the count of attempts. */
+#define PUBFILE_CACHE_LOCK_POLL_INTERVAL_NS 100000000
+#define PUBFILE_CACHE_LOCK_MAX_ATTEMPTS 600
+
+struct PUBFILE_CACHE_st {
+	uint64_t created;
+	int isVerified;
+	unsigned char trust[PUBFILE_CACHE_DIGEST_SIZE];
+	unsigned char *data;
+	size_t data_len;
+};
+
+static void pubfile_cache_put_uint64(unsigned char *buf, uint64_t val) {
+	int i;
+
+	for (i = 7; i >= 0; i--) {
+		buf[i] = (unsigned char)(val & 0xff);
+		val >>= 8;
+	}
+}
+
+static uint64_t pubfile_cache_get_uint64(const unsigned char *buf) {
+	uint64_t val = 0;
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		val = (val << 8) | buf[i];
+	}
+
+	return val;
+}
+
+static int pubfile_cache_read_all(SMART_FILE *in, unsigned char *buf, size_t len) {
+	int res;
+	size_t count = 0;
+
+	res = SMART_FILE_read(in, buf, len, &count);
+	if (res != SMART_FILE_OK) return res;
+
+	return (count == len) ? KT_OK : KT_INVALID_INPUT_FORMAT;
+}
+
+int PUBFILE_CACHE_new(const unsigned char *trust, const unsigned char *raw, size_t raw_len, int isVerified, PUBFILE_CACHE **cache) {
+	int res = KT_UNKNOWN_ERROR;
+	PUBFILE_CACHE *tmp = NULL;
+
+	if (trust == NULL || raw == NULL || raw_len == 0 || raw_len > PUBFILE_CACHE_MAX_DATA_SIZE || cache == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	tmp = (PUBFILE_CACHE*)malloc(sizeof(PUBFILE_CACHE));
+	if (tmp == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	tmp->created = (uint64_t)time(NULL);
+	tmp->isVerified = isVerified ? 1 : 0;
+	memcpy(tmp->trust, trust, PUBFILE_CACHE_DIGEST_SIZE);
+	tmp->data_len = raw_len;
+
+	tmp->data = (unsigned char*)malloc(raw_len);
+	if (tmp->data == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+	memcpy(tmp->data, raw, raw_len);
+
+	*cache = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	PUBFILE_CACHE_free(tmp);
+
+	return res;
+}
+
+void PUBFILE_CACHE_free(PUBFILE_CACHE *cache) {
+	if (cache == NULL) return;
+	free(cache->data);
+	free(cache);
+}
+
+int PUBFILE_CACHE_isFresh(PUBFILE_CACHE *cache, const unsigned char *trust, uint64_t ttl) {
+	uint64_t now = (uint64_t)time(NULL);
+
+	if (cache == NULL || trust == NULL) return 0;
+	if (memcmp(cache->trust, trust, PUBFILE_CACHE_DIGEST_SIZE) != 0) return 0;
+
+	/* Entry from the future is not trusted as the clock may have been changed. */
+	return cache->created <= now && now - cache->created < ttl;
+}
+
+int PUBFILE_CACHE_isSame(PUBFILE_CACHE *cache, const unsigned char *trust, const unsigned char *raw, size_t raw_len) {
+	if (cache == NULL || trust == NULL || raw == NULL) return 0;
+	if (memcmp(cache->trust, trust, PUBFILE_CACHE_DIGEST_SIZE) != 0) return 0;
+
+	return cache->data_len == raw_len && memcmp(cache->data, raw, raw_len) == 0;
+}
+
+int PUBFILE_CACHE_isVerified(PUBFILE_CACHE *cache) {
+	if (cache == NULL) return 0;
+	return cache->isVerified;
+}
+
+void PUBFILE_CACHE_setVerified(PUBFILE_CACHE *cache) {
+	if (cache == NULL) return;
+	cache->isVerified = 1;
+}
+
+const unsigned char *PUBFILE_CACHE_getData(PUBFILE_CACHE *cache, size_t *raw_len) {
+	if (cache == NULL) return NULL;
+	if (raw_len != NULL) *raw_len = cache->data_len;
+	return cache->data;
+}
+
+int PUBFILE_CACHE_write(PUBFILE_CACHE *cache, const char *fname) {
+	int res = KT_UNKNOWN_ERROR;
+	SMART_FILE *out = NULL;
+	unsigned char buf[PUBFILE_CACHE_HEADER_SIZE];
+	unsigned char *p = buf;
+	SMART_FILE_IOVEC iov[2];
+
+	if (cache == NULL || fname == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	memcpy(p, PUBFILE_CACHE_MAGIC, PUBFILE_CACHE_MAGIC_SIZE);
+	p += PUBFILE_CACHE_MAGIC_SIZE;
+	pubfile_cache_put_uint64(p, cache->created);
+	p += 8;
+	pubfile_cache_put_uint64(p, (uint64_t)cache->isVerified);
+	p += 8;
+	memcpy(p, cache->trust, PUBFILE_CACHE_DIGEST_SIZE);
+	p += PUBFILE_CACHE_DIGEST_SIZE;
+	pubfile_cache_put_uint64(p, cache->data_len);
+
+	iov[0].raw = buf;
+	iov[0].raw_len = sizeof(buf);
+	iov[1].raw = cache->data;
+	iov[1].raw_len = cache->data_len;
+
+	res = SMART_FILE_open(fname, "wbT", &out);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	res = SMART_FILE_writev(out, iov, 2, NULL);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	res = SMART_FILE_markConsistent(out);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	res = SMART_FILE_close(out);
+	out = NULL;
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	res = KT_OK;
+
+cleanup:
+
+	SMART_FILE_close(out);
+
+	return res;
+}
+
+int PUBFILE_CACHE_read(const char *fname, PUBFILE_CACHE **cache) {
+	int res = KT_UNKNOWN_ERROR;
+	SMART_FILE *in = NULL;
+	PUBFILE_CACHE *tmp = NULL;
+	unsigned char buf[PUBFILE_CACHE_HEADER_SIZE];
+	const unsigned char *p = buf;
+	uint64_t data_len = 0;
+
+	if (fname == NULL || cache == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	res = SMART_FILE_open(fname, "rb", &in);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	res = pubfile_cache_read_all(in, buf, sizeof(buf));
+	if (res != KT_OK) goto cleanup;
+
+	if (memcmp(p, PUBFILE_CACHE_MAGIC, PUBFILE_CACHE_MAGIC_SIZE) != 0) {
+		res = KT_INVALID_INPUT_FORMAT;
+		goto cleanup;
+	}
+	p += PUBFILE_CACHE_MAGIC_SIZE;
+
+	tmp = (PUBFILE_CACHE*)malloc(sizeof(PUBFILE_CACHE));
+	if (tmp == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	tmp->data = NULL;
+	tmp->data_len = 0;
+	tmp->created = pubfile_cache_get_uint64(p);
+	p += 8;
+	tmp->isVerified = pubfile_cache_get_uint64(p) ? 1 : 0;
+	p += 8;
+	memcpy(tmp->trust, p, PUBFILE_CACHE_DIGEST_SIZE);
+	p += PUBFILE_CACHE_DIGEST_SIZE;
+	data_len = pubfile_cache_get_uint64(p);
+
+	if (data_len == 0 || data_len > PUBFILE_CACHE_MAX_DATA_SIZE) {
+		res = KT_INVALID_INPUT_FORMAT;
+		goto cleanup;
+	}
+
+	tmp->data = (unsigned char*)malloc((size_t)data_len);
+	if (tmp->data == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+	tmp->data_len = (size_t)data_len;
+
+	res = pubfile_cache_read_all(in, tmp->data, tmp->data_len);
+	if (res != KT_OK) goto cleanup;
+
+	*cache = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	SMART_FILE_close(in);
+	PUBFILE_CACHE_free(tmp);
+
+	return res;
+}
+
+int PUBFILE_CACHE_lock(const char *fname, SMART_FILE **lock) {
+	int res = KT_UNKNOWN_ERROR;
+	SMART_FILE *tmp = NULL;
+	char *lockFname = NULL;
+	int i;
+
+	if (fname == NULL || lock == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	lockFname = (char*)malloc(strlen(fname) + sizeof(PUBFILE_CACHE_LOCK_EXTENSION));
+	if (lockFname == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+	sprintf(lockFname, "%s%s", fname, PUBFILE_CACHE_LOCK_EXTENSION);
+
+	/* The lock file is always empty, so it does not matter if it is truncated while locked by another process. */
+	res = SMART_FILE_open(lockFname, "wb", &tmp);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	for (i = 0; ; i++) {
+		struct timespec interval = {0, PUBFILE_CACHE_LOCK_POLL_INTERVAL_NS};
+
+		res = SMART_FILE_lock(tmp, SMART_FILE_WRITE_LOCK);
+		if (res == SMART_FILE_OK) break;
+		if (res != SMART_FILE_UNABLE_TO_LOCK) goto cleanup;
+
+		if (i + 1 >= PUBFILE_CACHE_LOCK_MAX_ATTEMPTS) {
+			res = KT_TIMEOUT;
+			goto cleanup;
+		}
+
+		nanosleep(&interval, NULL);
+	}
+
+	*lock = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	SMART_FILE_close(tmp);
+	free(lockFname);
+
+	return res;
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+#ifndef PUBFILE_CACHE_H
+#define	PUBFILE_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "smart_file.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/* Size of the SHA-256 digest of the trust settings kept in the cache file. */
+#define PUBFILE_CACHE_DIGEST_SIZE 32
+
+/* Default time in seconds the cached publications file is used without downloading it again. */
+#define PUBFILE_CACHE_DEFAULT_TTL 3600
+
+/* File extension of the lock file that is added to the cache file name. */
+#define PUBFILE_CACHE_LOCK_EXTENSION ".lock"
+
+typedef struct PUBFILE_CACHE_st PUBFILE_CACHE;
+
+/**
+ * Creates a cache entry that holds the raw publications file. The entry is kept in
+ * a file (see #PUBFILE_CACHE_write) so that the publications file does not have to be
+ * downloaded and verified again by every process. The creation time of the entry is
+ * set to the current time.
+ * \param trust			Digest of the trust settings (publications file URL, certificate
+ *						constraints and trust store) the file was received with.
+ * \param raw			Raw publications file.
+ * \param raw_len		Size of the raw publications file.
+ * \param isVerified	Set if the PKI signature of the publications file is verified.
+ * \param cache			Output parameter for the cache entry.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int PUBFILE_CACHE_new(const unsigned char *trust, const unsigned char *raw, size_t raw_len, int isVerified, PUBFILE_CACHE **cache);
+void PUBFILE_CACHE_free(PUBFILE_CACHE *cache);
+
+/**
+ * Returns non-zero value, if the entry is made with the same trust settings and is
+ * not older than \c ttl seconds.
+ */
+int PUBFILE_CACHE_isFresh(PUBFILE_CACHE *cache, const unsigned char *trust, uint64_t ttl);
+
+/**
+ * Returns non-zero value, if the entry is made with the same trust settings and holds
+ * the same publications file.
+ */
+int PUBFILE_CACHE_isSame(PUBFILE_CACHE *cache, const unsigned char *trust, const unsigned char *raw, size_t raw_len);
+
+int PUBFILE_CACHE_isVerified(PUBFILE_CACHE *cache);
+void PUBFILE_CACHE_setVerified(PUBFILE_CACHE *cache);
+
+/**
+ * Returns the raw publications file. The pointer is valid until the entry is freed.
+ */
+const unsigned char *PUBFILE_CACHE_getData(PUBFILE_CACHE *cache, size_t *raw_len);
+
+/**
+ * Writes the cache file. The file is written to a temporary file first and renamed
+ * when complete, so the file can be read by other processes without a lock.
+ * \param cache			Cache entry.
+ * \param fname			Name of the cache file.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int PUBFILE_CACHE_write(PUBFILE_CACHE *cache, const char *fname);
+
+/**
+ * Reads the cache file.
+ * \param fname			Name of the cache file.
+ * \param cache			Output parameter for the cache entry.
+ * \return KT_OK if successful, KT_INVALID_INPUT_FORMAT if the cache file is corrupted,
+ * error code otherwise.
+ */
+int PUBFILE_CACHE_read(const char *fname, PUBFILE_CACHE **cache);
+
+/**
+ * Takes an exclusive lock on the lock file of the cache file (the name of the cache
+ * file with #PUBFILE_CACHE_LOCK_EXTENSION). Only one process at a time should update
+ * the cache file. If the lock is held by another process, it is waited for.
+ * \param fname			Name of the cache file.
+ * \param lock			Output parameter for the lock file. The lock is released when the
+ *						file is closed with #SMART_FILE_close.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int PUBFILE_CACHE_lock(const char *fname, SMART_FILE **lock);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* PUBFILE_CACHE_H */
@@ -19,6 +19,9 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
 #include <ksi/ksi.h>
 #include <ksi/tlv_element.h>
 #include <ctype.h>
@@ -36,10 +39,36 @@
 #include "check.h"
 #include "process.h"
 #include "logksi.h"
+#include "ksi_init.h"
+#include "sign_queue.h"
+#include "sign_batch.h"
+#include "logline_pipeline.h"
+#include "block_index.h"
+#include "param_control.h"
 
 static int count_blocks(ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *logksi, SMART_FILE *in);
+static int open_block_index(PARAM_SET *set, ERR_TRCKR *err, LOGKSI *logksi, IO_FILES *files);
+static int save_block_index(ERR_TRCKR *err, LOGKSI *logksi, IO_FILES *files);
+static int resume_followed_log(MULTI_PRINTER* mp, ERR_TRCKR *err, LOGKSI *logksi, IO_FILES *files, STATE_FILE *state);
+static int set_follow_state(ERR_TRCKR *err, LOGKSI *logksi, IO_FILES *files, STATE_FILE *state, LOG_FOLLOW *follow);
+static int scan_block_index(ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *logksi, SMART_FILE *in, BLOCK_INDEX **index);
+static int open_input_block_index(MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *logksi, IO_FILES *files, BLOCK_INDEX **index);
+static int extract_indexed_blocks(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *logksi, IO_FILES *files, SIGNATURE_PROCESSORS *processors);
+static int skip_to_verified_blocks(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *logksi, IO_FILES *files, BLOCK_INDEX **index, size_t *lastBlockNo);
+static int skip_to_block_range(MULTI_PRINTER* mp, ERR_TRCKR *err, LOGKSI *logksi, IO_FILES *files, size_t *lastBlockNo);
+static int skip_to_block(ERR_TRCKR *err, LOGKSI *logksi, IO_FILES *files, BLOCK_INDEX *index, size_t i);
+static int get_log_position(LOGKSI *logksi, IO_FILES *files, size_t *pos);
+static int skip_blocks_verified_earlier(MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *logksi, IO_FILES *files, VERIFY_LEDGER *ledger, BLOCK_INDEX **index, VERIFY_LEDGER_ENTRY **entries, size_t *count, KSI_DataHash **firstInputHash);
+static int update_verify_ledger(ERR_TRCKR *err, LOGKSI *logksi, IO_FILES *files, VERIFY_LEDGER *ledger, VERIFY_LEDGER_ENTRY *entries, size_t count, int result);
+static int check_inter_linking_input_hash(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, IO_FILES *files, size_t blockNo, KSI_DataHash *firstLink, KSI_DataHash *inputHash);
+static int digest_file_range(KSI_DataHasher *hsr, SMART_FILE *in, uint64_t from, uint64_t to, unsigned char *digest);
+static int extend_block_signatures_only(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, KSI_PublicationsFile* pubFile, SIGNATURE_PROCESSORS *processors, LOGKSI *logksi, IO_FILES *files);
+static void verify_ledger_set_imprint(KSI_DataHash *hash, unsigned char *imprint, size_t *imprint_len);
 static int skip_current_block_as_it_does_not_verify(LOGKSI *logksi, MULTI_PRINTER* mp, IO_FILES *files, ERR_TRCKR *err, KSI_CTX *ksi, int *skip);
 static int wrapper_LOGKSI_createSignature(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *logksi, IO_FILES *files, KSI_DataHash *hash, KSI_uint64_t rootLevel, KSI_Signature **sig);
+static int presigned_LOGKSI_createSignature(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *logksi, IO_FILES *files, KSI_DataHash *hash, KSI_uint64_t rootLevel, KSI_Signature **sig);
+static int presign_unsigned_blocks(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *logksi, SMART_FILE *in, size_t maxRequests, size_t batchSize);
+static void sign_batch_free(void *obj);
 static int logksi_new_record_chain(MERKLE_TREE *tree, void *ctx, int isMetaRecordHash, KSI_DataHash *hash);
 static int logksi_extract_record_chain(MERKLE_TREE *tree, void *ctx, unsigned char level, KSI_DataHash *leftLink);;
 
@@ -53,7 +82,7 @@ static void print_excerpt_file_block_summary(MULTI_PRINTER *mp, LOGKSI *logksi)
 	print_debug_mp(mp, MP_ID_BLOCK_SUMMARY, DEBUG_EQUAL | DEBUG_LEVEL_2, "\n");
 }
 
-int logsignature_extend(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, KSI_PublicationsFile* pubFile, EXTENDING_FUNCTION extend_signature, IO_FILES *files) {
+int logsignature_extend(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, KSI_PublicationsFile* pubFile, EXTENDING_FUNCTION extend_signature, IO_FILES *files, EXTEND_CACHE *cache) {
 	int res;
 	LOGKSI logksi;
 	unsigned char ftlv_raw[SOF_FTLV_BUFFER];
@@ -69,10 +98,11 @@ int logsignature_extend(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_C
 	logksi.ftlv_raw = ftlv_raw;
 	logksi.taskId = TASK_EXTEND;
 	logksi.err = err;
+	logksi.task.extend.cache = cache;
 	memset(&processors, 0, sizeof(processors));
 	processors.extend_signature = extend_signature;
 
-	res = MERKLE_TREE_new(&logksi.tree);
+	res = MERKLE_TREE_new(ksi, &logksi.tree);
 	if (res != KT_OK) goto cleanup;
 
 	logksi.isContinuedOnFail = PARAM_SET_isSetByName(set, "continue-on-fail");
@@ -80,80 +110,91 @@ int logsignature_extend(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_C
 	res = process_magic_number(set, mp, err, &logksi, files);
 	if (res != KT_OK) goto cleanup;
 
-	while (!SMART_FILE_isEof(files->files.inSig)) {
-		MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
+	if (logksi.file.version == LOGSIG11 || logksi.file.version == LOGSIG12) {
+		res = open_block_index(set, err, &logksi, files);
+		if (res != KT_OK) goto cleanup;
+	}
 
-		res = LOGKSI_FTLV_smartFileRead(files->files.inSig, logksi.ftlv_raw, SOF_FTLV_BUFFER, &logksi.ftlv_len, &logksi.ftlv);
-		if (res == KSI_OK) {
-			switch(logksi.file.version) {
-				case LOGSIG11:
-				case LOGSIG12:
-					switch (logksi.ftlv.tag) {
-						case 0x901:
-							if (theFirstInputHashInFile == NULL) theFirstInputHashInFile = KSI_DataHash_ref(logksi.block.inputHash);
-						case 0x902:
-						case 0x903:
-						case 0x911:
-						case 0x904:
-							res = process_log_signature_with_block_signature(set, mp, err, &logksi, files, ksi, &processors, pubFile);
-							if (res != KT_OK) goto cleanup;
+	/* Only the block signatures are parsed, everything else is copied as it is. */
+	if ((logksi.file.version == LOGSIG11 || logksi.file.version == LOGSIG12) && PARAM_SET_isSetByName(set, "skip-tree-check") && !SMART_FILE_isStream(files->files.inSig)) {
+		res = extend_block_signatures_only(set, mp, err, ksi, pubFile, &processors, &logksi, files);
+		if (res != KT_OK) goto cleanup;
+	} else {
+		while (!SMART_FILE_isEof(files->files.inSig)) {
+			MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
+
+			res = LOGKSI_FTLV_smartFileRead(files->files.inSig, logksi.ftlv_raw, SOF_FTLV_BUFFER, &logksi.ftlv_len, &logksi.ftlv);
+			if (res == KSI_OK) {
+				switch(logksi.file.version) {
+					case LOGSIG11:
+					case LOGSIG12:
+						switch (logksi.ftlv.tag) {
+							case 0x901:
+								if (theFirstInputHashInFile == NULL) theFirstInputHashInFile = KSI_DataHash_ref(logksi.block.inputHash);
+							case 0x902:
+							case 0x903:
+							case 0x911:
+							case 0x904:
+								res = process_log_signature_with_block_signature(set, mp, err, &logksi, files, ksi, &processors, pubFile);
+								if (res != KT_OK) goto cleanup;
+							break;
+
+							default:
+								/* TODO: unknown TLV found. Either
+								 * 1) Warn user and skip TLV
+								 * 2) Copy TLV (maybe warn user)
+								 * 3) Abort extending with an error
+								 */
+							break;
+						}
 						break;
+					case RECSIG11:
+					case RECSIG12:
+						switch (logksi.ftlv.tag) {
+							case 0x905:
+								logksi.file.nofTotalRecordHashes += logksi.block.nofRecordHashes;
+
+								res = process_ksi_signature(set, mp, err, &logksi, files, ksi, pubFile, &processors);
+								if (res != KT_OK) goto cleanup;
+
+								if (MULTI_PRINTER_hasDataByID(mp, MP_ID_BLOCK_SUMMARY)) {
+									print_excerpt_file_block_summary(mp, &logksi);
+									MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
+									MULTI_PRINTER_printByID(mp, MP_ID_BLOCK_ERRORS);
+									MULTI_PRINTER_printByID(mp, MP_ID_BLOCK_SUMMARY);
+								}
 
-						default:
-							/* TODO: unknown TLV found. Either
-							 * 1) Warn user and skip TLV
-							 * 2) Copy TLV (maybe warn user)
-							 * 3) Abort extending with an error
-							 */
-						break;
-					}
+								print_debug_mp(mp, MP_ID_BLOCK_SUMMARY, DEBUG_EQUAL | DEBUG_LEVEL_2, "\nSummary of block %zu:\n", logksi.blockNo);
+								print_block_sign_times(mp, SIZE_OF_SHORT_INDENTENTION, &logksi);
+							break;
+
+							case 0x907:
+								res = process_record_chain(set, mp, err, &logksi, files, ksi);
+								if (res != KT_OK) goto cleanup;
+
+								res = check_log_record_embedded_time_against_ksi_signature_time(set, mp, err, &logksi);
+								if (res != KT_OK) goto cleanup;
+							break;
+
+							default:
+								/* TODO: unknown TLV found. Either
+								 * 1) Warn user and skip TLV
+								 * 2) Copy TLV (maybe warn user)
+								 * 3) Abort extending with an error
+								 */
+							break;
+						}
+					default:
+						/* TODO: unknown file header found. */
 					break;
-				case RECSIG11:
-				case RECSIG12:
-					switch (logksi.ftlv.tag) {
-						case 0x905:
-							logksi.file.nofTotalRecordHashes += logksi.block.nofRecordHashes;
-
-							res = process_ksi_signature(set, mp, err, &logksi, files, ksi, pubFile, &processors);
-							if (res != KT_OK) goto cleanup;
-
-							if (MULTI_PRINTER_hasDataByID(mp, MP_ID_BLOCK_SUMMARY)) {
-								print_excerpt_file_block_summary(mp, &logksi);
-								MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
-								MULTI_PRINTER_printByID(mp, MP_ID_BLOCK_ERRORS);
-								MULTI_PRINTER_printByID(mp, MP_ID_BLOCK_SUMMARY);
-							}
-
-							print_debug_mp(mp, MP_ID_BLOCK_SUMMARY, DEBUG_EQUAL | DEBUG_LEVEL_2, "\nSummary of block %zu:\n", logksi.blockNo);
-							print_block_sign_times(mp, SIZE_OF_SHORT_INDENTENTION, &logksi);
-						break;
-
-						case 0x907:
-							res = process_record_chain(set, mp, err, &logksi, files, ksi);
-							if (res != KT_OK) goto cleanup;
-
-							res = check_log_record_embedded_time_against_ksi_signature_time(set, mp, err, &logksi);
-							if (res != KT_OK) goto cleanup;
-						break;
-
-						default:
-							/* TODO: unknown TLV found. Either
-							 * 1) Warn user and skip TLV
-							 * 2) Copy TLV (maybe warn user)
-							 * 3) Abort extending with an error
-							 */
-						break;
-					}
-				default:
-					/* TODO: unknown file header found. */
-				break;
-			}
-		} else {
-			if (logksi.ftlv_len > 0) {
-				res = KT_INVALID_INPUT_FORMAT;
-				ERR_CATCH_MSG(err, res, "Error: Block no. %zu: incomplete data found in log signature file.", logksi.blockNo);
+				}
 			} else {
-				break;
+				if (logksi.ftlv_len > 0) {
+					res = KT_INVALID_INPUT_FORMAT;
+					ERR_CATCH_MSG(err, res, "Error: Block no. %zu: incomplete data found in log signature file.", logksi.blockNo);
+				} else {
+					break;
+				}
 			}
 		}
 	}
@@ -166,6 +207,9 @@ int logsignature_extend(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_C
 	res = finalize_log_signature(set, mp, err, &logksi, files, ksi, theFirstInputHashInFile);
 	if (res != KT_OK) goto cleanup;
 
+	res = save_block_index(err, &logksi, files);
+	if (res != KT_OK) goto cleanup;
+
 	res = KT_OK;
 
 cleanup:
@@ -188,7 +232,7 @@ cleanup:
 	return res;
 }
 
-int logsignature_verify(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *logksi, KSI_DataHash *firstLink, VERIFYING_FUNCTION verify_signature, IO_FILES *files, KSI_DataHash **lastLeaf, uint64_t* last_rec_time) {
+int logsignature_verify(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *logksi, KSI_DataHash *firstLink, VERIFYING_FUNCTION verify_signature, IO_FILES *files, VERIFY_LEDGER *ledger, KSI_DataHash **lastLeaf, uint64_t* last_rec_time, LOGSIG_EDGES *edges) {
 	int res;
 
 	KSI_DataHash *theFirstInputHashInFile = NULL;
@@ -199,7 +243,12 @@ int logsignature_verify(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_C
 	int printHeader = 0;
 	REGEXP *tmp_regxp = NULL;
 	KSI_DataHash *prevLeaf = NULL;
-	static uint64_t lastSignatureTime = 0;
+	BLOCK_INDEX *index = NULL;
+	size_t lastBlockNo = 0;
+	VERIFY_LEDGER_ENTRY *ledgerEntries = NULL;
+	size_t nofLedgerEntries = 0;
+	int isRange = 0;
+	size_t sigOffset = 0;
 
 
 	if (set == NULL || err == NULL || ksi == NULL || logksi == NULL || verify_signature == NULL || files == NULL) {
@@ -212,12 +261,26 @@ int logsignature_verify(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_C
 	logksi->err = err;
 	memset(&processors, 0, sizeof(processors));
 	processors.verify_signature = verify_signature;
+	if (edges != NULL) memset(edges, 0, sizeof(LOGSIG_EDGES));
 
-	res = MERKLE_TREE_new(&logksi->tree);
+	res = MERKLE_TREE_new(ksi, &logksi->tree);
 	if (res != KT_OK) goto cleanup;
 
 	logksi->isContinuedOnFail = PARAM_SET_isSetByName(set, "continue-on-fail");
-	logksi->sigTime_0 = lastSignatureTime;
+	logksi->sigTime_0 = files->previousSigTime;
+
+	/* With more than one thread, log lines are read ahead and hashed in parallel. */
+	if (PARAM_SET_isSetByName(set, "threads") && files->files.inLog != NULL) {
+		unsigned int nofThreads = 1;
+
+		res = PARAM_SET_getObj(set, "threads", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, (void*)&nofThreads);
+		if (res != PST_OK) goto cleanup;
+
+		if (nofThreads > 1) {
+			res = LOGLINE_PIPELINE_new(nofThreads, 2, &logksi->logLinePipeline);
+			ERR_CATCH_MSG(err, res, "Error: Unable to create %u hashing threads.", nofThreads);
+		}
+	}
 
 	res = process_magic_number(set, mp, err, logksi, files);
 	if (res != KT_OK) goto cleanup;
@@ -233,15 +296,53 @@ int logsignature_verify(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_C
 		tmp_regxp = NULL;
 	}
 
+	/* Only the blocks covering the given lines or record times are verified. */
+	if (PARAM_SET_isSetByName(set, "lines") || PARAM_SET_isSetByName(set, "time-range")) {
+		res = skip_to_verified_blocks(set, mp, err, ksi, logksi, files, &index, &lastBlockNo);
+		if (res != KT_OK) goto cleanup;
+	} else if (logksi->task.verify.index != NULL) {
+		res = skip_to_block_range(mp, err, logksi, files, &lastBlockNo);
+		if (res != KT_OK) goto cleanup;
+
+		/* Offsets are checked against the previous range by the caller (see logsignature_verify_between_blocks). */
+		if (edges != NULL) {
+			res = SMART_FILE_getPosition(files->files.inSig, &edges->startSigOffset);
+			if (res == SMART_FILE_OK) res = get_log_position(logksi, files, &edges->startLogOffset);
+			ERR_CATCH_MSG(err, res, "Error: Unable to get the positions of the first block in log signature file and in log file.");
+		}
+		isRange = 1;
+	} else if (ledger != NULL) {
+		res = skip_blocks_verified_earlier(mp, err, ksi, logksi, files, ledger, &index, &ledgerEntries, &nofLedgerEntries, &theFirstInputHashInFile);
+		if (res != KT_OK) goto cleanup;
+
+		/* The first block is skipped, so the inter-linking is checked with the input hash stored in the ledger. */
+		if (theFirstInputHashInFile != NULL) {
+			if (firstLink != NULL) {
+				res = check_inter_linking_input_hash(set, mp, err, files, 1, firstLink, theFirstInputHashInFile);
+				if (res != KT_OK) goto cleanup;
+			}
+			isFirst = 0;
+		}
+	}
+
 
 	while (!SMART_FILE_isEof(files->files.inSig)) {
 		MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
 
+		/* Range of blocks ends where the header of the next block (or the file) starts. */
+		if (isRange) {
+			res = SMART_FILE_getPosition(files->files.inSig, &sigOffset);
+			ERR_CATCH_MSG(err, res, "Error: Unable to get the position in log signature file.");
+		}
+
 		res = LOGKSI_FTLV_smartFileRead(files->files.inSig, logksi->ftlv_raw, SOF_FTLV_BUFFER, &logksi->ftlv_len, &logksi->ftlv);
 		if (res == KSI_OK) {
 			skip_current_block_as_it_does_not_verify(logksi, mp, files, err, ksi, &skipCurrentBlock);
 			if (skipCurrentBlock) continue;
 
+			/* Stop at the block header that follows the last selected block. */
+			if (lastBlockNo > 0 && logksi->ftlv.tag == 0x901 && logksi->blockNo >= lastBlockNo) break;
+
 			switch (logksi->file.version) {
 				case LOGSIG11:
 				case LOGSIG12:
@@ -302,33 +403,15 @@ int logsignature_verify(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_C
 
 						/* Check if the last leaf from the previous block matches with the current first block. */
 						if (isFirst == 1 && firstLink != NULL) {
-							print_progressDesc(mp, MP_ID_BLOCK, 0, DEBUG_LEVEL_3, "Block no. %3zu: verifying inter-linking input hash... ", logksi->blockNo);
 							isFirst = 0;
-							if (!KSI_DataHash_equals(firstLink, prevLeaf)) {
-								char buf_imp[1024];
-								char buf_exp_imp[1024];
-								char buf_fname[4096];
-								char *prevBlockSource = "Unexpected and not initialized previous block source.";
-								const char *firstBlockSource = IO_FILES_getCurrentLogFilePrintRepresentation(files);
-
-								res = KT_VERIFICATION_FAILURE;
-
-								if (PARAM_SET_isSetByName(set, "input-hash") && files->previousLogFile[0] == '\0') {
-									char *fname = NULL;
-									PARAM_SET_getStr(set, "input-hash", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, &fname);
-
-									PST_snprintf(buf_fname, sizeof(buf_fname), "from --input-hash %s", fname);
-									prevBlockSource = buf_fname;
-								} else {
-									prevBlockSource = files->previousLogFile;
-								}
-
-								ERR_TRCKR_ADD(err, res, "Error: Block no. %zu: The last leaf from the previous block (%s) does not match with the current first block (%s). Expecting '%s', but got '%s'.", logksi->blockNo, prevBlockSource, firstBlockSource, LOGKSI_DataHash_toString(firstLink, buf_exp_imp, sizeof(buf_exp_imp)), LOGKSI_DataHash_toString(prevLeaf, buf_imp, sizeof(buf_imp)));
-
-								goto cleanup;
-							}
+							res = check_inter_linking_input_hash(set, mp, err, files, logksi->blockNo, firstLink, prevLeaf);
+							if (res != KT_OK) goto cleanup;
+						}
 
-							print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_3, res);
+						/* Input hash of the block is the last leaf of the previous block. */
+						if (ledgerEntries != NULL && logksi->blockNo > 0 && logksi->blockNo <= nofLedgerEntries) {
+							verify_ledger_set_imprint(prevLeaf, ledgerEntries[logksi->blockNo - 1].inputHash, &ledgerEntries[logksi->blockNo - 1].inputHash_len);
+							if (logksi->blockNo > 1) verify_ledger_set_imprint(prevLeaf, ledgerEntries[logksi->blockNo - 2].lastLeaf, &ledgerEntries[logksi->blockNo - 2].lastLeaf_len);
 						}
 
 						KSI_DataHash_free(prevLeaf);
@@ -423,14 +506,18 @@ int logsignature_verify(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_C
 
 
 	/* If requested, return last leaf of last block. */
-	if (lastLeaf != NULL) {
+	if (lastLeaf != NULL || ledgerEntries != NULL || edges != NULL) {
 		KSI_DataHash_free(prevLeaf);
 		prevLeaf = NULL;
 
 		res = MERKLE_TREE_getPrevLeaf(logksi->tree, &prevLeaf);
 		ERR_CATCH_MSG(err, res, "Error: Unable to get previous leaf.");
 
-		*lastLeaf = KSI_DataHash_ref(prevLeaf);
+		if (lastLeaf != NULL) *lastLeaf = KSI_DataHash_ref(prevLeaf);
+
+		if (ledgerEntries != NULL && prevLeaf != NULL && logksi->blockNo > 0 && logksi->blockNo <= nofLedgerEntries) {
+			verify_ledger_set_imprint(prevLeaf, ledgerEntries[logksi->blockNo - 1].lastLeaf, &ledgerEntries[logksi->blockNo - 1].lastLeaf_len);
+		}
 	}
 
 	if (last_rec_time != NULL) {
@@ -440,6 +527,26 @@ int logsignature_verify(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_C
 	res = finalize_log_signature(set, mp, err, logksi, files, ksi, theFirstInputHashInFile);
 	if (res != KT_OK) goto cleanup;
 
+	/* The first block may be finalized only together with the log signature. */
+	if (edges != NULL) {
+		verify_ledger_set_imprint(theFirstInputHashInFile, edges->firstInputHash, &edges->firstInputHash_len);
+		verify_ledger_set_imprint(prevLeaf, edges->lastLeaf, &edges->lastLeaf_len);
+		edges->sigTimeFirst = logksi->file.sigTimeFirst;
+		edges->sigTimeLast = logksi->block.sigTime_1;
+		edges->recTimeFirst = logksi->file.recTimeFirst;
+		edges->recTimeLast = logksi->block.recTimeMax;
+		edges->recTimeMin = logksi->file.recTimeMin;
+		edges->recTimeMax = logksi->file.recTimeMax;
+		edges->firstBlockNo = logksi->file.firstBlockNo;
+		edges->lastBlockNo = logksi->blockNo;
+
+		if (isRange) {
+			edges->endSigOffset = sigOffset;
+			res = get_log_position(logksi, files, &edges->endLogOffset);
+			ERR_CATCH_MSG(err, res, "Error: Unable to get the position in log file.");
+		}
+	}
+
 	if (logksi->task.verify.errSignTime) {
 		res = KT_VERIFICATION_FAILURE;
 		ERR_TRCKR_ADD(err, res, "Error: Log block has signing time more recent than consecutive block!");
@@ -450,6 +557,11 @@ int logsignature_verify(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_C
 
 cleanup:
 
+	/* Outcome is not recorded if verification was continued after a failure. */
+	if (ledgerEntries != NULL && logksi->quietError == KT_OK) {
+		update_verify_ledger(err, logksi, files, ledger, ledgerEntries, nofLedgerEntries, res);
+	}
+
 	if (logksi->quietError != KT_OK) {
 		int isContinued = logksi->isContinuedOnFail && (res != KT_INVALID_CMD_PARAM) && (res != KT_USER_INPUT_FAILURE);
 		res = logksi->quietError;
@@ -471,144 +583,363 @@ cleanup:
 	KSI_DataHash_free(prevLeaf);
 	REGEXP_free(tmp_regxp);
 	KSI_DataHash_free(theFirstInputHashInFile);
-	lastSignatureTime = logksi->block.sigTime_1;
+	BLOCK_INDEX_free(index);
+	free(ledgerEntries);
+	if (files != NULL) files->previousSigTime = logksi->block.sigTime_1;
 	LOGKSI_freeAndClearInternals(logksi);
 
 	return res;
 }
 
-int logsignature_extract(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, IO_FILES *files) {
+int logsignature_verify_between_files(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGSIG_EDGES *prev, LOGSIG_EDGES *current, IO_FILES *files) {
 	int res;
 	LOGKSI logksi;
-	unsigned char ftlv_raw[SOF_FTLV_BUFFER];
-	SIGNATURE_PROCESSORS processors;
-	KSI_DataHash *theFirstInputHashInFile = NULL;
-	char *range = NULL;
+	KSI_DataHash *firstLink = NULL;
+	KSI_DataHash *inputHash = NULL;
 
-	if (set == NULL || err == NULL || ksi == NULL || files == NULL) {
+	LOGKSI_initialize(&logksi);
+
+	if (set == NULL || mp == NULL || err == NULL || ksi == NULL || prev == NULL || current == NULL || files == NULL) {
 		res = KT_INVALID_ARGUMENT;
 		goto cleanup;
 	}
 
-	LOGKSI_initialize(&logksi);
-	logksi.ftlv_raw = ftlv_raw;
-	logksi.taskId = TASK_EXTRACT;
+	/* Checks are done as with the first block of the current file. */
+	logksi.taskId = TASK_VERIFY;
 	logksi.err = err;
-	memset(&processors, 0, sizeof(processors));
-	processors.extract_signature = 1;
+	logksi.isContinuedOnFail = PARAM_SET_isSetByName(set, "continue-on-fail");
+	logksi.blockNo = 1;
+
+	if (prev->lastLeaf_len > 0 && current->firstInputHash_len > 0) {
+		res = KSI_DataHash_fromImprint(ksi, prev->lastLeaf, prev->lastLeaf_len, &firstLink);
+		ERR_CATCH_MSG(err, res, "Error: Unable to create hash from the last leaf of the previous log signature.");
+
+		res = KSI_DataHash_fromImprint(ksi, current->firstInputHash, current->firstInputHash_len, &inputHash);
+		ERR_CATCH_MSG(err, res, "Error: Unable to create hash from the input hash of the log signature.");
+
+		res = check_inter_linking_input_hash(set, mp, err, files, 1, firstLink, inputHash);
+		if (res != KT_OK) goto cleanup;
+	}
+
+	logksi.file.recTimeMax = prev->recTimeLast;
+	logksi.block.recTimeMin = current->recTimeFirst;
 
-	res = MERKLE_TREE_new(&logksi.tree);
+	res = check_record_time_check_between_files(set, mp, err, &logksi, files);
 	if (res != KT_OK) goto cleanup;
 
-	res = MERKLE_TREE_setCallbacks(logksi.tree, &logksi, logksi_extract_record_chain, logksi_new_record_chain, NULL);
+	logksi.sigTime_0 = prev->sigTimeLast;
+	logksi.block.sigTime_1 = current->sigTimeFirst;
+
+	res = check_block_signing_time_check(set, mp, err, &logksi, files);
 	if (res != KT_OK) goto cleanup;
 
+	if (logksi.task.verify.errSignTime) {
+		res = KT_VERIFICATION_FAILURE;
+		ERR_TRCKR_ADD(err, res, "Error: Log block has signing time more recent than consecutive block!");
+		goto cleanup;
+	}
+
+	res = KT_OK;
 
-	logksi.isContinuedOnFail = PARAM_SET_isSetByName(set, "continue-on-fail");
+cleanup:
 
-	/* Initialize the first extract position. */
-	res = PARAM_SET_getStr(set, "r", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, (char**)&range);
-	if (res != KT_OK) goto cleanup;
+	if (logksi.quietError != KT_OK) {
+		res = logksi.quietError;
+		if (logksi.isContinuedOnFail) ERR_TRCKR_ADD(err, res, "Error: Verification FAILED but was continued for further analysis.");
+		else ERR_TRCKR_ADD(err, res, "Error: Verification FAILED and was stopped.");
+	}
 
-	if (range) {
-		res = EXTRACT_INFO_new(range, &logksi.task.extract.info);
-		if (res != KT_OK) goto cleanup;
+	if (MULTI_PRINTER_hasDataByID(mp, MP_ID_BLOCK_ERRORS)) {
+		print_debug_mp(mp, MP_ID_BLOCK_ERRORS, DEBUG_SMALLER | DEBUG_LEVEL_3, "\n");
 	}
 
-	res = process_magic_number(set, mp, err, &logksi, files);
-	if (res != KT_OK) goto cleanup;
+	MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
+	MULTI_PRINTER_printByID(mp, MP_ID_BLOCK_ERRORS);
 
-	if (logksi.file.version == RECSIG11 || logksi.file.version == RECSIG12) {
-		res = KT_VERIFICATION_SKIPPED;
-		ERR_TRCKR_ADD(err, res, "Extracting from excerpt file not possible! Only log signature file can be extracted to produce excerpt file.");
+	KSI_DataHash_free(firstLink);
+	KSI_DataHash_free(inputHash);
+	LOGKSI_freeAndClearInternals(&logksi);
+
+	return res;
+}
+
+int logsignature_verify_between_blocks(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGSIG_EDGES *prev, LOGSIG_EDGES *current, IO_FILES *files) {
+	int res;
+	LOGKSI logksi;
+	KSI_DataHash *prevLeaf = NULL;
+	KSI_DataHash *inputHash = NULL;
+
+	LOGKSI_initialize(&logksi);
+
+	if (set == NULL || mp == NULL || err == NULL || ksi == NULL || prev == NULL || current == NULL || files == NULL) {
+		res = KT_INVALID_ARGUMENT;
 		goto cleanup;
 	}
 
-	while (!SMART_FILE_isEof(files->files.inSig)) {
-		MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
+	/* Checks are done as with the first block of the range. */
+	logksi.taskId = TASK_VERIFY;
+	logksi.err = err;
+	logksi.isContinuedOnFail = PARAM_SET_isSetByName(set, "continue-on-fail");
+	logksi.blockNo = current->firstBlockNo;
 
-		res = LOGKSI_FTLV_smartFileRead(files->files.inSig, logksi.ftlv_raw, SOF_FTLV_BUFFER, &logksi.ftlv_len, &logksi.ftlv);
-		if (res == KSI_OK) {
-			switch (logksi.ftlv.tag) {
-				case 0x901:
-					if (theFirstInputHashInFile == NULL) theFirstInputHashInFile = KSI_DataHash_ref(logksi.block.inputHash);
-				case 0x902:
-				case 0x903:
-				case 0x911:
-				case 0x904:
-					res = process_log_signature_with_block_signature(set, mp, err, &logksi, files, ksi, &processors, NULL);
-					if (res != KT_OK) goto cleanup;
-				break;
+	/* Offsets are taken from the block index that is not trusted, so no data may be left between the ranges. */
+	if (prev->lastBlockNo > 0 && (prev->endSigOffset != current->startSigOffset || prev->endLogOffset != current->startLogOffset)) {
+		res = KT_VERIFICATION_FAILURE;
+		ERR_CATCH_MSG(err, res, "Error: Block no. %zu: block index does not match the log signature file or the log file - block %zu ends at offset %zu (log file %zu), but block %zu starts at offset %zu (log file %zu).",
+				logksi.blockNo, prev->lastBlockNo, prev->endSigOffset, prev->endLogOffset, current->firstBlockNo, current->startSigOffset, current->startLogOffset);
+	}
 
-				default:
-					/* TODO: unknown TLV found. Either
-					 * 1) Warn user and skip TLV
-					 * 2) Copy TLV (maybe warn user)
-					 * 3) Abort extending with an error
-					 */
-				break;
-			}
+	if (prev->lastLeaf_len > 0 && current->firstInputHash_len > 0) {
+		res = KSI_DataHash_fromImprint(ksi, prev->lastLeaf, prev->lastLeaf_len, &prevLeaf);
+		ERR_CATCH_MSG(err, res, "Error: Unable to create hash from the last leaf of the previous block.");
+
+		res = KSI_DataHash_fromImprint(ksi, current->firstInputHash, current->firstInputHash_len, &inputHash);
+		ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to create hash from the input hash.", logksi.blockNo);
+
+		if (logksi.blockNo == 1) {
+			/* The first block is checked against --input-hash. */
+			res = check_inter_linking_input_hash(set, mp, err, files, logksi.blockNo, prevLeaf, inputHash);
+			if (res != KT_OK) goto cleanup;
 		} else {
-			if (logksi.ftlv_len > 0) {
-				res = KT_INVALID_INPUT_FORMAT;
-				ERR_CATCH_MSG(err, res, "Error: Block no. %zu: incomplete data found in log signature file.", logksi.blockNo);
-			} else {
-				break;
-			}
+			char description[1024];
+			PST_snprintf(description, sizeof(description), "Output hash of block %zu differs from input hash of block %zu", logksi.blockNo - 1, logksi.blockNo);
+
+			res = logksi_datahash_compare(err, mp, &logksi, 0, prevLeaf, inputHash, description, "Last hash computed from previous block data:", "Input hash stored in current block header:");
+			ERR_CATCH_MSG(err, res, "Error: %s.", description);
 		}
 	}
 
-	res = finalize_log_signature(set, mp, err, &logksi, files, ksi, theFirstInputHashInFile);
+	logksi.file.recTimeMax = prev->recTimeMax;
+	logksi.block.recTimeMin = current->recTimeMin;
+
+	res = check_record_time_check_between_blocks(set, mp, err, &logksi, current->lastBlockNo);
+	if (res != KT_OK) goto cleanup;
+
+	logksi.sigTime_0 = prev->sigTimeLast;
+	logksi.block.sigTime_1 = current->sigTimeFirst;
+
+	res = check_block_signing_time_check(set, mp, err, &logksi, files);
 	if (res != KT_OK) goto cleanup;
 
+	if (logksi.task.verify.errSignTime) {
+		res = KT_VERIFICATION_FAILURE;
+		ERR_TRCKR_ADD(err, res, "Error: Log block has signing time more recent than consecutive block!");
+		goto cleanup;
+	}
+
 	res = KT_OK;
 
 cleanup:
 
+	if (logksi.quietError != KT_OK) {
+		res = logksi.quietError;
+		ERR_TRCKR_ADD(err, res, "Error: Verification FAILED and was stopped.");
+	}
+
+	if (MULTI_PRINTER_hasDataByID(mp, MP_ID_BLOCK_ERRORS)) {
+		print_debug_mp(mp, MP_ID_BLOCK_ERRORS, DEBUG_SMALLER | DEBUG_LEVEL_3, "\n");
+	}
+
+	MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
+	MULTI_PRINTER_printByID(mp, MP_ID_BLOCK_ERRORS);
+
+	KSI_DataHash_free(prevLeaf);
+	KSI_DataHash_free(inputHash);
 	LOGKSI_freeAndClearInternals(&logksi);
-	KSI_DataHash_free(theFirstInputHashInFile);
 
 	return res;
 }
 
-int logsignature_integrate(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI* logksi, IO_FILES *files) {
-	int res;
+int logsignature_verify_scan(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, IO_FILES *files, BLOCK_INDEX **index) {
+	int res = KT_UNKNOWN_ERROR;
+	LOGKSI logksi;
 	unsigned char ftlv_raw[SOF_FTLV_BUFFER];
-	SIGNATURE_PROCESSORS processors;
-	KSI_DataHash *theFirstInputHashInFile = NULL;
+	BLOCK_INDEX *tmp = NULL;
 
+	LOGKSI_initialize(&logksi);
 
-	if (err == NULL || ksi == NULL || files == NULL) {
+	if (set == NULL || err == NULL || ksi == NULL || files == NULL || index == NULL) {
 		res = KT_INVALID_ARGUMENT;
 		goto cleanup;
 	}
 
-	logksi->ftlv_raw = ftlv_raw;
-	logksi->taskId = TASK_INTEGRATE;
-	logksi->err = err;
-	memset(&processors, 0, sizeof(processors));
+	logksi.ftlv_raw = ftlv_raw;
+	logksi.taskId = TASK_VERIFY;
+	logksi.err = err;
+
+	if (SMART_FILE_isStream(files->files.inLog) || SMART_FILE_isStream(files->files.inSig)) {
+		*index = NULL;
+		res = KT_OK;
+		goto cleanup;
+	}
 
-	res = MERKLE_TREE_new(&logksi->tree);
+	res = process_magic_number(set, mp, err, &logksi, files);
 	if (res != KT_OK) goto cleanup;
 
-	logksi->isContinuedOnFail = PARAM_SET_isSetByName(set, "continue-on-fail");
+	/* Blocks of excerpt file are not verified separately. */
+	if (logksi.file.version == LOGSIG11 || logksi.file.version == LOGSIG12) {
+		res = open_input_block_index(mp, err, ksi, &logksi, files, &tmp);
+		if (res != KT_OK) goto cleanup;
+	}
 
-	res = process_magic_number(set, mp, err, logksi, files);
-	if (res != KT_OK) goto cleanup;
+	*index = tmp;
+	tmp = NULL;
+	res = KT_OK;
 
-	while (!SMART_FILE_isEof(files->files.partsBlk)) {
-		MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
+cleanup:
 
-		res = LOGKSI_FTLV_smartFileRead(files->files.partsBlk, logksi->ftlv_raw, SOF_FTLV_BUFFER, &logksi->ftlv_len, &logksi->ftlv);
-		if (res == KSI_OK) {
-			switch (logksi->ftlv.tag) {
-				case 0x901:
-					if (theFirstInputHashInFile == NULL) theFirstInputHashInFile = KSI_DataHash_ref(logksi->block.inputHash);
-				case 0x902:
-				case 0x903:
-				case 0x911:
-					res = process_log_signature(set, mp, err, logksi, files, ksi);
-					if (res != KT_OK) goto cleanup;
+	MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
+	LOGKSI_freeAndClearInternals(&logksi);
+	BLOCK_INDEX_free(tmp);
+
+	return res;
+}
+
+int logsignature_extract(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, IO_FILES *files) {
+	int res;
+	LOGKSI logksi;
+	unsigned char ftlv_raw[SOF_FTLV_BUFFER];
+	SIGNATURE_PROCESSORS processors;
+	KSI_DataHash *theFirstInputHashInFile = NULL;
+	char *range = NULL;
+
+	if (set == NULL || err == NULL || ksi == NULL || files == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	LOGKSI_initialize(&logksi);
+	logksi.ftlv_raw = ftlv_raw;
+	logksi.taskId = TASK_EXTRACT;
+	logksi.err = err;
+	memset(&processors, 0, sizeof(processors));
+	processors.extract_signature = 1;
+
+	res = MERKLE_TREE_new(ksi, &logksi.tree);
+	if (res != KT_OK) goto cleanup;
+
+	res = MERKLE_TREE_setCallbacks(logksi.tree, &logksi, logksi_extract_record_chain, logksi_new_record_chain, NULL);
+	if (res != KT_OK) goto cleanup;
+
+
+	logksi.isContinuedOnFail = PARAM_SET_isSetByName(set, "continue-on-fail");
+
+	/* Initialize the first extract position. */
+	res = PARAM_SET_getStr(set, "r", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, (char**)&range);
+	if (res != KT_OK) goto cleanup;
+
+	if (range) {
+		res = EXTRACT_INFO_new(range, &logksi.task.extract.info);
+		if (res != KT_OK) goto cleanup;
+	}
+
+	res = process_magic_number(set, mp, err, &logksi, files);
+	if (res != KT_OK) goto cleanup;
+
+	if (logksi.file.version == RECSIG11 || logksi.file.version == RECSIG12) {
+		res = KT_VERIFICATION_SKIPPED;
+		ERR_TRCKR_ADD(err, res, "Extracting from excerpt file not possible! Only log signature file can be extracted to produce excerpt file.");
+		goto cleanup;
+	}
+
+	if (logksi.task.extract.info != NULL) {
+		res = open_input_block_index(mp, err, ksi, &logksi, files, &logksi.task.extract.index);
+		if (res != KT_OK) goto cleanup;
+	}
+
+	if (logksi.task.extract.index != NULL) {
+		res = extract_indexed_blocks(set, mp, err, ksi, &logksi, files, &processors);
+		if (res != KT_OK) goto cleanup;
+	} else {
+		while (!SMART_FILE_isEof(files->files.inSig)) {
+			MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
+
+			res = LOGKSI_FTLV_smartFileRead(files->files.inSig, logksi.ftlv_raw, SOF_FTLV_BUFFER, &logksi.ftlv_len, &logksi.ftlv);
+			if (res == KSI_OK) {
+				switch (logksi.ftlv.tag) {
+					case 0x901:
+						if (theFirstInputHashInFile == NULL) theFirstInputHashInFile = KSI_DataHash_ref(logksi.block.inputHash);
+					case 0x902:
+					case 0x903:
+					case 0x911:
+					case 0x904:
+						res = process_log_signature_with_block_signature(set, mp, err, &logksi, files, ksi, &processors, NULL);
+						if (res != KT_OK) goto cleanup;
+					break;
+
+					default:
+						/* TODO: unknown TLV found. Either
+						 * 1) Warn user and skip TLV
+						 * 2) Copy TLV (maybe warn user)
+						 * 3) Abort extending with an error
+						 */
+					break;
+				}
+			} else {
+				if (logksi.ftlv_len > 0) {
+					res = KT_INVALID_INPUT_FORMAT;
+					ERR_CATCH_MSG(err, res, "Error: Block no. %zu: incomplete data found in log signature file.", logksi.blockNo);
+				} else {
+					break;
+				}
+			}
+		}
+	}
+
+	res = finalize_log_signature(set, mp, err, &logksi, files, ksi, theFirstInputHashInFile);
+	if (res != KT_OK) goto cleanup;
+
+	res = KT_OK;
+
+cleanup:
+
+	LOGKSI_freeAndClearInternals(&logksi);
+	KSI_DataHash_free(theFirstInputHashInFile);
+
+	return res;
+}
+
+int logsignature_integrate(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI* logksi, IO_FILES *files) {
+	int res;
+	unsigned char ftlv_raw[SOF_FTLV_BUFFER];
+	SIGNATURE_PROCESSORS processors;
+	KSI_DataHash *theFirstInputHashInFile = NULL;
+
+
+	if (err == NULL || ksi == NULL || files == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	logksi->ftlv_raw = ftlv_raw;
+	logksi->taskId = TASK_INTEGRATE;
+	logksi->err = err;
+	memset(&processors, 0, sizeof(processors));
+
+	res = MERKLE_TREE_new(ksi, &logksi->tree);
+	if (res != KT_OK) goto cleanup;
+
+	logksi->isContinuedOnFail = PARAM_SET_isSetByName(set, "continue-on-fail");
+
+	res = process_magic_number(set, mp, err, logksi, files);
+	if (res != KT_OK) goto cleanup;
+
+	res = open_block_index(set, err, logksi, files);
+	if (res != KT_OK) goto cleanup;
+
+	while (!SMART_FILE_isEof(files->files.partsBlk)) {
+		MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
+
+		res = LOGKSI_FTLV_smartFileRead(files->files.partsBlk, logksi->ftlv_raw, SOF_FTLV_BUFFER, &logksi->ftlv_len, &logksi->ftlv);
+		if (res == KSI_OK) {
+			switch (logksi->ftlv.tag) {
+				case 0x901:
+					if (theFirstInputHashInFile == NULL) theFirstInputHashInFile = KSI_DataHash_ref(logksi->block.inputHash);
+				case 0x902:
+				case 0x903:
+				case 0x911:
+					res = process_log_signature(set, mp, err, logksi, files, ksi);
+					if (res != KT_OK) goto cleanup;
 				break;
 				case 0x904:
 				{
@@ -663,6 +994,9 @@ int logsignature_integrate(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KS
 	res = finalize_log_signature(set, mp, err, logksi, files, ksi, theFirstInputHashInFile);
 	if (res != KT_OK) goto cleanup;
 
+	res = save_block_index(err, logksi, files);
+	if (res != KT_OK) goto cleanup;
+
 	res = KT_OK;
 
 cleanup:
@@ -681,6 +1015,8 @@ int logsignature_sign(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX
 	SIGNATURE_PROCESSORS processors;
 	KSI_DataHash *theFirstInputHashInFile = NULL;
 	int lastError = KT_OK;
+	unsigned int maxRequests = 1;
+	unsigned int batchSize = 1;
 
 	if (set == NULL || err == NULL || ksi == NULL || files == NULL) {
 		res = KT_INVALID_ARGUMENT;
@@ -694,7 +1030,7 @@ int logsignature_sign(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX
 	memset(&processors, 0, sizeof(processors));
 	processors.create_signature = wrapper_LOGKSI_createSignature;
 
-	res = MERKLE_TREE_new(&logksi.tree);
+	res = MERKLE_TREE_new(ksi, &logksi.tree);
 	if (res != KT_OK) goto cleanup;
 
 	logksi.isContinuedOnFail = PARAM_SET_isSetByName(set, "continue-on-fail");
@@ -708,6 +1044,9 @@ int logsignature_sign(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX
 		goto cleanup;
 	}
 
+	res = open_block_index(set, err, &logksi, files);
+	if (res != KT_OK) goto cleanup;
+
 	if (SMART_FILE_isStream(files->files.inSig)) {
 		progress = (PARAM_SET_isSetByName(set, "d")&& PARAM_SET_isSetByName(set, "show-progress"));
 	} else {
@@ -724,6 +1063,28 @@ int logsignature_sign(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX
 			logksi.task.sign.noSigCount);
 	}
 
+	/* Sign all unsigned blocks with concurrent requests and/or in local batches before the log signature is rewritten. */
+	if (PARAM_SET_isSetByName(set, "max-requests") || PARAM_SET_isSetByName(set, "batch-size")) {
+		if (PARAM_SET_isSetByName(set, "max-requests")) {
+			res = PARAM_SET_getObj(set, "max-requests", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, (void*)&maxRequests);
+			if (res != PST_OK) goto cleanup;
+		}
+
+		if (PARAM_SET_isSetByName(set, "batch-size")) {
+			res = PARAM_SET_getObj(set, "batch-size", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, (void*)&batchSize);
+			if (res != PST_OK) goto cleanup;
+		}
+
+		if (SMART_FILE_isStream(files->files.inSig)) {
+			print_debug_mp(mp, MP_ID_BLOCK, DEBUG_LEVEL_2, "Warning: Unable to collect unsigned blocks in advance from stdin. Blocks are signed one by one.\n");
+		} else {
+			res = presign_unsigned_blocks(set, mp, err, ksi, &logksi, files->files.inSig, maxRequests, batchSize);
+			if (res != KT_OK) goto cleanup;
+
+			processors.create_signature = presigned_LOGKSI_createSignature;
+		}
+	}
+
 	while (!SMART_FILE_isEof(files->files.inSig)) {
 		MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
 
@@ -772,6 +1133,9 @@ int logsignature_sign(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX
 	res = finalize_log_signature(set, mp, err, &logksi, files, ksi, theFirstInputHashInFile);
 	if (res != KT_OK) goto cleanup;
 
+	res = save_block_index(err, &logksi, files);
+	if (res != KT_OK) goto cleanup;
+
 	res = SMART_FILE_markConsistent(files->files.outSig);
 	ERR_CATCH_MSG(err, res, "Error: Could not close output log signature file %s.", files->internal.outSig);
 
@@ -804,28 +1168,15 @@ cleanup:
 	return res;
 }
 
-static int finalize_new_log_sig(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err,
+static int write_new_log_sig(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err,
 								KSI_CTX *ksi, IO_FILES *files, LOGKSI *logksi,
-								KSI_DataHash *theFirstInputHashInFile, int isBlock) {
+								KSI_DataHash *theFirstInputHashInFile, int isBlock, KSI_Signature *sig) {
 	int res = KT_UNKNOWN_ERROR;
-	KSI_Signature *sig = NULL;
-	KSI_DataHash *root = NULL;
-	KSI_DataHash *prevLeaf = NULL;
+	KSI_Integer *tmpInt = NULL;
 	char buf[1024];
 
-	res = MERKLE_TREE_calculateRootHash(logksi->tree, &root);
-	ERR_CATCH_MSG(err, res, "Error: Could not calculate root hash of the tree.");
-
-	if (MULTI_PRINTER_hasDataByID(mp, MP_ID_BLOCK_PARSING_TREE_NODES)) {
-		print_debug_mp(mp, MP_ID_BLOCK_PARSING_TREE_NODES, DEBUG_LEVEL_3, "}\n");
-		MULTI_PRINTER_printByID(mp, MP_ID_BLOCK_PARSING_TREE_NODES);
-	}
-	//	printf(">>> Make KSI %zu\n", logksi->blockNo);
-	res = wrapper_LOGKSI_createSignature(set, mp, err, ksi, logksi, files, root, LOGKSI_get_aggregation_level(logksi), &sig);
-	ERR_CATCH_MSG(err, res, "Error: Could not sign tree root.");
 	logksi->sigNo++;
 
-	KSI_Integer *tmpInt = NULL;
 	KSI_Signature_getSigningTime(sig, &tmpInt);
 	logksi->block.sigTime_1 = KSI_Integer_getUInt64(tmpInt);
 
@@ -844,6 +1195,48 @@ static int finalize_new_log_sig(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *er
 		ERR_CATCH_MSG(err, res, "Error: Unable to finalize file.");
 	}
 
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
+
+static int calculate_new_log_sig_root(MULTI_PRINTER* mp, ERR_TRCKR *err, LOGKSI *logksi, KSI_DataHash **root) {
+	int res = KT_UNKNOWN_ERROR;
+
+	res = MERKLE_TREE_calculateRootHash(logksi->tree, root);
+	ERR_CATCH_MSG(err, res, "Error: Could not calculate root hash of the tree.");
+
+	if (MULTI_PRINTER_hasDataByID(mp, MP_ID_BLOCK_PARSING_TREE_NODES)) {
+		print_debug_mp(mp, MP_ID_BLOCK_PARSING_TREE_NODES, DEBUG_LEVEL_3, "}\n");
+		MULTI_PRINTER_printByID(mp, MP_ID_BLOCK_PARSING_TREE_NODES);
+	}
+
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
+
+static int finalize_new_log_sig(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err,
+								KSI_CTX *ksi, IO_FILES *files, LOGKSI *logksi,
+								KSI_DataHash *theFirstInputHashInFile, int isBlock) {
+	int res = KT_UNKNOWN_ERROR;
+	KSI_Signature *sig = NULL;
+	KSI_DataHash *root = NULL;
+	KSI_DataHash *prevLeaf = NULL;
+
+	res = calculate_new_log_sig_root(mp, err, logksi, &root);
+	if (res != KT_OK) goto cleanup;
+
+	res = wrapper_LOGKSI_createSignature(set, mp, err, ksi, logksi, files, root, LOGKSI_get_aggregation_level(logksi), &sig);
+	ERR_CATCH_MSG(err, res, "Error: Could not sign tree root.");
+
+	res = write_new_log_sig(set, mp, err, ksi, files, logksi, theFirstInputHashInFile, isBlock, sig);
+	if (res != KT_OK) goto cleanup;
+
 	res = MERKLE_TREE_getPrevLeaf(logksi->tree, &prevLeaf);
 	ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to get previous leaf.", logksi->blockNo);
 
@@ -876,6 +1269,7 @@ struct helper_st {
 	IO_FILES *io;
 	ERR_TRCKR *err;
 	MULTI_PRINTER *mp;
+	SMART_FILE *out;	/* Output for the block content. Is the log signature file or a buffer of a block waiting for its signature. */
 	int keepRecordHashes;
 	int keepTreeHashses;
 };
@@ -889,7 +1283,7 @@ static int logksi_store_hashes(MERKLE_TREE *tree, void *ctx, int tag, int isMeta
 	if (tag == 0x902 && !helper->keepRecordHashes) return KT_OK;
 	else if (tag == 0x903 && !helper->keepTreeHashses) return KT_OK;
 
-	res = tlv_element_write_hash(recordHash, tag, helper->io->files.outSig);
+	res = tlv_element_write_hash(recordHash, tag, helper->out);
 	ERR_CATCH_MSG(helper->err, res, "Error: Could not write record hash to log signature file.");
 	print_debug_mp(helper->mp, MP_ID_BLOCK_PARSING_TREE_NODES, DEBUG_LEVEL_3, tag == 0x902 ? nodeType : ".");
 	res = KT_OK;
@@ -940,7 +1334,7 @@ cleanup:
 	return res;
 }
 
-static int add_metadata(LOGKSI *logksi, ERR_TRCKR *err, KSI_CTX *ksi, IO_FILES *files, const char *key, const char *value) {
+static int add_metadata(LOGKSI *logksi, ERR_TRCKR *err, KSI_CTX *ksi, SMART_FILE *out, const char *key, const char *value) {
 	int res = KT_UNKNOWN_ERROR;
 	MetaDataRecord *metaData = NULL;
 	KSI_DataHash *hash = NULL;
@@ -956,7 +1350,7 @@ static int add_metadata(LOGKSI *logksi, ERR_TRCKR *err, KSI_CTX *ksi, IO_FILES *
 	res = metarecord_hash(logksi, ksi, buf, buf_len, &hash);
 	if (res != KSI_OK) goto cleanup;
 
-	res = SMART_FILE_write(files->files.outSig, buf, buf_len, NULL);
+	res = SMART_FILE_write(out, buf, buf_len, NULL);
 	ERR_CATCH_MSG(err, res, "Error: Could not write metadata log signature file.");
 
 	res = MERKLE_TREE_addRecordHash(logksi->tree, 1, hash);
@@ -1033,184 +1427,1928 @@ cleanup:
 	return res;
 }
 
-int logsignature_create(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *blocks, IO_FILES *files, KSI_HashAlgorithm aggrAlgo, STATE_FILE *state) {
-	int res = KT_UNKNOWN_ERROR;
-	KSI_DataHash *theFirstInputHashInFile = NULL;
-	KSI_DataHash *recordHash = NULL;
-	KSI_OctetString *seed = NULL;
-	int seed_len = 0;
-	int user_max_lvl = 0;
-	unsigned int user_block_size = 0;
-	size_t maxInputs = 0;
-	char buf[1024];
-	int lastError = KT_OK;
-	/* Maximum line size is 64K characters, without newline character. */
-	struct helper_st helper;
+/* A block that is closed and waits for its signature from the signing queue. */
+typedef struct PENDING_BLOCK_st {
+	BLOCK_INFO block;
+	size_t blockNo;
+	size_t nofTotalRecordHashes;
+	MERKLE_TREE *tree;
+	SMART_FILE *body;
+} PENDING_BLOCK;
 
-	if (set == NULL || err == NULL || ksi == NULL || blocks == NULL || files == NULL) {
-		res = KT_INVALID_ARGUMENT;
-		goto cleanup;
-	}
+static void pending_block_free(void *obj) {
+	PENDING_BLOCK *pending = obj;
 
-	blocks->file.version = LOGSIG12;
-	blocks->taskId = TASK_CREATE;
+	if (pending == NULL) return;
 
-	helper.err = err;
-	helper.io = files;
-	helper.mp = mp;
-	helper.keepRecordHashes = PARAM_SET_isSetByName(set, "keep-record-hashes");
-	helper.keepTreeHashses = PARAM_SET_isSetByName(set, "keep-tree-hashes");
+	KSI_DataHash_free(pending->block.inputHash);
+	MERKLE_TREE_free(pending->tree);
+	SMART_FILE_close(pending->body);
+	free(pending);
+}
 
-	if (PARAM_SET_isSetByName(set, "seed-len")) {
-		res = PARAM_SET_getObjExtended(set, "seed-len", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, NULL, (void**)&seed_len);
-		ERR_CATCH_MSG(err, res, "Unable to extract random seed!");
-	} else {
-		seed_len = KSI_getHashLength(aggrAlgo);
-		if (seed_len == 0) {
-			res = KT_UNKNOWN_HASH_ALG;
-			ERR_CATCH_MSG(err, res, "Unable to get the size of hash algorithm %i!", (int)aggrAlgo);
+static void pending_block_swap(PENDING_BLOCK *pending, LOGKSI *logksi) {
+	BLOCK_INFO block = logksi->block;
+	size_t blockNo = logksi->blockNo;
+	size_t nofTotalRecordHashes = logksi->file.nofTotalRecordHashes;
+	MERKLE_TREE *tree = logksi->tree;
+
+	logksi->block = pending->block;
+	logksi->blockNo = pending->blockNo;
+	logksi->file.nofTotalRecordHashes = pending->nofTotalRecordHashes;
+	logksi->tree = pending->tree;
+
+	pending->block = block;
+	pending->blockNo = blockNo;
+	pending->nofTotalRecordHashes = nofTotalRecordHashes;
+	pending->tree = tree;
+}
+
+static int copy_block_body(ERR_TRCKR *err, SMART_FILE *body, IO_FILES *files) {
+	int res = KT_UNKNOWN_ERROR;
+	unsigned char buf[0x4000];
+	size_t count = 0;
+
+	res = SMART_FILE_rewind(body);
+	ERR_CATCH_MSG(err, res, "Error: Unable to rewind block buffer.");
+
+	do {
+		res = SMART_FILE_read(body, buf, sizeof(buf), &count);
+		ERR_CATCH_MSG(err, res, "Error: Unable to read block buffer.");
+
+		if (count > 0) {
+			res = SMART_FILE_write(files->files.outSig, buf, count, NULL);
+			ERR_CATCH_MSG(err, res, "Error: Could not write block to log signature file.");
 		}
-	}
+	} while (count > 0);
 
+	res = KT_OK;
 
-	blocks->block.inputHash = KSI_DataHash_ref(STATE_FILE_lastLeaf(state));
-	theFirstInputHashInFile = KSI_DataHash_ref(STATE_FILE_lastLeaf(state));
+cleanup:
+
+	return res;
+}
+
+/**
+ * Closes the current block and adds its root hash to the signing batch. The tree and
+ * the buffered content of the block are moved to the pending block and are replaced
+ * with new ones, so that the next block can be built while waiting for the signature.
+ */
+static int queue_new_log_sig_block(MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *logksi, struct helper_st *helper,
+								   KSI_HashAlgorithm aggrAlgo, SIGN_BATCH *batch) {
+	int res = KT_UNKNOWN_ERROR;
+	PENDING_BLOCK *pending = NULL;
+	KSI_DataHash *root = NULL;
+	KSI_DataHash *prevLeaf = NULL;
+	MERKLE_TREE *tree = NULL;
 
-	res = MERKLE_TREE_new(&blocks->tree);
+	res = calculate_new_log_sig_root(mp, err, logksi, &root);
 	if (res != KT_OK) goto cleanup;
 
-	res = MERKLE_TREE_setCallbacks(blocks->tree, &helper,
+	res = MERKLE_TREE_getPrevLeaf(logksi->tree, &prevLeaf);
+	ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to get previous leaf.", logksi->blockNo);
+
+	res = MERKLE_TREE_new(ksi, &tree);
+	if (res != KT_OK) goto cleanup;
+
+	res = MERKLE_TREE_setCallbacks(tree, helper,
 		NULL,
 		logksi_store_record_hashes, logksi_store_tree_hashes);
 	if (res != KT_OK) goto cleanup;
 
-	res = MERKLE_TREE_reset(blocks->tree, aggrAlgo, NULL, NULL);
+	res = MERKLE_TREE_reset(tree, aggrAlgo, NULL, NULL);
 	ERR_CATCH_MSG(err, res, "Error: Could not reset merkle tree object.");
 
+	pending = (PENDING_BLOCK*)malloc(sizeof(PENDING_BLOCK));
+	if (pending == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		ERR_CATCH_MSG(err, res, "Error: Could not create pending block.");
+	}
+
+	pending->block = logksi->block;
+	pending->block.rootHash = NULL;
+	pending->block.metarecordHash = NULL;
+	pending->blockNo = logksi->blockNo;
+	pending->nofTotalRecordHashes = logksi->file.nofTotalRecordHashes;
+	pending->tree = logksi->tree;
+	pending->body = helper->out;
 
-	if (PARAM_SET_isSetByName(set, "max-lvl")) {
-		res = PARAM_SET_getObj(set, "max-lvl", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, (void*)&user_max_lvl);
-		if (res != PST_OK) goto cleanup;
+	logksi->block.inputHash = prevLeaf;
+	logksi->tree = tree;
+	helper->out = helper->io->files.outSig;
+	prevLeaf = NULL;
+	tree = NULL;
 
-		maxInputs = ((size_t)1 << (user_max_lvl - 1));
+	res = SIGN_BATCH_add(batch, root, LOGKSI_get_aggregation_level(logksi), pending, pending_block_free);
+	if (res != KT_OK) {
+		pending_block_free(pending);
+		pending = NULL;
+		ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to add root hash to signing batch.", logksi->blockNo);
+	}
+
+	res = KT_OK;
+
+cleanup:
+
+	KSI_DataHash_free(root);
+	KSI_DataHash_free(prevLeaf);
+	MERKLE_TREE_free(tree);
+
+	return res;
+}
+
+/**
+ * Writes all blocks of the batch together with their signatures into the log signature
+ * file. The signature of every block is created from the signature of the batch root.
+ * If it is not available (e.g. the asynchronous request has failed), signing is retried
+ * with a blocking request to report the error in the usual way.
+ */
+static int write_log_sig_batch(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err,
+							   KSI_CTX *ksi, IO_FILES *files, LOGKSI *logksi,
+							   SIGN_BATCH *batch, KSI_Signature *batchSig) {
+	int res = KT_UNKNOWN_ERROR;
+	PENDING_BLOCK *pending = NULL;
+	KSI_Signature *sig = NULL;
+	KSI_DataHash *root = NULL;
+	size_t i;
+
+	for (i = 0; i < SIGN_BATCH_getCount(batch); i++) {
+		pending = SIGN_BATCH_getCtx(batch, i);
+		pending_block_swap(pending, logksi);
+
+		res = LOGKSI_setBlockSigOffset(logksi, files->files.outSig, 0);
+		if (res != KT_OK) goto cleanup;
+
+		res = copy_block_body(err, pending->body, files);
+		if (res != KT_OK) goto cleanup;
+
+		if (batchSig == NULL || SIGN_BATCH_createSignature(batch, ksi, batchSig, i, &sig) != KT_OK) {
+			res = MERKLE_TREE_calculateRootHash(logksi->tree, &root);
+			ERR_CATCH_MSG(err, res, "Error: Could not calculate root hash of the tree.");
+
+			res = wrapper_LOGKSI_createSignature(set, mp, err, ksi, logksi, files, root, LOGKSI_get_aggregation_level(logksi), &sig);
+			ERR_CATCH_MSG(err, res, "Error: Could not sign tree root.");
+		} else {
+			print_progressDesc(mp, MP_ID_BLOCK, 1, DEBUG_EQUAL | DEBUG_LEVEL_2, "Signing Block no. %3zu... ", logksi->blockNo);
+			print_progressResult(mp, MP_ID_BLOCK, DEBUG_EQUAL | DEBUG_LEVEL_2, KT_OK);
+		}
+
+		res = write_new_log_sig(set, mp, err, ksi, files, logksi, NULL, 1, sig);
+		if (res != KT_OK) goto cleanup;
+
+		pending_block_swap(pending, logksi);
+		pending = NULL;
+
+		KSI_Signature_free(sig);
+		sig = NULL;
+		KSI_DataHash_free(root);
+		root = NULL;
+	}
+
+	res = KT_OK;
+
+cleanup:
+
+	if (pending != NULL) pending_block_swap(pending, logksi);
+	KSI_Signature_free(sig);
+	KSI_DataHash_free(root);
+
+	return res;
+}
+
+/**
+ * Takes the oldest batch of blocks from the signing queue and writes the blocks
+ * into the log signature file. If \c wait is not set and the oldest batch is not
+ * signed yet, \c written is 0.
+ */
+static int write_pending_log_sig_block(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err,
+									   KSI_CTX *ksi, IO_FILES *files, LOGKSI *logksi,
+									   SIGN_QUEUE *queue, int wait, int *written) {
+	int res = KT_UNKNOWN_ERROR;
+	SIGN_BATCH *batch = NULL;
+	KSI_Signature *sig = NULL;
+	int error = KT_OK;
+
+	*written = 0;
+
+	res = SIGN_QUEUE_getNext(queue, wait, (void**)&batch, &sig, &error);
+	ERR_CATCH_MSG(err, res, "Error: Unable to get response from signing queue.");
+	if (batch == NULL) goto cleanup;
+
+	res = write_log_sig_batch(set, mp, err, ksi, files, logksi, batch, sig);
+	if (res != KT_OK) goto cleanup;
+
+	*written = 1;
+	res = KT_OK;
+
+cleanup:
+
+	SIGN_BATCH_free(batch);
+	KSI_Signature_free(sig);
+
+	return res;
+}
+
+/**
+ * Aggregates the root hashes of the blocks in the batch locally and adds the root of
+ * the batch to the signing queue. The ownership of the batch is passed to the queue.
+ * If the root of the batch can not be calculated, all pending blocks are written and
+ * the blocks of the batch are signed one by one.
+ */
+static int queue_log_sig_batch(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err,
+							   KSI_CTX *ksi, IO_FILES *files, LOGKSI *logksi,
+							   SIGN_QUEUE *queue, SIGN_BATCH *batch, KSI_HashAlgorithm aggrAlgo) {
+	int res = KT_UNKNOWN_ERROR;
+	KSI_DataHash *root = NULL;
+	KSI_uint64_t rootLevel = 0;
+	int written = 0;
+
+	if (SIGN_QUEUE_isFull(queue)) {
+		res = write_pending_log_sig_block(set, mp, err, ksi, files, logksi, queue, 1, &written);
+		if (res != KT_OK) goto cleanup;
+	}
+
+	res = SIGN_BATCH_calculateRoot(batch, ksi, aggrAlgo, &root, &rootLevel);
+	if (res != KT_OK) {
+		while (SIGN_QUEUE_getCount(queue) > 0) {
+			res = write_pending_log_sig_block(set, mp, err, ksi, files, logksi, queue, 1, &written);
+			if (res != KT_OK) goto cleanup;
+		}
+
+		res = write_log_sig_batch(set, mp, err, ksi, files, logksi, batch, NULL);
+		goto cleanup;
+	}
+
+	res = SIGN_QUEUE_add(queue, root, rootLevel, batch, sign_batch_free);
+	ERR_CATCH_MSG(err, res, "Error: Unable to add root hash to signing queue.");
+	batch = NULL;
+
+	res = KT_OK;
+
+cleanup:
+
+	SIGN_BATCH_free(batch);
+	KSI_DataHash_free(root);
+
+	return res;
+}
+
+/* Count of jobs read ahead, while the input hash of the first block is waited for (see LOGSIG_LINK). */
+#define LOGSIG_LINK_READ_AHEAD_JOBS 64
+
+static int link_io(int fd, int isWrite, unsigned char *buf, size_t len) {
+	size_t count = 0;
+
+	while (count < len) {
+		ssize_t ret = isWrite ? write(fd, buf + count, len - count) : read(fd, buf + count, len - count);
+
+		if (ret < 0 && errno == EINTR) continue;
+		if (ret < 0) return KT_IO_ERROR;
+		if (ret == 0) return KT_UNEXPECTED_EOF;
+		count += (size_t)ret;
+	}
+
+	return KT_OK;
+}
+
+/* Hash is passed as the length of the imprint (single byte) followed by the imprint. */
+static int link_read_hash(int fd, KSI_CTX *ksi, KSI_DataHash **hash) {
+	int res = KT_UNKNOWN_ERROR;
+	unsigned char buf[KSI_MAX_IMPRINT_LEN + 1];
+
+	res = link_io(fd, 0, buf, 1);
+	if (res != KT_OK) return res;
+
+	if (buf[0] == 0 || buf[0] > KSI_MAX_IMPRINT_LEN) return KT_INVALID_INPUT_FORMAT;
+
+	res = link_io(fd, 0, buf + 1, buf[0]);
+	if (res != KT_OK) return res;
+
+	return KSI_DataHash_fromImprint(ksi, buf + 1, buf[0], hash);
+}
+
+static int link_write_hash(int fd, KSI_DataHash *hash) {
+	int res = KT_UNKNOWN_ERROR;
+	const unsigned char *imprint = NULL;
+	size_t imprint_len = 0;
+	unsigned char buf[KSI_MAX_IMPRINT_LEN + 1];
+
+	res = KSI_DataHash_getImprint(hash, &imprint, &imprint_len);
+	if (res != KSI_OK) return res;
+
+	if (imprint_len == 0 || imprint_len > KSI_MAX_IMPRINT_LEN) return KT_INVALID_ARGUMENT;
+
+	buf[0] = (unsigned char)imprint_len;
+	memcpy(buf + 1, imprint, imprint_len);
+
+	return link_io(fd, 1, buf, imprint_len + 1);
+}
+
+int logsignature_create(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *blocks, IO_FILES *files, KSI_HashAlgorithm aggrAlgo, STATE_FILE *state, LOG_FOLLOW *follow, LOGSIG_LINK *sigLink) {
+	int res = KT_UNKNOWN_ERROR;
+	KSI_DataHash *theFirstInputHashInFile = NULL;
+	KSI_DataHash *recordHash = NULL;
+	KSI_DataHash *linkedHash = NULL;
+	KSI_OctetString *seed = NULL;
+	int seed_len = 0;
+	int user_max_lvl = 0;
+	unsigned int user_block_size = 0;
+	size_t maxInputs = 0;
+	char buf[1024];
+	int lastError = KT_OK;
+	unsigned int maxPending = 1;
+	unsigned int batchSize = 1;
+	SIGN_QUEUE *queue = NULL;
+	SIGN_BATCH *batch = NULL;
+	SMART_FILE *blockBody = NULL;
+	int written = 0;
+	unsigned int nofThreads = 1;
+	unsigned int blockTime = 0;
+	time_t blockDeadline = 0;
+	int isBlockExpired = 0;
+	int isLinked = 0;
+	/* Maximum line size is 64K characters, without newline character. */
+	struct helper_st helper;
+
+	if (set == NULL || err == NULL || ksi == NULL || blocks == NULL || files == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	isLinked = (sigLink != NULL && sigLink->in >= 0);
+	blocks->file.version = LOGSIG12;
+	blocks->taskId = TASK_CREATE;
+
+	helper.err = err;
+	helper.io = files;
+	helper.mp = mp;
+	helper.out = files->files.outSig;
+	helper.keepRecordHashes = PARAM_SET_isSetByName(set, "keep-record-hashes");
+	helper.keepTreeHashses = PARAM_SET_isSetByName(set, "keep-tree-hashes");
+
+	if (PARAM_SET_isSetByName(set, "seed-len")) {
+		res = PARAM_SET_getObjExtended(set, "seed-len", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, NULL, (void**)&seed_len);
+		ERR_CATCH_MSG(err, res, "Unable to extract random seed!");
+	} else {
+		seed_len = KSI_getHashLength(aggrAlgo);
+		if (seed_len == 0) {
+			res = KT_UNKNOWN_HASH_ALG;
+			ERR_CATCH_MSG(err, res, "Unable to get the size of hash algorithm %i!", (int)aggrAlgo);
+		}
+	}
+
+
+	/* Followed log signature file grows over multiple runs, thus index is not written. */
+	if (follow == NULL) {
+		res = open_block_index(set, err, blocks, files);
+		if (res != KT_OK) goto cleanup;
+	}
+
+	res = MERKLE_TREE_new(ksi, &blocks->tree);
+	if (res != KT_OK) goto cleanup;
+
+	res = MERKLE_TREE_setCallbacks(blocks->tree, &helper,
+		NULL,
+		logksi_store_record_hashes, logksi_store_tree_hashes);
+	if (res != KT_OK) goto cleanup;
+
+	res = MERKLE_TREE_reset(blocks->tree, aggrAlgo, NULL, NULL);
+	ERR_CATCH_MSG(err, res, "Error: Could not reset merkle tree object.");
+
+
+	if (PARAM_SET_isSetByName(set, "max-lvl")) {
+		res = PARAM_SET_getObj(set, "max-lvl", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, (void*)&user_max_lvl);
+		if (res != PST_OK) goto cleanup;
+
+		maxInputs = ((size_t)1 << (user_max_lvl - 1));
 	}
 
 	if (PARAM_SET_isSetByName(set, "blk-size")) {
 		res = PARAM_SET_getObj(set, "blk-size", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, (void*)&user_block_size);
 		if (res != PST_OK) goto cleanup;
 
-		if (maxInputs != 0 && maxInputs < user_block_size) {
-			res = KT_INVALID_CMD_PARAM;
-			ERR_CATCH_MSG(err, res, "Error: It is not possible to use blk-size (%u) as tree level (%i) results tree with maximum %zu leafs.",
-				user_block_size,
-				user_max_lvl,
-				maxInputs);
-		}
+		if (maxInputs != 0 && maxInputs < user_block_size) {
+			res = KT_INVALID_CMD_PARAM;
+			ERR_CATCH_MSG(err, res, "Error: It is not possible to use blk-size (%u) as tree level (%i) results tree with maximum %zu leafs.",
+				user_block_size,
+				user_max_lvl,
+				maxInputs);
+		}
+
+		maxInputs = user_block_size;
+	}
+
+	/* Block is closed after blockTime seconds, counted from its first record, even if it is not full. */
+	if (PARAM_SET_isSetByName(set, "blk-time")) {
+		res = PARAM_SET_getObj(set, "blk-time", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, (void*)&blockTime);
+		if (res != PST_OK) goto cleanup;
+	}
+
+	/* With more than one pending request, blocks are buffered until their signatures are received. */
+	if (PARAM_SET_isSetByName(set, "max-pending")) {
+		res = PARAM_SET_getObj(set, "max-pending", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, (void*)&maxPending);
+		if (res != PST_OK) goto cleanup;
+	}
+
+	/* Root hashes of up to batchSize blocks are aggregated locally and signed with a single request. */
+	if (PARAM_SET_isSetByName(set, "batch-size")) {
+		res = PARAM_SET_getObj(set, "batch-size", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, (void*)&batchSize);
+		if (res != PST_OK) goto cleanup;
+	}
+
+	/* With more than one thread, log lines are hashed in parallel. */
+	if (PARAM_SET_isSetByName(set, "threads")) {
+		res = PARAM_SET_getObj(set, "threads", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, (void*)&nofThreads);
+		if (res != PST_OK) goto cleanup;
+	}
+
+	/* Linked log file is read ahead deeper, as the lines are hashed while the input hash is waited for. */
+	if (nofThreads > 1 || isLinked) {
+		res = LOGLINE_PIPELINE_new(nofThreads, isLinked ? LOGSIG_LINK_READ_AHEAD_JOBS : 2, &blocks->logLinePipeline);
+		ERR_CATCH_MSG(err, res, "Error: Unable to create %u hashing threads.", nofThreads);
+	}
+
+	if (maxPending > 1 || batchSize > 1) {
+		res = TOOL_newSignQueue(set, err, ksi, maxPending, &queue);
+		if (res != KT_OK) goto cleanup;
+	}
+
+	/* Signing of a followed log file is continued after the last block written into the log signature file. */
+	if (follow != NULL && STATE_FILE_getFollow(state) != NULL) {
+		res = resume_followed_log(mp, err, blocks, files, state);
+		if (res != KT_OK) goto cleanup;
+	} else {
+		res = SMART_FILE_write(files->files.outSig, (unsigned char*)LOGSIG_VERSION_toString(blocks->file.version), MAGIC_SIZE, NULL);
+		ERR_CATCH_MSG(err, res, "Error: Could not write magic number to log signature file.");
+	}
+
+	if (isLinked) {
+		res = LOGLINE_PIPELINE_start(blocks->logLinePipeline, blocks, files->files.inLog, aggrAlgo);
+		ERR_CATCH_MSG(err, res, "Error: Unable to read from file %s.", files->internal.inLog);
+
+		res = link_read_hash(sigLink->in, ksi, &linkedHash);
+		ERR_CATCH_MSG(err, res, "Error: Unable to get the last leaf of the previous log signature file.");
+
+		res = STATE_FILE_update(state, linkedHash);
+		ERR_CATCH_MSG(err, res, "Error: Unable to update state file.");
+	}
+
+	blocks->block.inputHash = KSI_DataHash_ref(STATE_FILE_lastLeaf(state));
+	theFirstInputHashInFile = KSI_DataHash_ref(STATE_FILE_lastLeaf(state));
+
+	/* Pipeline reads ahead, thus the end of log file is detected by KT_UNEXPECTED_EOF only. */
+	while (blocks->logLinePipeline != NULL || !SMART_FILE_isEof(files->files.inLog)) {
+		MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
+
+		if (blocks->block.recordCount == 0) {
+			blocks->blockNo++;
+
+			KSI_OctetString_free(seed);
+			seed = NULL;
+			res = get_random_seed(files, err, ksi, seed_len, &seed);
+			if (res != KT_OK) goto cleanup;
+
+			res = MERKLE_TREE_reset(blocks->tree, aggrAlgo,
+				KSI_DataHash_ref(STATE_FILE_lastLeaf(state)),
+				KSI_OctetString_ref(seed));
+			ERR_CATCH_MSG(err, res, "Error: Could not reset merkle tree object.");
+
+			if (queue != NULL) {
+				res = SMART_FILE_open("<block>", "wM", &blockBody);
+				ERR_CATCH_MSG(err, res, "Error: Could not create block buffer.");
+				helper.out = blockBody;
+			}
+
+			res = LOGKSI_setBlockLogOffset(blocks, files->files.inLog);
+			if (res != KT_OK) goto cleanup;
+
+			/* If the block is buffered, the offset is set when the block is copied to the log signature file. */
+			if (helper.out == files->files.outSig) {
+				res = LOGKSI_setBlockSigOffset(blocks, files->files.outSig, 0);
+				if (res != KT_OK) goto cleanup;
+			}
+
+			print_progressDesc(mp, MP_ID_BLOCK, 0, DEBUG_LEVEL_3, "Block no. %3zu: processing block header... ", blocks->blockNo);
+			res = tlv_element_write_header(ksi, aggrAlgo, seed, blocks->block.inputHash, helper.out);
+			ERR_CATCH_MSG(err, res, "Error: Could not write block header to log signature file.");
+			print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_3, res);
+			print_debug_mp(mp, MP_ID_BLOCK, DEBUG_LEVEL_3, "Block no. %3zu: input hash: %s.\n", blocks->blockNo,
+				LOGKSI_DataHash_toString(blocks->block.inputHash, buf, sizeof(buf)));
+
+			print_debug_mp(mp, MP_ID_BLOCK_PARSING_TREE_NODES, DEBUG_LEVEL_3, "Block no. %3zu: {", blocks->blockNo);
+		}
+
+		/* Block that is too old is closed before the next record is added, even if the log is busy. */
+		isBlockExpired = (blockDeadline != 0 && time(NULL) >= blockDeadline);
+
+		/* The end of a followed log file is reached only if the file is rotated or following is stopped. */
+		if (follow != NULL && !isBlockExpired) {
+			res = LOG_FOLLOW_waitForLine(follow, files->files.inLog, blockDeadline);
+			if (res == KT_UNEXPECTED_EOF) break;
+			else if (res == KT_TIMEOUT) isBlockExpired = 1;
+			else ERR_CATCH_MSG(err, res, "Error: Unable to follow log file %s.", files->internal.inLog);
+		}
+
+		if (!isBlockExpired) {
+			res = logksi_logline_calculate_hash_and_store(blocks, files, &recordHash);
+			if (res == KT_UNEXPECTED_EOF) break;
+			ERR_CATCH_MSG(err, res, "Error: Unable to read from file %s.", files->internal.outLog);
+
+
+			res = MERKLE_TREE_addRecordHash(blocks->tree, 0, recordHash);
+			ERR_CATCH_MSG(err, res, "Error: Could not add record hash to tree.");
+			KSI_DataHash_free(recordHash);
+			recordHash = NULL;
+			blocks->currentLine++;
+			blocks->block.recordCount++;
+			blocks->file.nofTotalRecordHashes++;
+
+			if (blocks->block.firstLineNo == 0) {
+				blocks->block.firstLineNo = blocks->currentLine;
+			}
+
+			if (blockTime > 0 && blocks->block.recordCount == 1) {
+				blockDeadline = time(NULL) + blockTime;
+			}
+		}
+
+		if (blocks->block.recordCount >= maxInputs || isBlockExpired) {
+			/* The reason of closing a block that is not full is recorded with a meta-record. */
+			if (blocks->block.recordCount < maxInputs) {
+				res = add_metadata(blocks, err, ksi, helper.out,
+				META_DATA_BLOCK_CLOSE_REASON,
+				"Block closed due to time limit."	);
+				ERR_CATCH_MSG(err, res, "Error: Could not add metadata.");
+				blocks->block.nofMetaRecords++;
+				blocks->file.nofTotalMetarecords++;
+			}
+
+			/* The last leaf is needed for the next block and is kept in the state only at block boundaries. */
+			res = update_state_file(state, err, blocks);
+			if (res != KT_OK) goto cleanup;
+
+			if (queue != NULL) {
+				if (batch == NULL) {
+					res = SIGN_BATCH_new(batchSize, &batch);
+					ERR_CATCH_MSG(err, res, "Error: Could not create signing batch.");
+				}
+
+				res = queue_new_log_sig_block(mp, err, ksi, blocks, &helper, aggrAlgo, batch);
+				if (helper.out != blockBody) blockBody = NULL;
+				if (res != KT_OK) goto cleanup;
+
+				if (SIGN_BATCH_isFull(batch)) {
+					res = queue_log_sig_batch(set, mp, err, ksi, files, blocks, queue, batch, aggrAlgo);
+					batch = NULL;
+					if (res != KT_OK) goto cleanup;
+				}
+
+				do {
+					res = write_pending_log_sig_block(set, mp, err, ksi, files, blocks, queue, 0, &written);
+					if (res != KT_OK) goto cleanup;
+				} while (written);
+			} else {
+				res = finalize_new_log_sig_block(set, mp, err, ksi, files, blocks);
+				if (res != KT_OK) goto cleanup;
+			}
+
+			blocks->block.recordCount = 0;
+			blocks->block.firstLineNo = blocks->file.nofTotalRecordHashes + 1;
+			blockDeadline = 0;
+
+			/* Signed block of a followed log file is made durable, so that signing can be continued after a restart. */
+			if (follow != NULL) {
+				res = set_follow_state(err, blocks, files, state, follow);
+				if (res != KT_OK) goto cleanup;
+
+				res = STATE_FILE_commit(state);
+				ERR_CATCH_MSG(err, res, "Error: Unable to update state file.");
+			}
+		}
+	}
+
+	res = add_metadata(blocks, err, ksi, helper.out,
+	META_DATA_BLOCK_CLOSE_REASON,
+	"Block closed due to file closure."	);
+	ERR_CATCH_MSG(err, res, "Error: Could not add metadata.");
+	blocks->block.nofMetaRecords++;
+	blocks->file.nofTotalMetarecords++;
+
+	/* The next log signature file can be built, while the blocks of this one are being signed. */
+	if (sigLink != NULL && sigLink->out >= 0) {
+		res = update_state_file(state, err, blocks);
+		if (res != KT_OK) goto cleanup;
+
+		res = link_write_hash(sigLink->out, STATE_FILE_lastLeaf(state));
+		ERR_CATCH_MSG(err, res, "Error: Unable to pass the last leaf to the next log signature file.");
+	}
+
+	/* Last block is signed when all the previous blocks are written. */
+	if (queue != NULL) {
+		if (batch != NULL) {
+			res = queue_log_sig_batch(set, mp, err, ksi, files, blocks, queue, batch, aggrAlgo);
+			batch = NULL;
+			if (res != KT_OK) goto cleanup;
+		}
+
+		while (SIGN_QUEUE_getCount(queue) > 0) {
+			res = write_pending_log_sig_block(set, mp, err, ksi, files, blocks, queue, 1, &written);
+			if (res != KT_OK) goto cleanup;
+		}
+
+		if (blockBody != NULL) {
+			res = LOGKSI_setBlockSigOffset(blocks, files->files.outSig, 0);
+			if (res != KT_OK) goto cleanup;
+
+			res = copy_block_body(err, blockBody, files);
+			if (res != KT_OK) goto cleanup;
+		}
+
+		helper.out = files->files.outSig;
+	}
+
+	res = finalize_new_log_sig_file(set, mp, err, ksi, files, blocks, theFirstInputHashInFile);
+	if (res != KT_OK) goto cleanup;
+
+	res = save_block_index(err, blocks, files);
+	if (res != KT_OK) goto cleanup;
+
+	res = update_state_file(state, err, blocks);
+	if (res != KT_OK) goto cleanup;
+
+	if (follow != NULL) {
+		res = set_follow_state(err, blocks, files, state, follow);
+		if (res != KT_OK) goto cleanup;
+	}
+
+	res = SMART_FILE_markConsistent(files->files.outSig);
+	ERR_CATCH_MSG(err, res, "Error: Could not close output log signature file %s.", files->internal.outSig);
+	blocks->task.sign.outSigModified = 1;
+	res = KT_OK;
+
+cleanup:
+	/**
+	 * + If there is error mark output file as inconsistent.
+	 * + Inconsistent state discards temporary file created.
+	 */
+	if (files->files.outSig != NULL && res != KT_OK) {
+		int tmp_res;
+		tmp_res = SMART_FILE_markInconsistent(files->files.outSig);
+		ERR_CATCH_MSG(err, tmp_res, "Error: Unable to mark output signature file as inconsistent.");
+	}
+
+	if (lastError != KT_OK) {
+		res = lastError;
+		ERR_TRCKR_ADD(err, res, "Error: Signing FAILED but was continued. All failed blocks are left unsigned!");
+	}
+
+	print_progressResult(mp, MP_ID_BLOCK, DEBUG_EQUAL | DEBUG_LEVEL_3, res);
+	print_progressResult(mp, MP_ID_BLOCK, DEBUG_EQUAL | DEBUG_LEVEL_2, res);
+	LOGKSI_freeAndClearInternals(blocks);
+	KSI_DataHash_free(theFirstInputHashInFile);
+	KSI_DataHash_free(linkedHash);
+	KSI_OctetString_free(seed);
+	SIGN_QUEUE_free(queue);
+	SIGN_BATCH_free(batch);
+	SMART_FILE_close(blockBody);
+
+	KSI_DataHash_free(recordHash);
+
+	return res;
+}
+
+int logsignature_index(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, IO_FILES *files, BLOCK_INDEX **index) {
+	int res = KT_UNKNOWN_ERROR;
+	LOGKSI logksi;
+	unsigned char ftlv_raw[SOF_FTLV_BUFFER];
+	BLOCK_INDEX *tmp = NULL;
+	const BLOCK_INDEX_ENTRY *last = NULL;
+
+	LOGKSI_initialize(&logksi);
+
+	if (set == NULL || err == NULL || ksi == NULL || files == NULL || files->files.inSig == NULL || index == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	logksi.ftlv_raw = ftlv_raw;
+	logksi.err = err;
+
+	res = process_magic_number(set, mp, err, &logksi, files);
+	if (res != KT_OK) goto cleanup;
+
+	if (logksi.file.version == RECSIG11 || logksi.file.version == RECSIG12) {
+		res = KT_INVALID_INPUT_FORMAT;
+		ERR_CATCH_MSG(err, res, "Error: Block index can not be created for excerpt file.");
+	}
+
+	print_progressDesc(mp, MP_ID_BLOCK, 0, DEBUG_EQUAL | DEBUG_LEVEL_1, "Indexing blocks... ");
+
+	res = scan_block_index(err, ksi, &logksi, files->files.inSig, &tmp);
+	if (res != KT_OK) goto cleanup;
+
+	print_progressResult(mp, MP_ID_BLOCK, DEBUG_EQUAL | DEBUG_LEVEL_1, KT_OK);
+
+	if (files->files.inLog != NULL) {
+		print_progressDesc(mp, MP_ID_BLOCK, 0, DEBUG_EQUAL | DEBUG_LEVEL_1, "Indexing log lines... ");
+
+		res = BLOCK_INDEX_setLogOffsets(tmp, files->files.inLog, files->internal.inLog);
+		if (res == KT_UNEXPECTED_EOF) {
+			last = BLOCK_INDEX_get(tmp, BLOCK_INDEX_getCount(tmp) - 1);
+			ERR_TRCKR_ADD(err, res, "Error: Log file %s has less lines (%llu expected).", files->internal.inLog, (unsigned long long)(last != NULL ? last->lastLine : 0));
+		}
+		ERR_CATCH_MSG(err, res, "Error: Could not find the offsets of blocks in log file.");
+
+		print_progressResult(mp, MP_ID_BLOCK, DEBUG_EQUAL | DEBUG_LEVEL_1, KT_OK);
+	}
+
+	*index = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	print_progressResult(mp, MP_ID_BLOCK, DEBUG_EQUAL | DEBUG_LEVEL_1, res);
+	MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
+	LOGKSI_freeAndClearInternals(&logksi);
+	BLOCK_INDEX_free(tmp);
+
+	return res;
+}
+
+/**
+ * Builds the block index from the block headers and block signatures of the log signature
+ * file. The file is read from the current position, that must be right after the magic
+ * number. Log file offsets are left unknown (see #BLOCK_INDEX_setLogOffsets).
+ */
+static int scan_block_index(ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *logksi, SMART_FILE *in, BLOCK_INDEX **index) {
+	int res = KT_UNKNOWN_ERROR;
+	BLOCK_INDEX *tmp = NULL;
+	BLOCK_INDEX_ENTRY entry;
+	KSI_TlvElement *tlv = NULL;
+	KSI_TlvElement *tlvSig = NULL;
+	KSI_TlvElement *tlvRfc3161 = NULL;
+	KSI_Signature *sig = NULL;
+	KSI_Integer *sigTime = NULL;
+	size_t pos = 0;
+	size_t blockNo = 0;
+	size_t recordCount = 0;
+	size_t nofMetaRecords = 0;
+	uint64_t nofLines = 0;
+	int blockOpen = 0;
+
+	if (err == NULL || ksi == NULL || logksi == NULL || in == NULL || index == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	memset(&entry, 0, sizeof(entry));
+
+	res = BLOCK_INDEX_new(&tmp);
+	ERR_CATCH_MSG(err, res, "Error: Could not create block index.");
+
+	while (!SMART_FILE_isEof(in)) {
+		res = LOGKSI_FTLV_smartFileRead(in, logksi->ftlv_raw, SOF_FTLV_BUFFER, &logksi->ftlv_len, &logksi->ftlv);
+		if (res == KSI_OK) {
+			switch (logksi->ftlv.tag) {
+				case 0x901:
+					if (blockOpen) {
+						res = KT_INVALID_INPUT_FORMAT;
+						ERR_CATCH_MSG(err, res, "Error: Block no. %zu: block signature data missing.", blockNo);
+					}
+
+					res = SMART_FILE_getPosition(in, &pos);
+					ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to get the position of block header.", blockNo + 1);
+
+					blockNo++;
+					blockOpen = 1;
+					nofMetaRecords = 0;
+
+					entry.blockNo = blockNo;
+					entry.sigOffset = pos - logksi->ftlv_len;
+					entry.logOffset = BLOCK_INDEX_UNKNOWN_OFFSET;
+					entry.firstLine = nofLines + 1;
+				break;
+
+				case 0x911:
+					nofMetaRecords++;
+				break;
+
+				case 0x904:
+					if (!blockOpen) {
+						res = KT_INVALID_INPUT_FORMAT;
+						ERR_CATCH_MSG(err, res, "Error: Block no. %zu: block signature without block header.", blockNo + 1);
+					}
+
+					res = tlv_element_parse_and_check_sub_elements(err, ksi, logksi->ftlv_raw, logksi->ftlv_len, logksi->ftlv.hdr_len, &tlv);
+					ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to parse block signature as TLV element.", blockNo);
+
+					res = tlv_element_get_uint(tlv, ksi, 0x01, &recordCount);
+					ERR_CATCH_MSG(err, res, "Error: Block no. %zu: missing record count in block signature.", blockNo);
+
+					res = KSI_TlvElement_getElement(tlv, 0x905, &tlvSig);
+					ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to extract KSI signature element in block signature.", blockNo);
+
+					res = KSI_TlvElement_getElement(tlv, 0x906, &tlvRfc3161);
+					ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to extract RFC3161 element in block signature.", blockNo);
+
+					entry.sigTime = 0;
+					entry.isSigned = tlvSig != NULL || tlvRfc3161 != NULL;
+
+					if (tlvSig != NULL) {
+						res = LOGKSI_Signature_parseWithPolicy(err, ksi, tlvSig->ptr + tlvSig->ftlv.hdr_len, tlvSig->ftlv.dat_len, KSI_VERIFICATION_POLICY_EMPTY, NULL, &sig);
+						ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to parse KSI signature.", blockNo);
+
+						res = KSI_Signature_getSigningTime(sig, &sigTime);
+						ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to get signing time of KSI signature.", blockNo);
+
+						entry.sigTime = KSI_Integer_getUInt64(sigTime);
+					}
+
+					if (recordCount < nofMetaRecords) {
+						res = KT_INVALID_INPUT_FORMAT;
+						ERR_CATCH_MSG(err, res, "Error: Block no. %zu: record count %zu is smaller than the count of meta-records %zu.", blockNo, recordCount, nofMetaRecords);
+					}
+
+					nofLines += recordCount - nofMetaRecords;
+					entry.lastLine = nofLines;
+					entry.recordCount = recordCount;
+
+					res = BLOCK_INDEX_add(tmp, &entry);
+					ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to add block to the block index.", blockNo);
+
+					blockOpen = 0;
+
+					KSI_Signature_free(sig);
+					sig = NULL;
+					KSI_TlvElement_free(tlvRfc3161);
+					tlvRfc3161 = NULL;
+					KSI_TlvElement_free(tlvSig);
+					tlvSig = NULL;
+					KSI_TlvElement_free(tlv);
+					tlv = NULL;
+				break;
+
+				default:
+				/* Ignore hashes and other TLVs as we are just indexing blocks. */
+				break;
+			}
+		} else {
+			if (logksi->ftlv_len > 0) {
+				res = KT_INVALID_INPUT_FORMAT;
+				ERR_CATCH_MSG(err, res, "Error: Block no. %zu: incomplete data found in log signature file.", blockNo);
+			} else {
+				break;
+			}
+		}
+	}
+
+	if (blockOpen) {
+		res = KT_INVALID_INPUT_FORMAT;
+		ERR_CATCH_MSG(err, res, "Error: Block no. %zu: block signature data missing.", blockNo);
+	}
+
+	*index = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	KSI_Signature_free(sig);
+	KSI_TlvElement_free(tlvRfc3161);
+	KSI_TlvElement_free(tlvSig);
+	KSI_TlvElement_free(tlv);
+	BLOCK_INDEX_free(tmp);
+
+	return res;
+}
+
+/**
+ * Creates the block index if it is requested with --write-index or if the index file
+ * of the output log signature file already exists (so that it is kept up to date).
+ */
+static int open_block_index(PARAM_SET *set, ERR_TRCKR *err, LOGKSI *logksi, IO_FILES *files) {
+	int res = KT_UNKNOWN_ERROR;
+	char *indexFname = NULL;
+
+	if (set == NULL || err == NULL || logksi == NULL || files == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	/* Index is not available if log signature is written to stdout. */
+	if (files->files.outSig == NULL || files->internal.outSig == NULL || strcmp(files->internal.outSig, "-") == 0) {
+		res = KT_OK;
+		goto cleanup;
+	}
+
+	res = concat_names(files->internal.outSig, BLOCK_INDEX_FILE_EXTENSION, &indexFname);
+	ERR_CATCH_MSG(err, res, "Error: Could not generate block index file name.");
+
+	if (PARAM_SET_isSetByName(set, "write-index") || SMART_FILE_doFileExist(indexFname)) {
+		res = BLOCK_INDEX_new(&logksi->index);
+		ERR_CATCH_MSG(err, res, "Error: Could not create block index.");
+	}
+
+	res = KT_OK;
+
+cleanup:
+
+	KSI_free(indexFname);
+
+	return res;
+}
+
+/**
+ * Writes the block index next to the output log signature file. Log file offsets that
+ * are not known (the log file is not read by sign, extend and integrate) are taken from
+ * the index file of the input log signature file, if it is up to date.
+ */
+static int save_block_index(ERR_TRCKR *err, LOGKSI *logksi, IO_FILES *files) {
+	int res = KT_UNKNOWN_ERROR;
+	char *indexFname = NULL;
+	char *oldIndexFname = NULL;
+	BLOCK_INDEX *oldIndex = NULL;
+	size_t sigSize = 0;
+
+	if (err == NULL || logksi == NULL || files == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	if (logksi->index == NULL) {
+		res = KT_OK;
+		goto cleanup;
+	}
+
+	res = SMART_FILE_getPosition(files->files.outSig, &sigSize);
+	ERR_CATCH_MSG(err, res, "Error: Could not get the size of output log signature file.");
+
+	if (files->files.inLog != NULL) {
+		/* Log file offsets are found while reading the log file (see LOGKSI_setBlockLogOffset). */
+		if (!SMART_FILE_isStream(files->files.inLog)) {
+			res = BLOCK_INDEX_setLogFile(logksi->index, files->internal.inLog);
+			ERR_CATCH_MSG(err, res, "Error: Could not get the size of log file %s.", files->internal.inLog);
+		}
+	} else if (files->internal.inSig != NULL && strcmp(files->internal.inSig, "-") != 0) {
+		res = concat_names(files->internal.inSig, BLOCK_INDEX_FILE_EXTENSION, &oldIndexFname);
+		ERR_CATCH_MSG(err, res, "Error: Could not generate block index file name.");
+
+		/* Missing or outdated index is not an error, the offsets are just left unknown. */
+		if (SMART_FILE_doFileExist(oldIndexFname) && BLOCK_INDEX_read(oldIndexFname, files->internal.inSig, NULL, &oldIndex) == KT_OK) {
+			BLOCK_INDEX_inheritLogOffsets(logksi->index, oldIndex);
+		}
+	}
+
+	res = concat_names(files->internal.outSig, BLOCK_INDEX_FILE_EXTENSION, &indexFname);
+	ERR_CATCH_MSG(err, res, "Error: Could not generate block index file name.");
+
+	res = BLOCK_INDEX_write(logksi->index, indexFname, sigSize);
+	ERR_CATCH_MSG(err, res, "Error: Could not write block index file %s.", indexFname);
+
+	res = KT_OK;
+
+cleanup:
+
+	BLOCK_INDEX_free(oldIndex);
+	KSI_free(indexFname);
+	KSI_free(oldIndexFname);
+
+	return res;
+}
+
+/**
+ * Continues signing a followed log file from the position kept in the state file. The
+ * end of the log signature file that was written after the last durable block (e.g.
+ * a block that was not closed before a crash) is removed.
+ */
+static int resume_followed_log(MULTI_PRINTER* mp, ERR_TRCKR *err, LOGKSI *logksi, IO_FILES *files, STATE_FILE *state) {
+	int res = KT_UNKNOWN_ERROR;
+	const STATE_FILE_FOLLOW *follow = NULL;
+
+	if (err == NULL || logksi == NULL || files == NULL || state == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	follow = STATE_FILE_getFollow(state);
+	if (follow == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	res = SMART_FILE_truncate(files->files.outSig, (size_t)follow->sigSize);
+	ERR_CATCH_MSG(err, res, "Error: Could not truncate log signature file %s.", files->internal.outSig);
+
+	res = SMART_FILE_setPosition(files->files.inLog, (size_t)follow->logOffset);
+	ERR_CATCH_MSG(err, res, "Error: Could not set the position of log file %s.", files->internal.inLog);
+
+	logksi->blockNo = (size_t)follow->blockNo;
+	logksi->currentLine = (size_t)follow->lineNo;
+	logksi->file.nofTotalRecordHashes = (size_t)follow->lineNo;
+
+	print_debug_mp(mp, MP_ID_BLOCK, DEBUG_LEVEL_3, "Continuing after block no. %zu and log line %zu.\n",
+		logksi->blockNo, logksi->currentLine);
+
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
+
+/**
+ * Keeps the position of signing a followed log file in the state file. The log signature
+ * file is flushed (or synced, see #STATE_FILE_setSync) first, so that the state never
+ * refers to data that is not written.
+ */
+static int set_follow_state(ERR_TRCKR *err, LOGKSI *logksi, IO_FILES *files, STATE_FILE *state, LOG_FOLLOW *follow) {
+	int res = KT_UNKNOWN_ERROR;
+	STATE_FILE_FOLLOW pos;
+	size_t logOffset = 0;
+	size_t sigSize = 0;
+
+	if (err == NULL || logksi == NULL || files == NULL || follow == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	res = update_state_file(state, err, logksi);
+	if (res != KT_OK) goto cleanup;
+
+	res = STATE_FILE_isSync(state) ? SMART_FILE_sync(files->files.outSig) : SMART_FILE_flush(files->files.outSig);
+	ERR_CATCH_MSG(err, res, "Error: Could not write to log signature file %s.", files->internal.outSig);
+
+	res = SMART_FILE_getPosition(files->files.outSig, &sigSize);
+	ERR_CATCH_MSG(err, res, "Error: Could not get the size of output log signature file.");
+
+	res = SMART_FILE_getPosition(files->files.inLog, &logOffset);
+	ERR_CATCH_MSG(err, res, "Error: Could not get the position of log file %s.", files->internal.inLog);
+
+	pos.logDevice = LOG_FOLLOW_getDevice(follow);
+	pos.logInode = LOG_FOLLOW_getInode(follow);
+	pos.logOffset = logOffset;
+	pos.lineNo = logksi->currentLine;
+	pos.blockNo = logksi->blockNo;
+	pos.sigSize = sigSize;
+
+	res = STATE_FILE_setFollow(state, &pos);
+	ERR_CATCH_MSG(err, res, "Error: Unable to update state file.");
+
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
+
+/**
+ * Opens the block index of the input log signature file, so that only some of the blocks
+ * can be processed. If the index file is missing or out of date, the index is built by
+ * reading just the block headers and block signatures. The index is not opened and
+ * \c index is left untouched if any of the input files is read from stdin.
+ */
+static int open_input_block_index(MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *logksi, IO_FILES *files, BLOCK_INDEX **index) {
+	int res = KT_UNKNOWN_ERROR;
+	char *indexFname = NULL;
+	BLOCK_INDEX *tmp = NULL;
+	const BLOCK_INDEX_ENTRY *entry = NULL;
+	size_t i;
+
+	if (err == NULL || ksi == NULL || logksi == NULL || files == NULL || index == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	if (files->internal.inLog == NULL || files->internal.inSig == NULL ||
+		SMART_FILE_isStream(files->files.inLog) || SMART_FILE_isStream(files->files.inSig)) {
+		res = KT_OK;
+		goto cleanup;
+	}
+
+	res = concat_names(files->internal.inSig, BLOCK_INDEX_FILE_EXTENSION, &indexFname);
+	ERR_CATCH_MSG(err, res, "Error: Could not generate block index file name.");
+
+	/* Missing or outdated index file is not an error, the index is just built from scratch. */
+	if (!SMART_FILE_doFileExist(indexFname) || BLOCK_INDEX_read(indexFname, files->internal.inSig, files->internal.inLog, &tmp) != KT_OK) {
+		print_progressDesc(mp, MP_ID_BLOCK, 0, DEBUG_LEVEL_3, "Building block index... ");
+
+		res = scan_block_index(err, ksi, logksi, files->files.inSig, &tmp);
+		if (res != KT_OK) goto cleanup;
+
+		print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_3, KT_OK);
+	}
+
+	/* Log file offsets are not known if the index file is written by sign, extend or integrate or if the log file is changed. */
+	for (i = 0; i < BLOCK_INDEX_getCount(tmp); i++) {
+		entry = BLOCK_INDEX_get(tmp, i);
+		if (entry->logOffset == BLOCK_INDEX_UNKNOWN_OFFSET) break;
+	}
+
+	if (i < BLOCK_INDEX_getCount(tmp)) {
+		print_progressDesc(mp, MP_ID_BLOCK, 0, DEBUG_LEVEL_3, "Indexing log lines... ");
+
+		res = BLOCK_INDEX_setLogOffsets(tmp, files->files.inLog, files->internal.inLog);
+		if (res == KT_UNEXPECTED_EOF) {
+			entry = BLOCK_INDEX_get(tmp, BLOCK_INDEX_getCount(tmp) - 1);
+			ERR_TRCKR_ADD(err, res, "Error: Log file %s has less lines (%llu expected).", files->internal.inLog, (unsigned long long)entry->lastLine);
+		}
+		ERR_CATCH_MSG(err, res, "Error: Could not find the offsets of blocks in log file.");
+
+		print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_3, KT_OK);
+	}
+
+	*index = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_3, res);
+	MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
+	BLOCK_INDEX_free(tmp);
+	KSI_free(indexFname);
+
+	return res;
+}
+
+/**
+ * Processes only the blocks that contain extract positions. Both input files are moved
+ * to the beginning of the block with the offsets from the block index and the blocks
+ * in between are skipped. Positions that are out of range are left pending, so that
+ * they are reported by finalize_log_signature.
+ */
+static int extract_indexed_blocks(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *logksi, IO_FILES *files, SIGNATURE_PROCESSORS *processors) {
+	int res = KT_UNKNOWN_ERROR;
+	BLOCK_INDEX *index = NULL;
+	const BLOCK_INDEX_ENTRY *entry = NULL;
+	size_t i = 0;
+
+	if (set == NULL || err == NULL || ksi == NULL || logksi == NULL || files == NULL || processors == NULL || logksi->task.extract.index == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	index = logksi->task.extract.index;
+
+	/* Log lines of the skipped blocks are not read. */
+	logksi->file.isPartial = 1;
+
+	while (EXTRACT_INFO_isLastPosPending(logksi->task.extract.info)) {
+		res = BLOCK_INDEX_findByLine(index, EXTRACT_INFO_getNextPosition(logksi->task.extract.info), &i);
+		if (res == KT_INDEX_OVF) break;
+		ERR_CATCH_MSG(err, res, "Error: Unable to find the block of extract position %zu.", EXTRACT_INFO_getNextPosition(logksi->task.extract.info));
+
+		entry = BLOCK_INDEX_get(index, i);
+
+		/* All positions of a block are extracted at once, so the blocks are only moved forward. */
+		res = LOGKSI_skipToBlock(logksi, index, i);
+		ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to skip to the block.", entry->blockNo);
+
+		res = SMART_FILE_setPosition(files->files.inSig, entry->sigOffset);
+		ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to move to the block header in log signature file.", entry->blockNo);
+
+		res = SMART_FILE_setPosition(files->files.inLog, entry->logOffset);
+		ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to move to the first line of the block in log file.", entry->blockNo);
+
+		res = LOGKSI_FTLV_smartFileRead(files->files.inSig, logksi->ftlv_raw, SOF_FTLV_BUFFER, &logksi->ftlv_len, &logksi->ftlv);
+		if (res != KSI_OK || logksi->ftlv.tag != 0x901) {
+			res = KT_INVALID_INPUT_FORMAT;
+			ERR_CATCH_MSG(err, res, "Error: Block no. %zu: block header not found at the offset given by the block index.", entry->blockNo);
+		}
+
+		/* Process the block up to and including the block signature. */
+		do {
+			switch (logksi->ftlv.tag) {
+				case 0x901:
+				case 0x902:
+				case 0x903:
+				case 0x911:
+				case 0x904:
+					res = process_log_signature_with_block_signature(set, mp, err, logksi, files, ksi, processors, NULL);
+					if (res != KT_OK) goto cleanup;
+				break;
+
+				default:
+				break;
+			}
+
+			if (logksi->ftlv.tag == 0x904) break;
+
+			MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
+
+			res = LOGKSI_FTLV_smartFileRead(files->files.inSig, logksi->ftlv_raw, SOF_FTLV_BUFFER, &logksi->ftlv_len, &logksi->ftlv);
+			if (res != KSI_OK) {
+				res = KT_INVALID_INPUT_FORMAT;
+				ERR_CATCH_MSG(err, res, "Error: Block no. %zu: incomplete data found in log signature file.", logksi->blockNo);
+			}
+		} while (1);
+
+		res = finalize_block(set, mp, err, logksi, files, ksi);
+		if (res != KT_OK) goto cleanup;
+	}
+
+	/* Skip the rest of the blocks, so that the summary covers the whole log signature file. */
+	res = LOGKSI_skipToBlock(logksi, index, BLOCK_INDEX_getCount(index));
+	ERR_CATCH_MSG(err, res, "Error: Unable to skip to the end of log signature file.");
+
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
+
+/**
+ * Returns the record time of the first log line of the block. Blocks without log lines
+ * get the record time of the next block that has log lines or UINT64_MAX if there is no
+ * such block, so that the times of the blocks are in ascending order.
+ */
+static int get_block_record_time(PARAM_SET *set, ERR_TRCKR *err, IO_FILES *files, BLOCK_INDEX *index, size_t i, uint64_t *time) {
+	int res = KT_UNKNOWN_ERROR;
+	const BLOCK_INDEX_ENTRY *entry = NULL;
+	char buf[1024];
+
+	if (set == NULL || err == NULL || files == NULL || index == NULL || time == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	for (; i < BLOCK_INDEX_getCount(index); i++) {
+		entry = BLOCK_INDEX_get(index, i);
+		if (entry->lastLine >= entry->firstLine) break;
+	}
+
+	if (i == BLOCK_INDEX_getCount(index)) {
+		*time = UINT64_MAX;
+		res = KT_OK;
+		goto cleanup;
+	}
+
+	res = SMART_FILE_setPosition(files->files.inLog, entry->logOffset);
+	ERR_CATCH_MSG(err, res, "Error: Block no. %llu: unable to move to the first line of the block in log file.", (unsigned long long)entry->blockNo);
+
+	/* Only the beginning of the line is needed to extract the time. */
+	res = SMART_FILE_readLine(files->files.inLog, buf, sizeof(buf), NULL);
+	if (res != SMART_FILE_OK && res != SMART_FILE_NO_EOL) {
+		ERR_CATCH_MSG(err, res, "Error: Block no. %llu: unable to read log line %llu.", (unsigned long long)entry->blockNo, (unsigned long long)entry->firstLine);
+	}
+
+	res = get_log_line_time(set, buf, time);
+	ERR_CATCH_MSG(err, res, "Error: Block no. %llu: unable to extract time stamp from the log line no. %llu.", (unsigned long long)entry->blockNo, (unsigned long long)entry->firstLine);
+
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
+
+/**
+ * Finds the first block with a record time (see get_block_record_time) that is not
+ * less than \c time or, if \c isInclusive is not set, greater than \c time. As only
+ * the first log line of a block is read, the log records are expected to be in
+ * chronological order.
+ */
+static int find_block_by_record_time(PARAM_SET *set, ERR_TRCKR *err, IO_FILES *files, BLOCK_INDEX *index, uint64_t time, int isInclusive, size_t *i) {
+	int res = KT_UNKNOWN_ERROR;
+	size_t lo = 0;
+	size_t hi = 0;
+	uint64_t blockTime = 0;
+
+	if (set == NULL || err == NULL || files == NULL || index == NULL || i == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	hi = BLOCK_INDEX_getCount(index);
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+
+		res = get_block_record_time(set, err, files, index, mid, &blockTime);
+		if (res != KT_OK) goto cleanup;
+
+		if (isInclusive ? (blockTime >= time) : (blockTime > time)) {
+			hi = mid;
+		} else {
+			lo = mid + 1;
+		}
+	}
+
+	*i = lo;
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
+
+/**
+ * Opens the block index and moves both input files to the first block that is selected
+ * with --lines or --time-range. The blocks before it are skipped (see LOGKSI_skipToBlock).
+ * The number of the last selected block is returned, so that the verification can be
+ * stopped after it.
+ */
+static int skip_to_verified_blocks(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *logksi, IO_FILES *files, BLOCK_INDEX **index, size_t *lastBlockNo) {
+	int res = KT_UNKNOWN_ERROR;
+	BLOCK_INDEX *tmp = NULL;
+	UINT64_RANGE range;
+	size_t count = 0;
+	size_t first = 0;
+	size_t last = 0;
+
+	if (set == NULL || err == NULL || ksi == NULL || logksi == NULL || files == NULL || index == NULL || lastBlockNo == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	if (logksi->file.version != LOGSIG11 && logksi->file.version != LOGSIG12) {
+		res = KT_INVALID_CMD_PARAM;
+		ERR_CATCH_MSG(err, res, "Error: --lines and --time-range can not be used with excerpt file.");
+	}
+
+	res = open_input_block_index(mp, err, ksi, logksi, files, &tmp);
+	if (res != KT_OK) goto cleanup;
+
+	if (tmp == NULL) {
+		res = KT_INVALID_CMD_PARAM;
+		ERR_CATCH_MSG(err, res, "Error: --lines and --time-range can not be used when log or log signature file is read from stdin.");
+	}
+
+	count = BLOCK_INDEX_getCount(tmp);
+	if (count == 0) {
+		res = KT_INVALID_INPUT_FORMAT;
+		ERR_CATCH_MSG(err, res, "Error: No blocks found.");
+	}
+
+	if (PARAM_SET_isSetByName(set, "lines")) {
+		uint64_t nofLines = BLOCK_INDEX_get(tmp, count - 1)->lastLine;
+
+		res = PARAM_SET_getObj(set, "lines", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, (void**)&range);
+		ERR_CATCH_MSG(err, res, "Error: Unable to extract line range.");
+
+		if (range.from > nofLines) {
+			res = KT_INVALID_CMD_PARAM;
+			ERR_CATCH_MSG(err, res, "Error: Line %llu out of range - log file has %llu lines.", (unsigned long long)range.from, (unsigned long long)nofLines);
+		}
+
+		if (range.to > nofLines) range.to = nofLines;
+
+		res = BLOCK_INDEX_findByLine(tmp, range.from, &first);
+		ERR_CATCH_MSG(err, res, "Error: Unable to find the block of log line %llu.", (unsigned long long)range.from);
+
+		res = BLOCK_INDEX_findByLine(tmp, range.to, &last);
+		ERR_CATCH_MSG(err, res, "Error: Unable to find the block of log line %llu.", (unsigned long long)range.to);
+	} else {
+		res = PARAM_SET_getObj(set, "time-range", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, (void**)&range);
+		ERR_CATCH_MSG(err, res, "Error: Unable to extract time range.");
+
+		print_progressDesc(mp, MP_ID_BLOCK, 0, DEBUG_LEVEL_3, "Searching blocks by record time... ");
+
+		/* The block before the first block with a more recent record time may still contain records from the time window. */
+		res = find_block_by_record_time(set, err, files, tmp, range.from, 1, &first);
+		if (res != KT_OK) goto cleanup;
+		if (first > 0) first--;
+
+		res = find_block_by_record_time(set, err, files, tmp, range.to, 0, &last);
+		if (res != KT_OK) goto cleanup;
+
+		print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_3, res);
+
+		if (last == 0) {
+			res = KT_INVALID_CMD_PARAM;
+			ERR_CATCH_MSG(err, res, "Error: Time range does not contain any log records.");
+		}
+		last--;
+	}
+
+	print_debug_mp(mp, MP_ID_BLOCK, DEBUG_LEVEL_3, "Verifying blocks %zu - %zu of %zu.\n", first + 1, last + 1, count);
+
+	res = skip_to_block(err, logksi, files, tmp, first);
+	if (res != KT_OK) goto cleanup;
+
+	/* Log lines outside of the selected blocks are not read. */
+	logksi->file.isPartial = 1;
+
+	*lastBlockNo = BLOCK_INDEX_get(tmp, last)->blockNo;
+	*index = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_3, res);
+	MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
+	BLOCK_INDEX_free(tmp);
+
+	return res;
+}
+
+/**
+ * Moves to the first block of the range of blocks that is verified on its own (see verify
+ * --jobs) and returns the number of the last block of the range. The block index and the
+ * range are taken from the task. Inter-linking with the previous block and the signing time
+ * and record time checks against the previous blocks are left to the caller (see
+ * #logsignature_verify_between_blocks).
+ */
+static int skip_to_block_range(MULTI_PRINTER* mp, ERR_TRCKR *err, LOGKSI *logksi, IO_FILES *files, size_t *lastBlockNo) {
+	int res = KT_UNKNOWN_ERROR;
+	BLOCK_INDEX *index = NULL;
+	size_t first = 0;
+	size_t last = 0;
+	size_t count = 0;
+
+	if (err == NULL || logksi == NULL || files == NULL || lastBlockNo == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	index = logksi->task.verify.index;
+	first = logksi->task.verify.firstBlock;
+	last = logksi->task.verify.lastBlock;
+	count = BLOCK_INDEX_getCount(index);
+
+	if (logksi->file.version != LOGSIG11 && logksi->file.version != LOGSIG12) {
+		res = KT_INVALID_INPUT_FORMAT;
+		ERR_CATCH_MSG(err, res, "Error: Blocks of excerpt file can not be verified separately.");
+	}
+
+	if (first > last || last >= count) {
+		res = KT_INVALID_ARGUMENT;
+		ERR_CATCH_MSG(err, res, "Error: Blocks %zu - %zu out of range - log signature file has %zu blocks.", first + 1, last + 1, count);
+	}
+
+	print_debug_mp(mp, MP_ID_BLOCK, DEBUG_LEVEL_3, "Verifying blocks %zu - %zu of %zu.\n", first + 1, last + 1, count);
+
+	/* Block index is not trusted, the first block must start right after the file header and at the beginning of the log file. */
+	if (first == 0) {
+		const BLOCK_INDEX_ENTRY *entry = BLOCK_INDEX_get(index, 0);
+		size_t sigOffset = 0;
+		size_t logOffset = 0;
+
+		res = SMART_FILE_getPosition(files->files.inSig, &sigOffset);
+		if (res == SMART_FILE_OK) res = get_log_position(logksi, files, &logOffset);
+		ERR_CATCH_MSG(err, res, "Error: Unable to get the positions of the first block in log signature file and in log file.");
+
+		if (entry->sigOffset != sigOffset || entry->logOffset != logOffset) {
+			res = KT_VERIFICATION_FAILURE;
+			ERR_CATCH_MSG(err, res, "Error: Block no. %llu: block index does not match the log signature file or the log file.", (unsigned long long)entry->blockNo);
+		}
+	}
+
+	res = skip_to_block(err, logksi, files, index, first);
+	if (res != KT_OK) goto cleanup;
+
+	/* Signing time of the previous block is checked when the previous range is finished. */
+	logksi->sigTime_0 = 0;
+
+	/* End of the log file is checked only with the last range. */
+	logksi->file.isPartial = (last + 1 < count);
+
+	*lastBlockNo = BLOCK_INDEX_get(index, last)->blockNo;
+	res = KT_OK;
+
+cleanup:
+
+	MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
+
+	return res;
+}
+
+/**
+ * Returns the position in the log file where the next log line starts. Lines read ahead by
+ * the hashing threads (see LOGLINE_PIPELINE_getPosition) are not counted.
+ */
+static int get_log_position(LOGKSI *logksi, IO_FILES *files, size_t *pos) {
+	if (logksi == NULL || files == NULL || pos == NULL) return KT_INVALID_ARGUMENT;
+
+	if (files->files.inLog == NULL) {
+		*pos = 0;
+		return KT_OK;
+	}
+
+	if (logksi->logLinePipeline != NULL) return LOGLINE_PIPELINE_getPosition(logksi->logLinePipeline, files->files.inLog, pos);
+
+	return SMART_FILE_getPosition(files->files.inLog, pos);
+}
+
+/**
+ * Moves the state to the beginning of the block with index \c i (see LOGKSI_skipToBlock) and
+ * the log signature file and the log file to the block header and to the first line of the
+ * block.
+ */
+static int skip_to_block(ERR_TRCKR *err, LOGKSI *logksi, IO_FILES *files, BLOCK_INDEX *index, size_t i) {
+	int res = KT_UNKNOWN_ERROR;
+	const BLOCK_INDEX_ENTRY *entry = NULL;
+
+	if (err == NULL || logksi == NULL || files == NULL || index == NULL || i >= BLOCK_INDEX_getCount(index)) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	entry = BLOCK_INDEX_get(index, i);
+
+	res = LOGKSI_skipToBlock(logksi, index, i);
+	ERR_CATCH_MSG(err, res, "Error: Block no. %llu: unable to skip to the block.", (unsigned long long)entry->blockNo);
+
+	res = SMART_FILE_setPosition(files->files.inSig, entry->sigOffset);
+	ERR_CATCH_MSG(err, res, "Error: Block no. %llu: unable to move to the block header in log signature file.", (unsigned long long)entry->blockNo);
+
+	res = SMART_FILE_setPosition(files->files.inLog, entry->logOffset);
+	ERR_CATCH_MSG(err, res, "Error: Block no. %llu: unable to move to the first line of the block in log file.", (unsigned long long)entry->blockNo);
+
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
+
+/**
+ * Computes SHA-256 of the bytes of \c in from offset \c from up to (not including) offset
+ * \c to or up to the end of file if \c to is UINT64_MAX.
+ */
+static int digest_file_range(KSI_DataHasher *hsr, SMART_FILE *in, uint64_t from, uint64_t to, unsigned char *digest) {
+	int res = KT_UNKNOWN_ERROR;
+	unsigned char buf[0x10000];
+	uint64_t remaining = to - from;
+	KSI_DataHash *hash = NULL;
+	KSI_HashAlgorithm algo = KSI_HASHALG_INVALID_VALUE;
+	const unsigned char *tmp = NULL;
+	size_t tmp_len = 0;
+	size_t count = 0;
+
+	if (hsr == NULL || in == NULL || digest == NULL || to < from) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	res = SMART_FILE_setPosition(in, from);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	res = KSI_DataHasher_reset(hsr);
+	if (res != KSI_OK) goto cleanup;
+
+	while (remaining > 0) {
+		res = SMART_FILE_read(in, buf, (remaining < sizeof(buf)) ? (size_t)remaining : sizeof(buf), &count);
+		if (res != SMART_FILE_OK) goto cleanup;
+		if (count == 0) break;
+
+		res = KSI_DataHasher_add(hsr, buf, count);
+		if (res != KSI_OK) goto cleanup;
+
+		if (to != UINT64_MAX) remaining -= count;
+	}
+
+	res = KSI_DataHasher_close(hsr, &hash);
+	if (res != KSI_OK) goto cleanup;
+
+	res = KSI_DataHash_extract(hash, &algo, &tmp, &tmp_len);
+	if (res != KSI_OK) goto cleanup;
+
+	if (tmp_len != VERIFY_LEDGER_DIGEST_SIZE) {
+		res = KT_UNKNOWN_ERROR;
+		goto cleanup;
+	}
+
+	memcpy(digest, tmp, VERIFY_LEDGER_DIGEST_SIZE);
+	res = KT_OK;
+
+cleanup:
+
+	KSI_DataHash_free(hash);
+
+	return res;
+}
+
+static void verify_ledger_set_imprint(KSI_DataHash *hash, unsigned char *imprint, size_t *imprint_len) {
+	const unsigned char *tmp = NULL;
+	size_t tmp_len = 0;
+
+	if (hash == NULL || KSI_DataHash_getImprint(hash, &tmp, &tmp_len) != KSI_OK || tmp_len > KSI_MAX_IMPRINT_LEN) {
+		*imprint_len = 0;
+		return;
+	}
+
+	memcpy(imprint, tmp, tmp_len);
+	*imprint_len = tmp_len;
+}
+
+static int check_inter_linking_input_hash(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, IO_FILES *files, size_t blockNo, KSI_DataHash *firstLink, KSI_DataHash *inputHash) {
+	int res = KT_UNKNOWN_ERROR;
+
+	print_progressDesc(mp, MP_ID_BLOCK, 0, DEBUG_LEVEL_3, "Block no. %3zu: verifying inter-linking input hash... ", blockNo);
+
+	if (!KSI_DataHash_equals(firstLink, inputHash)) {
+		char buf_imp[1024];
+		char buf_exp_imp[1024];
+		char buf_fname[4096];
+		char *prevBlockSource = "Unexpected and not initialized previous block source.";
+		const char *firstBlockSource = IO_FILES_getCurrentLogFilePrintRepresentation(files);
+
+		res = KT_VERIFICATION_FAILURE;
+
+		if (PARAM_SET_isSetByName(set, "input-hash") && files->previousLogFile[0] == '\0') {
+			char *fname = NULL;
+			PARAM_SET_getStr(set, "input-hash", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, &fname);
+
+			PST_snprintf(buf_fname, sizeof(buf_fname), "from --input-hash %s", fname);
+			prevBlockSource = buf_fname;
+		} else {
+			prevBlockSource = files->previousLogFile;
+		}
+
+		ERR_TRCKR_ADD(err, res, "Error: Block no. %zu: The last leaf from the previous block (%s) does not match with the current first block (%s). Expecting '%s', but got '%s'.", blockNo, prevBlockSource, firstBlockSource, LOGKSI_DataHash_toString(firstLink, buf_exp_imp, sizeof(buf_exp_imp)), LOGKSI_DataHash_toString(inputHash, buf_imp, sizeof(buf_imp)));
+
+		goto cleanup;
+	}
+
+	res = KT_OK;
+
+cleanup:
+
+	print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_3, res);
+
+	return res;
+}
+
+/**
+ * Computes the digests of every block in the log signature file and in the log file and
+ * skips the leading blocks that are recorded in the verification ledger as verified with
+ * the same policy and that have not been changed since. The last block is always verified.
+ * The last leaf of the last skipped block is taken from the ledger, so the input hash of
+ * the next block is still checked against it. Ledger entries of all blocks are returned,
+ * so that the outcome can be recorded when the verification is finished. Nothing is done
+ * for excerpt files and when any of the input files is read from stdin.
+ */
+static int skip_blocks_verified_earlier(MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *logksi, IO_FILES *files, VERIFY_LEDGER *ledger, BLOCK_INDEX **index, VERIFY_LEDGER_ENTRY **entries, size_t *count, KSI_DataHash **firstInputHash) {
+	int res = KT_UNKNOWN_ERROR;
+	BLOCK_INDEX *tmpIndex = NULL;
+	VERIFY_LEDGER_ENTRY *tmp = NULL;
+	const VERIFY_LEDGER_ENTRY *stored = NULL;
+	const BLOCK_INDEX_ENTRY *entry = NULL;
+	const BLOCK_INDEX_ENTRY *next = NULL;
+	KSI_DataHasher *hsr = NULL;
+	KSI_DataHash *inputHash = NULL;
+	KSI_DataHash *lastLeaf = NULL;
+	KSI_HashAlgorithm algo = KSI_HASHALG_INVALID_VALUE;
+	size_t nofBlocks = 0;
+	size_t nofSkipped = 0;
+	size_t i;
+
+	if (err == NULL || ksi == NULL || logksi == NULL || files == NULL || ledger == NULL || index == NULL || entries == NULL || count == NULL || firstInputHash == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	if (logksi->file.version != LOGSIG11 && logksi->file.version != LOGSIG12) {
+		res = KT_OK;
+		goto cleanup;
+	}
+
+	res = open_input_block_index(mp, err, ksi, logksi, files, &tmpIndex);
+	if (res != KT_OK) goto cleanup;
+
+	nofBlocks = BLOCK_INDEX_getCount(tmpIndex);
+	if (nofBlocks == 0) {
+		res = KT_OK;
+		goto cleanup;
+	}
 
-		maxInputs = user_block_size;
+	tmp = (VERIFY_LEDGER_ENTRY*)calloc(nofBlocks, sizeof(VERIFY_LEDGER_ENTRY));
+	if (tmp == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
 	}
 
-	res = SMART_FILE_write(files->files.outSig, (unsigned char*)LOGSIG_VERSION_toString(blocks->file.version), MAGIC_SIZE, NULL);
-	ERR_CATCH_MSG(err, res, "Error: Could not write magic number to log signature file.");
+	res = KSI_DataHasher_open(ksi, KSI_HASHALG_SHA2_256, &hsr);
+	ERR_CATCH_MSG(err, res, "Error: Could not open SHA-256 hasher.");
 
-	while (!SMART_FILE_isEof(files->files.inLog)) {
-		MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
+	print_progressDesc(mp, MP_ID_BLOCK, 0, DEBUG_LEVEL_3, "Comparing blocks with verification ledger... ");
 
-		if (blocks->block.recordCount == 0) {
-			blocks->blockNo++;
+	for (i = 0; i < nofBlocks; i++) {
+		entry = BLOCK_INDEX_get(tmpIndex, i);
+		next = (i + 1 < nofBlocks) ? BLOCK_INDEX_get(tmpIndex, i + 1) : NULL;
 
-			KSI_OctetString_free(seed);
-			seed = NULL;
-			res = get_random_seed(files, err, ksi, seed_len, &seed);
-			if (res != KT_OK) goto cleanup;
+		tmp[i].blockNo = entry->blockNo;
+		tmp[i].outcome = KT_UNKNOWN_ERROR;
+		memcpy(tmp[i].policy, VERIFY_LEDGER_getPolicy(ledger), VERIFY_LEDGER_DIGEST_SIZE);
 
-			res = MERKLE_TREE_reset(blocks->tree, aggrAlgo,
-				KSI_DataHash_ref(STATE_FILE_lastLeaf(state)),
-				KSI_OctetString_ref(seed));
-			ERR_CATCH_MSG(err, res, "Error: Could not reset merkle tree object.");
+		res = digest_file_range(hsr, files->files.inSig, entry->sigOffset, (next != NULL) ? next->sigOffset : UINT64_MAX, tmp[i].sigDigest);
+		ERR_CATCH_MSG(err, res, "Error: Block no. %llu: unable to compute the digest of the block in log signature file.", (unsigned long long)entry->blockNo);
 
-			print_progressDesc(mp, MP_ID_BLOCK, 0, DEBUG_LEVEL_3, "Block no. %3zu: processing block header... ", blocks->blockNo);
-			res = tlv_element_write_header(ksi, aggrAlgo, seed, blocks->block.inputHash, files->files.outSig);
-			ERR_CATCH_MSG(err, res, "Error: Could not write block header to log signature file.");
-			print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_3, res);
-			print_debug_mp(mp, MP_ID_BLOCK, DEBUG_LEVEL_3, "Block no. %3zu: input hash: %s.\n", blocks->blockNo,
-				LOGKSI_DataHash_toString(blocks->block.inputHash, buf, sizeof(buf)));
+		res = digest_file_range(hsr, files->files.inLog, entry->logOffset, (next != NULL) ? next->logOffset : UINT64_MAX, tmp[i].logDigest);
+		ERR_CATCH_MSG(err, res, "Error: Block no. %llu: unable to compute the digest of the block in log file.", (unsigned long long)entry->blockNo);
 
-			print_debug_mp(mp, MP_ID_BLOCK_PARSING_TREE_NODES, DEBUG_LEVEL_3, "Block no. %3zu: {", blocks->blockNo);
+		/* Only unchanged blocks from the beginning of the file can be skipped. */
+		if (nofSkipped == i && next != NULL) {
+			stored = VERIFY_LEDGER_get(ledger, files->internal.inSig, entry->blockNo);
+
+			if (stored != NULL && stored->outcome == KT_OK && stored->inputHash_len > 0 && stored->lastLeaf_len > 0 &&
+				memcmp(stored->policy, tmp[i].policy, VERIFY_LEDGER_DIGEST_SIZE) == 0 &&
+				memcmp(stored->sigDigest, tmp[i].sigDigest, VERIFY_LEDGER_DIGEST_SIZE) == 0 &&
+				memcmp(stored->logDigest, tmp[i].logDigest, VERIFY_LEDGER_DIGEST_SIZE) == 0) {
+				tmp[i] = *stored;
+				nofSkipped++;
+			}
 		}
+	}
 
-		res = logksi_logline_calculate_hash_and_store(blocks, files, &recordHash);
-		if (res == KT_UNEXPECTED_EOF) break;
-		ERR_CATCH_MSG(err, res, "Error: Unable to read from file %s.", files->internal.outLog);
+	print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_3, KT_OK);
 
+	if (nofSkipped > 0) {
+		print_debug_mp(mp, MP_ID_BLOCK, DEBUG_LEVEL_3, "Skipping %zu blocks verified earlier (see --ledger).\n", nofSkipped);
 
-		res = MERKLE_TREE_addRecordHash(blocks->tree, 0, recordHash);
-		ERR_CATCH_MSG(err, res, "Error: Could not add record hash to tree.");
-		KSI_DataHash_free(recordHash);
-		recordHash = NULL;
-		blocks->currentLine++;
-		blocks->block.recordCount++;
-		blocks->file.nofTotalRecordHashes++;
+		res = LOGKSI_DataHash_fromImprint(err, ksi, tmp[0].inputHash, tmp[0].inputHash_len, &inputHash);
+		ERR_CATCH_MSG(err, res, "Error: Unable to parse input hash of block no. 1 stored in verification ledger.");
 
-		res = update_state_file(state, err, blocks);
-		if (res != KT_OK) goto cleanup;
+		res = LOGKSI_DataHash_fromImprint(err, ksi, tmp[nofSkipped - 1].lastLeaf, tmp[nofSkipped - 1].lastLeaf_len, &lastLeaf);
+		ERR_CATCH_MSG(err, res, "Error: Unable to parse last leaf of block no. %zu stored in verification ledger.", nofSkipped);
 
-		if (blocks->block.firstLineNo == 0) {
-			blocks->block.firstLineNo = blocks->currentLine;
-		}
+		res = KSI_DataHash_getHashAlg(lastLeaf, &algo);
+		ERR_CATCH_MSG(err, res, "Error: Unable to get hash algorithm of the last leaf.");
 
-		if (blocks->block.recordCount >= maxInputs) {
-			res = finalize_new_log_sig_block(set, mp, err, ksi, files, blocks);
-			 if (res != KT_OK) goto cleanup;
+		res = LOGKSI_skipToBlock(logksi, tmpIndex, nofSkipped);
+		ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to skip to the block.", nofSkipped + 1);
 
-			blocks->block.recordCount = 0;
-			blocks->block.firstLineNo = blocks->file.nofTotalRecordHashes + 1;
-		}
+		/* Input hash of the next block is compared with the last leaf of the skipped block. */
+		res = MERKLE_TREE_reset(logksi->tree, algo, lastLeaf, NULL);
+		lastLeaf = NULL;
+		ERR_CATCH_MSG(err, res, "Error: Unable to reset MERKLE_TREE.");
 	}
 
-	res = add_metadata(blocks, err, ksi, files,
-	META_DATA_BLOCK_CLOSE_REASON,
-	"Block closed due to file closure."	);
-	ERR_CATCH_MSG(err, res, "Error: Could not add metadata.");
-	blocks->block.nofMetaRecords++;
-	blocks->file.nofTotalMetarecords++;
+	entry = BLOCK_INDEX_get(tmpIndex, nofSkipped);
 
+	res = SMART_FILE_setPosition(files->files.inSig, entry->sigOffset);
+	ERR_CATCH_MSG(err, res, "Error: Block no. %llu: unable to move to the block header in log signature file.", (unsigned long long)entry->blockNo);
 
-	res = finalize_new_log_sig_file(set, mp, err, ksi, files, blocks, theFirstInputHashInFile);
-	if (res != KT_OK) goto cleanup;
+	res = SMART_FILE_setPosition(files->files.inLog, entry->logOffset);
+	ERR_CATCH_MSG(err, res, "Error: Block no. %llu: unable to move to the first line of the block in log file.", (unsigned long long)entry->blockNo);
 
-	res = update_state_file(state, err, blocks);
-	if (res != KT_OK) goto cleanup;
+	*index = tmpIndex;
+	tmpIndex = NULL;
+	*entries = tmp;
+	tmp = NULL;
+	*count = nofBlocks;
+	*firstInputHash = inputHash;
+	inputHash = NULL;
+	res = KT_OK;
 
+cleanup:
+
+	print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_3, res);
+	MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
+	BLOCK_INDEX_free(tmpIndex);
+	KSI_DataHasher_free(hsr);
+	KSI_DataHash_free(inputHash);
+	KSI_DataHash_free(lastLeaf);
+	free(tmp);
+
+	return res;
+}
+
+/**
+ * Records the outcome of the verification in the ledger. If the verification of a block
+ * failed, the blocks before it are recorded as verified and the failed block with its
+ * outcome. Entries of the blocks after it are dropped.
+ */
+static int update_verify_ledger(ERR_TRCKR *err, LOGKSI *logksi, IO_FILES *files, VERIFY_LEDGER *ledger, VERIFY_LEDGER_ENTRY *entries, size_t count, int result) {
+	int res = KT_UNKNOWN_ERROR;
+	size_t nofVerified = 0;
+	size_t i;
+
+	if (err == NULL || logksi == NULL || files == NULL || ledger == NULL || entries == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	if (result == KT_OK) {
+		nofVerified = count;
+	} else if (logksi->task.verify.errSignTime) {
+		/* Signing times are checked between blocks, so the failure can not be assigned to a single block. */
+		nofVerified = 0;
+	} else if (logksi->blockNo > 0 && logksi->blockNo <= count) {
+		nofVerified = logksi->blockNo - 1;
+	} else {
+		nofVerified = (logksi->blockNo > count) ? count : 0;
+	}
+
+	for (i = 0; i < nofVerified; i++) {
+		entries[i].outcome = KT_OK;
+	}
+
+	/* Failed block is recorded with its outcome. */
+	if (nofVerified < count && logksi->blockNo == nofVerified + 1 && (result == KT_VERIFICATION_FAILURE || result == KSI_VERIFICATION_FAILURE || result == KT_VERIFICATION_NA) && !logksi->task.verify.errSignTime) {
+		entries[nofVerified].outcome = result;
+		nofVerified++;
+	}
+
+	res = VERIFY_LEDGER_set(ledger, files->internal.inSig, entries, nofVerified);
+	ERR_CATCH_MSG(err, res, "Error: Unable to update verification ledger.");
 
-	res = SMART_FILE_markConsistent(files->files.outSig);
-	ERR_CATCH_MSG(err, res, "Error: Could not close output log signature file %s.", files->internal.outSig);
-	blocks->task.sign.outSigModified = 1;
 	res = KT_OK;
 
 cleanup:
-	/**
-	 * + If there is error mark output file as inconsistent.
-	 * + Inconsistent state discards temporary file created.
-	 */
-	if (files->files.outSig != NULL && res != KT_OK) {
-		int tmp_res;
-		tmp_res = SMART_FILE_markInconsistent(files->files.outSig);
-		ERR_CATCH_MSG(err, tmp_res, "Error: Unable to mark output signature file as inconsistent.");
+
+	return res;
+}
+
+/**
+ * Extends the block signatures without rebuilding the Merkle trees (see --skip-tree-check).
+ * Only the headers of the other TLVs are read and the data between the block signatures
+ * is copied to the output log signature file with #SMART_FILE_copyRange.
+ */
+static int extend_block_signatures_only(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, KSI_PublicationsFile* pubFile, SIGNATURE_PROCESSORS *processors, LOGKSI *logksi, IO_FILES *files) {
+	int res = KT_UNKNOWN_ERROR;
+	SMART_FILE *in = NULL;
+	SMART_FILE *out = NULL;
+	size_t copyFrom = 0;
+	size_t pos = 0;
+	size_t hdr_len = 0;
+
+	if (set == NULL || err == NULL || ksi == NULL || processors == NULL || logksi == NULL || files == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
 	}
 
-	if (lastError != KT_OK) {
-		res = lastError;
-		ERR_TRCKR_ADD(err, res, "Error: Signing FAILED but was continued. All failed blocks are left unsigned!");
+	in = files->files.inSig;
+	out = files->files.outSig;
+
+	res = SMART_FILE_getPosition(in, &copyFrom);
+	ERR_CATCH_MSG(err, res, "Error: Could not get the position of input log signature file.");
+
+	while (1) {
+		MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
+
+		res = SMART_FILE_getPosition(in, &pos);
+		ERR_CATCH_MSG(err, res, "Error: Block no. %zu: could not get the position of input log signature file.", logksi->blockNo);
+
+		res = LOGKSI_FTLV_smartFileReadHeader(in, &hdr_len, &logksi->ftlv);
+		if (res == KT_INVALID_INPUT_FORMAT && hdr_len == 0) break;
+		ERR_CATCH_MSG(err, res, "Error: Block no. %zu: incomplete data found in log signature file.", logksi->blockNo);
+
+		switch (logksi->ftlv.tag) {
+			case 0x901:
+				/* Previous block must be in the output file before its end is marked consistent. */
+				res = SMART_FILE_copyRange(in, copyFrom, pos - copyFrom, out, NULL);
+				ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to copy block data to output log signature file.", logksi->blockNo);
+				copyFrom = pos;
+
+				res = finalize_block(set, mp, err, logksi, files, ksi);
+				if (res != KT_OK) goto cleanup;
+
+				res = LOGKSI_initNextBlock(logksi);
+				if (res != KT_OK) goto cleanup;
+
+				res = SMART_FILE_markConsistent(out);
+				ERR_CATCH_MSG(err, res, "Error: Block no. %zu: Unable to mark output log signature file consistent.", logksi->blockNo);
+
+				res = LOGKSI_setBlockSigOffset(logksi, out, 0);
+				if (res != KT_OK) goto cleanup;
+			break;
+
+			case 0x911:
+				logksi->block.nofMetaRecords++;
+				logksi->file.nofTotalMetarecords++;
+			break;
+
+			case 0x902:
+			case 0x903:
+			break;
+
+			case 0x904:
+				res = SMART_FILE_copyRange(in, copyFrom, pos - copyFrom, out, NULL);
+				ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to copy block data to output log signature file.", logksi->blockNo);
+
+				res = LOGKSI_FTLV_smartFileRead(in, logksi->ftlv_raw, SOF_FTLV_BUFFER, &logksi->ftlv_len, &logksi->ftlv);
+				ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to read block signature.", logksi->blockNo);
+
+				res = process_block_signature_without_tree(set, mp, err, logksi, files, ksi, processors, pubFile);
+				if (res != KT_OK) goto cleanup;
+
+				copyFrom = pos + logksi->ftlv_len;
+			continue;
+
+			default:
+				/* Unknown TLVs are not copied, as it is done when the file is fully parsed. */
+				res = SMART_FILE_copyRange(in, copyFrom, pos - copyFrom, out, NULL);
+				ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to copy block data to output log signature file.", logksi->blockNo);
+
+				copyFrom = pos + logksi->ftlv.hdr_len + logksi->ftlv.dat_len;
+			break;
+		}
+
+		res = SMART_FILE_setPosition(in, pos + logksi->ftlv.hdr_len + logksi->ftlv.dat_len);
+		ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to skip data in log signature file.", logksi->blockNo);
 	}
 
-	print_progressResult(mp, MP_ID_BLOCK, DEBUG_EQUAL | DEBUG_LEVEL_3, res);
-	print_progressResult(mp, MP_ID_BLOCK, DEBUG_EQUAL | DEBUG_LEVEL_2, res);
-	LOGKSI_freeAndClearInternals(blocks);
-	KSI_DataHash_free(theFirstInputHashInFile);
-	KSI_OctetString_free(seed);
+	res = SMART_FILE_copyRange(in, copyFrom, pos - copyFrom, out, NULL);
+	ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to copy block data to output log signature file.", logksi->blockNo);
 
-	KSI_DataHash_free(recordHash);
+	res = KT_OK;
+
+cleanup:
 
 	return res;
 }
@@ -1318,6 +3456,13 @@ static int skip_current_block_as_it_does_not_verify(LOGKSI *logksi, MULTI_PRINTE
 				print_debug_mp(mp, MP_ID_BLOCK, DEBUG_LEVEL_3, "Block no. %3zu: Skipping %zu log lines.\n", logksi->blockNo, logLinesToSkip);
 
 				for (i = 0; i < logLinesToSkip; i++) {
+					if (logksi->logLinePipeline != NULL) {
+						res = LOGLINE_PIPELINE_nextLine(logksi->logLinePipeline, logksi, files->files.inLog, logksi->block.hashAlgo, NULL);
+						if (res == KT_UNEXPECTED_EOF) break;
+						if (res != KT_OK) goto cleanup;
+						continue;
+					}
+
 					do {
 						res = SMART_FILE_readLine(files->files.inLog, buf, sizeof(buf), NULL);
 						if (res != SMART_FILE_OK && res != SMART_FILE_NO_EOL) goto cleanup;
@@ -1364,6 +3509,277 @@ static int wrapper_LOGKSI_createSignature(PARAM_SET *set, MULTI_PRINTER *mp, ERR
 	return res;
 }
 
+/* SIGNING_FUNCTION implementation that takes the signatures created by presign_unsigned_blocks. */
+static int presigned_LOGKSI_createSignature(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *logksi, IO_FILES *files, KSI_DataHash *hash, KSI_uint64_t rootLevel, KSI_Signature **sig) {
+	size_t i = 0;
+	KSI_DataHash *docHash = NULL;
+
+	if (set == NULL || err == NULL || ksi == NULL || logksi == NULL || files == NULL || hash == NULL || sig == NULL || logksi->task.sign.noSigNo == 0) {
+		return KT_INVALID_ARGUMENT;
+	}
+
+	i = logksi->task.sign.noSigNo - 1;
+
+	/* Signature that does not sign the root hash of this block is not used. */
+	if (i < logksi->task.sign.preSigned_count && logksi->task.sign.preSigned[i] != NULL) {
+		if (KSI_Signature_getDocumentHash(logksi->task.sign.preSigned[i], &docHash) != KSI_OK || !KSI_DataHash_equals(docHash, hash)) {
+			KSI_Signature_free(logksi->task.sign.preSigned[i]);
+			logksi->task.sign.preSigned[i] = NULL;
+		}
+	}
+
+	/* If the signature is not available, retry with a single request to report the error. */
+	if (i >= logksi->task.sign.preSigned_count || logksi->task.sign.preSigned[i] == NULL) {
+		return wrapper_LOGKSI_createSignature(set, mp, err, ksi, logksi, files, hash, rootLevel, sig);
+	}
+
+	print_progressDesc(mp, MP_ID_BLOCK, 1, DEBUG_EQUAL | DEBUG_LEVEL_2, "Signing Block no. %3zu... ", logksi->blockNo);
+	*sig = logksi->task.sign.preSigned[i];
+	logksi->task.sign.preSigned[i] = NULL;
+	print_progressResult(mp, MP_ID_BLOCK, DEBUG_EQUAL | DEBUG_LEVEL_2, KT_OK);
+
+	return KT_OK;
+}
+
+static void sign_batch_free(void *obj) {
+	SIGN_BATCH_free((SIGN_BATCH*)obj);
+}
+
+static int presign_store_signature(KSI_CTX *ksi, LOGKSI *logksi, SIGN_QUEUE *queue, size_t *count) {
+	int res = KT_UNKNOWN_ERROR;
+	void *ctx = NULL;
+	KSI_Signature *sig = NULL;
+	SIGN_BATCH *batch = NULL;
+	int error = KT_OK;
+	size_t i;
+
+	/* Responses are returned in the same order as requests were added. */
+	res = SIGN_QUEUE_getNext(queue, 1, &ctx, &sig, &error);
+	if (res != KT_OK) goto cleanup;
+
+	batch = ctx;
+
+	for (i = 0; i < SIGN_BATCH_getCount(batch); i++) {
+		KSI_Signature *blockSig = NULL;
+
+		/* If the signature of a block can not be created, it is left NULL and retried later. */
+		if (sig != NULL && SIGN_BATCH_createSignature(batch, ksi, sig, i, &blockSig) != KT_OK) {
+			blockSig = NULL;
+		}
+
+		logksi->task.sign.preSigned[(*count)++] = blockSig;
+	}
+
+	res = KT_OK;
+
+cleanup:
+
+	SIGN_BATCH_free(batch);
+	KSI_Signature_free(sig);
+
+	return res;
+}
+
+/**
+ * Aggregates the root hashes in the batch locally and adds the root of the batch
+ * to the signing queue. The ownership of the batch is passed to the queue. If the
+ * root of the batch can not be calculated, the blocks are left unsigned and are
+ * retried with a single request each during the rewrite.
+ */
+static int presign_add_batch(ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *logksi, SIGN_QUEUE *queue, SIGN_BATCH *batch, KSI_HashAlgorithm algo, size_t *count) {
+	int res = KT_UNKNOWN_ERROR;
+	KSI_DataHash *root = NULL;
+	KSI_uint64_t rootLevel = 0;
+
+	if (SIGN_QUEUE_isFull(queue)) {
+		res = presign_store_signature(ksi, logksi, queue, count);
+		ERR_CATCH_MSG(err, res, "Error: Unable to get response from signing queue.");
+	}
+
+	res = SIGN_BATCH_calculateRoot(batch, ksi, algo, &root, &rootLevel);
+	if (res != KT_OK) {
+		/* Keep the order of the signatures. */
+		while (SIGN_QUEUE_getCount(queue) > 0) {
+			res = presign_store_signature(ksi, logksi, queue, count);
+			ERR_CATCH_MSG(err, res, "Error: Unable to get response from signing queue.");
+		}
+
+		*count += SIGN_BATCH_getCount(batch);
+		res = KT_OK;
+		goto cleanup;
+	}
+
+	res = SIGN_QUEUE_add(queue, root, rootLevel, batch, sign_batch_free);
+	ERR_CATCH_MSG(err, res, "Error: Unable to add root hash to signing queue.");
+	batch = NULL;
+
+	res = KT_OK;
+
+cleanup:
+
+	SIGN_BATCH_free(batch);
+	KSI_DataHash_free(root);
+
+	return res;
+}
+
+/**
+ * Collects the root hashes of all unsigned blocks from the log signature file and
+ * signs them with concurrent requests. Up to batchSize root hashes are aggregated
+ * locally and only the root of the batch is sent to the aggregator. At most
+ * maxRequests requests are pending at once, but no more than advertised by the
+ * aggregator configuration. Signatures are
+ * stored in logksi->task.sign.preSigned. Failed requests are left NULL and are retried
+ * with a single request during the rewrite. On return the input file is positioned
+ * right after the magic number.
+ */
+static int presign_unsigned_blocks(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *logksi, SMART_FILE *in, size_t maxRequests, size_t batchSize) {
+	int res = KT_UNKNOWN_ERROR;
+	KSI_Config *config = NULL;
+	KSI_Integer *confMaxRequests = NULL;
+	SIGN_QUEUE *queue = NULL;
+	SIGN_BATCH *batch = NULL;
+	KSI_HashAlgorithm batchAlgo = KSI_HASHALG_INVALID_VALUE;
+	KSI_TlvElement *tlv = NULL;
+	KSI_TlvElement *tlvNoSig = NULL;
+	KSI_DataHash *hash = NULL;
+	size_t blockNo = 0;
+	size_t capacity = 0;
+	size_t count = 0;
+	size_t signedCount = 0;
+	unsigned char magic[MAGIC_SIZE];
+
+	if (set == NULL || err == NULL || ksi == NULL || logksi == NULL || in == NULL || maxRequests == 0 || batchSize == 0) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	/* Aggregator configuration is optional. */
+	if (KSI_receiveAggregatorConfig(ksi, &config) == KSI_OK && KSI_Config_getMaxRequests(config, &confMaxRequests) == KSI_OK && confMaxRequests != NULL) {
+		size_t confMax = (size_t)KSI_Integer_getUInt64(confMaxRequests);
+		if (confMax > 0 && confMax < maxRequests) maxRequests = confMax;
+	}
+
+	res = TOOL_newSignQueue(set, err, ksi, maxRequests, &queue);
+	if (res != KT_OK) goto cleanup;
+
+	/* Start from the first block in the file. */
+	res = SMART_FILE_rewind(in);
+	ERR_CATCH_MSG(err, res, "Error: Unable to rewind log signature file.");
+
+	res = SMART_FILE_read(in, magic, MAGIC_SIZE, NULL);
+	ERR_CATCH_MSG(err, res, "Error: Unable to read log signature file.");
+
+	print_progressDesc(mp, MP_ID_BLOCK, 0, DEBUG_LEVEL_2, "Signing unsigned blocks with up to %zu concurrent requests and %zu blocks per request... ", maxRequests, batchSize);
+
+	while (!SMART_FILE_isEof(in)) {
+		res = LOGKSI_FTLV_smartFileRead(in, logksi->ftlv_raw, SOF_FTLV_BUFFER, &logksi->ftlv_len, &logksi->ftlv);
+		if (res != KSI_OK) {
+			if (logksi->ftlv_len > 0) {
+				res = KT_INVALID_INPUT_FORMAT;
+				ERR_CATCH_MSG(err, res, "Error: Block no. %zu: incomplete data found in log signature file.", blockNo);
+			}
+			break;
+		}
+
+		if (logksi->ftlv.tag == 0x901) {
+			blockNo++;
+		} else if (logksi->ftlv.tag == 0x904) {
+			res = tlv_element_parse_and_check_sub_elements(err, ksi, logksi->ftlv_raw, logksi->ftlv_len, logksi->ftlv.hdr_len, &tlv);
+			ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to parse block signature as TLV element.", blockNo);
+
+			res = KSI_TlvElement_getElement(tlv, 0x02, &tlvNoSig);
+			ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to extract 'no-sig' element in signatures file.", blockNo);
+
+			if (tlvNoSig != NULL) {
+				/* Record count is needed to calculate the aggregation level. */
+				res = tlv_element_get_uint(tlv, ksi, 0x01, &logksi->block.recordCount);
+				ERR_CATCH_MSG(err, res, "Error: Block no. %zu: missing record count in signatures file.", blockNo);
+
+				res = tlv_element_get_hash(err, tlvNoSig, ksi, 0x01, &hash);
+				ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to parse root hash.", blockNo);
+
+				if (count == capacity) {
+					KSI_Signature **tmp = NULL;
+					size_t newCapacity = capacity == 0 ? 64 : capacity * 2;
+
+					tmp = (KSI_Signature**)realloc(logksi->task.sign.preSigned, newCapacity * sizeof(KSI_Signature*));
+					if (tmp == NULL) {
+						res = KT_OUT_OF_MEMORY;
+						goto cleanup;
+					}
+
+					logksi->task.sign.preSigned = tmp;
+					capacity = newCapacity;
+				}
+
+				logksi->task.sign.preSigned[count++] = NULL;
+				logksi->task.sign.preSigned_count = count;
+
+				if (batch == NULL) {
+					res = SIGN_BATCH_new(batchSize, &batch);
+					ERR_CATCH_MSG(err, res, "Error: Unable to create signing batch.");
+
+					res = KSI_DataHash_getHashAlg(hash, &batchAlgo);
+					ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to get hash algorithm of root hash.", blockNo);
+				}
+
+				res = SIGN_BATCH_add(batch, hash, LOGKSI_get_aggregation_level(logksi), NULL, NULL);
+				ERR_CATCH_MSG(err, res, "Error: Block no. %zu: unable to add root hash to signing batch.", blockNo);
+
+				if (SIGN_BATCH_isFull(batch)) {
+					res = presign_add_batch(err, ksi, logksi, queue, batch, batchAlgo, &signedCount);
+					batch = NULL;
+					if (res != KT_OK) goto cleanup;
+				}
+
+				KSI_DataHash_free(hash);
+				hash = NULL;
+			}
+
+			KSI_TlvElement_free(tlvNoSig);
+			tlvNoSig = NULL;
+			KSI_TlvElement_free(tlv);
+			tlv = NULL;
+		}
+	}
+
+	if (batch != NULL) {
+		res = presign_add_batch(err, ksi, logksi, queue, batch, batchAlgo, &signedCount);
+		batch = NULL;
+		if (res != KT_OK) goto cleanup;
+	}
+
+	while (SIGN_QUEUE_getCount(queue) > 0) {
+		res = presign_store_signature(ksi, logksi, queue, &signedCount);
+		ERR_CATCH_MSG(err, res, "Error: Unable to get response from signing queue.");
+	}
+
+	print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_2, KT_OK);
+	MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
+
+	logksi->block.recordCount = 0;
+
+	res = SMART_FILE_rewind(in);
+	ERR_CATCH_MSG(err, res, "Error: Unable to rewind log signature file.");
+
+	res = SMART_FILE_read(in, magic, MAGIC_SIZE, NULL);
+	ERR_CATCH_MSG(err, res, "Error: Unable to read log signature file.");
+
+	res = KT_OK;
+
+cleanup:
+
+	SIGN_QUEUE_free(queue);
+	SIGN_BATCH_free(batch);
+	KSI_Config_free(config);
+	KSI_TlvElement_free(tlvNoSig);
+	KSI_TlvElement_free(tlv);
+	KSI_DataHash_free(hash);
+
+	return res;
+}
+
 static int logksi_set_extract_record(LOGKSI *logksi, RECORD_INFO *recordInfo, int isMetaRecordHash, KSI_DataHash *hash) {
 	int res = KT_UNKNOWN_ERROR;
 	KSI_DataHash *hashRef = NULL;
@@ -1390,7 +3806,12 @@ static int logksi_set_extract_record(LOGKSI *logksi, RECORD_INFO *recordInfo, in
 		if (res != KT_OK) goto cleanup;
 		hashRef = NULL;
 	} else {
-		res = KSI_strdup(logksi->logLine, &logLineCopy);
+		const char *logLine = NULL;
+
+		res = LOGKSI_getLine(logksi, &logLine);
+		if (res != KT_OK) goto cleanup;
+
+		res = KSI_strdup(logLine, &logLineCopy);
 		if (res != KT_OK) goto cleanup;
 
 		res = RECORD_INFO_setRecordHash(recordInfo,
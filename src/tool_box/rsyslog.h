@@ -25,19 +25,99 @@
 #include "io_files.h"
 #include "err_trckr.h"
 #include "logksi.h"
+#include "block_index.h"
+#include "verify_ledger.h"
+#include "log_follow.h"
+#include "extend_cache.h"
 
 #define SOF_FTLV_BUFFER (0xffff + 4)
 
-#define META_DATA_BLOCK_CLOSE_REASON "com.guardtime.blockCloseReason"
-
 typedef int (*EXTENDING_FUNCTION)(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *blocks, IO_FILES *files, KSI_Signature *sig,  KSI_PublicationsFile *pubFile, KSI_VerificationContext *context, KSI_Signature **ext);
 typedef int (*VERIFYING_FUNCTION)(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *blocks, IO_FILES *files, KSI_Signature *sig, KSI_DataHash *hash, KSI_uint64_t rootLevel, KSI_PolicyVerificationResult **verificationResult);
 typedef int (*SIGNING_FUNCTION)(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *blocks, IO_FILES *files, KSI_DataHash *hash, KSI_uint64_t rootLevel, KSI_Signature **sig);
 
+/**
+ * Values at the edges of a log signature file (or of a range of its blocks) that are needed
+ * to check the file against the previous log signature file (or the range against the
+ * previous blocks), when the files or the blocks are not verified one after another (see
+ * verify --jobs). Imprints are empty if not available (e.g. excerpt file). Times are 0 if
+ * not available. File offsets are set only for a range of blocks.
+ */
+typedef struct LOGSIG_EDGES_st {
+	unsigned char firstInputHash[KSI_MAX_IMPRINT_LEN];	/* Imprint of the input hash of the first block. */
+	size_t firstInputHash_len;
+	unsigned char lastLeaf[KSI_MAX_IMPRINT_LEN];		/* Imprint of the last leaf of the last block. */
+	size_t lastLeaf_len;
+	uint64_t sigTimeFirst;								/* Signing time of the first block. */
+	uint64_t sigTimeLast;								/* Signing time of the last block. */
+	uint64_t recTimeFirst;								/* The lowest record time in the first block. */
+	uint64_t recTimeLast;								/* The highest record time in the last block. */
+	uint64_t recTimeMin;								/* The lowest record time in all the blocks. */
+	uint64_t recTimeMax;								/* The highest record time in all the blocks. */
+	size_t firstBlockNo;								/* Number of the first block. */
+	size_t lastBlockNo;									/* Number of the last block. */
+	size_t startSigOffset;								/* Offset of the header of the first block in the log signature file. */
+	size_t endSigOffset;								/* Offset in the log signature file where the last block ends. */
+	size_t startLogOffset;								/* Offset of the first line of the first block in the log file. */
+	size_t endLogOffset;								/* Offset in the log file after the last line of the last block. */
+} LOGSIG_EDGES;
+
+int logsignature_extend(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, KSI_PublicationsFile* pubFile, EXTENDING_FUNCTION extend_signature, IO_FILES *files, EXTEND_CACHE *cache);
+int logsignature_verify(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *blocks, KSI_DataHash *firstLink, VERIFYING_FUNCTION verify_signature, IO_FILES *files, VERIFY_LEDGER *ledger, KSI_DataHash **lastLeaf, uint64_t* last_rec_time, LOGSIG_EDGES *edges);
+
+/**
+ * Checks the log signature file (files->internal.inLog) against the previous one (files->previousLogFile)
+ * using the values collected by #logsignature_verify: inter-linking input hash, signing times of
+ * the last and the first block and record times of the last and the first block. These are the
+ * checks that are done with the first block of the file when log files are verified one after
+ * another. If \c prev has no last leaf, the inter-linking is not checked.
+ */
+int logsignature_verify_between_files(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGSIG_EDGES *prev, LOGSIG_EDGES *current, IO_FILES *files);
+
+/**
+ * Checks a range of blocks of the log signature file against the previous blocks of the same
+ * file, when the ranges of blocks are verified on their own (see verify --jobs), using the
+ * values collected by #logsignature_verify: the offsets where the previous range ends against
+ * the offsets where the range starts (both in the log signature file and in the log file, as
+ * the offsets of the block index are not trusted), the last leaf of the previous block against
+ * the input hash of the first block of the range, the signing times of the previous block and
+ * the first block of the range and the highest record time of all the previous blocks (\c prev
+ * must hold the highest value of all the previous ranges) against the records of the range.
+ * These are the checks that are done with the first block of the range when the blocks are
+ * verified one after another. For the range starting from the first block, \c prev may hold the
+ * input hash from --input-hash as the last leaf. The last range is checked to reach the end of
+ * both files by #logsignature_verify itself.
+ */
+int logsignature_verify_between_blocks(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGSIG_EDGES *prev, LOGSIG_EDGES *current, IO_FILES *files);
 
-int logsignature_extend(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, KSI_PublicationsFile* pubFile, EXTENDING_FUNCTION extend_signature, IO_FILES *files);
-int logsignature_verify(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *blocks, KSI_DataHash *firstLink, VERIFYING_FUNCTION verify_signature, IO_FILES *files, KSI_DataHash **lastLeaf, uint64_t* last_rec_time);
+/**
+ * Reads the block index of the log signature file (files->files.inSig) for verifying the
+ * ranges of its blocks on their own (see verify --jobs). The index is read from the block
+ * index file or built from the block headers and block signatures and the log file offsets
+ * of the blocks are found by counting the lines of the log file (files->files.inLog). For
+ * excerpt files and when any of the input files is read from stdin, \c index is set to NULL.
+ */
+int logsignature_verify_scan(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, IO_FILES *files, BLOCK_INDEX **index);
 int logsignature_extract(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, IO_FILES *files);
 int logsignature_integrate(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI* blocks, IO_FILES *files);
 int logsignature_sign(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, IO_FILES *files);
-int logsignature_create(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *blocks, IO_FILES *files, KSI_HashAlgorithm aggrAlgo, STATE_FILE *state);
+
+/**
+ * Inter-linking of log signature files that are created at the same time (see create --jobs).
+ * The input hash of the first block is read from the pipe \c in after the first log lines are
+ * read ahead, instead of taking it from the state. The last leaf is written into the pipe \c out
+ * as soon as the last block is closed, before the blocks are signed. Value -1 disables the pipe.
+ */
+typedef struct LOGSIG_LINK_st {
+	int in;
+	int out;
+} LOGSIG_LINK;
+
+int logsignature_create(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, LOGKSI *blocks, IO_FILES *files, KSI_HashAlgorithm aggrAlgo, STATE_FILE *state, LOG_FOLLOW *follow, LOGSIG_LINK *sigLink);
+
+/**
+ * Builds the block index of the log signature file (files->files.inSig) without verifying
+ * it. If the log file (files->files.inLog) is open, the log file offsets of the blocks are
+ * found by counting the lines of the log file.
+ */
+int logsignature_index(PARAM_SET *set, MULTI_PRINTER* mp, ERR_TRCKR *err, KSI_CTX *ksi, IO_FILES *files, BLOCK_INDEX **index);
@@ -54,7 +54,7 @@ static int open_input_and_output_files(PARAM_SET *set, ERR_TRCKR *err, IO_FILES
 static int rename_temporary_and_backup_files(ERR_TRCKR *err, IO_FILES *files);
 static void close_input_and_output_files(ERR_TRCKR *err, int res, IO_FILES *files);
 
-#define PARAMS "{input}{o}{sig-from-stdin}{insert-missing-hashes}{d}{show-progress}{log}{conf}{h|help}{continue-on-fail}{hex-to-str}"
+#define PARAMS "{input}{o}{sig-from-stdin}{insert-missing-hashes}{d}{show-progress}{log}{conf}{h|help}{continue-on-fail}{hex-to-str}{max-requests}{batch-size}{write-index}"
 
 int sign_run(int argc, char** argv, char **envp) {
 	int res;
@@ -174,6 +174,9 @@ char *sign_help_toString(char*buf, size_t len) {
 	PARAM_SET_setHelpText(set, "sig-from-stdin", NULL, "The log signature file is read from stdin.");
 	PARAM_SET_setHelpText(set, "o", "<out.logsig>", "Name of the signed output log signature file. An existing log signature file is overwritten. If not specified, the log signature is saved to '<logfile>.logsig' while a backup of '<logfile>.logsig' is saved in '<logfile>.logsig.bak'. Use '-' to redirect the signed log signature binary stream to stdout. If input is read from stdin and output is not specified, stdout is used for output.");
 	PARAM_SET_setHelpText(set, "continue-on-fail", NULL, "This option can be used to continue signing in case of signing error. Other errors (e.g. verification error) will terminated the process.");
+	PARAM_SET_setHelpText(set, "max-requests", "<int>", "Collect the root hashes of all unsigned blocks first and sign them with up to <int> concurrent requests before the log signature is rewritten. The count is also limited by the maximum requests advertised by the aggregator configuration. Can not be used to collect unsigned blocks from stdin, in that case blocks are signed one by one.");
+	PARAM_SET_setHelpText(set, "batch-size", "<int>", "Collect the root hashes of all unsigned blocks first and aggregate up to <int> root hashes locally into a single signing request. The signature of every block is created from the signature of the local aggregation root. Can be combined with '--max-requests'. Can not be used to collect unsigned blocks from stdin.");
+	PARAM_SET_setHelpText(set, "write-index", NULL, "Write a block index file next to the output log signature file as '<out.logsig>.idx'. The index contains the positions of the blocks in the log signature file and makes it possible to access a block without reading the file from the beginning. The index is always updated if it already exists. See 'logksi index' to create the index for an existing log signature file.");
 	PARAM_SET_setHelpText(set, "d", NULL, "Print detailed information about processes and errors to stderr. To make output more verbose use -dd or -ddd.");
 	PARAM_SET_setHelpText(set, "show-progress", NULL, "Print signing progress. Only valid with '-d' and debug level 1.");
 	PARAM_SET_setHelpText(set, "conf", "<file>", "Read configuration options from the given file. It must be noted that configuration options given explicitly on command line will override the ones in the configuration file.");
@@ -187,7 +190,7 @@ char *sign_help_toString(char*buf, size_t len) {
 		"logksi sign --sig-from-stdin [-o <out.logsig>] -S <URL> [--aggr-user <user> --aggr-key <key>] [more_options]"
 		"\\>\n\n\n");
 
-	ret = PARAM_SET_helpToString(set, "input,sig-from-stdin,o,S,aggr-user,aggr-key,aggr-hmac-alg,continue-on-fail,d,show-progress,conf,log", 1, 13, 80, buf + count, len - count);
+	ret = PARAM_SET_helpToString(set, "input,sig-from-stdin,o,S,aggr-user,aggr-key,aggr-hmac-alg,continue-on-fail,max-requests,batch-size,write-index,d,show-progress,conf,log", 1, 13, 80, buf + count, len - count);
 
 cleanup:
 	if (res != PST_OK || ret == NULL) {
@@ -218,12 +221,14 @@ static int generate_tasks_set(PARAM_SET *set, TASK_SET *task_set) {
 	PARAM_SET_addControl(set, "{conf}", isFormatOk_inputFile, isContentOk_inputFileRestrictPipe, convertRepair_path, NULL);
 	PARAM_SET_addControl(set, "{o}{log}", isFormatOk_path, NULL, convertRepair_path, NULL);
 	PARAM_SET_addControl(set, "{input}", isFormatOk_path, NULL, convertRepair_path, NULL);
-	PARAM_SET_addControl(set, "{sig-from-stdin}{insert-missing-hashes}{d}{show-progress}{continue-on-fail}{hex-to-str}", isFormatOk_flag, NULL, NULL, NULL);
+	PARAM_SET_addControl(set, "{sig-from-stdin}{insert-missing-hashes}{d}{show-progress}{continue-on-fail}{hex-to-str}{write-index}", isFormatOk_flag, NULL, NULL, NULL);
+	PARAM_SET_addControl(set, "{max-requests}{batch-size}", isFormatOk_int, isContentOk_uint_not_zero, NULL, extract_uint);
 
 
 	PARAM_SET_setParseOptions(set, "input", PST_PRSCMD_COLLECT_LOOSE_VALUES | PST_PRSCMD_HAS_NO_FLAG | PST_PRSCMD_NO_TYPOS);
 	PARAM_SET_setParseOptions(set, "d,h", PST_PRSCMD_HAS_NO_VALUE | PST_PRSCMD_NO_TYPOS);
-	PARAM_SET_setParseOptions(set, "sig-from-stdin,insert-missing-hashes,show-progress,continue-on-fail,hex-to-str", PST_PRSCMD_HAS_NO_VALUE);
+	PARAM_SET_setParseOptions(set, "sig-from-stdin,insert-missing-hashes,show-progress,continue-on-fail,hex-to-str,write-index", PST_PRSCMD_HAS_NO_VALUE);
+	PARAM_SET_setParseOptions(set, "max-requests,batch-size", PST_PRSCMD_HAS_VALUE);
 
 	/*					  ID	DESC										MAN					ATL		FORBIDDEN		IGN	*/
 	TASK_SET_add(task_set, 0,	"Sign data from file.",						"input,S",			NULL,	"sig-from-stdin",			NULL);
@@ -0,0 +1,424 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <ksi/ksi.h>
+#include "logksi_err.h"
+#include "merkle_tree.h"
+#include "hash_batch.h"
+#include "sign_batch.h"
+
+/* Imprints of two child nodes and the level byte. */
+#define SIGN_BATCH_NODE_DATA_SIZE (2 * KSI_MAX_IMPRINT_LEN + 1)
+
+typedef struct SIGN_BATCH_LINK_st {
+	KSI_DataHash *sibling;
+	int isLeft;
+	KSI_uint64_t corr;
+} SIGN_BATCH_LINK;
+
+typedef struct SIGN_BATCH_ITEM_st {
+	KSI_DataHash *hash;
+	KSI_uint64_t level;
+	void *ctx;
+	void (*ctx_free)(void*);
+	SIGN_BATCH_LINK chain[MAX_TREE_HEIGHT];	/* Local aggregation hash chain from the hash to the batch root. */
+	size_t chain_len;
+} SIGN_BATCH_ITEM;
+
+/* Root of a subtree that covers items [first, last). */
+typedef struct SIGN_BATCH_NODE_st {
+	KSI_DataHash *hash;
+	KSI_uint64_t level;
+	size_t first;
+	size_t last;
+} SIGN_BATCH_NODE;
+
+struct SIGN_BATCH_st {
+	SIGN_BATCH_ITEM *items;
+	size_t capacity;
+	size_t count;
+	KSI_HashAlgorithm algo;
+	KSI_DataHash *root;
+};
+
+static void sign_batch_clean_chain(SIGN_BATCH_ITEM *item) {
+	size_t i;
+
+	for (i = 0; i < item->chain_len; i++) {
+		KSI_DataHash_free(item->chain[i].sibling);
+		item->chain[i].sibling = NULL;
+	}
+
+	item->chain_len = 0;
+}
+
+static int sign_batch_add_link(SIGN_BATCH *batch, SIGN_BATCH_NODE *node, KSI_DataHash *sibling, int isLeft, KSI_uint64_t level) {
+	size_t i;
+
+	for (i = node->first; i < node->last; i++) {
+		SIGN_BATCH_ITEM *item = &batch->items[i];
+
+		if (item->chain_len >= MAX_TREE_HEIGHT) return KT_TREE_LEVEL_OVF;
+
+		item->chain[item->chain_len].sibling = KSI_DataHash_ref(sibling);
+		item->chain[item->chain_len].isLeft = isLeft;
+		item->chain[item->chain_len].corr = level - node->level - 1;
+		item->chain_len++;
+	}
+
+	return KT_OK;
+}
+
+/* Tree node hash is calculated over the imprints of the children and the level of the node (see MERKLE_TREE_calculateTreeHash). */
+static int sign_batch_node_data(SIGN_BATCH_NODE *left, SIGN_BATCH_NODE *right, unsigned char *buf, size_t *buf_len) {
+	int res = KT_UNKNOWN_ERROR;
+	const unsigned char *imprint = NULL;
+	size_t imprint_len = 0;
+	size_t len = 0;
+	KSI_uint64_t level = (left->level > right->level ? left->level : right->level) + 1;
+
+	if (level > MAX_TREE_HEIGHT) return KT_TREE_LEVEL_OVF;
+
+	res = KSI_DataHash_getImprint(left->hash, &imprint, &imprint_len);
+	if (res != KSI_OK) return res;
+	if (imprint_len > KSI_MAX_IMPRINT_LEN) return KT_INVALID_INPUT_FORMAT;
+	memcpy(buf + len, imprint, imprint_len);
+	len += imprint_len;
+
+	res = KSI_DataHash_getImprint(right->hash, &imprint, &imprint_len);
+	if (res != KSI_OK) return res;
+	if (imprint_len > KSI_MAX_IMPRINT_LEN) return KT_INVALID_INPUT_FORMAT;
+	memcpy(buf + len, imprint, imprint_len);
+	len += imprint_len;
+
+	buf[len++] = (unsigned char)level;
+	*buf_len = len;
+
+	return KT_OK;
+}
+
+int SIGN_BATCH_new(size_t maxSize, SIGN_BATCH **batch) {
+	int res = KT_UNKNOWN_ERROR;
+	SIGN_BATCH *tmp = NULL;
+
+	if (maxSize == 0 || batch == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	tmp = (SIGN_BATCH*)malloc(sizeof(SIGN_BATCH));
+	if (tmp == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	tmp->items = NULL;
+	tmp->capacity = maxSize;
+	tmp->count = 0;
+	tmp->algo = KSI_HASHALG_INVALID_VALUE;
+	tmp->root = NULL;
+
+	tmp->items = (SIGN_BATCH_ITEM*)calloc(maxSize, sizeof(SIGN_BATCH_ITEM));
+	if (tmp->items == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	*batch = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	SIGN_BATCH_free(tmp);
+
+	return res;
+}
+
+void SIGN_BATCH_free(SIGN_BATCH *batch) {
+	size_t i;
+
+	if (batch == NULL) return;
+
+	for (i = 0; i < batch->count; i++) {
+		SIGN_BATCH_ITEM *item = &batch->items[i];
+
+		sign_batch_clean_chain(item);
+		KSI_DataHash_free(item->hash);
+		if (item->ctx_free != NULL) item->ctx_free(item->ctx);
+	}
+
+	KSI_DataHash_free(batch->root);
+	free(batch->items);
+	free(batch);
+}
+
+int SIGN_BATCH_add(SIGN_BATCH *batch, KSI_DataHash *hash, KSI_uint64_t level, void *ctx, void (*ctx_free)(void*)) {
+	SIGN_BATCH_ITEM *item = NULL;
+
+	if (batch == NULL || hash == NULL) return KT_INVALID_ARGUMENT;
+	if (SIGN_BATCH_isFull(batch)) return KT_INDEX_OVF;
+
+	item = &batch->items[batch->count];
+	item->hash = KSI_DataHash_ref(hash);
+	item->level = level;
+	item->ctx = ctx;
+	item->ctx_free = ctx_free;
+	item->chain_len = 0;
+	batch->count++;
+
+	return KT_OK;
+}
+
+int SIGN_BATCH_calculateRoot(SIGN_BATCH *batch, KSI_CTX *ksi, KSI_HashAlgorithm algo, KSI_DataHash **root, KSI_uint64_t *rootLevel) {
+	int res = KT_UNKNOWN_ERROR;
+	HASH_BATCH *hasher = NULL;
+	SIGN_BATCH_NODE *nodes = NULL;
+	unsigned char *buf = NULL;
+	const unsigned char **data = NULL;
+	size_t *data_len = NULL;
+	KSI_DataHash **hashes = NULL;
+	size_t nofNodes = 0;
+	size_t nofPairs = 0;
+	size_t i;
+
+	if (batch == NULL || ksi == NULL || batch->count == 0 || root == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	res = HASH_BATCH_new(ksi, &hasher);
+	if (res != KT_OK) goto cleanup;
+
+	nodes = (SIGN_BATCH_NODE*)malloc(batch->count * sizeof(SIGN_BATCH_NODE));
+	buf = (unsigned char*)malloc((batch->count / 2 + 1) * SIGN_BATCH_NODE_DATA_SIZE);
+	data = (const unsigned char**)malloc((batch->count / 2 + 1) * sizeof(const unsigned char*));
+	data_len = (size_t*)malloc((batch->count / 2 + 1) * sizeof(size_t));
+	hashes = (KSI_DataHash**)calloc(batch->count / 2 + 1, sizeof(KSI_DataHash*));
+	if (nodes == NULL || buf == NULL || data == NULL || data_len == NULL || hashes == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	KSI_DataHash_free(batch->root);
+	batch->root = NULL;
+
+	for (i = 0; i < batch->count; i++) {
+		sign_batch_clean_chain(&batch->items[i]);
+
+		nodes[i].hash = KSI_DataHash_ref(batch->items[i].hash);
+		nodes[i].level = batch->items[i].level;
+		nodes[i].first = i;
+		nodes[i].last = i + 1;
+	}
+	nofNodes = batch->count;
+
+	/* Aggregate neighbouring subtrees until a single root remains. */
+	while (nofNodes > 1) {
+		size_t n = 0;
+
+		nofPairs = nofNodes / 2;
+
+		/* Hashes of the same tree level are independent and are calculated at once. */
+		for (i = 0; i < nofPairs; i++) {
+			data[i] = buf + i * SIGN_BATCH_NODE_DATA_SIZE;
+
+			res = sign_batch_node_data(&nodes[2 * i], &nodes[2 * i + 1], buf + i * SIGN_BATCH_NODE_DATA_SIZE, &data_len[i]);
+			if (res != KT_OK) goto cleanup;
+		}
+
+		res = HASH_BATCH_calculate(hasher, algo, data, data_len, nofPairs, hashes);
+		if (res != KT_OK) goto cleanup;
+
+		for (i = 0; i < nofPairs; i++) {
+			SIGN_BATCH_NODE *left = &nodes[2 * i];
+			SIGN_BATCH_NODE *right = &nodes[2 * i + 1];
+			KSI_uint64_t level = (left->level > right->level ? left->level : right->level) + 1;
+
+			res = sign_batch_add_link(batch, left, right->hash, 1, level);
+			if (res != KT_OK) goto cleanup;
+
+			res = sign_batch_add_link(batch, right, left->hash, 0, level);
+			if (res != KT_OK) goto cleanup;
+
+			KSI_DataHash_free(left->hash);
+			KSI_DataHash_free(right->hash);
+			left->hash = NULL;
+			right->hash = NULL;
+
+			nodes[n].hash = hashes[i];
+			nodes[n].level = level;
+			nodes[n].first = left->first;
+			nodes[n].last = right->last;
+			hashes[i] = NULL;
+			n++;
+		}
+
+		/* Odd subtree is moved to the next level as it is. */
+		if (2 * nofPairs < nofNodes) {
+			nodes[n++] = nodes[2 * nofPairs];
+		}
+
+		nofNodes = n;
+	}
+
+	batch->algo = algo;
+	batch->root = KSI_DataHash_ref(nodes[0].hash);
+
+	*root = nodes[0].hash;
+	if (rootLevel != NULL) *rootLevel = nodes[0].level;
+	nodes[0].hash = NULL;
+	nofNodes = 0;
+	res = KT_OK;
+
+cleanup:
+
+	if (nodes != NULL) {
+		for (i = 0; i < nofNodes; i++) {
+			KSI_DataHash_free(nodes[i].hash);
+		}
+	}
+
+	if (hashes != NULL) {
+		for (i = 0; i < nofPairs; i++) {
+			KSI_DataHash_free(hashes[i]);
+		}
+	}
+
+	free(nodes);
+	free(buf);
+	free((void*)data);
+	free(data_len);
+	free(hashes);
+	HASH_BATCH_free(hasher);
+
+	return res;
+}
+
+int SIGN_BATCH_createSignature(SIGN_BATCH *batch, KSI_CTX *ksi, const KSI_Signature *batchSig, size_t i, KSI_Signature **sig) {
+	int res = KT_UNKNOWN_ERROR;
+	SIGN_BATCH_ITEM *item = NULL;
+	KSI_HashChainLinkList *chainList = NULL;
+	KSI_HashChainLink *link = NULL;
+	KSI_AggregationHashChain *aggrChain = NULL;
+	KSI_SignatureBuilder *builder = NULL;
+	KSI_Integer *lvlcrct = NULL;
+	KSI_Integer *hashId = NULL;
+	KSI_Signature *tmp = NULL;
+	size_t j;
+
+	if (batch == NULL || ksi == NULL || batchSig == NULL || i >= batch->count || sig == NULL || batch->root == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	item = &batch->items[i];
+
+	/* A batch of a single hash is signed as it is. */
+	if (item->chain_len == 0) {
+		res = KSI_Signature_clone(batchSig, &tmp);
+		if (res != KSI_OK) goto cleanup;
+
+		*sig = tmp;
+		tmp = NULL;
+		res = KT_OK;
+		goto cleanup;
+	}
+
+	res = KSI_HashChainLinkList_new(&chainList);
+	if (res != KSI_OK) goto cleanup;
+
+	for (j = 0; j < item->chain_len; j++) {
+		res = KSI_HashChainLink_new(ksi, &link);
+		if (res != KSI_OK) goto cleanup;
+
+		res = KSI_HashChainLink_setImprint(link, KSI_DataHash_ref(item->chain[j].sibling));
+		if (res != KSI_OK) goto cleanup;
+
+		res = KSI_HashChainLink_setIsLeft(link, item->chain[j].isLeft);
+		if (res != KSI_OK) goto cleanup;
+
+		res = KSI_Integer_new(ksi, item->chain[j].corr, &lvlcrct);
+		if (res != KSI_OK) goto cleanup;
+
+		res = KSI_HashChainLink_setLevelCorrection(link, lvlcrct);
+		if (res != KSI_OK) goto cleanup;
+		lvlcrct = NULL;
+
+		res = KSI_HashChainLinkList_append(chainList, link);
+		if (res != KSI_OK) goto cleanup;
+		link = NULL;
+	}
+
+	res = KSI_AggregationHashChain_new(ksi, &aggrChain);
+	if (res != KSI_OK) goto cleanup;
+
+	res = KSI_AggregationHashChain_setChain(aggrChain, chainList);
+	if (res != KSI_OK) goto cleanup;
+	chainList = NULL;
+
+	res = KSI_AggregationHashChain_setInputHash(aggrChain, KSI_DataHash_ref(item->hash));
+	if (res != KSI_OK) goto cleanup;
+
+	res = KSI_Integer_new(ksi, batch->algo, &hashId);
+	if (res != KSI_OK) goto cleanup;
+
+	res = KSI_AggregationHashChain_setAggrHashId(aggrChain, hashId);
+	if (res != KSI_OK) goto cleanup;
+	hashId = NULL;
+
+	res = KSI_SignatureBuilder_openFromSignature(batchSig, &builder);
+	if (res != KSI_OK) goto cleanup;
+
+	res = KSI_SignatureBuilder_createSignatureWithAggregationChain(builder, aggrChain, &tmp);
+	if (res != KSI_OK) goto cleanup;
+
+	*sig = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	KSI_Signature_free(tmp);
+	KSI_SignatureBuilder_free(builder);
+	KSI_AggregationHashChain_free(aggrChain);
+	KSI_HashChainLinkList_free(chainList);
+	KSI_HashChainLink_free(link);
+	KSI_Integer_free(lvlcrct);
+	KSI_Integer_free(hashId);
+
+	return res;
+}
+
+void* SIGN_BATCH_getCtx(SIGN_BATCH *batch, size_t i) {
+	if (batch == NULL || i >= batch->count) return NULL;
+	return batch->items[i].ctx;
+}
+
+int SIGN_BATCH_isFull(SIGN_BATCH *batch) {
+	if (batch == NULL) return 0;
+	return batch->count >= batch->capacity;
+}
+
+size_t SIGN_BATCH_getCount(SIGN_BATCH *batch) {
+	if (batch == NULL) return 0;
+	return batch->count;
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+#ifndef SIGN_BATCH_H
+#define	SIGN_BATCH_H
+
+#include <stddef.h>
+#include <ksi/ksi.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+typedef struct SIGN_BATCH_st SIGN_BATCH;
+
+/**
+ * Creates a batch of hashes (e.g. block root hashes) that are aggregated locally
+ * into a single hash. Only the root of the batch needs to be signed. The signature
+ * of every hash in the batch is created by prepending the local aggregation hash
+ * chain to the signature of the batch root (see #SIGN_BATCH_createSignature).
+ * \param maxSize		Maximum count of hashes in the batch.
+ * \param batch			Output parameter for the batch.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int SIGN_BATCH_new(size_t maxSize, SIGN_BATCH **batch);
+void SIGN_BATCH_free(SIGN_BATCH *batch);
+
+/**
+ * Adds a new hash to the end of the batch.
+ * \param batch			Batch object.
+ * \param hash			Hash to be signed. Reference is taken.
+ * \param level			Level of the hash to be signed.
+ * \param ctx			User context of the hash. Can be \c NULL.
+ * \param ctx_free		Function to free \c ctx when the batch is freed. Can be \c NULL.
+ * \return KT_OK if successful, KT_INDEX_OVF if the batch is full, error code otherwise.
+ */
+int SIGN_BATCH_add(SIGN_BATCH *batch, KSI_DataHash *hash, KSI_uint64_t level, void *ctx, void (*ctx_free)(void*));
+
+/**
+ * Builds the local aggregation tree over all hashes in the batch. Hashes are
+ * aggregated pairwise in the same order as they were added, the level of every
+ * tree node is one more than the highest level of its children.
+ * Nodes of the same level are hashed at once (see #HASH_BATCH_calculate).
+ * \param batch			Batch object.
+ * \param ksi			KSI context.
+ * \param algo			Hash algorithm used to calculate the tree nodes.
+ * \param root			Output parameter for the root hash of the batch.
+ * \param rootLevel		Output parameter for the level of the root hash. Can be \c NULL.
+ * \return KT_OK if successful, KT_TREE_LEVEL_OVF if the tree gets too high, error code otherwise.
+ */
+int SIGN_BATCH_calculateRoot(SIGN_BATCH *batch, KSI_CTX *ksi, KSI_HashAlgorithm algo, KSI_DataHash **root, KSI_uint64_t *rootLevel);
+
+/**
+ * Creates the signature of a single hash in the batch from the signature of the
+ * batch root. Must be called after #SIGN_BATCH_calculateRoot.
+ * \param batch			Batch object.
+ * \param ksi			KSI context.
+ * \param batchSig		Signature of the batch root.
+ * \param i				Index of the hash in the batch.
+ * \param sig			Output parameter for the signature.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int SIGN_BATCH_createSignature(SIGN_BATCH *batch, KSI_CTX *ksi, const KSI_Signature *batchSig, size_t i, KSI_Signature **sig);
+
+/**
+ * Returns the user context of the hash with index \c i, or \c NULL if out of range.
+ * The ownership of the context is not passed to the caller.
+ */
+void* SIGN_BATCH_getCtx(SIGN_BATCH *batch, size_t i);
+
+int SIGN_BATCH_isFull(SIGN_BATCH *batch);
+size_t SIGN_BATCH_getCount(SIGN_BATCH *batch);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SIGN_BATCH_H */
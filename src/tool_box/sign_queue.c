@@ -0,0 +1,415 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ksi/ksi.h>
+#include <ksi/net.h>
+#include "logksi_err.h"
+#include "sign_queue.h"
+
+/* Time to sleep between polls of the asynchronous service, when waiting for a response. */
+#define SIGN_QUEUE_POLL_INTERVAL_NS 1000000
+
+typedef struct SIGN_QUEUE_ITEM_st {
+	size_t id;			/* Request id, that is unique within the queue. */
+	KSI_DataHash *hash;
+	KSI_uint64_t rootLevel;
+	void *ctx;
+	void (*ctx_free)(void*);
+	KSI_Signature *sig;
+	int error;
+	int isSent;
+	int isDone;
+} SIGN_QUEUE_ITEM;
+
+struct SIGN_QUEUE_st {
+	KSI_CTX *ksi;
+	KSI_AsyncService *service;
+	SIGN_QUEUE_ITEM *items;
+	size_t capacity;
+	size_t first;
+	size_t count;
+	size_t nextId;
+};
+
+static void sign_queue_item_clean(SIGN_QUEUE_ITEM *item) {
+	if (item == NULL) return;
+
+	KSI_DataHash_free(item->hash);
+	KSI_Signature_free(item->sig);
+	if (item->ctx_free != NULL) item->ctx_free(item->ctx);
+	memset(item, 0, sizeof(SIGN_QUEUE_ITEM));
+}
+
+static SIGN_QUEUE_ITEM* sign_queue_get_item(SIGN_QUEUE *queue, size_t i) {
+	return &queue->items[(queue->first + i) % queue->capacity];
+}
+
+/* Returns the item of the request with the given id or NULL if the item is already taken from the queue. */
+static SIGN_QUEUE_ITEM* sign_queue_find_item(SIGN_QUEUE *queue, size_t id) {
+	size_t i;
+
+	for (i = 0; i < queue->count; i++) {
+		SIGN_QUEUE_ITEM *item = sign_queue_get_item(queue, i);
+		if (item->id == id) return item;
+	}
+
+	return NULL;
+}
+
+static void sign_queue_mark_failed(SIGN_QUEUE *queue, int error) {
+	size_t i;
+
+	for (i = 0; i < queue->count; i++) {
+		SIGN_QUEUE_ITEM *item = sign_queue_get_item(queue, i);
+
+		if (!item->isDone) {
+			item->isDone = 1;
+			item->error = error;
+		}
+	}
+}
+
+/* Returns KSI_ASYNC_REQUEST_CACHE_FULL if the request must be sent later. */
+static int sign_queue_send_item(SIGN_QUEUE *queue, SIGN_QUEUE_ITEM *item) {
+	int res = KT_UNKNOWN_ERROR;
+	KSI_AggregationReq *req = NULL;
+	KSI_AsyncHandle *handle = NULL;
+	KSI_Integer *level = NULL;
+	size_t *id = NULL;
+
+	res = KSI_AggregationReq_new(queue->ksi, &req);
+	if (res != KSI_OK) goto cleanup;
+
+	res = KSI_AggregationReq_setRequestHash(req, KSI_DataHash_ref(item->hash));
+	if (res != KSI_OK) goto cleanup;
+
+	if (item->rootLevel > 0) {
+		res = KSI_Integer_new(queue->ksi, item->rootLevel, &level);
+		if (res != KSI_OK) goto cleanup;
+
+		res = KSI_AggregationReq_setRequestLevel(req, level);
+		if (res != KSI_OK) goto cleanup;
+		level = NULL;
+	}
+
+	res = KSI_AsyncAggregationHandle_new(queue->ksi, req, &handle);
+	if (res != KSI_OK) goto cleanup;
+	req = NULL;
+
+	/* Request is identified by its id, as the item is reused for the next requests. */
+	id = (size_t*)malloc(sizeof(size_t));
+	if (id == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	*id = item->id;
+
+	res = KSI_AsyncHandle_setRequestCtx(handle, (void*)id, free);
+	if (res != KSI_OK) goto cleanup;
+	id = NULL;
+
+	res = KSI_AsyncService_addRequest(queue->service, handle);
+	if (res != KSI_OK) goto cleanup;
+	handle = NULL;
+
+	item->isSent = 1;
+	res = KT_OK;
+
+cleanup:
+
+	free(id);
+	KSI_Integer_free(level);
+	KSI_AggregationReq_free(req);
+	KSI_AsyncHandle_free(handle);
+
+	return res;
+}
+
+static int sign_queue_handle_response(SIGN_QUEUE *queue, KSI_AsyncHandle *handle) {
+	int res = KT_UNKNOWN_ERROR;
+	int state = 0;
+	const size_t *id = NULL;
+	SIGN_QUEUE_ITEM *item = NULL;
+
+	res = KSI_AsyncHandle_getState(handle, &state);
+	if (res != KSI_OK) goto cleanup;
+
+	/* Skip responses that do not belong to any request (e.g. pushed configuration). */
+	if (state != KSI_ASYNC_STATE_RESPONSE_RECEIVED && state != KSI_ASYNC_STATE_ERROR) {
+		res = KT_OK;
+		goto cleanup;
+	}
+
+	res = KSI_AsyncHandle_getRequestCtx(handle, (const void**)&id);
+	if (res != KSI_OK) goto cleanup;
+
+	if (id == NULL) {
+		res = KT_UNKNOWN_ERROR;
+		goto cleanup;
+	}
+
+	/* Request may already be marked as failed and even taken from the queue. */
+	item = sign_queue_find_item(queue, *id);
+	if (item == NULL || item->isDone) {
+		res = KT_OK;
+		goto cleanup;
+	}
+
+	if (state == KSI_ASYNC_STATE_RESPONSE_RECEIVED) {
+		item->error = KSI_AsyncHandle_getSignature(handle, &item->sig);
+	} else {
+		res = KSI_AsyncHandle_getError(handle, &item->error);
+		if (res != KSI_OK) goto cleanup;
+		if (item->error == KSI_OK) item->error = KT_SIGNING_FAILURE;
+	}
+
+	item->isDone = 1;
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
+
+static int sign_queue_run(SIGN_QUEUE *queue) {
+	int res = KT_UNKNOWN_ERROR;
+	KSI_AsyncHandle *handle = NULL;
+	size_t waiting = 0;
+	size_t i;
+
+	/* Send all requests that were not accepted by the service earlier. */
+	for (i = 0; i < queue->count; i++) {
+		SIGN_QUEUE_ITEM *item = sign_queue_get_item(queue, i);
+
+		if (item->isSent || item->isDone) continue;
+
+		res = sign_queue_send_item(queue, item);
+		if (res == KSI_ASYNC_REQUEST_CACHE_FULL) break;
+		else if (res != KT_OK) {
+			item->isDone = 1;
+			item->error = res;
+		}
+	}
+
+	do {
+		res = KSI_AsyncService_run(queue->service, &handle, &waiting);
+		if (res != KSI_OK) {
+			/* Service is not usable anymore. Let the caller handle the failed requests. */
+			sign_queue_mark_failed(queue, res);
+			res = KT_OK;
+			goto cleanup;
+		}
+
+		if (handle == NULL) break;
+
+		res = sign_queue_handle_response(queue, handle);
+		if (res != KT_OK) goto cleanup;
+
+		KSI_AsyncHandle_free(handle);
+		handle = NULL;
+	} while (1);
+
+	res = KT_OK;
+
+cleanup:
+
+	KSI_AsyncHandle_free(handle);
+
+	return res;
+}
+
+int SIGN_QUEUE_new(KSI_CTX *ksi, const char *url, const char *user, const char *key, KSI_HashAlgorithm hmacAlg, size_t maxPending, SIGN_QUEUE **queue) {
+	int res = KT_UNKNOWN_ERROR;
+	SIGN_QUEUE *tmp = NULL;
+
+	if (ksi == NULL || url == NULL || maxPending == 0 || queue == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	tmp = (SIGN_QUEUE*)malloc(sizeof(SIGN_QUEUE));
+	if (tmp == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	tmp->ksi = ksi;
+	tmp->service = NULL;
+	tmp->items = NULL;
+	tmp->capacity = maxPending;
+	tmp->first = 0;
+	tmp->count = 0;
+	tmp->nextId = 1;
+
+	tmp->items = (SIGN_QUEUE_ITEM*)calloc(maxPending, sizeof(SIGN_QUEUE_ITEM));
+	if (tmp->items == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	res = KSI_SigningAsyncService_new(ksi, &tmp->service);
+	if (res != KSI_OK) goto cleanup;
+
+	res = KSI_AsyncService_setEndpoint(tmp->service, url, user, key);
+	if (res != KSI_OK) goto cleanup;
+
+	if (KSI_isHashAlgorithmSupported(hmacAlg)) {
+		res = KSI_AsyncService_setOption(tmp->service, KSI_ASYNC_OPT_HMAC_ALGORITHM, (void*)hmacAlg);
+		if (res != KSI_OK) goto cleanup;
+	}
+
+	res = KSI_AsyncService_setOption(tmp->service, KSI_ASYNC_OPT_REQUEST_CACHE_SIZE, (void*)maxPending);
+	if (res != KSI_OK) goto cleanup;
+
+	res = KSI_AsyncService_setOption(tmp->service, KSI_ASYNC_OPT_MAX_REQUEST_COUNT, (void*)maxPending);
+	if (res != KSI_OK) goto cleanup;
+
+	*queue = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	SIGN_QUEUE_free(tmp);
+
+	return res;
+}
+
+void SIGN_QUEUE_free(SIGN_QUEUE *queue) {
+	size_t i;
+
+	if (queue == NULL) return;
+
+	KSI_AsyncService_free(queue->service);
+
+	if (queue->items != NULL) {
+		for (i = 0; i < queue->capacity; i++) {
+			sign_queue_item_clean(&queue->items[i]);
+		}
+	}
+
+	free(queue->items);
+	free(queue);
+}
+
+int SIGN_QUEUE_add(SIGN_QUEUE *queue, KSI_DataHash *hash, KSI_uint64_t rootLevel, void *ctx, void (*ctx_free)(void*)) {
+	int res = KT_UNKNOWN_ERROR;
+	SIGN_QUEUE_ITEM *item = NULL;
+
+	if (queue == NULL || hash == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	if (SIGN_QUEUE_isFull(queue)) {
+		res = KT_INDEX_OVF;
+		goto cleanup;
+	}
+
+	item = sign_queue_get_item(queue, queue->count);
+	item->id = queue->nextId++;
+	item->hash = KSI_DataHash_ref(hash);
+	item->rootLevel = rootLevel;
+	item->ctx = ctx;
+	item->ctx_free = ctx_free;
+	item->sig = NULL;
+	item->error = KT_OK;
+	item->isSent = 0;
+	item->isDone = 0;
+	queue->count++;
+
+	/* Send the request immediately and process any responses already received. As
+	 * the item is already owned by the queue, failures are reported per request. */
+	res = sign_queue_run(queue);
+	if (res != KT_OK) sign_queue_mark_failed(queue, res);
+
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
+
+int SIGN_QUEUE_getNext(SIGN_QUEUE *queue, int wait, void **ctx, KSI_Signature **sig, int *error) {
+	int res = KT_UNKNOWN_ERROR;
+	SIGN_QUEUE_ITEM *item = NULL;
+
+	if (queue == NULL || ctx == NULL || sig == NULL || error == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	*ctx = NULL;
+	*sig = NULL;
+	*error = KT_OK;
+
+	if (queue->count == 0) {
+		res = KT_OK;
+		goto cleanup;
+	}
+
+	item = sign_queue_get_item(queue, 0);
+
+	do {
+		res = sign_queue_run(queue);
+		if (res != KT_OK) goto cleanup;
+
+		if (!item->isDone && wait) {
+			struct timespec interval = {0, SIGN_QUEUE_POLL_INTERVAL_NS};
+			nanosleep(&interval, NULL);
+		}
+	} while (!item->isDone && wait);
+
+	if (!item->isDone) {
+		res = KT_OK;
+		goto cleanup;
+	}
+
+	*ctx = item->ctx;
+	*sig = item->sig;
+	*error = item->error;
+
+	/* Ownership of the user context and signature is passed to the caller. */
+	item->ctx = NULL;
+	item->ctx_free = NULL;
+	item->sig = NULL;
+	sign_queue_item_clean(item);
+
+	queue->first = (queue->first + 1) % queue->capacity;
+	queue->count--;
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
+
+int SIGN_QUEUE_isFull(SIGN_QUEUE *queue) {
+	if (queue == NULL) return 0;
+	return queue->count >= queue->capacity;
+}
+
+size_t SIGN_QUEUE_getCount(SIGN_QUEUE *queue) {
+	if (queue == NULL) return 0;
+	return queue->count;
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+#ifndef SIGN_QUEUE_H
+#define	SIGN_QUEUE_H
+
+#include <stddef.h>
+#include <ksi/ksi.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+typedef struct SIGN_QUEUE_st SIGN_QUEUE;
+
+/**
+ * Creates a queue of non-blocking signing requests on top of libksi asynchronous
+ * signing service. Requests are sent to the aggregator as soon as they are added
+ * and responses are returned in the same order as the requests were added.
+ * \param ksi			KSI context.
+ * \param url			Aggregator URL.
+ * \param user			Aggregator user.
+ * \param key			Aggregator key.
+ * \param hmacAlg		HMAC algorithm of the requests. If not supported (e.g. KSI_HASHALG_INVALID_VALUE), the default is used.
+ * \param maxPending	Maximum count of requests that can be in the queue at once.
+ * \param queue			Output parameter for the queue.
+ * \return KT_OK if successful, error code otherwise.
+ * \see #TOOL_newSignQueue to configure the queue from the command line and the configuration file.
+ */
+int SIGN_QUEUE_new(KSI_CTX *ksi, const char *url, const char *user, const char *key, KSI_HashAlgorithm hmacAlg, size_t maxPending, SIGN_QUEUE **queue);
+void SIGN_QUEUE_free(SIGN_QUEUE *queue);
+
+/**
+ * Adds a new signing request to the end of the queue. When the queue is full
+ * (see #SIGN_QUEUE_isFull) the request is rejected and at least one response must
+ * be taken from the queue with #SIGN_QUEUE_getNext.
+ * \param queue			Queue object.
+ * \param hash			Hash to be signed. Reference is taken.
+ * \param rootLevel		Level of the hash to be signed.
+ * \param ctx			User context returned together with the response. Can be \c NULL.
+ * \param ctx_free		Function to free \c ctx if the queue is freed before the response is taken. Can be \c NULL.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int SIGN_QUEUE_add(SIGN_QUEUE *queue, KSI_DataHash *hash, KSI_uint64_t rootLevel, void *ctx, void (*ctx_free)(void*));
+
+/**
+ * Takes the response of the oldest request from the queue. If \c wait is set the
+ * function blocks until the response is received, otherwise \c ctx is set to \c NULL
+ * if the oldest request is not answered yet.
+ * \param queue			Queue object.
+ * \param wait			Block until the response of the oldest request is available.
+ * \param ctx			Output parameter for the user context given to #SIGN_QUEUE_add.
+ * \param sig			Output parameter for the KSI signature. Is \c NULL when request failed.
+ * \param error			Output parameter for the error code of the failed request. Is KT_OK on success.
+ * \return KT_OK if successful, error code otherwise. Note that failure of a single request
+ * is reported via \c error and does not make the function fail.
+ */
+int SIGN_QUEUE_getNext(SIGN_QUEUE *queue, int wait, void **ctx, KSI_Signature **sig, int *error);
+
+int SIGN_QUEUE_isFull(SIGN_QUEUE *queue);
+size_t SIGN_QUEUE_getCount(SIGN_QUEUE *queue);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SIGN_QUEUE_H */
@@ -23,6 +23,9 @@
 #include <errno.h>
 #include <unistd.h>
 #include <ctype.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
 #include <ksi/ksi.h>
 #include <ksi/err.h>
 #include <ksi/compatibility.h>
@@ -34,6 +37,7 @@
 #include "tool_box/ksi_init.h"
 #include "tool_box/param_control.h"
 #include "tool_box/task_initializer.h"
+#include "tool_box.h"
 #include "smart_file.h"
 #include "err_trckr.h"
 #include "api_wrapper.h"
@@ -81,8 +85,13 @@ static int generate_filenames(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err,
 static int open_log_and_signature_files(ERR_TRCKR *err, IO_FILES *files);
 static void close_log_and_signature_files(IO_FILES *files);
 static int getLogFiles(PARAM_SET *set, ERR_TRCKR *err, int i, IO_FILES *files);
+static int open_verify_ledger(PARAM_SET *set, ERR_TRCKR *err, KSI_CTX *ksi, TASK *task, const char *fname, VERIFY_LEDGER **ledger);
+static int receive_publications_file(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_CTX *ksi);
+static KSI_PublicationsFile *get_cached_publications_file(PARAM_SET *set, KSI_CTX *ksi);
+static int verify_log_files_in_parallel(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_CTX *ksi, SMART_FILE *ksi_log, VERIFYING_FUNCTION verify_signature, KSI_DataHash *inputHash, unsigned nofJobs, IO_FILES *files, KSI_DataHash **lastLeaf);
+static int verify_log_blocks_in_parallel(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_CTX *ksi, SMART_FILE *ksi_log, VERIFYING_FUNCTION verify_signature, KSI_DataHash *inputHash, unsigned nofJobs, IO_FILES *files, KSI_DataHash **lastLeaf);
 
-#define PARAMS "{log-file-list}{log-file-list-delimiter}{sig-dir}{warn-same-block-time}{warn-client-id-change}{ignore-desc-block-time}{logfile}{multiple_logs}{input}{input-hash}{client-id}{output-hash}{log-from-stdin}{x}{d}{pub-str}{ver-int}{ver-cal}{ver-key}{ver-pub}{use-computed-hash-on-fail}{use-stored-hash-on-fail}{continue-on-fail}{conf}{time-form}{time-base}{time-diff}{time-disordered}{block-time-diff}{log}{h|help}{hex-to-str}"
+#define PARAMS "{log-file-list}{log-file-list-delimiter}{sig-dir}{warn-same-block-time}{warn-client-id-change}{ignore-desc-block-time}{logfile}{multiple_logs}{input}{input-hash}{client-id}{output-hash}{log-from-stdin}{x}{d}{pub-str}{ver-int}{ver-cal}{ver-key}{ver-pub}{use-computed-hash-on-fail}{use-stored-hash-on-fail}{continue-on-fail}{conf}{time-form}{time-base}{time-diff}{time-disordered}{block-time-diff}{log}{h|help}{hex-to-str}{threads}{jobs}{lines}{time-range}{ledger}"
 
 int verify_run(int argc, char **argv, char **envp) {
 	int res;
@@ -105,6 +114,10 @@ int verify_run(int argc, char **argv, char **envp) {
 	LOGKSI logksi;
 	MULTI_PRINTER *mp = NULL;
 	uint64_t las_rec_time = 0;
+	VERIFY_LEDGER *ledger = NULL;
+	char *ledgerFname = NULL;
+	int isPubFileUsed = 0;
+	unsigned nofJobs = 1;
 
 	LOGKSI_initialize(&logksi);
 	IO_FILES_init(&files);
@@ -137,6 +150,11 @@ int verify_run(int argc, char **argv, char **envp) {
 	d = PARAM_SET_isSetByName(set, "d");
 	isMultipleLog = PARAM_SET_isSetByName(set, "multiple_logs");
 
+	if (PARAM_SET_isSetByName(set, "jobs")) {
+		res = PARAM_SET_getObj(set, "jobs", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, (void*)&nofJobs);
+		ERR_CATCH_MSG(err, res, "Error: Unable to extract the count of jobs.");
+	}
+
 
 
 	res = check_pipe_errors(set, err);
@@ -156,6 +174,7 @@ int verify_run(int argc, char **argv, char **envp) {
 		case ANC_BASED_PUB_SRT:
 		case ANC_BASED_PUB_SRT_X:
 			verify_signature = signature_verify_general;
+			isPubFileUsed = 1;
 		break;
 
 		case INT_BASED:
@@ -168,11 +187,13 @@ int verify_run(int argc, char **argv, char **envp) {
 
 		case KEY_BASED:
 			verify_signature = signature_verify_key_based;
+			isPubFileUsed = 1;
 		break;
 
 		case PUB_BASED_FILE:
 		case PUB_BASED_FILE_X:
 			verify_signature = signature_verify_publication_based_with_pubfile;
+			isPubFileUsed = 1;
 		break;
 
 		case PUB_BASED_STR:
@@ -188,6 +209,11 @@ int verify_run(int argc, char **argv, char **envp) {
 
 
 
+	if (isPubFileUsed && PARAM_SET_isSetByName(set, "pubfile-cache,P")) {
+		res = receive_publications_file(set, mp, err, ksi);
+		if (res != KT_OK) goto cleanup;
+	}
+
 	if (PARAM_SET_isSetByName(set, "input-hash")) {
 		COMPOSITE extra;
 		extra.ctx = ksi;
@@ -196,48 +222,74 @@ int verify_run(int argc, char **argv, char **envp) {
 		ERR_CATCH_MSG(err, res, "Error: Unable to extract input hash value!");
 	}
 
-	do {
-		res = getLogFiles(set, err, i, &files);
-		 if (res == PST_PARAMETER_VALUE_NOT_FOUND) {
-			res = KT_OK;
-			break;
-		}
-		ERR_CATCH_MSG(err, res, "Error: Unable to get file names for log and log signature file.");
+	if (PARAM_SET_isSetByName(set, "ledger")) {
+		res = PARAM_SET_getStr(set, "ledger", NULL, PST_PRIORITY_HIGHEST, PST_INDEX_LAST, &ledgerFname);
+		ERR_CATCH_MSG(err, res, "Error: Unable to get file name for verification ledger.");
 
+		res = open_verify_ledger(set, err, ksi, task, ledgerFname, &ledger);
+		if (res != KT_OK) goto cleanup;
+	}
 
-		res = generate_filenames(set, mp, err, &files);
+	/* Log files are verified on their own and the checks between the files are done afterwards. */
+	if (nofJobs > 1 && !PARAM_SET_isSetByName(set, "logfile")) {
+		res = verify_log_files_in_parallel(set, mp, err, ksi, logfile, verify_signature, inputHash, nofJobs, &files, &outputHash);
 		if (res != KT_OK) goto cleanup;
 
-		res = open_log_and_signature_files(err, &files);
+		pLastOutputHash = outputHash;
+	} else if (nofJobs > 1 && !PARAM_SET_isOneOfSetByName(set, "log-from-stdin,continue-on-fail,lines,time-range")) {
+		/* Blocks of a single log file are verified in ranges and the checks between the ranges are done afterwards. */
+		res = verify_log_blocks_in_parallel(set, mp, err, ksi, logfile, verify_signature, inputHash, nofJobs, &files, &outputHash);
 		if (res != KT_OK) goto cleanup;
 
-		if (isMultipleLog) {
-			print_debug_mp(mp, MP_ID_BLOCK, DEBUG_LEVEL_1, "%sLog file '%s'.\n", (i == 0 ? "" : "\n"), files.internal.inLog);
-		}
+		pLastOutputHash = outputHash;
+	} else {
+		do {
+			res = getLogFiles(set, err, i, &files);
+			 if (res == PST_PARAMETER_VALUE_NOT_FOUND) {
+				res = KT_OK;
+				break;
+			}
+			ERR_CATCH_MSG(err, res, "Error: Unable to get file names for log and log signature file.");
 
-		logksi.file.recTimeMax = las_rec_time;
 
-		print_progressDesc(mp, MP_ID_BLOCK, 0, DEBUG_EQUAL | DEBUG_LEVEL_1, "Verifying... ");
-		res = logsignature_verify(set, mp, err, ksi, &logksi, inputHash, verify_signature, &files, &outputHash, &las_rec_time);
-		print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_1, res);
-		if (res != KT_OK) goto cleanup;
+			res = generate_filenames(set, mp, err, &files);
+			if (res != KT_OK) goto cleanup;
 
-		MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
-		if (MULTI_PRINTER_hasDataByID(mp, MP_ID_LOGFILE_WARNINGS)) {
-			print_debug("\n");
-			MULTI_PRINTER_printByID(mp, MP_ID_LOGFILE_WARNINGS);
-		}
+			res = open_log_and_signature_files(err, &files);
+			if (res != KT_OK) goto cleanup;
 
-		KSI_DataHash_free(inputHash);
-		inputHash = outputHash;
-		pLastOutputHash = outputHash;
-		outputHash = NULL;
+			if (isMultipleLog) {
+				print_debug_mp(mp, MP_ID_BLOCK, DEBUG_LEVEL_1, "%sLog file '%s'.\n", (i == 0 ? "" : "\n"), files.internal.inLog);
+			}
+
+			logksi.file.recTimeMax = las_rec_time;
+
+			print_progressDesc(mp, MP_ID_BLOCK, 0, DEBUG_EQUAL | DEBUG_LEVEL_1, "Verifying... ");
+			res = logsignature_verify(set, mp, err, ksi, &logksi, inputHash, verify_signature, &files, ledger, &outputHash, &las_rec_time, NULL);
+			print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_1, res);
+			if (res != KT_OK) goto cleanup;
+
+			MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
+			if (MULTI_PRINTER_hasDataByID(mp, MP_ID_LOGFILE_WARNINGS)) {
+				print_debug("\n");
+				MULTI_PRINTER_printByID(mp, MP_ID_LOGFILE_WARNINGS);
+			}
 
-		IO_FILES_StorePreviousFileNames(&files);
-		close_log_and_signature_files(&files);
-		i++;
-	} while(1);
+			KSI_DataHash_free(inputHash);
+			inputHash = outputHash;
+			pLastOutputHash = outputHash;
+			outputHash = NULL;
 
+			IO_FILES_StorePreviousFileNames(&files);
+			close_log_and_signature_files(&files);
+			i++;
+		} while(1);
+	}
+
+	if (ledger != NULL) {
+		res = VERIFY_LEDGER_write(ledger, ledgerFname);
+		ERR_CATCH_MSG(err, res, "Error: Unable to write verification ledger %s.", ledgerFname);
+	}
 
 
 	if (PARAM_SET_isSetByName(set, "output-hash")) {
@@ -258,6 +310,10 @@ int verify_run(int argc, char **argv, char **envp) {
 
 cleanup:
 
+	/* Outcome of the log files verified before the failure is not lost. */
+	if (res != KT_OK && ledger != NULL) {
+		VERIFY_LEDGER_write(ledger, ledgerFname);
+	}
 
 	close_log_and_signature_files(&files);
 
@@ -278,6 +334,7 @@ cleanup:
 
 	KSI_DataHash_free(inputHash);
 	KSI_DataHash_free(outputHash);
+	VERIFY_LEDGER_free(ledger);
 	SMART_FILE_close(logfile);
 	PARAM_SET_free(set);
 	TASK_SET_free(task_set);
@@ -337,6 +394,11 @@ char *verify_help_toString(char *buf, size_t len) {
 	PARAM_SET_setHelpText(set, "warn-client-id-change", NULL, "Will warn the user if KSI signatures client ID is not constant over all the blocks.");
 	PARAM_SET_setHelpText(set, "warn-same-block-time", NULL, "Prints a warning when two consecutive blocks have same signing time. When multiple log files are verified the last block from the previous file is compared with the first block from the current file.");
 	PARAM_SET_setHelpText(set, "continue-on-fail", NULL, "Can be used to continue verification to improve debugging of verification errors. Other errors (e.g. IO error) will terminated verification.");
+	PARAM_SET_setHelpText(set, "lines", "<range>", "Verify only the blocks that contain the given range of log lines. The range is given as <from>-<to>, <from>- (until the end of the log file) or <line>, where the first line is 1. The blocks before and after the range are skipped with the help of the block index (see logksi index), but every block in the range is verified completely. Can not be used with --log-from-stdin, --, --input-hash and --output-hash.");
+	PARAM_SET_setHelpText(set, "time-range", "<from>,<to>", "Verify only the blocks that contain log records from the given time window. The record time is extracted from the log lines with --time-form, that must be specified. Time is given as seconds since 1970-01-01 00:00:00 UTC or as 'YYYY-MM-DD hh:mm:ss' in UTC. One of the times can be omitted (e.g. '2019-01-01 12:00:00,'). The log records are expected to be in chronological order. See --lines for other restrictions.");
+	PARAM_SET_setHelpText(set, "threads", "<int>", "The count of threads used to calculate the hashes of log lines. Log lines are read ahead and hashed in parallel, while the blocks are verified in the same order as with a single thread. Default value is 1.");
+	PARAM_SET_setHelpText(set, "jobs", "<int>", "The count of log files verified at once when multiple log files are verified (see -- and --log-file-list). Every log file is verified on its own in a separate process. The inter-linking and the order of signing and record times between the log files are checked afterwards, in the order of the log files. The output is printed in the same order. When a single log file is verified, its blocks are split into the given count of ranges, using the block index, and every range is verified in a separate process. The inter-linking and the order of signing and record times between the ranges are checked afterwards. Blocks are verified in a single process with --log-from-stdin, --continue-on-fail, --lines and --time-range. Can not be used with --ledger. Default value is 1.");
+	PARAM_SET_setHelpText(set, "ledger", "<file>", "Keep a verification ledger in the given file. For every block of the verified log signature files the ledger records the digests of the block in the log signature file and in the log file, the last leaf of the block, the verification options used and the outcome. Blocks at the beginning of the file that have been verified successfully with the same options and that have not changed since are not verified again. Only the inter-linking with the first block that is verified is checked with the last leaf stored in the ledger. The last block is always verified. The file is created if it does not exist. Can not be used with --log-from-stdin, --lines, --time-range and --jobs.");
 	PARAM_SET_setHelpText(set, "use-stored-hash-on-fail", NULL, "Can be used to debug hash comparison failures, by using stored hash values to continue verification process.");
 	PARAM_SET_setHelpText(set, "use-computed-hash-on-fail", NULL, "Can be used to debug hash comparison failures, by using computed hash values to continue verification process.");
 	PARAM_SET_setHelpText(set, "x", NULL, "Permit to use extender for publication-based verification.");
@@ -363,7 +425,7 @@ char *verify_help_toString(char *buf, size_t len) {
 	"logksi verify --ver-pub <logfile> [<logfile.logsig>] -P <URL> [--cnstr <oid=value>]... [-x -X <URL>  [--ext-user <user> --ext-key <key>]] [more_options]"
 	"\\>\n\n\n");
 
-	ret = PARAM_SET_helpToString(set, "ver-int,ver-cal,ver-key,ver-pub,input,logsig,exerpt-log,exerpt-proof,log-from-stdin,multiple_logs,input-hash,output-hash,ignore-desc-block-time,client-id,time-form,time-base,time-diff,time-disordered,warn-client-id-change,warn-same-block-time,continue-on-fail,use-stored-hash-on-fail,use-computed-hash-on-fail,x,X,ext-user,ext-key,ext-hmac-alg,P,cnstr,pub-str,V,d,hex-to-str,conf,log", 1, 13, 80, buf + count, len - count);
+	ret = PARAM_SET_helpToString(set, "ver-int,ver-cal,ver-key,ver-pub,input,logsig,exerpt-log,exerpt-proof,log-from-stdin,multiple_logs,input-hash,output-hash,ignore-desc-block-time,client-id,time-form,time-base,time-diff,time-disordered,warn-client-id-change,warn-same-block-time,continue-on-fail,use-stored-hash-on-fail,use-computed-hash-on-fail,threads,jobs,lines,time-range,ledger,x,X,ext-user,ext-key,ext-hmac-alg,P,cnstr,pub-str,V,pubfile-cache,pubfile-cache-ttl,d,hex-to-str,conf,log", 1, 13, 80, buf + count, len - count);
 
 cleanup:
 	if (res != PST_OK || ret == NULL) {
@@ -394,7 +456,7 @@ static int generate_tasks_set(PARAM_SET *set, TASK_SET *task_set) {
 	PARAM_SET_setPrintName(set, "logfile", "--input", NULL);
 	PARAM_SET_setPrintName(set, "multiple_logs", "--input", NULL);
 	PARAM_SET_addControl(set, "{conf}", isFormatOk_inputFile, isContentOk_inputFileRestrictPipe, convertRepair_path, NULL);
-	PARAM_SET_addControl(set, "{log}{output-hash}", isFormatOk_path, NULL, convertRepair_path, NULL);
+	PARAM_SET_addControl(set, "{log}{output-hash}{ledger}", isFormatOk_path, NULL, convertRepair_path, NULL);
 	PARAM_SET_addControl(set, "{logfile}{multiple_logs}", isFormatOk_inputFile, isContentOk_inputFileNoDir, convertRepair_path, NULL);
 	PARAM_SET_addControl(set, "{sig-dir}", isFormatOk_inputFile, isContentOk_dir, convertRepair_path, NULL);
 	PARAM_SET_addControl(set, "{input-hash}", isFormatOk_inputHash, isContentOk_inputHash, convertRepair_path, extract_inputHashFromImprintOrImprintInFile);
@@ -402,12 +464,15 @@ static int generate_tasks_set(PARAM_SET *set, TASK_SET *task_set) {
 	PARAM_SET_addControl(set, "{pub-str}", isFormatOk_pubString, NULL, NULL, extract_pubString);
 	PARAM_SET_addControl(set, "client-id,time-form", isFormatOk_string, NULL, NULL, NULL);
 	PARAM_SET_addControl(set, "time-base", isFormatOk_int, isContentOk_uint, NULL, extract_int);
+	PARAM_SET_addControl(set, "threads,jobs", isFormatOk_int, isContentOk_uint_not_zero, NULL, extract_uint);
 	PARAM_SET_addControl(set, "time-diff", isFormatOk_timeDiff, NULL, NULL, extract_timeDiff);
 	PARAM_SET_addControl(set, "block-time-diff", isFormatOk_timeDiffInfinity, NULL, NULL, extract_timeDiff);
 	PARAM_SET_addControl(set, "time-disordered", isFormatOk_timeValue, NULL, NULL, extract_timeValue);
+	PARAM_SET_addControl(set, "lines", isFormatOk_lineRange, NULL, NULL, extract_lineRange);
+	PARAM_SET_addControl(set, "time-range", isFormatOk_timeRange, NULL, NULL, extract_timeRange);
 	PARAM_SET_addControl(set, "log-file-list-delimiter", isFormatOk_fileNameDelimiter, NULL, NULL, NULL);
 
-	PARAM_SET_setParseOptions(set, "time-form,time-base,time-diff,time-disordered,block-time-diff", PST_PRSCMD_HAS_VALUE);
+	PARAM_SET_setParseOptions(set, "time-form,time-base,time-diff,time-disordered,block-time-diff,threads,jobs,lines,time-range", PST_PRSCMD_HAS_VALUE);
 
 	/* Make input also collect same values as multiple_logs. It simplifies task handling. */
 	PARAM_SET_setParseOptions(set, "input",
@@ -735,6 +800,8 @@ static int signature_verify_general(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR
 		}
 	}
 
+	if (pubFile == NULL) pubFile = get_cached_publications_file(set, ksi);
+
 	/**
 	 * Verify signature.
 	 */
@@ -806,7 +873,7 @@ static int signature_verify_key_based(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRC
 	 * Verify signature.
 	 */
 	print_progressDesc(mp, MP_ID_BLOCK, d, DEBUG_LEVEL_3, "%s... ", task);
-	res = LOGKSI_SignatureVerify_keyBased(err, sig, ksi, hsh, rootLevel, out);
+	res = LOGKSI_SignatureVerify_keyBased(err, sig, ksi, hsh, rootLevel, get_cached_publications_file(set, ksi), out);
 	if (res != KSI_OK && *out != NULL) {
 		res = handle_verification_result(set, mp, err, ksi, logksi, sig, NULL, res, task, *out, 0);
 		goto cleanup;
@@ -877,7 +944,7 @@ static int signature_verify_publication_based_with_pubfile(PARAM_SET *set, MULTI
 	 * Verify signature.
 	 */
 	print_progressDesc(mp, MP_ID_BLOCK, d, DEBUG_LEVEL_3, "%s... ", task);
-	res = LOGKSI_SignatureVerify_publicationsFileBased(err, sig, ksi, hsh, rootLevel, x, out);
+	res = LOGKSI_SignatureVerify_publicationsFileBased(err, sig, ksi, hsh, rootLevel, get_cached_publications_file(set, ksi), x, out);
 	if (res != KSI_OK && *out != NULL) {
 		res = handle_verification_result(set, mp, err, ksi, logksi, sig, NULL, res, task, *out, 1);
 		goto cleanup;
@@ -1018,7 +1085,7 @@ static int open_log_and_signature_files(ERR_TRCKR *err, IO_FILES *files) {
 	}
 
 	if (files->internal.inLog) {
-		res = SMART_FILE_open(files->internal.inLog, "rb", &tmp.files.inLog);
+		res = SMART_FILE_open(files->internal.inLog, "rbm", &tmp.files.inLog);
 		ERR_CATCH_MSG(err, res, "Unable to open input log file '%s'.", files->internal.inLog)
 	} else {
 		res = SMART_FILE_open("-", "rbs", &tmp.files.inLog);
@@ -1071,6 +1138,7 @@ static int check_io_naming_and_type_errors(PARAM_SET *set, ERR_TRCKR *err) {
 	int isMultipleLogFiles = 0;
 	int isLogFromStdin = 0;
 	int isLogSigFromDir = 0;
+	int isPartial = 0;
 
 	if (set == NULL || err == NULL) {
 		ERR_TRCKR_ADD(err, res = KT_INVALID_ARGUMENT, NULL);
@@ -1109,14 +1177,182 @@ static int check_io_naming_and_type_errors(PARAM_SET *set, ERR_TRCKR *err) {
 
 	if (res != KT_OK) goto cleanup;
 
+	/* Only a part of a single log file can be verified, as the inter-linking with other log files can not be checked. */
+	isPartial = PARAM_SET_isSetByName(set, "lines") || PARAM_SET_isSetByName(set, "time-range");
+
+	if (isPartial) {
+		if (PARAM_SET_isSetByName(set, "lines") && PARAM_SET_isSetByName(set, "time-range")) {
+			ERR_TRCKR_ADD(err, res = KT_INVALID_CMD_PARAM, "Error: --lines and --time-range can not be used together!");
+		} else if (isMultipleLogFiles || PARAM_SET_isSetByName(set, "log-file-list")) {
+			ERR_TRCKR_ADD(err, res = KT_INVALID_CMD_PARAM, "Error: --lines and --time-range can not be used to verify multiple log files!");
+		} else if (isLogFromStdin) {
+			ERR_TRCKR_ADD(err, res = KT_INVALID_CMD_PARAM, "Error: --lines and --time-range can not be used with log file from stdin (--log-from-stdin)!");
+		} else if (PARAM_SET_isSetByName(set, "input-hash") || PARAM_SET_isSetByName(set, "output-hash")) {
+			ERR_TRCKR_ADD(err, res = KT_INVALID_CMD_PARAM, "Error: --lines and --time-range can not be used with --input-hash nor --output-hash!");
+		} else if (PARAM_SET_isSetByName(set, "time-range") && !PARAM_SET_isSetByName(set, "time-form")) {
+			ERR_TRCKR_ADD(err, res = KT_INVALID_CMD_PARAM, "Error: --time-range needs --time-form to extract the record time from the log lines!");
+		}
+	}
+
+	if (res != KT_OK) goto cleanup;
+
+	if (PARAM_SET_isSetByName(set, "ledger")) {
+		if (isPartial) {
+			ERR_TRCKR_ADD(err, res = KT_INVALID_CMD_PARAM, "Error: --ledger can not be used with --lines nor --time-range!");
+		} else if (isLogFromStdin) {
+			ERR_TRCKR_ADD(err, res = KT_INVALID_CMD_PARAM, "Error: --ledger can not be used with log file from stdin (--log-from-stdin)!");
+		} else if (PARAM_SET_isSetByName(set, "jobs")) {
+			ERR_TRCKR_ADD(err, res = KT_INVALID_CMD_PARAM, "Error: --ledger can not be used with --jobs!");
+		}
+	}
+
+	if (res != KT_OK) goto cleanup;
+
+
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
+
+/**
+ * Opens the verification ledger or creates an empty one if the ledger file does not exist.
+ * The verification policy of the ledger is a digest of the verification task and of all
+ * the options that can change the outcome of the verification, so that the blocks verified
+ * with different options are verified again.
+ */
+static int open_verify_ledger(PARAM_SET *set, ERR_TRCKR *err, KSI_CTX *ksi, TASK *task, const char *fname, VERIFY_LEDGER **ledger) {
+	int res = KT_UNKNOWN_ERROR;
+	const char *flags[] = {"x", "ignore-desc-block-time", "use-computed-hash-on-fail", "use-stored-hash-on-fail", NULL};
+	const char *values[] = {"pub-str", "P", "cnstr", "V", "X", "client-id", "time-form", "time-base", "time-diff", "time-disordered", "block-time-diff", NULL};
+	VERIFY_LEDGER *tmp = NULL;
+	KSI_DataHasher *hsr = NULL;
+	KSI_DataHash *hash = NULL;
+	KSI_HashAlgorithm algo = KSI_HASHALG_INVALID_VALUE;
+	const unsigned char *digest = NULL;
+	size_t digest_len = 0;
+	char buf[1024];
+	size_t i;
+	int j;
+
+	if (set == NULL || err == NULL || ksi == NULL || task == NULL || fname == NULL || ledger == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	if (SMART_FILE_doFileExist(fname)) {
+		res = VERIFY_LEDGER_read(fname, &tmp);
+		if (res == KT_INVALID_INPUT_FORMAT) ERR_TRCKR_addAdditionalInfo(err, "  * Suggestion:  Remove the ledger file to verify all the blocks again.\n");
+		ERR_CATCH_MSG(err, res, "Error: Unable to read verification ledger %s.", fname);
+	} else {
+		res = VERIFY_LEDGER_new(&tmp);
+		ERR_CATCH_MSG(err, res, "Error: Unable to create verification ledger.");
+	}
+
+	res = KSI_DataHasher_open(ksi, KSI_HASHALG_SHA2_256, &hsr);
+	ERR_CATCH_MSG(err, res, "Error: Could not open SHA-256 hasher.");
+
+	PST_snprintf(buf, sizeof(buf), "task=%i;", TASK_getID(task));
+	res = KSI_DataHasher_add(hsr, buf, strlen(buf));
+	if (res != KSI_OK) goto cleanup;
+
+	for (i = 0; flags[i] != NULL; i++) {
+		if (!PARAM_SET_isSetByName(set, flags[i])) continue;
+
+		PST_snprintf(buf, sizeof(buf), "%s;", flags[i]);
+		res = KSI_DataHasher_add(hsr, buf, strlen(buf));
+		if (res != KSI_OK) goto cleanup;
+	}
+
+	for (i = 0; values[i] != NULL; i++) {
+		char *value = NULL;
+
+		for (j = 0; PARAM_SET_getStr(set, values[i], NULL, PST_PRIORITY_HIGHEST, j, &value) == PST_OK; j++) {
+			res = KSI_DataHasher_add(hsr, values[i], strlen(values[i]));
+			if (res != KSI_OK) goto cleanup;
+
+			res = KSI_DataHasher_add(hsr, "=", 1);
+			if (res != KSI_OK) goto cleanup;
+
+			if (value != NULL) {
+				res = KSI_DataHasher_add(hsr, value, strlen(value));
+				if (res != KSI_OK) goto cleanup;
+			}
+
+			res = KSI_DataHasher_add(hsr, ";", 1);
+			if (res != KSI_OK) goto cleanup;
+		}
+	}
+
+	res = KSI_DataHasher_close(hsr, &hash);
+	ERR_CATCH_MSG(err, res, "Error: Unable to compute the digest of verification options.");
+
+	res = KSI_DataHash_extract(hash, &algo, &digest, &digest_len);
+	ERR_CATCH_MSG(err, res, "Error: Unable to compute the digest of verification options.");
+
+	if (digest_len != VERIFY_LEDGER_DIGEST_SIZE) {
+		res = KT_UNKNOWN_ERROR;
+		goto cleanup;
+	}
+
+	VERIFY_LEDGER_setPolicy(tmp, digest);
+
+	*ledger = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	VERIFY_LEDGER_free(tmp);
+	KSI_DataHasher_free(hsr);
+	KSI_DataHash_free(hash);
+
+	return res;
+}
+
+static int receive_publications_file(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_CTX *ksi) {
+	int res = KT_UNKNOWN_ERROR;
+	int d = PARAM_SET_isSetByName(set, "d");
+	KSI_PublicationsFile *pubFile = NULL;
+	int isPubFileVerified = 0;
+
+	print_progressDesc(mp, MP_ID_BLOCK, d, DEBUG_LEVEL_1, "%s", getPublicationsFileRetrieveDescriptionString(set));
+	res = TOOL_receivePublicationsFile(set, err, ksi, &pubFile, &isPubFileVerified);
+	ERR_CATCH_MSG(err, res, "Error: Unable to receive publications file.");
+	print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_1, res);
+
+	if (!PARAM_SET_isSetByName(set, "publications-file-no-verify")) {
+		print_progressDesc(mp, MP_ID_BLOCK, d, DEBUG_LEVEL_1, "Verifying publications file... ");
+		if (!isPubFileVerified) res = TOOL_verifyPublicationsFile(set, err, ksi, pubFile);
+		ERR_CATCH_MSG(err, res, "Error: Unable to verify publications file.");
+		print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_1, res);
+	}
 
 	res = KT_OK;
 
 cleanup:
 
+	print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_1, res);
+	KSI_PublicationsFile_free(pubFile);
+
 	return res;
 }
 
+/**
+ * Publications file taken from the cache (see --pubfile-cache) is received and verified
+ * once by #receive_publications_file and kept by KSI context. It is given to the
+ * verification of every KSI signature, so that it is not verified again.
+ */
+static KSI_PublicationsFile *get_cached_publications_file(PARAM_SET *set, KSI_CTX *ksi) {
+	KSI_PublicationsFile *pubFile = NULL;
+
+	if (!PARAM_SET_isSetByName(set, "pubfile-cache,P")) return NULL;
+	if (KSI_CTX_getPublicationsFile(ksi, &pubFile) != KSI_OK) return NULL;
+
+	return pubFile;
+}
+
 static int getLogFiles(PARAM_SET *set, ERR_TRCKR *err, int i, IO_FILES *files) {
 	int res = KT_UNKNOWN_ERROR;
 
@@ -1164,4 +1400,533 @@ static int getLogFiles(PARAM_SET *set, ERR_TRCKR *err, int i, IO_FILES *files) {
 cleanup:
 
 	return res;
-}
\ No newline at end of file
+}
+/**
+ * Log file verified in a child process (see #verify_log_files_in_parallel). Output of the
+ * child is kept in temporary files until all the previous log files are finished.
+ */
+typedef struct VERIFY_JOB_st {
+	pid_t pid;
+	FILE *out;			/* Standard output of the child. */
+	FILE *errOut;		/* Standard error of the child. */
+	FILE *result;		/* Result of the verification (VERIFY_JOB_RESULT) followed by the errors. */
+	BLOCK_INDEX *index;	/* If set, only the blocks firstBlock to lastBlock of the index are verified (see #verify_log_blocks_in_parallel). */
+	size_t firstBlock;
+	size_t lastBlock;
+} VERIFY_JOB;
+
+typedef struct VERIFY_JOB_RESULT_st {
+	int res;
+	LOGSIG_EDGES edges;
+	char logFile[4096];
+	char sigFile[4096];
+} VERIFY_JOB_RESULT;
+
+static void verify_job_init(VERIFY_JOB *job) {
+	if (job == NULL) return;
+
+	job->pid = -1;
+	job->out = NULL;
+	job->errOut = NULL;
+	job->result = NULL;
+	job->index = NULL;
+	job->firstBlock = 0;
+	job->lastBlock = 0;
+}
+
+/**
+ * Describes the job in error messages, as "log file no. <i>" or as "blocks <first> - <last>".
+ */
+static const char *verify_job_toString(int i, VERIFY_JOB *job, char *buf, size_t buf_len) {
+	if (job->index != NULL) {
+		PST_snprintf(buf, buf_len, "blocks %zu - %zu", job->firstBlock + 1, job->lastBlock + 1);
+	} else {
+		PST_snprintf(buf, buf_len, "log file no. %i", i + 1);
+	}
+
+	return buf;
+}
+
+static void verify_job_close(VERIFY_JOB *job) {
+	if (job == NULL) return;
+
+	if (job->pid > 0) {
+		kill(job->pid, SIGTERM);
+		waitpid(job->pid, NULL, 0);
+	}
+
+	if (job->out != NULL) fclose(job->out);
+	if (job->errOut != NULL) fclose(job->errOut);
+	if (job->result != NULL) fclose(job->result);
+
+	job->pid = -1;
+	job->out = NULL;
+	job->errOut = NULL;
+	job->result = NULL;
+}
+
+/**
+ * Verifies the log file (or the range of its blocks) in the child process, without the previous
+ * log file (or the previous blocks). The values at the edges of the log signature file (or the
+ * range of blocks) and the errors are written into the result file.
+ */
+static int verify_job_run(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_CTX *ksi, VERIFYING_FUNCTION verify_signature, int i, VERIFY_JOB *job) {
+	int res = KT_UNKNOWN_ERROR;
+	IO_FILES files;
+	LOGKSI logksi;
+	VERIFY_JOB_RESULT result;
+
+	IO_FILES_init(&files);
+	LOGKSI_initialize(&logksi);
+	memset(&result, 0, sizeof(result));
+
+	/* Errors are passed to the parent, that has its own errors already. */
+	ERR_TRCKR_reset(err);
+
+	if (dup2(fileno(job->out), STDOUT_FILENO) < 0 || dup2(fileno(job->errOut), STDERR_FILENO) < 0) {
+		res = KT_IO_ERROR;
+		ERR_TRCKR_ADD(err, res, "Error: Unable to redirect the output of the verification.");
+		goto cleanup;
+	}
+
+	res = getLogFiles(set, err, i, &files);
+	ERR_CATCH_MSG(err, res, "Error: Unable to get file names for log and log signature file.");
+
+	res = generate_filenames(set, mp, err, &files);
+	if (res != KT_OK) goto cleanup;
+
+	res = open_log_and_signature_files(err, &files);
+	if (res != KT_OK) goto cleanup;
+
+	if (PARAM_SET_isSetByName(set, "multiple_logs")) {
+		print_debug_mp(mp, MP_ID_BLOCK, DEBUG_LEVEL_1, "%sLog file '%s'.\n", (i == 0 ? "" : "\n"), files.internal.inLog);
+	}
+
+	/* Result of a range of blocks is printed by the parent, when all the ranges are checked. */
+	if (job->index != NULL) {
+		logksi.task.verify.index = job->index;
+		logksi.task.verify.firstBlock = job->firstBlock;
+		logksi.task.verify.lastBlock = job->lastBlock;
+	} else {
+		print_progressDesc(mp, MP_ID_BLOCK, 0, DEBUG_EQUAL | DEBUG_LEVEL_1, "Verifying... ");
+	}
+
+	res = logsignature_verify(set, mp, err, ksi, &logksi, NULL, verify_signature, &files, NULL, NULL, NULL, &result.edges);
+	print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_1, res);
+	if (res != KT_OK) goto cleanup;
+
+	IO_FILES_StorePreviousFileNames(&files);
+	PST_strncpy(result.logFile, files.previousLogFile, sizeof(result.logFile));
+	PST_strncpy(result.sigFile, files.previousSigFileIn, sizeof(result.sigFile));
+
+	res = KT_OK;
+
+cleanup:
+
+	MULTI_PRINTER_printByID(mp, MP_ID_BLOCK);
+	if (MULTI_PRINTER_hasDataByID(mp, MP_ID_LOGFILE_WARNINGS)) {
+		print_debug("\n");
+		MULTI_PRINTER_printByID(mp, MP_ID_LOGFILE_WARNINGS);
+	}
+
+	LOGKSI_KSI_ERRTrace_save(ksi);
+	if (res != KT_OK) LOGKSI_KSI_ERRTrace_LOG(ksi);
+
+	close_log_and_signature_files(&files);
+
+	result.res = res;
+	if (fwrite(&result, sizeof(result), 1, job->result) != 1 || ERR_TRCKR_writeToFile(err, job->result) != 0 || fflush(job->result) != 0) {
+		res = KT_IO_ERROR;
+	}
+
+	fflush(stdout);
+	fflush(stderr);
+
+	return res;
+}
+
+static int verify_job_start(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_CTX *ksi, SMART_FILE *ksi_log, VERIFYING_FUNCTION verify_signature, int i, VERIFY_JOB *job) {
+	int res = KT_UNKNOWN_ERROR;
+	int exitCode;
+	char buf[256];
+
+	job->out = tmpfile();
+	job->errOut = tmpfile();
+	job->result = tmpfile();
+	if (job->out == NULL || job->errOut == NULL || job->result == NULL) {
+		res = KT_IO_ERROR;
+		ERR_CATCH_MSG(err, res, "Error: Unable to create temporary files for the verification of %s.", verify_job_toString(i, job, buf, sizeof(buf)));
+	}
+
+	/* Buffered output must not be inherited by the child, as it would be written twice. */
+	fflush(stdout);
+	fflush(stderr);
+	if (ksi_log != NULL) SMART_FILE_flush(ksi_log);
+
+	job->pid = fork();
+	if (job->pid < 0) {
+		res = KT_UNKNOWN_ERROR;
+		ERR_CATCH_MSG(err, res, "Error: Unable to start the verification of %s: %s.", verify_job_toString(i, job, buf, sizeof(buf)), strerror(errno));
+	} else if (job->pid == 0) {
+		exitCode = LOGKSI_errToExitCode(verify_job_run(set, mp, err, ksi, verify_signature, i, job));
+
+		/* Objects inherited from the parent are not freed by _exit, but the log file is closed. */
+		SMART_FILE_close(ksi_log);
+		fflush(stdout);
+		fflush(stderr);
+		_exit(exitCode);
+	}
+
+	res = KT_OK;
+
+cleanup:
+
+	return res;
+}
+
+static int copy_job_output(FILE *in, FILE *out) {
+	char buf[4096];
+	size_t count;
+
+	rewind(in);
+	while ((count = fread(buf, 1, sizeof(buf), in)) > 0) {
+		if (fwrite(buf, 1, count, out) != count) return KT_IO_ERROR;
+	}
+
+	return ferror(in) ? KT_IO_ERROR : KT_OK;
+}
+
+/**
+ * Waits for the child, prints its output and reads its result. Errors of the child are added
+ * to the error tracker.
+ */
+static int verify_job_finish(ERR_TRCKR *err, int i, VERIFY_JOB *job, VERIFY_JOB_RESULT *result) {
+	int res = KT_UNKNOWN_ERROR;
+	char buf[256];
+
+	if (waitpid(job->pid, NULL, 0) < 0) {
+		res = KT_UNKNOWN_ERROR;
+		ERR_CATCH_MSG(err, res, "Error: Unable to wait for the verification of %s: %s.", verify_job_toString(i, job, buf, sizeof(buf)), strerror(errno));
+	}
+	job->pid = -1;
+
+	res = copy_job_output(job->out, stdout);
+	if (res == KT_OK) res = copy_job_output(job->errOut, stderr);
+	ERR_CATCH_MSG(err, res, "Error: Unable to print the output of the verification of %s.", verify_job_toString(i, job, buf, sizeof(buf)));
+
+	rewind(job->result);
+	if (fread(result, sizeof(VERIFY_JOB_RESULT), 1, job->result) != 1 || ERR_TRCKR_addFromFile(err, job->result) != 0) {
+		res = KT_UNKNOWN_ERROR;
+		ERR_CATCH_MSG(err, res, "Error: Verification of %s was terminated unexpectedly.", verify_job_toString(i, job, buf, sizeof(buf)));
+	}
+
+	res = KT_OK;
+
+cleanup:
+
+	verify_job_close(job);
+
+	return res;
+}
+
+/**
+ * Verifies multiple log files in child processes, up to nofJobs at once. Every log file is
+ * verified without the previous log file and its inter-linking and the order of signing
+ * and record times with the previous log file are checked after it is finished, in the
+ * order of the log files. The output of the children is printed in the same order and
+ * nothing is verified after the first failure, as it is without the jobs. Last leaf of the
+ * last log file and the names of the last log and log signature file are returned.
+ */
+static int verify_log_files_in_parallel(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_CTX *ksi, SMART_FILE *ksi_log, VERIFYING_FUNCTION verify_signature, KSI_DataHash *inputHash, unsigned nofJobs, IO_FILES *files, KSI_DataHash **lastLeaf) {
+	int res = KT_UNKNOWN_ERROR;
+	VERIFY_JOB *jobs = NULL;
+	VERIFY_JOB_RESULT *result = NULL;
+	LOGSIG_EDGES prev;
+	KSI_DataHash *tmp = NULL;
+	int nofFiles = 0;
+	int started = 0;
+	int i;
+	unsigned j;
+
+	if (set == NULL || mp == NULL || err == NULL || ksi == NULL || nofJobs == 0 || files == NULL || lastLeaf == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	res = PARAM_SET_getValueCount(set, "input", NULL, PST_PRIORITY_NONE, &nofFiles);
+	ERR_CATCH_MSG(err, res, "Error: Unable to get the count of log files.");
+
+	jobs = (VERIFY_JOB*)malloc(nofJobs * sizeof(VERIFY_JOB));
+	result = (VERIFY_JOB_RESULT*)malloc(sizeof(VERIFY_JOB_RESULT));
+	if (jobs == NULL || result == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	for (j = 0; j < nofJobs; j++) verify_job_init(&jobs[j]);
+
+	/* The first log file is checked against --input-hash. */
+	memset(&prev, 0, sizeof(prev));
+	if (inputHash != NULL) {
+		const unsigned char *imprint = NULL;
+		size_t imprint_len = 0;
+
+		res = KSI_DataHash_getImprint(inputHash, &imprint, &imprint_len);
+		ERR_CATCH_MSG(err, res, "Error: Unable to get the imprint of the input hash.");
+
+		memcpy(prev.lastLeaf, imprint, imprint_len);
+		prev.lastLeaf_len = imprint_len;
+	}
+
+	/* Output collected so far is printed before it is copied into the children. */
+	MULTI_PRINTER_print(mp);
+
+	for (i = 0; i < nofFiles; i++) {
+		/* Keep the next nofJobs log files verified, including the one that is waited for. */
+		while (started < nofFiles && started < i + (int)nofJobs) {
+			res = verify_job_start(set, mp, err, ksi, ksi_log, verify_signature, started, &jobs[started % nofJobs]);
+			if (res != KT_OK) goto cleanup;
+			started++;
+		}
+
+		res = verify_job_finish(err, i, &jobs[i % nofJobs], result);
+		if (res != KT_OK) goto cleanup;
+
+		res = result->res;
+		if (res != KT_OK) goto cleanup;
+
+		res = duplicate_name(result->logFile, &files->internal.inLog);
+		if (res == KT_OK) res = duplicate_name(result->sigFile, &files->internal.inSig);
+		ERR_CATCH_MSG(err, res, "Error: Could not duplicate log file name.");
+
+		res = logsignature_verify_between_files(set, mp, err, ksi, &prev, &result->edges, files);
+		if (MULTI_PRINTER_hasDataByID(mp, MP_ID_LOGFILE_WARNINGS)) {
+			print_debug("\n");
+			MULTI_PRINTER_printByID(mp, MP_ID_LOGFILE_WARNINGS);
+		}
+		if (res != KT_OK) goto cleanup;
+
+		IO_FILES_StorePreviousFileNames(files);
+		logksi_internal_filenames_free(&files->internal);
+		prev = result->edges;
+	}
+
+	if (prev.lastLeaf_len > 0 && nofFiles > 0) {
+		res = KSI_DataHash_fromImprint(ksi, prev.lastLeaf, prev.lastLeaf_len, &tmp);
+		ERR_CATCH_MSG(err, res, "Error: Unable to create hash from the last leaf of the log signature.");
+	}
+
+	*lastLeaf = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	if (jobs != NULL) {
+		for (j = 0; j < nofJobs; j++) verify_job_close(&jobs[j]);
+	}
+
+	KSI_DataHash_free(tmp);
+	free(result);
+	free(jobs);
+
+	return res;
+}
+
+/**
+ * Splits the blocks of the block index into at most nofRanges ranges of consecutive blocks
+ * with about the same count of records. Every range has at least one block. Index of the last
+ * block of every range is returned.
+ */
+static int split_block_index(BLOCK_INDEX *index, size_t nofRanges, size_t **lastBlocks, size_t *count) {
+	int res = KT_UNKNOWN_ERROR;
+	size_t *tmp = NULL;
+	size_t nofBlocks = 0;
+	uint64_t total = 0;
+	uint64_t sum = 0;
+	size_t n = 0;
+	size_t i;
+
+	if (index == NULL || nofRanges == 0 || lastBlocks == NULL || count == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	nofBlocks = BLOCK_INDEX_getCount(index);
+	if (nofBlocks == 0) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	if (nofRanges > nofBlocks) nofRanges = nofBlocks;
+
+	tmp = (size_t*)malloc(nofRanges * sizeof(size_t));
+	if (tmp == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	for (i = 0; i < nofBlocks; i++) total += BLOCK_INDEX_get(index, i)->recordCount;
+
+	for (i = 0; i + 1 < nofBlocks && n + 1 < nofRanges; i++) {
+		sum += BLOCK_INDEX_get(index, i)->recordCount;
+
+		/* Range is closed when its share of the records is reached or when there are as many blocks left as ranges. */
+		if (sum * nofRanges >= total * (n + 1) || nofBlocks - i - 1 == nofRanges - n - 1) {
+			tmp[n++] = i;
+		}
+	}
+
+	tmp[n++] = nofBlocks - 1;
+
+	*lastBlocks = tmp;
+	*count = n;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	free(tmp);
+
+	return res;
+}
+
+/**
+ * Verifies the blocks of a single log file in child processes, up to nofJobs at once. The
+ * block headers and the record counts are read first (see #logsignature_verify_scan) and the
+ * blocks are split into nofJobs ranges of consecutive blocks with about the same count of
+ * records. Every range is verified on its own in a child process, that has its own copy of
+ * the KSI context and its own file handles: record hashes, Merkle trees and KSI signatures of
+ * the blocks. The inter-linking of the ranges and the order of signing and record times
+ * between the ranges are checked afterwards, in the order of the blocks. The output of the
+ * children is printed in the same order and nothing is checked after the first failure.
+ * Excerpt files are verified in a single child process. Last leaf of the last block is returned.
+ */
+static int verify_log_blocks_in_parallel(PARAM_SET *set, MULTI_PRINTER *mp, ERR_TRCKR *err, KSI_CTX *ksi, SMART_FILE *ksi_log, VERIFYING_FUNCTION verify_signature, KSI_DataHash *inputHash, unsigned nofJobs, IO_FILES *files, KSI_DataHash **lastLeaf) {
+	int res = KT_UNKNOWN_ERROR;
+	VERIFY_JOB *jobs = NULL;
+	VERIFY_JOB_RESULT *result = NULL;
+	BLOCK_INDEX *index = NULL;
+	size_t *lastBlocks = NULL;
+	size_t nofRanges = 1;
+	LOGSIG_EDGES prev;
+	KSI_DataHash *tmp = NULL;
+	uint64_t recTimeMax = 0;
+	size_t started = 0;
+	size_t i;
+	unsigned j;
+
+	if (set == NULL || mp == NULL || err == NULL || ksi == NULL || nofJobs == 0 || files == NULL || lastLeaf == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	res = getLogFiles(set, err, 0, files);
+	ERR_CATCH_MSG(err, res, "Error: Unable to get file names for log and log signature file.");
+
+	res = generate_filenames(set, mp, err, files);
+	if (res != KT_OK) goto cleanup;
+
+	res = open_log_and_signature_files(err, files);
+	if (res != KT_OK) goto cleanup;
+
+	res = logsignature_verify_scan(set, mp, err, ksi, files, &index);
+	if (res != KT_OK) goto cleanup;
+
+	/* Children open the files on their own, as the positions of inherited file handles are shared. */
+	logksi_files_close(&files->files);
+
+	if (index != NULL && BLOCK_INDEX_getCount(index) > 0) {
+		res = split_block_index(index, nofJobs, &lastBlocks, &nofRanges);
+		ERR_CATCH_MSG(err, res, "Error: Unable to split the blocks into ranges.");
+
+		print_debug_mp(mp, MP_ID_BLOCK, DEBUG_LEVEL_3, "Verifying %zu blocks in %zu ranges.\n", BLOCK_INDEX_getCount(index), nofRanges);
+	}
+
+	jobs = (VERIFY_JOB*)malloc(nofJobs * sizeof(VERIFY_JOB));
+	result = (VERIFY_JOB_RESULT*)malloc(sizeof(VERIFY_JOB_RESULT));
+	if (jobs == NULL || result == NULL) {
+		res = KT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	for (j = 0; j < nofJobs; j++) verify_job_init(&jobs[j]);
+
+	/* The first block is checked against --input-hash. */
+	memset(&prev, 0, sizeof(prev));
+	if (inputHash != NULL) {
+		const unsigned char *imprint = NULL;
+		size_t imprint_len = 0;
+
+		res = KSI_DataHash_getImprint(inputHash, &imprint, &imprint_len);
+		ERR_CATCH_MSG(err, res, "Error: Unable to get the imprint of the input hash.");
+
+		memcpy(prev.lastLeaf, imprint, imprint_len);
+		prev.lastLeaf_len = imprint_len;
+	}
+
+	/* Output collected so far is printed before it is copied into the children. */
+	MULTI_PRINTER_print(mp);
+
+	for (i = 0; i < nofRanges; i++) {
+		/* Keep the next nofJobs ranges verified, including the one that is waited for. */
+		while (started < nofRanges && started < i + nofJobs) {
+			VERIFY_JOB *job = &jobs[started % nofJobs];
+
+			if (lastBlocks != NULL) {
+				job->index = index;
+				job->firstBlock = (started == 0) ? 0 : lastBlocks[started - 1] + 1;
+				job->lastBlock = lastBlocks[started];
+			}
+
+			res = verify_job_start(set, mp, err, ksi, ksi_log, verify_signature, 0, job);
+			if (res != KT_OK) goto cleanup;
+			started++;
+		}
+
+		res = verify_job_finish(err, 0, &jobs[i % nofJobs], result);
+		if (res != KT_OK) goto cleanup;
+
+		res = result->res;
+		if (res != KT_OK) goto cleanup;
+
+		/* Record times of all the previous blocks are checked against the current range. */
+		res = logsignature_verify_between_blocks(set, mp, err, ksi, &prev, &result->edges, files);
+		if (res != KT_OK) goto cleanup;
+
+		if (recTimeMax < result->edges.recTimeMax) recTimeMax = result->edges.recTimeMax;
+		prev = result->edges;
+		prev.recTimeMax = recTimeMax;
+	}
+
+	if (prev.lastLeaf_len > 0 && nofRanges > 0) {
+		res = KSI_DataHash_fromImprint(ksi, prev.lastLeaf, prev.lastLeaf_len, &tmp);
+		ERR_CATCH_MSG(err, res, "Error: Unable to create hash from the last leaf of the log signature.");
+	}
+
+	IO_FILES_StorePreviousFileNames(files);
+
+	*lastLeaf = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	/* Without the block index, the child has printed the result already. */
+	if (lastBlocks != NULL) {
+		print_progressDesc(mp, MP_ID_BLOCK, 0, DEBUG_EQUAL | DEBUG_LEVEL_1, "Verifying... ");
+		print_progressResult(mp, MP_ID_BLOCK, DEBUG_LEVEL_1, res);
+	}
+
+	if (jobs != NULL) {
+		for (j = 0; j < nofJobs; j++) verify_job_close(&jobs[j]);
+	}
+
+	KSI_DataHash_free(tmp);
+	BLOCK_INDEX_free(index);
+	free(lastBlocks);
+	free(result);
+	free(jobs);
+
+	return res;
+}
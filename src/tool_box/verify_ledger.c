@@ -0,0 +1,404 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "logksi_err.h"
+#include "smart_file.h"
+#include "verify_ledger.h"
+
+/**
+ * Ledger file layout (all integers are 64-bit big-endian):
+ *   magic "LOGVLG10" | count of files | files
+ * where every file is:
+ *   size of the name | name of the log signature file | count of entries | entries
+ * and every entry is:
+ *   block no | outcome | policy | sig digest | log digest | input hash size | input hash | last leaf size | last leaf
+ * Imprints are padded with zeros to KSI_MAX_IMPRINT_LEN bytes.
+ */
+#define VERIFY_LEDGER_MAGIC "LOGVLG10"
+#define VERIFY_LEDGER_MAGIC_SIZE 8
+#define VERIFY_LEDGER_MAX_NAME_SIZE 0x1000
+#define VERIFY_LEDGER_ENTRY_SIZE (4 * 8 + 3 * VERIFY_LEDGER_DIGEST_SIZE + 2 * KSI_MAX_IMPRINT_LEN)
+
+typedef struct VERIFY_LEDGER_FILE_st {
+	char *name;
+	VERIFY_LEDGER_ENTRY *entries;
+	size_t count;
+} VERIFY_LEDGER_FILE;
+
+struct VERIFY_LEDGER_st {
+	VERIFY_LEDGER_FILE *files;
+	size_t count;
+	unsigned char policy[VERIFY_LEDGER_DIGEST_SIZE];
+};
+
+static void verify_ledger_put_uint64(unsigned char *buf, uint64_t val) {
+	int i;
+
+	for (i = 7; i >= 0; i--) {
+		buf[i] = (unsigned char)(val & 0xff);
+		val >>= 8;
+	}
+}
+
+static uint64_t verify_ledger_get_uint64(const unsigned char *buf) {
+	uint64_t val = 0;
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		val = (val << 8) | buf[i];
+	}
+
+	return val;
+}
+
+static void verify_ledger_entry_serialize(const VERIFY_LEDGER_ENTRY *entry, unsigned char *buf) {
+	memset(buf, 0, VERIFY_LEDGER_ENTRY_SIZE);
+
+	verify_ledger_put_uint64(buf, entry->blockNo);
+	buf += 8;
+	verify_ledger_put_uint64(buf, (uint64_t)(unsigned int)entry->outcome);
+	buf += 8;
+	memcpy(buf, entry->policy, VERIFY_LEDGER_DIGEST_SIZE);
+	buf += VERIFY_LEDGER_DIGEST_SIZE;
+	memcpy(buf, entry->sigDigest, VERIFY_LEDGER_DIGEST_SIZE);
+	buf += VERIFY_LEDGER_DIGEST_SIZE;
+	memcpy(buf, entry->logDigest, VERIFY_LEDGER_DIGEST_SIZE);
+	buf += VERIFY_LEDGER_DIGEST_SIZE;
+	verify_ledger_put_uint64(buf, entry->inputHash_len);
+	buf += 8;
+	memcpy(buf, entry->inputHash, entry->inputHash_len);
+	buf += KSI_MAX_IMPRINT_LEN;
+	verify_ledger_put_uint64(buf, entry->lastLeaf_len);
+	buf += 8;
+	memcpy(buf, entry->lastLeaf, entry->lastLeaf_len);
+}
+
+static int verify_ledger_entry_parse(const unsigned char *buf, VERIFY_LEDGER_ENTRY *entry) {
+	memset(entry, 0, sizeof(VERIFY_LEDGER_ENTRY));
+
+	entry->blockNo = verify_ledger_get_uint64(buf);
+	buf += 8;
+	entry->outcome = (int)(unsigned int)verify_ledger_get_uint64(buf);
+	buf += 8;
+	memcpy(entry->policy, buf, VERIFY_LEDGER_DIGEST_SIZE);
+	buf += VERIFY_LEDGER_DIGEST_SIZE;
+	memcpy(entry->sigDigest, buf, VERIFY_LEDGER_DIGEST_SIZE);
+	buf += VERIFY_LEDGER_DIGEST_SIZE;
+	memcpy(entry->logDigest, buf, VERIFY_LEDGER_DIGEST_SIZE);
+	buf += VERIFY_LEDGER_DIGEST_SIZE;
+	entry->inputHash_len = (size_t)verify_ledger_get_uint64(buf);
+	buf += 8;
+	if (entry->inputHash_len > KSI_MAX_IMPRINT_LEN) return KT_INVALID_INPUT_FORMAT;
+	memcpy(entry->inputHash, buf, entry->inputHash_len);
+	buf += KSI_MAX_IMPRINT_LEN;
+	entry->lastLeaf_len = (size_t)verify_ledger_get_uint64(buf);
+	buf += 8;
+	if (entry->lastLeaf_len > KSI_MAX_IMPRINT_LEN) return KT_INVALID_INPUT_FORMAT;
+	memcpy(entry->lastLeaf, buf, entry->lastLeaf_len);
+
+	return KT_OK;
+}
+
+static int verify_ledger_read_all(SMART_FILE *in, unsigned char *buf, size_t len) {
+	int res;
+	size_t count = 0;
+
+	res = SMART_FILE_read(in, buf, len, &count);
+	if (res != SMART_FILE_OK) return res;
+
+	return (count == len) ? KT_OK : KT_INVALID_INPUT_FORMAT;
+}
+
+static VERIFY_LEDGER_FILE *verify_ledger_find_file(VERIFY_LEDGER *ledger, const char *sigFname) {
+	size_t i;
+
+	for (i = 0; i < ledger->count; i++) {
+		if (strcmp(ledger->files[i].name, sigFname) == 0) return &ledger->files[i];
+	}
+
+	return NULL;
+}
+
+int VERIFY_LEDGER_new(VERIFY_LEDGER **ledger) {
+	VERIFY_LEDGER *tmp = NULL;
+
+	if (ledger == NULL) return KT_INVALID_ARGUMENT;
+
+	tmp = (VERIFY_LEDGER*)malloc(sizeof(VERIFY_LEDGER));
+	if (tmp == NULL) return KT_OUT_OF_MEMORY;
+
+	tmp->files = NULL;
+	tmp->count = 0;
+	memset(tmp->policy, 0, sizeof(tmp->policy));
+
+	*ledger = tmp;
+
+	return KT_OK;
+}
+
+void VERIFY_LEDGER_free(VERIFY_LEDGER *ledger) {
+	size_t i;
+
+	if (ledger == NULL) return;
+
+	for (i = 0; i < ledger->count; i++) {
+		free(ledger->files[i].name);
+		free(ledger->files[i].entries);
+	}
+
+	free(ledger->files);
+	free(ledger);
+}
+
+void VERIFY_LEDGER_setPolicy(VERIFY_LEDGER *ledger, const unsigned char *policy) {
+	if (ledger == NULL || policy == NULL) return;
+	memcpy(ledger->policy, policy, VERIFY_LEDGER_DIGEST_SIZE);
+}
+
+const unsigned char *VERIFY_LEDGER_getPolicy(VERIFY_LEDGER *ledger) {
+	return (ledger == NULL) ? NULL : ledger->policy;
+}
+
+const VERIFY_LEDGER_ENTRY *VERIFY_LEDGER_get(VERIFY_LEDGER *ledger, const char *sigFname, uint64_t blockNo) {
+	VERIFY_LEDGER_FILE *file = NULL;
+
+	if (ledger == NULL || sigFname == NULL || blockNo == 0) return NULL;
+
+	file = verify_ledger_find_file(ledger, sigFname);
+	if (file == NULL || blockNo > file->count) return NULL;
+
+	return &file->entries[blockNo - 1];
+}
+
+int VERIFY_LEDGER_set(VERIFY_LEDGER *ledger, const char *sigFname, const VERIFY_LEDGER_ENTRY *entries, size_t count) {
+	VERIFY_LEDGER_FILE *file = NULL;
+	VERIFY_LEDGER_ENTRY *tmp = NULL;
+	size_t i;
+
+	if (ledger == NULL || sigFname == NULL || (entries == NULL && count > 0)) return KT_INVALID_ARGUMENT;
+
+	for (i = 0; i < count; i++) {
+		if (entries[i].blockNo != i + 1) return KT_INVALID_ARGUMENT;
+	}
+
+	file = verify_ledger_find_file(ledger, sigFname);
+
+	if (count == 0) {
+		if (file != NULL) {
+			free(file->name);
+			free(file->entries);
+			*file = ledger->files[ledger->count - 1];
+			ledger->count--;
+		}
+		return KT_OK;
+	}
+
+	tmp = (VERIFY_LEDGER_ENTRY*)malloc(count * sizeof(VERIFY_LEDGER_ENTRY));
+	if (tmp == NULL) return KT_OUT_OF_MEMORY;
+	memcpy(tmp, entries, count * sizeof(VERIFY_LEDGER_ENTRY));
+
+	if (file == NULL) {
+		VERIFY_LEDGER_FILE *files = NULL;
+		char *name = NULL;
+
+		name = (char*)malloc(strlen(sigFname) + 1);
+		files = (VERIFY_LEDGER_FILE*)realloc(ledger->files, (ledger->count + 1) * sizeof(VERIFY_LEDGER_FILE));
+		if (files != NULL) ledger->files = files;
+
+		if (name == NULL || files == NULL) {
+			free(name);
+			free(tmp);
+			return KT_OUT_OF_MEMORY;
+		}
+
+		strcpy(name, sigFname);
+		file = &ledger->files[ledger->count];
+		file->name = name;
+		file->entries = NULL;
+		ledger->count++;
+	}
+
+	free(file->entries);
+	file->entries = tmp;
+	file->count = count;
+
+	return KT_OK;
+}
+
+int VERIFY_LEDGER_write(VERIFY_LEDGER *ledger, const char *fname) {
+	int res = KT_UNKNOWN_ERROR;
+	SMART_FILE *out = NULL;
+	unsigned char buf[VERIFY_LEDGER_ENTRY_SIZE];
+	unsigned char len_buf[8];
+	unsigned char count_buf[8];
+	SMART_FILE_IOVEC iov[3];
+	size_t i;
+	size_t j;
+
+	if (ledger == NULL || fname == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	res = SMART_FILE_open(fname, "wbT", &out);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	memcpy(buf, VERIFY_LEDGER_MAGIC, VERIFY_LEDGER_MAGIC_SIZE);
+	verify_ledger_put_uint64(buf + VERIFY_LEDGER_MAGIC_SIZE, ledger->count);
+
+	res = SMART_FILE_write(out, buf, VERIFY_LEDGER_MAGIC_SIZE + 8, NULL);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	for (i = 0; i < ledger->count; i++) {
+		const VERIFY_LEDGER_FILE *file = &ledger->files[i];
+		size_t name_len = strlen(file->name);
+
+		verify_ledger_put_uint64(len_buf, name_len);
+		verify_ledger_put_uint64(count_buf, file->count);
+
+		iov[0].raw = len_buf;
+		iov[0].raw_len = sizeof(len_buf);
+		iov[1].raw = (const unsigned char*)file->name;
+		iov[1].raw_len = name_len;
+		iov[2].raw = count_buf;
+		iov[2].raw_len = sizeof(count_buf);
+
+		res = SMART_FILE_writev(out, iov, 3, NULL);
+		if (res != SMART_FILE_OK) goto cleanup;
+
+		for (j = 0; j < file->count; j++) {
+			verify_ledger_entry_serialize(&file->entries[j], buf);
+
+			res = SMART_FILE_write(out, buf, VERIFY_LEDGER_ENTRY_SIZE, NULL);
+			if (res != SMART_FILE_OK) goto cleanup;
+		}
+	}
+
+	res = SMART_FILE_markConsistent(out);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	res = SMART_FILE_close(out);
+	out = NULL;
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	res = KT_OK;
+
+cleanup:
+
+	SMART_FILE_close(out);
+
+	return res;
+}
+
+int VERIFY_LEDGER_read(const char *fname, VERIFY_LEDGER **ledger) {
+	int res = KT_UNKNOWN_ERROR;
+	SMART_FILE *in = NULL;
+	VERIFY_LEDGER *tmp = NULL;
+	VERIFY_LEDGER_ENTRY *entries = NULL;
+	unsigned char buf[VERIFY_LEDGER_ENTRY_SIZE];
+	char name[VERIFY_LEDGER_MAX_NAME_SIZE + 1];
+	uint64_t nofFiles = 0;
+	uint64_t i;
+	uint64_t j;
+
+	if (fname == NULL || ledger == NULL) {
+		res = KT_INVALID_ARGUMENT;
+		goto cleanup;
+	}
+
+	res = SMART_FILE_open(fname, "rb", &in);
+	if (res != SMART_FILE_OK) goto cleanup;
+
+	res = verify_ledger_read_all(in, buf, VERIFY_LEDGER_MAGIC_SIZE + 8);
+	if (res != KT_OK) goto cleanup;
+
+	if (memcmp(buf, VERIFY_LEDGER_MAGIC, VERIFY_LEDGER_MAGIC_SIZE) != 0) {
+		res = KT_INVALID_INPUT_FORMAT;
+		goto cleanup;
+	}
+
+	nofFiles = verify_ledger_get_uint64(buf + VERIFY_LEDGER_MAGIC_SIZE);
+
+	res = VERIFY_LEDGER_new(&tmp);
+	if (res != KT_OK) goto cleanup;
+
+	for (i = 0; i < nofFiles; i++) {
+		uint64_t name_len = 0;
+		uint64_t count = 0;
+
+		res = verify_ledger_read_all(in, buf, 8);
+		if (res != KT_OK) goto cleanup;
+
+		name_len = verify_ledger_get_uint64(buf);
+		if (name_len == 0 || name_len > VERIFY_LEDGER_MAX_NAME_SIZE) {
+			res = KT_INVALID_INPUT_FORMAT;
+			goto cleanup;
+		}
+
+		res = verify_ledger_read_all(in, (unsigned char*)name, name_len);
+		if (res != KT_OK) goto cleanup;
+		name[name_len] = '\0';
+
+		res = verify_ledger_read_all(in, buf, 8);
+		if (res != KT_OK) goto cleanup;
+
+		count = verify_ledger_get_uint64(buf);
+		if (count == 0 || count > SIZE_MAX / sizeof(VERIFY_LEDGER_ENTRY)) {
+			res = KT_INVALID_INPUT_FORMAT;
+			goto cleanup;
+		}
+
+		entries = (VERIFY_LEDGER_ENTRY*)malloc(count * sizeof(VERIFY_LEDGER_ENTRY));
+		if (entries == NULL) {
+			res = KT_OUT_OF_MEMORY;
+			goto cleanup;
+		}
+
+		for (j = 0; j < count; j++) {
+			res = verify_ledger_read_all(in, buf, VERIFY_LEDGER_ENTRY_SIZE);
+			if (res != KT_OK) goto cleanup;
+
+			res = verify_ledger_entry_parse(buf, &entries[j]);
+			if (res != KT_OK) goto cleanup;
+		}
+
+		res = VERIFY_LEDGER_set(tmp, name, entries, count);
+		if (res != KT_OK) {
+			if (res == KT_INVALID_ARGUMENT) res = KT_INVALID_INPUT_FORMAT;
+			goto cleanup;
+		}
+
+		free(entries);
+		entries = NULL;
+	}
+
+	*ledger = tmp;
+	tmp = NULL;
+	res = KT_OK;
+
+cleanup:
+
+	SMART_FILE_close(in);
+	VERIFY_LEDGER_free(tmp);
+	free(entries);
+
+	return res;
+}
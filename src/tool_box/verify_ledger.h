@@ -0,0 +1,110 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+
+#ifndef VERIFY_LEDGER_H
+#define	VERIFY_LEDGER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <ksi/ksi.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/* Size of the SHA-256 digests kept in the ledger. */
+#define VERIFY_LEDGER_DIGEST_SIZE 32
+
+typedef struct VERIFY_LEDGER_st VERIFY_LEDGER;
+
+typedef struct VERIFY_LEDGER_ENTRY_st {
+	uint64_t blockNo;									/* Number of the block, starting from 1. */
+	int outcome;										/* Verification result of the block, KT_OK if the block was verified successfully. */
+	unsigned char policy[VERIFY_LEDGER_DIGEST_SIZE];	/* Digest of the verification policy (see #VERIFY_LEDGER_setPolicy). */
+	unsigned char sigDigest[VERIFY_LEDGER_DIGEST_SIZE];	/* Digest of the block in the log signature file, from the block header to the block signature. */
+	unsigned char logDigest[VERIFY_LEDGER_DIGEST_SIZE];	/* Digest of the log lines of the block. */
+	unsigned char inputHash[KSI_MAX_IMPRINT_LEN];		/* Imprint of the input hash of the block (the last leaf of the previous block). */
+	size_t inputHash_len;								/* Size of the input hash imprint or 0 if not known. */
+	unsigned char lastLeaf[KSI_MAX_IMPRINT_LEN];		/* Imprint of the last leaf of the block. */
+	size_t lastLeaf_len;								/* Size of the last leaf imprint or 0 if not known. */
+} VERIFY_LEDGER_ENTRY;
+
+/**
+ * Creates an empty verification ledger. The ledger keeps the verification results of
+ * the blocks of log signature files, so that the blocks that are not changed since
+ * the last verification can be skipped. The ledger is kept in a file (see
+ * #VERIFY_LEDGER_write) between the runs.
+ * \param ledger		Output parameter for the ledger.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int VERIFY_LEDGER_new(VERIFY_LEDGER **ledger);
+void VERIFY_LEDGER_free(VERIFY_LEDGER *ledger);
+
+/**
+ * Sets the digest of the verification policy that is used in the current run. Entries
+ * made with a different policy are not used to skip the blocks.
+ */
+void VERIFY_LEDGER_setPolicy(VERIFY_LEDGER *ledger, const unsigned char *policy);
+const unsigned char *VERIFY_LEDGER_getPolicy(VERIFY_LEDGER *ledger);
+
+/**
+ * Returns the entry of the block of the log signature file or \c NULL if there is no
+ * such entry.
+ * \param ledger		Ledger object.
+ * \param sigFname		Name of the log signature file.
+ * \param blockNo		Number of the block, starting from 1.
+ */
+const VERIFY_LEDGER_ENTRY *VERIFY_LEDGER_get(VERIFY_LEDGER *ledger, const char *sigFname, uint64_t blockNo);
+
+/**
+ * Replaces all the entries of the log signature file. Entries must be given in the
+ * order of blocks, starting from block 1.
+ * \param ledger		Ledger object.
+ * \param sigFname		Name of the log signature file.
+ * \param entries		Array of entries.
+ * \param count			Count of entries. If 0, the log signature file is removed from the ledger.
+ * \return KT_OK if successful, KT_INVALID_ARGUMENT if the entries are not in the order of blocks,
+ * error code otherwise.
+ */
+int VERIFY_LEDGER_set(VERIFY_LEDGER *ledger, const char *sigFname, const VERIFY_LEDGER_ENTRY *entries, size_t count);
+
+/**
+ * Writes the ledger file. The file is written to a temporary file first and renamed
+ * when complete.
+ * \param ledger		Ledger object.
+ * \param fname			Name of the ledger file.
+ * \return KT_OK if successful, error code otherwise.
+ */
+int VERIFY_LEDGER_write(VERIFY_LEDGER *ledger, const char *fname);
+
+/**
+ * Reads the ledger file.
+ * \param fname			Name of the ledger file.
+ * \param ledger		Output parameter for the ledger.
+ * \return KT_OK if successful, KT_INVALID_INPUT_FORMAT if the ledger file is corrupted,
+ * error code otherwise.
+ */
+int VERIFY_LEDGER_read(const char *fname, VERIFY_LEDGER **ledger);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* VERIFY_LEDGER_H */
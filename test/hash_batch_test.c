@@ -0,0 +1,233 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+/**
+ * Known-answer test of the SHA-256 kernels of HASH_BATCH (see test/test_suites/hash_batch.bats).
+ * Every kernel supported by the CPU is forced in turn and the digests of messages around the
+ * padding boundaries are compared with the known answers. Batches are hashed with counts below
+ * and above the lane threshold of the multi-buffer kernels, so idle and refilled lanes are
+ * covered as well.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ksi/ksi.h>
+#include "logksi_err.h"
+#include "hash_batch.h"
+
+#define DIGEST_SIZE 32
+#define MAX_MESSAGE_LEN 1000
+#define MAX_BATCH_SIZE 40
+
+typedef struct {
+	/* Message text. If NULL, byte i of the message is (i * 31 + len) & 0xff. */
+	const char *text;
+	size_t len;
+	const char *digest;
+} KNOWN_ANSWER;
+
+static const KNOWN_ANSWER known_answers[] = {
+	{NULL, 0, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+	{NULL, 1, "4bf5122f344554c53bde2ebb8cd2b7e3d1600ad631c385a5d7cce23c7785459a"},
+	{"abc", 3, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+	{NULL, 55, "0c74b286e2c8b409ed0fd89f5a8344aeb274bda5d9bfbe7b8e537cfc6142736d"},
+	{NULL, 56, "8136496fb4867a08f8c0f1afaf000ef4093ecc2d544f4f808ef9d5945ca4c2fa"},
+	{"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 56, "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+	{NULL, 63, "a7c6fa71b10f6f7bd8ce26f79db5693d265b2cde42e61955077e77c8764bc26f"},
+	{NULL, 64, "3ea97ec766b8247739939247b4d4cb362cf13c100deb0cc2ba5391f762023852"},
+	{NULL, 65, "7fc8e770811fb1035a2279b782a7b04024fe6a2229e9bb11a99686d3ca65f4a7"},
+	{"abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu", 112, "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1"},
+	{NULL, 119, "6cf3e40eee6bd154b923dbbe0b421de7934af82282113dd285bb895e4bb3f8f7"},
+	{NULL, 120, "696e486e83239a511feef5f0b438da322fa51490489668162c6ed9a9c6ad8055"},
+	{NULL, 127, "2bcc276222962a8489f66518df75ceb051de1e5fcf9cec388ced69ef82dcbe12"},
+	{NULL, 128, "3b35116c160c0ffdaf1287960af39caf2760811b02a36e3bd5294bdd61eea9a9"},
+	{NULL, 1000, "44a1b8c5e1f8849fc62fcbfadd4f4ab312021e40f8e16b2a4f9307493ca45102"}
+};
+
+#define NOF_KNOWN_ANSWERS (sizeof(known_answers) / sizeof(known_answers[0]))
+
+static const char *kernels[] = {"libksi", "generic", "sha-ni", "avx2", "avx512"};
+
+/* Lane thresholds are 4 and 8 (avx2 and avx512), full lanes 8 and 16. */
+static const size_t batch_sizes[] = {1, 3, 4, 7, 8, 9, 15, 16, 17, MAX_BATCH_SIZE};
+
+static unsigned char messages[NOF_KNOWN_ANSWERS][MAX_MESSAGE_LEN];
+static unsigned char digests[NOF_KNOWN_ANSWERS][DIGEST_SIZE];
+
+static int hex_to_digest(const char *hex, unsigned char *digest) {
+	size_t i;
+
+	if (strlen(hex) != DIGEST_SIZE * 2) return KT_INVALID_ARGUMENT;
+
+	for (i = 0; i < DIGEST_SIZE; i++) {
+		unsigned int b = 0;
+		if (sscanf(hex + i * 2, "%2x", &b) != 1) return KT_INVALID_HEX_CHAR;
+		digest[i] = (unsigned char)b;
+	}
+
+	return KT_OK;
+}
+
+static int init_known_answers(void) {
+	int res = KT_UNKNOWN_ERROR;
+	size_t i;
+	size_t n;
+
+	for (i = 0; i < NOF_KNOWN_ANSWERS; i++) {
+		const KNOWN_ANSWER *ka = &known_answers[i];
+
+		if (ka->text != NULL) {
+			memcpy(messages[i], ka->text, ka->len);
+		} else {
+			for (n = 0; n < ka->len; n++) messages[i][n] = (unsigned char)((n * 31 + ka->len) & 0xff);
+		}
+
+		res = hex_to_digest(ka->digest, digests[i]);
+		if (res != KT_OK) return res;
+	}
+
+	return KT_OK;
+}
+
+/* Message j of a batch is known answer (j + offset) % NOF_KNOWN_ANSWERS, so lengths differ between lanes. */
+static int test_batch(HASH_BATCH *batch, const char *kernel, size_t count, size_t offset, size_t *tested) {
+	int res = KT_UNKNOWN_ERROR;
+	const unsigned char *data[MAX_BATCH_SIZE];
+	size_t data_len[MAX_BATCH_SIZE];
+	KSI_DataHash *hashes[MAX_BATCH_SIZE];
+	size_t j;
+
+	for (j = 0; j < count; j++) {
+		size_t k = (j + offset) % NOF_KNOWN_ANSWERS;
+		data[j] = messages[k];
+		data_len[j] = known_answers[k].len;
+		hashes[j] = NULL;
+	}
+
+	res = HASH_BATCH_calculate(batch, KSI_HASHALG_SHA2_256, data, data_len, count, hashes);
+	if (res != KT_OK) {
+		fprintf(stderr, "Kernel %s: unable to hash a batch of %zu message(s) (%s).\n", kernel, count, LOGKSI_errToString(res));
+		goto cleanup;
+	}
+
+	for (j = 0; j < count; j++) {
+		size_t k = (j + offset) % NOF_KNOWN_ANSWERS;
+		KSI_HashAlgorithm algo = KSI_HASHALG_INVALID_VALUE;
+		const unsigned char *digest = NULL;
+		size_t digest_len = 0;
+
+		res = KSI_DataHash_extract(hashes[j], &algo, &digest, &digest_len);
+		if (res != KSI_OK) goto cleanup;
+
+		if (algo != KSI_HASHALG_SHA2_256 || digest_len != DIGEST_SIZE || memcmp(digest, digests[k], DIGEST_SIZE) != 0) {
+			fprintf(stderr, "Kernel %s: wrong digest of a %zu byte message (message %zu of a batch of %zu).\n", kernel, known_answers[k].len, j, count);
+			res = KT_UNKNOWN_ERROR;
+			goto cleanup;
+		}
+
+		(*tested)++;
+	}
+
+	res = KT_OK;
+
+cleanup:
+
+	for (j = 0; j < count; j++) KSI_DataHash_free(hashes[j]);
+
+	return res;
+}
+
+static int test_kernel(HASH_BATCH *batch, const char *kernel, size_t *tested) {
+	int res = KT_UNKNOWN_ERROR;
+	size_t i;
+	size_t offset;
+
+	for (i = 0; i < sizeof(batch_sizes) / sizeof(batch_sizes[0]); i++) {
+		for (offset = 0; offset < NOF_KNOWN_ANSWERS; offset++) {
+			res = test_batch(batch, kernel, batch_sizes[i], offset, tested);
+			if (res != KT_OK) return res;
+		}
+	}
+
+	return KT_OK;
+}
+
+int main(int argc, char** argv) {
+	int res = KT_UNKNOWN_ERROR;
+	HASH_BATCH *batch = NULL;
+	unsigned char digest[DIGEST_SIZE];
+	size_t nofKernels = 0;
+	size_t tested = 0;
+	size_t i;
+
+	if (argc != 1) {
+		fprintf(stderr, "Usage:\n  %s\n", argv[0]);
+		return 3;
+	}
+
+	res = init_known_answers();
+	if (res != KT_OK) goto cleanup;
+
+	res = HASH_BATCH_new(NULL, &batch);
+	if (res != KT_OK) goto cleanup;
+
+	printf("Hash batch: default kernel is %s.\n", HASH_BATCH_getKernelName(batch));
+
+	for (i = 0; i < NOF_KNOWN_ANSWERS; i++) {
+		res = HASH_BATCH_sha256(messages[i], known_answers[i].len, digest);
+		if (res != KT_OK) goto cleanup;
+
+		if (memcmp(digest, digests[i], DIGEST_SIZE) != 0) {
+			fprintf(stderr, "Single digest: wrong digest of a %zu byte message.\n", known_answers[i].len);
+			res = KT_UNKNOWN_ERROR;
+			goto cleanup;
+		}
+	}
+
+	for (i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++) {
+		size_t count = 0;
+
+		res = HASH_BATCH_setKernel(batch, kernels[i]);
+		if (res == KT_INVALID_ARGUMENT) {
+			printf("Kernel %s: not supported, skipped.\n", kernels[i]);
+			continue;
+		} else if (res != KT_OK) {
+			goto cleanup;
+		}
+
+		res = test_kernel(batch, kernels[i], &count);
+		if (res != KT_OK) goto cleanup;
+
+		printf("Kernel %s: %zu digest(s) ok.\n", kernels[i], count);
+		tested += count;
+		nofKernels++;
+	}
+
+	printf("Hash batch: %zu kernel(s) tested, %zu digest(s) ok.\n", nofKernels, tested);
+	res = KT_OK;
+
+cleanup:
+
+	if (res != KT_OK) fprintf(stderr, "Error: Hash batch test failed (%s).\n", LOGKSI_errToString(res));
+
+	HASH_BATCH_free(batch);
+
+	return res == KT_OK ? 0 : 1;
+}
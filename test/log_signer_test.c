@@ -0,0 +1,103 @@
+/*
+ * Copyright 2013-2022 Guardtime, Inc.
+ *
+ * This file is part of the Guardtime client SDK.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES, CONDITIONS, OR OTHER LICENSES OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ * "Guardtime" and "KSI" are trademarks or registered trademarks of
+ * Guardtime, Inc., and no license to trademarks is granted; Guardtime
+ * reserves and retains all trademark rights.
+ */
+
+/**
+ * Test program of the log signer library interface (see test/test_suites/log_signer.bats).
+ * Log records are read from stdin, one record per line, signed with LOG_SIGNER and the
+ * log signature file is written by the sink, so it can be verified with logksi verify.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ksi/ksi.h>
+#include "logksi_err.h"
+#include "log_signer.h"
+
+static int write_sink(void *ctx, size_t blockNo, size_t recordCount, const unsigned char *data, size_t data_len) {
+	FILE *out = ctx;
+
+	(void)blockNo;
+	(void)recordCount;
+
+	if (fwrite(data, 1, data_len, out) != data_len) return KT_IO_ERROR;
+
+	return KT_OK;
+}
+
+int main(int argc, char** argv) {
+	int res = KT_UNKNOWN_ERROR;
+	KSI_CTX *ksi = NULL;
+	LOG_SIGNER *signer = NULL;
+	FILE *out = NULL;
+	char buf[0x10000];
+	size_t len = 0;
+	size_t count = 0;
+
+	if (argc != 7) {
+		fprintf(stderr, "Usage:\n  %s <aggr-url> <aggr-user> <aggr-key> <random> <blk-size> <out-file> < log\n", argv[0]);
+		return 3;
+	}
+
+	res = KSI_CTX_new(&ksi);
+	if (res != KSI_OK) goto cleanup;
+
+	res = LOG_SIGNER_new(ksi, argv[1], argv[2], argv[3], KSI_HASHALG_SHA2_256, 4, &signer);
+	if (res != KT_OK) goto cleanup;
+
+	res = LOG_SIGNER_setRandomSource(signer, argv[4]);
+	if (res != KT_OK) goto cleanup;
+
+	res = LOG_SIGNER_setBlockLimits(signer, (size_t)atol(argv[5]), 0);
+	if (res != KT_OK) goto cleanup;
+
+	out = fopen(argv[6], "wb");
+	if (out == NULL) {
+		res = KT_IO_ERROR;
+		goto cleanup;
+	}
+
+	res = LOG_SIGNER_setSink(signer, out, write_sink);
+	if (res != KT_OK) goto cleanup;
+
+	while (fgets(buf, sizeof(buf), stdin) != NULL) {
+		len = strlen(buf);
+		if (len > 0 && buf[len - 1] == '\n') len--;
+
+		res = LOG_SIGNER_addRecord(signer, (unsigned char*)buf, len);
+		if (res != KT_OK) goto cleanup;
+		count++;
+	}
+
+	res = LOG_SIGNER_close(signer);
+	if (res != KT_OK) goto cleanup;
+
+	printf("Log signer: %zu record(s) signed.\n", count);
+	res = KT_OK;
+
+cleanup:
+
+	if (res != KT_OK) fprintf(stderr, "Error: Log signer failed (%s).\n", LOGKSI_errToString(res));
+
+	if (out != NULL) fclose(out);
+	LOG_SIGNER_free(signer);
+	KSI_CTX_free(ksi);
+
+	return res == KT_OK ? 0 : 1;
+}
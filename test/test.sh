@@ -52,6 +52,8 @@ test/test_suites/hash_check.bats \
 test/test_suites/extract.bats \
 test/test_suites/extract_debug_output.bats \
 test/test_suites/extract_cmd.bats \
+test/test_suites/index.bats \
+test/test_suites/daemon.bats \
 test/test_suites/treehash_check.bats \
 test/test_suites/legacy.bats \
 test/test_suites/verify_linking.bats \
@@ -71,6 +73,9 @@ test/test_suites/create_log_file_list.bats \
 test/test_suites/create_rebuild.bats \
 test/test_suites/create_state_file.bats \
 test/test_suites/create_state_file_cmd.bats \
+test/test_suites/create_follow.bats \
+test/test_suites/log_signer.bats \
+test/test_suites/hash_batch.bats \
 $TEST_DEPENDING_ON_KSI_TOOL \
 $TEST_DEPENDING_ON_TLVUTIL \
 $TEST_DEPENDING_ON_URANDOM
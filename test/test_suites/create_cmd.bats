@@ -104,6 +104,24 @@ mkdir -p test/out/dummy_dir
 	[[ "$output" =~ (Integer value is too small).*(blk-size).*('0') ]]
 }
 
+@test "create CMD test: try to use max-pending 0"  {
+	run src/logksi create test/out/dummy_cmd --blk-size 4 --max-pending 0 --seed test/resource/random/seed_aa
+	[ "$status" -eq 3 ]
+	[[ "$output" =~ (Integer value is too small).*(max-pending).*('0') ]]
+}
+
+@test "create CMD test: try to use batch-size 0"  {
+	run src/logksi create test/out/dummy_cmd --blk-size 4 --batch-size 0 --seed test/resource/random/seed_aa
+	[ "$status" -eq 3 ]
+	[[ "$output" =~ (Integer value is too small).*(batch-size).*('0') ]]
+}
+
+@test "create CMD test: try to use threads 0"  {
+	run src/logksi create test/out/dummy_cmd --blk-size 4 --threads 0 --seed test/resource/random/seed_aa
+	[ "$status" -eq 3 ]
+	[[ "$output" =~ (Integer value is too small).*(threads).*('0') ]]
+}
+
 @test "create CMD test: try to use blk-size larger than provided by max-lvl"  {
 	run src/logksi create test/out/dummy_cmd --max-lvl 9 --blk-size 257 --seed test/resource/random/seed_aa
 	[ "$status" -eq 3 ]
@@ -244,3 +262,53 @@ mkdir -p test/out/dummy_dir
 	[ "$status" -eq 3 ]
 	[[ "$output" =~ (File does not exist).*(Parameter).*(from).*('CMD').*([-][-]).*('-') ]]
 }
+
+@test "create CMD test: try to follow more than one log file"  {
+	run src/logksi create --blk-size 4 --seed test/resource/random/seed_aa --follow --sig-dir test/out/dummy_dir -- test/out/dummy_cmd test/out/dummy_cmd
+	[ "$status" -eq 3 ]
+	[[ "$output" =~ (Error: Only a single log file).*(can be followed with --follow) ]]
+
+	run src/logksi create --blk-size 4 --seed test/resource/random/seed_aa --follow --log-from-stdin -o test/out/dummy_dir/follow.logsig
+	[ "$status" -eq 3 ]
+	[[ "$output" =~ (Error: Only a single log file).*(can be followed with --follow) ]]
+}
+
+@test "create CMD test: try to use --follow with --threads"  {
+	run src/logksi create test/out/dummy_cmd --blk-size 4 --seed test/resource/random/seed_aa --follow --threads 2 -o test/out/dummy_dir/follow.logsig
+	[ "$status" -eq 3 ]
+	[[ "$output" =~ (Error: It is not possible to use --follow together with) ]]
+}
+
+@test "create CMD test: try to use --follow with --jobs"  {
+	run src/logksi create test/out/dummy_cmd --blk-size 4 --seed test/resource/random/seed_aa --follow --jobs 2 -o test/out/dummy_dir/follow.logsig
+	[ "$status" -eq 3 ]
+	[[ "$output" =~ (Error: It is not possible to use --follow together with) ]]
+}
+
+@test "create CMD test: try to use jobs 0 and random seed from stdin with --jobs"  {
+	run src/logksi create --blk-size 4 --jobs 0 --seed test/resource/random/seed_aa -- test/out/dummy_cmd test/out/dummy_cmd
+	[ "$status" -eq 3 ]
+	[[ "$output" =~ (Integer value is too small).*(jobs).*('0') ]]
+
+	run bash -c "cat test/resource/random/seed_aa | src/logksi create --blk-size 4 --jobs 2 --seed - -- test/out/dummy_cmd test/out/dummy_cmd"
+	[ "$status" -eq 3 ]
+	[[ "$output" =~ (Error: It is not possible to read random seed from stdin with --jobs) ]]
+}
+
+@test "create CMD test: try to write log signature of followed log file to stdout"  {
+	run src/logksi create test/out/dummy_cmd --blk-size 4 --seed test/resource/random/seed_aa --follow -o -
+	[ "$status" -eq 3 ]
+	[[ "$output" =~ (Error: Log signature of a followed log file can not be written to stdout) ]]
+}
+
+@test "create CMD test: try to use blk-time 0"  {
+	run src/logksi create test/out/dummy_cmd --blk-size 4 --blk-time 0 --seed test/resource/random/seed_aa
+	[ "$status" -eq 3 ]
+	[[ "$output" =~ (Integer value is too small).*(blk-time).*('0') ]]
+}
+
+@test "create CMD test: try to use blk-time without follow"  {
+	run src/logksi create test/out/dummy_cmd --blk-size 4 --blk-time 1 --seed test/resource/random/seed_aa -o test/out/dummy_dir/blk_time.logsig
+	[ "$status" -eq 3 ]
+	[[ "$output" =~ (Error: It is not possible to use --blk-time without --follow) ]]
+}
@@ -0,0 +1,126 @@
+#!/bin/bash
+
+export KSI_CONF=test/test.cfg
+
+# Follows the log file for the given count of seconds and ends following with SIGTERM.
+# Usage: follow_log <log file> <seconds> [options]
+follow_log () {
+	local log=$1
+	local seconds=$2
+	shift 2
+	./src/logksi create "$log" --follow --blk-size 2 "$@" &
+	local pid=$!
+	sleep "$seconds"
+	kill -TERM $pid
+	wait $pid
+}
+
+setup() {
+	mkdir -p test/out/follow
+}
+
+@test "create --follow: sign log lines appended to a growing log file" {
+	rm -f test/out/follow/grow.log*
+	printf "line 1\nline 2\nline 3\n" > test/out/follow/grow.log
+	(sleep 2; printf "line 4\nline 5\n" >> test/out/follow/grow.log; sleep 1; printf "line 6\n" >> test/out/follow/grow.log) &
+	run follow_log test/out/follow/grow.log 5 -d
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Log file 'test/out/follow/grow.log'." ]]
+	run ./src/logksi verify test/out/follow/grow.log -d
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ (Count of record hashes:).*( 6) ]]
+	[[ "$output" =~ "Finalizing log signature... ok." ]]
+}
+
+@test "create --follow: sign log lines that end with CR and CR LF" {
+	rm -f test/out/follow/cr.log*
+	printf "line 1\rline 2\rline 3\r" > test/out/follow/cr.log
+	(sleep 2; printf "line 4\r" >> test/out/follow/cr.log; sleep 1; printf "\nline 5\r\n" >> test/out/follow/cr.log) &
+	run follow_log test/out/follow/cr.log 5 -d
+	[ "$status" -eq 0 ]
+	run ./src/logksi verify test/out/follow/cr.log -d
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ (Count of record hashes:).*( 5) ]]
+	[[ "$output" =~ "Finalizing log signature... ok." ]]
+}
+
+@test "create --follow: blocks are written into log signature file before following ends" {
+	rm -f test/out/follow/early.log*
+	printf "line 1\nline 2\nline 3\nline 4\n" > test/out/follow/early.log
+	./src/logksi create test/out/follow/early.log --follow --blk-size 2 &
+	pid=$!
+	sleep 3
+	run test -s test/out/follow/early.log.logsig
+	early_status=$status
+	kill -TERM $pid
+	wait $pid
+	[ "$early_status" -eq 0 ]
+	run ./src/logksi verify test/out/follow/early.log -d
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ (Count of record hashes:).*( 4) ]]
+}
+
+@test "create --follow: SIGTERM closes and signs the last block" {
+	rm -f test/out/follow/term.log*
+	printf "line 1\nline 2\nline 3\n" > test/out/follow/term.log
+	run follow_log test/out/follow/term.log 2 -d
+	[ "$status" -eq 0 ]
+	run ./src/logksi verify test/out/follow/term.log -d
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ (Count of blocks:).*( 2) ]]
+	[[ "$output" =~ (Count of record hashes:).*( 3) ]]
+	[[ "$output" =~ (Count of meta-records:).*( 1) ]]
+}
+
+@test "create --follow: resume signing from the state file" {
+	rm -f test/out/follow/resume.log*
+	printf "line 1\nline 2\nline 3\nline 4\n" > test/out/follow/resume.log
+	run follow_log test/out/follow/resume.log 2 --state -d
+	[ "$status" -eq 0 ]
+	run test -f test/out/follow/resume.log.state
+	[ "$status" -eq 0 ]
+	run head -c 9 test/out/follow/resume.log.state
+	[ "$output" == "KSISTAT11" ]
+	printf "line 5\nline 6\nline 7\n" >> test/out/follow/resume.log
+	run follow_log test/out/follow/resume.log 2 --state -d
+	[ "$status" -eq 0 ]
+	run ./src/logksi verify test/out/follow/resume.log -d
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ (Count of record hashes:).*( 7) ]]
+	[[ "$output" =~ "Finalizing log signature... ok." ]]
+}
+
+@test "create --follow: log signature file of rotated log file is moved aside on restart" {
+	rm -f test/out/follow/rotate.log*
+	printf "line 1\nline 2\nline 3\n" > test/out/follow/rotate.log
+	run follow_log test/out/follow/rotate.log 2 --state -d
+	[ "$status" -eq 0 ]
+	mv test/out/follow/rotate.log test/out/follow/rotate.log.1
+	printf "line 4\nline 5\n" > test/out/follow/rotate.log
+	run follow_log test/out/follow/rotate.log 2 --state -d
+	[ "$status" -eq 0 ]
+	run test -f test/out/follow/rotate.log.1.logsig
+	[ "$status" -eq 0 ]
+	run ./src/logksi verify test/out/follow/rotate.log.1 -d
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ (Count of record hashes:).*( 3) ]]
+	run ./src/logksi verify test/out/follow/rotate.log -d
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ (Count of record hashes:).*( 2) ]]
+}
+
+@test "create --follow: restart is refused if rotated log file is not found" {
+	rm -f test/out/follow/lost.log* test/out/follow/moved/lost.log
+	printf "line 1\nline 2\nline 3\n" > test/out/follow/lost.log
+	run follow_log test/out/follow/lost.log 2 --state -d
+	[ "$status" -eq 0 ]
+	cp test/out/follow/lost.log.logsig test/out/follow/lost.expected
+	mkdir -p test/out/follow/moved
+	mv test/out/follow/lost.log test/out/follow/moved/lost.log
+	printf "line 4\n" > test/out/follow/lost.log
+	run follow_log test/out/follow/lost.log 2 --state --force-overwrite -d
+	[ "$status" -ne 0 ]
+	[[ "$output" =~ (Error: Log file).*(was rotated, but the rotated log file is not found) ]]
+	run cmp test/out/follow/lost.log.logsig test/out/follow/lost.expected
+	[ "$status" -eq 0 ]
+}
@@ -4,6 +4,8 @@ export KSI_CONF=test/test.cfg
 
 cp test/resource/logfiles/treehash1 test/out/create_log_1
 cp test/resource/logfiles/treehash2 test/out/create_log_2
+mkdir -p test/out/create_jobs_seq
+mkdir -p test/out/create_jobs_par
 
 
 # block_count, rec_hash_count, meta_rec_count, ih, oh
@@ -90,3 +92,33 @@ f_summary_of_logfile_short () {
 	[[ "$output" =~ `f_summary_of_logfile_short 1 4 1 "SHA-256:000000.*000000" "SHA-256:20c46e.*498552"` ]]
 	[[ "$output" =~ `f_summary_of_logfile_short 1 5 1 "SHA-256:20c46e.*498552" "SHA-256:44883d.*7afe98"` ]]
 }
+
+@test "create new logsig: from two files in sequence (after --) with --jobs" {
+	run ./src/logksi create -dd --seed test/resource/random/seed_aa --blk-size 16 --force-overwrite --jobs 2 -- test/out/create_log_1 test/out/create_log_2
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ `f_summary_of_logfile_short 1 4 1 "SHA-256:000000.*000000" "SHA-256:20c46e.*498552"` ]]
+	[[ "$output" =~ `f_summary_of_logfile_short 1 5 1 "SHA-256:20c46e.*498552" "SHA-256:44883d.*7afe98"` ]]
+
+	run ./src/logksi verify -dd -- test/out/create_log_1 test/out/create_log_2
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ `f_summary_of_logfile_short 1 4 1 "SHA-256:000000.*000000" "SHA-256:20c46e.*498552"` ]]
+	[[ "$output" =~ `f_summary_of_logfile_short 1 5 1 "SHA-256:20c46e.*498552" "SHA-256:44883d.*7afe98"` ]]
+}
+
+@test "create new logsig: from multiple files with --jobs and --max-pending (output hash must match the one created in sequence)" {
+	run ./src/logksi create --seed test/resource/random/seed_aa --blk-size 2 --sig-dir test/out/create_jobs_seq --state-file-name test/out/create_jobs_seq/state --output-hash test/out/create_jobs_seq/outhash --force-overwrite -- test/out/create_log_1 test/out/create_log_2 test/resource/logfiles/treehash1 test/resource/logfiles/treehash2
+	[ "$status" -eq 0 ]
+
+	run ./src/logksi create --seed test/resource/random/seed_aa --blk-size 2 --sig-dir test/out/create_jobs_par --state-file-name test/out/create_jobs_par/state --output-hash test/out/create_jobs_par/outhash --force-overwrite --jobs 3 --max-pending 2 -d -- test/out/create_log_1 test/out/create_log_2 test/resource/logfiles/treehash1 test/resource/logfiles/treehash2
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ (Log file).*(create_log_1).*(Log file).*(create_log_2).*(Log file).*(treehash1).*(Log file).*(treehash2) ]]
+
+	run diff test/out/create_jobs_seq/outhash test/out/create_jobs_par/outhash
+	[ "$status" -eq 0 ]
+
+	run cmp test/out/create_jobs_seq/state test/out/create_jobs_par/state
+	[ "$status" -eq 0 ]
+
+	run ./src/logksi verify -d --sig-dir test/out/create_jobs_par -- test/out/create_log_1 test/out/create_log_2 test/resource/logfiles/treehash1 test/resource/logfiles/treehash2
+	[ "$status" -eq 0 ]
+}
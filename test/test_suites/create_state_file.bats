@@ -10,6 +10,7 @@ mkdir -p test/out/state/sigdir_D
 mkdir -p test/out/state/sigdir_E
 mkdir -p test/out/state/sigdir_F
 mkdir -p test/out/state/sigdir_G
+mkdir -p test/out/state/sigdir_H
 mkdir -p test/out/state/invalid-state_files
 cp test/resource/logfiles/treehash1 test/out/state/logfile_1A
 cp test/resource/logfiles/treehash2 test/out/state/logfile_2A
@@ -325,4 +326,14 @@ f_summary_of_logfile_short () {
 	run xxd -p -c 100 test/out/state/sigdir_F/logfile_2A.state
 	[ "$status" -eq 0 ]
 	[[ "$output" =~ (4b5349535441543130)(05)(40)(88fffc8a82c342ce65b687e117fedc45953bbf302505525ffd359e16a293a9accd1f0dab2dda7b0a1d13b1b97f2d950cfbd2c70b6075d987b00c37a339e0fbc5) ]]
-}
\ No newline at end of file
+}
+@test "create with state file: use --state-fsync" {
+	run ./src/logksi create --seed test/resource/random/seed_aa --blk-size 5 -d --sig-dir test/out/state/sigdir_H --state --state-fsync -- test/out/state/logfile_1A
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Creating... ok." ]]
+	[[ "$output" =~ `f_summary_of_logfile_short 1 4 1 "SHA-256:000000.*000000" "SHA-256:20c46e.*498552"` ]]
+
+	run xxd -p -c 100 test/out/state/sigdir_H/logfile_1A.state
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ ^(4b5349535441543130)(01)(20)(20c46e471b9c26c192797aff00f2ad8633500a365c64f0fd4177df0b34498552)$ ]]
+}
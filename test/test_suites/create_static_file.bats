@@ -255,6 +255,44 @@ f_summary_of_logfile_short () {
 	[[ "$output" =~ `f_summary_of_logfile_short 2 1414 1 "SHA-256:000000.*000000" "SHA-256:6c293e.*9bc0ea"` ]]
 }
 
+@test "create new logsig: with multiple pending signing requests" {
+	run ./src/logksi create test/out/large_log --seed test/resource/random/seed_aa --blk-size 256 -o test/out/large_log_pending_1.logsig --output-hash test/out/large_log_pending_1.hash -d
+	[ "$status" -eq 0 ]
+	run ./src/logksi create test/out/large_log --seed test/resource/random/seed_aa --blk-size 256 --max-pending 4 -o test/out/large_log_pending_4.logsig --output-hash test/out/large_log_pending_4.hash -d
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Creating... ok." ]]
+	run diff test/out/large_log_pending_1.hash test/out/large_log_pending_4.hash
+	[ "$status" -eq 0 ]
+	run ./src/logksi verify test/out/large_log test/out/large_log_pending_4.logsig -d
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Verifying... ok." ]]
+	[[ "$output" =~ (Count of blocks:).*(6) ]]
+}
+
+@test "create new logsig: with multiple hashing threads" {
+	run ./src/logksi create test/out/large_log --seed test/resource/random/seed_aa --blk-size 256 --threads 4 -o test/out/large_log_threads_4.logsig --output-hash test/out/large_log_threads_4.hash -d
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Creating... ok." ]]
+	run diff test/out/large_log_pending_1.hash test/out/large_log_threads_4.hash
+	[ "$status" -eq 0 ]
+	run ./src/logksi verify test/out/large_log test/out/large_log_threads_4.logsig -d
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Verifying... ok." ]]
+	[[ "$output" =~ (Count of blocks:).*(6) ]]
+}
+
+@test "create new logsig: with locally aggregated signing batches" {
+	run ./src/logksi create test/out/large_log --seed test/resource/random/seed_aa --blk-size 256 --batch-size 4 --max-pending 2 -o test/out/large_log_batch_4.logsig --output-hash test/out/large_log_batch_4.hash -d
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Creating... ok." ]]
+	run diff test/out/large_log_pending_1.hash test/out/large_log_batch_4.hash
+	[ "$status" -eq 0 ]
+	run ./src/logksi verify test/out/large_log test/out/large_log_batch_4.logsig -d
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Verifying... ok." ]]
+	[[ "$output" =~ (Count of blocks:).*(6) ]]
+}
+
 @test "create: verify metarecord" {
 	run ./src/logksi verify test/out/records_4 test/out/records_4_record_and_tree_hashes.logsig --hex-to-str -ddd
 	[ "$status" -eq 0 ]
@@ -359,3 +397,25 @@ f_summary_of_logfile_short () {
 	[[ "$output" =~ "Verifying... ok." ]]
 	[[ "$output" =~ `f_summary_of_logfile_short 1 6 1 "SHA-256:000000.*000000" "SHA-256:bf50f4.*e8a84b"` ]]
 }
+
+@test "create new logsig: with block index" {
+	run ./src/logksi create test/out/large_log --seed test/resource/random/seed_aa --blk-size 256 --write-index -o test/out/large_log_index.logsig -d
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Creating... ok." ]]
+	run test -f test/out/large_log_index.logsig.idx
+	[ "$status" -eq 0 ]
+	run ./src/logksi index test/out/large_log test/out/large_log_index.logsig -o test/out/large_log_index.rebuilt.idx -d
+	[ "$status" -eq 0 ]
+	run cmp test/out/large_log_index.logsig.idx test/out/large_log_index.rebuilt.idx
+	[ "$status" -eq 0 ]
+}
+
+@test "create new logsig: close block when --blk-time is reached" {
+	run bash -c "rm -f test/out/blk_time.logsig; printf 'line 1\nline 2\n' > test/out/blk_time.log; ./src/logksi create test/out/blk_time.log --follow --seed test/resource/random/seed_aa --blk-size 100 --blk-time 1 -o test/out/blk_time.logsig -d & pid=\$!; sleep 3; printf 'line 3\n' >> test/out/blk_time.log; sleep 3; kill -TERM \$pid; wait \$pid"
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Creating... ok." ]]
+
+	run ./src/logksi verify test/out/blk_time.log test/out/blk_time.logsig -d
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Verifying... ok." ]]
+}
@@ -0,0 +1,98 @@
+#!/bin/bash
+
+export KSI_CONF=test/test.cfg
+
+# Usage: start_daemon [count of workers]
+start_daemon() {
+	rm -f test/out/daemon.sock
+	./src/logksi daemon --socket test/out/daemon.sock --workers ${1:-2} 3>&- &
+	DAEMON_PID=$!
+	for i in $(seq 50); do
+		test -S test/out/daemon.sock && return 0
+		sleep 0.1
+	done
+	return 1
+}
+
+stop_daemon() {
+	kill -TERM $DAEMON_PID
+	wait $DAEMON_PID
+}
+
+@test "daemon: verify log_repaired.logsig through daemon" {
+	start_daemon
+	LOGKSI_DAEMON_SOCKET=test/out/daemon.sock run ./src/logksi verify test/resource/logs_and_signatures/log_repaired -ddd --ignore-desc-block-time
+	stop_daemon
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Finalizing log signature... ok." ]]
+	run test -S test/out/daemon.sock
+	[ "$status" -ne 0 ]
+}
+
+@test "daemon: exit code and output of the failing job are returned by client" {
+	run ./src/logksi verify test/resource/logfiles/legacy_extract
+	local_status=$status
+	local_output=$output
+	[ "$local_status" -ne 0 ]
+	start_daemon
+	LOGKSI_DAEMON_SOCKET=test/out/daemon.sock run ./src/logksi verify test/resource/logfiles/legacy_extract
+	stop_daemon
+	[ "$status" -eq "$local_status" ]
+	[ "$output" == "$local_output" ]
+}
+
+@test "daemon: socket is accessible only by the owner" {
+	start_daemon
+	run stat -c %a test/out/daemon.sock
+	stop_daemon
+	[ "$status" -eq 0 ]
+	[ "$output" == "600" ]
+}
+
+@test "daemon: worker serves several jobs one after another" {
+	start_daemon
+	for i in 1 2 3; do
+		LOGKSI_DAEMON_SOCKET=test/out/daemon.sock run ./src/logksi verify test/resource/logs_and_signatures/log_repaired -d --ignore-desc-block-time
+		[ "$status" -eq 0 ] || break
+	done
+	stop_daemon
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Finalizing log signature... ok." ]]
+}
+
+@test "daemon: signing time of the previous job is not used by the next job" {
+	start_daemon 1
+	LOGKSI_DAEMON_SOCKET=test/out/daemon.sock run ./src/logksi verify test/resource/interlink/ok-testlog-interlink-2 -d
+	newer_status=$status
+	LOGKSI_DAEMON_SOCKET=test/out/daemon.sock run ./src/logksi verify test/resource/interlink/ok-testlog-interlink-1 -d
+	stop_daemon
+	[ "$newer_status" -eq 0 ]
+	[ "$status" -eq 0 ]
+	[[ ! "$output" =~ "is more recent than" ]]
+	[[ "$output" =~ "Verifying... ok." ]]
+}
+
+@test "daemon: job is configured by the environment of the client" {
+	run env KSI_CONF=test/out/missing.cfg ./src/logksi verify test/resource/logs_and_signatures/log_repaired
+	local_status=$status
+	local_output=$output
+	[ "$local_status" -ne 0 ]
+	start_daemon
+	KSI_CONF=test/out/missing.cfg LOGKSI_DAEMON_SOCKET=test/out/daemon.sock run ./src/logksi verify test/resource/logs_and_signatures/log_repaired
+	stop_daemon
+	[ "$status" -eq "$local_status" ]
+	[ "$output" == "$local_output" ]
+}
+
+@test "daemon CMD: attempt to run job without daemon" {
+	rm -f test/out/daemon.sock
+	LOGKSI_DAEMON_SOCKET=test/out/daemon.sock run ./src/logksi verify test/resource/logs_and_signatures/log_repaired
+	[ "$status" -ne 0 ]
+	[[ "$output" =~ (Error: Unable to run the job in logksi daemon listening on).*(daemon.sock) ]]
+}
+
+@test "daemon CMD: socket is mandatory" {
+	run ./src/logksi daemon
+	[ "$status" -eq 3 ]
+	[[ "$output" =~ "socket" ]]
+}
@@ -55,6 +55,68 @@ cp test/resource/logfiles/signed test/out/signed4
 	[ "$status" -ne 0 ]
 }
 
+@test "extend signed3.logsig with --skip-tree-check gives the same result as full parsing" {
+	run ./src/logksi extend test/out/signed3 -o test/out/signed_skip_tree_check.logsig --skip-tree-check \
+	--pub-str AAAAAA-C2PMAF-IAISKD-4JLNKD-ZFCF5L-4OWMS5-DMJLTC-DCJ6SS-QDFBC4-ELLWTM-5BO7WF-I7W2JK \
+	-P file://test/resource/publication/dummy-publications.bin \
+	-V test/resource/certificates/dummy-cert.pem -ddd
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Finalizing log signature... ok." ]]
+	run cmp test/out/signed4.logsig test/out/signed_skip_tree_check.logsig
+	[ "$status" -eq 0 ]
+}
+
+@test "extend signed3.logsig with --ext-cache reuses calendar hash chains without extender" {
+	run rm -rf test/out/ext_cache
+	run ./src/logksi extend test/out/signed3 -o test/out/signed_ext_cache_1.logsig --ext-cache test/out/ext_cache \
+	--pub-str AAAAAA-C2PMAF-IAISKD-4JLNKD-ZFCF5L-4OWMS5-DMJLTC-DCJ6SS-QDFBC4-ELLWTM-5BO7WF-I7W2JK \
+	-P file://test/resource/publication/dummy-publications.bin \
+	-V test/resource/certificates/dummy-cert.pem -ddd
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Finalizing log signature... ok." ]]
+	run ./src/logksi extend test/out/signed3 -o test/out/signed_ext_cache_2.logsig --ext-cache test/out/ext_cache \
+	-X http://localhost:1 \
+	--pub-str AAAAAA-C2PMAF-IAISKD-4JLNKD-ZFCF5L-4OWMS5-DMJLTC-DCJ6SS-QDFBC4-ELLWTM-5BO7WF-I7W2JK \
+	-P file://test/resource/publication/dummy-publications.bin \
+	-V test/resource/certificates/dummy-cert.pem -ddd
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ (Extender cache: [1-9][0-9]* KSI signature) ]]
+	run cmp test/out/signed4.logsig test/out/signed_ext_cache_2.logsig
+	[ "$status" -eq 0 ]
+}
+
+@test "extend signed3.logsig with --pubfile-cache uses cached publications file" {
+	run rm -f test/out/pubfile.cache test/out/pubfile.cache.lock
+	run cp test/resource/publication/dummy-publications.bin test/out/pubfile_cache_src.bin
+	run ./src/logksi extend test/out/signed3 -o test/out/signed_pubfile_cache_1.logsig --pubfile-cache test/out/pubfile.cache \
+	--pub-str AAAAAA-C2PMAF-IAISKD-4JLNKD-ZFCF5L-4OWMS5-DMJLTC-DCJ6SS-QDFBC4-ELLWTM-5BO7WF-I7W2JK \
+	-P file://test/out/pubfile_cache_src.bin \
+	-V test/resource/certificates/dummy-cert.pem -d
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Verifying publications file... ok." ]]
+	[ -f test/out/pubfile.cache ]
+	run rm -f test/out/pubfile_cache_src.bin
+	run ./src/logksi extend test/out/signed3 -o test/out/signed_pubfile_cache_2.logsig --pubfile-cache test/out/pubfile.cache \
+	--pub-str AAAAAA-C2PMAF-IAISKD-4JLNKD-ZFCF5L-4OWMS5-DMJLTC-DCJ6SS-QDFBC4-ELLWTM-5BO7WF-I7W2JK \
+	-P file://test/out/pubfile_cache_src.bin \
+	-V test/resource/certificates/dummy-cert.pem -d
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Loading publications file from file... ok." ]]
+	run cmp test/out/signed4.logsig test/out/signed_pubfile_cache_2.logsig
+	[ "$status" -eq 0 ]
+}
+
+@test "extend signed3.logsig with --max-pending gives the same result as serial extending" {
+	run ./src/logksi extend test/out/signed3 -o test/out/signed_max_pending.logsig --max-pending 8 \
+	--pub-str AAAAAA-C2PMAF-IAISKD-4JLNKD-ZFCF5L-4OWMS5-DMJLTC-DCJ6SS-QDFBC4-ELLWTM-5BO7WF-I7W2JK \
+	-P file://test/resource/publication/dummy-publications.bin \
+	-V test/resource/certificates/dummy-cert.pem -d
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Prefetching calendar hash chains... ok." ]]
+	run cmp test/out/signed4.logsig test/out/signed_max_pending.logsig
+	[ "$status" -eq 0 ]
+}
+
 # @SKIP_MEMORY_TEST
 @test "extend signed3.logsig to stdout" {
 	run bash -c "./src/logksi extend test/out/signed3 -o - \
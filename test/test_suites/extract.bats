@@ -266,6 +266,32 @@ cp -r test/resource/logfiles/legacy_extract test/out
 	[ "$status" -eq 0 ]
 }
 
+@test "extract with block index, compare with extracting all blocks" {
+	run ./src/logksi index test/out/extract.base.1
+	[ "$status" -eq 0 ]
+	run ./src/logksi extract test/out/extract.base.1 -r 3,6,9,1414 -o test/out/extract.base.1.indexed -ddd
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Finalizing log signature... ok." ]]
+	[[ ! "$output" =~ "Building block index..." ]]
+	run ./src/logksi extract --sig-from-stdin test/out/extract.base.1 -r 3,6,9,1414 -o test/out/extract.base.1.all < test/out/extract.base.1.logsig
+	[ "$status" -eq 0 ]
+	run cmp test/out/extract.base.1.indexed.excerpt test/out/extract.base.1.all.excerpt
+	[ "$status" -eq 0 ]
+	run cmp test/out/extract.base.1.indexed.excerpt.logsig test/out/extract.base.1.all.excerpt.logsig
+	[ "$status" -eq 0 ]
+	run ./src/logksi verify test/out/extract.base.1.indexed.excerpt -d
+	[ "$status" -eq 0 ]
+}
+
+@test "extract with block index built on the fly" {
+	run ./src/logksi extract test/out/extract.base.2 -r 3,6,9 -ddd
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Building block index... ok." ]]
+	[[ "$output" =~ "Finalizing log signature... ok." ]]
+	run diff test/out/extract.base.2.excerpt test/resource/logfiles/r3.6.9.excerpt
+	[ "$status" -eq 0 ]
+}
+
 @test "extract records from non-extended legacy.gtsig" {
 	run ./src/logksi verify --ver-int test/out/legacy_extract -ddd
 	[ "$status" -eq 0 ]
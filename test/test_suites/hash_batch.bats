@@ -0,0 +1,15 @@
+#!/bin/bash
+
+setup() {
+	[ -x ./src/hash_batch_test ] || skip "hash batch test program is not built (run make check)."
+}
+
+@test "hash batch: every SHA-256 kernel supported by the CPU gives the known answers" {
+	run ./src/hash_batch_test
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Kernel libksi: 1800 digest(s) ok." ]]
+	[[ "$output" =~ "Kernel generic: 1800 digest(s) ok." ]]
+	[[ "$output" =~ (Kernel sha-ni: )(1800 digest\(s\) ok|not supported, skipped)"." ]]
+	[[ "$output" =~ (Kernel avx2: )(1800 digest\(s\) ok|not supported, skipped)"." ]]
+	[[ "$output" =~ (Kernel avx512: )(1800 digest\(s\) ok|not supported, skipped)"." ]]
+}
@@ -0,0 +1,107 @@
+#!/bin/bash
+
+export KSI_CONF=test/test.cfg
+
+cp test/resource/logs_and_signatures/signed test/out/index_signed
+cp test/resource/logs_and_signatures/signed.logsig test/out/index_signed.logsig
+cp test/resource/logs_and_signatures/unsigned test/out/index_unsigned
+cp test/resource/logs_and_signatures/unsigned.logsig test/out/index_unsigned.logsig
+cp test/resource/logfiles/mac-new-line test/out/index_mac_new_line
+cp test/resource/logfiles/win-new-line test/out/index_win_new_line
+
+@test "index: create block index for signed log signature" {
+	run ./src/logksi index test/out/index_signed -d
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Indexing blocks... ok." ]]
+	[[ "$output" =~ "Indexing log lines... ok." ]]
+	[[ "$output" =~ (Block index of).*(blocks saved to).*(index_signed.logsig.idx) ]]
+	run test -f test/out/index_signed.logsig.idx
+	[ "$status" -eq 0 ]
+}
+
+@test "index: block index is updated by sign" {
+	run ./src/logksi index test/out/index_unsigned
+	[ "$status" -eq 0 ]
+	cp test/out/index_unsigned.logsig.idx test/out/index_unsigned.before.idx
+	run ./src/logksi sign test/out/index_unsigned -d
+	[ "$status" -eq 0 ]
+	run cmp test/out/index_unsigned.logsig.idx test/out/index_unsigned.before.idx
+	[ "$status" -ne 0 ]
+	run ./src/logksi index test/out/index_unsigned -o test/out/index_unsigned.rebuilt.idx
+	[ "$status" -eq 0 ]
+	run cmp test/out/index_unsigned.logsig.idx test/out/index_unsigned.rebuilt.idx
+	[ "$status" -eq 0 ]
+}
+
+@test "index: log lines that end with CR" {
+	run ./src/logksi create test/out/index_mac_new_line --seed test/resource/random/seed_aa --blk-size 1 -o test/out/index_mac_new_line.logsig
+	[ "$status" -eq 0 ]
+	run ./src/logksi index test/out/index_mac_new_line
+	[ "$status" -eq 0 ]
+	run ./src/logksi extract test/out/index_mac_new_line -r 3 -o test/out/index_mac_new_line.indexed
+	[ "$status" -eq 0 ]
+	run ./src/logksi extract --sig-from-stdin test/out/index_mac_new_line -r 3 -o test/out/index_mac_new_line.all < test/out/index_mac_new_line.logsig
+	[ "$status" -eq 0 ]
+	run cmp test/out/index_mac_new_line.indexed.excerpt test/out/index_mac_new_line.all.excerpt
+	[ "$status" -eq 0 ]
+	run cat test/out/index_mac_new_line.indexed.excerpt
+	[[ "$output" =~ ^CC$ ]]
+	run ./src/logksi verify test/out/index_mac_new_line -dd --lines 3-4
+	[ "$status" -eq 0 ]
+	[[ ! "$output" =~ "Verifying block no.   1..." ]]
+	[[ "$output" =~ (Verifying block no.   3... ok.).*(Verifying block no.   4... ok.) ]]
+	run ./src/logksi verify test/out/index_mac_new_line -d --jobs 2
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Verifying... ok." ]]
+}
+
+@test "index: log lines that end with CR LF" {
+	run ./src/logksi create test/out/index_win_new_line --seed test/resource/random/seed_aa --blk-size 1 -o test/out/index_win_new_line.logsig
+	[ "$status" -eq 0 ]
+	run ./src/logksi index test/out/index_win_new_line
+	[ "$status" -eq 0 ]
+	run ./src/logksi extract test/out/index_win_new_line -r 3 -o test/out/index_win_new_line.indexed
+	[ "$status" -eq 0 ]
+	run cat test/out/index_win_new_line.indexed.excerpt
+	[[ "$output" =~ ^CC$ ]]
+	run ./src/logksi verify test/out/index_win_new_line -dd --lines 3-4
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ (Verifying block no.   3... ok.).*(Verifying block no.   4... ok.) ]]
+	run ./src/logksi verify test/out/index_win_new_line -d --jobs 2
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Verifying... ok." ]]
+}
+
+@test "index: log file offsets are found again when log file is rewritten" {
+	printf "line 1\nline 2\nline 3\nline 4\n" > test/out/index_rewritten
+	run ./src/logksi create test/out/index_rewritten --seed test/resource/random/seed_aa --blk-size 1 -o test/out/index_rewritten.logsig
+	[ "$status" -eq 0 ]
+	run ./src/logksi index test/out/index_rewritten
+	[ "$status" -eq 0 ]
+	run ./src/logksi verify test/out/index_rewritten -ddd --lines 3-4
+	[ "$status" -eq 0 ]
+	[[ ! "$output" =~ "Indexing log lines..." ]]
+	printf "line one\nline 2\nline 3\nline 4\n" > test/out/index_rewritten
+	run ./src/logksi verify test/out/index_rewritten -ddd --lines 3-4
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Indexing log lines... ok." ]]
+	[[ "$output" =~ (Block no.   3: processing block header... ok.).*(Block no.   4: processing block header... ok.) ]]
+}
+
+@test "index CMD: attempt to open not existing log signature file" {
+	run ./src/logksi index test/resource/logfiles/legacy_extract
+	[ "$status" -eq 9 ]
+	[[ "$output" =~ (Error: Could not open input sig file).*(legacy_extract.logsig) ]]
+}
+
+@test "index CMD: attempt to redirect block index to stdout" {
+	run ./src/logksi index test/out/index_signed -o -
+	[ "$status" -eq 3 ]
+	[[ "$output" =~ "Error: Block index can not be redirected to stdout." ]]
+}
+
+@test "index CMD: attempt to index excerpt file" {
+	run ./src/logksi index test/resource/excerpt/log-ok.excerpt test/resource/excerpt/log-ok.excerpt.logsig
+	[ "$status" -ne 0 ]
+	[[ "$output" =~ "Error: Block index can not be created for excerpt file." ]]
+}
@@ -0,0 +1,37 @@
+#!/bin/bash
+
+export KSI_CONF=test/test.cfg
+
+# Aggregator settings are taken from the test configuration file.
+conf_value () {
+	awk -v opt="$1" '$1 == opt {print $2; exit}' test/test.cfg
+}
+
+setup() {
+	[ -x ./src/log_signer_test ] || skip "log signer test program is not built (run make check)."
+	seq 1 10 | sed 's/^/log signer record /' > test/out/log_signer_records
+}
+
+@test "log signer: sign records through LOG_SIGNER and verify the output with logksi" {
+	run ./src/log_signer_test "$(conf_value -S)" "$(conf_value --aggr-user)" "$(conf_value --aggr-key)" test/resource/random/seed_aa 4 test/out/log_signer_records.logsig < test/out/log_signer_records
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Log signer: 10 record(s) signed." ]]
+	run ./src/logksi verify test/out/log_signer_records -ddd
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ (Count of blocks:).*( 3) ]]
+	[[ "$output" =~ (Count of record hashes:).*( 10) ]]
+	[[ "$output" =~ (Count of meta-records:).*( 1) ]]
+	[[ "$output" =~ "Finalizing log signature... ok." ]]
+}
+
+@test "log signer: output hash is the same as the one of logksi create" {
+	cp test/out/log_signer_records test/out/log_signer_create
+	run ./src/logksi create test/out/log_signer_create --seed test/resource/random/seed_aa --blk-size 4 --force-overwrite -d
+	[ "$status" -eq 0 ]
+	run ./src/log_signer_test "$(conf_value -S)" "$(conf_value --aggr-user)" "$(conf_value --aggr-key)" test/resource/random/seed_aa 4 test/out/log_signer_records.logsig < test/out/log_signer_records
+	[ "$status" -eq 0 ]
+	create_output_hash=$(./src/logksi verify test/out/log_signer_create -d 2>&1 | grep "Output hash:")
+	signer_output_hash=$(./src/logksi verify test/out/log_signer_records -d 2>&1 | grep "Output hash:")
+	[ -n "$create_output_hash" ]
+	[ "$create_output_hash" == "$signer_output_hash" ]
+}
@@ -59,6 +59,26 @@ export KSI_CONF=test/test.cfg
 	[ "$status" -eq 0 ]
 }
 
+@test "sign unsigned.logsig with concurrent requests" {
+	run ./src/logksi sign test/out/unsigned -o test/out/unsigned_max_requests.logsig --max-requests 4 -ddd
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Signing unsigned blocks with up to" ]]
+	[[ "$output" =~ "creating missing KSI signature" ]]
+	[[ "$output" =~ "Finalizing log signature... ok." ]]
+	run ./src/logksi verify test/out/unsigned test/out/unsigned_max_requests.logsig
+	[ "$status" -eq 0 ]
+}
+
+@test "sign unsigned.logsig with locally aggregated batch" {
+	run ./src/logksi sign test/out/unsigned -o test/out/unsigned_batch.logsig --batch-size 8 -ddd
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "blocks per request" ]]
+	[[ "$output" =~ "creating missing KSI signature" ]]
+	[[ "$output" =~ "Finalizing log signature... ok." ]]
+	run ./src/logksi verify test/out/unsigned test/out/unsigned_batch.logsig
+	[ "$status" -eq 0 ]
+}
+
 @test "sign and check if backup is really backup" {
 	run cp  test/resource/logs_and_signatures/only-1-unsigned test/out/
 	run cp  test/resource/logs_and_signatures/only-1-unsigned.logsig test/out/
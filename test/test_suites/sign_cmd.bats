@@ -21,6 +21,18 @@ export KSI_CONF=test/test.cfg
 	[[ "$output" =~ (Algorithm name is incorrect).*(Parameter.*CMD.*aggr-hmac-alg).*(dummy) ]]
 }
 
+@test "sign CMD test: try to use max-requests 0" {
+	run src/logksi sign test/resource/logs_and_signatures/unsigned -o test/out/dummy.ksig --max-requests 0
+	[ "$status" -eq 3 ]
+	[[ "$output" =~ (Integer value is too small).*(max-requests).*('0') ]]
+}
+
+@test "sign CMD test: try to use batch-size 0" {
+	run src/logksi sign test/resource/logs_and_signatures/unsigned -o test/out/dummy.ksig --batch-size 0
+	[ "$status" -eq 3 ]
+	[[ "$output" =~ (Integer value is too small).*(batch-size).*('0') ]]
+}
+
 @test "sign CMD test: try to sign not existing log signature file" {
 	run src/logksi sign -o test/out/dummy.ksig dummy.not.existing
 	[ "$status" -eq 9 ]
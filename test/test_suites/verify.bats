@@ -28,6 +28,104 @@ export KSI_CONF=test/test.cfg
 	[[ "$output" =~ "Finalizing log signature... ok." ]]
 }
 
+@test "verify log_repaired.logsig with multiple hashing threads" {
+	run ./src/logksi verify test/resource/logs_and_signatures/log_repaired -ddd --ignore-desc-block-time --threads 4
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Finalizing log signature... ok." ]]
+}
+
+@test "verify ranges of blocks of log_repaired.logsig in parallel processes" {
+	run ./src/logksi verify test/resource/logs_and_signatures/log_repaired -ddd --ignore-desc-block-time --jobs 3
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ (Verifying block no.   1... ok.).*(Finalizing log signature... ok.) ]]
+	[[ "$output" =~ "Verifying... ok." ]]
+
+	run ./src/logksi verify test/resource/logs_and_signatures/log_repaired -d --ignore-desc-block-time --jobs 3 --threads 2
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Verifying... ok." ]]
+}
+
+@test "verify ranges of blocks of log_repaired.logsig in parallel processes WITHOUT --ignore-desc-block-time" {
+	run ./src/logksi verify test/resource/logs_and_signatures/log_repaired --jobs 4
+	[ "$status" -eq 6 ]
+	[[ "$output" =~ .*(Error).*(Block no).*(17).*(1540303365).*(is more recent than).*(block no).*(18).*(1517928940).* ]]
+}
+
+@test "try verifying ranges of blocks of log_repaired.logsig against signed logfile in parallel processes" {
+	run ./src/logksi verify test/resource/logs_and_signatures/signed test/resource/logs_and_signatures/log_repaired.logsig -d --jobs 3
+	[ "$status" -ne 0 ]
+	[[ "$output" =~ "Verifying... failed." ]]
+}
+
+@test "try verifying ranges of blocks in parallel processes with a block index that skips inserted log lines" {
+	printf 'line %s\n' 1 2 3 4 5 6 > test/out/verify_jobs_tampered_index
+	run ./src/logksi create test/out/verify_jobs_tampered_index --seed test/resource/random/seed_aa --blk-size 2 --force-overwrite -o test/out/verify_jobs_tampered_index.logsig
+	[ "$status" -eq 0 ]
+	cp test/out/verify_jobs_tampered_index test/out/verify_jobs_tampered_index_first
+	cp test/out/verify_jobs_tampered_index.logsig test/out/verify_jobs_tampered_index_first.logsig
+
+	# Line is inserted between blocks 1 and 2 and the offset of block 2 (at byte 136 of the index) is moved past it.
+	sed -i '2a junk' test/out/verify_jobs_tampered_index
+	run ./src/logksi index test/out/verify_jobs_tampered_index
+	[ "$status" -eq 0 ]
+	printf '\000\000\000\000\000\000\000\023' | dd of=test/out/verify_jobs_tampered_index.logsig.idx bs=1 seek=136 conv=notrunc
+	run ./src/logksi verify test/out/verify_jobs_tampered_index -d --jobs 3
+	[ "$status" -eq 6 ]
+	[[ "$output" =~ "Verifying... failed." ]]
+	[[ "$output" =~ (Error: Block no. 2: block index does not match the log signature file or the log file).*(block 1 ends at offset).*(log file 14).*(log file 19) ]]
+
+	# Line is inserted before block 1 and the offset of block 1 (at byte 72 of the index) is moved past it.
+	sed -i '1i junk' test/out/verify_jobs_tampered_index_first
+	run ./src/logksi index test/out/verify_jobs_tampered_index_first
+	[ "$status" -eq 0 ]
+	printf '\000\000\000\000\000\000\000\005' | dd of=test/out/verify_jobs_tampered_index_first.logsig.idx bs=1 seek=72 conv=notrunc
+	run ./src/logksi verify test/out/verify_jobs_tampered_index_first -d --jobs 3
+	[ "$status" -eq 6 ]
+	[[ "$output" =~ "Error: Block no. 1: block index does not match the log signature file or the log file." ]]
+}
+
+@test "verify only the blocks of log_repaired.logsig that contain the given lines" {
+	run ./src/logksi verify test/resource/logs_and_signatures/log_repaired -dd --ignore-desc-block-time --lines 80-88
+	[ "$status" -eq 0 ]
+	[[ ! "$output" =~ "Verifying block no.   1..." ]]
+	[[ "$output" =~ (Verifying block no.  28... ok.).*(Verifying block no.  30... ok.) ]]
+	[[ "$output" =~ (Count of record hashes:).*(88) ]]
+
+	run ./src/logksi verify test/resource/logs_and_signatures/log_repaired -dd --ignore-desc-block-time --lines 4-6
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Verifying block no.   2... ok." ]]
+	[[ ! "$output" =~ "Verifying block no.   3..." ]]
+}
+
+@test "verify only the blocks of log_repaired.logsig that contain the given record time window" {
+	run ./src/logksi verify test/resource/logs_and_signatures/log_repaired -dd --ignore-desc-block-time --time-form "%B %d %H:%M:%S" --time-base 2017 --time-range "2017-04-26 14:42:03,"
+	[ "$status" -eq 0 ]
+	[[ ! "$output" =~ "Verifying block no.   1..." ]]
+	[[ "$output" =~ "Verifying block no.  30... ok." ]]
+
+	run ./src/logksi verify test/resource/logs_and_signatures/log_repaired -dd --ignore-desc-block-time --time-form "%B %d %H:%M:%S" --time-base 2017 --time-range ",2017-04-26 14:00:00"
+	[ "$status" -eq 3 ]
+	[[ "$output" =~ "Error: Time range does not contain any log records." ]]
+}
+
+@test "verify log_repaired.logsig twice with verification ledger" {
+	run ./src/logksi verify test/resource/logs_and_signatures/log_repaired -dd --ignore-desc-block-time --ledger test/out/log_repaired.ledger
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Verifying block no.   1... ok." ]]
+	[ -f test/out/log_repaired.ledger ]
+
+	run ./src/logksi verify test/resource/logs_and_signatures/log_repaired -ddd --ignore-desc-block-time --ledger test/out/log_repaired.ledger
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Skipping 29 blocks verified earlier (see --ledger)." ]]
+	[[ ! "$output" =~ "Block no.   1: verifying KSI signature..." ]]
+	[[ "$output" =~ "Block no.  30: verifying KSI signature..." ]]
+
+	# Blocks verified with different options are verified again.
+	run ./src/logksi verify --ver-int test/resource/logs_and_signatures/log_repaired -dd --ignore-desc-block-time --ledger test/out/log_repaired.ledger
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "Verifying block no.   1... ok." ]]
+}
+
 @test "verify log_repaired.logsig internally" {
 	run ./src/logksi verify --ver-int test/resource/logs_and_signatures/log_repaired -ddd --ignore-desc-block-time
 	[ "$status" -eq 0 ]
@@ -171,6 +171,40 @@ export KSI_CONF=test/test.cfg
 	[[ "$output" =~ (Only digits, oo and 1x d, H, M and S allowed).*(Parameter).*(--block-time-diff).*(o,o) ]]
 }
 
+@test "verify CMD test: try to use threads 0" {
+	run ./src/logksi verify test/resource/logs_and_signatures/log_repaired --threads 0
+	[ "$status" -eq 3 ]
+	[[ "$output" =~ (Integer value is too small).*(threads).*('0') ]]
+}
+
+@test "verify CMD test: try to use invalid --lines and --time-range" {
+	run ./src/logksi verify test/resource/logs_and_signatures/log_repaired --lines 5-2
+	[ "$status" -eq 3 ]
+	[[ "$output" =~ (Line range must be).*(Parameter).*(--lines).*('5-2') ]]
+
+	run ./src/logksi verify test/resource/logs_and_signatures/log_repaired --time-range "2017-04-26 14:42:03"
+	[ "$status" -eq 3 ]
+	[[ "$output" =~ (Time range must be).*(Parameter).*(--time-range) ]]
+
+	run ./src/logksi verify test/resource/logs_and_signatures/log_repaired --time-range "2017-04-26 14:42:03,"
+	[ "$status" -eq 3 ]
+	[[ "$output" =~ (Error).*(--time-range needs --time-form) ]]
+
+	run ./src/logksi verify --lines 1-3 -- test/resource/logs_and_signatures/log_repaired
+	[ "$status" -eq 3 ]
+	[[ "$output" =~ (Error).*(--lines and --time-range can not be used to verify multiple log files) ]]
+}
+
+@test "verify CMD test: try to use invalid --jobs" {
+	run ./src/logksi verify --jobs 0 -- test/resource/interlink/ok-testlog-interlink-1 test/resource/interlink/ok-testlog-interlink-2
+	[ "$status" -eq 3 ]
+	[[ "$output" =~ (Integer value is too small).*(jobs).*('0') ]]
+
+	run ./src/logksi verify --jobs 2 --ledger test/out/jobs.ledger -- test/resource/interlink/ok-testlog-interlink-1 test/resource/interlink/ok-testlog-interlink-2
+	[ "$status" -eq 3 ]
+	[[ "$output" =~ (Error).*(--ledger can not be used with --jobs) ]]
+}
+
 @test "verify CMD test: Check if --time-disordered has the same type as --time-diff but does not allow comma nor minus nor infinity" {
 	run ./src/logksi verify --ver-key test/resource/logs_and_signatures/log_repaired -d --time-disordered 1S2
 	[ "$status" -eq 3 ]
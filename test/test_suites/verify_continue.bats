@@ -58,6 +58,15 @@ export KSI_CONF=test/test.cfg
 	[[ "$output" =~ (1[\)]).*(Error: 1 hash comparison failures found).*(Log signature verification failed)  ]]
 }
 
+@test "Log rec nr.4 removed from log signature file. Log lines are hashed with multiple threads and verification is continued." {
+	run src/logksi verify --ver-int test/resource/continue-verification/log test/resource/continue-verification/log-line-4-removed.logsig  -d --continue-on-fail --threads 2
+	[ "$status" -eq 6 ]
+	[[ "$output" =~ (Verifying... failed).*(Error: Failed to verify logline no. 5).*(Error: Skipping block 2).*(Error: Failed to verify logline no. 6).*(Error: Skipping block 3).*(Count of hash failures:      4) ]]
+	[[ ! "$output" =~ (Error: Skipping block 1)  ]]
+	[[ ! "$output" =~ (Error: Skipping block 4)  ]]
+	[[ "$output" =~ (1[\)]).*(Error: Block no. 4: end of log file contains unexpected records).*(verification failed)  ]]
+}
+
 @test "KSI signature is replaced in block 2. Rec. hashes present. Sig verification fails but verification is continued." {
 	run src/logksi verify --ver-int test/resource/continue-verification/log test/resource/continue-verification/log-sig-no2-wrong.logsig -d --continue-on-fail
 	[ "$status" -eq 6 ]
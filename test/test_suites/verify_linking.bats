@@ -36,6 +36,16 @@ cp test/resource/interlink/ok-testlog-interlink-2        test/out/verify_interli
 	[[ "$output" =~ (Log file).*(test\/resource\/logs_and_signatures\/log_repaired).*(Last leaf from log signature).*(test\/resource\/logs_and_signatures\/log_repaired.logsig).*(SHA-512:7f5a178f581de2aed0d36739f908733643b316aac8bed0c9f89c040ad1d1e601ae8fd1ae1e177c2cdf9ebf59a2f43df00614893723d5019b6326b225bbcd7827) ]]
 }
 
+@test "verify log_repaired.logsig in parallel processes with input hash and output last leaf hash to stdout" {
+	run ./src/logksi verify test/resource/logs_and_signatures/log_repaired -d --jobs 3 --input-hash test/out/input-hash.txt --output-hash - --ignore-desc-block-time
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ "SHA-512:7f5a178f581de2aed0d36739f908733643b316aac8bed0c9f89c040ad1d1e601ae8fd1ae1e177c2cdf9ebf59a2f43df00614893723d5019b6326b225bbcd7827" ]]
+
+	run ./src/logksi verify test/resource/logs_and_signatures/log_repaired -d --jobs 3 --input-hash SHA-512:7f5a178f581de2aed0d36739f908733643b316aac8bed0c9f89c040ad1d1e601ae8fd1ae1e177c2cdf9ebf59a2f43df00614893723d5019b6326b225bbcd7827 --ignore-desc-block-time
+	[ "$status" -eq 6 ]
+	[[ "$output" =~ "Verifying... failed." ]]
+}
+
 @test "verify log_repaired.logsig output last leaf hash to stdout" {
 	run ./src/logksi verify test/resource/logs_and_signatures/log_repaired -ddd --output-hash - --ignore-desc-block-time
 	[ "$status" -eq 0 ]
@@ -174,4 +184,33 @@ cp test/resource/interlink/ok-testlog-interlink-2        test/out/verify_interli
 	[ "$status" -eq 0 ]
 	[[ ! "$output" =~ (too close) ]]
 	[[ ! "$output" =~ (too apart) ]]
-}
\ No newline at end of file
+}
+##
+# Verify multiple log files at once.
+##
+
+@test "verify inter-linking of 2 log files after -- with --jobs. Check output hash (must match to last log and log signature)" {
+	run src/logksi verify -ddd --jobs 2 --output-hash - -- test/resource/interlink/ok-testlog-interlink-1 test/resource/interlink/ok-testlog-interlink-2
+	[ "$status" -eq 0 ]
+	[[ "$output" =~ (Log file.*ok-testlog-interlink-1).*(Finalizing log signature... ok).*(Log file.*ok-testlog-interlink-2).*(Finalizing log signature... ok).*(Block no).*(1).*(verifying inter-linking input hash... ok) ]]
+	[[ "$output" =~ "SHA-256:601697d09896bf2c537a913c77c213630e9bd9b034b328a5c93e0d2b2e35dc7d" ]]
+}
+
+@test "verify inter-linking of 2 log files in WRONG ORDER after -- with --jobs" {
+	run src/logksi verify -ddd --jobs 2 -- test/resource/interlink/ok-testlog-interlink-2 test/resource/interlink/ok-testlog-interlink-1
+	[ "$status" -eq 6 ]
+	[[ "$output" =~ (Log file.*ok-testlog-interlink-2).*(Finalizing log signature... ok).*(Log file.*ok-testlog-interlink-1).*(Finalizing log signature... ok).*(Block no).*(1).*(verifying inter-linking input hash... failed) ]]
+	[[ "$output" =~ .*(Error).*(Block no).*(1).*(The last leaf from the previous block).*(/ok-testlog-interlink-2).*(does not match with the current first block).*(/ok-testlog-interlink-1).*.*(Expecting).*(SHA-256:601697d09896bf2c537a913c77c213630e9bd9b034b328a5c93e0d2b2e35dc7d).*(but got).*(SHA-256:a558295ae8da8cf4e2b13a34289d2a17676821f14e0792ac1098d27d9bea5fc9) ]]
+}
+
+@test "verify inter-linking where first log is resigned with --jobs" {
+	run src/logksi verify -ddd --jobs 2 -- test/resource/interlink/ok-testlog-interlink-resigned-1 test/resource/interlink/ok-testlog-interlink-2
+	[ "$status" -eq 6 ]
+	[[ "$output" =~ .*(Error).*(Last block).*(1540301997).*(from file).*(ok-testlog-interlink-resigned-1).*(is more recent than).*(first block).*(1539771503).*(from file).*(ok-testlog-interlink-2) ]]
+}
+
+@test "verify inter-linking and log record embedded time chronological order with --jobs - fail" {
+	run src/logksi verify --time-form "%B %d %H:%M:%S" --time-base 2018 --time-diff 50S -dd --use-stored-hash-on-fail --jobs 2 -- test/resource/interlink/ok-testlog-interlink-1 test/resource/interlink/testlog-interlink-first-rec-time-changed-2
+	[ "$status" -eq 6 ]
+	[[ "$output" =~ (x Error: Most recent log line from previous file is more recent than least recent log line from current file:).*(Previous log file).*(ok-testlog-interlink-1).*(Time for most recent log line).*(1539771483).*(Current log file).*(testlog-interlink-first-rec-time-changed-2).*(Time for least recent log line).*(1539771480) ]]
+}